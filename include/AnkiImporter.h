@@ -0,0 +1,155 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <functional>
+#include "Card.h"
+
+class Deck;
+class CardRepository;
+class StringPool;
+
+/**
+ * @brief Импорт коллекции Anki (.apkg, распакованного локально)
+ *
+ * Читает базу SQLite коллекции (collection.anki2 / collection.anki21)
+ * только для чтения и переносит карточки Anki в Card:
+ * - вопрос и ответ - первое и второе поле заметки (для обратной карточки,
+ *   ord = 1, - наоборот); HTML сводится к тексту: <br> и </div> становятся
+ *   переводами строк, остальные теги удаляются, сущности раскрываются;
+ * - [sound:файл] дает ContentType::Audio, <img src="файл"> -
+ *   ContentType::Image; файл ищется через карту media архива;
+ * - easyFactor = factor / 1000 в пределах SM2, intervalDays = ivl
+ *   (интервалы обучения в секундах дают 0);
+ * - nextReview: новые карточки - без даты (готовы сразу), карточки
+ *   повторения - дата создания коллекции плюс due дней, карточки
+ *   обучения - due секунд от эпохи;
+ * - repetitions - серия успешных ответов (ease > 1) в конце журнала
+ *   revlog, lastReview - время последнего ответа.
+ *
+ * Все выборки - однопроходные курсоры (forward-only), журнал повторений
+ * сворачивается в сводку по карточке до чтения карточек, а карточки
+ * передаются получателю пакетами, поэтому память не зависит от размера
+ * коллекции. Идентификаторы Anki 64-битные, поэтому карточки получают
+ * новые последовательные идентификаторы.
+ *
+ * Ошибки не бросают исключений: методы возвращают false, а текст ошибки
+ * доступен через lastError().
+ *
+ * @see CsvImporter, CardRepository
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class AnkiImporter
+{
+public:
+    /**
+     * @brief Параметры импорта
+     */
+    struct Options {
+        int deckId = 0;                 ///< Колода импортируемых карточек
+        int firstCardId = 1;            ///< Идентификатор первой карточки; при импорте в базу - не меньше CardRepository::nextCardId()
+        int batchSize = 20000;          ///< Карточек в пакете получателя
+        qint64 sourceDeckId = 0;        ///< Колода Anki (did); 0 - все колоды
+        bool includeSuspended = true;   ///< Импортировать приостановленные карточки
+        QString mediaDirectory;         ///< Каталог медиафайлов; пусто - каталог коллекции
+        StringPool *stringPool = nullptr;   ///< Пул текста карточек; nullptr - без интернирования (не владеет)
+    };
+
+    /**
+     * @brief Итог импорта
+     */
+    struct Result {
+        qint64 cards = 0;               ///< Карточек прочитано
+        qint64 imported = 0;            ///< Карточек передано получателю
+        qint64 skipped = 0;             ///< Пропущено (приостановленные, пустые)
+        qint64 reviewLogs = 0;          ///< Записей журнала повторений прочитано
+        qint64 mediaFiles = 0;          ///< Медиафайлов передано получателю
+        qint64 missingMedia = 0;        ///< Медиафайлов не найдено
+        qint64 elapsedMSecs = 0;        ///< Длительность импорта
+    };
+
+    /**
+     * @brief Получатель пакета карточек
+     * @return false прерывает импорт
+     */
+    using BatchSink = std::function<bool(QList<Card> &&batch)>;
+
+    /**
+     * @brief Получатель медиаданных карточек
+     * @return false прерывает импорт
+     */
+    using MediaSink = std::function<bool(const QHash<int, QByteArray> &media)>;
+
+    /**
+     * @brief Обработчик прогресса
+     * @param cardsRead Прочитано карточек
+     * @param totalCards Всего карточек в коллекции (с учетом sourceDeckId)
+     */
+    using ProgressCallback = std::function<void(qint64 cardsRead, qint64 totalCards)>;
+
+    AnkiImporter();
+    explicit AnkiImporter(const Options &options);
+
+    /**
+     * @brief Установить обработчик прогресса
+     */
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+     * @brief Импортировать коллекцию в базу данных
+     *
+     * Каждый пакет карточек и медиаданных записывается одной транзакцией.
+     * Нумерация карточек начинается с CardRepository::nextCardId(),
+     * если Options::firstCardId не больше, поэтому карточки других
+     * колод не затрагиваются.
+     *
+     * @param collectionPath Путь к collection.anki2 или collection.anki21
+     * @param cards Хранилище карточек
+     * @return true при успехе
+     */
+    bool importCollection(const QString &collectionPath, CardRepository &cards);
+
+    /**
+     * @brief Импортировать коллекцию в колоду
+     *
+     * Медиаданные в колоде не хранятся и не читаются.
+     *
+     * @param collectionPath Путь к collection.anki2 или collection.anki21
+     * @param deck Колода
+     * @return true при успехе
+     */
+    bool importCollection(const QString &collectionPath, Deck &deck);
+
+    /**
+     * @brief Импортировать коллекцию в произвольные получатели
+     * @param collectionPath Путь к базе коллекции
+     * @param sink Получатель карточек
+     * @param mediaSink Получатель медиаданных; пустой - медиа не читаются
+     * @return true при успехе
+     */
+    bool importCollection(const QString &collectionPath, const BatchSink &sink, const MediaSink &mediaSink);
+
+    /**
+     * @brief Итог последнего импорта
+     */
+    const Result &result() const;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+private:
+    Options options;                    ///< Параметры импорта
+    ProgressCallback progressCallback;  ///< Обработчик прогресса
+    Result summary;                     ///< Итог последнего импорта
+    QString errorText;                  ///< Текст последней ошибки
+
+    /**
+     * @brief Запомнить ошибку и вернуть false
+     */
+    bool fail(const QString &message);
+};
@@ -4,6 +4,12 @@
 #include <QDateTime>
 #include <QString>
 
+class Scheduler;
+
+class Clock;
+
+class StringPool;
+
 /**
  * @brief Класс, представляющий учебную карточку с системой интервального повторения
  *
@@ -43,11 +49,13 @@ public:
      * @param nextReview Дата следующего повторения
      * @param lastReview Дата последнего повторения
      * @param deckId Идентификатор колоды, к которой принадлежит карточка
+     * @param pool Пул строк для вопроса и ответа; nullptr - без интернирования
      */
     Card(int id, const QString &question, const QString &answer,
          ContentType contentType, TestMode testMode,
          float easyFactor, int intervalDays, int repetitions,
-         const QDateTime &nextReview, const QDateTime &lastReview, int deckId);
+         const QDateTime &nextReview, const QDateTime &lastReview, int deckId,
+         StringPool *pool = nullptr);
 
     /**
      * @brief Конструктор копирования
@@ -267,6 +275,32 @@ public:
      */
     void updateSM2(int grade);
 
+    /**
+     * @brief Обновить состояние карточки по алгоритму SM2 с заданными часами
+     *
+     * То же, что updateSM2(int), но момент ответа берется из clock, а не из
+     * системных часов. Позволяет тестам и симуляциям управлять временем.
+     *
+     * @param grade Оценка ответа (0-5)
+     * @param clock Источник текущего момента
+     * @see Clock
+     */
+    void updateSM2(int grade, const Clock &clock);
+
+    /**
+     * @brief Оценить ответ и перепланировать карточку выбранным планировщиком
+     *
+     * Поля планирования передаются планировщику как SchedulingState,
+     * затем lastReview = момент ответа, nextReview = lastReview + intervalDays.
+     * С Scheduler::defaultScheduler() результат совпадает с updateSM2().
+     *
+     * @param grade Оценка ответа (0-5)
+     * @param scheduler Алгоритм планирования
+     * @param clock Источник текущего момента
+     * @see Scheduler
+     */
+    void review(int grade, const Scheduler &scheduler, const Clock &clock);
+
 private:
     int id;                     ///< Уникальный идентификатор карточки
     QString question;           ///< Текст вопроса
@@ -0,0 +1,72 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Содержимое карточки, не нужное для планирования
+ *
+ * Текст вопроса и ответа и, для карточек ContentType::Image и
+ * ContentType::Audio, двоичные данные изображения или звука.
+ *
+ * @see CardContentSource, CardContentCache
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+struct CardContent {
+    QString question;       ///< Текст вопроса
+    QString answer;         ///< Текст ответа
+    QByteArray media;       ///< Изображение или звук; пусто для текстовых карточек
+
+    /**
+     * @brief Оценка занимаемой памяти в байтах (стоимость в кэше)
+     */
+    qsizetype memoryCost() const
+    {
+        return qsizetype(sizeof(CardContent))
+             + (question.size() + answer.size()) * qsizetype(sizeof(QChar))
+             + media.size();
+    }
+};
+
+/**
+ * @brief Источник содержимого карточек по требованию
+ *
+ * Реализуется хранилищем, из которого можно прочитать содержимое
+ * отдельной карточки, например CardRepository.
+ */
+class CardContentSource
+{
+public:
+    /// Получатель текста карточки: идентификатор, вопрос, ответ
+    using TextVisitor = std::function<void(int cardId, const QString &question, const QString &answer)>;
+
+    virtual ~CardContentSource() = default;
+
+    /**
+     * @brief Прочитать содержимое карточки
+     * @param cardId Идентификатор карточки
+     * @param content Заполняется при успехе
+     * @return true, если карточка найдена
+     */
+    virtual bool fetchContent(int cardId, CardContent &content) = 0;
+
+    /**
+     * @brief Прочитать текст всех карточек колоды одним проходом
+     *
+     * Нужен для сортировки и фильтрации по тексту колоды, загруженной
+     * без текста: один запрос вместо fetchContent() на каждую карточку.
+     * Медиаданные не читаются.
+     *
+     * @param deckId Идентификатор колоды
+     * @param visit Вызывается для каждой карточки колоды
+     * @return false, если источник не умеет читать колоду целиком или произошла ошибка
+     */
+    virtual bool forEachText(int deckId, const TextVisitor &visit)
+    {
+        Q_UNUSED(deckId);
+        Q_UNUSED(visit);
+        return false;
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <QCache>
+#include <QMutex>
+#include "CardContent.h"
+
+/**
+ * @brief Ограниченный LRU-кэш содержимого карточек
+ *
+ * Загружает текст и медиаданные карточек из CardContentSource
+ * по требованию и держит в памяти не больше заданного объема.
+ * Вытесняются давно не использованные карточки (QCache).
+ *
+ * Счетчики попаданий и промахов позволяют подобрать размер кэша.
+ *
+ * @note Потокобезопасен: обращения к кэшу сериализуются мьютексом, а
+ *       источник читается без него. Если кэш используют несколько
+ *       потоков, источник тоже должен допускать одновременные вызовы
+ * @see Deck::getContent()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CardContentCache
+{
+public:
+    /**
+     * @brief Счетчики кэша
+     */
+    struct Stats {
+        qint64 hits = 0;        ///< Запросы, обслуженные из кэша
+        qint64 misses = 0;      ///< Запросы, потребовавшие чтения из источника
+        qint64 failures = 0;    ///< Промахи, для которых источник не нашел карточку
+
+        /**
+         * @brief Доля попаданий среди всех запросов (0 при отсутствии запросов)
+         */
+        double hitRate() const
+        {
+            const qint64 total = hits + misses;
+            return total > 0 ? double(hits) / double(total) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Создать кэш
+     * @param source Источник содержимого (не владеет)
+     * @param capacityBytes Наибольший объем содержимого в кэше
+     */
+    explicit CardContentCache(CardContentSource *source, qsizetype capacityBytes = 64 * 1024 * 1024);
+
+    /**
+     * @brief Получить содержимое карточки
+     *
+     * При промахе читает содержимое из источника и кладет его в кэш.
+     *
+     * @param cardId Идентификатор карточки
+     * @param found Устанавливается в false, если карточки нет в источнике (может быть nullptr)
+     * @return Содержимое или пустое содержимое, если карточка не найдена
+     */
+    CardContent content(int cardId, bool *found = nullptr);
+
+    /**
+     * @brief Прочитать текст всех карточек колоды из источника
+     *
+     * Идет в обход кэша: прочитанный текст не кэшируется и не вытесняет
+     * кэшированные карточки.
+     *
+     * @see CardContentSource::forEachText()
+     */
+    bool forEachText(int deckId, const CardContentSource::TextVisitor &visit);
+
+    /**
+     * @brief Проверить, лежит ли карточка в кэше (не меняет счетчики и порядок LRU)
+     */
+    bool contains(int cardId) const;
+
+    /**
+     * @brief Забыть содержимое карточки, например после его изменения
+     */
+    void invalidate(int cardId);
+
+    /**
+     * @brief Очистить кэш
+     */
+    void clear();
+
+    /**
+     * @brief Текущий объем содержимого в кэше (байты)
+     */
+    qsizetype totalCost() const;
+
+    /**
+     * @brief Наибольший объем содержимого в кэше (байты)
+     */
+    qsizetype capacity() const;
+
+    /**
+     * @brief Изменить наибольший объем; лишнее вытесняется сразу
+     */
+    void setCapacity(qsizetype capacityBytes);
+
+    /**
+     * @brief Текущие счетчики
+     */
+    Stats stats() const;
+
+    /**
+     * @brief Обнулить счетчики
+     */
+    void resetStats();
+
+private:
+    CardContentSource *source;              ///< Источник содержимого
+    mutable QMutex mutex;                   ///< Защищает поля ниже
+    QCache<int, CardContent> cache;         ///< Содержимое по идентификатору карточки
+    Stats counters;                         ///< Счетчики
+    quint64 invalidations = 0;              ///< Количество вызовов invalidate() и clear()
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include "Card.h"
+
+class QIODevice;
+class QThread;
+class Deck;
+
+/**
+ * @brief Потоковый экспорт карточек в CSV, JSON Lines и двоичный формат
+ *
+ * Карточки читаются прямо из столбцового хранилища колоды (CardSpan),
+ * без копий getCards(), и сериализуются в буфер фиксированного размера.
+ * Заполненный буфер (при необходимости сжатый) записывается на
+ * устройство, поэтому память не зависит от размера коллекции.
+ *
+ * Форматы:
+ * - Csv - RFC 4180 с заголовком; столбцы совпадают с CsvImporter
+ *   (плюс deck_id), даты - миллисекунды от эпохи, пусто - без даты;
+ * - JsonLines - один объект JSON на строку с теми же полями,
+ *   дата без значения - null;
+ * - Binary - сигнатура "QCEX", версия и записи переменной длины:
+ *   поля фиксированной ширины, затем длины и тексты в UTF-8.
+ *   Читается обратно функцией readBinary().
+ *
+ * Сжатие Deflate делит поток на независимые блоки qCompress() (zlib)
+ * с префиксом длины после сигнатуры "QCZ1"; распаковка - decompress().
+ *
+ * Экспорт выполняется в вызывающем потоке (exportDecks(), exportFile())
+ * или в фоновом (start(), wait()). cancel() можно вызвать из любого
+ * потока: экспорт останавливается на ближайшей карточке, а файл
+ * экспорта не создается (QSaveFile).
+ *
+ * Ошибки не бросают исключений: методы возвращают false, а текст ошибки
+ * доступен через lastError().
+ *
+ * @see CsvImporter, CollectionSnapshot
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CardExporter
+{
+public:
+    /// Версия двоичного формата
+    static constexpr quint32 kBinaryVersion = 1;
+
+    /**
+     * @brief Формат записей
+     */
+    enum class Format {
+        Csv,            ///< Текст с разделителями и заголовком
+        JsonLines,      ///< Один объект JSON на строку
+        Binary          ///< Компактные двоичные записи
+    };
+
+    /**
+     * @brief Сжатие потока
+     */
+    enum class Compression {
+        None,           ///< Без сжатия
+        Deflate         ///< Блоки qCompress (zlib)
+    };
+
+    /**
+     * @brief Параметры экспорта
+     */
+    struct Options {
+        Format format = Format::Csv;                ///< Формат записей
+        Compression compression = Compression::None;///< Сжатие
+        int compressionLevel = 6;                   ///< Уровень сжатия zlib (1-9)
+        int bufferBytes = 1 << 20;                  ///< Размер буфера (и блока сжатия)
+        char delimiter = ',';                       ///< Разделитель CSV; '\t' для TSV
+    };
+
+    /**
+     * @brief Итог экспорта
+     */
+    struct Result {
+        qint64 cards = 0;               ///< Карточек записано
+        qint64 rawBytes = 0;            ///< Байт до сжатия
+        qint64 bytesWritten = 0;        ///< Байт записано на устройство
+        qint64 peakBufferBytes = 0;     ///< Наибольший объем буферов экспорта
+        qint64 elapsedMSecs = 0;        ///< Длительность экспорта
+        bool canceled = false;          ///< Экспорт отменен
+
+        /**
+         * @brief Скорость сериализации в МБ/с (по байтам до сжатия)
+         */
+        double megabytesPerSecond() const;
+    };
+
+    /**
+     * @brief Обработчик прогресса
+     *
+     * Вызывается в потоке экспорта после записи каждого буфера.
+     *
+     * @param cardsWritten Карточек записано
+     * @param totalCards Всего карточек
+     */
+    using ProgressCallback = std::function<void(qint64 cardsWritten, qint64 totalCards)>;
+
+    CardExporter();
+    explicit CardExporter(const Options &options);
+    ~CardExporter();
+
+    CardExporter(const CardExporter &) = delete;
+    CardExporter &operator=(const CardExporter &) = delete;
+
+    /**
+     * @brief Установить обработчик прогресса
+     */
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+     * @brief Экспортировать колоды в открытое устройство
+     * @param decks Колоды; не должны меняться во время экспорта
+     * @param device Устройство, открытое на запись
+     * @return true при успехе; false при ошибке записи или отмене
+     */
+    bool exportDecks(const QList<Deck> &decks, QIODevice &device);
+
+    /**
+     * @brief Экспортировать колоду в открытое устройство
+     */
+    bool exportDeck(const Deck &deck, QIODevice &device);
+
+    /**
+     * @brief Экспортировать колоды в файл
+     *
+     * Файл заменяется атомарно: при ошибке или отмене прежний файл
+     * не меняется.
+     *
+     * @param decks Колоды
+     * @param path Путь к файлу
+     * @return true при успехе
+     */
+    bool exportFile(const QList<Deck> &decks, const QString &path);
+
+    // =============== ФОНОВЫЙ ЭКСПОРТ ===============
+
+    /**
+     * @brief Запустить экспорт в файл в фоновом потоке
+     * @param decks Колоды; должны жить и не меняться до wait()
+     * @param path Путь к файлу
+     * @return false, если экспорт уже выполняется
+     */
+    bool start(const QList<Deck> &decks, const QString &path);
+
+    /**
+     * @brief Дождаться завершения фонового экспорта
+     * @return Результат экспорта; true, если экспорт не запускался
+     */
+    bool wait();
+
+    /**
+     * @brief Выполняется ли фоновый экспорт
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Отменить экспорт (из любого потока)
+     */
+    void cancel();
+
+    /**
+     * @brief Итог последнего экспорта
+     * @note После start() читайте только после wait()
+     */
+    const Result &result() const;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+    // =============== ЧТЕНИЕ ===============
+
+    /**
+     * @brief Распаковать поток, сжатый Compression::Deflate
+     * @param in Сжатый поток
+     * @param out Устройство для распакованных данных
+     * @param errorMessage Текст ошибки (может быть nullptr)
+     * @return true при успехе
+     */
+    static bool decompress(QIODevice &in, QIODevice &out, QString *errorMessage = nullptr);
+
+    /**
+     * @brief Прочитать карточки двоичного формата
+     * @param device Несжатый поток Format::Binary
+     * @param cards Прочитанные карточки (добавляются в конец)
+     * @param errorMessage Текст ошибки (может быть nullptr)
+     * @return true при успехе
+     */
+    static bool readBinary(QIODevice &device, QList<Card> &cards, QString *errorMessage = nullptr);
+
+private:
+    Options options;                    ///< Параметры экспорта
+    ProgressCallback progressCallback;  ///< Обработчик прогресса
+    Result summary;                     ///< Итог последнего экспорта
+    QString errorText;                  ///< Текст последней ошибки
+    std::atomic<bool> canceled{false};  ///< Запрошена отмена
+    QThread *worker = nullptr;          ///< Фоновый поток экспорта
+    bool workerOk = false;              ///< Результат фонового экспорта
+
+    /**
+     * @brief Записать колоды без сброса итога
+     */
+    bool writeDecks(const QList<const Deck *> &decks, QIODevice &device);
+
+    /**
+     * @brief Запомнить ошибку и вернуть false
+     */
+    bool fail(const QString &message);
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include <QHash>
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include "Card.h"
+#include "CardContent.h"
+#include "CardView.h"
+#include "ReviewRecord.h"
+
+class QSqlQuery;
+
+/**
+ * @brief Хранилище карточек в базе данных SQLite
+ *
+ * Все запросы подготавливаются (prepared statements), а массовые вставка
+ * и обновление выполняются одной транзакцией: SQLite синхронизирует файл
+ * один раз на транзакцию, а не на каждую строку.
+ *
+ * Выборка и подсчет готовых карточек - диапазонное сканирование индекса
+ * (deck_id, next_review), без загрузки всей колоды.
+ *
+ * Ошибки не бросают исключений: методы возвращают false (или пустой
+ * результат), а текст ошибки доступен через lastError().
+ *
+ * Хранилище также служит источником содержимого (CardContentSource)
+ * для ленивой загрузки текста и медиаданных через CardContentCache
+ * и получателем записей журнала повторений (ReviewSink).
+ *
+ * @note Идентификатор карточки - первичный ключ таблицы, поэтому он должен
+ *       быть уникален во всей базе; вставка карточки с занятым
+ *       идентификатором завершается ошибкой. Свободные идентификаторы
+ *       выдает nextCardId()
+ * @see Database, DeckRepository
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CardRepository : public CardContentSource, public ReviewSink
+{
+    friend class DeckRepository;
+
+public:
+    /**
+     * @brief Создать хранилище поверх открытого соединения
+     * @param database Соединение, подготовленное Database::open()
+     */
+    explicit CardRepository(const QSqlDatabase &database);
+
+    // =============== ЗАПИСЬ ===============
+
+    /**
+     * @brief Добавить карточки в конец колоды одной транзакцией
+     * @param deckId Идентификатор колоды
+     * @param cards Карточки; их собственный deckId заменяется на deckId
+     * @return true, если записаны все карточки; при ошибке, в том числе
+     *         при занятом идентификаторе, транзакция откатывается
+     */
+    bool insertCards(int deckId, const QList<Card> &cards);
+
+    /**
+     * @brief Сохранить поля планирования карточек одной транзакцией
+     *
+     * Обновляет easy_factor, interval_days, repetitions, next_review
+     * и last_review по идентификатору; текст не перезаписывается.
+     *
+     * @param cards Карточки колоды, например Deck::getCardsView()
+     * @return true при успехе; при ошибке транзакция откатывается
+     */
+    bool updateScheduling(CardSpan cards);
+
+    /**
+     * @brief Применить записи журнала повторений одной транзакцией
+     *
+     * Каждая запись устанавливает итоговое состояние планирования карточки;
+     * записи применяются в порядке списка, поэтому побеждает последняя.
+     * Записи для отсутствующих карточек пропускаются.
+     *
+     * @param records Записи журнала
+     * @return true при успехе; при ошибке транзакция откатывается
+     * @see ReviewJournal::recover()
+     */
+    bool applyReviews(const QList<ReviewRecord> &records) override;
+
+    /**
+     * @brief Удалить карточку вместе с её медиаданными
+     * @param cardId Идентификатор карточки
+     * @return true, если карточка существовала и удалена
+     */
+    bool removeCard(int cardId);
+
+    /**
+     * @brief Сохранить изображение или звук карточки
+     * @param cardId Идентификатор карточки
+     * @param data Двоичные данные; заменяют прежние
+     * @return true при успехе
+     */
+    bool saveMedia(int cardId, const QByteArray &data);
+
+    /**
+     * @brief Сохранить медиаданные нескольких карточек одной транзакцией
+     * @param media Двоичные данные по идентификатору карточки
+     * @return true при успехе; при ошибке транзакция откатывается
+     */
+    bool saveMedia(const QHash<int, QByteArray> &media);
+
+    // =============== ЧТЕНИЕ ===============
+
+    /**
+     * @brief Загрузить все карточки колоды в исходном порядке
+     * @param deckId Идентификатор колоды
+     * @return Карточки колоды; пустой список при ошибке (см. lastError())
+     */
+    QList<Card> loadDeckCards(int deckId);
+
+    /**
+     * @brief Загрузить карточки колоды без текста
+     *
+     * Читает только поля планирования; вопрос и ответ остаются пустыми.
+     * Текст и медиаданные затем загружаются по требованию через
+     * fetchContent().
+     *
+     * @param deckId Идентификатор колоды
+     * @return Карточки колоды в исходном порядке
+     */
+    QList<Card> loadDeckMetadata(int deckId);
+
+    /**
+     * @brief Прочитать текст и медиаданные одной карточки
+     *
+     * Медиаданные читаются только для карточек ContentType::Image
+     * и ContentType::Audio.
+     *
+     * @param cardId Идентификатор карточки
+     * @param content Заполняется при успехе
+     * @return true, если карточка найдена
+     */
+    bool fetchContent(int cardId, CardContent &content) override;
+
+    /**
+     * @brief Прочитать вопросы и ответы карточек колоды одним запросом
+     * @param deckId Идентификатор колоды
+     * @param visit Вызывается для каждой карточки в порядке колоды
+     * @return false при ошибке запроса
+     */
+    bool forEachText(int deckId, const TextVisitor &visit) override;
+
+    /**
+     * @brief Загрузить карточки, готовые к повторению
+     *
+     * Карточки упорядочены по времени повторения: сначала без даты,
+     * затем самые просроченные.
+     *
+     * @param deckId Идентификатор колоды
+     * @param nowMSecs Текущий момент (мс от эпохи)
+     * @param limit Наибольшее количество карточек; -1 - без ограничения
+     * @return Готовые карточки
+     * @note Диапазонное сканирование индекса (deck_id, next_review)
+     */
+    QList<Card> loadDueCards(int deckId, qint64 nowMSecs, int limit = -1);
+
+    /**
+     * @brief Подсчитать карточки, готовые к повторению
+     * @param deckId Идентификатор колоды
+     * @param nowMSecs Текущий момент (мс от эпохи)
+     * @return Количество карточек или -1 при ошибке
+     * @note Подсчет выполняется по индексу, без чтения строк таблицы
+     */
+    int countDueCards(int deckId, qint64 nowMSecs);
+
+    /**
+     * @brief Первый свободный идентификатор карточки
+     *
+     * Идентификаторы уникальны во всей базе, поэтому импорт в любую
+     * колоду нумерует новые карточки с этого значения.
+     *
+     * @return Наибольший идентификатор плюс один (1 для пустой базы)
+     *         или -1 при ошибке
+     */
+    int nextCardId();
+
+    /**
+     * @brief Найти карточки по тексту вопроса и ответа
+     *
+     * Запрос в синтаксисе SearchIndex (слова, `префикс*`, `"фраза"`)
+     * переводится в выражение FTS5 и выполняется по таблице cards_fts,
+     * которую триггеры поддерживают вместе с таблицей cards.
+     *
+     * @param query Запрос
+     * @param limit Наибольшее количество карточек; -1 - без ограничения
+     * @return Идентификаторы карточек по возрастанию; пустой список при ошибке
+     *         и если поиск не включен Database::enableFullTextSearch()
+     * @see SearchIndex::toFts5Query()
+     */
+    QList<int> search(const QString &query, int limit = -1);
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const override;
+
+private:
+    QSqlDatabase database;      ///< Соединение с базой данных
+    QString errorText;          ///< Текст последней ошибки
+
+    /**
+     * @brief Записать карточки колоды внутри уже открытой транзакции
+     * @param firstPosition Позиция первой карточки в колоде
+     */
+    bool writeCards(int deckId, const QList<Card> &cards, int firstPosition);
+    bool writeCards(int deckId, CardSpan cards, int firstPosition);
+
+    /**
+     * @brief Заменить карточки колоды без текста внутри уже открытой транзакции
+     *
+     * Для колоды Deck::isMetadataOnly(): сохраненные карточки получают
+     * новые позиции и поля планирования, но question и answer остаются
+     * прежними. Новые карточки записываются с текстом колоды, карточки,
+     * которых нет в колоде, удаляются вместе с медиаданными.
+     */
+    bool writeDeckMetadata(int deckId, CardSpan cards);
+
+    /**
+     * @brief Обновить поля планирования внутри уже открытой транзакции
+     */
+    bool writeScheduling(CardSpan cards);
+
+    /**
+     * @brief Удалить все карточки колоды внутри уже открытой транзакции
+     */
+    bool removeDeckCards(int deckId);
+
+    /**
+     * @brief Прочитать карточки из выполненного запроса
+     * @param withText Запрос содержит столбцы question и answer
+     */
+    QList<Card> readCards(QSqlQuery &query, bool withText = true);
+
+    /**
+     * @brief Удалить медиаданные карточек колоды внутри уже открытой транзакции
+     */
+    bool removeDeckMedia(int deckId);
+
+    /**
+     * @brief Удалить медиаданные карточек колоды, которых нет в cards,
+     *        внутри уже открытой транзакции
+     */
+    bool removeDroppedMedia(int deckId, CardSpan cards);
+
+    /**
+     * @brief Подготовить запрос, запомнив ошибку при неудаче
+     */
+    bool prepare(QSqlQuery &query, const QString &sql);
+
+    /**
+     * @brief Выполнить подготовленный запрос, запомнив ошибку при неудаче
+     */
+    bool exec(QSqlQuery &query);
+};
@@ -0,0 +1,401 @@
+#pragma once
+#include <QDateTime>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <limits>
+#include "Card.h"
+
+class CardRef;
+class Scheduler;
+class TextArena;
+
+/**
+ * @brief Столбцовое (structure-of-arrays) хранилище карточек колоды
+ *
+ * Каждое поле карточки хранится в отдельном непрерывном массиве. Горячие
+ * поля планирования (easyFactor, intervalDays, repetitions, nextReview,
+ * lastReview) лежат плотно и не перемешаны с текстом вопросов и ответов,
+ * поэтому проход по датам повторения читает только нужные байты.
+ *
+ * Даты хранятся как qint64 - миллисекунды от эпохи (UTC). Отсутствующая
+ * дата (невалидная QDateTime) хранится как kNoDate; это минимальное
+ * значение, поэтому такие карточки при сравнении с текущим моментом
+ * автоматически считаются готовыми к повторению.
+ *
+ * Строка хранилища (row) - позиция карточки в колоде.
+ *
+ * Хранилище, собранное DeckBuilder, держит текст в общем TextArena:
+ * строки столбцов ссылаются на его блоки, а буфер живет, пока жива
+ * хоть одна копия хранилища. question()/answer() отдают эти строки без
+ * копирования и годятся только, пока хранилище живо; card(),
+ * ownedQuestion() и ownedAnswer() возвращают собственные копии текста.
+ *
+ * @note Столбцы основаны на QList, поэтому копия хранилища разделяет данные
+ *       до первой модификации (implicit sharing)
+ * @see CardRef
+ * @see Deck
+ * @see DeckBuilder
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CardStore
+{
+    friend class DeckBuilder;
+
+public:
+    /**
+     * @brief Готовые столбцы для массовой загрузки
+     *
+     * Указатели на непрерывные массивы одинаковой длины, например
+     * на разделы отображенного в память снимка коллекции.
+     *
+     * @see assign(), CollectionSnapshot
+     */
+    struct Columns {
+        const int *ids = nullptr;
+        const int *deckIds = nullptr;
+        const ContentType *contentTypes = nullptr;
+        const TestMode *testModes = nullptr;
+        const float *easyFactors = nullptr;
+        const int *intervals = nullptr;
+        const int *repetitions = nullptr;
+        const qint64 *nextReviews = nullptr;   ///< Мс от эпохи или kNoDate
+        const qint64 *lastReviews = nullptr;   ///< Мс от эпохи или kNoDate
+    };
+
+    /// Значение столбца даты для невалидной QDateTime
+    static constexpr qint64 kNoDate = std::numeric_limits<qint64>::min();
+
+    /**
+     * @brief Преобразовать дату в значение столбца
+     * @param dateTime Дата (возможно, невалидная)
+     * @return Миллисекунды от эпохи или kNoDate
+     */
+    static qint64 toEpochMSecs(const QDateTime &dateTime);
+
+    /**
+     * @brief Преобразовать значение столбца в дату
+     * @param msecs Миллисекунды от эпохи или kNoDate
+     * @return Дата в локальном времени или невалидная QDateTime
+     */
+    static QDateTime fromEpochMSecs(qint64 msecs);
+
+    // =============== РАЗМЕР ===============
+
+    /**
+     * @brief Количество строк (карточек)
+     */
+    int size() const;
+
+    /**
+     * @brief Проверить, пусто ли хранилище
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Зарезервировать место под заданное количество строк во всех столбцах
+     * @param rows Ожидаемое количество строк
+     */
+    void reserve(int rows);
+
+    /**
+     * @brief Удалить все строки
+     */
+    void clear();
+
+    /**
+     * @brief Заменить содержимое хранилища готовыми столбцами
+     *
+     * Каждый столбец копируется целиком, одним блоком памяти, без сборки
+     * Card по строкам.
+     *
+     * @param columns Столбцы длиной rows
+     * @param rows Количество строк
+     * @param questions Тексты вопросов (rows строк или пустой список)
+     * @param answers Тексты ответов (rows строк или пустой список)
+     * @note Без хранения текста questions и answers игнорируются;
+     *       пустые списки дают пустые строки
+     */
+    void assign(const Columns &columns, int rows,
+                QList<QString> questions = {}, QList<QString> answers = {});
+
+    // =============== СТРОКИ ===============
+
+    /**
+     * @brief Добавить карточку в конец хранилища
+     * @param card Карточка
+     * @return Номер новой строки
+     */
+    int append(const Card &card);
+
+    /**
+     * @brief Добавить карточку, переместив её строки в столбец текста
+     * @param card Карточка (r-value reference)
+     * @return Номер новой строки
+     */
+    int append(Card &&card);
+
+    /**
+     * @brief Удалить строку, сдвинув последующие
+     * @param row Номер строки
+     */
+    void removeAt(int row);
+
+    /**
+     * @brief Собрать объект Card из строки
+     *
+     * Текст из буфера DeckBuilder копируется, поэтому карточка
+     * не зависит от времени жизни хранилища.
+     *
+     * @param row Номер строки
+     * @return Копия карточки
+     */
+    Card card(int row) const;
+
+    /**
+     * @brief Перезаписать строку значениями карточки
+     * @param row Номер строки
+     * @param card Новые значения
+     */
+    void setCard(int row, const Card &card);
+
+    /**
+     * @brief Получить легковесный дескриптор строки
+     * @param row Номер строки
+     */
+    CardRef ref(int row) const;
+
+    // =============== ПОЛЯ СТРОКИ ===============
+
+    int id(int row) const;
+    const QString &question(int row) const;     ///< Пустая строка, если текст не хранится
+    const QString &answer(int row) const;       ///< Пустая строка, если текст не хранится
+    QString ownedQuestion(int row) const;       ///< Вопрос, не ссылающийся на TextArena
+    QString ownedAnswer(int row) const;         ///< Ответ, не ссылающийся на TextArena
+    ContentType contentType(int row) const;
+    TestMode testMode(int row) const;
+    float easyFactor(int row) const;
+    int intervalDays(int row) const;
+    int repetitions(int row) const;
+    qint64 nextReviewMSecs(int row) const;
+    qint64 lastReviewMSecs(int row) const;
+    int deckId(int row) const;
+
+    // =============== ТЕКСТ ===============
+
+    /**
+     * @brief Включить или выключить хранение текста вопросов и ответов
+     *
+     * Без текста хранилище держит только поля планирования: столбцы
+     * вопросов и ответов освобождаются, а question()/answer() возвращают
+     * пустую строку. Текст в этом режиме загружается по требованию
+     * (см. CardContentCache).
+     *
+     * @param stored false освобождает уже сохраненный текст
+     */
+    void setTextStored(bool stored);
+
+    /**
+     * @brief Хранится ли текст карточек
+     */
+    bool isTextStored() const;
+
+    /**
+     * @brief Проверить, разделяет ли хранилище текст с другим
+     *
+     * Столбцы идентификаторов, вопросов и ответов копируются только
+     * при изменении, поэтому копия, в которой менялись лишь поля
+     * планирования, разделяет их с оригиналом. Проверка - O(1).
+     *
+     * @param other Другое хранилище, обычно исходное для копии
+     * @return true, если текст и идентификаторы карточек заведомо совпадают
+     */
+    bool sharesTextWith(const CardStore &other) const;
+
+    /**
+     * @brief Оценка памяти, занятой хранилищем
+     *
+     * Складывает емкость всех столбцов, размер буферов строк и блоков
+     * TextArena. Строки, разделяемые с другими объектами, учитываются целиком.
+     *
+     * @return Байты
+     */
+    qsizetype memoryUsage() const;
+
+    // =============== СТОЛБЦЫ ===============
+
+    /**
+     * @brief Столбец дат следующего повторения
+     * @return Непрерывный массив из size() значений
+     */
+    const QList<qint64> &nextReviewColumn() const;
+
+    // =============== ПЛАНИРОВАНИЕ ===============
+
+    /**
+     * @brief Применить оценку SM2 к строке
+     *
+     * Эквивалент Card::updateSM2() для строки хранилища:
+     * lastReview = now, nextReview = now + intervalDays.
+     *
+     * @param row Номер строки
+     * @param grade Оценка ответа (0-5)
+     * @param now Момент ответа
+     */
+    void updateSM2(int row, int grade, const QDateTime &now);
+
+    /**
+     * @brief Применить оценку к строке выбранным планировщиком
+     *
+     * Эквивалент Card::review() для строки хранилища.
+     *
+     * @param row Номер строки
+     * @param grade Оценка ответа (0-5)
+     * @param now Момент ответа
+     * @param scheduler Алгоритм планирования
+     */
+    void review(int row, int grade, const QDateTime &now, const Scheduler &scheduler);
+
+    /**
+     * @brief Применить пакет оценок SM2 с общим моментом ответа
+     *
+     * Результат совпадает с последовательными вызовами updateSM2() в порядке
+     * пакета, включая повторные оценки одной строки. Поля планирования
+     * собираются в плотные временные массивы и обновляются SM2::applyBatch(),
+     * а дата следующего повторения вычисляется один раз на каждый
+     * встретившийся интервал.
+     *
+     * @param rows Номера строк
+     * @param grades Оценки ответа (0-5), по одной на строку
+     * @param count Количество оценок
+     * @param now Момент ответа для всех оценок пакета
+     */
+    void applyGrades(const int *rows, const int *grades, qsizetype count, const QDateTime &now);
+
+private:
+    QList<int> ids;                     ///< Идентификаторы карточек
+    QList<int> deckIds;                 ///< Идентификаторы колод
+    QList<ContentType> contentTypes;    ///< Типы содержимого
+    QList<TestMode> testModes;          ///< Режимы тестирования
+
+    // Горячие поля планирования
+    QList<float> easyFactors;           ///< Факторы легкости
+    QList<int> intervals;               ///< Интервалы в днях
+    QList<int> repetitionCounts;        ///< Успешные повторения подряд
+    QList<qint64> nextReviews;          ///< Следующее повторение (мс от эпохи или kNoDate)
+    QList<qint64> lastReviews;          ///< Последнее повторение (мс от эпохи или kNoDate)
+
+    // Холодный текст
+    QList<QString> questions;           ///< Тексты вопросов
+    QList<QString> answers;             ///< Тексты ответов
+    bool textStored = true;             ///< Хранятся ли столбцы текста
+    QSharedPointer<const TextArena> textArena;  ///< Буфер текста, на который ссылаются строки столбцов
+
+    /**
+     * @brief Общая пустая строка для режима без текста
+     */
+    static const QString &emptyText();
+
+    /**
+     * @brief Копия строки столбца, владеющая данными
+     *
+     * Строки TextArena копируются, остальные разделяются как обычно.
+     */
+    QString owned(const QString &text) const;
+};
+
+/**
+ * @brief Легковесный дескриптор строки CardStore
+ *
+ * Предоставляет тот же набор геттеров, что и Card, но читает значения
+ * прямо из столбцов хранилища, не копируя карточку целиком.
+ * Копирование дескриптора стоит два машинных слова.
+ *
+ * getQuestion() и getAnswer() возвращают строки, владеющие данными;
+ * questionView() и answerView() читают текст без копирования.
+ *
+ * @warning Дескриптор действителен, пока хранилище не изменено.
+ *          Представления questionView()/answerView() действительны,
+ *          пока жива колода
+ * @see CardStore
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CardRef
+{
+public:
+    CardRef() = default;
+    CardRef(const CardStore *store, int row) : store(store), rowIndex(row) {}
+
+    /**
+     * @brief Номер строки в хранилище (позиция карточки в колоде)
+     */
+    int row() const { return rowIndex; }
+
+    int getId() const { return store->id(rowIndex); }
+    QString getQuestion() const { return store->ownedQuestion(rowIndex); }
+    QString getAnswer() const { return store->ownedAnswer(rowIndex); }
+    ContentType getContentType() const { return store->contentType(rowIndex); }
+    TestMode getTestMode() const { return store->testMode(rowIndex); }
+    float getEasyFactor() const { return store->easyFactor(rowIndex); }
+    int getIntervalDays() const { return store->intervalDays(rowIndex); }
+    int getRepetitions() const { return store->repetitions(rowIndex); }
+    QDateTime getNextReview() const { return CardStore::fromEpochMSecs(store->nextReviewMSecs(rowIndex)); }
+    QDateTime getLastReview() const { return CardStore::fromEpochMSecs(store->lastReviewMSecs(rowIndex)); }
+    int getDeckId() const { return store->deckId(rowIndex); }
+
+    /**
+     * @brief Дата следующего повторения без построения QDateTime
+     * @return Миллисекунды от эпохи или CardStore::kNoDate
+     */
+    qint64 getNextReviewMSecs() const { return store->nextReviewMSecs(rowIndex); }
+
+    /**
+     * @brief Дата последнего повторения без построения QDateTime
+     * @return Миллисекунды от эпохи или CardStore::kNoDate
+     */
+    qint64 getLastReviewMSecs() const { return store->lastReviewMSecs(rowIndex); }
+
+    /**
+     * @brief Вопрос без копирования
+     */
+    QStringView questionView() const { return store->question(rowIndex); }
+
+    /**
+     * @brief Ответ без копирования
+     */
+    QStringView answerView() const { return store->answer(rowIndex); }
+
+    /**
+     * @brief Собрать полноценную копию карточки
+     */
+    Card toCard() const { return store->card(rowIndex); }
+
+private:
+    const CardStore *store = nullptr;   ///< Хранилище
+    int rowIndex = 0;                   ///< Номер строки
+};
+
+// =============== INLINE ДОСТУП К ПОЛЯМ ===============
+
+inline int CardStore::size() const { return static_cast<int>(ids.size()); }
+inline bool CardStore::isEmpty() const { return ids.isEmpty(); }
+inline CardRef CardStore::ref(int row) const { return CardRef(this, row); }
+inline int CardStore::id(int row) const { return ids[row]; }
+inline const QString &CardStore::question(int row) const { return textStored ? questions[row] : emptyText(); }
+inline const QString &CardStore::answer(int row) const { return textStored ? answers[row] : emptyText(); }
+inline QString CardStore::ownedQuestion(int row) const { return owned(question(row)); }
+inline QString CardStore::ownedAnswer(int row) const { return owned(answer(row)); }
+inline QString CardStore::owned(const QString &text) const { return textArena ? QString(text.constData(), text.size()) : text; }
+inline ContentType CardStore::contentType(int row) const { return contentTypes[row]; }
+inline TestMode CardStore::testMode(int row) const { return testModes[row]; }
+inline float CardStore::easyFactor(int row) const { return easyFactors[row]; }
+inline int CardStore::intervalDays(int row) const { return intervals[row]; }
+inline int CardStore::repetitions(int row) const { return repetitionCounts[row]; }
+inline qint64 CardStore::nextReviewMSecs(int row) const { return nextReviews[row]; }
+inline qint64 CardStore::lastReviewMSecs(int row) const { return lastReviews[row]; }
+inline int CardStore::deckId(int row) const { return deckIds[row]; }
+inline const QList<qint64> &CardStore::nextReviewColumn() const { return nextReviews; }
@@ -0,0 +1,199 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <QList>
+#include <QString>
+#include "CardContent.h"
+
+class Deck;
+
+/**
+ * @brief Табличная модель Qt для просмотра карточек колоды
+ *
+ * Модель не копирует карточки: data() читает значения прямо из столбцов
+ * CardStore колоды за O(1), а сортировка и фильтрация строят только
+ * перестановку номеров строк (4 байта на видимую строку). Пока модель
+ * не отсортирована и не отфильтрована, перестановки нет вовсе,
+ * поэтому setDeck() и reload() без фильтра стоят O(1).
+ *
+ * Строки отдаются представлению порциями через canFetchMore()/fetchMore():
+ * rowCount() сообщает только загруженную часть, и представление
+ * запрашивает следующую порцию при прокрутке к концу.
+ *
+ * Сортировка по дате следующего повторения берет порядок из индекса
+ * повторений колоды за O(n); остальные столбцы сортируются по ключу
+ * за O(n log n). Равные значения упорядочиваются по позиции в колоде
+ * при любом направлении сортировки.
+ *
+ * Для колоды Deck::isMetadataOnly() текст ячеек, текстового фильтра
+ * и сортировки по вопросу или ответу берется из Deck::getContent().
+ * Фильтр и сортировка читают текст каждой строки, поэтому на такой
+ * колоде они проходят через кэш содержимого всю колоду.
+ *
+ * @warning Модель не владеет колодой и не следит за её изменениями:
+ *          после изменения колоды нужно вызвать reload()
+ * @see Deck, CardStore, DueIndex
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CardTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Столбцы таблицы
+     */
+    enum Column {
+        Id,
+        Question,
+        Answer,
+        EasyFactor,
+        Interval,
+        Repetitions,
+        NextReview,
+        LastReview,
+        ColumnCount
+    };
+
+    /// Строк в порции fetchMore() по умолчанию
+    static constexpr int kDefaultFetchBatch = 1000;
+
+    explicit CardTableModel(QObject *parent = nullptr);
+
+    // =============== КОЛОДА ===============
+
+    /**
+     * @brief Показать колоду; сортировка и фильтры сбрасываются
+     * @param deck Колода или nullptr (не владеет)
+     */
+    void setDeck(const Deck *deck);
+
+    /**
+     * @brief Текущая колода
+     */
+    const Deck *deck() const;
+
+    /**
+     * @brief Перечитать колоду после изменения
+     *
+     * Фильтры и сортировка применяются заново, загруженной остается
+     * первая порция строк.
+     */
+    void reload();
+
+    /**
+     * @brief Позиция карточки в колоде по строке модели
+     * @param row Строка модели
+     * @return Позиция для Deck::getCardsView()[]
+     */
+    int deckRow(int row) const;
+
+    // =============== ПОРЦИИ ===============
+
+    /**
+     * @brief Задать размер порции fetchMore()
+     * @param rows Строк в порции; не меньше одной
+     */
+    void setFetchBatchSize(int rows);
+
+    /**
+     * @brief Размер порции fetchMore()
+     */
+    int fetchBatchSize() const;
+
+    /**
+     * @brief Количество строк, прошедших фильтры (включая не загруженные)
+     */
+    int totalRowCount() const;
+
+    // =============== ФИЛЬТРЫ ===============
+
+    /**
+     * @brief Оставить карточки, текст которых содержит подстроку
+     *
+     * Сравнение без учета регистра.
+     *
+     * @param text Подстрока; пустая строка снимает фильтр
+     * @param column Question, Answer или -1 - вопрос или ответ
+     */
+    void setFilterText(const QString &text, int column = -1);
+
+    /**
+     * @brief Оставить только карточки, готовые к повторению
+     *
+     * Момент берется из часов колоды при каждом применении фильтра.
+     *
+     * @param enabled Включить фильтр
+     */
+    void setDueOnly(bool enabled);
+
+    // =============== QAbstractTableModel ===============
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    /**
+     * @brief Отсортировать строки
+     *
+     * Постоянные индексы (QPersistentModelIndex) переносятся вслед
+     * за своими карточками; индексы карточек, оказавшихся за пределами
+     * загруженной части, становятся недействительными.
+     *
+     * @param column Столбец; -1 возвращает порядок колоды
+     * @param order Направление
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+    const Deck *source = nullptr;       ///< Колода (не владеет)
+    QList<int> rows;                    ///< Позиции в колоде по строкам модели
+    bool identity = true;               ///< Строки идут в порядке колоды; rows не используется
+    int loaded = 0;                     ///< Загруженных строк
+    int fetchBatch = kDefaultFetchBatch;
+    int sortColumn = -1;                ///< Столбец сортировки; -1 - порядок колоды
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+    QString filterText;                 ///< Подстрока фильтра
+    int filterColumn = -1;              ///< Столбец фильтра
+    bool dueOnly = false;               ///< Только готовые к повторению
+
+    /**
+     * @brief Отфильтровать строки колоды в порядке колоды
+     */
+    void applyFilters();
+
+    /**
+     * @brief Проверить текстовый фильтр для строки колоды
+     */
+    bool matchesFilterText(int deckRow) const;
+
+    /**
+     * @brief Проверить текстовый фильтр для вопроса и ответа
+     */
+    bool matchesText(const QString &question, const QString &answer) const;
+
+    /**
+     * @brief Прочитать текст всех карточек колоды без текста одним проходом
+     * @return false, если источник колоды так не умеет
+     */
+    bool forEachDeckText(const CardContentSource::TextVisitor &visit) const;
+
+    /**
+     * @brief Переставить rows по столбцу sortColumn
+     */
+    void applySort();
+
+    /**
+     * @brief Применить фильтры и сортировку заново со сбросом модели
+     */
+    void resetRows();
+
+    /**
+     * @brief Отобразимое значение ячейки
+     */
+    QVariant displayValue(int deckRow, int column) const;
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include <iterator>
+#include "CardStore.h"
+#include "DueIndex.h"
+
+/**
+ * @brief Невладеющее представление всех карточек колоды
+ *
+ * Позволяет пройти по карточкам колоды без копирования. Элементы
+ * представления - дескрипторы CardRef, читающие поля прямо из столбцов
+ * CardStore. Представление действительно, пока колода не изменяется.
+ *
+ * @see Deck::getCardsView()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CardSpan
+{
+public:
+    /**
+     * @brief Итератор по строкам хранилища
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CardRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = CardRef;
+
+        const_iterator() = default;
+        const_iterator(const CardStore *store, int row) : store(store), rowIndex(row) {}
+
+        CardRef operator*() const { return store->ref(rowIndex); }
+
+        /**
+         * @brief Позиция текущей карточки в колоде
+         */
+        int row() const { return rowIndex; }
+
+        const_iterator &operator++() { ++rowIndex; return *this; }
+        const_iterator operator++(int) { const_iterator tmp = *this; ++rowIndex; return tmp; }
+
+        bool operator==(const const_iterator &other) const { return rowIndex == other.rowIndex; }
+        bool operator!=(const const_iterator &other) const { return rowIndex != other.rowIndex; }
+
+    private:
+        const CardStore *store = nullptr;   ///< Хранилище колоды
+        int rowIndex = 0;                   ///< Текущая строка
+    };
+
+    CardSpan() = default;
+
+    /**
+     * @brief Создать представление над всеми строками хранилища
+     * @param store Хранилище колоды
+     */
+    explicit CardSpan(const CardStore *store) : store(store) {}
+
+    const_iterator begin() const { return const_iterator(store, 0); }
+    const_iterator end() const { return const_iterator(store, static_cast<int>(size())); }
+
+    /**
+     * @brief Количество карточек в представлении
+     */
+    qsizetype size() const { return store ? store->size() : 0; }
+
+    /**
+     * @brief Проверить, пусто ли представление
+     */
+    bool isEmpty() const { return size() == 0; }
+
+    /**
+     * @brief Доступ к карточке по позиции в колоде
+     * @param row Позиция карточки
+     * @return Дескриптор строки хранилища
+     */
+    CardRef operator[](qsizetype row) const { return store->ref(static_cast<int>(row)); }
+
+private:
+    const CardStore *store = nullptr;   ///< Хранилище колоды
+};
+
+/**
+ * @brief Ленивый диапазон карточек, готовых к повторению
+ *
+ * Обходит префикс индекса повторений (DueIndex) и превращает каждый
+ * элемент в дескриптор CardRef строки хранилища. Ни список, ни карточки
+ * не копируются, обход не выделяет память.
+ *
+ * Карточки перечисляются в порядке времени повторения: сначала карточки
+ * без даты, затем самые просроченные.
+ *
+ * @warning Любое изменение колоды (addCard, removeCard, reviewCard, setCards)
+ *          делает представление недействительным. Для сессии повторения
+ *          запрашивайте новое представление после каждой оценки.
+ * @see Deck::getDueCardsView()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class DueCardRange
+{
+public:
+    /**
+     * @brief Итератор по готовым к повторению карточкам
+     */
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CardRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = CardRef;
+
+        const_iterator() = default;
+        const_iterator(DueIndex::const_iterator pos, const CardStore *store) : pos(pos), store(store) {}
+
+        CardRef operator*() const { return store->ref(pos->row); }
+
+        /**
+         * @brief Позиция текущей карточки в колоде
+         */
+        int row() const { return pos->row; }
+
+        const_iterator &operator++() { ++pos; return *this; }
+        const_iterator operator++(int) { const_iterator tmp = *this; ++pos; return tmp; }
+
+        bool operator==(const const_iterator &other) const { return pos == other.pos; }
+        bool operator!=(const const_iterator &other) const { return pos != other.pos; }
+
+    private:
+        DueIndex::const_iterator pos;       ///< Текущий элемент индекса
+        const CardStore *store = nullptr;   ///< Хранилище колоды
+    };
+
+    DueCardRange() = default;
+
+    /**
+     * @brief Создать диапазон над участком индекса
+     * @param first Первый элемент индекса
+     * @param last Элемент, следующий за последним готовым
+     * @param store Хранилище колоды
+     */
+    DueCardRange(DueIndex::const_iterator first, DueIndex::const_iterator last, const CardStore *store)
+        : first(first), last(last), store(store) {}
+
+    const_iterator begin() const { return const_iterator(first, store); }
+    const_iterator end() const { return const_iterator(last, store); }
+
+    /**
+     * @brief Количество карточек в диапазоне
+     * @note Сложность O(1)
+     */
+    qsizetype size() const { return last - first; }
+
+    /**
+     * @brief Проверить, пуст ли диапазон
+     */
+    bool isEmpty() const { return first == last; }
+
+    /**
+     * @brief Самая приоритетная карточка (без даты или самая просроченная)
+     * @warning Диапазон не должен быть пустым
+     */
+    CardRef front() const { return store->ref(first->row); }
+
+private:
+    DueIndex::const_iterator first;     ///< Первый готовый элемент индекса
+    DueIndex::const_iterator last;      ///< Граница готовых элементов индекса
+    const CardStore *store = nullptr;   ///< Хранилище колоды
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <atomic>
+
+/**
+ * @brief Источник текущего времени для планирования повторений
+ *
+ * Card и Deck получают текущий момент через этот интерфейс вместо прямых
+ * вызовов QDateTime::currentDateTime(). Это позволяет:
+ * - читать время один раз на пакетную операцию;
+ * - подменять время в тестах и симуляциях и сдвигать его детерминированно;
+ * - заменить дорогой системный вызов с переводом в часовой пояс
+ *   дешевым монотонным счетчиком (CachedClock).
+ *
+ * Реализации должны быть потокобезопасны для чтения.
+ *
+ * @see SystemClock, FixedClock, CachedClock
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    /**
+     * @brief Текущий момент в локальном времени
+     */
+    virtual QDateTime now() const = 0;
+
+    /**
+     * @brief Текущий момент в миллисекундах от эпохи
+     * @note Дешевле now(): не создает QDateTime и не переводит часовой пояс
+     */
+    virtual qint64 nowMSecs() const = 0;
+
+    /**
+     * @brief Общие системные часы процесса
+     * @return Часы по умолчанию для Card и Deck
+     */
+    static const Clock &system();
+};
+
+/**
+ * @brief Системные часы: каждый вызов читает время заново
+ */
+class SystemClock : public Clock
+{
+public:
+    QDateTime now() const override;
+    qint64 nowMSecs() const override;
+};
+
+/**
+ * @brief Неподвижные часы с ручным сдвигом
+ *
+ * Время меняется только явными вызовами setNow() и advance(). Предназначены
+ * для тестов и симуляций расписания.
+ */
+class FixedClock : public Clock
+{
+public:
+    /**
+     * @brief Создать часы, остановленные на моменте now
+     * @param now Начальный момент; должен быть валидным
+     */
+    explicit FixedClock(const QDateTime &now);
+
+    QDateTime now() const override;
+    qint64 nowMSecs() const override;
+
+    /**
+     * @brief Переставить часы на заданный момент
+     */
+    void setNow(const QDateTime &now);
+
+    /**
+     * @brief Сдвинуть часы на заданное количество миллисекунд
+     */
+    void advance(qint64 msecs);
+
+    /**
+     * @brief Сдвинуть часы на заданное количество календарных дней
+     * @note Использует QDateTime::addDays(), поэтому учитывает переход на летнее время
+     */
+    void advanceDays(int days);
+
+private:
+    mutable QMutex mutex;       ///< Защищает current
+    QDateTime current;          ///< Текущий момент часов
+};
+
+/**
+ * @brief Монотонные часы с кэшированной датой
+ *
+ * При создании один раз читают системное время, а дальше отсчитывают его
+ * монотонным таймером QElapsedTimer, без перевода в часовой пояс.
+ * now() пересобирает QDateTime, только если с прошлого вызова прошло
+ * больше resolution миллисекунд, иначе возвращает кэш.
+ *
+ * @note Перевод системных часов (NTP, ручная установка) не отслеживается
+ *       до вызова resync()
+ */
+class CachedClock : public Clock
+{
+public:
+    /**
+     * @brief Создать часы
+     * @param resolutionMSecs Точность now() в миллисекундах
+     */
+    explicit CachedClock(qint64 resolutionMSecs = 1000);
+
+    QDateTime now() const override;
+    qint64 nowMSecs() const override;
+
+    /**
+     * @brief Заново синхронизироваться с системным временем
+     */
+    void resync();
+
+private:
+    QElapsedTimer timer;                    ///< Монотонный отсчет от момента синхронизации
+    std::atomic<qint64> baseMSecs{0};       ///< Системное время в момент синхронизации
+    qint64 resolution;                      ///< Точность кэша now()
+
+    mutable QMutex mutex;                   ///< Защищает кэш now()
+    mutable QDateTime cached;               ///< Последний выданный now()
+    mutable qint64 cachedMSecs = 0;         ///< Момент cached в мс от эпохи
+};
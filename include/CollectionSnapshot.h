@@ -0,0 +1,196 @@
+#pragma once
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "CardContent.h"
+#include "Deck.h"
+#include "ReviewRecord.h"
+
+/**
+ * @brief Двоичный снимок коллекции, отображаемый в память
+ *
+ * Снимок хранит колоды и карточки в том же столбцовом виде, что и
+ * CardStore: каждое поле карточки - отдельный раздел файла с записями
+ * фиксированной ширины, карточки одной колоды лежат подряд. Поэтому
+ * колода открывается без разбора записей: каждый столбец копируется
+ * из отображения одним блоком, а упорядоченный индекс повторений
+ * (DueIndex) хранится в снимке готовым.
+ *
+ * Тексты вопросов, ответов и названия колод вынесены в раздел строк
+ * и интернированы: одинаковые строки хранятся один раз, а при загрузке
+ * разделяют один буфер QString (implicit sharing).
+ *
+ * Заголовок содержит сигнатуру, версию формата и таблицу разделов;
+ * у заголовка и каждого раздела есть своя контрольная сумма.
+ *
+ * Изменения расписания не пишутся в снимок по одной: ответы копятся
+ * в журнале (ReviewJournal), а ReviewJournal::checkpoint() переносит
+ * их в снимок через applyReviews(), атомарно заменяя файл.
+ *
+ * Ошибки не бросают исключений: методы возвращают false, а текст ошибки
+ * доступен через lastError().
+ *
+ * @note Формат файла использует порядок байтов платформы
+ * @see Deck, ReviewJournal, DeckRepository
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CollectionSnapshot : public CardContentSource, public ReviewSink
+{
+public:
+    /// Версия формата файла
+    static constexpr quint32 kVersion = 1;
+
+    /**
+     * @brief Записать снимок коллекции
+     *
+     * Файл сначала пишется во временный и затем атомарно заменяет
+     * прежний (QSaveFile), поэтому сбой во время записи не портит снимок.
+     *
+     * Колоды в режиме Deck::isMetadataOnly() не записываются: их текст
+     * нужно сначала загрузить полностью.
+     *
+     * @param path Путь к файлу снимка
+     * @param decks Колоды коллекции
+     * @param errorMessage Текст ошибки (может быть nullptr)
+     * @return true при успехе
+     */
+    static bool write(const QString &path, const QList<Deck> &decks, QString *errorMessage = nullptr);
+
+    explicit CollectionSnapshot(const QString &path);
+    ~CollectionSnapshot() override;
+
+    CollectionSnapshot(const CollectionSnapshot &) = delete;
+    CollectionSnapshot &operator=(const CollectionSnapshot &) = delete;
+
+    /**
+     * @brief Отобразить снимок в память только для чтения
+     *
+     * Проверяет сигнатуру, версию, границы разделов, контрольную сумму
+     * заголовка и строки индекса повторений каждой колоды.
+     *
+     * @param verifyChecksums Проверить и контрольные суммы всех разделов
+     *        (чтение всего файла)
+     * @return true при успехе; текст ошибки - в lastError()
+     */
+    bool open(bool verifyChecksums = true);
+
+    /**
+     * @brief Снять отображение и закрыть файл
+     */
+    void close();
+
+    /**
+     * @brief Проверить, открыт ли снимок
+     */
+    bool isOpen() const;
+
+    // =============== ЧТЕНИЕ ===============
+
+    /**
+     * @brief Идентификаторы колод в порядке записи
+     */
+    QList<int> deckIds() const;
+
+    /**
+     * @brief Общее количество карточек в снимке
+     */
+    int cardCount() const;
+
+    /**
+     * @brief Открыть колоду из снимка
+     *
+     * Столбцы планирования и индекс повторений копируются блоками;
+     * тексты собираются из раздела строк.
+     *
+     * @param deckId Идентификатор колоды
+     * @param deck Заполняется при успехе
+     * @return true, если колода найдена
+     */
+    bool loadDeck(int deckId, Deck &deck);
+
+    /**
+     * @brief Открыть колоду без текста карточек
+     *
+     * Самый быстрый способ открыть колоду: копируются только столбцы
+     * планирования и индекс. Колода переводится в режим
+     * Deck::setMetadataOnly(), текст загружается по требованию через
+     * fetchContent().
+     *
+     * @param deckId Идентификатор колоды
+     * @param deck Заполняется при успехе
+     * @return true, если колода найдена
+     */
+    bool loadDeckMetadata(int deckId, Deck &deck);
+
+    /**
+     * @brief Прочитать текст одной карточки
+     *
+     * Медиаданные в снимке не хранятся и остаются пустыми.
+     *
+     * @param cardId Идентификатор карточки
+     * @param content Заполняется при успехе
+     * @return true, если карточка найдена
+     */
+    bool fetchContent(int cardId, CardContent &content) override;
+
+    /**
+     * @brief Прочитать текст всех карточек колоды
+     * @param deckId Идентификатор колоды
+     * @param visit Вызывается для каждой карточки в порядке колоды
+     * @return false, если снимок не открыт или колоды в нем нет
+     */
+    bool forEachText(int deckId, const TextVisitor &visit) override;
+
+    // =============== ЗАПИСЬ ===============
+
+    /**
+     * @brief Применить записи журнала повторений
+     *
+     * Переписывает столбцы планирования и индексы повторений затронутых
+     * колод, затем атомарно заменяет файл и заново отображает его.
+     * Записи для отсутствующих карточек пропускаются.
+     *
+     * @param records Записи журнала
+     * @return true при успехе; при ошибке файл на диске не изменяется
+     * @note Стоимость пропорциональна размеру снимка, поэтому записи
+     *       переносятся пакетами через ReviewJournal::checkpoint()
+     */
+    bool applyReviews(const QList<ReviewRecord> &records) override;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const override;
+
+private:
+    QString path;                       ///< Путь к файлу снимка
+    QFile file;                         ///< Файл снимка
+    const uchar *data = nullptr;        ///< Отображение файла в память
+    qint64 size = 0;                    ///< Размер отображения
+    QHash<int, int> rowById;            ///< Строка снимка по идентификатору карточки (строится лениво)
+    QString errorText;                  ///< Текст последней ошибки
+
+    /**
+     * @brief Загрузить колоду с текстом или без
+     */
+    bool load(int deckId, Deck &deck, bool metadataOnly);
+
+    /**
+     * @brief Найти строку карточки во всем снимке
+     * @return Строка или -1
+     */
+    int rowOf(int cardId);
+
+    /**
+     * @brief Прочитать строку раздела строк
+     */
+    QString string(quint32 index) const;
+
+    /**
+     * @brief Запомнить ошибку и вернуть false
+     */
+    bool fail(const QString &message);
+};
@@ -0,0 +1,195 @@
+#pragma once
+#include <QList>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include "Deck.h"
+
+/**
+ * @brief Колода для одновременного чтения из многих потоков и записи из одного
+ *
+ * Колода хранится неизменяемыми версиями (RCU). Читатель берет снимок
+ * read() и работает с версией, которая не изменится, пока снимок жив:
+ * статистика и поиск в фоновых потоках видят согласованное состояние
+ * всех карточек, даже если сессия повторения одновременно ставит оценки.
+ *
+ * Писатель (update(), reviewCard(), applyGrades()) копирует текущую
+ * версию, изменяет копию и публикует её одной атомарной записью
+ * указателя. Копия дешевая: столбцы CardStore и индекс повторений
+ * разделяются (implicit sharing) и копируются только изменяемые
+ * столбцы. Писатели упорядочиваются мьютексом, читатели его не берут.
+ *
+ * Освобождение старых версий основано на эпохах: читатель объявляет
+ * эпоху в своей ячейке, а писатель удаляет версию, когда ни одна
+ * активная ячейка не объявила эпоху раньше её замены. Взятие снимка -
+ * захват ячейки (CAS) и чтение указателя, без блокировок.
+ *
+ * Полнотекстовый индекс, кэш счетчиков и прогноз не потокобезопасны, поэтому
+ * версии их не хранят: рабочая копия изменяется без них, а индекс,
+ * подключенный к начальной колоде, обновляется писателем после
+ * успешного изменения, перед публикацией. Отмененное изменение
+ * индекс не затрагивает. Кэш содержимого (CardContentCache) версии
+ * тоже не хранят: его источник, например CardRepository поверх
+ * QSqlDatabase, нельзя вызывать из потоков читателей. Текст колоды,
+ * загруженной без текста, читатель получает из своего источника.
+ *
+ * @note Стоимость публикации - копия изменяемых столбцов, O(n):
+ *       оценки выгоднее применять пакетами через applyGrades()
+ * @warning Снимки должны быть освобождены до уничтожения колоды.
+ *          DueCountCache к версиям не подключается: счетчик снимка
+ *          берется из его индекса повторений (Deck::getDueCount())
+ * @see Deck, DeckHandoff
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class ConcurrentDeck
+{
+    struct Version;
+
+public:
+    /// Ячеек читателей по умолчанию
+    static constexpr int kDefaultReaderSlots = 64;
+
+    /**
+     * @brief Снимок колоды для чтения
+     *
+     * Пока снимок жив, версия не освобождается и не изменяется.
+     * Снимок только перемещается; освобождение - в деструкторе.
+     */
+    class Snapshot
+    {
+    public:
+        Snapshot(Snapshot &&other) noexcept;
+        Snapshot &operator=(Snapshot &&other) noexcept;
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+        ~Snapshot();
+
+        const Deck &deck() const;
+        const Deck *operator->() const { return &deck(); }
+
+        /**
+         * @brief Номер версии; растет на единицу с каждой публикацией
+         */
+        quint64 version() const;
+
+    private:
+        friend class ConcurrentDeck;
+        Snapshot(std::atomic<quint64> *slot, const Version *version);
+
+        /**
+         * @brief Освободить ячейку читателя
+         */
+        void release();
+
+        std::atomic<quint64> *slot = nullptr;   ///< Ячейка читателя
+        const Version *current = nullptr;       ///< Удерживаемая версия
+    };
+
+    /**
+     * @param deck Начальное состояние колоды; её полнотекстовый индекс
+     *        (Deck::setSearchIndex()) переходит под управление писателя,
+     *        а кэш счетчиков, прогноз и кэш содержимого отключаются
+     * @param readerSlots Наибольшее количество одновременных снимков;
+     *        при нехватке ячеек read() ждет освобождения
+     */
+    explicit ConcurrentDeck(Deck deck = Deck(), int readerSlots = kDefaultReaderSlots);
+    ~ConcurrentDeck();
+
+    ConcurrentDeck(const ConcurrentDeck &) = delete;
+    ConcurrentDeck &operator=(const ConcurrentDeck &) = delete;
+
+    // =============== ЧТЕНИЕ ===============
+
+    /**
+     * @brief Взять снимок текущей версии (из любого потока, без блокировок)
+     */
+    Snapshot read() const;
+
+    /**
+     * @brief Номер текущей версии
+     */
+    quint64 version() const;
+
+    // =============== ЗАПИСЬ ===============
+
+    /**
+     * @brief Изменить колоду и опубликовать новую версию
+     *
+     * Функция получает копию текущей версии; читатели видят
+     * изменения целиком после возврата из update(). Обработчики,
+     * подключенные к копии внутри mutation, отключаются.
+     *
+     * @param mutation Изменение копии колоды; false отменяет изменение
+     * @return Результат mutation; при false версия не публикуется
+     */
+    bool update(const std::function<bool(Deck &deck)> &mutation);
+
+    /**
+     * @brief Оценить карточку и опубликовать новую версию
+     * @see Deck::reviewCard()
+     */
+    bool reviewCard(int cardId, int grade);
+
+    /**
+     * @brief Применить пакет оценок одной публикацией
+     * @see Deck::applyGrades()
+     */
+    int applyGrades(const QList<CardGrade> &grades);
+
+    /**
+     * @brief Количество замененных версий, которые еще держат читатели
+     */
+    int retainedVersions() const;
+
+private:
+    /**
+     * @brief Опубликованная версия колоды
+     */
+    struct Version {
+        Deck deck;                  ///< Неизменяемое состояние
+        quint64 number = 0;         ///< Номер публикации
+        quint64 retiredAt = 0;      ///< Эпоха замены; читатели с эпохой раньше могут её держать
+    };
+
+    /// Значение свободной ячейки читателя
+    static constexpr quint64 kIdle = std::numeric_limits<quint64>::max();
+
+    /**
+     * @brief Ячейка читателя на отдельной строке кэша
+     */
+    struct alignas(64) ReaderSlot {
+        std::atomic<quint64> epoch{kIdle};  ///< Объявленная эпоха или kIdle
+    };
+
+    std::atomic<Version *> current;             ///< Опубликованная версия
+    std::atomic<quint64> epoch{1};              ///< Глобальная эпоха
+    std::unique_ptr<ReaderSlot[]> readers;      ///< Ячейки читателей
+    int slotCount;                              ///< Количество ячеек
+    mutable QMutex writer;                      ///< Упорядочивает писателей, защищает retired
+    QList<Version *> retired;                   ///< Замененные, еще не освобожденные версии
+    SearchIndex *searchIndex = nullptr;         ///< Полнотекстовый индекс колоды (не владеет)
+
+    /**
+     * @brief Отключить от версии обработчики, не допускающие доступа из нескольких потоков
+     */
+    static void detachObservers(Deck &deck);
+
+    /**
+     * @brief Перенести изменения текста новой версии в полнотекстовый индекс
+     */
+    void reindex(const Deck &previous, const Deck &next);
+
+    /**
+     * @brief Опубликовать версию и освободить версии без читателей
+     */
+    void publish(Version *next);
+
+    /**
+     * @brief Удалить замененные версии, которые не может держать ни один читатель
+     */
+    void reclaim();
+};
@@ -0,0 +1,193 @@
+#pragma once
+#include <QList>
+#include <QString>
+#include <functional>
+#include "Card.h"
+
+class QIODevice;
+class Deck;
+class CardRepository;
+class StringPool;
+
+/**
+ * @brief Потоковый импорт карточек из CSV и TSV
+ *
+ * Файл читается блоками фиксированного размера, поэтому импорт
+ * многогигабайтного файла не держит его в памяти целиком. Поток чтения
+ * только находит в блоке границу последней целой записи (с учетом
+ * переводов строк внутри кавычек) и передает блок в пул потоков
+ * (QThreadPool). Рабочие потоки разбирают записи и собирают карточки,
+ * а готовые блоки выдаются получателю строго в порядке файла пакетами
+ * по batchSize карточек. Количество блоков в обработке ограничено,
+ * так что память не зависит от размера файла.
+ *
+ * Формат - RFC 4180: поля в двойных кавычках могут содержать
+ * разделитель, перевод строки и удвоенную кавычку. Кодировка - UTF-8.
+ *
+ * Первая строка по умолчанию - заголовок с именами столбцов
+ * (регистр не важен, неизвестные столбцы пропускаются):
+ * - question, answer - обязательные;
+ * - id, content_type, test_mode, easy_factor, interval_days,
+ *   repetitions, next_review, last_review - необязательные.
+ *
+ * Без заголовка первый столбец - вопрос, второй - ответ. Тип содержимого
+ * и режим тестирования задаются именем (text, image, audio; direct,
+ * multiple_choice, matching) или номером; даты - в ISO 8601 или
+ * миллисекундами от эпохи, пустое поле - дата не задана.
+ *
+ * Некорректные записи (нехватка полей, пустой вопрос, неверное число,
+ * дата или перечисление, незакрытая кавычка) пропускаются и попадают
+ * в отчет Result::errors с номером строки файла.
+ *
+ * Ошибки не бросают исключений: import() возвращает false, а текст
+ * ошибки доступен через lastError().
+ *
+ * @see Deck::addCards(), CardRepository::insertCards()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class CsvImporter
+{
+public:
+    /**
+     * @brief Параметры импорта
+     */
+    struct Options {
+        char delimiter = ',';           ///< Разделитель полей; '\t' для TSV
+        bool hasHeader = true;          ///< Первая строка - имена столбцов
+        int deckId = 0;                 ///< Колода импортируемых карточек
+        int firstCardId = 1;            ///< Идентификатор первой карточки, если нет столбца id; см. importFile(path, cards)
+        int chunkBytes = 4 << 20;       ///< Размер блока чтения
+        int batchSize = 50000;          ///< Карточек в пакете получателя
+        int threadCount = 0;            ///< Потоков разбора; 0 - по числу ядер
+        int maxReportedErrors = 1000;   ///< Наибольшее количество сохраняемых ошибок
+        StringPool *stringPool = nullptr;   ///< Пул текста карточек; nullptr - без интернирования (не владеет)
+    };
+
+    /**
+     * @brief Некорректная запись
+     */
+    struct RowError {
+        qint64 line = 0;                ///< Номер строки файла, с которой начинается запись (с 1)
+        QString message;                ///< Описание ошибки
+    };
+
+    /**
+     * @brief Итог импорта
+     */
+    struct Result {
+        qint64 bytesRead = 0;           ///< Прочитано байт
+        qint64 rows = 0;                ///< Записей данных (без заголовка)
+        qint64 imported = 0;            ///< Карточек передано получателю
+        qint64 malformed = 0;           ///< Пропущено некорректных записей
+        QList<RowError> errors;         ///< Первые maxReportedErrors ошибок в порядке файла
+        qint64 elapsedMSecs = 0;        ///< Длительность импорта
+    };
+
+    /**
+     * @brief Получатель пакета карточек
+     *
+     * Вызывается в потоке import() в порядке файла.
+     *
+     * @return false прерывает импорт
+     */
+    using BatchSink = std::function<bool(QList<Card> &&batch)>;
+
+    /**
+     * @brief Обработчик прогресса
+     *
+     * Вызывается в потоке import() после каждого выданного блока.
+     * Для обновления интерфейса запускайте импорт в рабочем потоке
+     * и передавайте прогресс в поток интерфейса сигналом или
+     * QMetaObject::invokeMethod().
+     *
+     * @param bytesProcessed Обработано байт
+     * @param totalBytes Размер файла или -1 для последовательного устройства
+     * @param rowsImported Карточек передано получателю
+     */
+    using ProgressCallback = std::function<void(qint64 bytesProcessed, qint64 totalBytes, qint64 rowsImported)>;
+
+    CsvImporter();
+    explicit CsvImporter(const Options &options);
+
+    /**
+     * @brief Установить обработчик прогресса
+     */
+    void setProgressCallback(ProgressCallback callback);
+
+    /**
+     * @brief Импортировать карточки из открытого устройства
+     * @param device Устройство, открытое на чтение
+     * @param sink Получатель пакетов
+     * @return true, если файл прочитан до конца; некорректные записи
+     *         ошибкой импорта не считаются
+     */
+    bool import(QIODevice &device, const BatchSink &sink);
+
+    /**
+     * @brief Импортировать карточки из файла
+     * @param path Путь к файлу
+     * @param sink Получатель пакетов
+     * @return true, если файл прочитан до конца
+     */
+    bool importFile(const QString &path, const BatchSink &sink);
+
+    /**
+     * @brief Импортировать карточки из файла в базу данных
+     *
+     * Карточки записываются в колоду Options::deckId через repositorySink().
+     * Если в файле нет столбца id, нумерация начинается с
+     * CardRepository::nextCardId() (но не меньше Options::firstCardId),
+     * поэтому импорт не задевает карточки других колод.
+     *
+     * @param path Путь к файлу
+     * @param cards Хранилище карточек
+     * @return true, если файл прочитан до конца
+     */
+    bool importFile(const QString &path, CardRepository &cards);
+
+    /**
+     * @brief Итог последнего импорта
+     */
+    const Result &result() const;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+    // =============== ПОЛУЧАТЕЛИ ===============
+
+    /**
+     * @brief Получатель, добавляющий пакеты в колоду
+     * @param deck Колода; должна пережить импорт
+     * @see Deck::addCards()
+     */
+    static BatchSink deckSink(Deck &deck);
+
+    /**
+     * @brief Получатель, записывающий пакеты в базу данных
+     *
+     * Каждый пакет записывается одной транзакцией. Карточка с уже занятым
+     * идентификатором прерывает импорт: при нумерации импортером
+     * используйте importFile(path, cards) или задайте Options::firstCardId
+     * из CardRepository::nextCardId().
+     *
+     * @param cards Хранилище карточек; должно пережить импорт
+     * @param deckId Колода в базе данных
+     * @see CardRepository::insertCards()
+     */
+    static BatchSink repositorySink(CardRepository &cards, int deckId);
+
+private:
+    Options options;                    ///< Параметры импорта
+    ProgressCallback progressCallback;  ///< Обработчик прогресса
+    Result summary;                     ///< Итог последнего импорта
+    QString errorText;                  ///< Текст последней ошибки
+
+    /**
+     * @brief Запомнить ошибку и вернуть false
+     */
+    bool fail(const QString &message);
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QString>
+
+/**
+ * @brief Открытие и разметка базы данных SQLite для хранения колод
+ *
+ * Схема:
+ * - decks(id, name) - колоды;
+ * - cards(id, deck_id, position, question, answer, content_type, test_mode,
+ *   easy_factor, interval_days, repetitions, next_review, last_review) -
+ *   карточки; position сохраняет порядок карточек в колоде;
+ * - card_media(card_id, data) - изображения и звук карточек, читаются
+ *   только по требованию;
+ * - cards_fts(question, answer) - необязательный полнотекстовый индекс
+ *   FTS5 над cards, поддерживается триггерами. Создается только
+ *   enableFullTextSearch(): триггеры удваивают стоимость записи карточек.
+ *
+ * Даты хранятся как INTEGER - миллисекунды от эпохи, отсутствующая дата -
+ * как CardStore::kNoDate. Поэтому выборка готовых карточек - это диапазон
+ * `next_review <= now` по индексу (deck_id, next_review) без особого
+ * случая для NULL.
+ *
+ * @see CardRepository, DeckRepository
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+namespace Database {
+
+/**
+ * @brief Открыть (или создать) базу данных и подготовить схему
+ *
+ * Включает журнал WAL (читатели не блокируют писателя),
+ * synchronous=NORMAL (достаточно для WAL) и создает таблицы и индексы,
+ * если их еще нет.
+ *
+ * @param path Путь к файлу базы данных или ":memory:"
+ * @param connectionName Имя соединения QSqlDatabase; должно быть уникальным
+ * @param errorMessage Текст ошибки, если открыть базу не удалось (может быть nullptr)
+ * @return Открытое соединение или невалидное при ошибке
+ * @note Закрывайте соединение через QSqlDatabase::removeDatabase(connectionName)
+ *       после уничтожения всех репозиториев, использующих его
+ */
+QSqlDatabase open(const QString &path, const QString &connectionName,
+                  QString *errorMessage = nullptr);
+
+/**
+ * @brief Создать таблицы и индексы, если их еще нет
+ * @param database Открытое соединение
+ * @param errorMessage Текст ошибки (может быть nullptr)
+ * @return true при успехе
+ */
+bool createSchema(QSqlDatabase &database, QString *errorMessage = nullptr);
+
+/**
+ * @brief Включить полнотекстовый поиск по карточкам
+ *
+ * Создает таблицу cards_fts с триггерами и заполняет её текстом уже
+ * сохраненных карточек. Индекс хранится в файле базы: после включения
+ * он поддерживается при каждом открытии. Повторный вызов ничего не делает.
+ *
+ * @param database Открытое соединение
+ * @param errorMessage Текст ошибки (может быть nullptr)
+ * @return true, если индекс включен
+ * @see CardRepository::search()
+ */
+bool enableFullTextSearch(QSqlDatabase &database, QString *errorMessage = nullptr);
+
+/**
+ * @brief Проверить, включен ли полнотекстовый поиск
+ * @param database Открытое соединение
+ */
+bool hasFullTextSearch(QSqlDatabase &database);
+
+/**
+ * @brief Выполнить запись в одной транзакции
+ *
+ * Транзакция фиксируется, если writer вернул true, и откатывается,
+ * если writer вернул false или фиксация не удалась.
+ *
+ * @param database Открытое соединение
+ * @param errorMessage Текст ошибки самой транзакции (может быть nullptr);
+ *        ошибки внутри writer сообщает он сам
+ * @param writer Вызываемый объект bool()
+ * @return true, если транзакция зафиксирована
+ */
+template<typename Writer>
+bool inTransaction(QSqlDatabase &database, QString *errorMessage, Writer &&writer)
+{
+    if (!database.transaction()) {
+        if (errorMessage) {
+            *errorMessage = database.lastError().text();
+        }
+        return false;
+    }
+
+    if (!writer()) {
+        database.rollback();
+        return false;
+    }
+
+    if (!database.commit()) {
+        if (errorMessage) {
+            *errorMessage = database.lastError().text();
+        }
+        database.rollback();
+        return false;
+    }
+    return true;
+}
+
+} // namespace Database
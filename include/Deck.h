@@ -1,7 +1,28 @@
 #pragma once
 #include <QString>
 #include <QList>
+#include <QHash>
 #include "Card.h"
+#include "CardContent.h"
+#include "Clock.h"
+#include "CardStore.h"
+#include "CardView.h"
+#include "DueIndex.h"
+#include "ReviewForecast.h"
+
+class CardContentCache;
+class SearchIndex;
+class DueCountCache;
+class Scheduler;
+
+/**
+ * @brief Оценка ответа по карточке для пакетного перепланирования
+ * @see Deck::applyGrades()
+ */
+struct CardGrade {
+    int cardId;     ///< Идентификатор карточки
+    int grade;      ///< Оценка ответа (0-5)
+};
 
 /**
  * @brief Класс, представляющий колоду учебных карточек
@@ -10,6 +31,10 @@
  * Предоставляет функциональность для управления карточками, получения статистики
  * и фильтрации карточек, готовых к повторению.
  *
+ * Карточки хранятся по столбцам в CardStore: поля планирования лежат в плотных
+ * массивах отдельно от текста. Card используется как значение для обмена
+ * с колодой, CardRef - как дескриптор строки без копирования.
+ *
  * @note Все методы получения данных являются константными и не модифицируют объект
  * @see Card
  *
@@ -17,10 +42,68 @@
  * @version 1.0
  */
 class Deck {
+    friend class CollectionSnapshot;
+    friend class ReviewQueue;
+    friend class DueCountCache;
+    friend class ReviewForecast;
+    friend class CardTableModel;
+    friend class DeckBuilder;
+    friend class ConcurrentDeck;
+
 private:
     int id;                     ///< Уникальный идентификатор колоды
     QString name;               ///< Название колоды
-    QList<Card> cards;          ///< Список карточек в колоде
+    CardStore store;            ///< Столбцовое хранилище карточек колоды
+    DueIndex dueIndex;          ///< Индекс карточек по дате следующего повторения
+    QHash<int, int> rowById;    ///< Позиция карточки в списке по её идентификатору
+    const Clock *clock;         ///< Источник текущего времени (не владеет)
+    CardContentCache *contentCache = nullptr;   ///< Ленивое содержимое карточек (не владеет)
+    SearchIndex *searchIndex = nullptr;         ///< Полнотекстовый индекс (не владеет)
+    DueCountCache *dueCountCache = nullptr;     ///< Кэш счетчиков готовых карточек (не владеет)
+    ReviewForecast *forecast = nullptr;         ///< Поддерживаемый прогноз нагрузки (не владеет)
+    const Scheduler *scheduler = nullptr;       ///< Планировщик; nullptr - SM-2 (не владеет)
+
+    /**
+     * @brief Перестроить индекс повторений и таблицу позиций
+     */
+    void rebuildIndexes();
+
+    /**
+     * @brief Пересчитать подключенный прогноз по индексу повторений
+     */
+    void rebuildForecast();
+
+    /**
+     * @brief Перестроить таблицу позиций по идентификаторам
+     */
+    void rebuildRowIds();
+
+    /**
+     * @brief Добавить строки начиная с firstRow в полнотекстовый индекс
+     */
+    void indexCards(int firstRow);
+
+    /**
+     * @brief Убрать карточки колоды из полнотекстового индекса
+     */
+    void unindexCards();
+
+    /**
+     * @brief Заменить карточки готовым хранилищем и индексом повторений
+     *
+     * Используется при открытии снимка коллекции: индекс уже упорядочен,
+     * поэтому перестраивается только таблица позиций.
+     *
+     * @param cards Хранилище карточек
+     * @param index Индекс повторений, согласованный с cards
+     */
+    void assignStore(CardStore cards, DueIndex index);
+
+    /**
+     * @brief Позиции готовых к повторению карточек в порядке колоды
+     * @param now Текущий момент (мс от эпохи)
+     */
+    QList<int> dueRows(qint64 now) const;
 
 public:
     /**
@@ -54,10 +137,44 @@ public:
     /**
      * @brief Получить список всех карточек в колоде
      * @return QList<Card> Копия списка карточек
-     * @note Возвращает копию списка. Для модификации карточек используйте сеттеры.
+     * @note Собирает карточки из столбцов хранилища. Для модификации карточек используйте сеттеры.
+     * @note Для обхода без копирования используйте getCardsView()
      */
     QList<Card> getCards() const;
 
+    /**
+     * @brief Получить представление всех карточек без копирования
+     * @return CardSpan Невладеющий диапазон дескрипторов CardRef
+     * @warning Представление недействительно после изменения колоды
+     */
+    CardSpan getCardsView() const;
+
+    /**
+     * @brief Получить количество карточек в колоде
+     * @return Количество карточек
+     */
+    int getCardCount() const;
+
+    /**
+     * @brief Найти позицию карточки в колоде
+     * @param cardId Идентификатор карточки
+     * @return Позиция для getCardsView()[] или -1, если карточки нет
+     * @note Сложность O(1)
+     */
+    int indexOf(int cardId) const;
+
+    /**
+     * @brief Получить часы, по которым колода определяет текущий момент
+     * @return Часы колоды; по умолчанию Clock::system()
+     */
+    const Clock &getClock() const;
+
+    /**
+     * @brief Получить планировщик повторений колоды
+     * @return Планировщик, заданный setScheduler(), или Scheduler::defaultScheduler()
+     */
+    const Scheduler &getScheduler() const;
+
     // =============== СЕТТЕРЫ ===============
 
     /**
@@ -79,6 +196,199 @@ public:
      */
     void setCards(QList<Card> cards);
 
+    /**
+     * @brief Установить часы для операций повторения
+     *
+     * Часы используются в getDueCards(), getDueCardsView(), getDueCount(),
+     * reviewCard() и applyGrades() без явного момента.
+     *
+     * @param clock Часы; nullptr возвращает системные часы
+     * @warning Колода не владеет часами: они должны пережить колоду
+     *          и все её копии
+     */
+    void setClock(const Clock *clock);
+
+    /**
+     * @brief Установить алгоритм планирования для reviewCard() и applyGrades()
+     *
+     * По умолчанию колода планирует по SM-2 пакетным путем
+     * CardStore::applyGrades(). С другим планировщиком оценки применяются
+     * по одной через CardStore::review().
+     *
+     * @param scheduler Планировщик; nullptr возвращает SM-2
+     * @warning Колода не владеет планировщиком: он должен пережить колоду
+     *          и все её копии
+     */
+    void setScheduler(const Scheduler *scheduler);
+
+    // =============== ЛЕНИВОЕ СОДЕРЖИМОЕ ===============
+
+    /**
+     * @brief Хранить только поля планирования, без текста карточек
+     *
+     * В этом режиме колода не держит вопросы и ответы в памяти:
+     * getCards(), getDueCards() и представления возвращают карточки
+     * с пустым текстом, а содержимое выдает getContent() через
+     * CardContentCache.
+     *
+     * @param metadataOnly true освобождает уже загруженный текст и убирает
+     *        карточки колоды из полнотекстового индекса
+     * @see DeckRepository::loadDeckMetadata()
+     */
+    void setMetadataOnly(bool metadataOnly);
+
+    /**
+     * @brief Проверить, хранит ли колода только поля планирования
+     */
+    bool isMetadataOnly() const;
+
+    /**
+     * @brief Установить кэш содержимого карточек
+     * @param cache Кэш; nullptr отключает ленивую загрузку
+     * @warning Колода не владеет кэшем: он должен пережить колоду
+     */
+    void setContentCache(CardContentCache *cache);
+
+    /**
+     * @brief Получить текст и медиаданные карточки
+     *
+     * Текст берется из памяти колоды, если она его хранит; иначе, как и
+     * медиаданные карточек Image/Audio, - из кэша содержимого.
+     *
+     * @param cardId Идентификатор карточки
+     * @return Содержимое; пустое, если карточки нет или содержимое недоступно
+     */
+    CardContent getContent(int cardId) const;
+
+    // =============== ПОИСК ===============
+
+    /**
+     * @brief Подключить полнотекстовый индекс
+     *
+     * Текущие карточки колоды сразу добавляются в индекс, а затем
+     * колода сама поддерживает его при добавлении, удалении, замене
+     * карточек и изменении их текста (updateCard()). Один индекс
+     * можно подключить к нескольким колодам коллекции.
+     * Колода без текста (setMetadataOnly) новые карточки в индекс не
+     * добавляет, но удаленные и замененные карточки из него убирает.
+     * При замене индекса карточки колоды убираются из прежнего.
+     *
+     * @param index Индекс; nullptr отключает индекс и убирает из него карточки колоды
+     * @warning Колода не владеет индексом: он должен пережить колоду
+     * @see SearchIndex
+     */
+    void setSearchIndex(SearchIndex *index);
+
+    // =============== СЧЕТЧИКИ ===============
+
+    /**
+     * @brief Подключить кэш счетчиков готовых карточек
+     *
+     * Колода сообщает кэшу о каждом изменении индекса повторений.
+     * Вызывается из DueCountCache::addDeck() и removeDeck().
+     *
+     * @param cache Кэш; nullptr отключает уведомления
+     * @see DueCountCache
+     */
+    void setDueCountCache(DueCountCache *cache);
+
+    /**
+     * @brief Подключить прогноз нагрузки, поддерживаемый без пересчета
+     *
+     * Прогноз сразу пересчитывается по индексу повторений колоды с теми
+     * же моментом построения и горизонтом. Затем колода переносит
+     * карточки между корзинами при каждом изменении (cardAdded(),
+     * cardRemoved(), cardRescheduled()), а после массовых изменений
+     * пересчитывает прогноз за O(d log n).
+     *
+     * @param forecast Прогноз, построенный ReviewForecast(now, days);
+     *        nullptr отключает уведомления
+     * @warning Колода не владеет прогнозом: он должен пережить колоду
+     * @see ReviewForecast
+     */
+    void setForecast(ReviewForecast *forecast);
+
+    // =============== УПРАВЛЕНИЕ КАРТОЧКАМИ ===============
+
+    /**
+     * @brief Добавить карточку в конец колоды
+     * @param card Добавляемая карточка
+     * @note Индекс повторений обновляется за O(log n) плюс сдвиг хвоста индекса
+     */
+    void addCard(const Card &card);
+
+    /**
+     * @brief Добавить пакет карточек в конец колоды
+     *
+     * Для массового добавления, например при импорте: индекс повторений
+     * обновляется одним слиянием на пакет, а не вставкой каждой карточки.
+     *
+     * @param cards Добавляемые карточки
+     * @see CsvImporter
+     */
+    void addCards(QList<Card> cards);
+
+    /**
+     * @brief Удалить карточку из колоды
+     * @param cardId Идентификатор удаляемой карточки
+     * @return true, если карточка найдена и удалена
+     * @note При совпадающих идентификаторах удаляется первая по порядку карточка
+     */
+    bool removeCard(int cardId);
+
+    /**
+     * @brief Заменить карточку с тем же идентификатором
+     *
+     * Изменения текста (Card::setQuestion(), Card::setAnswer()) попадают
+     * в полнотекстовый индекс, изменение даты повторения - в индекс
+     * повторений.
+     *
+     * @param card Карточка с измененными полями
+     * @return true, если карточка найдена
+     */
+    bool updateCard(const Card &card);
+
+    /**
+     * @brief Оценить ответ по карточке и перепланировать её
+     *
+     * Пересчитывает поля планирования карточки планировщиком колоды
+     * (по умолчанию как Card::updateSM2()) и переносит её в индексе
+     * повторений на новую дату.
+     *
+     * @param cardId Идентификатор карточки
+     * @param grade Оценка ответа (0-5)
+     * @return true, если карточка найдена
+     * @see Card::updateSM2(), setScheduler()
+     */
+    bool reviewCard(int cardId, int grade);
+
+    /**
+     * @brief Применить пакет оценок с общим моментом ответа
+     *
+     * Пакетная альтернатива циклу reviewCard() для массового выставления
+     * оценок и пересчета расписания из истории ответов: момент ответа
+     * передается один раз, а поля планирования обновляются одним проходом
+     * по столбцам хранилища (CardStore::applyGrades()).
+     *
+     * Оценки применяются в порядке списка; повторные оценки одной карточки
+     * учитываются последовательно, как при вызовах reviewCard().
+     *
+     * @param grades Пары (идентификатор карточки, оценка)
+     * @param now Момент ответа для всех оценок
+     * @return Количество примененных оценок; неизвестные идентификаторы пропускаются
+     * @note Для большого пакета индекс повторений перестраивается целиком
+     * @see reviewCard()
+     */
+    int applyGrades(const QList<CardGrade> &grades, const QDateTime &now);
+
+    /**
+     * @brief Применить пакет оценок, прочитав время часов колоды один раз
+     * @param grades Пары (идентификатор карточки, оценка)
+     * @return Количество примененных оценок
+     * @see setClock()
+     */
+    int applyGrades(const QList<CardGrade> &grades);
+
     // =============== ФУНКЦИОНАЛ ПОВТОРЕНИЯ ===============
 
     /**
@@ -89,12 +399,29 @@ public:
      * - Дата следующего повторения (nextReview) наступила или прошла
      * - Или дата следующего повторения не установлена (невалидная QDateTime)
      *
+     * Карточки возвращаются в порядке колоды.
+     *
      * @return QList<Card> Список карточек, требующих повторения
+     * @note Для большой доли готовых карточек отбор выполняет векторизованный
+     *       фильтр DueFilter вместо сортировки позиций из индекса
      * @see Card::getNextReview()
      * @see getDueCount()
      */
     QList<Card> getDueCards() const;
 
+    /**
+     * @brief Получить ленивый диапазон карточек для повторения без копирования
+     *
+     * Карточки перечисляются в порядке времени повторения (самые
+     * просроченные первыми). Обход не выделяет память.
+     *
+     * @return DueCardRange Невладеющий диапазон готовых карточек
+     * @note Сложность O(log n) на построение диапазона
+     * @warning Представление недействительно после изменения колоды
+     * @see getDueCards()
+     */
+    DueCardRange getDueCardsView() const;
+
     /**
      * @brief Получить количество карточек для повторения сегодня
      *
@@ -102,7 +429,20 @@ public:
      * не создает копии карточек, а только подсчитывает их количество.
      *
      * @return int Количество карточек, готовых к повторению
+     * @note Сложность O(log n) благодаря индексу повторений
      * @see getDueCards()
      */
     int getDueCount() const;
+
+    /**
+     * @brief Прогноз нагрузки на ближайшие дни
+     *
+     * Строится по индексу повторений без обхода карточек.
+     *
+     * @param days Количество дневных корзин, начиная с сегодняшней
+     * @return Гистограмма повторений по дням на момент часов колоды
+     * @note Сложность O(days log n)
+     * @see ReviewForecast
+     */
+    ReviewForecast getForecast(int days) const;
 };
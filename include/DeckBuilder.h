@@ -0,0 +1,109 @@
+#pragma once
+#include <QByteArrayView>
+#include <QSharedPointer>
+#include <QStringView>
+#include "CardStore.h"
+#include "SM2.h"
+#include "TextArena.h"
+
+class Deck;
+
+/**
+ * @brief Массовая сборка колоды без выделения памяти на каждую карточку
+ *
+ * Поля карточек раскладываются сразу по столбцам CardStore, а текст
+ * вопросов и ответов копируется в TextArena. Объекты Card и отдельные
+ * буферы QString не создаются, поэтому сборка миллиона карточек
+ * выделяет память несколько сотен раз, а не миллионы.
+ *
+ * Буфер текста передается колоде в build() и живет, пока жива колода
+ * или любая её копия: уничтожение колоды освобождает его блоки целиком.
+ *
+ * @note Изменения колоды после сборки работают как обычно: новые
+ *       и перезаписанные строки хранят текст в собственных QString
+ * @see CardStore, TextArena
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class DeckBuilder
+{
+public:
+    /**
+     * @brief Поля планирования строки
+     */
+    struct Row {
+        int id = 0;                                     ///< Идентификатор карточки
+        int deckId = 0;                                 ///< Колода
+        ContentType contentType = ContentType::Text;    ///< Тип содержимого
+        TestMode testMode = TestMode::DirectAnswer;     ///< Режим тестирования
+        float easyFactor = SM2::kMaxEasyFactor;         ///< Фактор легкости
+        int intervalDays = 0;                           ///< Интервал в днях
+        int repetitions = 0;                            ///< Успешные повторения подряд
+        qint64 nextReview = CardStore::kNoDate;         ///< Мс от эпохи или kNoDate
+        qint64 lastReview = CardStore::kNoDate;         ///< Мс от эпохи или kNoDate
+    };
+
+    /**
+     * @param expectedCards Ожидаемое количество карточек (резерв столбцов)
+     * @param blockChars Размер блока буфера текста в символах UTF-16
+     */
+    explicit DeckBuilder(int expectedCards = 0, qsizetype blockChars = TextArena::kDefaultBlockChars);
+
+    DeckBuilder(const DeckBuilder &) = delete;
+    DeckBuilder &operator=(const DeckBuilder &) = delete;
+
+    /**
+     * @brief Добавить карточку
+     * @param row Поля планирования
+     * @param question Текст вопроса
+     * @param answer Текст ответа
+     * @return Номер строки
+     */
+    int add(const Row &row, QStringView question, QStringView answer);
+
+    /**
+     * @brief Добавить карточку с текстом в UTF-8
+     *
+     * Текст декодируется прямо в буфер, без промежуточного QString.
+     *
+     * @return Номер строки
+     */
+    int addUtf8(const Row &row, QByteArrayView question, QByteArrayView answer);
+
+    /**
+     * @brief Добавить копию готовой карточки
+     * @return Номер строки
+     */
+    int add(const Card &card);
+
+    /**
+     * @brief Количество добавленных карточек
+     */
+    int size() const;
+
+    /**
+     * @brief Буфер текста собираемой колоды
+     */
+    const TextArena &arena() const;
+
+    /**
+     * @brief Передать собранные карточки колоде
+     *
+     * Карточки колоды заменяются, индексы строятся один раз.
+     * После вызова построитель пуст и готов к новой сборке.
+     *
+     * @param deck Колода
+     */
+    void build(Deck &deck);
+
+private:
+    CardStore store;                    ///< Собираемые столбцы
+    QSharedPointer<TextArena> text;     ///< Буфер текста собираемой колоды
+    qsizetype blockChars;               ///< Размер блока буфера
+
+    /**
+     * @brief Разложить строку по столбцам
+     */
+    int append(const Row &row, const QString &question, const QString &answer);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <QMutex>
+#include <QSharedPointer>
+#include <atomic>
+#include "Deck.h"
+
+/**
+ * @brief Потокобезопасная передача готовой колоды из рабочего потока
+ *
+ * Рабочий поток собирает колоду целиком и публикует её через publish();
+ * поток интерфейса забирает неизменяемую колоду через current().
+ * Передается только указатель, поэтому current() стоит O(1) при любом
+ * размере колоды, а интерфейс никогда не видит колоду в процессе сборки.
+ *
+ * Прежняя колода освобождается тем, кто отпустит последнюю ссылку:
+ * если интерфейс её уже не держит - рабочим потоком при публикации.
+ *
+ * @see TaskRunner, DeckTasks
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class DeckHandoff
+{
+public:
+    DeckHandoff() = default;
+
+    DeckHandoff(const DeckHandoff &) = delete;
+    DeckHandoff &operator=(const DeckHandoff &) = delete;
+
+    /**
+     * @brief Опубликовать колоду (из любого потока)
+     * @param deck Собранная колода; после публикации не изменяется
+     */
+    void publish(Deck deck);
+
+    /**
+     * @brief Опубликовать уже разделяемую колоду (из любого потока)
+     */
+    void publish(QSharedPointer<const Deck> deck);
+
+    /**
+     * @brief Последняя опубликованная колода (из любого потока)
+     * @return Колода или пустой указатель, если публикаций не было
+     */
+    QSharedPointer<const Deck> current() const;
+
+    /**
+     * @brief Номер публикации; растет на единицу с каждым publish()
+     */
+    quint64 version() const;
+
+private:
+    mutable QMutex mutex;                   ///< Защищает deck
+    QSharedPointer<const Deck> deck;        ///< Опубликованная колода
+    std::atomic<quint64> published{0};      ///< Количество публикаций
+};
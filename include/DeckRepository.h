@@ -0,0 +1,116 @@
+#pragma once
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include "CardRepository.h"
+#include "Deck.h"
+
+/**
+ * @brief Хранилище колод в базе данных SQLite
+ *
+ * Сохраняет колоду целиком (название и все карточки в исходном порядке)
+ * одной транзакцией и загружает её обратно. Карточки записываются
+ * через CardRepository.
+ *
+ * Ошибки не бросают исключений: методы возвращают false, а текст ошибки
+ * доступен через lastError().
+ *
+ * @see Database, CardRepository
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class DeckRepository
+{
+public:
+    /**
+     * @brief Создать хранилище поверх открытого соединения
+     * @param database Соединение, подготовленное Database::open()
+     */
+    explicit DeckRepository(const QSqlDatabase &database);
+
+    /**
+     * @brief Сохранить колоду целиком
+     *
+     * Записывает название колоды и заменяет все её сохраненные карточки
+     * текущими, в порядке колоды. Для колоды из loadDeckMetadata()
+     * сохраненный текст карточек сохраняется: записываются только
+     * порядок и поля планирования.
+     *
+     * @param deck Колода
+     * @return true при успехе; при ошибке база остается в прежнем состоянии
+     */
+    bool saveDeck(const Deck &deck);
+
+    /**
+     * @brief Сохранить только поля планирования карточек колоды
+     *
+     * Быстрый путь после сессии повторения: текст карточек не перезаписывается.
+     *
+     * @param deck Колода, ранее сохраненная saveDeck()
+     * @return true при успехе
+     */
+    bool saveScheduling(const Deck &deck);
+
+    /**
+     * @brief Загрузить колоду
+     * @param deckId Идентификатор колоды
+     * @param deck Колода, в которую записываются название и карточки
+     * @return true, если колода найдена и загружена
+     */
+    bool loadDeck(int deckId, Deck &deck);
+
+    /**
+     * @brief Загрузить колоду без текста карточек
+     *
+     * Колода переводится в режим Deck::setMetadataOnly() и получает только
+     * поля планирования. Текст и медиаданные загружаются по требованию:
+     * передайте колоде CardContentCache поверх cards().
+     *
+     * @param deckId Идентификатор колоды
+     * @param deck Колода, в которую записываются название и карточки
+     * @return true, если колода найдена и загружена
+     * @note Время загрузки и память колоды уменьшаются пропорционально объему текста
+     */
+    bool loadDeckMetadata(int deckId, Deck &deck);
+
+    /**
+     * @brief Удалить колоду вместе с карточками и их медиаданными
+     * @param deckId Идентификатор колоды
+     * @return true, если колода существовала и удалена
+     */
+    bool removeDeck(int deckId);
+
+    /**
+     * @brief Идентификаторы всех сохраненных колод по возрастанию
+     */
+    QList<int> deckIds();
+
+    /**
+     * @brief Хранилище карточек на том же соединении
+     *
+     * Для запросов к отдельным карточкам, например выборки готовых
+     * карточек без загрузки колоды.
+     */
+    CardRepository &cards();
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+private:
+    QSqlDatabase database;          ///< Соединение с базой данных
+    CardRepository cardRepository;  ///< Запись и чтение карточек
+    QString errorText;              ///< Текст последней ошибки
+
+    /**
+     * @brief Общая часть loadDeck() и loadDeckMetadata()
+     */
+    bool load(int deckId, Deck &deck, bool metadataOnly);
+
+    /**
+     * @brief Запомнить ошибку запроса и вернуть false
+     */
+    bool fail(const QString &message);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <QString>
+#include "CsvImporter.h"
+#include "ReviewForecast.h"
+#include "TaskRunner.h"
+
+class DeckHandoff;
+
+/**
+ * @brief Готовые фоновые задачи над колодами для TaskRunner
+ *
+ * Каждая функция возвращает задачу, которая собирает результат
+ * в рабочем потоке целиком и только затем передает его интерфейсу:
+ * колоду - через DeckHandoff, статистику - в переданный объект.
+ * Объекты, переданные по ссылке, должны пережить задачу.
+ *
+ * @see TaskRunner, DeckHandoff
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+namespace DeckTasks {
+
+/**
+ * @brief Загрузить колоду из снимка коллекции и опубликовать её
+ * @param path Путь к снимку (CollectionSnapshot)
+ * @param deckId Идентификатор колоды
+ * @param target Получатель колоды
+ */
+TaskRunner::Task loadSnapshot(const QString &path, int deckId, DeckHandoff &target);
+
+/**
+ * @brief Импортировать CSV в новую колоду и опубликовать её
+ *
+ * Прогресс - прочитанные байты файла. Отмена прерывает импорт
+ * на ближайшем пакете, и колода не публикуется.
+ *
+ * @param path Путь к файлу CSV
+ * @param deckId Идентификатор новой колоды
+ * @param target Получатель колоды
+ * @param options Параметры разбора; deckId заменяется на deckId колоды
+ */
+TaskRunner::Task importCsv(const QString &path, int deckId, DeckHandoff &target,
+                           const CsvImporter::Options &options = CsvImporter::Options());
+
+/**
+ * @brief Построить прогноз нагрузки по опубликованной колоде
+ *
+ * Читать result можно после сигнала TaskRunner::finished() задачи.
+ *
+ * @param source Источник колоды
+ * @param days Количество дневных корзин
+ * @param result Заполняется при успехе
+ */
+TaskRunner::Task forecast(const DeckHandoff &source, int days, ReviewForecast &result);
+
+} // namespace DeckTasks
@@ -0,0 +1,262 @@
+#pragma once
+#include <QHash>
+#include <QList>
+#include <QMultiMap>
+#include <QTimer>
+#include <functional>
+#include "Clock.h"
+
+class Deck;
+
+/**
+ * @brief Кэш количества готовых к повторению карточек по колодам
+ *
+ * Главное окно показывает счетчики всех колод и перерисовывает их
+ * часто. Кэш хранит готовое количество для каждой колоды и шкалу
+ * "станет готовой в момент t" для карточек, срок которых наступит
+ * в ближайшие сутки (горизонт). Поэтому:
+ * - чтение счетчика колоды - O(1) при попадании в кэш;
+ * - продвижение времени стоит O(m log m), где m - карточки, чей срок
+ *   наступил за прошедший промежуток, а не O(k log n) по всем колодам;
+ * - перепланирование карточки (Deck::reviewCard(), applyGrades(),
+ *   updateCard()) обновляет счетчик колоды и шкалу на месте;
+ * - массовые изменения колоды (setCards(), addCards()) сбрасывают
+ *   только её запись; она пересчитывается при следующем чтении (промах).
+ *
+ * Колода сама сообщает кэшу об изменениях, пока подключена (addDeck()).
+ * Шкала перестраивается, когда время выходит за горизонт или идет
+ * назад.
+ *
+ * С включенным setAutoAdvance() кэш заводит QTimer на момент ближайшего
+ * события шкалы и вызывает обработчик изменения счетчиков; для этого
+ * в потоке кэша должен работать цикл событий.
+ *
+ * @note Не потокобезопасен: колоды и кэш используются из одного потока
+ * @see Deck::getDueCount(), DueIndex
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class DueCountCache
+{
+public:
+    /// Горизонт шкалы событий: сутки
+    static constexpr qint64 kHorizonMSecs = 24LL * 60 * 60 * 1000;
+
+    /**
+     * @brief Счетчики кэша
+     */
+    struct Stats {
+        qint64 hits = 0;            ///< Чтения из готовой записи
+        qint64 misses = 0;          ///< Чтения, потребовавшие пересчета по индексу колоды
+        qint64 updates = 0;         ///< Изменения, примененные на месте
+        qint64 crossings = 0;       ///< Карточки, ставшие готовыми при продвижении времени
+        qint64 rebuilds = 0;        ///< Перестроения шкалы целиком
+
+        /**
+         * @brief Доля попаданий среди всех чтений (0 при отсутствии чтений)
+         */
+        double hitRate() const
+        {
+            const qint64 total = hits + misses;
+            return total > 0 ? double(hits) / double(total) : 0.0;
+        }
+    };
+
+    /// Обработчик изменения счетчиков при продвижении времени по таймеру
+    using ChangedCallback = std::function<void()>;
+
+    /**
+     * @brief Создать кэш
+     * @param clock Часы; nullptr - системные часы
+     * @warning Кэш не владеет часами: они должны пережить кэш
+     */
+    explicit DueCountCache(const Clock *clock = nullptr);
+
+    /**
+     * @brief Деструктор: отключает кэш от колод
+     */
+    ~DueCountCache();
+
+    DueCountCache(const DueCountCache &) = delete;
+    DueCountCache &operator=(const DueCountCache &) = delete;
+
+    // =============== КОЛОДЫ ===============
+
+    /**
+     * @brief Подключить колоду
+     * @param deck Колода; её счетчик будет вычислен при первом чтении
+     * @warning Колоду нужно отключить (removeDeck()) до её уничтожения.
+     *          Копии колоды наследуют ссылку на кэш: их уведомления
+     *          игнорируются, но кэш должен пережить и копии
+     */
+    void addDeck(Deck *deck);
+
+    /**
+     * @brief Отключить колоду
+     */
+    void removeDeck(Deck *deck);
+
+    /**
+     * @brief Количество подключенных колод
+     */
+    int deckCount() const;
+
+    // =============== ЧТЕНИЕ ===============
+
+    /**
+     * @brief Количество готовых к повторению карточек колоды
+     *
+     * Сначала продвигает время до текущего момента часов.
+     *
+     * @param deck Колода; для неподключенной возвращается deck->getDueCount()
+     * @return То же, что Deck::getDueCount() в момент часов кэша
+     */
+    int dueCount(const Deck *deck);
+
+    /**
+     * @brief Счетчики всех колод в порядке подключения
+     * @note Сложность O(k) при попаданиях
+     */
+    QList<int> dueCounts();
+
+    /**
+     * @brief Сумма счетчиков всех колод
+     */
+    int totalDueCount();
+
+    /**
+     * @brief Момент, на который посчитаны счетчики (мс от эпохи)
+     */
+    qint64 now() const;
+
+    /**
+     * @brief Ближайший момент, когда какая-то карточка станет готовой
+     * @return Момент в мс от эпохи или конец горизонта, если событий нет
+     */
+    qint64 nextChangeAt() const;
+
+    /**
+     * @brief Счетчики попаданий и промахов
+     */
+    Stats stats() const;
+
+    /**
+     * @brief Обнулить счетчики
+     */
+    void resetStats();
+
+    // =============== ВРЕМЯ ===============
+
+    /**
+     * @brief Продвинуть счетчики к моменту nowMSecs
+     * @return true, если изменился хотя бы один счетчик
+     */
+    bool advanceTo(qint64 nowMSecs);
+
+    /**
+     * @brief Продвигать время по таймеру
+     *
+     * Таймер срабатывает в момент ближайшего события шкалы (но не чаще
+     * minIntervalMSecs) и вызывает обработчик, если счетчики изменились.
+     *
+     * @param enabled Включить или выключить таймер
+     * @param minIntervalMSecs Наименьший интервал между срабатываниями
+     */
+    void setAutoAdvance(bool enabled, int minIntervalMSecs = 1000);
+
+    /**
+     * @brief Установить обработчик изменения счетчиков
+     */
+    void setChangedCallback(ChangedCallback callback);
+
+    // =============== УВЕДОМЛЕНИЯ КОЛОДЫ ===============
+
+    /**
+     * @brief Карточка добавлена в колоду
+     * @param dueAt Срок карточки (ключ DueIndex)
+     */
+    void cardAdded(const Deck *deck, qint64 dueAt);
+
+    /**
+     * @brief Карточка удалена из колоды
+     * @param dueAt Срок карточки (ключ DueIndex)
+     */
+    void cardRemoved(const Deck *deck, qint64 dueAt);
+
+    /**
+     * @brief Карточка перепланирована
+     * @param oldDueAt Прежний срок
+     * @param newDueAt Новый срок
+     */
+    void cardRescheduled(const Deck *deck, qint64 oldDueAt, qint64 newDueAt);
+
+    /**
+     * @brief Сбросить запись колоды после массового изменения
+     */
+    void invalidate(const Deck *deck);
+
+private:
+    /**
+     * @brief Запись колоды
+     */
+    struct Entry {
+        Deck *deck = nullptr;
+        int count = 0;          ///< Готовых карточек на момент now
+        bool valid = false;     ///< Счетчик и события шкалы актуальны
+    };
+
+    const Clock *clock;                 ///< Источник времени (не владеет)
+    QList<Entry> entries;               ///< Записи в порядке подключения
+    QHash<const Deck *, int> slotByDeck;    ///< Номер записи по колоде
+    QMultiMap<qint64, int> timeline;    ///< Срок -> номер записи, для сроков в (now, horizon]
+    qint64 current = 0;                 ///< Момент счетчиков
+    qint64 horizon = 0;                 ///< Конец шкалы
+    bool started = false;               ///< Момент уже установлен
+    Stats counters;                     ///< Счетчики кэша
+    QTimer timer;                       ///< Таймер продвижения времени
+    bool autoAdvance = false;           ///< Таймер включен
+    int minTimerInterval = 1000;        ///< Наименьший интервал таймера
+    qint64 timerDeadline = 0;           ///< Момент, на который заведен таймер
+    ChangedCallback changedCallback;    ///< Обработчик изменения счетчиков
+
+    /**
+     * @brief Счетчик записи; при промахе пересчитывает её
+     */
+    int lookup(int slot);
+
+    /**
+     * @brief Пересчитать запись по индексу повторений колоды
+     */
+    void recompute(int slot);
+
+    /**
+     * @brief Учесть появление срока dueAt в записи
+     */
+    void addDue(int slot, qint64 dueAt);
+
+    /**
+     * @brief Учесть исчезновение срока dueAt из записи
+     */
+    void removeDue(int slot, qint64 dueAt);
+
+    /**
+     * @brief Убрать события записи со шкалы
+     */
+    void dropEvents(int slot);
+
+    /**
+     * @brief Сбросить все записи и начать шкалу с момента nowMSecs
+     */
+    void restart(qint64 nowMSecs);
+
+    /**
+     * @brief Перезапустить таймер на ближайшее событие
+     */
+    void scheduleTimer();
+
+    /**
+     * @brief Обработать срабатывание таймера
+     */
+    void onTimeout();
+};
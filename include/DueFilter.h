@@ -0,0 +1,83 @@
+#pragma once
+#include <QtGlobal>
+
+/**
+ * @brief Векторизованный фильтр дат повторения
+ *
+ * Сравнивает целые блоки упакованных дат (qint64, мс от эпохи) с текущим
+ * моментом и возвращает результат в виде битовой маски, сжатого списка
+ * позиций или количества. Заменяет поэлементную проверку
+ * `!nextReview.isValid() || nextReview <= now`: отсутствующая дата хранится
+ * как CardStore::kNoDate (минимальное qint64), поэтому условие сводится
+ * к одному сравнению `t <= now` без ветвлений.
+ *
+ * Реализация выбирается во время выполнения: AVX2, SSE2 или скалярная.
+ * Все реализации дают побитово одинаковый результат.
+ *
+ * @see CardStore::nextReviewColumn()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+namespace DueFilter {
+
+/**
+ * @brief Реализация ядра фильтра
+ */
+enum class Kernel {
+    Scalar,     ///< Переносимая скалярная реализация без ветвлений
+    Sse2,       ///< 2 даты за сравнение (x86, эмуляция 64-битного сравнения)
+    Avx2        ///< 4 даты за сравнение (x86, проверяется во время выполнения)
+};
+
+/**
+ * @brief Лучшая реализация, поддерживаемая процессором
+ * @note Определяется один раз при первом вызове
+ */
+Kernel bestKernel();
+
+/**
+ * @brief Проверить, доступна ли реализация на этом процессоре
+ * @param kernel Реализация
+ */
+bool isSupported(Kernel kernel);
+
+/**
+ * @brief Подсчитать даты, наступившие к моменту now
+ * @param dates Упакованные даты
+ * @param count Количество дат
+ * @param now Текущий момент (мс от эпохи)
+ * @param kernel Реализация; недоступная заменяется скалярной
+ * @return Количество элементов с dates[i] <= now
+ */
+qsizetype countDue(const qint64 *dates, qsizetype count, qint64 now,
+                   Kernel kernel = bestKernel());
+
+/**
+ * @brief Записать позиции наступивших дат в порядке возрастания
+ * @param dates Упакованные даты
+ * @param count Количество дат
+ * @param now Текущий момент (мс от эпохи)
+ * @param rows Выходной массив; должен вмещать count элементов
+ * @param kernel Реализация; недоступная заменяется скалярной
+ * @return Количество записанных позиций
+ */
+qsizetype compactDue(const qint64 *dates, qsizetype count, qint64 now, int *rows,
+                     Kernel kernel = bestKernel());
+
+/**
+ * @brief Построить битовую маску наступивших дат
+ *
+ * Бит i слова i / 64 установлен, если dates[i] <= now. Неиспользуемые
+ * старшие биты последнего слова обнуляются.
+ *
+ * @param dates Упакованные даты
+ * @param count Количество дат
+ * @param now Текущий момент (мс от эпохи)
+ * @param bits Выходной массив из (count + 63) / 64 слов
+ * @param kernel Реализация; недоступная заменяется скалярной
+ */
+void dueBitmap(const qint64 *dates, qsizetype count, qint64 now, quint64 *bits,
+               Kernel kernel = bestKernel());
+
+} // namespace DueFilter
@@ -0,0 +1,131 @@
+#pragma once
+#include <QList>
+#include <limits>
+
+/**
+ * @brief Упорядоченный по времени индекс карточек колоды
+ *
+ * Хранит пары (момент следующего повторения, позиция карточки в колоде),
+ * отсортированные по времени. Благодаря этому количество карточек, готовых
+ * к повторению, находится бинарным поиском за O(log n), а сами карточки -
+ * за O(log n + k), без обхода всей колоды.
+ *
+ * Карточки с невалидной датой следующего повторения получают ключ
+ * kAlwaysDue и всегда оказываются в начале индекса.
+ *
+ * @note Индекс хранится в непрерывном отсортированном массиве: чтение
+ *       максимально дружелюбно к кэшу, а вставка и удаление стоят O(log n)
+ *       на поиск плюс сдвиг хвоста массива.
+ * @see Deck
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class DueIndex
+{
+public:
+    /**
+     * @brief Элемент индекса
+     */
+    struct Entry {
+        qint64 dueAt;   ///< Момент следующего повторения (мс от эпохи) или kAlwaysDue
+        int row;        ///< Позиция карточки в колоде
+    };
+
+    using const_iterator = QList<Entry>::const_iterator;
+
+    /// Ключ для карточек без даты следующего повторения (всегда готовы)
+    static constexpr qint64 kAlwaysDue = std::numeric_limits<qint64>::min();
+
+    /**
+     * @brief Очистить индекс
+     */
+    void clear();
+
+    /**
+     * @brief Перестроить индекс целиком
+     *
+     * @param keys Ключи карточек; позиция в списке равна позиции карточки в колоде
+     * @note Сложность O(n log n)
+     */
+    void rebuild(const QList<qint64> &keys);
+
+    /**
+     * @brief Заменить индекс готовыми, уже упорядоченными элементами
+     *
+     * @param sorted Элементы, отсортированные по (dueAt, row)
+     * @param count Количество элементов
+     * @note Сложность O(n) - одно копирование без сортировки
+     * @warning Порядок элементов не проверяется
+     */
+    void assign(const Entry *sorted, int count);
+
+    /**
+     * @brief Добавить карточку в индекс
+     * @param dueAt Ключ карточки
+     * @param row Позиция карточки в колоде
+     */
+    void insert(qint64 dueAt, int row);
+
+    /**
+     * @brief Добавить в индекс подряд идущие новые карточки
+     *
+     * @param firstRow Позиция первой карточки
+     * @param keys Ключи карточек firstRow, firstRow + 1, ...
+     * @note Сложность O(k log k + n): новые элементы сортируются отдельно
+     *       и сливаются с индексом, вместо k вставок со сдвигом хвоста
+     */
+    void insertRows(int firstRow, const QList<qint64> &keys);
+
+    /**
+     * @brief Удалить карточку из индекса
+     *
+     * Позиции всех карточек, стоявших после удаляемой, уменьшаются на единицу,
+     * как и в списке карточек колоды.
+     *
+     * @param dueAt Ключ карточки
+     * @param row Позиция карточки в колоде
+     */
+    void remove(qint64 dueAt, int row);
+
+    /**
+     * @brief Перенести карточку на новый момент повторения
+     * @param oldDueAt Прежний ключ карточки
+     * @param newDueAt Новый ключ карточки
+     * @param row Позиция карточки в колоде
+     */
+    void update(qint64 oldDueAt, qint64 newDueAt, int row);
+
+    /**
+     * @brief Количество карточек, готовых к повторению на момент now
+     * @param now Текущий момент (мс от эпохи)
+     * @return Количество элементов с dueAt <= now
+     * @note Сложность O(log n)
+     */
+    int countDue(qint64 now) const;
+
+    /**
+     * @brief Начало индекса (самая просроченная карточка)
+     */
+    const_iterator begin() const;
+
+    /**
+     * @brief Граница готовых к повторению карточек
+     * @param now Текущий момент (мс от эпохи)
+     * @return Итератор на первый элемент с dueAt > now
+     */
+    const_iterator dueEnd(qint64 now) const;
+
+    /**
+     * @brief Конец индекса
+     */
+    const_iterator end() const;
+
+    /**
+     * @brief Количество карточек в индексе
+     */
+    int size() const;
+
+private:
+    QList<Entry> entries;       ///< Элементы, отсортированные по (dueAt, row)
+};
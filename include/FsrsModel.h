@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Формулы модели памяти FSRS-4.5
+ *
+ * Шаблоны над типом числа: FsrsScheduler вызывает их с double,
+ * ParameterOptimizer - с дуальными числами, которые вместе со значением
+ * несут производные по всем весам. Так планировщик и оптимизатор
+ * считают одну и ту же модель.
+ *
+ * Для типа T нужны арифметика с double, exp(), log(), pow() (находятся
+ * по ADL либо из std) и функции clampTo(x, lo, hi), minOf(a, b).
+ * Веса - индексируемый контейнер из 17 элементов, приводимых к T.
+ *
+ * @see FsrsScheduler, ParameterOptimizer
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+namespace FsrsModel {
+
+/// Показатель степени кривой забывания
+constexpr double kDecay = -0.5;
+
+/// Множитель кривой забывания: R = 0.9 при t = S
+constexpr double kFactor = 19.0 / 81.0;
+
+constexpr double kMinDifficulty = 1.0;
+constexpr double kMaxDifficulty = 10.0;
+constexpr double kMinStability = 0.01;
+
+inline double clampTo(double value, double low, double high)
+{
+    return std::clamp(value, low, high);
+}
+
+inline double minOf(double a, double b)
+{
+    return std::min(a, b);
+}
+
+/**
+ * @brief Вероятность вспомнить через elapsedDays дней при стабильности s
+ */
+template <typename T>
+T retrievability(const T &stability, double elapsedDays)
+{
+    using std::pow;
+    return pow(1.0 + kFactor * std::max(0.0, elapsedDays) / stability, kDecay);
+}
+
+/**
+ * @brief Стабильность после первого ответа с рейтингом rating (1-4)
+ */
+template <typename T, typename Weights>
+T initialStability(const Weights &w, int rating)
+{
+    return clampTo(T(w[rating - 1]), kMinStability, std::numeric_limits<double>::max());
+}
+
+/**
+ * @brief Трудность после первого ответа: w4 - (G - 3) w5
+ */
+template <typename T, typename Weights>
+T initialDifficulty(const Weights &w, int rating)
+{
+    return clampTo(T(w[4]) - T(w[5]) * double(rating - 3), kMinDifficulty, kMaxDifficulty);
+}
+
+/**
+ * @brief Трудность после ответа: сдвиг на w6 за ступень рейтинга
+ *        и возврат к начальной трудности Good с весом w7
+ */
+template <typename T, typename Weights>
+T nextDifficulty(const Weights &w, const T &difficulty, int rating)
+{
+    const T shifted = difficulty - T(w[6]) * double(rating - 3);
+    const T w7 = T(w[7]);
+    return clampTo(w7 * initialDifficulty<T>(w, 3) + (1.0 - w7) * shifted, kMinDifficulty, kMaxDifficulty);
+}
+
+/**
+ * @brief Стабильность после ответа
+ * @param r Вероятность вспомнить в момент ответа
+ *
+ * Успех умножает S на 1 + e^w8 (11 - D) S^-w9 (e^(w10 (1 - R)) - 1),
+ * с поправками w15 для Hard и w16 для Easy. Ошибка дает
+ * w11 D^-w12 ((S + 1)^w13 - 1) e^(w14 (1 - R)), но не больше прежней S.
+ */
+template <typename T, typename Weights>
+T nextStability(const Weights &w, const T &stability, const T &difficulty, const T &r, int rating)
+{
+    using std::exp;
+    using std::log;
+    T next;
+    if (rating == 1) {
+        next = T(w[11]) * exp(-T(w[12]) * log(difficulty))
+             * (exp(T(w[13]) * log(stability + 1.0)) - 1.0) * exp(T(w[14]) * (1.0 - r));
+        next = minOf(next, stability);
+    } else {
+        T growth = exp(T(w[8])) * (11.0 - difficulty) * exp(-T(w[9]) * log(stability))
+                 * (exp(T(w[10]) * (1.0 - r)) - 1.0);
+        if (rating == 2) {
+            growth = growth * T(w[15]);
+        } else if (rating == 4) {
+            growth = growth * T(w[16]);
+        }
+        next = stability * (growth + 1.0);
+    }
+    return clampTo(next, kMinStability, std::numeric_limits<double>::max());
+}
+
+} // namespace FsrsModel
@@ -0,0 +1,109 @@
+#pragma once
+#include <QList>
+#include <array>
+#include "Scheduler.h"
+#include "ReviewRecord.h"
+
+/**
+ * @brief Планировщик по модели памяти FSRS (Free Spaced Repetition Scheduler)
+ *
+ * Для каждой карточки ведется стабильность S (через сколько дней
+ * вероятность вспомнить упадет до 90%) и трудность D (1-10). Вероятность
+ * вспомнить через t дней - кривая забывания R = (1 + F t / S)^-0.5,
+ * а интервал выбирается так, чтобы к повторению R опустилась ровно
+ * до желаемого уровня. Поэтому при той же доле вспомненных карточек
+ * FSRS назначает меньше повторений, чем SM-2: легкие карточки быстро
+ * уходят на длинные интервалы, трудные повторяются чаще.
+ *
+ * Формулы (FsrsModel) и 17 весов по умолчанию соответствуют FSRS-4.5. Оценки 0-5
+ * переводятся в рейтинги FSRS: 0-2 - Again, 3 - Hard, 4 - Good, 5 - Easy.
+ *
+ * Колода хранит только поля SM-2, поэтому состояние FSRS кодируется
+ * в них: трудность - в факторе легкости (D = 1 соответствует 2.5,
+ * D = 10 - 1.3), а стабильность восстанавливается из интервала.
+ * Карточка с ненулевым интервалом считается изученной, поэтому колоду,
+ * которая планировалась по SM-2, можно перевести на FSRS без миграции.
+ *
+ * evaluate() оценивает сразу несколько наборов параметров на истории
+ * ответов: история один раз упаковывается по карточкам, после чего
+ * наборы и участки истории считаются параллельно.
+ *
+ * @see https://github.com/open-spaced-repetition/fsrs4anki/wiki/The-Algorithm
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class FsrsScheduler : public Scheduler
+{
+public:
+    /// Количество весов модели
+    static constexpr int kWeightCount = 17;
+
+    using Weights = std::array<float, kWeightCount>;
+
+    /**
+     * @brief Параметры планировщика
+     */
+    struct Parameters {
+        Weights weights = defaultWeights();     ///< Веса модели
+        double desiredRetention = 0.9;          ///< Желаемая вероятность вспомнить к повторению
+        int maximumInterval = 36500;            ///< Наибольший интервал в днях
+    };
+
+    /**
+     * @brief Качество предсказаний на истории ответов
+     */
+    struct Evaluation {
+        double logLoss = 0.0;           ///< Средняя логарифмическая потеря
+        double predictedRecall = 0.0;   ///< Средняя предсказанная вероятность вспомнить
+        double actualRecall = 0.0;      ///< Доля ответов с оценкой 3 и выше
+        qint64 predictions = 0;         ///< Оцененных ответов (все, кроме первого для карточки)
+    };
+
+    FsrsScheduler();
+    explicit FsrsScheduler(const Parameters &parameters);
+
+    /**
+     * @brief Веса FSRS-4.5 по умолчанию
+     */
+    static Weights defaultWeights();
+
+    /**
+     * @brief Текущие параметры
+     */
+    const Parameters &parameters() const;
+
+    QString name() const override;
+    void review(SchedulingState &state, int grade, double elapsedDays) const override;
+    double retrievability(const SchedulingState &state, double elapsedDays) const override;
+
+    /**
+     * @brief Интервал для стабильности при желаемой вероятности
+     * @return Дни в диапазоне [1, maximumInterval]
+     */
+    int nextInterval(float stability) const;
+
+    /**
+     * @brief Рейтинг FSRS (1-4) по оценке 0-5
+     */
+    static int rating(int grade);
+
+    /**
+     * @brief Оценить наборы параметров на истории ответов
+     *
+     * Ответы каждой карточки воспроизводятся по времени; перед каждым
+     * ответом, кроме первого, модель предсказывает вероятность вспомнить,
+     * а исходом считается оценка 3 и выше.
+     *
+     * @param history Записи в любом порядке; используются cardId, grade и reviewedAt
+     * @param candidates Наборы параметров
+     * @param threadCount Потоков; 0 - по числу ядер, 1 - в потоке вызова
+     * @return Оценки в порядке candidates; результат не зависит от threadCount
+     */
+    static QList<Evaluation> evaluate(const QList<ReviewRecord> &history,
+                                      const QList<Parameters> &candidates, int threadCount = 0);
+
+private:
+    Parameters params;
+    double intervalFactor;      ///< Интервал на единицу стабильности при desiredRetention
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <QList>
+#include <QString>
+#include "FsrsScheduler.h"
+#include "ReviewRecord.h"
+
+/**
+ * @brief Подбор весов FSRS по истории ответов пользователя
+ *
+ * Офлайн-оптимизатор: история ответов подается порциями (addReview(),
+ * addReviews()) и хранится упакованной - 13 байт на ответ вместо
+ * ReviewRecord. fit() воспроизводит историю каждой карточки, считает
+ * логарифмическую потерю предсказанной вероятности вспомнить (исход -
+ * оценка 3 и выше) и минимизирует её градиентным спуском (Adam)
+ * по мини-пакетам.
+ *
+ * Градиент считается прямым автоматическим дифференцированием: модель
+ * FsrsModel вычисляется на дуальных числах, где вместе со значением
+ * идут производные по всем 17 весам, и каждая операция обновляет все
+ * производные одним плотным циклом, который компилятор векторизует.
+ *
+ * Карточки делятся на участки (около 16 тысяч ответов); участки
+ * мини-пакета считаются параллельно (QThreadPool) и сводятся в фиксированном
+ * порядке, поэтому результат не зависит от числа потоков.
+ *
+ * SM-2 не предсказывает вероятность вспомнить, поэтому подбираются
+ * веса FSRS: результат передается в FsrsScheduler::Parameters.
+ *
+ * @see FsrsModel, FsrsScheduler::evaluate()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class ParameterOptimizer
+{
+public:
+    /**
+     * @brief Параметры обучения
+     */
+    struct Options {
+        int epochs = 5;                 ///< Проходов по истории
+        int batchReviews = 1 << 18;     ///< Ответов в мини-пакете (не меньше одного участка)
+        double learningRate = 0.04;     ///< Шаг Adam
+        int threadCount = 0;            ///< Потоков; 0 - по числу ядер, 1 - в потоке вызова
+        quint32 seed = 1;               ///< Зерно перемешивания участков
+        /// Начальные веса
+        FsrsScheduler::Weights initialWeights = FsrsScheduler::defaultWeights();
+    };
+
+    /**
+     * @brief Итог обучения
+     */
+    struct Result {
+        FsrsScheduler::Weights weights = FsrsScheduler::defaultWeights();  ///< Подобранные веса
+        double initialLogLoss = 0.0;    ///< Потеря с начальными весами
+        double finalLogLoss = 0.0;      ///< Потеря с подобранными весами
+        QList<double> epochLogLoss;     ///< Средняя потеря мини-пакетов каждой эпохи
+        qint64 reviews = 0;             ///< Ответов в истории
+        qint64 predictions = 0;         ///< Оцененных ответов (все, кроме первого для карточки)
+        int cards = 0;                  ///< Карточек в истории
+        int steps = 0;                  ///< Шагов градиентного спуска
+        qint64 elapsedMSecs = 0;        ///< Длительность обучения
+    };
+
+    ParameterOptimizer();
+    explicit ParameterOptimizer(const Options &options);
+
+    // =============== ИСТОРИЯ ===============
+
+    /**
+     * @brief Добавить ответ
+     * @param cardId Идентификатор карточки
+     * @param grade Оценка ответа (0-5)
+     * @param reviewedAt Момент ответа (мс от эпохи)
+     */
+    void addReview(int cardId, int grade, qint64 reviewedAt);
+
+    /**
+     * @brief Добавить порцию ответов; используются cardId, grade и reviewedAt
+     */
+    void addReviews(const QList<ReviewRecord> &records);
+
+    /**
+     * @brief Зарезервировать место под count ответов
+     */
+    void reserve(qsizetype count);
+
+    /**
+     * @brief Количество добавленных ответов
+     */
+    qsizetype reviewCount() const;
+
+    /**
+     * @brief Удалить историю
+     */
+    void clear();
+
+    // =============== ОБУЧЕНИЕ ===============
+
+    /**
+     * @brief Подобрать веса по накопленной истории
+     *
+     * Порядок добавления ответов не важен: ответы каждой карточки
+     * упорядочиваются по времени.
+     *
+     * @return false при пустой истории или недопустимых параметрах
+     */
+    bool fit();
+
+    /**
+     * @brief Итог последнего обучения
+     */
+    const Result &result() const;
+
+    /**
+     * @brief Параметры планировщика с подобранными весами
+     * @param desiredRetention Желаемая вероятность вспомнить
+     */
+    FsrsScheduler::Parameters fittedParameters(double desiredRetention = 0.9) const;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+private:
+    Options options;
+    QList<int> cardIds;             ///< Карточка каждого ответа
+    QList<qint64> reviewTimes;      ///< Момент каждого ответа
+    QList<qint8> grades;            ///< Оценка каждого ответа
+    Result summary;                 ///< Итог последнего обучения
+    QString errorText;              ///< Текст последней ошибки
+
+    /**
+     * @brief Запомнить ошибку и вернуть false
+     */
+    bool fail(const QString &message);
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <QDateTime>
+#include <QList>
+#include "DueIndex.h"
+
+class Deck;
+
+/**
+ * @brief Прогноз нагрузки: сколько повторений придется на каждый день
+ *
+ * Гистограмма по календарным дням начиная с сегодняшнего: корзина 0 -
+ * карточки, готовые к концу сегодняшнего дня (включая просроченные
+ * и новые), корзина i - карточки со сроком в i-й день, later() - срок
+ * за горизонтом прогноза. Границы дней - полночь местного времени.
+ *
+ * Прогноз колоды строится по её индексу повторений: корзина - это
+ * разность двух бинарных поисков, поэтому стоимость O(d log n) не зависит
+ * от доли карточек в горизонте и не требует прохода по карточкам.
+ * Прогноз коллекции складывается из прогнозов колод, которые
+ * считаются параллельно (QThreadPool) и сводятся слиянием.
+ *
+ * Готовый прогноз можно поддерживать без пересчета: cardRescheduled()
+ * переносит одну карточку между корзинами за O(log d). Колода делает
+ * это сама для прогноза, подключенного через Deck::setForecast().
+ *
+ * @see Deck::getForecast(), Deck::setForecast(), DueIndex
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class ReviewForecast
+{
+public:
+    /**
+     * @brief Пустой прогноз без корзин
+     */
+    ReviewForecast() = default;
+
+    /**
+     * @brief Пустой прогноз на days дней от момента now
+     * @param now Текущий момент; определяет сегодняшний день
+     * @param days Количество дневных корзин (не меньше 1)
+     */
+    ReviewForecast(const QDateTime &now, int days);
+
+    /**
+     * @brief Прогноз по нескольким колодам
+     *
+     * Колоды делятся между потоками пула; каждый поток накапливает
+     * собственный прогноз, затем прогнозы сливаются.
+     *
+     * @param decks Колоды; nullptr пропускаются
+     * @param now Текущий момент
+     * @param days Количество дневных корзин
+     * @param threadCount Потоков; 0 - по числу ядер, 1 - в потоке вызова
+     */
+    static ReviewForecast forDecks(const QList<const Deck *> &decks, const QDateTime &now,
+                                   int days, int threadCount = 0);
+
+    // =============== НАКОПЛЕНИЕ ===============
+
+    /**
+     * @brief Добавить карточки индекса повторений
+     * @note Сложность O(d log n)
+     */
+    void addIndex(const DueIndex &index);
+
+    /**
+     * @brief Добавить прогноз с теми же границами дней
+     * @return false, если границы не совпадают
+     */
+    bool merge(const ReviewForecast &other);
+
+    /**
+     * @brief Учесть новую карточку
+     * @param dueAt Срок карточки (ключ DueIndex)
+     */
+    void cardAdded(qint64 dueAt);
+
+    /**
+     * @brief Учесть удаление карточки
+     * @param dueAt Срок карточки (ключ DueIndex)
+     */
+    void cardRemoved(qint64 dueAt);
+
+    /**
+     * @brief Перенести карточку на новый срок, например после Card::updateSM2()
+     * @param oldDueAt Прежний срок
+     * @param newDueAt Новый срок
+     */
+    void cardRescheduled(qint64 oldDueAt, qint64 newDueAt);
+
+    // =============== РЕЗУЛЬТАТ ===============
+
+    /**
+     * @brief Количество дневных корзин
+     */
+    int days() const;
+
+    /**
+     * @brief Повторений в день day (0 - сегодня, включая просроченные)
+     */
+    int count(int day) const;
+
+    /**
+     * @brief Все дневные корзины
+     */
+    QList<int> counts() const;
+
+    /**
+     * @brief Повторений за горизонтом прогноза
+     */
+    int later() const;
+
+    /**
+     * @brief Всего карточек в прогнозе, включая later()
+     */
+    qint64 total() const;
+
+    /**
+     * @brief Начало дня day (полночь, мс от эпохи); day 0 - момент now
+     */
+    qint64 dayStart(int day) const;
+
+    /**
+     * @brief Номер корзины для срока
+     * @return 0..days() - 1 или days() для срока за горизонтом
+     */
+    int dayOf(qint64 dueAt) const;
+
+private:
+    qint64 start = 0;           ///< Момент построения
+    QList<qint64> dayEnds;      ///< Конец дня i (полночь следующего), мс от эпохи
+    QList<int> buckets;         ///< Корзины дней
+    int beyond = 0;             ///< Срок за горизонтом
+};
@@ -0,0 +1,207 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <functional>
+#include "ReviewRecord.h"
+
+class QThread;
+
+/**
+ * @brief Журнал повторений с отложенной записью и групповой фиксацией
+ *
+ * Ответы сессии повторения дописываются в конец файла журнала фоновым
+ * потоком. append() только кладет запись в очередь и сразу возвращает
+ * управление, поэтому поток интерфейса не ждет диска. Фоновый поток
+ * собирает накопившиеся записи в группу и фиксирует их одной записью
+ * и одной синхронизацией с диском (fsync), когда:
+ * - в очереди набралось maxBatchRecords записей;
+ * - самая старая запись ждет дольше flushIntervalMSecs;
+ * - вызван flush() или close().
+ *
+ * Записи фиксированного размера снабжены контрольной суммой. После сбоя
+ * recover() применяет целые записи к хранилищу (ReviewSink: база данных
+ * CardRepository или снимок CollectionSnapshot) и очищает журнал;
+ * оборванная последняя запись отбрасывается.
+ *
+ * Если группу не удалось записать, журнал отрезает её и перестает
+ * принимать записи: append() возвращает 0, flush() - false, а текст
+ * ошибки доступен в lastError(). Чтобы продолжить, журнал закрывают и
+ * открывают заново.
+ *
+ * @note Формат файла использует порядок байтов платформы
+ * @see ReviewRecord, ReviewSink::applyReviews()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class ReviewJournal
+{
+public:
+    /**
+     * @brief Параметры групповой фиксации
+     */
+    struct Options {
+        int flushIntervalMSecs = 20;    ///< Наибольшее ожидание записи в очереди
+        int maxBatchRecords = 512;      ///< Размер группы, фиксируемой без ожидания
+        bool syncToDisk = true;         ///< Вызывать fsync после каждой группы
+    };
+
+    /**
+     * @brief Счетчики работы журнала
+     */
+    struct Stats {
+        qint64 appended = 0;            ///< Записей принято append()
+        qint64 committed = 0;           ///< Записей зафиксировано на диске
+        qint64 groupCommits = 0;        ///< Выполнено групповых фиксаций
+    };
+
+    /**
+     * @brief Обработчик фиксации группы
+     *
+     * Вызывается из фонового потока после синхронизации с диском;
+     * аргумент - порядковый номер последней зафиксированной записи.
+     */
+    using CommitCallback = std::function<void(qint64 lastSequence)>;
+
+    explicit ReviewJournal(const QString &path);
+    ReviewJournal(const QString &path, const Options &options);
+
+    /**
+     * @brief Деструктор
+     *
+     * Фиксирует оставшиеся записи и останавливает фоновый поток.
+     */
+    ~ReviewJournal();
+
+    ReviewJournal(const ReviewJournal &) = delete;
+    ReviewJournal &operator=(const ReviewJournal &) = delete;
+
+    /**
+     * @brief Открыть журнал и запустить фоновый поток
+     *
+     * Существующий журнал дописывается; нумерация продолжается с последней
+     * целой записи, оборванный хвост отрезается.
+     *
+     * @return true при успехе; текст ошибки - в lastError()
+     */
+    bool open();
+
+    /**
+     * @brief Зафиксировать оставшиеся записи и закрыть журнал
+     */
+    void close();
+
+    /**
+     * @brief Проверить, открыт ли журнал
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Поставить запись в очередь на фиксацию
+     *
+     * Не ждет диска: стоимость - захват мьютекса и копирование записи.
+     *
+     * @param record Запись; поле sequence заполняется журналом
+     * @return Порядковый номер записи или 0, если журнал не открыт
+     *         или запись на диск уже завершилась ошибкой
+     */
+    qint64 append(const ReviewRecord &record);
+
+    /**
+     * @brief Дождаться фиксации всех принятых записей
+     * @return false, если запись на диск завершилась ошибкой
+     */
+    bool flush();
+
+    /**
+     * @brief Перенести зафиксированные записи в хранилище и очистить журнал
+     *
+     * Используется периодически во время работы, чтобы журнал не рос
+     * бесконечно. Сначала выполняет flush().
+     *
+     * @param cards Хранилище карточек
+     * @return true при успехе; при ошибке журнал не очищается
+     */
+    bool checkpoint(ReviewSink &cards);
+
+    /**
+     * @brief Номер последней зафиксированной записи
+     */
+    qint64 committedSequence() const;
+
+    /**
+     * @brief Установить обработчик фиксации группы
+     * @note Устанавливайте до open()
+     */
+    void setCommitCallback(CommitCallback callback);
+
+    /**
+     * @brief Текущие счетчики
+     */
+    Stats stats() const;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+    // =============== ВОССТАНОВЛЕНИЕ ===============
+
+    /**
+     * @brief Прочитать все целые записи журнала
+     * @param path Путь к файлу журнала
+     * @param errorMessage Текст ошибки (может быть nullptr)
+     * @return Записи в порядке фиксации; отсутствующий файл дает пустой список
+     * @note Чтение останавливается на первой оборванной или поврежденной записи
+     */
+    static QList<ReviewRecord> readRecords(const QString &path, QString *errorMessage = nullptr);
+
+    /**
+     * @brief Восстановить состояние после сбоя
+     *
+     * Применяет записи журнала к хранилищу одной операцией
+     * и очищает журнал. Вызывайте при запуске до открытия журнала.
+     *
+     * @param path Путь к файлу журнала
+     * @param cards Хранилище карточек
+     * @param errorMessage Текст ошибки (может быть nullptr)
+     * @return Количество примененных записей или -1 при ошибке
+     */
+    static int recover(const QString &path, ReviewSink &cards, QString *errorMessage = nullptr);
+
+private:
+    QString path;                       ///< Путь к файлу журнала
+    Options options;                    ///< Параметры групповой фиксации
+    CommitCallback commitCallback;      ///< Обработчик фиксации группы
+    QThread *writer = nullptr;          ///< Фоновый поток записи
+
+    QFile file;                         ///< Файл журнала (только фоновый поток и checkpoint)
+    QMutex fileMutex;                   ///< Защищает file
+
+    mutable QMutex mutex;               ///< Защищает поля ниже
+    QWaitCondition writerWake;          ///< Будит фоновый поток
+    QWaitCondition committedChanged;    ///< Сообщает о фиксации группы
+    QList<ReviewRecord> pending;        ///< Очередь на фиксацию
+    QElapsedTimer oldestPending;        ///< Возраст самой старой записи очереди
+    qint64 nextSequence = 0;            ///< Номер последней принятой записи
+    qint64 committed = 0;               ///< Номер последней зафиксированной записи
+    Stats counters;                     ///< Счетчики
+    bool flushRequested = false;        ///< Запрошена фиксация без ожидания
+    bool stopping = false;              ///< Поток должен завершиться
+    bool failed = false;                ///< Запись на диск завершилась ошибкой
+    QString errorText;                  ///< Текст последней ошибки
+
+    /**
+     * @brief Цикл фонового потока
+     */
+    void writerLoop();
+
+    /**
+     * @brief Записать группу в файл и синхронизировать его с диском
+     */
+    bool writeBatch(const QList<ReviewRecord> &batch);
+};
@@ -0,0 +1,190 @@
+#pragma once
+#include <QHash>
+#include <QList>
+#include "CardStore.h"
+
+class Deck;
+
+/**
+ * @brief Общая очередь повторения по нескольким колодам
+ *
+ * Сливает готовые к повторению карточки многих колод в один поток без
+ * сборки общего списка: для каждой колоды хранится только курсор в её
+ * индексе повторений (DueIndex), а очередной элемент выбирается из
+ * двоичной кучи голов курсоров (k-путевое слияние). Выдача очередной
+ * карточки стоит O(log k + log n), где k - количество колод, а начало
+ * сессии - O(k log n) независимо от общего числа готовых карточек.
+ *
+ * Порядок выдачи задает Interleave. Для каждой колоды действует дневной
+ * лимит повторений; уже выполненные сегодня повторения учитываются
+ * через setReviewedToday().
+ *
+ * Очередь допускает оценку выданных карточек (Deck::reviewCard()) во
+ * время обхода: курсор колоды хранит ключ последней выданной карточки
+ * и при следующем обращении находит продолжение в актуальном индексе.
+ * Перепланированная карточка уходит за границу готовых и повторно
+ * не выдается.
+ *
+ * Момент now фиксируется при start(): карточки, ставшие готовыми
+ * во время сессии, попадут в очередь только при следующем start().
+ *
+ * @warning Очередь не владеет колодами: они должны пережить очередь.
+ *          Удаление карточек (Deck::removeCard()) и замена карточек
+ *          колоды во время обхода требуют повторного start()
+ * @see Deck::getDueCardsView()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class ReviewQueue
+{
+public:
+    /// Лимит, означающий отсутствие ограничения
+    static constexpr int kUnlimited = -1;
+
+    /**
+     * @brief Порядок чередования колод
+     */
+    enum class Interleave {
+        ByDueTime,      ///< Самые просроченные карточки всех колод первыми
+        RoundRobin,     ///< По одной карточке из каждой колоды по кругу
+        DeckByDeck      ///< Колоды целиком, в порядке добавления
+    };
+
+    /**
+     * @brief Очередная карточка
+     */
+    struct Item {
+        const Deck *deck = nullptr;     ///< Колода карточки
+        CardRef card;                   ///< Карточка; действительна до изменения колоды
+    };
+
+    ReviewQueue() = default;
+
+    // =============== НАСТРОЙКА ===============
+
+    /**
+     * @brief Добавить колоду в очередь
+     * @param deck Колода; nullptr игнорируется
+     * @note Порядок добавления разрешает равенство сроков и задает
+     *       порядок колод в RoundRobin и DeckByDeck
+     */
+    void addDeck(const Deck *deck);
+
+    /**
+     * @brief Заменить список колод
+     */
+    void setDecks(const QList<const Deck *> &decks);
+
+    /**
+     * @brief Установить порядок чередования колод
+     */
+    void setInterleave(Interleave interleave);
+
+    /**
+     * @brief Получить порядок чередования колод
+     */
+    Interleave getInterleave() const;
+
+    /**
+     * @brief Установить дневной лимит повторений для всех колод
+     * @param limit Лимит; kUnlimited - без ограничения
+     */
+    void setDailyLimit(int limit);
+
+    /**
+     * @brief Установить дневной лимит повторений отдельной колоды
+     * @param deckId Идентификатор колоды
+     * @param limit Лимит; перекрывает общий лимит
+     */
+    void setDeckLimit(int deckId, int limit);
+
+    /**
+     * @brief Учесть повторения, уже выполненные в колоде сегодня
+     * @param deckId Идентификатор колоды
+     * @param count Количество повторений; уменьшает остаток дневного лимита
+     */
+    void setReviewedToday(int deckId, int count);
+
+    // =============== ОБХОД ===============
+
+    /**
+     * @brief Начать обход с моментом now
+     * @param nowMSecs Текущий момент (мс от эпохи)
+     */
+    void start(qint64 nowMSecs);
+
+    /**
+     * @brief Есть ли еще карточки
+     */
+    bool hasNext() const;
+
+    /**
+     * @brief Выдать очередную карточку
+     * @return Карточка; пустой Item (deck == nullptr), если очередь исчерпана
+     */
+    Item next();
+
+    /**
+     * @brief Сколько карточек еще будет выдано с учетом лимитов
+     * @note Сложность O(k log n)
+     */
+    int remaining() const;
+
+    /**
+     * @brief Сколько карточек колоды выдано с начала обхода
+     * @param deckId Идентификатор колоды
+     */
+    int issued(int deckId) const;
+
+private:
+    /**
+     * @brief Курсор колоды в её индексе повторений
+     */
+    struct Cursor {
+        const Deck *deck = nullptr;
+        qint64 lastDueAt = 0;       ///< Ключ последней выданной карточки
+        int lastRow = -1;           ///< -1 - карточек еще не выдано
+        int budget = 0;             ///< Остаток дневного лимита; kUnlimited - без ограничения
+        int issued = 0;             ///< Выдано с начала обхода
+    };
+
+    /**
+     * @brief Голова курсора в куче слияния
+     */
+    struct Head {
+        qint64 dueAt;       ///< Срок карточки
+        int row;            ///< Позиция карточки в колоде
+        int cursor;         ///< Номер курсора (порядок добавления колоды)
+    };
+
+    QList<const Deck *> decks;          ///< Колоды в порядке добавления
+    QHash<int, int> deckLimits;         ///< Лимиты отдельных колод
+    QHash<int, int> reviewedToday;      ///< Повторения, выполненные до обхода
+    Interleave interleave = Interleave::ByDueTime;
+    int dailyLimit = kUnlimited;        ///< Общий дневной лимит
+
+    qint64 now = 0;                     ///< Момент начала обхода
+    QList<Cursor> cursors;              ///< Курсоры колод
+    QList<Head> heap;                   ///< Куча голов (ByDueTime)
+    int turn = 0;                       ///< Текущая колода (RoundRobin, DeckByDeck)
+    Item upcoming;                      ///< Очередная карточка (найдена заранее)
+    int upcomingCursor = -1;            ///< Курсор очередной карточки
+
+    /**
+     * @brief Найти очередную карточку колоды
+     * @return false, если колода исчерпана или лимит выбран
+     */
+    bool peekCursor(int cursorIndex, Head &head) const;
+
+    /**
+     * @brief Найти очередную карточку всей очереди и сдвинуть курсор
+     * @return Номер курсора; -1, если очередь исчерпана
+     */
+    int advance();
+
+    /**
+     * @brief Сдвинуть курсор за карточку head и запомнить её как очередную
+     */
+    void take(int cursorIndex, const Head &head);
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include "CardStore.h"
+
+/**
+ * @brief Запись журнала повторений: оценка и итоговое состояние карточки
+ *
+ * Хранит не только оценку, но и состояние планирования после её
+ * применения, поэтому воспроизведение записи идемпотентно: повторное
+ * применение дает тот же результат и не зависит от часов.
+ *
+ * @see ReviewJournal, CardRepository::applyReviews()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+struct ReviewRecord {
+    qint64 sequence = 0;        ///< Порядковый номер в журнале (назначается журналом)
+    int cardId = 0;             ///< Идентификатор карточки
+    int grade = 0;              ///< Оценка ответа (0-5)
+    qint64 reviewedAt = 0;      ///< Момент ответа (мс от эпохи), становится lastReview
+    float easyFactor = 0.0f;    ///< Фактор легкости после ответа
+    int intervalDays = 0;       ///< Интервал после ответа
+    int repetitions = 0;        ///< Счетчик повторений после ответа
+    qint64 nextReview = 0;      ///< Следующее повторение (мс от эпохи или kNoDate)
+
+    /**
+     * @brief Составить запись по уже перепланированной карточке
+     * @param card Карточка после Deck::reviewCard()
+     * @param grade Выставленная оценка
+     */
+    static ReviewRecord fromCard(const CardRef &card, int grade)
+    {
+        ReviewRecord record;
+        record.cardId = card.getId();
+        record.grade = grade;
+        record.reviewedAt = card.getLastReviewMSecs();
+        record.easyFactor = card.getEasyFactor();
+        record.intervalDays = card.getIntervalDays();
+        record.repetitions = card.getRepetitions();
+        record.nextReview = card.getNextReviewMSecs();
+        return record;
+    }
+};
+
+/**
+ * @brief Получатель записей журнала повторений
+ *
+ * Реализуется хранилищем, в которое журнал переносит зафиксированные
+ * ответы: базой данных (CardRepository) или снимком коллекции
+ * (CollectionSnapshot).
+ *
+ * @see ReviewJournal::checkpoint(), ReviewJournal::recover()
+ */
+class ReviewSink
+{
+public:
+    virtual ~ReviewSink() = default;
+
+    /**
+     * @brief Применить записи журнала
+     * @param records Записи в порядке фиксации
+     * @return true при успехе; при ошибке хранилище не изменяется
+     */
+    virtual bool applyReviews(const QList<ReviewRecord> &records) = 0;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    virtual QString lastError() const = 0;
+};
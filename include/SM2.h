@@ -0,0 +1,58 @@
+#pragma once
+#include <QtGlobal>
+
+/**
+ * @brief Шаг алгоритма SuperMemo 2 над полями планирования
+ *
+ * Функции работают только с числовым состоянием повторения и не зависят от
+ * того, где оно хранится: в объекте Card или в столбцах CardStore.
+ *
+ * @see Card::updateSM2()
+ * @see https://www.supermemo.com/en/archives1990-2015/english/ol/sm2
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+namespace SM2 {
+
+/// Нижняя граница фактора легкости
+constexpr float kMinEasyFactor = 1.3f;
+
+/// Верхняя граница фактора легкости
+constexpr float kMaxEasyFactor = 2.5f;
+
+/**
+ * @brief Применить оценку к состоянию повторения
+ *
+ * Обновляет интервал, счетчик повторений и фактор легкости по правилам SM2.
+ * Даты повторения не затрагиваются: их вычисляет вызывающая сторона как
+ * момент ответа плюс новый интервал.
+ *
+ * @param easyFactor Фактор легкости (изменяется на месте)
+ * @param intervalDays Интервал в днях (изменяется на месте)
+ * @param repetitions Количество успешных повторений подряд (изменяется на месте)
+ * @param grade Оценка ответа (0-5), ограничивается автоматически
+ */
+void apply(float &easyFactor, int &intervalDays, int &repetitions, int grade);
+
+/**
+ * @brief Применить оценки к упакованным массивам состояний
+ *
+ * Пакетный эквивалент apply() для count независимых состояний:
+ * результат для каждого элемента совпадает с вызовом apply() побитово.
+ * Расчет разбит на два прохода без ветвлений - интервалы и счетчики,
+ * затем фактор легкости с ограничением [kMinEasyFactor, kMaxEasyFactor], -
+ * чтобы компилятор мог векторизовать формулу фактора легкости.
+ *
+ * @param easyFactors Факторы легкости (изменяются на месте)
+ * @param intervals Интервалы в днях (изменяются на месте)
+ * @param repetitions Счетчики успешных повторений (изменяются на месте)
+ * @param grades Оценки ответа (0-5), ограничиваются автоматически
+ * @param count Количество элементов
+ * @warning Каждый элемент обновляется один раз: повторная оценка того же
+ *          состояния должна идти отдельным вызовом
+ */
+void applyBatch(float *easyFactors, int *intervals, int *repetitions,
+                const int *grades, qsizetype count);
+
+} // namespace SM2
@@ -0,0 +1,113 @@
+#pragma once
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief Состояние планирования карточки, отдельное от Card
+ *
+ * Поля SM-2 совпадают с полями Card и столбцами CardStore. Поля модели
+ * памяти (стабильность и трудность) заполняются планировщиками, которые
+ * их используют; нулевое значение означает, что состояние еще не
+ * известно и должно быть выведено из полей SM-2.
+ *
+ * @see Scheduler
+ */
+struct SchedulingState {
+    float easyFactor = 2.5f;    ///< Фактор легкости
+    int intervalDays = 0;       ///< Интервал до следующего повторения в днях
+    int repetitions = 0;        ///< Счетчик повторений (смысл задает планировщик)
+    float stability = 0.0f;     ///< Дней до падения вероятности вспомнить до 90%; 0 - неизвестна
+    float difficulty = 0.0f;    ///< Трудность 1-10; 0 - неизвестна
+};
+
+/**
+ * @brief Стратегия планирования повторений
+ *
+ * Планировщик переводит состояние карточки и оценку ответа в новое
+ * состояние и интервал. Он не знает о датах и хранилищах: момент
+ * следующего повторения вычисляет вызывающая сторона как момент ответа
+ * плюс intervalDays (Card::review(), CardStore::review()).
+ *
+ * По умолчанию колода планирует по SM-2 (defaultScheduler()); другой
+ * планировщик подключается через Deck::setScheduler().
+ *
+ * @note Реализации не хранят изменяемого состояния и могут вызываться
+ *       из нескольких потоков одновременно
+ * @see Sm2Scheduler, FsrsScheduler
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class Scheduler
+{
+public:
+    virtual ~Scheduler() = default;
+
+    /**
+     * @brief Название алгоритма
+     */
+    virtual QString name() const = 0;
+
+    /**
+     * @brief Применить оценку к состоянию
+     * @param state Состояние (изменяется на месте)
+     * @param grade Оценка ответа (0-5), ограничивается автоматически
+     * @param elapsedDays Дней с прошлого повторения; 0 для первого
+     */
+    virtual void review(SchedulingState &state, int grade, double elapsedDays) const = 0;
+
+    /**
+     * @brief Применить оценки к массиву независимых состояний
+     *
+     * Реализация по умолчанию вызывает review() для каждого элемента.
+     *
+     * @param states Состояния (изменяются на месте)
+     * @param grades Оценки ответа
+     * @param elapsedDays Дней с прошлого повторения для каждого состояния
+     * @param count Количество элементов
+     */
+    virtual void reviewBatch(SchedulingState *states, const int *grades, const float *elapsedDays,
+                             qsizetype count) const;
+
+    /**
+     * @brief Предсказанная вероятность вспомнить карточку
+     * @param state Состояние после последнего повторения
+     * @param elapsedDays Дней с последнего повторения
+     * @return Вероятность в диапазоне [0, 1]
+     */
+    virtual double retrievability(const SchedulingState &state, double elapsedDays) const = 0;
+
+    /**
+     * @brief Планировщик по умолчанию (SM-2)
+     */
+    static const Scheduler &defaultScheduler();
+
+    /**
+     * @brief Дней между двумя моментами
+     * @param lastReview Прошлое повторение (мс от эпохи или CardStore::kNoDate)
+     * @param now Момент ответа (мс от эпохи)
+     * @return Дробное число дней; 0, если прошлого повторения не было
+     */
+    static double elapsedDays(qint64 lastReview, qint64 now);
+};
+
+/**
+ * @brief Планировщик SuperMemo 2
+ *
+ * Обертка над SM2::apply(): дает тот же результат, что Card::updateSM2().
+ * Модели памяти у SM-2 нет, поэтому retrievability() считается
+ * приближенно: вероятность экспоненциально убывает и достигает 90%
+ * к концу интервала.
+ *
+ * @see SM2::apply()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class Sm2Scheduler : public Scheduler
+{
+public:
+    QString name() const override;
+    void review(SchedulingState &state, int grade, double elapsedDays) const override;
+    double retrievability(const SchedulingState &state, double elapsedDays) const override;
+};
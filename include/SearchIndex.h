@@ -0,0 +1,220 @@
+#pragma once
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include "CardView.h"
+
+/**
+ * @brief Полнотекстовый индекс по вопросам и ответам карточек
+ *
+ * Обратный индекс: для каждого слова хранится список вхождений
+ * (документ, позиция), упорядоченный по документу, поэтому запрос
+ * - это пересечение коротких отсортированных списков, а не обход
+ * всех карточек с QString::contains().
+ *
+ * Разбиение на слова учитывает Unicode: слово - непрерывная
+ * последовательность букв, цифр и диакритических знаков любой
+ * письменности (кириллица, латиница, суррогатные пары). Слова
+ * приводятся к единому регистру (case folding), слова
+ * с диакритическими знаками - к форме NFC.
+ *
+ * Синтаксис запроса (все условия должны выполняться одновременно):
+ * - `слово` - карточка содержит слово;
+ * - `прист*` - карточка содержит слово, начинающееся с "прист";
+ * - `"несколько слов"` - слова идут подряд в вопросе или в ответе.
+ *
+ * Индекс обновляется по одной карточке: updateCard() помечает прежний
+ * документ удаленным и добавляет новый. Удаленные документы
+ * отбрасываются при поиске и вычищаются compact(), который
+ * вызывается автоматически, когда удаленных становится больше живых.
+ *
+ * Колода поддерживает индекс сама (Deck::setSearchIndex()). Индекс
+ * сохраняется в файл рядом с коллекцией (save(), load()); для базы
+ * данных тот же синтаксис запроса обслуживает FTS5
+ * (CardRepository::search()).
+ *
+ * @note Не потокобезопасен: изменения и поиск - из одного потока
+ * @see Deck::setSearchIndex(), CardRepository::search()
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class SearchIndex
+{
+public:
+    /// Версия формата файла
+    static constexpr quint32 kVersion = 1;
+
+    /**
+     * @brief Размер индекса
+     */
+    struct Stats {
+        int documents = 0;              ///< Проиндексированных карточек
+        int deletedDocuments = 0;       ///< Удаленных, но не вычищенных документов
+        int terms = 0;                  ///< Различных слов
+        qint64 postings = 0;            ///< Вхождений слов
+        qsizetype memoryUsage = 0;      ///< Оценка занимаемой памяти в байтах
+    };
+
+    SearchIndex() = default;
+
+    // =============== ИЗМЕНЕНИЕ ===============
+
+    /**
+     * @brief Очистить индекс
+     */
+    void clear();
+
+    /**
+     * @brief Добавить карточку
+     *
+     * Уже проиндексированная карточка заменяется.
+     *
+     * @param cardId Идентификатор карточки
+     * @param question Текст вопроса
+     * @param answer Текст ответа
+     */
+    void addCard(int cardId, const QString &question, const QString &answer);
+
+    /**
+     * @brief Добавить карточки диапазона
+     */
+    void addCards(CardSpan cards);
+
+    /**
+     * @brief Обновить текст карточки
+     * @return false, если карточки нет в индексе (тогда она добавляется)
+     */
+    bool updateCard(int cardId, const QString &question, const QString &answer);
+
+    /**
+     * @brief Удалить карточку
+     * @return false, если карточки нет в индексе
+     */
+    bool removeCard(int cardId);
+
+    /**
+     * @brief Вычистить удаленные документы из списков вхождений
+     *
+     * Сложность алгоритма: O(количество вхождений)
+     */
+    void compact();
+
+    // =============== ПОИСК ===============
+
+    /**
+     * @brief Найти карточки по запросу
+     * @param query Запрос (см. описание класса)
+     * @param limit Наибольшее количество результатов; -1 - без ограничения
+     * @return Идентификаторы карточек в порядке добавления в индекс
+     */
+    QList<int> search(const QString &query, int limit = -1) const;
+
+    /**
+     * @brief Есть ли карточка в индексе
+     */
+    bool contains(int cardId) const;
+
+    /**
+     * @brief Количество проиндексированных карточек
+     */
+    int size() const;
+
+    /**
+     * @brief Размер индекса
+     */
+    Stats stats() const;
+
+    // =============== ФАЙЛ ===============
+
+    /**
+     * @brief Сохранить индекс в файл (атомарно, через QSaveFile)
+     * @param path Путь к файлу
+     * @return true при успехе
+     */
+    bool save(const QString &path);
+
+    /**
+     * @brief Загрузить индекс из файла
+     *
+     * При ошибке индекс остается пустым и его следует перестроить.
+     *
+     * @param path Путь к файлу
+     * @return true при успехе
+     */
+    bool load(const QString &path);
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+    /**
+     * @brief Путь файла индекса рядом с файлом коллекции
+     * @param collectionPath Путь к базе данных или снимку коллекции
+     */
+    static QString pathFor(const QString &collectionPath);
+
+    // =============== РАЗБОР ===============
+
+    /**
+     * @brief Разбить текст на слова так же, как при индексации
+     */
+    static QStringList tokenize(const QString &text);
+
+    /**
+     * @brief Перевести запрос в выражение MATCH для SQLite FTS5
+     * @return Пустая строка, если в запросе нет ни одного слова
+     */
+    static QString toFts5Query(const QString &query);
+
+private:
+    /**
+     * @brief Вхождение слова
+     */
+    struct Posting {
+        qint32 doc;         ///< Номер документа
+        qint32 position;    ///< Номер слова; у ответа смещен на kFieldGap
+    };
+
+    QHash<QString, qint32> termIds;     ///< Номер слова по слову
+    QMap<QString, qint32> sortedTerms;  ///< Слова по порядку (для поиска по префиксу)
+    QList<QList<Posting>> postings;     ///< Вхождения по номеру слова, по возрастанию документа
+    QList<int> cardByDoc;               ///< Карточка документа; -1 - документ удален
+    QHash<int, qint32> docByCard;       ///< Живой документ карточки
+    int deletedDocs = 0;                ///< Удаленных документов в списках вхождений
+    qint64 postingCount = 0;            ///< Всего вхождений
+    QString errorText;                  ///< Текст последней ошибки
+
+    /**
+     * @brief Пометить документ карточки удаленным
+     */
+    bool dropCard(int cardId);
+
+    /**
+     * @brief Вычистить удаленные документы, если их стало много
+     */
+    void compactIfNeeded();
+
+    /**
+     * @brief Отсортированные документы, содержащие слово
+     */
+    QList<qint32> documentsWith(qint32 termId) const;
+
+    /**
+     * @brief Отсортированные документы, содержащие слово с префиксом
+     */
+    QList<qint32> documentsWithPrefix(const QString &prefix) const;
+
+    /**
+     * @brief Отсортированные документы, содержащие слова подряд
+     */
+    QList<qint32> documentsWithPhrase(const QStringList &tokens) const;
+
+    /**
+     * @brief Запомнить ошибку и вернуть false
+     */
+    bool fail(const QString &message);
+};
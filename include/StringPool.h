@@ -0,0 +1,112 @@
+#pragma once
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <array>
+
+/**
+ * @brief Пул интернированных строк для текста карточек
+ *
+ * Одинаковый текст, полученный независимо (разобранный из файла дважды,
+ * собранный из частей), занимает в QString отдельные буферы: implicit
+ * sharing помогает только копиям одной строки. intern() возвращает
+ * строку, разделяющую буфер с первой такой же строкой пула, поэтому
+ * в колодах с повторяющимися ответами (спряжения, словари с общими
+ * переводами) каждый текст хранится один раз.
+ *
+ * Пул держит ссылку на каждую строку; squeeze() отпускает строки,
+ * которые больше никем не используются.
+ *
+ * @note Потокобезопасен: строки распределены по сегментам со своими
+ *       мьютексами, поэтому потоки разбора импортера почти не ждут
+ *       друг друга
+ * @see Card, CsvImporter::Options::stringPool, AnkiImporter::Options::stringPool
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class StringPool
+{
+public:
+    /**
+     * @brief Счетчики пула
+     */
+    struct Stats {
+        qsizetype strings = 0;      ///< Различных строк в пуле
+        qint64 requests = 0;        ///< Вызовов intern() с непустой строкой
+        qint64 hits = 0;            ///< Вызовов, вернувших строку из пула
+        qint64 pooledBytes = 0;     ///< Объем текста строк пула (UTF-16)
+        qint64 savedBytes = 0;      ///< Объем текста, не выделенного повторно благодаря пулу
+    };
+
+    StringPool() = default;
+
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    /**
+     * @brief Получить строку пула, равную text
+     *
+     * Если такой строки в пуле нет, text добавляется в пул.
+     * Пустая строка возвращается без изменений.
+     *
+     * @param text Текст
+     * @return Строка, разделяющая буфер со строкой пула
+     */
+    QString intern(const QString &text);
+
+    /**
+     * @brief Есть ли строка в пуле
+     */
+    bool contains(const QString &text) const;
+
+    /**
+     * @brief Количество различных строк в пуле
+     */
+    qsizetype size() const;
+
+    /**
+     * @brief Счетчики пула
+     */
+    Stats stats() const;
+
+    /**
+     * @brief Удалить строки, которые используются только пулом
+     * @return Количество удаленных строк
+     */
+    qsizetype squeeze();
+
+    /**
+     * @brief Удалить все строки и сбросить счетчики
+     *
+     * Строки, уже выданные пулом, остаются действительными.
+     */
+    void clear();
+
+private:
+    /// Количество сегментов (степень двойки)
+    static constexpr int kShardCount = 16;
+
+    /**
+     * @brief Сегмент пула со своим мьютексом
+     */
+    struct Shard {
+        mutable QMutex mutex;       ///< Защищает поля сегмента
+        QSet<QString> strings;      ///< Строки сегмента
+        qint64 requests = 0;        ///< Вызовов intern()
+        qint64 hits = 0;            ///< Попаданий
+        qint64 pooledBytes = 0;     ///< Объем текста строк сегмента
+        qint64 savedBytes = 0;      ///< Объем повторно не выделенного текста
+    };
+
+    std::array<Shard, kShardCount> shards;
+
+    /**
+     * @brief Сегмент строки по старшим битам хэша
+     *
+     * Младшие биты выбирают корзину внутри QSet сегмента, поэтому
+     * для выбора сегмента берутся старшие.
+     */
+    Shard &shardFor(const QString &text);
+    const Shard &shardFor(const QString &text) const;
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <utility>
+
+class TaskRunner;
+
+/**
+ * @brief Связь выполняемой задачи с TaskRunner
+ *
+ * Передается функции задачи; используется только в её потоке.
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class TaskContext
+{
+public:
+    /**
+     * @brief Запрошена ли отмена задачи
+     *
+     * Долгая задача проверяет флаг между порциями работы и завершается,
+     * вернув false.
+     */
+    bool isCanceled() const;
+
+    /**
+     * @brief Сообщить о прогрессе
+     *
+     * Сигнал TaskRunner::progress() выдается не чаще раза
+     * в TaskRunner::kProgressIntervalMSecs, а также при done >= total,
+     * поэтому метод можно вызывать на каждой карточке.
+     *
+     * @param done Выполнено единиц работы
+     * @param total Всего единиц работы или -1, если неизвестно
+     */
+    void setProgress(qint64 done, qint64 total);
+
+    /**
+     * @brief Запомнить текст ошибки для TaskRunner::finished()
+     */
+    void setError(const QString &message);
+
+    /**
+     * @brief Текст ошибки, заданный setError()
+     */
+    QString error() const;
+
+private:
+    friend class TaskRunner;
+
+    TaskContext(TaskRunner *runner, int id, const QPromise<bool> &promise);
+
+    TaskRunner *runner;                 ///< Владелец задачи
+    int taskId;                         ///< Идентификатор задачи
+    const QPromise<bool> &promise;      ///< Обещание результата задачи
+    QElapsedTimer sinceProgress;        ///< Время с последнего сигнала прогресса
+    QString errorText;                  ///< Текст ошибки
+};
+
+/**
+ * @brief Пул фоновых задач: загрузка колод, импорт, статистика
+ *
+ * Задачи выполняются в собственном QThreadPool, поэтому поток
+ * интерфейса не ждет ни загрузки, ни разбора файлов. Результат
+ * задачи - QFuture<bool>; отмена - QFuture::cancel() или cancel(),
+ * после чего TaskContext::isCanceled() возвращает true.
+ *
+ * Сигналы выдаются объектом TaskRunner и доставляются получателям
+ * в потоке интерфейса очередью событий:
+ * - started() - из run(), в потоке вызова;
+ * - progress() - из рабочего потока, не чаще kProgressIntervalMSecs;
+ * - finished() - в потоке TaskRunner после завершения задачи.
+ *
+ * Собранную колоду задача передает интерфейсу через DeckHandoff;
+ * готовые задачи для колод - в DeckTasks.
+ *
+ * Пример:
+ * @code
+ * TaskRunner runner;
+ * DeckHandoff handoff;
+ * connect(&runner, &TaskRunner::finished, this, [&](int id, bool ok) {
+ *     if (ok) model->setDeck((deck = handoff.current()).data());
+ * });
+ * runner.run("Загрузка", DeckTasks::loadSnapshot(path, deckId, handoff));
+ * @endcode
+ *
+ * @see DeckHandoff, DeckTasks
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class TaskRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Наименьший промежуток между сигналами progress() одной задачи
+    static constexpr int kProgressIntervalMSecs = 30;
+
+    /**
+     * @brief Функция задачи
+     * @return true при успехе; при отмене или ошибке - false
+     */
+    using Task = std::function<bool(TaskContext &context)>;
+
+    /**
+     * @param threadCount Потоков пула; 0 - по числу ядер
+     */
+    explicit TaskRunner(int threadCount = 0, QObject *parent = nullptr);
+
+    /**
+     * @brief Отменяет задачи и дожидается их завершения
+     */
+    ~TaskRunner() override;
+
+    /**
+     * @brief Запустить задачу в фоне
+     * @param name Название задачи для интерфейса
+     * @param task Функция задачи
+     * @return Идентификатор задачи
+     */
+    int run(const QString &name, Task task);
+
+    /**
+     * @brief Результат задачи
+     *
+     * Будущее доступно до доставки сигнала finished() этой задачи.
+     *
+     * @return Будущее или пустое QFuture, если задача неизвестна
+     */
+    QFuture<bool> future(int id) const;
+
+    /**
+     * @brief Запросить отмену задачи (из любого потока)
+     */
+    void cancel(int id);
+
+    /**
+     * @brief Запросить отмену всех задач (из любого потока)
+     */
+    void cancelAll();
+
+    /**
+     * @brief Дождаться завершения всех задач
+     *
+     * Блокирует вызывающий поток; в потоке интерфейса используйте
+     * сигнал finished().
+     *
+     * @param msecs Наибольшее время ожидания; -1 - без ограничения
+     * @return true, если все задачи завершены
+     */
+    bool waitForDone(int msecs = -1);
+
+    /**
+     * @brief Количество запущенных и еще не завершенных задач
+     */
+    int activeCount() const;
+
+    /**
+     * @brief Отпустить значение в рабочем потоке
+     *
+     * Деструктор колоды на миллион карточек занимает десятки
+     * миллисекунд; если поток интерфейса держит последнюю ссылку,
+     * её стоит отпустить здесь, а не в потоке интерфейса.
+     *
+     * @param value Разделяемое значение; передайте через std::move
+     */
+    template <typename T>
+    void releaseLater(QSharedPointer<T> value)
+    {
+        if (value) {
+            threadPool.start([held = std::move(value)]() mutable { held.reset(); });
+        }
+    }
+
+signals:
+    /**
+     * @brief Задача поставлена в очередь
+     */
+    void started(int id, const QString &name);
+
+    /**
+     * @brief Прогресс задачи
+     * @param total Всего единиц работы или -1, если неизвестно
+     */
+    void progress(int id, qint64 done, qint64 total);
+
+    /**
+     * @brief Задача завершена
+     * @param ok true при успехе; false при ошибке или отмене
+     * @param error Текст ошибки; пустой при успехе
+     */
+    void finished(int id, bool ok, const QString &error);
+
+private:
+    friend class TaskContext;
+
+    QThreadPool threadPool;                 ///< Рабочие потоки
+    mutable QMutex mutex;                   ///< Защищает futures и nextId
+    QHash<int, QFuture<bool>> futures;      ///< Задачи до доставки finished()
+    int nextId = 1;                         ///< Следующий идентификатор
+    std::atomic<int> active{0};             ///< Незавершенных задач
+};
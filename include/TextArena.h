@@ -0,0 +1,95 @@
+#pragma once
+#include <QByteArrayView>
+#include <QString>
+#include <QStringDecoder>
+#include <QStringView>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Монотонный буфер текста карточек
+ *
+ * Текст копируется в крупные блоки подряд, без отдельного выделения
+ * памяти на каждую строку. add() возвращает QString, который ссылается
+ * на данные блока (QString::fromRawData()) и сам памяти не выделяет.
+ * Строки по отдельности не освобождаются: все блоки освобождаются
+ * вместе с буфером.
+ *
+ * @warning Строки буфера и их копии действительны, пока жив буфер.
+ *          Не потокобезопасен
+ * @see DeckBuilder
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class TextArena
+{
+public:
+    /// Размер блока по умолчанию в символах UTF-16 (2 МиБ)
+    static constexpr qsizetype kDefaultBlockChars = qsizetype(1) << 20;
+
+    /**
+     * @param blockChars Размер блока в символах UTF-16
+     */
+    explicit TextArena(qsizetype blockChars = kDefaultBlockChars);
+
+    TextArena(const TextArena &) = delete;
+    TextArena &operator=(const TextArena &) = delete;
+
+    /**
+     * @brief Скопировать текст в буфер
+     * @param text Текст
+     * @return Строка, ссылающаяся на копию в буфере; для пустого текста - пустая строка
+     */
+    QString add(QStringView text);
+
+    /**
+     * @brief Декодировать UTF-8 прямо в буфер
+     *
+     * Промежуточный QString не создается.
+     *
+     * @param utf8 Текст в UTF-8
+     * @return Строка, ссылающаяся на текст в буфере
+     */
+    QString addUtf8(QByteArrayView utf8);
+
+    /**
+     * @brief Количество выделенных блоков
+     */
+    int blockCount() const;
+
+    /**
+     * @brief Объем выделенных блоков в байтах
+     */
+    qint64 bytesReserved() const;
+
+    /**
+     * @brief Объем занятой части блоков в байтах
+     */
+    qint64 bytesUsed() const;
+
+private:
+    std::vector<std::unique_ptr<char16_t[]>> blocks;    ///< Выделенные блоки в любом порядке
+    char16_t *cursor = nullptr;         ///< Начало свободного места текущего блока
+    char16_t *limit = nullptr;          ///< Конец текущего блока
+    qsizetype blockChars;               ///< Размер обычного блока
+    qint64 reservedChars = 0;           ///< Символов во всех блоках
+    qint64 usedChars = 0;               ///< Занятых символов
+    QStringDecoder decoder;             ///< Декодер UTF-8 без состояния
+
+    /**
+     * @brief Место под chars символов
+     *
+     * Строка длиннее четверти блока получает собственный блок, чтобы
+     * не оставлять пустым хвост текущего.
+     */
+    char16_t *allocate(qsizetype chars);
+
+    /**
+     * @brief Вернуть неиспользованный хвост последнего выделения
+     * @param start Начало выделения
+     * @param reserved Выделено символов
+     * @param used Использовано символов
+     */
+    void release(char16_t *start, qsizetype reserved, qsizetype used);
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <QList>
+#include <QString>
+#include <array>
+#include "Clock.h"
+
+class Deck;
+
+/**
+ * @brief Монте-Карло симулятор нагрузки повторений по SM-2
+ *
+ * Предсказывает, сколько повторений придется на каждый день в ближайшие
+ * месяцы: многократно "проживает" расписание колоды день за днем,
+ * выставляя карточкам случайные оценки по заданным вероятностям
+ * и пересчитывая их по тем же правилам, что Card::updateSM2() (SM2::apply()).
+ *
+ * Испытания независимы и выполняются параллельно (QThreadPool). Каждое
+ * испытание использует собственный генератор, засеянный seed и номером
+ * испытания, поэтому результат не зависит от числа потоков.
+ *
+ * Состояние карточек в испытании упаковано в плотные массивы, а очередь
+ * дней - интрузивные списки (голова на день, следующий на карточку),
+ * поэтому день обрабатывает только свои карточки, а внутренний цикл
+ * не выделяет память: буферы выделяются один раз на поток.
+ *
+ * Результат - кривая нагрузки по дням: среднее, медиана и границы
+ * доверительной полосы (перцентили по испытаниям).
+ *
+ * @note Колода не изменяется; дни считаются от текущего момента часов
+ *       (setClock()), сроки переводятся в дни по местной полуночи
+ * @see SM2::apply(), ReviewForecast
+ *
+ * @author bozvan
+ * @version 1.0
+ */
+class WorkloadSimulator
+{
+public:
+    /// Лимит, означающий отсутствие ограничения
+    static constexpr int kUnlimited = -1;
+
+    /**
+     * @brief Параметры симуляции
+     */
+    struct Options {
+        int days = 365;                 ///< Длина симуляции в днях
+        int trials = 100;               ///< Количество испытаний
+        int threadCount = 0;            ///< Потоков; 0 - по числу ядер, 1 - в потоке вызова
+        int dailyLimit = kUnlimited;    ///< Наибольшее число повторений в день; остаток переносится
+        quint32 seed = 1;               ///< Зерно генератора первого испытания
+        double confidence = 0.9;        ///< Ширина доверительной полосы (доля испытаний)
+        /// Относительные вероятности оценок 0-5
+        std::array<double, 6> gradeWeights = {0.02, 0.03, 0.05, 0.15, 0.45, 0.30};
+    };
+
+    /**
+     * @brief Нагрузка одного дня по всем испытаниям
+     */
+    struct DayLoad {
+        double mean = 0.0;      ///< Среднее число повторений
+        int median = 0;         ///< Медиана
+        int lower = 0;          ///< Нижняя граница доверительной полосы
+        int upper = 0;          ///< Верхняя граница доверительной полосы
+    };
+
+    /**
+     * @brief Итог симуляции
+     */
+    struct Result {
+        QList<DayLoad> days;            ///< Кривая нагрузки, день 0 - сегодня
+        double meanTotal = 0.0;         ///< Среднее число повторений за весь срок
+        int lowerTotal = 0;             ///< Нижняя граница полосы для суммы
+        int upperTotal = 0;             ///< Верхняя граница полосы для суммы
+        double meanBacklog = 0.0;       ///< Среднее число карточек, не уместившихся в лимит к концу срока
+        qint64 reviews = 0;             ///< Повторений смоделировано во всех испытаниях
+        qint64 elapsedMSecs = 0;        ///< Длительность симуляции
+    };
+
+    WorkloadSimulator();
+    explicit WorkloadSimulator(const Options &options);
+
+    /**
+     * @brief Установить часы, от которых отсчитываются дни
+     * @param clock Часы; nullptr - часы колоды
+     * @warning Симулятор не владеет часами
+     */
+    void setClock(const Clock *clock);
+
+    /**
+     * @brief Смоделировать нагрузку колоды
+     * @param deck Колода; не должна меняться во время симуляции
+     * @return false при недопустимых параметрах
+     */
+    bool simulate(const Deck &deck);
+
+    /**
+     * @brief Итог последней симуляции
+     */
+    const Result &result() const;
+
+    /**
+     * @brief Текст последней ошибки
+     */
+    QString lastError() const;
+
+private:
+    /**
+     * @brief Упакованное начальное состояние колоды
+     */
+    struct Initial {
+        QList<float> easyFactors;
+        QList<int> intervals;
+        QList<int> repetitions;
+        QList<int> dueDays;         ///< День первого повторения; days - за горизонтом
+    };
+
+    struct TrialBuffers;
+
+    Options options;
+    const Clock *clock = nullptr;       ///< Часы симуляции (не владеет)
+    Result summary;                     ///< Итог последней симуляции
+    QString errorText;                  ///< Текст последней ошибки
+
+    /**
+     * @brief Провести одно испытание
+     * @param initial Начальное состояние
+     * @param thresholds Накопленные границы оценок 1-5 в диапазоне quint32
+     * @param trial Номер испытания (зерно генератора)
+     * @param loads Выход: повторений по дням, options.days элементов
+     * @param buffers Рабочие массивы потока (переиспользуются)
+     * @return Карточек, оставшихся в очереди сверх лимита к концу срока
+     */
+    int runTrial(const Initial &initial, const quint32 *thresholds, int trial, int *loads,
+                 TrialBuffers &buffers) const;
+
+    /**
+     * @brief Запомнить ошибку и вернуть false
+     */
+    bool fail(const QString &message);
+};
@@ -0,0 +1,452 @@
+#include "AnkiImporter.h"
+#include "CardStore.h"
+#include "CardRepository.h"
+#include "Deck.h"
+#include "SM2.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+/// Миллисекунд в сутках
+constexpr qint64 kDayMSecs = 86400000;
+
+/// Граница между днями и секундами в поле due карточек обучения
+constexpr qint64 kEpochSecondsThreshold = 1000000000;
+
+/// Объем медиаданных, после которого они записываются, не дожидаясь пакета
+constexpr qint64 kMediaFlushBytes = 32 * 1024 * 1024;
+
+/// Разделитель полей заметки Anki
+constexpr char16_t kFieldSeparator = 0x1f;
+
+/**
+ * @brief Типы карточек Anki (cards.type)
+ */
+enum AnkiCardType {
+    AnkiNew = 0,
+    AnkiLearning = 1,
+    AnkiReview = 2,
+    AnkiRelearning = 3
+};
+
+/// Очередь приостановленных карточек (cards.queue)
+constexpr int kAnkiSuspendedQueue = -1;
+
+/**
+ * @brief Сводка журнала повторений по карточке
+ */
+struct ReviewSummary {
+    qint64 lastReviewMSecs = 0;     ///< Время последнего ответа
+    int streak = 0;                 ///< Успешных ответов подряд в конце журнала
+};
+
+bool queryFailed(const QSqlQuery &query, QString *errorMessage)
+{
+    if (errorMessage) {
+        *errorMessage = query.lastError().text();
+    }
+    return false;
+}
+
+bool readCreationTime(QSqlDatabase &database, qint64 &creationMSecs, QString *errorMessage)
+{
+    QSqlQuery query(database);
+    if (!query.exec("SELECT crt FROM col") || !query.next()) {
+        if (errorMessage) {
+            *errorMessage = query.lastError().isValid() ? query.lastError().text()
+                                                        : QStringLiteral("Collection has no col row");
+        }
+        return false;
+    }
+    creationMSecs = query.value(0).toLongLong() * 1000;
+    return true;
+}
+
+/**
+ * @brief Свернуть журнал повторений в сводку по карточке
+ *
+ * Записи читаются по порядку (cid, id), поэтому серия успешных ответов
+ * считается одним проходом. Перенос без ответа (ease = 0) не учитывается.
+ */
+bool readReviewSummaries(QSqlDatabase &database, qint64 sourceDeckId,
+                         QHash<qint64, ReviewSummary> &summaries, qint64 &count, QString *errorMessage)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    QString sql = "SELECT cid, id, ease FROM revlog";
+    if (sourceDeckId != 0) {
+        sql += " WHERE cid IN (SELECT id FROM cards WHERE did = ?)";
+    }
+    sql += " ORDER BY cid, id";
+    if (!query.prepare(sql)) {
+        return queryFailed(query, errorMessage);
+    }
+    if (sourceDeckId != 0) {
+        query.addBindValue(sourceDeckId);
+    }
+    if (!query.exec()) {
+        return queryFailed(query, errorMessage);
+    }
+
+    qint64 currentCard = 0;
+    ReviewSummary *current = nullptr;
+    while (query.next()) {
+        ++count;
+        const int ease = query.value(2).toInt();
+        if (ease == 0) {
+            continue;
+        }
+        const qint64 cardId = query.value(0).toLongLong();
+        if (!current || cardId != currentCard) {
+            currentCard = cardId;
+            current = &summaries[cardId];
+        }
+        current->lastReviewMSecs = query.value(1).toLongLong();
+        current->streak = ease > 1 ? current->streak + 1 : 0;
+    }
+    return !query.lastError().isValid() || queryFailed(query, errorMessage);
+}
+
+/**
+ * @brief Прочитать карту медиафайлов архива
+ *
+ * В распакованном .apkg файлы называются 0, 1, ..., а файл media
+ * содержит JSON {"0": "имя.jpg", ...}.
+ *
+ * @return Путь к файлу на диске по исходному имени
+ */
+QHash<QString, QString> readMediaMap(const QDir &directory)
+{
+    QHash<QString, QString> paths;
+    QFile file(directory.filePath("media"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return paths;
+    }
+    const QJsonObject media = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = media.constBegin(); it != media.constEnd(); ++it) {
+        paths.insert(it.value().toString(), directory.filePath(it.key()));
+    }
+    return paths;
+}
+
+/**
+ * @brief Свести HTML поля Anki к тексту и найти ссылку на медиафайл
+ *
+ * @param html Поле заметки
+ * @param mediaName Имя первого найденного медиафайла (не перезаписывается)
+ * @param contentType Тип содержимого по первому медиафайлу
+ */
+QString plainText(const QString &html, QString &mediaName, ContentType &contentType)
+{
+    static const QRegularExpression sound(QStringLiteral("\\[sound:([^\\]]+)\\]"));
+    static const QRegularExpression image(QStringLiteral("<img[^>]*\\ssrc\\s*=\\s*[\"']?([^\"'>\\s]+)[^>]*>"),
+                                          QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression lineBreak(QStringLiteral("<br\\s*/?>|</div>|</p>"),
+                                              QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression tag(QStringLiteral("<[^>]*>"));
+
+    // Быстрый путь: обычный текст без разметки
+    if (!html.contains(QLatin1Char('<')) && !html.contains(QLatin1Char('&'))
+        && !html.contains(QLatin1String("[sound:"))) {
+        return html.trimmed();
+    }
+
+    QString text = html;
+    if (mediaName.isEmpty()) {
+        const QRegularExpressionMatch soundMatch = sound.match(text);
+        const QRegularExpressionMatch imageMatch = image.match(text);
+        if (soundMatch.hasMatch()
+            && (!imageMatch.hasMatch() || soundMatch.capturedStart() < imageMatch.capturedStart())) {
+            mediaName = soundMatch.captured(1);
+            contentType = ContentType::Audio;
+        } else if (imageMatch.hasMatch()) {
+            mediaName = imageMatch.captured(1);
+            contentType = ContentType::Image;
+        }
+    }
+    text.remove(sound);
+    text.remove(image);
+    text.replace(lineBreak, QStringLiteral("\n"));
+    text.remove(tag);
+    text.replace(QLatin1String("&nbsp;"), QLatin1String(" "));
+    text.replace(QLatin1String("&lt;"), QLatin1String("<"));
+    text.replace(QLatin1String("&gt;"), QLatin1String(">"));
+    text.replace(QLatin1String("&quot;"), QLatin1String("\""));
+    text.replace(QLatin1String("&#39;"), QLatin1String("'"));
+    text.replace(QLatin1String("&amp;"), QLatin1String("&"));
+    return text.trimmed();
+}
+
+/**
+ * @brief Дата следующего повторения по полям карточки Anki
+ * @return Мс от эпохи или kNoDate для новых карточек
+ */
+qint64 nextReviewMSecs(int type, qint64 due, qint64 creationMSecs)
+{
+    switch (type) {
+    case AnkiReview:
+        return creationMSecs + due * kDayMSecs;
+    case AnkiLearning:
+    case AnkiRelearning:
+        // Очередь обучения хранит секунды от эпохи, очередь дневного обучения - дни
+        return due > kEpochSecondsThreshold ? due * 1000 : creationMSecs + due * kDayMSecs;
+    default:
+        return CardStore::kNoDate;
+    }
+}
+
+} // namespace
+
+AnkiImporter::AnkiImporter() : AnkiImporter(Options()) {}
+
+AnkiImporter::AnkiImporter(const Options &options) : options(options) {}
+
+void AnkiImporter::setProgressCallback(ProgressCallback callback)
+{
+    progressCallback = std::move(callback);
+}
+
+/**
+ * @brief Импортировать коллекцию в базу данных
+ *
+ * Идентификаторы карточек уникальны во всей базе, поэтому нумерация
+ * продолжает наибольший сохраненный идентификатор.
+ */
+bool AnkiImporter::importCollection(const QString &collectionPath, CardRepository &cards)
+{
+    const int nextCardId = cards.nextCardId();
+    if (nextCardId < 0) {
+        summary = Result();
+        return fail(cards.lastError());
+    }
+    const int deckId = options.deckId;
+    const int configuredId = options.firstCardId;
+    options.firstCardId = std::max(configuredId, nextCardId);
+    const bool ok = importCollection(collectionPath,
+        [&cards, deckId](QList<Card> &&batch) { return cards.insertCards(deckId, batch); },
+        [&cards](const QHash<int, QByteArray> &media) { return cards.saveMedia(media); });
+    options.firstCardId = configuredId;
+    return ok;
+}
+
+bool AnkiImporter::importCollection(const QString &collectionPath, Deck &deck)
+{
+    return importCollection(collectionPath,
+        [&deck](QList<Card> &&batch) {
+            deck.addCards(std::move(batch));
+            return true;
+        },
+        MediaSink());
+}
+
+/**
+ * @brief Импортировать коллекцию в произвольные получатели
+ *
+ * Порядок: дата создания коллекции, сводка журнала повторений, затем
+ * один курсор по карточкам с текстом заметок. Коллекция открывается
+ * отдельным соединением только для чтения.
+ */
+bool AnkiImporter::importCollection(const QString &collectionPath, const BatchSink &sink,
+                                    const MediaSink &mediaSink)
+{
+    summary = Result();
+    errorText.clear();
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!QFileInfo::exists(collectionPath)) {
+        return fail(QString("Collection %1 not found").arg(collectionPath));
+    }
+
+    const QDir mediaDirectory(options.mediaDirectory.isEmpty()
+                                  ? QFileInfo(collectionPath).absolutePath()
+                                  : options.mediaDirectory);
+    const QHash<QString, QString> mediaPaths = mediaSink ? readMediaMap(mediaDirectory)
+                                                         : QHash<QString, QString>();
+
+    const QString connection = QString("anki_import_%1").arg(reinterpret_cast<quintptr>(this));
+    bool ok = false;
+    {
+        QSqlDatabase anki = QSqlDatabase::addDatabase("QSQLITE", connection);
+        anki.setDatabaseName(collectionPath);
+        anki.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (!anki.open()) {
+            errorText = anki.lastError().text();
+        } else {
+            ok = [&]() {
+                qint64 creationMSecs = 0;
+                QHash<qint64, ReviewSummary> reviews;
+                if (!readCreationTime(anki, creationMSecs, &errorText)
+                    || !readReviewSummaries(anki, options.sourceDeckId, reviews, summary.reviewLogs, &errorText)) {
+                    return false;
+                }
+
+                const QString filter = options.sourceDeckId != 0 ? QStringLiteral(" WHERE c.did = ?") : QString();
+                QSqlQuery query(anki);
+                query.setForwardOnly(true);
+                qint64 totalCards = 0;
+                if (!query.prepare("SELECT COUNT(*) FROM cards c" + filter)) {
+                    return queryFailed(query, &errorText);
+                }
+                if (options.sourceDeckId != 0) {
+                    query.addBindValue(options.sourceDeckId);
+                }
+                if (!query.exec() || !query.next()) {
+                    return queryFailed(query, &errorText);
+                }
+                totalCards = query.value(0).toLongLong();
+                query.finish();
+
+                if (!query.prepare("SELECT c.id, c.ord, c.type, c.queue,"
+                                   " CASE WHEN c.odid != 0 THEN c.odue ELSE c.due END,"
+                                   " c.ivl, c.factor, n.flds"
+                                   " FROM cards c JOIN notes n ON n.id = c.nid" + filter +
+                                   " ORDER BY c.id")) {
+                    return queryFailed(query, &errorText);
+                }
+                if (options.sourceDeckId != 0) {
+                    query.addBindValue(options.sourceDeckId);
+                }
+                if (!query.exec()) {
+                    return queryFailed(query, &errorText);
+                }
+
+                QList<Card> batch;
+                batch.reserve(options.batchSize);
+                QHash<int, QByteArray> media;
+                qint64 mediaBytes = 0;
+                int nextCardId = options.firstCardId;
+
+                auto flushMedia = [&]() {
+                    if (media.isEmpty()) {
+                        return true;
+                    }
+                    if (!mediaSink(media)) {
+                        return fail(QStringLiteral("Media import aborted by the receiver"));
+                    }
+                    summary.mediaFiles += media.size();
+                    media.clear();
+                    mediaBytes = 0;
+                    return true;
+                };
+                auto flushBatch = [&]() {
+                    if (batch.isEmpty()) {
+                        return true;
+                    }
+                    const qsizetype size = batch.size();
+                    if (!sink(std::move(batch))) {
+                        return fail(QStringLiteral("Import aborted by the receiver"));
+                    }
+                    summary.imported += size;
+                    batch = QList<Card>();
+                    batch.reserve(options.batchSize);
+                    if (progressCallback) {
+                        progressCallback(summary.cards, totalCards);
+                    }
+                    return true;
+                };
+
+                while (query.next()) {
+                    ++summary.cards;
+                    const qint64 ankiCardId = query.value(0).toLongLong();
+                    const int ord = query.value(1).toInt();
+                    const int type = query.value(2).toInt();
+                    const int queue = query.value(3).toInt();
+                    const qint64 due = query.value(4).toLongLong();
+                    const int ankiInterval = query.value(5).toInt();
+                    const int factor = query.value(6).toInt();
+
+                    if (queue == kAnkiSuspendedQueue && !options.includeSuspended) {
+                        ++summary.skipped;
+                        continue;
+                    }
+
+                    const QStringList fields = query.value(7).toString().split(QChar(kFieldSeparator));
+                    QString questionHtml = fields.value(0);
+                    QString answerHtml = fields.value(1);
+                    if (ord == 1 && fields.size() >= 2) {
+                        std::swap(questionHtml, answerHtml);
+                    }
+
+                    QString mediaName;
+                    ContentType contentType = ContentType::Text;
+                    const QString question = plainText(questionHtml, mediaName, contentType);
+                    const QString answer = plainText(answerHtml, mediaName, contentType);
+                    if (question.isEmpty() && mediaName.isEmpty()) {
+                        ++summary.skipped;
+                        continue;
+                    }
+
+                    const float easyFactor = factor > 0
+                        ? qBound(SM2::kMinEasyFactor, factor / 1000.0f, SM2::kMaxEasyFactor)
+                        : SM2::kMaxEasyFactor;
+                    const qint64 next = nextReviewMSecs(type, due, creationMSecs);
+                    const ReviewSummary review = reviews.value(ankiCardId);
+                    const int repetitions = review.lastReviewMSecs != 0 ? review.streak
+                                                                       : (type == AnkiReview ? 1 : 0);
+
+                    const int cardId = nextCardId++;
+                    batch.append(Card(cardId, question, answer, contentType, TestMode::DirectAnswer,
+                                      easyFactor, type == AnkiNew ? 0 : qMax(ankiInterval, 0), repetitions,
+                                      CardStore::fromEpochMSecs(next),
+                                      review.lastReviewMSecs != 0 ? QDateTime::fromMSecsSinceEpoch(review.lastReviewMSecs)
+                                                                  : QDateTime(),
+                                      options.deckId, options.stringPool));
+
+                    if (mediaSink && !mediaName.isEmpty()) {
+                        QFile file(mediaPaths.value(mediaName, mediaDirectory.filePath(mediaName)));
+                        if (file.open(QIODevice::ReadOnly)) {
+                            const QByteArray data = file.readAll();
+                            mediaBytes += data.size();
+                            media.insert(cardId, data);
+                        } else {
+                            ++summary.missingMedia;
+                        }
+                    }
+
+                    if ((batch.size() >= options.batchSize && !flushBatch())
+                        || (mediaBytes >= kMediaFlushBytes && !flushMedia())) {
+                        return false;
+                    }
+                }
+                if (query.lastError().isValid()) {
+                    return queryFailed(query, &errorText);
+                }
+                return flushBatch() && flushMedia();
+            }();
+        }
+        anki.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+
+    summary.elapsedMSecs = timer.elapsed();
+    return ok;
+}
+
+const AnkiImporter::Result &AnkiImporter::result() const
+{
+    return summary;
+}
+
+QString AnkiImporter::lastError() const
+{
+    return errorText;
+}
+
+bool AnkiImporter::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
@@ -0,0 +1,103 @@
+#include "CardContentCache.h"
+#include <QMutexLocker>
+
+CardContentCache::CardContentCache(CardContentSource *source, qsizetype capacityBytes)
+    : source(source), cache(capacityBytes) {}
+
+/**
+ * @brief Получить содержимое карточки
+ *
+ * Источник читается без мьютекса, поэтому промах не задерживает
+ * попадания других потоков. Если карточку за это время забыли
+ * (invalidate(), clear()), прочитанное содержимое не кэшируется.
+ * Содержимое дороже всего кэша возвращается, но не кэшируется.
+ */
+CardContent CardContentCache::content(int cardId, bool *found)
+{
+    QMutexLocker locker(&mutex);
+
+    if (const CardContent *cached = cache.object(cardId)) {
+        ++counters.hits;
+        if (found) {
+            *found = true;
+        }
+        return *cached;
+    }
+
+    ++counters.misses;
+    const quint64 generation = invalidations;
+    locker.unlock();
+
+    CardContent loaded;
+    const bool fetched = source && source->fetchContent(cardId, loaded);
+    if (found) {
+        *found = fetched;
+    }
+
+    locker.relock();
+    if (!fetched) {
+        ++counters.failures;
+        return CardContent();
+    }
+
+    const qsizetype cost = loaded.memoryCost();
+    if (generation == invalidations && cost <= cache.maxCost()) {
+        cache.insert(cardId, new CardContent(loaded), cost);
+    }
+    return loaded;
+}
+
+bool CardContentCache::forEachText(int deckId, const CardContentSource::TextVisitor &visit)
+{
+    return source && source->forEachText(deckId, visit);
+}
+
+bool CardContentCache::contains(int cardId) const
+{
+    QMutexLocker locker(&mutex);
+    return cache.contains(cardId);
+}
+
+void CardContentCache::invalidate(int cardId)
+{
+    QMutexLocker locker(&mutex);
+    ++invalidations;
+    cache.remove(cardId);
+}
+
+void CardContentCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    ++invalidations;
+    cache.clear();
+}
+
+qsizetype CardContentCache::totalCost() const
+{
+    QMutexLocker locker(&mutex);
+    return cache.totalCost();
+}
+
+qsizetype CardContentCache::capacity() const
+{
+    QMutexLocker locker(&mutex);
+    return cache.maxCost();
+}
+
+void CardContentCache::setCapacity(qsizetype capacityBytes)
+{
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(capacityBytes);
+}
+
+CardContentCache::Stats CardContentCache::stats() const
+{
+    QMutexLocker locker(&mutex);
+    return counters;
+}
+
+void CardContentCache::resetStats()
+{
+    QMutexLocker locker(&mutex);
+    counters = Stats();
+}
@@ -0,0 +1,558 @@
+#include "CardExporter.h"
+#include "Deck.h"
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QSaveFile>
+#include <QThread>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+/// Сигнатура двоичного формата
+constexpr char kBinaryMagic[4] = {'Q', 'C', 'E', 'X'};
+
+/// Сигнатура сжатого потока
+constexpr char kDeflateMagic[4] = {'Q', 'C', 'Z', '1'};
+
+/// Проверять отмену раз в столько карточек
+constexpr int kCancelCheckInterval = 1024;
+
+const char *const kCsvHeader[] = {
+    "id", "deck_id", "question", "answer", "content_type", "test_mode",
+    "easy_factor", "interval_days", "repetitions", "next_review", "last_review"
+};
+
+/**
+ * @brief Поля фиксированной ширины записи двоичного формата
+ *
+ * За ними следуют questionBytes и answerBytes байт текста в UTF-8.
+ */
+struct BinaryRecord {
+    qint32 id;
+    qint32 deckId;
+    float easyFactor;
+    qint32 intervalDays;
+    qint32 repetitions;
+    quint8 contentType;
+    quint8 testMode;
+    quint16 reserved;
+    qint64 nextReview;              ///< Мс от эпохи или CardStore::kNoDate
+    qint64 lastReview;              ///< Мс от эпохи или CardStore::kNoDate
+    quint32 questionBytes;
+    quint32 answerBytes;
+};
+
+const char *contentTypeName(ContentType type)
+{
+    switch (type) {
+    case ContentType::Image: return "image";
+    case ContentType::Audio: return "audio";
+    default: return "text";
+    }
+}
+
+const char *testModeName(TestMode mode)
+{
+    switch (mode) {
+    case TestMode::MultipleChoice: return "multiple_choice";
+    case TestMode::Matching: return "matching";
+    default: return "direct";
+    }
+}
+
+template<typename T>
+void appendNumber(QByteArray &out, T value)
+{
+    char digits[32];
+    const std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end.ptr - digits);
+}
+
+void appendCsvField(QByteArray &out, const QByteArray &text, char delimiter)
+{
+    bool quoted = false;
+    for (const char c : text) {
+        if (c == delimiter || c == '"' || c == '\n' || c == '\r') {
+            quoted = true;
+            break;
+        }
+    }
+    if (!quoted) {
+        out += text;
+        return;
+    }
+    out += '"';
+    for (const char c : text) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+void appendJsonString(QByteArray &out, const QByteArray &text)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (const char c : text) {
+        const uchar u = static_cast<uchar>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (u < 0x20) {
+            out += "\\u00";
+            out += hex[u >> 4];
+            out += hex[u & 0xf];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void appendJsonDate(QByteArray &out, qint64 msecs)
+{
+    if (msecs == CardStore::kNoDate) {
+        out += "null";
+    } else {
+        appendNumber(out, msecs);
+    }
+}
+
+void appendCsvDate(QByteArray &out, qint64 msecs)
+{
+    if (msecs != CardStore::kNoDate) {
+        appendNumber(out, msecs);
+    }
+}
+
+/**
+ * @brief Буфер вывода со сжатием блоков
+ */
+class BlockWriter
+{
+public:
+    BlockWriter(QIODevice &device, const CardExporter::Options &options, CardExporter::Result &summary)
+        : device(device), options(options), summary(summary)
+    {
+        buffer.reserve(options.bufferBytes + options.bufferBytes / 8);
+    }
+
+    QByteArray &data() { return buffer; }
+
+    bool isFull() const { return buffer.size() >= options.bufferBytes; }
+
+    /**
+     * @brief Записать сигнатуру сжатого потока
+     */
+    bool begin()
+    {
+        if (options.compression == CardExporter::Compression::None) {
+            return true;
+        }
+        return write(kDeflateMagic, sizeof(kDeflateMagic));
+    }
+
+    /**
+     * @brief Записать накопленный буфер (сжатым блоком при необходимости)
+     */
+    bool flush()
+    {
+        if (buffer.isEmpty()) {
+            return true;
+        }
+        summary.rawBytes += buffer.size();
+        qint64 peak = buffer.capacity();
+        bool ok;
+        if (options.compression == CardExporter::Compression::Deflate) {
+            const QByteArray block = qCompress(buffer, options.compressionLevel);
+            const quint32 blockSize = static_cast<quint32>(block.size());
+            peak += block.size();
+            ok = write(reinterpret_cast<const char *>(&blockSize), sizeof(blockSize))
+                 && write(block.constData(), block.size());
+        } else {
+            ok = write(buffer.constData(), buffer.size());
+        }
+        summary.peakBufferBytes = qMax(summary.peakBufferBytes, peak);
+        buffer.resize(0);
+        return ok;
+    }
+
+private:
+    bool write(const char *bytes, qint64 size)
+    {
+        if (device.write(bytes, size) != size) {
+            return false;
+        }
+        summary.bytesWritten += size;
+        return true;
+    }
+
+    QIODevice &device;
+    const CardExporter::Options &options;
+    CardExporter::Result &summary;
+    QByteArray buffer;
+};
+
+/**
+ * @brief Сериализовать одну карточку в буфер
+ */
+void appendCard(QByteArray &out, const CardExporter::Options &options, const CardRef &card,
+                const QByteArray &question, const QByteArray &answer)
+{
+    switch (options.format) {
+    case CardExporter::Format::Csv: {
+        const char delimiter = options.delimiter;
+        appendNumber(out, card.getId());
+        out += delimiter;
+        appendNumber(out, card.getDeckId());
+        out += delimiter;
+        appendCsvField(out, question, delimiter);
+        out += delimiter;
+        appendCsvField(out, answer, delimiter);
+        out += delimiter;
+        out += contentTypeName(card.getContentType());
+        out += delimiter;
+        out += testModeName(card.getTestMode());
+        out += delimiter;
+        appendNumber(out, card.getEasyFactor());
+        out += delimiter;
+        appendNumber(out, card.getIntervalDays());
+        out += delimiter;
+        appendNumber(out, card.getRepetitions());
+        out += delimiter;
+        appendCsvDate(out, card.getNextReviewMSecs());
+        out += delimiter;
+        appendCsvDate(out, card.getLastReviewMSecs());
+        out += '\n';
+        break;
+    }
+    case CardExporter::Format::JsonLines:
+        out += "{\"id\":";
+        appendNumber(out, card.getId());
+        out += ",\"deck_id\":";
+        appendNumber(out, card.getDeckId());
+        out += ",\"question\":";
+        appendJsonString(out, question);
+        out += ",\"answer\":";
+        appendJsonString(out, answer);
+        out += ",\"content_type\":\"";
+        out += contentTypeName(card.getContentType());
+        out += "\",\"test_mode\":\"";
+        out += testModeName(card.getTestMode());
+        out += "\",\"easy_factor\":";
+        appendNumber(out, card.getEasyFactor());
+        out += ",\"interval_days\":";
+        appendNumber(out, card.getIntervalDays());
+        out += ",\"repetitions\":";
+        appendNumber(out, card.getRepetitions());
+        out += ",\"next_review\":";
+        appendJsonDate(out, card.getNextReviewMSecs());
+        out += ",\"last_review\":";
+        appendJsonDate(out, card.getLastReviewMSecs());
+        out += "}\n";
+        break;
+    case CardExporter::Format::Binary: {
+        BinaryRecord record;
+        record.id = card.getId();
+        record.deckId = card.getDeckId();
+        record.easyFactor = card.getEasyFactor();
+        record.intervalDays = card.getIntervalDays();
+        record.repetitions = card.getRepetitions();
+        record.contentType = static_cast<quint8>(card.getContentType());
+        record.testMode = static_cast<quint8>(card.getTestMode());
+        record.reserved = 0;
+        record.nextReview = card.getNextReviewMSecs();
+        record.lastReview = card.getLastReviewMSecs();
+        record.questionBytes = static_cast<quint32>(question.size());
+        record.answerBytes = static_cast<quint32>(answer.size());
+        out.append(reinterpret_cast<const char *>(&record), sizeof(record));
+        out += question;
+        out += answer;
+        break;
+    }
+    }
+}
+
+} // namespace
+
+double CardExporter::Result::megabytesPerSecond() const
+{
+    return rawBytes / (1024.0 * 1024.0) / (qMax<qint64>(1, elapsedMSecs) / 1000.0);
+}
+
+CardExporter::CardExporter() : CardExporter(Options()) {}
+
+CardExporter::CardExporter(const Options &options) : options(options)
+{
+    this->options.bufferBytes = qMax(4096, options.bufferBytes);
+}
+
+CardExporter::~CardExporter()
+{
+    cancel();
+    wait();
+}
+
+void CardExporter::setProgressCallback(ProgressCallback callback)
+{
+    progressCallback = std::move(callback);
+}
+
+bool CardExporter::exportDecks(const QList<Deck> &decks, QIODevice &device)
+{
+    QList<const Deck *> pointers;
+    pointers.reserve(decks.size());
+    for (const Deck &deck : decks) {
+        pointers.append(&deck);
+    }
+    return writeDecks(pointers, device);
+}
+
+bool CardExporter::exportDeck(const Deck &deck, QIODevice &device)
+{
+    return writeDecks({&deck}, device);
+}
+
+bool CardExporter::exportFile(const QList<Deck> &decks, const QString &path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        summary = Result();
+        return fail(file.errorString());
+    }
+    if (!exportDecks(decks, file)) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        return fail(file.errorString());
+    }
+    return true;
+}
+
+/**
+ * @brief Записать колоды подряд
+ *
+ * Текст берется из хранилища колоды без копирования; у колоды без
+ * текста (setMetadataOnly) - из кэша содержимого.
+ */
+bool CardExporter::writeDecks(const QList<const Deck *> &decks, QIODevice &device)
+{
+    summary = Result();
+    errorText.clear();
+    canceled.store(false, std::memory_order_relaxed);
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 totalCards = 0;
+    for (const Deck *deck : decks) {
+        totalCards += deck->getCardCount();
+    }
+
+    BlockWriter writer(device, options, summary);
+    if (!writer.begin()) {
+        return fail(device.errorString());
+    }
+
+    QByteArray &buffer = writer.data();
+    switch (options.format) {
+    case Format::Csv:
+        for (const char *name : kCsvHeader) {
+            if (name != kCsvHeader[0]) {
+                buffer += options.delimiter;
+            }
+            buffer += name;
+        }
+        buffer += '\n';
+        break;
+    case Format::Binary:
+        buffer.append(kBinaryMagic, sizeof(kBinaryMagic));
+        buffer.append(reinterpret_cast<const char *>(&kBinaryVersion), sizeof(kBinaryVersion));
+        break;
+    case Format::JsonLines:
+        break;
+    }
+
+    for (const Deck *deck : decks) {
+        const CardSpan cards = deck->getCardsView();
+        const bool textStored = !deck->isMetadataOnly();
+        for (const CardRef card : cards) {
+            if (textStored) {
+                appendCard(buffer, options, card, card.questionView().toUtf8(), card.answerView().toUtf8());
+            } else {
+                const CardContent content = deck->getContent(card.getId());
+                appendCard(buffer, options, card, content.question.toUtf8(), content.answer.toUtf8());
+            }
+            ++summary.cards;
+
+            if (summary.cards % kCancelCheckInterval == 0 && canceled.load(std::memory_order_relaxed)) {
+                summary.canceled = true;
+                summary.elapsedMSecs = timer.elapsed();
+                return fail(QStringLiteral("Export canceled"));
+            }
+            if (writer.isFull()) {
+                if (!writer.flush()) {
+                    return fail(device.errorString());
+                }
+                if (progressCallback) {
+                    progressCallback(summary.cards, totalCards);
+                }
+            }
+        }
+    }
+
+    if (canceled.load(std::memory_order_relaxed)) {
+        summary.canceled = true;
+        summary.elapsedMSecs = timer.elapsed();
+        return fail(QStringLiteral("Export canceled"));
+    }
+    if (!writer.flush()) {
+        return fail(device.errorString());
+    }
+    if (progressCallback) {
+        progressCallback(summary.cards, totalCards);
+    }
+    summary.elapsedMSecs = timer.elapsed();
+    return true;
+}
+
+// ==================== BACKGROUND ====================
+
+bool CardExporter::start(const QList<Deck> &decks, const QString &path)
+{
+    if (worker) {
+        return fail(QStringLiteral("Export is already running"));
+    }
+    canceled.store(false);
+    workerOk = false;
+    const QList<Deck> *source = &decks;
+    worker = QThread::create([this, source, path]() { workerOk = exportFile(*source, path); });
+    worker->start();
+    return true;
+}
+
+bool CardExporter::wait()
+{
+    if (!worker) {
+        return true;
+    }
+    worker->wait();
+    delete worker;
+    worker = nullptr;
+    return workerOk;
+}
+
+bool CardExporter::isRunning() const
+{
+    return worker && worker->isRunning();
+}
+
+void CardExporter::cancel()
+{
+    canceled.store(true);
+}
+
+const CardExporter::Result &CardExporter::result() const
+{
+    return summary;
+}
+
+QString CardExporter::lastError() const
+{
+    return errorText;
+}
+
+bool CardExporter::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
+
+// ==================== READING ====================
+
+bool CardExporter::decompress(QIODevice &in, QIODevice &out, QString *errorMessage)
+{
+    auto failed = [errorMessage](const QString &message) {
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+
+    if (in.read(sizeof(kDeflateMagic)) != QByteArray(kDeflateMagic, sizeof(kDeflateMagic))) {
+        return failed(QStringLiteral("Not a compressed export stream"));
+    }
+    for (;;) {
+        const QByteArray sizeBytes = in.read(sizeof(quint32));
+        if (sizeBytes.isEmpty()) {
+            return true;
+        }
+        quint32 blockSize = 0;
+        if (sizeBytes.size() != sizeof(blockSize)) {
+            return failed(QStringLiteral("Truncated block header"));
+        }
+        std::memcpy(&blockSize, sizeBytes.constData(), sizeof(blockSize));
+        const QByteArray block = in.read(blockSize);
+        if (block.size() != qsizetype(blockSize)) {
+            return failed(QStringLiteral("Truncated block"));
+        }
+        const QByteArray data = qUncompress(block);
+        if (data.isEmpty()) {
+            return failed(QStringLiteral("Corrupted block"));
+        }
+        if (out.write(data) != data.size()) {
+            return failed(out.errorString());
+        }
+    }
+}
+
+bool CardExporter::readBinary(QIODevice &device, QList<Card> &cards, QString *errorMessage)
+{
+    auto failed = [errorMessage](const QString &message) {
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return false;
+    };
+
+    const QByteArray header = device.read(sizeof(kBinaryMagic) + sizeof(kBinaryVersion));
+    quint32 version = 0;
+    if (header.size() != qsizetype(sizeof(kBinaryMagic) + sizeof(version))
+        || std::memcmp(header.constData(), kBinaryMagic, sizeof(kBinaryMagic)) != 0) {
+        return failed(QStringLiteral("Not a binary card export"));
+    }
+    std::memcpy(&version, header.constData() + sizeof(kBinaryMagic), sizeof(version));
+    if (version != kBinaryVersion) {
+        return failed(QString("Unsupported export version %1").arg(version));
+    }
+
+    BinaryRecord record;
+    for (;;) {
+        const qint64 read = device.read(reinterpret_cast<char *>(&record), sizeof(record));
+        if (read == 0) {
+            return true;
+        }
+        if (read != qint64(sizeof(record))) {
+            return failed(QStringLiteral("Truncated record"));
+        }
+        const QByteArray question = device.read(record.questionBytes);
+        const QByteArray answer = device.read(record.answerBytes);
+        if (question.size() != qsizetype(record.questionBytes) || answer.size() != qsizetype(record.answerBytes)) {
+            return failed(QStringLiteral("Truncated record text"));
+        }
+        cards.append(Card(record.id, QString::fromUtf8(question), QString::fromUtf8(answer),
+                          static_cast<ContentType>(record.contentType), static_cast<TestMode>(record.testMode),
+                          record.easyFactor, record.intervalDays, record.repetitions,
+                          CardStore::fromEpochMSecs(record.nextReview), CardStore::fromEpochMSecs(record.lastReview),
+                          record.deckId));
+    }
+}
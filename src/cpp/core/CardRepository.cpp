@@ -0,0 +1,570 @@
+#include "CardRepository.h"
+#include "CardStore.h"
+#include "Database.h"
+#include "SearchIndex.h"
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace {
+
+/// Столбцы карточки в порядке чтения readCards()
+const QString kSelectColumns =
+    "SELECT id, question, answer, content_type, test_mode, easy_factor,"
+    " interval_days, repetitions, next_review, last_review, deck_id FROM cards ";
+
+/// Столбцы карточки без текста в порядке чтения readCards(query, false)
+const QString kSelectMetadataColumns =
+    "SELECT id, content_type, test_mode, easy_factor,"
+    " interval_days, repetitions, next_review, last_review, deck_id FROM cards ";
+
+/// Вставка новой карточки; занятый идентификатор нарушает PRIMARY KEY
+const QString kInsertCard =
+    "INSERT INTO cards (id, deck_id, position, question, answer,"
+    " content_type, test_mode, easy_factor, interval_days, repetitions,"
+    " next_review, last_review) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+/// Вставка карточки без перезаписи текста уже сохраненной строки
+const QString kUpsertMetadata =
+    "INSERT INTO cards (id, deck_id, position, question, answer,"
+    " content_type, test_mode, easy_factor, interval_days, repetitions,"
+    " next_review, last_review) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+    " ON CONFLICT(id) DO UPDATE SET deck_id = excluded.deck_id, position = excluded.position,"
+    " content_type = excluded.content_type, test_mode = excluded.test_mode,"
+    " easy_factor = excluded.easy_factor, interval_days = excluded.interval_days,"
+    " repetitions = excluded.repetitions, next_review = excluded.next_review,"
+    " last_review = excluded.last_review"
+    " WHERE cards.deck_id = excluded.deck_id";
+
+const QString kUpdateScheduling =
+    "UPDATE cards SET easy_factor = ?, interval_days = ?, repetitions = ?,"
+    " next_review = ?, last_review = ? WHERE id = ?";
+
+qint64 nextReviewMSecs(const Card &card) { return CardStore::toEpochMSecs(card.getNextReview()); }
+qint64 nextReviewMSecs(const CardRef &card) { return card.getNextReviewMSecs(); }
+qint64 lastReviewMSecs(const Card &card) { return CardStore::toEpochMSecs(card.getLastReview()); }
+qint64 lastReviewMSecs(const CardRef &card) { return card.getLastReviewMSecs(); }
+
+/**
+ * @brief Привязать значения карточки к запросу kInsertCard
+ *
+ * Работает и с Card, и с CardRef: оба предоставляют одинаковые геттеры.
+ * Фактор легкости передается как double: драйвер QSQLITE привязывает
+ * float текстом.
+ */
+template<typename CardLike>
+void bindCard(QSqlQuery &query, const CardLike &card, int deckId, int position)
+{
+    query.bindValue(0, card.getId());
+    query.bindValue(1, deckId);
+    query.bindValue(2, position);
+    query.bindValue(3, card.getQuestion());
+    query.bindValue(4, card.getAnswer());
+    query.bindValue(5, static_cast<int>(card.getContentType()));
+    query.bindValue(6, static_cast<int>(card.getTestMode()));
+    query.bindValue(7, static_cast<double>(card.getEasyFactor()));
+    query.bindValue(8, card.getIntervalDays());
+    query.bindValue(9, card.getRepetitions());
+    query.bindValue(10, nextReviewMSecs(card));
+    query.bindValue(11, lastReviewMSecs(card));
+}
+
+} // namespace
+
+CardRepository::CardRepository(const QSqlDatabase &database) : database(database) {}
+
+/**
+ * @brief Добавить карточки в конец колоды одной транзакцией
+ *
+ * Позиции продолжают последнюю сохраненную позицию колоды; максимум
+ * берется из индекса (deck_id, position) без чтения таблицы.
+ */
+bool CardRepository::insertCards(int deckId, const QList<Card> &cards)
+{
+    return Database::inTransaction(database, &errorText, [&]() {
+        QSqlQuery query(database);
+        if (!prepare(query, "SELECT COALESCE(MAX(position) + 1, 0) FROM cards WHERE deck_id = ?")) {
+            return false;
+        }
+        query.addBindValue(deckId);
+        if (!exec(query) || !query.next()) {
+            return false;
+        }
+        const int firstPosition = query.value(0).toInt();
+        return writeCards(deckId, cards, firstPosition);
+    });
+}
+
+bool CardRepository::writeCards(int deckId, const QList<Card> &cards, int firstPosition)
+{
+    QSqlQuery query(database);
+    if (!prepare(query, kInsertCard)) {
+        return false;
+    }
+    for (int i = 0; i < cards.size(); ++i) {
+        bindCard(query, cards[i], deckId, firstPosition + i);
+        if (!exec(query)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CardRepository::writeCards(int deckId, CardSpan cards, int firstPosition)
+{
+    QSqlQuery query(database);
+    if (!prepare(query, kInsertCard)) {
+        return false;
+    }
+    for (auto it = cards.begin(); it != cards.end(); ++it) {
+        bindCard(query, *it, deckId, firstPosition + it.row());
+        if (!exec(query)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Заменить карточки колоды, не трогая сохраненный текст
+ *
+ * Прежние строки колоды помечаются отрицательной позицией; строки,
+ * которые остались в колоде, получают обычную позицию при вставке
+ * с ON CONFLICT, а помеченными остаются только удаленные карточки.
+ * Карточка другой колоды с тем же идентификатором не переносится:
+ * вставка ничего не меняет, и запись завершается ошибкой.
+ */
+bool CardRepository::writeDeckMetadata(int deckId, CardSpan cards)
+{
+    QSqlQuery mark(database);
+    if (!prepare(mark, "UPDATE cards SET position = -1 - position WHERE deck_id = ?")) {
+        return false;
+    }
+    mark.addBindValue(deckId);
+    if (!exec(mark)) {
+        return false;
+    }
+
+    QSqlQuery query(database);
+    if (!prepare(query, kUpsertMetadata)) {
+        return false;
+    }
+    for (auto it = cards.begin(); it != cards.end(); ++it) {
+        bindCard(query, *it, deckId, it.row());
+        if (!exec(query)) {
+            return false;
+        }
+        if (query.numRowsAffected() == 0) {
+            errorText = QString("Card %1 belongs to another deck").arg((*it).getId());
+            return false;
+        }
+    }
+
+    QSqlQuery media(database);
+    if (!prepare(media, "DELETE FROM card_media WHERE card_id IN"
+                        " (SELECT id FROM cards WHERE deck_id = ? AND position < 0)")) {
+        return false;
+    }
+    media.addBindValue(deckId);
+    if (!exec(media)) {
+        return false;
+    }
+    QSqlQuery stale(database);
+    if (!prepare(stale, "DELETE FROM cards WHERE deck_id = ? AND position < 0")) {
+        return false;
+    }
+    stale.addBindValue(deckId);
+    return exec(stale);
+}
+
+bool CardRepository::updateScheduling(CardSpan cards)
+{
+    return Database::inTransaction(database, &errorText, [&]() {
+        return writeScheduling(cards);
+    });
+}
+
+bool CardRepository::applyReviews(const QList<ReviewRecord> &records)
+{
+    return Database::inTransaction(database, &errorText, [&]() {
+        QSqlQuery query(database);
+        if (!prepare(query, kUpdateScheduling)) {
+            return false;
+        }
+        for (const ReviewRecord &record : records) {
+            query.bindValue(0, static_cast<double>(record.easyFactor));
+            query.bindValue(1, record.intervalDays);
+            query.bindValue(2, record.repetitions);
+            query.bindValue(3, record.nextReview);
+            query.bindValue(4, record.reviewedAt);
+            query.bindValue(5, record.cardId);
+            if (!exec(query)) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+/**
+ * @brief Обновить поля планирования внутри уже открытой транзакции
+ *
+ * Один подготовленный запрос выполняется для каждой карточки; даты
+ * берутся из столбцов хранилища без построения QDateTime.
+ */
+bool CardRepository::writeScheduling(CardSpan cards)
+{
+    QSqlQuery query(database);
+    if (!prepare(query, kUpdateScheduling)) {
+        return false;
+    }
+    for (const CardRef &card : cards) {
+        query.bindValue(0, static_cast<double>(card.getEasyFactor()));
+        query.bindValue(1, card.getIntervalDays());
+        query.bindValue(2, card.getRepetitions());
+        query.bindValue(3, card.getNextReviewMSecs());
+        query.bindValue(4, card.getLastReviewMSecs());
+        query.bindValue(5, card.getId());
+        if (!exec(query)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CardRepository::removeCard(int cardId)
+{
+    QSqlQuery media(database);
+    if (!prepare(media, "DELETE FROM card_media WHERE card_id = ?")) {
+        return false;
+    }
+    media.addBindValue(cardId);
+    if (!exec(media)) {
+        return false;
+    }
+
+    QSqlQuery query(database);
+    if (!prepare(query, "DELETE FROM cards WHERE id = ?")) {
+        return false;
+    }
+    query.addBindValue(cardId);
+    return exec(query) && query.numRowsAffected() > 0;
+}
+
+bool CardRepository::saveMedia(int cardId, const QByteArray &data)
+{
+    QSqlQuery query(database);
+    if (!prepare(query, "INSERT OR REPLACE INTO card_media (card_id, data) VALUES (?, ?)")) {
+        return false;
+    }
+    query.addBindValue(cardId);
+    query.addBindValue(data);
+    return exec(query);
+}
+
+bool CardRepository::saveMedia(const QHash<int, QByteArray> &media)
+{
+    return Database::inTransaction(database, &errorText, [&]() {
+        QSqlQuery query(database);
+        if (!prepare(query, "INSERT OR REPLACE INTO card_media (card_id, data) VALUES (?, ?)")) {
+            return false;
+        }
+        for (auto it = media.constBegin(); it != media.constEnd(); ++it) {
+            query.bindValue(0, it.key());
+            query.bindValue(1, it.value());
+            if (!exec(query)) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+bool CardRepository::removeDeckMedia(int deckId)
+{
+    QSqlQuery query(database);
+    if (!prepare(query, "DELETE FROM card_media WHERE card_id IN"
+                        " (SELECT id FROM cards WHERE deck_id = ?)")) {
+        return false;
+    }
+    query.addBindValue(deckId);
+    return exec(query);
+}
+
+/**
+ * @brief Удалить медиаданные карточек, которые покидают колоду
+ *
+ * Просматриваются только медиаданные колоды, а не все её карточки.
+ */
+bool CardRepository::removeDroppedMedia(int deckId, CardSpan cards)
+{
+    QSet<int> kept;
+    kept.reserve(cards.size());
+    for (const CardRef card : cards) {
+        kept.insert(card.getId());
+    }
+
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, "SELECT m.card_id FROM card_media m"
+                        " JOIN cards c ON c.id = m.card_id WHERE c.deck_id = ?")) {
+        return false;
+    }
+    query.addBindValue(deckId);
+    if (!exec(query)) {
+        return false;
+    }
+    QList<int> dropped;
+    while (query.next()) {
+        const int cardId = query.value(0).toInt();
+        if (!kept.contains(cardId)) {
+            dropped.append(cardId);
+        }
+    }
+    query.finish();
+
+    QSqlQuery remove(database);
+    if (!prepare(remove, "DELETE FROM card_media WHERE card_id = ?")) {
+        return false;
+    }
+    for (int cardId : std::as_const(dropped)) {
+        remove.bindValue(0, cardId);
+        if (!exec(remove)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CardRepository::removeDeckCards(int deckId)
+{
+    QSqlQuery query(database);
+    if (!prepare(query, "DELETE FROM cards WHERE deck_id = ?")) {
+        return false;
+    }
+    query.addBindValue(deckId);
+    return exec(query);
+}
+
+/**
+ * @brief Загрузить все карточки колоды в исходном порядке
+ *
+ * Порядок дает индекс (deck_id, position), поэтому SQLite не сортирует
+ * результат. Запрос только вперед (forward-only) не кэширует строки.
+ */
+QList<Card> CardRepository::loadDeckCards(int deckId)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, kSelectColumns + "WHERE deck_id = ? ORDER BY position")) {
+        return {};
+    }
+    query.addBindValue(deckId);
+    if (!exec(query)) {
+        return {};
+    }
+    return readCards(query);
+}
+
+/**
+ * @brief Загрузить карточки колоды без текста
+ *
+ * Столбцы question и answer не читаются вовсе, поэтому SQLite не копирует
+ * текст, а Card не выделяет под него память.
+ */
+QList<Card> CardRepository::loadDeckMetadata(int deckId)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, kSelectMetadataColumns + "WHERE deck_id = ? ORDER BY position")) {
+        return {};
+    }
+    query.addBindValue(deckId);
+    if (!exec(query)) {
+        return {};
+    }
+    return readCards(query, false);
+}
+
+/**
+ * @brief Прочитать текст и медиаданные одной карточки
+ *
+ * Один запрос по первичному ключу; медиаданные присоединяются
+ * только для нетекстовых карточек.
+ */
+bool CardRepository::fetchContent(int cardId, CardContent &content)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, "SELECT c.question, c.answer, m.data FROM cards c"
+                        " LEFT JOIN card_media m ON m.card_id = c.id AND c.content_type <> ?"
+                        " WHERE c.id = ?")) {
+        return false;
+    }
+    query.addBindValue(static_cast<int>(ContentType::Text));
+    query.addBindValue(cardId);
+    if (!exec(query) || !query.next()) {
+        return false;
+    }
+
+    content.question = query.value(0).toString();
+    content.answer = query.value(1).toString();
+    content.media = query.value(2).toByteArray();
+    return true;
+}
+
+bool CardRepository::forEachText(int deckId, const TextVisitor &visit)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, "SELECT id, question, answer FROM cards WHERE deck_id = ? ORDER BY position")) {
+        return false;
+    }
+    query.addBindValue(deckId);
+    if (!exec(query)) {
+        return false;
+    }
+    while (query.next()) {
+        visit(query.value(0).toInt(), query.value(1).toString(), query.value(2).toString());
+    }
+    return true;
+}
+
+/**
+ * @brief Загрузить карточки, готовые к повторению
+ *
+ * Условие `deck_id = ? AND next_review <= ?` и порядок по next_review
+ * целиком обслуживаются индексом (deck_id, next_review): SQLite читает
+ * только готовые строки. Карточки без даты хранят kNoDate и попадают
+ * в начало диапазона.
+ */
+QList<Card> CardRepository::loadDueCards(int deckId, qint64 nowMSecs, int limit)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, kSelectColumns + "WHERE deck_id = ? AND next_review <= ?"
+                                         " ORDER BY next_review LIMIT ?")) {
+        return {};
+    }
+    query.addBindValue(deckId);
+    query.addBindValue(nowMSecs);
+    query.addBindValue(limit);
+    if (!exec(query)) {
+        return {};
+    }
+    return readCards(query);
+}
+
+int CardRepository::countDueCards(int deckId, qint64 nowMSecs)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, "SELECT COUNT(*) FROM cards WHERE deck_id = ? AND next_review <= ?")) {
+        return -1;
+    }
+    query.addBindValue(deckId);
+    query.addBindValue(nowMSecs);
+    if (!exec(query) || !query.next()) {
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+/**
+ * @brief Первый свободный идентификатор карточки
+ *
+ * MAX по первичному ключу читает последнюю запись B-дерева, а не всю таблицу.
+ */
+int CardRepository::nextCardId()
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!prepare(query, "SELECT COALESCE(MAX(id), 0) + 1 FROM cards")) {
+        return -1;
+    }
+    if (!exec(query) || !query.next()) {
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+/**
+ * @brief Найти карточки через FTS5
+ *
+ * Таблица cards_fts хранит только словарь и списки вхождений
+ * (external content), а совпадения отдаются идентификаторами карточек
+ * (rowid), поэтому сами строки cards не читаются.
+ */
+QList<int> CardRepository::search(const QString &query, int limit)
+{
+    const QString match = SearchIndex::toFts5Query(query);
+    if (match.isEmpty() || limit == 0) {
+        return {};
+    }
+
+    if (!Database::hasFullTextSearch(database)) {
+        errorText = QStringLiteral("Full-text search is not enabled for this database");
+        return {};
+    }
+
+    QSqlQuery select(database);
+    select.setForwardOnly(true);
+    if (!prepare(select, "SELECT rowid FROM cards_fts WHERE cards_fts MATCH ? ORDER BY rowid LIMIT ?")) {
+        return {};
+    }
+    select.addBindValue(match);
+    select.addBindValue(limit);
+    if (!exec(select)) {
+        return {};
+    }
+    QList<int> ids;
+    while (select.next()) {
+        ids.append(select.value(0).toInt());
+    }
+    return ids;
+}
+
+QString CardRepository::lastError() const
+{
+    return errorText;
+}
+
+QList<Card> CardRepository::readCards(QSqlQuery &query, bool withText)
+{
+    QList<Card> cards;
+    // Без текста столбцы question и answer отсутствуют, остальные сдвинуты на 2
+    const int shift = withText ? 0 : 2;
+    while (query.next()) {
+        cards.append(Card(query.value(0).toInt(),
+                          withText ? query.value(1).toString() : QString(),
+                          withText ? query.value(2).toString() : QString(),
+                          static_cast<ContentType>(query.value(3 - shift).toInt()),
+                          static_cast<TestMode>(query.value(4 - shift).toInt()),
+                          query.value(5 - shift).toFloat(),
+                          query.value(6 - shift).toInt(),
+                          query.value(7 - shift).toInt(),
+                          CardStore::fromEpochMSecs(query.value(8 - shift).toLongLong()),
+                          CardStore::fromEpochMSecs(query.value(9 - shift).toLongLong()),
+                          query.value(10 - shift).toInt()));
+    }
+    return cards;
+}
+
+bool CardRepository::prepare(QSqlQuery &query, const QString &sql)
+{
+    if (!query.prepare(sql)) {
+        errorText = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool CardRepository::exec(QSqlQuery &query)
+{
+    if (!query.exec()) {
+        errorText = query.lastError().text();
+        return false;
+    }
+    return true;
+}
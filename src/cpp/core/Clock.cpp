@@ -0,0 +1,97 @@
+#include "Clock.h"
+#include <QMutexLocker>
+
+/**
+ * @brief Общие системные часы процесса
+ *
+ * Экземпляр создается при первом обращении и живет до конца процесса,
+ * поэтому указатели на него безопасно хранить в колодах.
+ */
+const Clock &Clock::system()
+{
+    static const SystemClock clock;
+    return clock;
+}
+
+QDateTime SystemClock::now() const
+{
+    return QDateTime::currentDateTime();
+}
+
+qint64 SystemClock::nowMSecs() const
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+FixedClock::FixedClock(const QDateTime &now) : current(now) {}
+
+QDateTime FixedClock::now() const
+{
+    QMutexLocker locker(&mutex);
+    return current;
+}
+
+qint64 FixedClock::nowMSecs() const
+{
+    QMutexLocker locker(&mutex);
+    return current.toMSecsSinceEpoch();
+}
+
+void FixedClock::setNow(const QDateTime &now)
+{
+    QMutexLocker locker(&mutex);
+    current = now;
+}
+
+void FixedClock::advance(qint64 msecs)
+{
+    QMutexLocker locker(&mutex);
+    current = current.addMSecs(msecs);
+}
+
+void FixedClock::advanceDays(int days)
+{
+    QMutexLocker locker(&mutex);
+    current = current.addDays(days);
+}
+
+CachedClock::CachedClock(qint64 resolutionMSecs) : resolution(resolutionMSecs)
+{
+    resync();
+}
+
+/**
+ * @brief Текущий момент в локальном времени
+ *
+ * Кэш пересобирается не чаще одного раза за resolution миллисекунд;
+ * между пересборками вызов стоит одного захвата мьютекса без конкуренции.
+ */
+QDateTime CachedClock::now() const
+{
+    const qint64 msecs = nowMSecs();
+
+    QMutexLocker locker(&mutex);
+    if (!cached.isValid() || msecs - cachedMSecs >= resolution || msecs < cachedMSecs) {
+        cached = QDateTime::fromMSecsSinceEpoch(msecs);
+        cachedMSecs = msecs;
+    }
+    return cached;
+}
+
+qint64 CachedClock::nowMSecs() const
+{
+    return baseMSecs.load(std::memory_order_relaxed) + timer.elapsed();
+}
+
+/**
+ * @brief Заново синхронизироваться с системным временем
+ * @warning Не вызывайте одновременно с чтением часов из других потоков
+ */
+void CachedClock::resync()
+{
+    baseMSecs.store(QDateTime::currentMSecsSinceEpoch(), std::memory_order_relaxed);
+    timer.start();
+
+    QMutexLocker locker(&mutex);
+    cached = QDateTime();
+}
@@ -0,0 +1,706 @@
+#include "CollectionSnapshot.h"
+#include <QSaveFile>
+#include <QSet>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace {
+
+/// Сигнатура файла снимка
+constexpr char kMagic[4] = {'Q', 'C', 'S', 'N'};
+
+/**
+ * @brief Разделы файла в порядке расположения
+ *
+ * Столбцы карточек идут в порядке строк снимка, карточки одной колоды
+ * лежат подряд.
+ */
+enum Section {
+    Decks,              ///< DeckEntry на колоду
+    Ids,                ///< qint32 на карточку
+    DeckIds,            ///< qint32 на карточку
+    ContentTypes,       ///< ContentType (4 байта) на карточку
+    TestModes,          ///< TestMode (4 байта) на карточку
+    EasyFactors,        ///< float на карточку
+    Intervals,          ///< qint32 на карточку
+    Repetitions,        ///< qint32 на карточку
+    NextReviews,        ///< qint64 на карточку (мс от эпохи или kNoDate)
+    LastReviews,        ///< qint64 на карточку (мс от эпохи или kNoDate)
+    Questions,          ///< quint32 - номер строки вопроса
+    Answers,            ///< quint32 - номер строки ответа
+    DueEntries,         ///< DueIndex::Entry на карточку; строки внутри колоды
+    StringOffsets,      ///< quint64 на строку плюс конец: начала строк в символах
+    StringChars,        ///< UTF-16 символы всех строк подряд
+    SectionCount
+};
+
+struct SectionEntry {
+    quint64 offset;     ///< Смещение от начала файла, кратно 8
+    quint64 size;       ///< Размер в байтах
+    quint64 checksum;   ///< Контрольная сумма содержимого
+};
+
+/**
+ * @brief Заголовок файла
+ *
+ * Поля упорядочены так, что структура не содержит выравнивающих
+ * промежутков и копируется в файл как есть.
+ */
+struct Header {
+    char magic[4];
+    quint32 version;
+    quint32 deckCount;
+    quint32 cardCount;
+    quint32 stringCount;
+    quint32 reserved;
+    SectionEntry sections[SectionCount];
+    quint64 checksum;   ///< Контрольная сумма всех предыдущих полей
+};
+
+static_assert(offsetof(Header, checksum) + sizeof(quint64) == sizeof(Header),
+              "Заголовок снимка не должен содержать промежутков");
+
+struct DeckEntry {
+    qint32 id;
+    quint32 name;       ///< Номер строки названия
+    quint32 firstRow;   ///< Первая строка колоды в столбцах
+    quint32 rowCount;   ///< Количество карточек колоды
+};
+
+static_assert(sizeof(DeckEntry) == 16, "Запись колоды должна иметь фиксированный размер");
+static_assert(sizeof(ContentType) == 4 && sizeof(TestMode) == 4,
+              "Столбцы перечислений копируются из снимка как 32-битные значения");
+static_assert(sizeof(DueIndex::Entry) == 16, "Элемент индекса копируется из снимка как есть");
+
+/// Размер одной записи раздела; 0 - раздел переменной длины
+constexpr quint64 kRecordSize[SectionCount] = {
+    sizeof(DeckEntry), 4, 4, 4, 4, 4, 4, 4, 8, 8, 4, 4, sizeof(DueIndex::Entry), 8, 0
+};
+
+/**
+ * @brief Контрольная сумма Флетчера-64 по 32-битным словам
+ *
+ * В отличие от побайтового CRC (qChecksum) обрабатывает четыре байта
+ * за шаг, поэтому проверка снимка на миллион карточек занимает
+ * миллисекунды. Приведение по модулю выполняется раз в блок слов,
+ * пока суммы не могут переполниться. Хвост короче слова дополняется нулями.
+ */
+quint64 checksum(const uchar *bytes, quint64 size)
+{
+    constexpr quint64 kModulus = 0xFFFFFFFFu;
+    constexpr quint64 kBlockWords = 16384;
+
+    quint64 low = 0;
+    quint64 high = 0;
+    quint64 words = size / 4;
+    while (words > 0) {
+        const quint64 block = std::min(words, kBlockWords);
+        for (quint64 i = 0; i < block; ++i) {
+            quint32 word;
+            std::memcpy(&word, bytes + i * 4, sizeof(word));
+            low += word;
+            high += low;
+        }
+        low %= kModulus;
+        high %= kModulus;
+        bytes += block * 4;
+        words -= block;
+    }
+
+    if (size % 4 != 0) {
+        quint32 word = 0;
+        std::memcpy(&word, bytes, size % 4);
+        low = (low + word) % kModulus;
+        high = (high + low) % kModulus;
+    }
+    return (high << 32) | low;
+}
+
+quint64 headerChecksum(const Header &header)
+{
+    return checksum(reinterpret_cast<const uchar *>(&header), offsetof(Header, checksum));
+}
+
+const Header &headerOf(const uchar *data)
+{
+    return *reinterpret_cast<const Header *>(data);
+}
+
+template<typename T>
+const T *sectionOf(const uchar *data, Section section)
+{
+    return reinterpret_cast<const T *>(data + headerOf(data).sections[section].offset);
+}
+
+/**
+ * @brief Содержимое раздела для записи
+ */
+struct SectionBytes {
+    const void *data = nullptr;
+    quint64 size = 0;
+};
+
+template<typename T>
+SectionBytes bytesOf(const QList<T> &column)
+{
+    return SectionBytes{column.constData(), quint64(column.size()) * sizeof(T)};
+}
+
+/**
+ * @brief Записать заголовок и разделы через QSaveFile
+ *
+ * Заполняет смещения, размеры и контрольные суммы в header. Перед
+ * заменой файла вызывает beforeCommit: к этому моменту все данные уже
+ * во временном файле, и отображение прежнего файла можно снять.
+ */
+bool writeFile(const QString &path, Header &header, const SectionBytes *sections,
+               const std::function<void()> &beforeCommit, QString *errorMessage)
+{
+    quint64 offset = (sizeof(Header) + 7) & ~quint64(7);
+    for (int section = 0; section < SectionCount; ++section) {
+        header.sections[section].offset = offset;
+        header.sections[section].size = sections[section].size;
+        header.sections[section].checksum =
+            checksum(static_cast<const uchar *>(sections[section].data), sections[section].size);
+        offset = (offset + sections[section].size + 7) & ~quint64(7);
+    }
+    header.checksum = headerChecksum(header);
+
+    QSaveFile out(path);
+    bool written = out.open(QIODevice::WriteOnly)
+                && out.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header));
+
+    quint64 position = sizeof(Header);
+    static const char padding[8] = {};
+    for (int section = 0; written && section < SectionCount; ++section) {
+        const qint64 gap = qint64(header.sections[section].offset - position);
+        const qint64 bytes = qint64(sections[section].size);
+        written = out.write(padding, gap) == gap
+               && (bytes == 0 || out.write(static_cast<const char *>(sections[section].data), bytes) == bytes);
+        position = header.sections[section].offset + sections[section].size;
+    }
+
+    if (!written) {
+        if (errorMessage) {
+            *errorMessage = out.errorString();
+        }
+        out.cancelWriting();
+        return false;
+    }
+
+    if (beforeCommit) {
+        beforeCommit();
+    }
+    if (!out.commit()) {
+        if (errorMessage) {
+            *errorMessage = out.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+Header makeHeader(quint32 deckCount, quint32 cardCount, quint32 stringCount)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = CollectionSnapshot::kVersion;
+    header.deckCount = deckCount;
+    header.cardCount = cardCount;
+    header.stringCount = stringCount;
+    return header;
+}
+
+} // namespace
+
+/**
+ * @brief Записать снимок коллекции
+ *
+ * Строки интернируются по значению: одинаковые тексты получают один
+ * номер в разделе строк.
+ */
+bool CollectionSnapshot::write(const QString &path, const QList<Deck> &decks, QString *errorMessage)
+{
+    qint64 totalCards = 0;
+    for (const Deck &deck : decks) {
+        // У колоды без текста в снимок попали бы пустые вопросы и ответы
+        if (deck.isMetadataOnly()) {
+            if (errorMessage) {
+                *errorMessage = QString("Deck %1 has no card text loaded").arg(deck.getId());
+            }
+            return false;
+        }
+        totalCards += deck.store.size();
+    }
+    if (totalCards > std::numeric_limits<int>::max()) {
+        if (errorMessage) {
+            *errorMessage = QString("Collection is too large for a snapshot: %1 cards").arg(totalCards);
+        }
+        return false;
+    }
+    const int cardCount = static_cast<int>(totalCards);
+
+    QHash<QString, quint32> stringIndex;
+    QList<quint64> stringOffsets{0};
+    QString stringChars;
+    auto intern = [&](const QString &text) -> quint32 {
+        auto it = stringIndex.constFind(text);
+        if (it != stringIndex.constEnd()) {
+            return it.value();
+        }
+        const quint32 index = quint32(stringIndex.size());
+        stringIndex.insert(text, index);
+        stringChars.append(text);
+        stringOffsets.append(quint64(stringChars.size()));
+        return index;
+    };
+
+    QList<DeckEntry> deckEntries;
+    QList<qint32> ids, deckIds, intervals, repetitions;
+    QList<ContentType> contentTypes;
+    QList<TestMode> testModes;
+    QList<float> easyFactors;
+    QList<qint64> nextReviews, lastReviews;
+    QList<quint32> questions, answers;
+    QList<DueIndex::Entry> dueEntries;
+    deckEntries.reserve(decks.size());
+    ids.reserve(cardCount);
+    deckIds.reserve(cardCount);
+    intervals.reserve(cardCount);
+    repetitions.reserve(cardCount);
+    contentTypes.reserve(cardCount);
+    testModes.reserve(cardCount);
+    easyFactors.reserve(cardCount);
+    nextReviews.reserve(cardCount);
+    lastReviews.reserve(cardCount);
+    questions.reserve(cardCount);
+    answers.reserve(cardCount);
+    dueEntries.reserve(cardCount);
+
+    for (const Deck &deck : decks) {
+        const CardStore &store = deck.store;
+        deckEntries.append(DeckEntry{deck.getId(), intern(deck.getName()),
+                                     quint32(ids.size()), quint32(store.size())});
+        for (int row = 0; row < store.size(); ++row) {
+            ids.append(store.id(row));
+            deckIds.append(store.deckId(row));
+            contentTypes.append(store.contentType(row));
+            testModes.append(store.testMode(row));
+            easyFactors.append(store.easyFactor(row));
+            intervals.append(store.intervalDays(row));
+            repetitions.append(store.repetitions(row));
+            nextReviews.append(store.nextReviewMSecs(row));
+            lastReviews.append(store.lastReviewMSecs(row));
+            questions.append(intern(store.question(row)));
+            answers.append(intern(store.answer(row)));
+        }
+        for (auto it = deck.dueIndex.begin(); it != deck.dueIndex.end(); ++it) {
+            dueEntries.append(*it);
+        }
+    }
+
+    SectionBytes sections[SectionCount];
+    sections[Decks] = bytesOf(deckEntries);
+    sections[Ids] = bytesOf(ids);
+    sections[DeckIds] = bytesOf(deckIds);
+    sections[ContentTypes] = bytesOf(contentTypes);
+    sections[TestModes] = bytesOf(testModes);
+    sections[EasyFactors] = bytesOf(easyFactors);
+    sections[Intervals] = bytesOf(intervals);
+    sections[Repetitions] = bytesOf(repetitions);
+    sections[NextReviews] = bytesOf(nextReviews);
+    sections[LastReviews] = bytesOf(lastReviews);
+    sections[Questions] = bytesOf(questions);
+    sections[Answers] = bytesOf(answers);
+    sections[DueEntries] = bytesOf(dueEntries);
+    sections[StringOffsets] = bytesOf(stringOffsets);
+    sections[StringChars] = SectionBytes{stringChars.constData(), quint64(stringChars.size()) * sizeof(QChar)};
+
+    Header header = makeHeader(quint32(deckEntries.size()), quint32(cardCount), quint32(stringIndex.size()));
+    return writeFile(path, header, sections, nullptr, errorMessage);
+}
+
+CollectionSnapshot::CollectionSnapshot(const QString &path) : path(path) {}
+
+CollectionSnapshot::~CollectionSnapshot()
+{
+    close();
+}
+
+/**
+ * @brief Отобразить снимок в память только для чтения
+ *
+ * Размер каждого раздела сверяется со счетчиками заголовка, поэтому
+ * после успешного открытия доступ к столбцам не требует проверок границ.
+ */
+bool CollectionSnapshot::open(bool verifyChecksums)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+    size = file.size();
+    if (size < qint64(sizeof(Header))) {
+        close();
+        return fail(QString("%1 is not a collection snapshot").arg(path));
+    }
+    data = file.map(0, size);
+    if (!data) {
+        const QString error = file.errorString();
+        close();
+        return fail(error);
+    }
+
+    const Header &header = headerOf(data);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        close();
+        return fail(QString("%1 is not a collection snapshot").arg(path));
+    }
+    if (header.version != kVersion) {
+        const quint32 version = header.version;
+        close();
+        return fail(QString("Unsupported snapshot version %1").arg(version));
+    }
+    if (header.checksum != headerChecksum(header)) {
+        close();
+        return fail(QString("Snapshot header checksum mismatch in %1").arg(path));
+    }
+
+    for (int section = 0; section < SectionCount; ++section) {
+        const SectionEntry &entry = header.sections[section];
+        quint64 expected = 0;
+        switch (section) {
+        case Decks:
+            expected = quint64(header.deckCount) * kRecordSize[section];
+            break;
+        case StringOffsets:
+            expected = (quint64(header.stringCount) + 1) * kRecordSize[section];
+            break;
+        case StringChars:
+            expected = entry.size;
+            break;
+        default:
+            expected = quint64(header.cardCount) * kRecordSize[section];
+            break;
+        }
+        if (entry.offset % 8 != 0 || entry.size != expected
+            || entry.offset > quint64(size) || entry.size > quint64(size) - entry.offset) {
+            close();
+            return fail(QString("Snapshot section %1 is truncated or malformed").arg(section));
+        }
+        if (verifyChecksums && entry.checksum != checksum(data + entry.offset, entry.size)) {
+            close();
+            return fail(QString("Snapshot section %1 checksum mismatch").arg(section));
+        }
+    }
+
+    const DeckEntry *decks = sectionOf<DeckEntry>(data, Decks);
+    for (quint32 i = 0; i < header.deckCount; ++i) {
+        if (decks[i].firstRow > header.cardCount || decks[i].rowCount > header.cardCount - decks[i].firstRow) {
+            const int deckId = decks[i].id;
+            close();
+            return fail(QString("Snapshot deck %1 is out of range").arg(deckId));
+        }
+        // Строки индекса считаются от начала колоды; load() и applyReviews()
+        // передают их колоде без проверок
+        const DueIndex::Entry *entries = sectionOf<DueIndex::Entry>(data, DueEntries) + decks[i].firstRow;
+        const qint32 rowCount = qint32(decks[i].rowCount);
+        for (qint32 row = 0; row < rowCount; ++row) {
+            if (entries[row].row < 0 || entries[row].row >= rowCount) {
+                const int deckId = decks[i].id;
+                close();
+                return fail(QString("Snapshot due index of deck %1 is malformed").arg(deckId));
+            }
+        }
+    }
+    return true;
+}
+
+void CollectionSnapshot::close()
+{
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+        data = nullptr;
+    }
+    file.close();
+    size = 0;
+    rowById.clear();
+}
+
+bool CollectionSnapshot::isOpen() const
+{
+    return data != nullptr;
+}
+
+QList<int> CollectionSnapshot::deckIds() const
+{
+    QList<int> result;
+    if (!isOpen()) {
+        return result;
+    }
+    const DeckEntry *decks = sectionOf<DeckEntry>(data, Decks);
+    result.reserve(headerOf(data).deckCount);
+    for (quint32 i = 0; i < headerOf(data).deckCount; ++i) {
+        result.append(decks[i].id);
+    }
+    return result;
+}
+
+int CollectionSnapshot::cardCount() const
+{
+    return isOpen() ? int(headerOf(data).cardCount) : 0;
+}
+
+bool CollectionSnapshot::loadDeck(int deckId, Deck &deck)
+{
+    return load(deckId, deck, false);
+}
+
+bool CollectionSnapshot::loadDeckMetadata(int deckId, Deck &deck)
+{
+    return load(deckId, deck, true);
+}
+
+/**
+ * @brief Загрузить колоду с текстом или без
+ *
+ * Интернированные строки декодируются один раз на номер строки; все
+ * карточки с одинаковым текстом получают копии одного QString.
+ */
+bool CollectionSnapshot::load(int deckId, Deck &deck, bool metadataOnly)
+{
+    if (!isOpen()) {
+        return fail("Snapshot is not open");
+    }
+
+    const Header &header = headerOf(data);
+    const DeckEntry *decks = sectionOf<DeckEntry>(data, Decks);
+    const DeckEntry *entry = std::find_if(decks, decks + header.deckCount,
+                                          [deckId](const DeckEntry &e) { return e.id == deckId; });
+    if (entry == decks + header.deckCount) {
+        return fail(QString("Deck %1 not found in snapshot").arg(deckId));
+    }
+
+    const quint32 first = entry->firstRow;
+    const int rows = static_cast<int>(entry->rowCount);
+
+    CardStore::Columns columns;
+    columns.ids = sectionOf<int>(data, Ids) + first;
+    columns.deckIds = sectionOf<int>(data, DeckIds) + first;
+    columns.contentTypes = sectionOf<ContentType>(data, ContentTypes) + first;
+    columns.testModes = sectionOf<TestMode>(data, TestModes) + first;
+    columns.easyFactors = sectionOf<float>(data, EasyFactors) + first;
+    columns.intervals = sectionOf<int>(data, Intervals) + first;
+    columns.repetitions = sectionOf<int>(data, Repetitions) + first;
+    columns.nextReviews = sectionOf<qint64>(data, NextReviews) + first;
+    columns.lastReviews = sectionOf<qint64>(data, LastReviews) + first;
+
+    QList<QString> questions;
+    QList<QString> answers;
+    if (!metadataOnly) {
+        QList<QString> pool(header.stringCount);
+        auto shared = [&](quint32 index) -> QString {
+            if (index >= header.stringCount) {
+                return QString();
+            }
+            if (pool[index].isNull()) {
+                pool[index] = string(index);
+            }
+            return pool[index];
+        };
+        const quint32 *questionIndexes = sectionOf<quint32>(data, Questions) + first;
+        const quint32 *answerIndexes = sectionOf<quint32>(data, Answers) + first;
+        questions.reserve(rows);
+        answers.reserve(rows);
+        for (int row = 0; row < rows; ++row) {
+            questions.append(shared(questionIndexes[row]));
+            answers.append(shared(answerIndexes[row]));
+        }
+    }
+
+    CardStore cards;
+    cards.setTextStored(!metadataOnly);
+    cards.assign(columns, rows, std::move(questions), std::move(answers));
+
+    DueIndex index;
+    index.assign(sectionOf<DueIndex::Entry>(data, DueEntries) + first, rows);
+
+    deck.setId(entry->id);
+    deck.setName(string(entry->name));
+    deck.assignStore(std::move(cards), std::move(index));
+    return true;
+}
+
+bool CollectionSnapshot::fetchContent(int cardId, CardContent &content)
+{
+    const int row = rowOf(cardId);
+    if (row < 0) {
+        return false;
+    }
+    content.question = string(sectionOf<quint32>(data, Questions)[row]);
+    content.answer = string(sectionOf<quint32>(data, Answers)[row]);
+    content.media.clear();
+    return true;
+}
+
+bool CollectionSnapshot::forEachText(int deckId, const TextVisitor &visit)
+{
+    if (!isOpen()) {
+        return fail("Snapshot is not open");
+    }
+
+    const Header &header = headerOf(data);
+    const DeckEntry *decks = sectionOf<DeckEntry>(data, Decks);
+    const DeckEntry *entry = std::find_if(decks, decks + header.deckCount,
+                                          [deckId](const DeckEntry &e) { return e.id == deckId; });
+    if (entry == decks + header.deckCount) {
+        return fail(QString("Deck %1 not found in snapshot").arg(deckId));
+    }
+
+    const int *ids = sectionOf<int>(data, Ids) + entry->firstRow;
+    const quint32 *questions = sectionOf<quint32>(data, Questions) + entry->firstRow;
+    const quint32 *answers = sectionOf<quint32>(data, Answers) + entry->firstRow;
+    for (quint32 row = 0; row < entry->rowCount; ++row) {
+        visit(ids[row], string(questions[row]), string(answers[row]));
+    }
+    return true;
+}
+
+/**
+ * @brief Применить записи журнала повторений
+ *
+ * Столбцы планирования копируются из отображения, изменяются, и новый
+ * файл собирается из них и неизмененных разделов отображения. Индекс
+ * повторений пересчитывается только для колод, чьи карточки изменились.
+ */
+bool CollectionSnapshot::applyReviews(const QList<ReviewRecord> &records)
+{
+    if (!isOpen()) {
+        return fail("Snapshot is not open");
+    }
+    if (records.isEmpty()) {
+        return true;
+    }
+
+    const Header &header = headerOf(data);
+    const quint32 cardCount = header.cardCount;
+    QList<float> easyFactors(sectionOf<float>(data, EasyFactors), sectionOf<float>(data, EasyFactors) + cardCount);
+    QList<qint32> intervals(sectionOf<qint32>(data, Intervals), sectionOf<qint32>(data, Intervals) + cardCount);
+    QList<qint32> repetitions(sectionOf<qint32>(data, Repetitions), sectionOf<qint32>(data, Repetitions) + cardCount);
+    QList<qint64> nextReviews(sectionOf<qint64>(data, NextReviews), sectionOf<qint64>(data, NextReviews) + cardCount);
+    QList<qint64> lastReviews(sectionOf<qint64>(data, LastReviews), sectionOf<qint64>(data, LastReviews) + cardCount);
+
+    const DeckEntry *decks = sectionOf<DeckEntry>(data, Decks);
+    const DeckEntry *decksEnd = decks + header.deckCount;
+    QSet<const DeckEntry *> touchedDecks;
+    for (const ReviewRecord &record : records) {
+        const int row = rowOf(record.cardId);
+        if (row < 0) {
+            continue;
+        }
+        easyFactors[row] = record.easyFactor;
+        intervals[row] = record.intervalDays;
+        repetitions[row] = record.repetitions;
+        nextReviews[row] = record.nextReview;
+        lastReviews[row] = record.reviewedAt;
+
+        // Колоды записаны подряд, поэтому колода строки - последняя,
+        // начинающаяся не позже неё
+        const DeckEntry *deck = std::upper_bound(decks, decksEnd, quint32(row),
+            [](quint32 value, const DeckEntry &e) { return value < e.firstRow; });
+        touchedDecks.insert(deck - 1);
+    }
+
+    const DueIndex::Entry *sourceEntries = sectionOf<DueIndex::Entry>(data, DueEntries);
+    QList<DueIndex::Entry> dueEntries(sourceEntries, sourceEntries + cardCount);
+    for (const DeckEntry *deck : std::as_const(touchedDecks)) {
+        const qsizetype first = deck->firstRow;
+        const qsizetype rows = deck->rowCount;
+        DueIndex index;
+        index.rebuild(nextReviews.mid(first, rows));
+        std::copy(index.begin(), index.end(), dueEntries.begin() + first);
+    }
+
+    SectionBytes sections[SectionCount];
+    for (int section = 0; section < SectionCount; ++section) {
+        sections[section] = SectionBytes{data + header.sections[section].offset, header.sections[section].size};
+    }
+    sections[EasyFactors] = bytesOf(easyFactors);
+    sections[Intervals] = bytesOf(intervals);
+    sections[Repetitions] = bytesOf(repetitions);
+    sections[NextReviews] = bytesOf(nextReviews);
+    sections[LastReviews] = bytesOf(lastReviews);
+    sections[DueEntries] = bytesOf(dueEntries);
+
+    Header updated = header;
+    QString error;
+    bool unmapped = false;
+    // Отображение снимается перед заменой файла: на Windows нельзя
+    // переименовать файл поверх отображенного
+    const bool written = writeFile(path, updated, sections, [this, &unmapped]() {
+        close();
+        unmapped = true;
+    }, &error);
+
+    if (unmapped && !open(false)) {
+        return false;
+    }
+    return written || fail(error);
+}
+
+QString CollectionSnapshot::lastError() const
+{
+    return errorText;
+}
+
+int CollectionSnapshot::rowOf(int cardId)
+{
+    if (!isOpen()) {
+        return -1;
+    }
+    if (rowById.isEmpty()) {
+        const quint32 cardCount = headerOf(data).cardCount;
+        const qint32 *ids = sectionOf<qint32>(data, Ids);
+        rowById.reserve(cardCount);
+        for (quint32 row = 0; row < cardCount; ++row) {
+            if (!rowById.contains(ids[row])) {
+                rowById.insert(ids[row], int(row));
+            }
+        }
+    }
+    return rowById.value(cardId, -1);
+}
+
+/**
+ * @brief Прочитать строку раздела строк
+ *
+ * Границы строки проверяются, поскольку разделы без проверки
+ * контрольных сумм могут быть повреждены.
+ */
+QString CollectionSnapshot::string(quint32 index) const
+{
+    const Header &header = headerOf(data);
+    if (index >= header.stringCount) {
+        return QString();
+    }
+    const quint64 *offsets = sectionOf<quint64>(data, StringOffsets);
+    const quint64 charCount = header.sections[StringChars].size / sizeof(QChar);
+    const quint64 begin = offsets[index];
+    const quint64 end = offsets[index + 1];
+    if (begin > end || end > charCount) {
+        return QString();
+    }
+    return QString(sectionOf<QChar>(data, StringChars) + begin, qsizetype(end - begin));
+}
+
+bool CollectionSnapshot::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
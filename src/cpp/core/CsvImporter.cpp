@@ -0,0 +1,699 @@
+#include "CsvImporter.h"
+#include "CardRepository.h"
+#include "Deck.h"
+#include "SM2.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Известные столбцы
+ */
+enum Column {
+    ColumnId,
+    ColumnQuestion,
+    ColumnAnswer,
+    ColumnContentType,
+    ColumnTestMode,
+    ColumnEasyFactor,
+    ColumnIntervalDays,
+    ColumnRepetitions,
+    ColumnNextReview,
+    ColumnLastReview,
+    ColumnCount
+};
+
+const char *const kColumnNames[ColumnCount] = {
+    "id", "question", "answer", "content_type", "test_mode",
+    "easy_factor", "interval_days", "repetitions", "next_review", "last_review"
+};
+
+/**
+ * @brief Расположение столбцов в записи
+ */
+struct Layout {
+    int index[ColumnCount];     ///< Номер поля столбца или -1
+    int requiredFields = 0;     ///< Наименьшее количество полей записи
+};
+
+/**
+ * @brief Поле записи внутри блока
+ */
+struct Field {
+    const char *begin = nullptr;
+    qsizetype size = 0;
+    bool escaped = false;       ///< Содержит удвоенные кавычки
+};
+
+/**
+ * @brief Блок целых записей
+ */
+struct Chunk {
+    qint64 sequence = 0;        ///< Порядковый номер блока
+    QByteArray bytes;           ///< Записи блока
+    qsizetype start = 0;        ///< Смещение первой записи (после заголовка)
+    qint64 firstLine = 1;       ///< Номер строки файла в начале блока
+};
+
+/**
+ * @brief Результат разбора блока
+ */
+struct ParsedChunk {
+    QList<Card> cards;
+    QList<CsvImporter::RowError> errors;
+    qint64 rows = 0;
+    qint64 malformed = 0;
+    qint64 bytes = 0;
+};
+
+/**
+ * @brief Разобрать одну запись
+ *
+ * @param p Начало записи
+ * @param end Конец данных
+ * @param fields Поля записи
+ * @param newlines Увеличивается на количество переводов строк в записи
+ * @param error Описание ошибки формата или пустая строка
+ * @return Начало следующей записи
+ */
+const char *splitRecord(const char *p, const char *end, char delimiter,
+                        QList<Field> &fields, qint64 &newlines, QString &error)
+{
+    fields.clear();
+    error.clear();
+    for (;;) {
+        Field field;
+        if (p < end && *p == '"') {
+            field.begin = ++p;
+            for (;;) {
+                const char *quote = static_cast<const char *>(std::memchr(p, '"', size_t(end - p)));
+                if (!quote) {
+                    newlines += std::count(p, end, '\n');
+                    field.size = end - field.begin;
+                    fields.append(field);
+                    error = QStringLiteral("unterminated quoted field");
+                    return end;
+                }
+                newlines += std::count(p, quote, '\n');
+                if (quote + 1 < end && quote[1] == '"') {
+                    field.escaped = true;
+                    p = quote + 2;
+                    continue;
+                }
+                field.size = quote - field.begin;
+                p = quote + 1;
+                break;
+            }
+            if (p < end && *p != delimiter && *p != '\n' && *p != '\r' && error.isEmpty()) {
+                error = QStringLiteral("unexpected character after closing quote");
+            }
+            while (p < end && *p != delimiter && *p != '\n') {
+                ++p;
+            }
+        } else {
+            field.begin = p;
+            while (p < end && *p != delimiter && *p != '\n') {
+                ++p;
+            }
+            field.size = p - field.begin;
+            if (field.size > 0 && field.begin[field.size - 1] == '\r' && (p == end || *p == '\n')) {
+                --field.size;
+            }
+        }
+        fields.append(field);
+
+        if (p == end) {
+            return end;
+        }
+        if (*p == delimiter) {
+            ++p;
+            continue;
+        }
+        ++newlines;
+        return p + 1;
+    }
+}
+
+/**
+ * @brief Состояние поиска границы записи
+ *
+ * Сканирование продолжается с места, где остановилось, поэтому запись
+ * длиннее блока не просматривается заново при каждом дочитывании.
+ */
+struct RecordScan {
+    enum State {
+        FieldStart,     ///< Начало поля
+        Unquoted,       ///< Внутри поля без кавычек
+        Quoted,         ///< Внутри поля в кавычках
+        QuotePending,   ///< Кавычка внутри поля в кавычках: экранирование или конец поля
+        AfterQuote      ///< После закрывающей кавычки до разделителя
+    };
+
+    State state = FieldStart;
+    qsizetype scanned = 0;  ///< Просмотренные байты буфера
+    qint64 lines = 0;       ///< Переводы строк в просмотренных байтах
+};
+
+/**
+ * @brief Граница последней целой записи блока
+ *
+ * Кавычки разбираются так же, как в splitRecord(): поле в кавычках
+ * открывается только кавычкой в начале поля, удвоенная кавычка внутри
+ * него экранирована, а кавычки в середине поля без кавычек ничего не
+ * значат. Перевод строки завершает запись, только если он вне поля в
+ * кавычках.
+ *
+ * @param scan Состояние после предыдущего вызова для того же буфера
+ * @param newlines Количество переводов строк до границы
+ * @return Смещение после последней целой записи или 0
+ */
+qsizetype lastRecordEnd(const QByteArray &bytes, char delimiter, RecordScan &scan, qint64 &newlines)
+{
+    const char *data = bytes.constData();
+    const qsizetype size = bytes.size();
+    RecordScan::State state = scan.state;
+    qsizetype boundary = 0;
+    qint64 lines = scan.lines;
+    newlines = 0;
+    for (qsizetype i = scan.scanned; i < size; ++i) {
+        const char c = data[i];
+        if (c == '\n') {
+            ++lines;
+        }
+        switch (state) {
+        case RecordScan::Quoted:
+            if (c == '"') {
+                state = RecordScan::QuotePending;
+            }
+            continue;
+        case RecordScan::QuotePending:
+            if (c == '"') {
+                state = RecordScan::Quoted;
+                continue;
+            }
+            state = RecordScan::AfterQuote;
+            break;
+        case RecordScan::FieldStart:
+            if (c == '"') {
+                state = RecordScan::Quoted;
+                continue;
+            }
+            state = RecordScan::Unquoted;
+            break;
+        case RecordScan::Unquoted:
+        case RecordScan::AfterQuote:
+            break;
+        }
+        if (c == delimiter) {
+            state = RecordScan::FieldStart;
+        } else if (c == '\n') {
+            state = RecordScan::FieldStart;
+            boundary = i + 1;
+            newlines = lines;
+        }
+    }
+    scan.state = state;
+    scan.scanned = size;
+    scan.lines = lines;
+    return boundary;
+}
+
+QString decodeText(const Field &field, QByteArray &scratch)
+{
+    if (!field.escaped) {
+        return QString::fromUtf8(field.begin, field.size);
+    }
+    scratch.resize(field.size);
+    char *out = scratch.data();
+    for (qsizetype i = 0; i < field.size; ++i) {
+        *out++ = field.begin[i];
+        if (field.begin[i] == '"' && i + 1 < field.size && field.begin[i + 1] == '"') {
+            ++i;
+        }
+    }
+    return QString::fromUtf8(scratch.constData(), out - scratch.constData());
+}
+
+QByteArray rawBytes(const Field &field)
+{
+    return QByteArray::fromRawData(field.begin, field.size).trimmed();
+}
+
+bool parseEnum(const Field &field, const char *const *names, int count, int &value)
+{
+    const QByteArray text = rawBytes(field).toLower();
+    for (int i = 0; i < count; ++i) {
+        if (text == names[i]) {
+            value = i;
+            return true;
+        }
+    }
+    bool ok = false;
+    value = text.toInt(&ok);
+    return ok && value >= 0 && value < count;
+}
+
+bool parseDate(const Field &field, QDateTime &date)
+{
+    const QByteArray text = rawBytes(field);
+    if (text.isEmpty()) {
+        date = QDateTime();
+        return true;
+    }
+    bool ok = false;
+    const qint64 msecs = text.toLongLong(&ok);
+    if (ok) {
+        date = QDateTime::fromMSecsSinceEpoch(msecs);
+        return true;
+    }
+    date = QDateTime::fromString(QString::fromLatin1(text), Qt::ISODateWithMs);
+    return date.isValid();
+}
+
+const char *const kContentTypeNames[] = {"text", "image", "audio"};
+const char *const kTestModeNames[] = {"direct", "multiple_choice", "matching"};
+
+/**
+ * @brief Собрать карточку из полей записи
+ * @return Описание ошибки или пустая строка
+ */
+QString buildCard(const QList<Field> &fields, const Layout &layout, int deckId,
+                  StringPool *pool, QByteArray &scratch, Card &card)
+{
+    if (fields.size() < layout.requiredFields) {
+        return QString("expected at least %1 fields, got %2").arg(layout.requiredFields).arg(fields.size());
+    }
+    auto field = [&](Column column) -> const Field * {
+        const int index = layout.index[column];
+        return index >= 0 ? &fields[index] : nullptr;
+    };
+
+    int id = 0;
+    if (const Field *f = field(ColumnId)) {
+        bool ok = false;
+        id = rawBytes(*f).toInt(&ok);
+        if (!ok) {
+            return QStringLiteral("invalid id");
+        }
+    }
+
+    QString question = decodeText(*field(ColumnQuestion), scratch);
+    if (question.trimmed().isEmpty()) {
+        return QStringLiteral("empty question");
+    }
+    QString answer = decodeText(*field(ColumnAnswer), scratch);
+
+    int contentType = 0;
+    if (const Field *f = field(ColumnContentType); f && !parseEnum(*f, kContentTypeNames, 3, contentType)) {
+        return QStringLiteral("invalid content_type");
+    }
+    int testMode = 0;
+    if (const Field *f = field(ColumnTestMode); f && !parseEnum(*f, kTestModeNames, 3, testMode)) {
+        return QStringLiteral("invalid test_mode");
+    }
+
+    float easyFactor = SM2::kMaxEasyFactor;
+    if (const Field *f = field(ColumnEasyFactor)) {
+        bool ok = false;
+        easyFactor = rawBytes(*f).toFloat(&ok);
+        if (!ok || !std::isfinite(easyFactor) || easyFactor <= 0.0f) {
+            return QStringLiteral("invalid easy_factor");
+        }
+    }
+    int intervalDays = 0;
+    if (const Field *f = field(ColumnIntervalDays)) {
+        bool ok = false;
+        intervalDays = rawBytes(*f).toInt(&ok);
+        if (!ok || intervalDays < 0) {
+            return QStringLiteral("invalid interval_days");
+        }
+    }
+    int repetitions = 0;
+    if (const Field *f = field(ColumnRepetitions)) {
+        bool ok = false;
+        repetitions = rawBytes(*f).toInt(&ok);
+        if (!ok || repetitions < 0) {
+            return QStringLiteral("invalid repetitions");
+        }
+    }
+    QDateTime nextReview;
+    if (const Field *f = field(ColumnNextReview); f && !parseDate(*f, nextReview)) {
+        return QStringLiteral("invalid next_review");
+    }
+    QDateTime lastReview;
+    if (const Field *f = field(ColumnLastReview); f && !parseDate(*f, lastReview)) {
+        return QStringLiteral("invalid last_review");
+    }
+
+    card = Card(id, question, answer,
+                static_cast<ContentType>(contentType), static_cast<TestMode>(testMode),
+                easyFactor, intervalDays, repetitions, nextReview, lastReview, deckId, pool);
+    return QString();
+}
+
+/**
+ * @brief Разобрать блок в рабочем потоке
+ */
+ParsedChunk parseChunk(const Chunk &chunk, const Layout &layout, const CsvImporter::Options &options)
+{
+    ParsedChunk parsed;
+    parsed.bytes = chunk.bytes.size();
+    parsed.cards.reserve(chunk.bytes.size() / 64);
+
+    QList<Field> fields;
+    QByteArray scratch;
+    QString error;
+    qint64 line = chunk.firstLine;
+    const char *p = chunk.bytes.constData() + chunk.start;
+    const char *end = chunk.bytes.constData() + chunk.bytes.size();
+    while (p < end) {
+        const qint64 recordLine = line;
+        p = splitRecord(p, end, options.delimiter, fields, line, error);
+
+        // Пустая строка - не запись
+        if (fields.size() == 1 && fields[0].size == 0 && error.isEmpty()) {
+            continue;
+        }
+
+        ++parsed.rows;
+        Card card;
+        if (error.isEmpty()) {
+            error = buildCard(fields, layout, options.deckId, options.stringPool, scratch, card);
+        }
+        if (!error.isEmpty()) {
+            ++parsed.malformed;
+            if (parsed.errors.size() < options.maxReportedErrors) {
+                parsed.errors.append(CsvImporter::RowError{recordLine, error});
+            }
+            continue;
+        }
+        parsed.cards.append(std::move(card));
+    }
+    return parsed;
+}
+
+/**
+ * @brief Сопоставить заголовок известным столбцам
+ * @return Описание ошибки или пустая строка
+ */
+QString makeLayout(const QList<Field> *header, Layout &layout)
+{
+    std::fill(std::begin(layout.index), std::end(layout.index), -1);
+    if (!header) {
+        layout.index[ColumnQuestion] = 0;
+        layout.index[ColumnAnswer] = 1;
+        layout.requiredFields = 2;
+        return QString();
+    }
+
+    QByteArray scratch;
+    for (int i = 0; i < header->size(); ++i) {
+        const QByteArray name = decodeText((*header)[i], scratch).trimmed().toLower().toUtf8();
+        for (int column = 0; column < ColumnCount; ++column) {
+            if (name == kColumnNames[column] && layout.index[column] < 0) {
+                layout.index[column] = i;
+                layout.requiredFields = std::max(layout.requiredFields, i + 1);
+            }
+        }
+    }
+    if (layout.index[ColumnQuestion] < 0 || layout.index[ColumnAnswer] < 0) {
+        return QStringLiteral("Header must contain question and answer columns");
+    }
+    return QString();
+}
+
+/**
+ * @brief Упорядоченная передача разобранных блоков из пула
+ */
+struct Pipeline {
+    QMutex mutex;
+    QWaitCondition ready;
+    QHash<qint64, ParsedChunk> done;
+};
+
+} // namespace
+
+CsvImporter::CsvImporter() : CsvImporter(Options()) {}
+
+CsvImporter::CsvImporter(const Options &options) : options(options) {}
+
+void CsvImporter::setProgressCallback(ProgressCallback callback)
+{
+    progressCallback = std::move(callback);
+}
+
+/**
+ * @brief Импортировать карточки из открытого устройства
+ *
+ * Поток вызова читает блоки, находит границы записей и раздает блоки
+ * пулу, затем забирает разобранные блоки в порядке файла и передает
+ * их получателю. В обработке одновременно не больше двух блоков на поток
+ * пула, поэтому чтение притормаживает, если разбор или получатель
+ * не успевают.
+ */
+bool CsvImporter::import(QIODevice &device, const BatchSink &sink)
+{
+    summary = Result();
+    errorText.clear();
+    QElapsedTimer timer;
+    timer.start();
+
+    const qint64 totalBytes = device.isSequential() ? -1 : device.size();
+    QThreadPool pool;
+    if (options.threadCount > 0) {
+        pool.setMaxThreadCount(options.threadCount);
+    }
+    const int maxInFlight = std::max(2, pool.maxThreadCount() * 2);
+
+    Pipeline pipeline;
+    Layout layout;
+    bool haveLayout = false;
+    qint64 dispatched = 0;
+    qint64 delivered = 0;
+    qint64 nextCardId = options.firstCardId;
+    qint64 bytesProcessed = 0;
+    QList<Card> batch;
+    bool ok = true;
+
+    auto flushBatch = [&]() {
+        if (batch.isEmpty()) {
+            return true;
+        }
+        const qsizetype size = batch.size();
+        if (!sink(std::move(batch))) {
+            return fail(QStringLiteral("Import aborted by the receiver"));
+        }
+        summary.imported += size;
+        batch = QList<Card>();
+        batch.reserve(options.batchSize);
+        return true;
+    };
+
+    // Забрать следующий по порядку блок и передать его карточки получателю
+    auto deliverNext = [&]() {
+        ParsedChunk parsed;
+        {
+            QMutexLocker locker(&pipeline.mutex);
+            while (!pipeline.done.contains(delivered)) {
+                pipeline.ready.wait(&pipeline.mutex);
+            }
+            parsed = pipeline.done.take(delivered);
+        }
+        ++delivered;
+
+        summary.rows += parsed.rows;
+        summary.malformed += parsed.malformed;
+        for (CsvImporter::RowError &error : parsed.errors) {
+            if (summary.errors.size() >= options.maxReportedErrors) {
+                break;
+            }
+            summary.errors.append(std::move(error));
+        }
+
+        const bool assignIds = layout.index[ColumnId] < 0;
+        for (Card &card : parsed.cards) {
+            if (assignIds) {
+                card.setId(static_cast<int>(nextCardId++));
+            }
+            batch.append(std::move(card));
+            if (batch.size() >= options.batchSize && !flushBatch()) {
+                return false;
+            }
+        }
+
+        bytesProcessed += parsed.bytes;
+        if (progressCallback) {
+            progressCallback(bytesProcessed, totalBytes, summary.imported + batch.size());
+        }
+        return true;
+    };
+
+    batch.reserve(options.batchSize);
+    QByteArray buffer;
+    RecordScan scan;
+    qint64 nextLine = 1;
+    bool firstBlock = true;
+    for (;;) {
+        QByteArray block = device.read(options.chunkBytes);
+        const bool atEnd = block.isEmpty();
+        summary.bytesRead += block.size();
+        if (buffer.isEmpty()) {
+            buffer = std::move(block);
+        } else {
+            buffer.append(block);
+        }
+
+        if (firstBlock && (buffer.size() >= 3 || atEnd)) {
+            // Метка порядка байтов UTF-8
+            if (buffer.startsWith("\xEF\xBB\xBF")) {
+                buffer.remove(0, 3);
+                bytesProcessed += 3;
+                scan = RecordScan();
+            }
+            firstBlock = false;
+        }
+
+        qint64 newlines = 0;
+        qsizetype boundary = 0;
+        if (atEnd) {
+            boundary = buffer.size();
+            newlines = std::count(buffer.cbegin(), buffer.cend(), '\n');
+        } else {
+            boundary = lastRecordEnd(buffer, options.delimiter, scan, newlines);
+            if (boundary == 0) {
+                // Запись длиннее блока: дочитываем
+                continue;
+            }
+            // Остаток за границей уже просмотрен и становится началом буфера
+            scan.scanned -= boundary;
+            scan.lines -= newlines;
+        }
+
+        Chunk chunk;
+        chunk.sequence = dispatched;
+        chunk.firstLine = nextLine;
+        nextLine += newlines;
+        QByteArray tail = buffer.mid(boundary);
+        buffer.truncate(boundary);
+        chunk.bytes = std::move(buffer);
+        buffer = std::move(tail);
+
+        if (!haveLayout && !chunk.bytes.isEmpty()) {
+            QList<Field> header;
+            QString error;
+            qint64 headerLines = 0;
+            const char *begin = chunk.bytes.constData();
+            if (options.hasHeader) {
+                const char *next = splitRecord(begin, begin + chunk.bytes.size(), options.delimiter,
+                                               header, headerLines, error);
+                chunk.start = next - begin;
+                chunk.firstLine += headerLines;
+                bytesProcessed += chunk.start;
+            }
+            error = makeLayout(options.hasHeader ? &header : nullptr, layout);
+            if (!error.isEmpty()) {
+                ok = fail(error);
+                break;
+            }
+            haveLayout = true;
+        }
+
+        if (chunk.bytes.size() > chunk.start) {
+            pool.start([&pipeline, &layout, this, chunk]() {
+                ParsedChunk parsed = parseChunk(chunk, layout, options);
+                parsed.bytes -= chunk.start;
+                QMutexLocker locker(&pipeline.mutex);
+                pipeline.done.insert(chunk.sequence, std::move(parsed));
+                pipeline.ready.wakeAll();
+            });
+            ++dispatched;
+        }
+
+        while (dispatched - delivered >= maxInFlight) {
+            if (!deliverNext()) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok || atEnd) {
+            break;
+        }
+    }
+
+    while (ok && delivered < dispatched) {
+        ok = deliverNext();
+    }
+    pool.waitForDone();
+    ok = ok && flushBatch();
+
+    // Пустое чтение до конца файла - ошибка устройства
+    if (ok && !device.isSequential() && !device.atEnd()) {
+        ok = fail(device.errorString());
+    }
+    summary.elapsedMSecs = timer.elapsed();
+    return ok;
+}
+
+bool CsvImporter::importFile(const QString &path, const BatchSink &sink)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        summary = Result();
+        return fail(file.errorString());
+    }
+    return import(file, sink);
+}
+
+bool CsvImporter::importFile(const QString &path, CardRepository &cards)
+{
+    const int nextCardId = cards.nextCardId();
+    if (nextCardId < 0) {
+        summary = Result();
+        return fail(cards.lastError());
+    }
+    const int configuredId = options.firstCardId;
+    options.firstCardId = std::max(configuredId, nextCardId);
+    const bool ok = importFile(path, repositorySink(cards, options.deckId));
+    options.firstCardId = configuredId;
+    return ok;
+}
+
+const CsvImporter::Result &CsvImporter::result() const
+{
+    return summary;
+}
+
+QString CsvImporter::lastError() const
+{
+    return errorText;
+}
+
+CsvImporter::BatchSink CsvImporter::deckSink(Deck &deck)
+{
+    return [&deck](QList<Card> &&batch) {
+        deck.addCards(std::move(batch));
+        return true;
+    };
+}
+
+CsvImporter::BatchSink CsvImporter::repositorySink(CardRepository &cards, int deckId)
+{
+    return [&cards, deckId](QList<Card> &&batch) {
+        return cards.insertCards(deckId, batch);
+    };
+}
+
+bool CsvImporter::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
@@ -0,0 +1,139 @@
+#include "Database.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+
+namespace {
+
+/**
+ * @brief Выполнить список инструкций, остановившись на первой ошибке
+ */
+bool execAll(QSqlDatabase &database, const QStringList &statements, QString *errorMessage)
+{
+    QSqlQuery query(database);
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            if (errorMessage) {
+                *errorMessage = query.lastError().text();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+QSqlDatabase Database::open(const QString &path, const QString &connectionName,
+                            QString *errorMessage)
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    database.setDatabaseName(path);
+    if (!database.open()) {
+        if (errorMessage) {
+            *errorMessage = database.lastError().text();
+        }
+        return QSqlDatabase();
+    }
+
+    // Для ":memory:" SQLite оставляет журнал "memory", это не ошибка
+    const QStringList pragmas = {
+        "PRAGMA journal_mode = WAL",
+        "PRAGMA synchronous = NORMAL",
+        "PRAGMA temp_store = MEMORY",
+        "PRAGMA foreign_keys = ON"
+    };
+    if (!execAll(database, pragmas, errorMessage) || !createSchema(database, errorMessage)) {
+        database.close();
+        return QSqlDatabase();
+    }
+    return database;
+}
+
+/**
+ * @brief Создать таблицы и индексы, если их еще нет
+ *
+ * Индекс (deck_id, next_review) обслуживает выборку и подсчет готовых
+ * карточек колоды, индекс (deck_id, position) - загрузку колоды в исходном
+ * порядке без сортировки.
+ */
+bool Database::createSchema(QSqlDatabase &database, QString *errorMessage)
+{
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS decks ("
+        " id INTEGER PRIMARY KEY,"
+        " name TEXT NOT NULL)",
+
+        "CREATE TABLE IF NOT EXISTS cards ("
+        " id INTEGER PRIMARY KEY,"
+        " deck_id INTEGER NOT NULL,"
+        " position INTEGER NOT NULL,"
+        " question TEXT NOT NULL,"
+        " answer TEXT NOT NULL,"
+        " content_type INTEGER NOT NULL,"
+        " test_mode INTEGER NOT NULL,"
+        " easy_factor REAL NOT NULL,"
+        " interval_days INTEGER NOT NULL,"
+        " repetitions INTEGER NOT NULL,"
+        " next_review INTEGER NOT NULL,"
+        " last_review INTEGER NOT NULL)",
+
+        "CREATE TABLE IF NOT EXISTS card_media ("
+        " card_id INTEGER PRIMARY KEY,"
+        " data BLOB NOT NULL)",
+
+        "CREATE INDEX IF NOT EXISTS idx_cards_deck_due ON cards (deck_id, next_review)",
+        "CREATE INDEX IF NOT EXISTS idx_cards_deck_position ON cards (deck_id, position)"
+    };
+    return execAll(database, statements, errorMessage);
+}
+
+bool Database::hasFullTextSearch(QSqlDatabase &database)
+{
+    QSqlQuery query(database);
+    return query.exec("SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'cards_fts'")
+           && query.next();
+}
+
+/**
+ * @brief Включить полнотекстовый индекс
+ *
+ * Таблица cards_fts (FTS5) не хранит копию текста (content='cards')
+ * и обновляется триггерами. Создание и заполнение командой 'rebuild'
+ * выполняются одной транзакцией, поэтому индекс не бывает заполнен
+ * частично.
+ */
+bool Database::enableFullTextSearch(QSqlDatabase &database, QString *errorMessage)
+{
+    if (hasFullTextSearch(database)) {
+        return true;
+    }
+
+    const QStringList statements = {
+        // Разбиение на слова - как у SearchIndex: буквы и цифры любой
+        // письменности без учета регистра, диакритика сохраняется
+        "CREATE VIRTUAL TABLE cards_fts USING fts5("
+        " question, answer, content = 'cards', content_rowid = 'id',"
+        " tokenize = 'unicode61 remove_diacritics 0')",
+
+        "CREATE TRIGGER cards_fts_insert AFTER INSERT ON cards BEGIN"
+        " INSERT INTO cards_fts (rowid, question, answer) VALUES (new.id, new.question, new.answer);"
+        " END",
+
+        "CREATE TRIGGER cards_fts_delete AFTER DELETE ON cards BEGIN"
+        " INSERT INTO cards_fts (cards_fts, rowid, question, answer)"
+        " VALUES ('delete', old.id, old.question, old.answer);"
+        " END",
+
+        "CREATE TRIGGER cards_fts_update AFTER UPDATE OF question, answer ON cards BEGIN"
+        " INSERT INTO cards_fts (cards_fts, rowid, question, answer)"
+        " VALUES ('delete', old.id, old.question, old.answer);"
+        " INSERT INTO cards_fts (rowid, question, answer) VALUES (new.id, new.question, new.answer);"
+        " END",
+
+        "INSERT INTO cards_fts (cards_fts) VALUES ('rebuild')"
+    };
+    return inTransaction(database, errorMessage, [&]() {
+        return execAll(database, statements, errorMessage);
+    });
+}
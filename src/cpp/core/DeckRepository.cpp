@@ -0,0 +1,152 @@
+#include "DeckRepository.h"
+#include "Database.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+DeckRepository::DeckRepository(const QSqlDatabase &database)
+    : database(database), cardRepository(database) {}
+
+/**
+ * @brief Сохранить колоду целиком
+ *
+ * В одной транзакции:
+ * 1. строка колоды вставляется или обновляется;
+ * 2. медиаданные карточек, которых больше нет в колоде, удаляются;
+ * 3. прежние карточки колоды удаляются;
+ * 4. текущие карточки записываются одним подготовленным запросом.
+ *
+ * Колода без текста (Deck::isMetadataOnly()) хранит пустые строки
+ * вместо вопросов и ответов, поэтому для неё сохраненный текст
+ * не перезаписывается.
+ */
+bool DeckRepository::saveDeck(const Deck &deck)
+{
+    return Database::inTransaction(database, &errorText, [&]() {
+        QSqlQuery query(database);
+        if (!query.prepare("INSERT OR REPLACE INTO decks (id, name) VALUES (?, ?)")) {
+            return fail(query.lastError().text());
+        }
+        query.addBindValue(deck.getId());
+        query.addBindValue(deck.getName());
+        if (!query.exec()) {
+            return fail(query.lastError().text());
+        }
+
+        if (deck.isMetadataOnly()) {
+            if (!cardRepository.writeDeckMetadata(deck.getId(), deck.getCardsView())) {
+                return fail(cardRepository.lastError());
+            }
+            return true;
+        }
+        if (!cardRepository.removeDroppedMedia(deck.getId(), deck.getCardsView())
+            || !cardRepository.removeDeckCards(deck.getId())
+            || !cardRepository.writeCards(deck.getId(), deck.getCardsView(), 0)) {
+            return fail(cardRepository.lastError());
+        }
+        return true;
+    });
+}
+
+bool DeckRepository::saveScheduling(const Deck &deck)
+{
+    return Database::inTransaction(database, &errorText, [&]() {
+        if (!cardRepository.writeScheduling(deck.getCardsView())) {
+            return fail(cardRepository.lastError());
+        }
+        return true;
+    });
+}
+
+bool DeckRepository::loadDeck(int deckId, Deck &deck)
+{
+    return load(deckId, deck, false);
+}
+
+bool DeckRepository::loadDeckMetadata(int deckId, Deck &deck)
+{
+    return load(deckId, deck, true);
+}
+
+bool DeckRepository::load(int deckId, Deck &deck, bool metadataOnly)
+{
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!query.prepare("SELECT name FROM decks WHERE id = ?")) {
+        return fail(query.lastError().text());
+    }
+    query.addBindValue(deckId);
+    if (!query.exec()) {
+        return fail(query.lastError().text());
+    }
+    if (!query.next()) {
+        return fail(QString("Deck %1 not found").arg(deckId));
+    }
+    const QString name = query.value(0).toString();
+
+    // Пустая колода тоже дает пустой список, поэтому ошибку различаем по тексту
+    cardRepository.errorText.clear();
+    QList<Card> cards = metadataOnly ? cardRepository.loadDeckMetadata(deckId)
+                                     : cardRepository.loadDeckCards(deckId);
+    if (cards.isEmpty() && !cardRepository.lastError().isEmpty()) {
+        return fail(cardRepository.lastError());
+    }
+
+    deck.setId(deckId);
+    deck.setName(name);
+    deck.setMetadataOnly(metadataOnly);
+    deck.setCards(std::move(cards));
+    return true;
+}
+
+bool DeckRepository::removeDeck(int deckId)
+{
+    bool removed = false;
+    const bool committed = Database::inTransaction(database, &errorText, [&]() {
+        if (!cardRepository.removeDeckMedia(deckId) || !cardRepository.removeDeckCards(deckId)) {
+            return fail(cardRepository.lastError());
+        }
+        QSqlQuery query(database);
+        if (!query.prepare("DELETE FROM decks WHERE id = ?")) {
+            return fail(query.lastError().text());
+        }
+        query.addBindValue(deckId);
+        if (!query.exec()) {
+            return fail(query.lastError().text());
+        }
+        removed = query.numRowsAffected() > 0;
+        return true;
+    });
+    return committed && removed;
+}
+
+QList<int> DeckRepository::deckIds()
+{
+    QList<int> ids;
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id FROM decks ORDER BY id")) {
+        fail(query.lastError().text());
+        return ids;
+    }
+    while (query.next()) {
+        ids.append(query.value(0).toInt());
+    }
+    return ids;
+}
+
+CardRepository &DeckRepository::cards()
+{
+    return cardRepository;
+}
+
+QString DeckRepository::lastError() const
+{
+    return errorText;
+}
+
+bool DeckRepository::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
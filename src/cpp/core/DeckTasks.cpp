@@ -0,0 +1,72 @@
+#include "DeckTasks.h"
+#include "CollectionSnapshot.h"
+#include "DeckHandoff.h"
+#include <utility>
+
+namespace DeckTasks {
+
+TaskRunner::Task loadSnapshot(const QString &path, int deckId, DeckHandoff &target)
+{
+    return [path, deckId, &target](TaskContext &context) {
+        context.setProgress(0, 1);
+        CollectionSnapshot snapshot(path);
+        if (!snapshot.open()) {
+            context.setError(snapshot.lastError());
+            return false;
+        }
+        Deck deck;
+        if (context.isCanceled()) {
+            return false;
+        }
+        if (!snapshot.loadDeck(deckId, deck)) {
+            context.setError(snapshot.lastError());
+            return false;
+        }
+        if (context.isCanceled()) {
+            return false;
+        }
+        target.publish(std::move(deck));
+        context.setProgress(1, 1);
+        return true;
+    };
+}
+
+TaskRunner::Task importCsv(const QString &path, int deckId, DeckHandoff &target,
+                           const CsvImporter::Options &options)
+{
+    return [path, deckId, &target, options](TaskContext &context) {
+        Deck deck;
+        deck.setId(deckId);
+        CsvImporter::Options parse = options;
+        parse.deckId = deckId;
+        CsvImporter importer(parse);
+        importer.setProgressCallback([&context](qint64 bytesProcessed, qint64 totalBytes, qint64) {
+            context.setProgress(bytesProcessed, totalBytes);
+        });
+        const CsvImporter::BatchSink sink = CsvImporter::deckSink(deck);
+        const bool ok = importer.importFile(path, [&context, &sink](QList<Card> &&batch) {
+            return !context.isCanceled() && sink(std::move(batch));
+        });
+        if (!ok || context.isCanceled()) {
+            context.setError(importer.lastError());
+            return false;
+        }
+        target.publish(std::move(deck));
+        return true;
+    };
+}
+
+TaskRunner::Task forecast(const DeckHandoff &source, int days, ReviewForecast &result)
+{
+    return [&source, days, &result](TaskContext &context) {
+        const QSharedPointer<const Deck> deck = source.current();
+        if (!deck) {
+            context.setError(QStringLiteral("Deck is not loaded"));
+            return false;
+        }
+        result = deck->getForecast(days);
+        return true;
+    };
+}
+
+} // namespace DeckTasks
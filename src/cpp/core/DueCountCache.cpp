@@ -0,0 +1,325 @@
+#include "DueCountCache.h"
+#include "Deck.h"
+#include <limits>
+
+DueCountCache::DueCountCache(const Clock *clock)
+    : clock(clock ? clock : &Clock::system())
+{
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, &timer, [this]() { onTimeout(); });
+}
+
+DueCountCache::~DueCountCache()
+{
+    for (const Entry &entry : std::as_const(entries)) {
+        entry.deck->setDueCountCache(nullptr);
+    }
+}
+
+// ==================== DECKS ====================
+
+void DueCountCache::addDeck(Deck *deck)
+{
+    if (!deck || slotByDeck.contains(deck)) {
+        return;
+    }
+    slotByDeck.insert(deck, static_cast<int>(entries.size()));
+    Entry entry;
+    entry.deck = deck;
+    entries.append(entry);
+    deck->setDueCountCache(this);
+    scheduleTimer();
+}
+
+/**
+ * @brief Отключить колоду
+ *
+ * Номера следующих записей сдвигаются, поэтому шкала и таблица номеров
+ * исправляются за O(m + k).
+ */
+void DueCountCache::removeDeck(Deck *deck)
+{
+    const auto it = slotByDeck.constFind(deck);
+    if (it == slotByDeck.constEnd()) {
+        return;
+    }
+    const int slot = it.value();
+    dropEvents(slot);
+    deck->setDueCountCache(nullptr);
+    entries.removeAt(slot);
+
+    slotByDeck.clear();
+    for (int i = 0; i < entries.size(); i++) {
+        slotByDeck.insert(entries[i].deck, i);
+    }
+    for (auto event = timeline.begin(); event != timeline.end(); ++event) {
+        if (event.value() > slot) {
+            --event.value();
+        }
+    }
+}
+
+int DueCountCache::deckCount() const
+{
+    return static_cast<int>(entries.size());
+}
+
+// ==================== READING ====================
+
+int DueCountCache::dueCount(const Deck *deck)
+{
+    advanceTo(clock->nowMSecs());
+    const auto it = slotByDeck.constFind(deck);
+    if (it == slotByDeck.constEnd()) {
+        return deck->getDueCount();
+    }
+    return lookup(it.value());
+}
+
+QList<int> DueCountCache::dueCounts()
+{
+    advanceTo(clock->nowMSecs());
+    QList<int> counts;
+    counts.reserve(entries.size());
+    for (int slot = 0; slot < entries.size(); slot++) {
+        counts.append(lookup(slot));
+    }
+    return counts;
+}
+
+int DueCountCache::totalDueCount()
+{
+    advanceTo(clock->nowMSecs());
+    int total = 0;
+    for (int slot = 0; slot < entries.size(); slot++) {
+        total += lookup(slot);
+    }
+    return total;
+}
+
+qint64 DueCountCache::now() const
+{
+    return current;
+}
+
+qint64 DueCountCache::nextChangeAt() const
+{
+    return timeline.isEmpty() ? horizon : timeline.firstKey();
+}
+
+DueCountCache::Stats DueCountCache::stats() const
+{
+    return counters;
+}
+
+void DueCountCache::resetStats()
+{
+    counters = Stats();
+}
+
+// ==================== TIME ====================
+
+/**
+ * @brief Продвинуть счетчики к моменту nowMSecs
+ *
+ * Каждое событие шкалы со сроком не позже nowMSecs увеличивает счетчик
+ * своей колоды и покидает шкалу. Выход за горизонт или шаг назад
+ * сбрасывают все записи: они пересчитаются при чтении.
+ *
+ * Сложность алгоритма: O(m log m), m - количество пройденных событий
+ */
+bool DueCountCache::advanceTo(qint64 nowMSecs)
+{
+    if (!started || nowMSecs < current || nowMSecs > horizon) {
+        restart(nowMSecs);
+        return !entries.isEmpty();
+    }
+
+    bool changed = false;
+    while (!timeline.isEmpty() && timeline.firstKey() <= nowMSecs) {
+        entries[timeline.first()].count++;
+        timeline.erase(timeline.begin());
+        counters.crossings++;
+        changed = true;
+    }
+    current = nowMSecs;
+    return changed;
+}
+
+void DueCountCache::setAutoAdvance(bool enabled, int minIntervalMSecs)
+{
+    autoAdvance = enabled;
+    minTimerInterval = qMax(0, minIntervalMSecs);
+    if (enabled) {
+        scheduleTimer();
+    } else {
+        timer.stop();
+    }
+}
+
+void DueCountCache::setChangedCallback(ChangedCallback callback)
+{
+    changedCallback = std::move(callback);
+}
+
+// ==================== DECK NOTIFICATIONS ====================
+
+void DueCountCache::cardAdded(const Deck *deck, qint64 dueAt)
+{
+    const auto it = slotByDeck.constFind(deck);
+    if (it != slotByDeck.constEnd() && entries[it.value()].valid) {
+        addDue(it.value(), dueAt);
+        counters.updates++;
+    }
+}
+
+void DueCountCache::cardRemoved(const Deck *deck, qint64 dueAt)
+{
+    const auto it = slotByDeck.constFind(deck);
+    if (it != slotByDeck.constEnd() && entries[it.value()].valid) {
+        removeDue(it.value(), dueAt);
+        counters.updates++;
+    }
+}
+
+/**
+ * @brief Карточка перепланирована
+ *
+ * Обычно это ответ на готовую карточку: счетчик уменьшается на единицу,
+ * а новый срок (через сутки и позже) лежит за горизонтом и на шкалу
+ * не попадает.
+ */
+void DueCountCache::cardRescheduled(const Deck *deck, qint64 oldDueAt, qint64 newDueAt)
+{
+    const auto it = slotByDeck.constFind(deck);
+    if (it != slotByDeck.constEnd() && entries[it.value()].valid) {
+        removeDue(it.value(), oldDueAt);
+        addDue(it.value(), newDueAt);
+        counters.updates++;
+    }
+}
+
+void DueCountCache::invalidate(const Deck *deck)
+{
+    const auto it = slotByDeck.constFind(deck);
+    if (it != slotByDeck.constEnd() && entries[it.value()].valid) {
+        dropEvents(it.value());
+        entries[it.value()].valid = false;
+        scheduleTimer();
+    }
+}
+
+// ==================== PRIVATE ====================
+
+int DueCountCache::lookup(int slot)
+{
+    if (entries[slot].valid) {
+        counters.hits++;
+    } else {
+        counters.misses++;
+        recompute(slot);
+    }
+    return entries[slot].count;
+}
+
+/**
+ * @brief Пересчитать запись по индексу повторений колоды
+ *
+ * Счетчик находится бинарным поиском, а на шкалу попадают карточки
+ * со сроком в (now, horizon] - участок индекса между двумя границами.
+ *
+ * Сложность алгоритма: O(log n + m log m), m - события записи
+ */
+void DueCountCache::recompute(int slot)
+{
+    Entry &entry = entries[slot];
+    const DueIndex &index = entry.deck->dueIndex;
+    const auto first = index.dueEnd(current);
+    const auto last = index.dueEnd(horizon);
+    entry.count = static_cast<int>(first - index.begin());
+    for (auto it = first; it != last; ++it) {
+        timeline.insert(it->dueAt, slot);
+    }
+    entry.valid = true;
+}
+
+void DueCountCache::addDue(int slot, qint64 dueAt)
+{
+    if (dueAt <= current) {
+        entries[slot].count++;
+    } else if (dueAt <= horizon) {
+        timeline.insert(dueAt, slot);
+        if (autoAdvance && dueAt < timerDeadline) {
+            scheduleTimer();
+        }
+    }
+}
+
+void DueCountCache::removeDue(int slot, qint64 dueAt)
+{
+    if (dueAt <= current) {
+        entries[slot].count--;
+    } else if (dueAt <= horizon) {
+        const auto it = timeline.find(dueAt, slot);
+        if (it != timeline.end()) {
+            timeline.erase(it);
+        }
+    }
+}
+
+void DueCountCache::dropEvents(int slot)
+{
+    for (auto it = timeline.begin(); it != timeline.end();) {
+        if (it.value() == slot) {
+            it = timeline.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DueCountCache::restart(qint64 nowMSecs)
+{
+    timeline.clear();
+    for (Entry &entry : entries) {
+        entry.valid = false;
+    }
+    current = nowMSecs;
+    horizon = nowMSecs > std::numeric_limits<qint64>::max() - kHorizonMSecs
+            ? std::numeric_limits<qint64>::max() : nowMSecs + kHorizonMSecs;
+    started = true;
+    counters.rebuilds++;
+}
+
+/**
+ * @brief Перезапустить таймер на ближайшее событие
+ *
+ * Чтобы таймер видел события всех колод, сброшенные записи
+ * пересчитываются сразу, а не при чтении.
+ */
+void DueCountCache::scheduleTimer()
+{
+    if (!autoAdvance) {
+        return;
+    }
+    advanceTo(clock->nowMSecs());
+    for (int slot = 0; slot < entries.size(); slot++) {
+        if (!entries[slot].valid) {
+            counters.misses++;
+            recompute(slot);
+        }
+    }
+
+    timerDeadline = nextChangeAt();
+    const qint64 delay = qBound(qint64(minTimerInterval), timerDeadline - current, kHorizonMSecs);
+    timer.start(static_cast<int>(delay));
+}
+
+void DueCountCache::onTimeout()
+{
+    const bool changed = advanceTo(clock->nowMSecs());
+    scheduleTimer();
+    if (changed && changedCallback) {
+        changedCallback();
+    }
+}
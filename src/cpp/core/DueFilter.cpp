@@ -0,0 +1,217 @@
+#include "DueFilter.h"
+#include <QtAlgorithms>
+
+#if defined(Q_PROCESSOR_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define QTCARDS_DUEFILTER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(QTCARDS_DUEFILTER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define QTCARDS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define QTCARDS_TARGET_AVX2
+#endif
+
+namespace {
+
+/// Количество дат, обрабатываемых ядром за один вызов (одно слово маски)
+constexpr qsizetype kBlockSize = 64;
+
+/// Ядро: маска наступивших дат для полного блока из 64 элементов
+using BlockFunction = quint64 (*)(const qint64 *dates, qint64 now);
+
+/**
+ * @brief Маска для неполного блока (хвоста массива)
+ */
+quint64 dueTail(const qint64 *dates, qsizetype count, qint64 now)
+{
+    quint64 bits = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        bits |= quint64(dates[i] <= now) << i;
+    }
+    return bits;
+}
+
+quint64 dueBlockScalar(const qint64 *dates, qint64 now)
+{
+    return dueTail(dates, kBlockSize, now);
+}
+
+#if defined(QTCARDS_DUEFILTER_X86)
+
+/**
+ * @brief Знаковое 64-битное сравнение a > b на SSE2
+ *
+ * В SSE2 нет pcmpgtq, поэтому сравнение собирается из 32-битных:
+ * старшие половины сравниваются со знаком, младшие - без знака
+ * (через инверсию знакового бита), а при равных старших половинах
+ * результат берется из младших.
+ */
+inline __m128i greaterThan64(__m128i a, __m128i b)
+{
+    const __m128i lowSignFlip = _mm_set_epi32(0, static_cast<int>(0x80000000), 0, static_cast<int>(0x80000000));
+    const __m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(a, lowSignFlip), _mm_xor_si128(b, lowSignFlip));
+    const __m128i eq = _mm_cmpeq_epi32(a, b);
+
+    const __m128i gtLow = _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0));
+    const __m128i gtHigh = _mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1));
+    const __m128i eqHigh = _mm_shuffle_epi32(eq, _MM_SHUFFLE(3, 3, 1, 1));
+    return _mm_or_si128(gtHigh, _mm_and_si128(eqHigh, gtLow));
+}
+
+quint64 dueBlockSse2(const qint64 *dates, qint64 now)
+{
+    const __m128i nowVector = _mm_set1_epi64x(now);
+    quint64 bits = 0;
+    for (qsizetype i = 0; i < kBlockSize; i += 2) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dates + i));
+        const int notDue = _mm_movemask_pd(_mm_castsi128_pd(greaterThan64(value, nowVector)));
+        bits |= quint64(~notDue & 0x3) << i;
+    }
+    return bits;
+}
+
+QTCARDS_TARGET_AVX2 quint64 dueBlockAvx2(const qint64 *dates, qint64 now)
+{
+    const __m256i nowVector = _mm256_set1_epi64x(now);
+    quint64 bits = 0;
+    for (qsizetype i = 0; i < kBlockSize; i += 4) {
+        const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dates + i));
+        const int notDue = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(value, nowVector)));
+        bits |= quint64(~notDue & 0xF) << i;
+    }
+    return bits;
+}
+
+/**
+ * @brief Проверить поддержку AVX2 процессором и операционной системой
+ */
+bool cpuHasAvx2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 0x6) == 0x6);
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    return false;
+#endif
+}
+
+#endif // QTCARDS_DUEFILTER_X86
+
+BlockFunction blockFunction(DueFilter::Kernel kernel)
+{
+    if (!DueFilter::isSupported(kernel)) {
+        kernel = DueFilter::Kernel::Scalar;
+    }
+
+    switch (kernel) {
+#if defined(QTCARDS_DUEFILTER_X86)
+    case DueFilter::Kernel::Avx2:
+        return dueBlockAvx2;
+    case DueFilter::Kernel::Sse2:
+        return dueBlockSse2;
+#endif
+    default:
+        return dueBlockScalar;
+    }
+}
+
+/**
+ * @brief Общий обход: маска для каждого блока передается в обработчик
+ *
+ * @param sink Вызывается как sink(номер блока, маска)
+ */
+template<typename Sink>
+void forEachBlock(const qint64 *dates, qsizetype count, qint64 now,
+                  DueFilter::Kernel kernel, Sink &&sink)
+{
+    const BlockFunction block = blockFunction(kernel);
+    const qsizetype fullBlocks = count / kBlockSize;
+
+    for (qsizetype b = 0; b < fullBlocks; ++b) {
+        sink(b, block(dates + b * kBlockSize, now));
+    }
+
+    const qsizetype tail = count - fullBlocks * kBlockSize;
+    if (tail > 0) {
+        sink(fullBlocks, dueTail(dates + fullBlocks * kBlockSize, tail, now));
+    }
+}
+
+} // namespace
+
+DueFilter::Kernel DueFilter::bestKernel()
+{
+    static const Kernel best = [] {
+#if defined(QTCARDS_DUEFILTER_X86)
+        return cpuHasAvx2() ? Kernel::Avx2 : Kernel::Sse2;
+#else
+        return Kernel::Scalar;
+#endif
+    }();
+    return best;
+}
+
+bool DueFilter::isSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::Scalar:
+        return true;
+#if defined(QTCARDS_DUEFILTER_X86)
+    case Kernel::Sse2:
+        return true;
+    case Kernel::Avx2:
+        return bestKernel() == Kernel::Avx2;
+#endif
+    default:
+        return false;
+    }
+}
+
+qsizetype DueFilter::countDue(const qint64 *dates, qsizetype count, qint64 now, Kernel kernel)
+{
+    qsizetype due = 0;
+    forEachBlock(dates, count, now, kernel, [&due](qsizetype, quint64 bits) {
+        due += qPopulationCount(bits);
+    });
+    return due;
+}
+
+/**
+ * @brief Записать позиции наступивших дат в порядке возрастания
+ *
+ * Позиции извлекаются из маски блока по младшему установленному биту,
+ * поэтому стоимость пропорциональна числу наступивших дат, а не размеру блока.
+ */
+qsizetype DueFilter::compactDue(const qint64 *dates, qsizetype count, qint64 now, int *rows, Kernel kernel)
+{
+    qsizetype written = 0;
+    forEachBlock(dates, count, now, kernel, [&written, rows](qsizetype block, quint64 bits) {
+        const int base = static_cast<int>(block * kBlockSize);
+        while (bits) {
+            rows[written++] = base + static_cast<int>(qCountTrailingZeroBits(bits));
+            bits &= bits - 1;
+        }
+    });
+    return written;
+}
+
+void DueFilter::dueBitmap(const qint64 *dates, qsizetype count, qint64 now, quint64 *bits, Kernel kernel)
+{
+    forEachBlock(dates, count, now, kernel, [bits](qsizetype block, quint64 word) {
+        bits[block] = word;
+    });
+}
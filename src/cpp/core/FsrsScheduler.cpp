@@ -0,0 +1,244 @@
+#include "FsrsScheduler.h"
+#include "FsrsModel.h"
+#include "SM2.h"
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+constexpr float kMinDifficulty = float(FsrsModel::kMinDifficulty);
+constexpr float kMaxDifficulty = float(FsrsModel::kMaxDifficulty);
+constexpr float kMinStability = float(FsrsModel::kMinStability);
+
+/// Ответов в одном участке истории при оценке параметров
+constexpr qsizetype kShardReviews = 1 << 16;
+
+/// Вероятность ограничивается, чтобы логарифм оставался конечным
+constexpr double kEpsilon = 1e-6;
+
+float easyFactorFromDifficulty(float difficulty)
+{
+    return SM2::kMaxEasyFactor - (difficulty - kMinDifficulty) / (kMaxDifficulty - kMinDifficulty)
+                                     * (SM2::kMaxEasyFactor - SM2::kMinEasyFactor);
+}
+
+float difficultyFromEasyFactor(float easyFactor)
+{
+    const float clamped = std::clamp(easyFactor, SM2::kMinEasyFactor, SM2::kMaxEasyFactor);
+    return kMinDifficulty + (SM2::kMaxEasyFactor - clamped) / (SM2::kMaxEasyFactor - SM2::kMinEasyFactor)
+                                * (kMaxDifficulty - kMinDifficulty);
+}
+
+/**
+ * @brief Частичные суммы оценки по одному участку истории
+ */
+struct PartialEvaluation {
+    double loss = 0.0;
+    double predicted = 0.0;
+    double actual = 0.0;
+    qint64 count = 0;
+};
+
+} // namespace
+
+FsrsScheduler::FsrsScheduler()
+    : FsrsScheduler(Parameters())
+{}
+
+FsrsScheduler::FsrsScheduler(const Parameters &parameters)
+    : params(parameters)
+{
+    const double retention = std::clamp(params.desiredRetention, 0.01, 0.99);
+    intervalFactor = (std::pow(retention, 1.0 / FsrsModel::kDecay) - 1.0) / FsrsModel::kFactor;
+}
+
+FsrsScheduler::Weights FsrsScheduler::defaultWeights()
+{
+    return {0.4872f, 1.4003f, 3.7145f, 13.8206f, 5.1618f, 1.2298f, 0.8975f, 0.031f, 1.6474f,
+            0.1367f, 1.0461f, 2.1072f, 0.0793f, 0.3246f, 1.587f, 0.2272f, 2.8755f};
+}
+
+const FsrsScheduler::Parameters &FsrsScheduler::parameters() const
+{
+    return params;
+}
+
+QString FsrsScheduler::name() const
+{
+    return QStringLiteral("FSRS");
+}
+
+int FsrsScheduler::rating(int grade)
+{
+    return std::max(1, std::min(grade, 5) - 1);
+}
+
+/**
+ * @brief Применить оценку к состоянию
+ *
+ * 1. Неизвестное состояние: у изученной карточки выводится из полей SM-2,
+ *    у новой - начальные S = w[G-1] и D = w4 - (G-3) w5.
+ * 2. Вероятность вспомнить R к моменту ответа.
+ * 3. Стабильность и трудность пересчитываются по формулам FsrsModel;
+ *    стабильность - по прежней трудности.
+ * 4. Интервал - nextInterval(S).
+ */
+void FsrsScheduler::review(SchedulingState &state, int grade, double elapsedDays) const
+{
+    const Weights &w = params.weights;
+    const int g = rating(grade);
+
+    if (state.stability <= 0.0f && state.intervalDays > 0) {
+        state.stability = std::max(kMinStability, float(state.intervalDays / intervalFactor));
+    }
+    if (state.difficulty <= 0.0f && state.intervalDays > 0) {
+        state.difficulty = difficultyFromEasyFactor(state.easyFactor);
+    }
+
+    if (state.stability <= 0.0f) {
+        state.stability = float(FsrsModel::initialStability<double>(w, g));
+        state.difficulty = float(FsrsModel::initialDifficulty<double>(w, g));
+    } else {
+        const double s = state.stability;
+        const double d = state.difficulty;
+        const double r = FsrsModel::retrievability(s, elapsedDays);
+        state.stability = float(FsrsModel::nextStability(w, s, d, r, g));
+        state.difficulty = float(FsrsModel::nextDifficulty(w, d, g));
+    }
+
+    state.intervalDays = nextInterval(state.stability);
+    state.easyFactor = easyFactorFromDifficulty(state.difficulty);
+    state.repetitions++;
+}
+
+double FsrsScheduler::retrievability(const SchedulingState &state, double elapsedDays) const
+{
+    if (state.stability <= 0.0f) {
+        return 0.0;
+    }
+    return FsrsModel::retrievability(double(state.stability), elapsedDays);
+}
+
+int FsrsScheduler::nextInterval(float stability) const
+{
+    const double days = std::round(stability * intervalFactor);
+    return int(std::clamp(days, 1.0, double(std::max(1, params.maximumInterval))));
+}
+
+/**
+ * @brief Оценить наборы параметров на истории ответов
+ *
+ * 1. Индексы записей сортируются по (карточка, момент ответа); оценки
+ *    и интервалы между ответами упаковываются в плотные массивы.
+ * 2. Карточки делятся на участки примерно по kShardReviews ответов.
+ *    Границы участков зависят только от истории, поэтому суммы
+ *    складываются в одном и том же порядке при любом числе потоков.
+ * 3. Пары (набор, участок) разбираются потоками пула.
+ *
+ * Сложность алгоритма: O(n log n + n c), c - количество наборов
+ */
+QList<FsrsScheduler::Evaluation> FsrsScheduler::evaluate(const QList<ReviewRecord> &history,
+                                                         const QList<Parameters> &candidates,
+                                                         int threadCount)
+{
+    QList<Evaluation> results(candidates.size());
+    if (history.isEmpty() || candidates.isEmpty()) {
+        return results;
+    }
+
+    QList<int> order(history.size());
+    for (qsizetype i = 0; i < order.size(); ++i) {
+        order[i] = int(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&history](int a, int b) {
+        const ReviewRecord &left = history[a];
+        const ReviewRecord &right = history[b];
+        return left.cardId != right.cardId ? left.cardId < right.cardId
+                                           : left.reviewedAt < right.reviewedAt;
+    });
+
+    QList<int> grades(history.size());
+    QList<float> elapsed(history.size());
+    QList<qsizetype> cardStarts;
+    for (qsizetype i = 0; i < order.size(); ++i) {
+        const ReviewRecord &record = history[order[i]];
+        grades[i] = record.grade;
+        if (i == 0 || history[order[i - 1]].cardId != record.cardId) {
+            cardStarts.append(i);
+            elapsed[i] = 0.0f;
+        } else {
+            elapsed[i] = float(elapsedDays(history[order[i - 1]].reviewedAt, record.reviewedAt));
+        }
+    }
+    cardStarts.append(order.size());
+
+    // Участок - непрерывный диапазон карточек [shardStarts[k], shardStarts[k + 1])
+    QList<qsizetype> shardStarts = {0};
+    for (qsizetype card = 1; card + 1 < cardStarts.size(); ++card) {
+        if (cardStarts[card] - cardStarts[shardStarts.last()] >= kShardReviews) {
+            shardStarts.append(card);
+        }
+    }
+    shardStarts.append(cardStarts.size() - 1);
+    const qsizetype shardCount = shardStarts.size() - 1;
+
+    const qsizetype itemCount = candidates.size() * shardCount;
+    QList<PartialEvaluation> partials(itemCount);
+    PartialEvaluation *partial = partials.data();
+    std::atomic<qsizetype> nextItem{0};
+
+    auto worker = [&]() {
+        for (qsizetype item = nextItem.fetch_add(1); item < itemCount; item = nextItem.fetch_add(1)) {
+            const FsrsScheduler scheduler(candidates[item / shardCount]);
+            const qsizetype shard = item % shardCount;
+            PartialEvaluation &sums = partial[item];
+            for (qsizetype card = shardStarts[shard]; card < shardStarts[shard + 1]; ++card) {
+                SchedulingState state;
+                for (qsizetype i = cardStarts[card]; i < cardStarts[card + 1]; ++i) {
+                    if (i != cardStarts[card]) {
+                        const double r = std::clamp(scheduler.retrievability(state, elapsed[i]),
+                                                    kEpsilon, 1.0 - kEpsilon);
+                        const bool recalled = grades[i] >= 3;
+                        sums.loss -= recalled ? std::log(r) : std::log(1.0 - r);
+                        sums.predicted += r;
+                        sums.actual += recalled ? 1.0 : 0.0;
+                        ++sums.count;
+                    }
+                    scheduler.review(state, grades[i], elapsed[i]);
+                }
+            }
+        }
+    };
+
+    QThreadPool pool;
+    if (threadCount > 0) {
+        pool.setMaxThreadCount(threadCount);
+    }
+    const qsizetype workers = std::min<qsizetype>(pool.maxThreadCount(), itemCount);
+    for (qsizetype i = 1; i < workers; ++i) {
+        pool.start(worker);
+    }
+    worker();
+    pool.waitForDone();
+
+    for (qsizetype candidate = 0; candidate < candidates.size(); ++candidate) {
+        PartialEvaluation sums;
+        for (qsizetype shard = 0; shard < shardCount; ++shard) {
+            const PartialEvaluation &part = partials[candidate * shardCount + shard];
+            sums.loss += part.loss;
+            sums.predicted += part.predicted;
+            sums.actual += part.actual;
+            sums.count += part.count;
+        }
+        Evaluation &result = results[candidate];
+        result.predictions = sums.count;
+        if (sums.count > 0) {
+            result.logLoss = sums.loss / double(sums.count);
+            result.predictedRecall = sums.predicted / double(sums.count);
+            result.actualRecall = sums.actual / double(sums.count);
+        }
+    }
+    return results;
+}
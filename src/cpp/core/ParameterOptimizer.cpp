@@ -0,0 +1,535 @@
+#include "ParameterOptimizer.h"
+#include "FsrsModel.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+constexpr int kWeightCount = FsrsScheduler::kWeightCount;
+
+/// Производных в дуальном числе: число весов, дополненное до кратного 4,
+/// чтобы циклы по производным векторизовались без хвоста
+constexpr int kLanes = (kWeightCount + 3) / 4 * 4;
+
+/// Ответов в одном участке истории
+constexpr qsizetype kShardReviews = 1 << 14;
+
+/// Вероятность ограничивается, чтобы логарифм оставался конечным
+constexpr double kEpsilon = 1e-6;
+
+/// Допустимые диапазоны весов (как в оптимизаторе FSRS-4.5)
+constexpr std::array<double, kWeightCount> kLowerBounds = {
+    0.1, 0.1, 0.1, 0.1, 1.0, 0.1, 0.1, 0.0, 0.0, 0.0, 0.01, 0.5, 0.01, 0.01, 0.01, 0.0, 1.0};
+constexpr std::array<double, kWeightCount> kUpperBounds = {
+    100.0, 100.0, 100.0, 100.0, 10.0, 5.0, 5.0, 0.75, 4.0, 0.8, 3.0, 5.0, 0.2, 0.9, 3.0, 1.0, 6.0};
+
+// =============== ДУАЛЬНЫЕ ЧИСЛА ===============
+
+/**
+ * @brief Значение и его производные по всем весам
+ *
+ * Прямое автоматическое дифференцирование: каждая операция вычисляет
+ * значение и по цепному правилу - производные результата.
+ */
+struct Dual {
+    double value = 0.0;
+    std::array<double, kLanes> grad{};
+
+    Dual() = default;
+    Dual(double constant) : value(constant) {}
+};
+
+/**
+ * @brief f(x) по значению f и производной f'(x)
+ */
+inline Dual chain(const Dual &x, double value, double derivative)
+{
+    Dual result(value);
+    for (int i = 0; i < kLanes; ++i) {
+        result.grad[i] = derivative * x.grad[i];
+    }
+    return result;
+}
+
+inline Dual operator+(const Dual &a, const Dual &b)
+{
+    Dual result(a.value + b.value);
+    for (int i = 0; i < kLanes; ++i) {
+        result.grad[i] = a.grad[i] + b.grad[i];
+    }
+    return result;
+}
+
+inline Dual operator-(const Dual &a, const Dual &b)
+{
+    Dual result(a.value - b.value);
+    for (int i = 0; i < kLanes; ++i) {
+        result.grad[i] = a.grad[i] - b.grad[i];
+    }
+    return result;
+}
+
+inline Dual operator*(const Dual &a, const Dual &b)
+{
+    Dual result(a.value * b.value);
+    for (int i = 0; i < kLanes; ++i) {
+        result.grad[i] = a.grad[i] * b.value + b.grad[i] * a.value;
+    }
+    return result;
+}
+
+inline Dual operator+(const Dual &a, double b)
+{
+    Dual result = a;
+    result.value += b;
+    return result;
+}
+
+inline Dual operator+(double a, const Dual &b)
+{
+    return b + a;
+}
+
+inline Dual operator-(const Dual &a, double b)
+{
+    return a + -b;
+}
+
+inline Dual operator-(double a, const Dual &b)
+{
+    return chain(b, a - b.value, -1.0);
+}
+
+inline Dual operator-(const Dual &a)
+{
+    return chain(a, -a.value, -1.0);
+}
+
+inline Dual operator*(const Dual &a, double b)
+{
+    return chain(a, a.value * b, b);
+}
+
+inline Dual operator/(double a, const Dual &b)
+{
+    const double value = a / b.value;
+    return chain(b, value, -value / b.value);
+}
+
+inline Dual &operator-=(Dual &a, const Dual &b)
+{
+    a.value -= b.value;
+    for (int i = 0; i < kLanes; ++i) {
+        a.grad[i] -= b.grad[i];
+    }
+    return a;
+}
+
+inline Dual exp(const Dual &x)
+{
+    const double value = std::exp(x.value);
+    return chain(x, value, value);
+}
+
+inline Dual log(const Dual &x)
+{
+    return chain(x, std::log(x.value), 1.0 / x.value);
+}
+
+inline Dual pow(const Dual &x, double exponent)
+{
+    const double value = std::pow(x.value, exponent);
+    return chain(x, value, exponent * value / x.value);
+}
+
+/**
+ * @brief Ограничение: за границей значение постоянно, производные нулевые
+ */
+inline Dual clampTo(const Dual &x, double low, double high)
+{
+    if (x.value < low) {
+        return Dual(low);
+    }
+    if (x.value > high) {
+        return Dual(high);
+    }
+    return x;
+}
+
+inline Dual minOf(const Dual &a, const Dual &b)
+{
+    return a.value <= b.value ? a : b;
+}
+
+// =============== ИСТОРИЯ ===============
+
+/**
+ * @brief История, упакованная по карточкам
+ */
+struct PackedHistory {
+    QList<qint8> ratings;           ///< Рейтинг FSRS (1-4) каждого ответа
+    QList<float> elapsed;           ///< Дней с прошлого ответа той же карточки; 0 для первого
+    QList<qsizetype> cardStarts;    ///< Первый ответ карточки; последний элемент - общее число
+    QList<qsizetype> shardStarts;   ///< Первая карточка участка; последний элемент - число карточек
+
+    qsizetype shardCount() const { return shardStarts.size() - 1; }
+
+    qsizetype shardReviews(qsizetype shard) const
+    {
+        return cardStarts[shardStarts[shard + 1]] - cardStarts[shardStarts[shard]];
+    }
+};
+
+/**
+ * @brief Частичная сумма потери и градиента по участку
+ */
+struct Partial {
+    double loss = 0.0;
+    std::array<double, kLanes> grad{};
+    qint64 count = 0;
+};
+
+/**
+ * @brief Воспроизвести историю участка и накопить потерю
+ *
+ * Первый ответ карточки задает начальное состояние; перед каждым
+ * следующим модель предсказывает вероятность вспомнить.
+ */
+template <typename T, typename Weights>
+void replayShard(const Weights &w, const PackedHistory &history, qsizetype shard, T &loss, qint64 &count)
+{
+    using FsrsModel::clampTo;
+    using std::log;
+    const qint8 *ratings = history.ratings.constData();
+    const float *elapsed = history.elapsed.constData();
+    for (qsizetype card = history.shardStarts[shard]; card < history.shardStarts[shard + 1]; ++card) {
+        const qsizetype first = history.cardStarts[card];
+        const qsizetype last = history.cardStarts[card + 1];
+        T stability = FsrsModel::initialStability<T>(w, ratings[first]);
+        T difficulty = FsrsModel::initialDifficulty<T>(w, ratings[first]);
+        for (qsizetype i = first + 1; i < last; ++i) {
+            const int rating = ratings[i];
+            const T r = FsrsModel::retrievability(stability, elapsed[i]);
+            const T p = clampTo(r, kEpsilon, 1.0 - kEpsilon);
+            loss -= rating > 1 ? log(p) : log(1.0 - p);
+            ++count;
+
+            const T next = FsrsModel::nextStability(w, stability, difficulty, r, rating);
+            difficulty = FsrsModel::nextDifficulty(w, difficulty, rating);
+            stability = next;
+        }
+    }
+}
+
+/**
+ * @brief Выполнить task(0..count-1) потоками пула и дождаться завершения
+ */
+void runParallel(QThreadPool &pool, qsizetype count, const std::function<void(qsizetype)> &task)
+{
+    std::atomic<qsizetype> next{0};
+    auto worker = [&]() {
+        for (qsizetype item = next.fetch_add(1); item < count; item = next.fetch_add(1)) {
+            task(item);
+        }
+    };
+    const qsizetype workers = std::min<qsizetype>(pool.maxThreadCount(), count);
+    for (qsizetype i = 1; i < workers; ++i) {
+        pool.start(worker);
+    }
+    worker();
+    pool.waitForDone();
+}
+
+/**
+ * @brief Средняя потеря по всей истории
+ */
+double meanLogLoss(QThreadPool &pool, const PackedHistory &history,
+                   const std::array<double, kWeightCount> &weights, qint64 *predictions)
+{
+    QList<Partial> partials(history.shardCount());
+    Partial *partial = partials.data();
+    runParallel(pool, history.shardCount(), [&](qsizetype shard) {
+        Partial &sums = partial[shard];
+        replayShard(weights, history, shard, sums.loss, sums.count);
+    });
+
+    double loss = 0.0;
+    qint64 count = 0;
+    for (const Partial &partial : std::as_const(partials)) {
+        loss += partial.loss;
+        count += partial.count;
+    }
+    if (predictions) {
+        *predictions = count;
+    }
+    return count > 0 ? loss / double(count) : 0.0;
+}
+
+} // namespace
+
+ParameterOptimizer::ParameterOptimizer()
+    : ParameterOptimizer(Options())
+{}
+
+ParameterOptimizer::ParameterOptimizer(const Options &options)
+    : options(options)
+{}
+
+void ParameterOptimizer::addReview(int cardId, int grade, qint64 reviewedAt)
+{
+    cardIds.append(cardId);
+    reviewTimes.append(reviewedAt);
+    grades.append(qint8(qBound(0, grade, 5)));
+}
+
+void ParameterOptimizer::addReviews(const QList<ReviewRecord> &records)
+{
+    reserve(reviewCount() + records.size());
+    for (const ReviewRecord &record : records) {
+        addReview(record.cardId, record.grade, record.reviewedAt);
+    }
+}
+
+void ParameterOptimizer::reserve(qsizetype count)
+{
+    cardIds.reserve(count);
+    reviewTimes.reserve(count);
+    grades.reserve(count);
+}
+
+qsizetype ParameterOptimizer::reviewCount() const
+{
+    return cardIds.size();
+}
+
+void ParameterOptimizer::clear()
+{
+    cardIds.clear();
+    reviewTimes.clear();
+    grades.clear();
+}
+
+/**
+ * @brief Подобрать веса по накопленной истории
+ *
+ * 1. Упаковка: карточки нумеруются по возрастанию идентификатора,
+ *    ответы раскладываются по карточкам подсчетом (O(n)) и внутри
+ *    карточки упорядочиваются по времени. Порядок добавления поэтому
+ *    не влияет на результат.
+ * 2. Карточки делятся на участки около kShardReviews ответов.
+ * 3. Каждая эпоха перемешивает участки (зерно options.seed) и нарезает
+ *    их на мини-пакеты около batchReviews ответов. Участки пакета
+ *    считаются параллельно на дуальных числах, градиент сводится
+ *    по порядку и делает шаг Adam; веса ограничиваются допустимыми
+ *    диапазонами.
+ *
+ * Сложность алгоритма: O(n) на упаковку плюс O(e n w) на обучение,
+ * e - эпохи, w - количество весов
+ */
+bool ParameterOptimizer::fit()
+{
+    summary = Result();
+    errorText.clear();
+    QElapsedTimer timer;
+    timer.start();
+
+    const qsizetype count = reviewCount();
+    if (count == 0) {
+        return fail(QStringLiteral("Review history is empty"));
+    }
+    if (options.epochs < 1 || options.batchReviews < 1) {
+        return fail(QStringLiteral("Epochs and batch size must be positive"));
+    }
+    if (!(options.learningRate > 0.0) || !std::isfinite(options.learningRate)) {
+        return fail(QStringLiteral("Learning rate must be positive"));
+    }
+
+    // Карточки по возрастанию идентификатора
+    QHash<int, int> cardById;
+    for (int id : std::as_const(cardIds)) {
+        cardById.insert(id, 0);
+    }
+    QList<int> sortedIds = cardById.keys();
+    std::sort(sortedIds.begin(), sortedIds.end());
+    for (qsizetype card = 0; card < sortedIds.size(); ++card) {
+        cardById[sortedIds[card]] = int(card);
+    }
+
+    PackedHistory history;
+    const qsizetype cards = sortedIds.size();
+    QList<int> cardOfReview(count);
+    history.cardStarts.fill(0, cards + 1);
+    for (qsizetype i = 0; i < count; ++i) {
+        const int card = cardById.value(cardIds[i]);
+        cardOfReview[i] = card;
+        ++history.cardStarts[card + 1];
+    }
+    cardById.clear();
+    for (qsizetype card = 0; card < cards; ++card) {
+        history.cardStarts[card + 1] += history.cardStarts[card];
+    }
+
+    QList<qsizetype> order(count);
+    {
+        QList<qsizetype> fill(history.cardStarts.constBegin(), history.cardStarts.constEnd() - 1);
+        for (qsizetype i = 0; i < count; ++i) {
+            order[fill[cardOfReview[i]]++] = i;
+        }
+    }
+    cardOfReview.clear();
+
+    const qint64 *times = reviewTimes.constData();
+    history.ratings.resize(count);
+    history.elapsed.resize(count);
+    for (qsizetype card = 0; card < cards; ++card) {
+        const auto first = order.begin() + history.cardStarts[card];
+        const auto last = order.begin() + history.cardStarts[card + 1];
+        const auto byTime = [times](qsizetype a, qsizetype b) { return times[a] < times[b]; };
+        if (!std::is_sorted(first, last, byTime)) {
+            std::stable_sort(first, last, byTime);
+        }
+        for (auto it = first; it != last; ++it) {
+            const qsizetype i = it - order.begin();
+            history.ratings[i] = qint8(FsrsScheduler::rating(grades[*it]));
+            history.elapsed[i] = it == first
+                                     ? 0.0f
+                                     : float(Scheduler::elapsedDays(times[*(it - 1)], times[*it]));
+        }
+    }
+    order.clear();
+
+    history.shardStarts.append(0);
+    for (qsizetype card = 1; card < cards; ++card) {
+        if (history.cardStarts[card] - history.cardStarts[history.shardStarts.last()] >= kShardReviews) {
+            history.shardStarts.append(card);
+        }
+    }
+    history.shardStarts.append(cards);
+    const qsizetype shardCount = history.shardCount();
+
+    QThreadPool pool;
+    if (options.threadCount > 0) {
+        pool.setMaxThreadCount(options.threadCount);
+    }
+
+    std::array<double, kWeightCount> weights;
+    for (int j = 0; j < kWeightCount; ++j) {
+        weights[j] = std::clamp(double(options.initialWeights[j]), kLowerBounds[j], kUpperBounds[j]);
+    }
+    summary.reviews = count;
+    summary.cards = int(cards);
+    summary.initialLogLoss = meanLogLoss(pool, history, weights, &summary.predictions);
+
+    // Adam
+    constexpr double kBeta1 = 0.9;
+    constexpr double kBeta2 = 0.999;
+    constexpr double kAdamEpsilon = 1e-8;
+    std::array<double, kWeightCount> firstMoment{};
+    std::array<double, kWeightCount> secondMoment{};
+    double beta1Power = 1.0;
+    double beta2Power = 1.0;
+
+    QList<qsizetype> shardOrder(shardCount);
+    for (qsizetype shard = 0; shard < shardCount; ++shard) {
+        shardOrder[shard] = shard;
+    }
+    QList<Partial> partials(shardCount);
+    Partial *partial = partials.data();
+    QRandomGenerator random(options.seed);
+
+    for (int epoch = 0; epoch < options.epochs; ++epoch) {
+        std::shuffle(shardOrder.begin(), shardOrder.end(), random);
+        double epochLoss = 0.0;
+        qint64 epochCount = 0;
+
+        qsizetype batchBegin = 0;
+        while (batchBegin < shardCount) {
+            qsizetype batchEnd = batchBegin;
+            qsizetype batchReviews = 0;
+            while (batchEnd < shardCount && (batchEnd == batchBegin || batchReviews < options.batchReviews)) {
+                batchReviews += history.shardReviews(shardOrder[batchEnd]);
+                ++batchEnd;
+            }
+
+            std::array<Dual, kWeightCount> dualWeights;
+            for (int j = 0; j < kWeightCount; ++j) {
+                dualWeights[j] = Dual(weights[j]);
+                dualWeights[j].grad[j] = 1.0;
+            }
+            runParallel(pool, batchEnd - batchBegin, [&](qsizetype item) {
+                Dual loss;
+                Partial &sums = partial[batchBegin + item];
+                sums.count = 0;
+                replayShard(dualWeights, history, shardOrder[batchBegin + item], loss, sums.count);
+                sums.loss = loss.value;
+                sums.grad = loss.grad;
+            });
+
+            Partial batch;
+            for (qsizetype k = batchBegin; k < batchEnd; ++k) {
+                batch.loss += partials[k].loss;
+                batch.count += partials[k].count;
+                for (int j = 0; j < kWeightCount; ++j) {
+                    batch.grad[j] += partials[k].grad[j];
+                }
+            }
+            batchBegin = batchEnd;
+            if (batch.count == 0) {
+                continue;
+            }
+            epochLoss += batch.loss;
+            epochCount += batch.count;
+
+            beta1Power *= kBeta1;
+            beta2Power *= kBeta2;
+            for (int j = 0; j < kWeightCount; ++j) {
+                const double gradient = batch.grad[j] / double(batch.count);
+                firstMoment[j] = kBeta1 * firstMoment[j] + (1.0 - kBeta1) * gradient;
+                secondMoment[j] = kBeta2 * secondMoment[j] + (1.0 - kBeta2) * gradient * gradient;
+                const double corrected = firstMoment[j] / (1.0 - beta1Power);
+                const double scale = std::sqrt(secondMoment[j] / (1.0 - beta2Power)) + kAdamEpsilon;
+                weights[j] = std::clamp(weights[j] - options.learningRate * corrected / scale,
+                                        kLowerBounds[j], kUpperBounds[j]);
+            }
+            ++summary.steps;
+        }
+        summary.epochLogLoss.append(epochCount > 0 ? epochLoss / double(epochCount) : 0.0);
+    }
+
+    summary.finalLogLoss = meanLogLoss(pool, history, weights, nullptr);
+    for (int j = 0; j < kWeightCount; ++j) {
+        summary.weights[j] = float(weights[j]);
+    }
+    summary.elapsedMSecs = timer.elapsed();
+    return true;
+}
+
+const ParameterOptimizer::Result &ParameterOptimizer::result() const
+{
+    return summary;
+}
+
+FsrsScheduler::Parameters ParameterOptimizer::fittedParameters(double desiredRetention) const
+{
+    FsrsScheduler::Parameters parameters;
+    parameters.weights = summary.weights;
+    parameters.desiredRetention = desiredRetention;
+    return parameters;
+}
+
+QString ParameterOptimizer::lastError() const
+{
+    return errorText;
+}
+
+bool ParameterOptimizer::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
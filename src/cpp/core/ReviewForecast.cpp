@@ -0,0 +1,166 @@
+#include "ReviewForecast.h"
+#include "Deck.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <algorithm>
+
+ReviewForecast::ReviewForecast(const QDateTime &now, int days)
+    : start(now.toMSecsSinceEpoch())
+{
+    days = std::max(1, days);
+    dayEnds.reserve(days);
+    const QDate today = now.date();
+    for (int day = 0; day < days; day++) {
+        // startOfDay() учитывает переход на летнее время
+        dayEnds.append(today.addDays(day + 1).startOfDay().toMSecsSinceEpoch());
+    }
+    buckets.fill(0, days);
+}
+
+/**
+ * @brief Прогноз по нескольким колодам
+ *
+ * Колоды раздаются потокам чередованием (i, i + t, i + 2t, ...), чтобы
+ * большие и маленькие колоды распределились равномерно без сортировки.
+ * Поток вызова тоже считает свою долю.
+ */
+ReviewForecast ReviewForecast::forDecks(const QList<const Deck *> &decks, const QDateTime &now,
+                                        int days, int threadCount)
+{
+    ReviewForecast result(now, days);
+
+    QThreadPool pool;
+    if (threadCount > 0) {
+        pool.setMaxThreadCount(threadCount);
+    }
+    const int workers = static_cast<int>(std::clamp<qsizetype>(
+        qsizetype(pool.maxThreadCount()), 1, std::max<qsizetype>(1, decks.size())));
+
+    // Пустой прогноз с теми же границами дней - заготовка для потоков
+    const ReviewForecast blank = result;
+    QMutex mutex;
+    auto accumulate = [&](int first) {
+        ReviewForecast partial(blank);
+        for (qsizetype i = first; i < decks.size(); i += workers) {
+            if (decks[i]) {
+                partial.addIndex(decks[i]->dueIndex);
+            }
+        }
+        QMutexLocker locker(&mutex);
+        result.merge(partial);
+    };
+
+    for (int worker = 1; worker < workers; worker++) {
+        pool.start([&accumulate, worker]() { accumulate(worker); });
+    }
+    accumulate(0);
+    pool.waitForDone();
+    return result;
+}
+
+// ==================== ACCUMULATION ====================
+
+/**
+ * @brief Добавить карточки индекса повторений
+ *
+ * Индекс отсортирован по сроку, поэтому граница каждого дня находится
+ * бинарным поиском в остатке индекса после границы предыдущего дня.
+ *
+ * Сложность алгоритма: O(d log n)
+ */
+void ReviewForecast::addIndex(const DueIndex &index)
+{
+    auto first = index.begin();
+    const auto end = index.end();
+    for (int day = 0; day < dayEnds.size() && first != end; day++) {
+        const qint64 dayEnd = dayEnds[day];
+        const auto last = std::lower_bound(first, end, dayEnd,
+            [](const DueIndex::Entry &entry, qint64 key) { return entry.dueAt < key; });
+        buckets[day] += static_cast<int>(last - first);
+        first = last;
+    }
+    beyond += static_cast<int>(end - first);
+}
+
+bool ReviewForecast::merge(const ReviewForecast &other)
+{
+    if (other.dayEnds != dayEnds) {
+        return false;
+    }
+    for (int day = 0; day < buckets.size(); day++) {
+        buckets[day] += other.buckets[day];
+    }
+    beyond += other.beyond;
+    return true;
+}
+
+void ReviewForecast::cardAdded(qint64 dueAt)
+{
+    const int day = dayOf(dueAt);
+    if (day < buckets.size()) {
+        buckets[day]++;
+    } else {
+        beyond++;
+    }
+}
+
+void ReviewForecast::cardRemoved(qint64 dueAt)
+{
+    const int day = dayOf(dueAt);
+    if (day < buckets.size()) {
+        buckets[day]--;
+    } else {
+        beyond--;
+    }
+}
+
+void ReviewForecast::cardRescheduled(qint64 oldDueAt, qint64 newDueAt)
+{
+    cardRemoved(oldDueAt);
+    cardAdded(newDueAt);
+}
+
+// ==================== RESULT ====================
+
+int ReviewForecast::days() const
+{
+    return static_cast<int>(buckets.size());
+}
+
+int ReviewForecast::count(int day) const
+{
+    return day >= 0 && day < buckets.size() ? buckets[day] : 0;
+}
+
+QList<int> ReviewForecast::counts() const
+{
+    return buckets;
+}
+
+int ReviewForecast::later() const
+{
+    return beyond;
+}
+
+qint64 ReviewForecast::total() const
+{
+    qint64 sum = beyond;
+    for (int count : buckets) {
+        sum += count;
+    }
+    return sum;
+}
+
+qint64 ReviewForecast::dayStart(int day) const
+{
+    if (day <= 0 || dayEnds.isEmpty()) {
+        return start;
+    }
+    return dayEnds[std::min<qsizetype>(day, dayEnds.size()) - 1];
+}
+
+int ReviewForecast::dayOf(qint64 dueAt) const
+{
+    return static_cast<int>(std::upper_bound(dayEnds.begin(), dayEnds.end(), dueAt) - dayEnds.begin());
+}
@@ -0,0 +1,471 @@
+#include "ReviewJournal.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <cstddef>
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// Сигнатура файла журнала
+constexpr char kMagic[4] = {'Q', 'C', 'R', 'J'};
+
+/// Версия формата записей
+constexpr quint32 kVersion = 1;
+
+/// Размер заголовка: сигнатура, версия, резерв
+constexpr qint64 kHeaderSize = 16;
+
+/**
+ * @brief Запись журнала в том виде, в каком она лежит на диске
+ *
+ * Поля упорядочены по убыванию размера, поэтому структура не содержит
+ * выравнивающих промежутков и копируется в файл как есть.
+ */
+struct DiskRecord {
+    qint64 sequence;
+    qint64 reviewedAt;
+    qint64 nextReview;
+    qint32 cardId;
+    qint32 grade;
+    float easyFactor;
+    qint32 intervalDays;
+    qint32 repetitions;
+    quint16 checksum;       ///< CRC-16 всех предыдущих полей
+    quint16 reserved;       ///< Всегда 0
+};
+
+static_assert(sizeof(DiskRecord) == 48, "Запись журнала должна иметь фиксированный размер без промежутков");
+
+constexpr qsizetype kChecksummedBytes = offsetof(DiskRecord, checksum);
+
+quint16 checksumOf(const DiskRecord &disk)
+{
+    return qChecksum(QByteArrayView(reinterpret_cast<const char *>(&disk), kChecksummedBytes));
+}
+
+DiskRecord toDisk(const ReviewRecord &record)
+{
+    DiskRecord disk;
+    std::memset(&disk, 0, sizeof(disk));
+    disk.sequence = record.sequence;
+    disk.reviewedAt = record.reviewedAt;
+    disk.nextReview = record.nextReview;
+    disk.cardId = record.cardId;
+    disk.grade = record.grade;
+    disk.easyFactor = record.easyFactor;
+    disk.intervalDays = record.intervalDays;
+    disk.repetitions = record.repetitions;
+    disk.checksum = checksumOf(disk);
+    return disk;
+}
+
+ReviewRecord fromDisk(const DiskRecord &disk)
+{
+    ReviewRecord record;
+    record.sequence = disk.sequence;
+    record.cardId = disk.cardId;
+    record.grade = disk.grade;
+    record.reviewedAt = disk.reviewedAt;
+    record.easyFactor = disk.easyFactor;
+    record.intervalDays = disk.intervalDays;
+    record.repetitions = disk.repetitions;
+    record.nextReview = disk.nextReview;
+    return record;
+}
+
+QByteArray makeHeader()
+{
+    QByteArray header(kHeaderSize, '\0');
+    std::memcpy(header.data(), kMagic, sizeof(kMagic));
+    std::memcpy(header.data() + sizeof(kMagic), &kVersion, sizeof(kVersion));
+    return header;
+}
+
+/**
+ * @brief Синхронизировать файл с диском
+ */
+bool syncFile(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#if defined(Q_OS_WIN)
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+/**
+ * @brief Прочитать целые записи открытого журнала
+ *
+ * Проверяет заголовок, затем читает записи, пока они целые, контрольная
+ * сумма сходится и номера возрастают. Все, что дальше, - оборванный
+ * при сбое хвост.
+ *
+ * @param records Прочитанные записи (может быть nullptr)
+ * @param validEnd Смещение конца последней целой записи
+ */
+bool scanJournal(QFile &file, QList<ReviewRecord> *records, qint64 *validEnd, QString *errorMessage)
+{
+    file.seek(0);
+    const QByteArray header = file.read(kHeaderSize);
+    quint32 version = 0;
+    if (header.size() == kHeaderSize) {
+        std::memcpy(&version, header.constData() + sizeof(kMagic), sizeof(version));
+    }
+    if (header.size() != kHeaderSize || std::memcmp(header.constData(), kMagic, sizeof(kMagic)) != 0
+        || version != kVersion) {
+        if (errorMessage) {
+            *errorMessage = QString("%1 is not a review journal").arg(file.fileName());
+        }
+        return false;
+    }
+
+    *validEnd = kHeaderSize;
+    qint64 lastSequence = 0;
+    DiskRecord disk;
+    while (file.read(reinterpret_cast<char *>(&disk), sizeof(disk)) == sizeof(disk)) {
+        if (disk.checksum != checksumOf(disk) || disk.sequence <= lastSequence) {
+            break;
+        }
+        lastSequence = disk.sequence;
+        *validEnd += sizeof(disk);
+        if (records) {
+            records->append(fromDisk(disk));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+ReviewJournal::ReviewJournal(const QString &path) : ReviewJournal(path, Options()) {}
+
+ReviewJournal::ReviewJournal(const QString &path, const Options &options)
+    : path(path), options(options) {}
+
+ReviewJournal::~ReviewJournal()
+{
+    close();
+}
+
+/**
+ * @brief Открыть журнал и запустить фоновый поток
+ *
+ * Новый файл получает заголовок. У существующего файла отрезается
+ * оборванный хвост, а нумерация продолжается с последней целой записи.
+ */
+bool ReviewJournal::open()
+{
+    if (isOpen()) {
+        return true;
+    }
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        errorText = file.errorString();
+        return false;
+    }
+
+    qint64 lastSequence = 0;
+    if (file.size() == 0) {
+        if (file.write(makeHeader()) != kHeaderSize || !syncFile(file)) {
+            errorText = file.errorString();
+            file.close();
+            return false;
+        }
+    } else {
+        QList<ReviewRecord> records;
+        qint64 validEnd = 0;
+        if (!scanJournal(file, &records, &validEnd, &errorText)) {
+            file.close();
+            return false;
+        }
+        if (validEnd < file.size() && !file.resize(validEnd)) {
+            errorText = file.errorString();
+            file.close();
+            return false;
+        }
+        if (!records.isEmpty()) {
+            lastSequence = records.last().sequence;
+        }
+    }
+    file.seek(file.size());
+
+    {
+        QMutexLocker locker(&mutex);
+        nextSequence = lastSequence;
+        committed = lastSequence;
+        stopping = false;
+        failed = false;
+        flushRequested = false;
+    }
+
+    writer = QThread::create([this]() { writerLoop(); });
+    writer->start();
+    return true;
+}
+
+void ReviewJournal::close()
+{
+    if (!writer) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        writerWake.wakeOne();
+    }
+    writer->wait();
+    delete writer;
+    writer = nullptr;
+    file.close();
+}
+
+bool ReviewJournal::isOpen() const
+{
+    return writer != nullptr;
+}
+
+/**
+ * @brief Поставить запись в очередь на фиксацию
+ *
+ * Фоновый поток будится, только когда набралась полная группа; иначе
+ * он сам проснется по истечении интервала фиксации.
+ */
+qint64 ReviewJournal::append(const ReviewRecord &record)
+{
+    QMutexLocker locker(&mutex);
+    if (!writer || stopping || failed) {
+        return 0;
+    }
+
+    if (pending.isEmpty()) {
+        oldestPending.start();
+        writerWake.wakeOne();
+    }
+    pending.append(record);
+    pending.last().sequence = ++nextSequence;
+    ++counters.appended;
+
+    if (pending.size() >= options.maxBatchRecords) {
+        writerWake.wakeOne();
+    }
+    return nextSequence;
+}
+
+bool ReviewJournal::flush()
+{
+    QMutexLocker locker(&mutex);
+    const qint64 target = nextSequence;
+    if (committed < target) {
+        flushRequested = true;
+        writerWake.wakeOne();
+    }
+    while (committed < target && !failed) {
+        committedChanged.wait(&mutex);
+    }
+    return !failed;
+}
+
+/**
+ * @brief Перенести зафиксированные записи в хранилище и очистить журнал
+ *
+ * Пока идет перенос, фоновый поток не пишет в файл: новые ответы
+ * копятся в очереди и будут зафиксированы после очистки.
+ */
+bool ReviewJournal::checkpoint(ReviewSink &cards)
+{
+    if (!isOpen() || !flush()) {
+        return false;
+    }
+
+    QMutexLocker fileLocker(&fileMutex);
+    QList<ReviewRecord> records;
+    qint64 validEnd = 0;
+    QString error;
+    if (!scanJournal(file, &records, &validEnd, &error)
+        || (!records.isEmpty() && !cards.applyReviews(records))) {
+        // Фоновый поток продолжит дописывать с конца файла
+        file.seek(file.size());
+        QMutexLocker locker(&mutex);
+        errorText = error.isEmpty() ? cards.lastError() : error;
+        return false;
+    }
+
+    if (!file.resize(kHeaderSize) || !file.seek(kHeaderSize) || !syncFile(file)) {
+        QMutexLocker locker(&mutex);
+        errorText = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 ReviewJournal::committedSequence() const
+{
+    QMutexLocker locker(&mutex);
+    return committed;
+}
+
+void ReviewJournal::setCommitCallback(CommitCallback callback)
+{
+    commitCallback = std::move(callback);
+}
+
+ReviewJournal::Stats ReviewJournal::stats() const
+{
+    QMutexLocker locker(&mutex);
+    return counters;
+}
+
+QString ReviewJournal::lastError() const
+{
+    QMutexLocker locker(&mutex);
+    return errorText;
+}
+
+/**
+ * @brief Цикл фонового потока
+ *
+ * Ждет, пока группа не заполнится, не истечет интервал фиксации самой
+ * старой записи или не будет запрошен flush(). Затем забирает всю
+ * очередь целиком и пишет её без удержания мьютекса, так что append()
+ * не блокируется на время записи на диск. После ошибки записи поток
+ * завершается, а очередь отбрасывается.
+ */
+void ReviewJournal::writerLoop()
+{
+    QMutexLocker locker(&mutex);
+    while (!stopping || !pending.isEmpty()) {
+        if (pending.isEmpty()) {
+            writerWake.wait(&mutex);
+            continue;
+        }
+
+        if (pending.size() < options.maxBatchRecords && !flushRequested && !stopping) {
+            const qint64 remaining = options.flushIntervalMSecs - oldestPending.elapsed();
+            if (remaining > 0) {
+                writerWake.wait(&mutex, static_cast<unsigned long>(remaining));
+                continue;
+            }
+        }
+
+        QList<ReviewRecord> batch;
+        batch.swap(pending);
+        flushRequested = false;
+
+        locker.unlock();
+        const bool written = writeBatch(batch);
+        locker.relock();
+
+        if (!written) {
+            // Дальше оборванной группы писать нельзя: при чтении журнал
+            // обрывается на первой записи с неверной контрольной суммой
+            failed = true;
+            pending.clear();
+            committedChanged.wakeAll();
+            return;
+        }
+
+        committed = batch.last().sequence;
+        counters.committed += batch.size();
+        ++counters.groupCommits;
+        committedChanged.wakeAll();
+
+        if (commitCallback) {
+            const qint64 lastSequence = committed;
+            locker.unlock();
+            commitCallback(lastSequence);
+            locker.relock();
+        }
+    }
+}
+
+bool ReviewJournal::writeBatch(const QList<ReviewRecord> &batch)
+{
+    QByteArray bytes(batch.size() * qsizetype(sizeof(DiskRecord)), Qt::Uninitialized);
+    char *out = bytes.data();
+    for (const ReviewRecord &record : batch) {
+        const DiskRecord disk = toDisk(record);
+        std::memcpy(out, &disk, sizeof(disk));
+        out += sizeof(disk);
+    }
+
+    QMutexLocker fileLocker(&fileMutex);
+    const qint64 start = file.pos();
+    if (file.write(bytes) != bytes.size() || (options.syncToDisk ? !syncFile(file) : !file.flush())) {
+        QMutexLocker locker(&mutex);
+        errorText = file.errorString();
+        // Журнал должен заканчиваться целой записью; если отрезать хвост
+        // не удалось, его отбросит следующий open()
+        if (!file.resize(start) || !file.seek(start)) {
+            errorText += QString("; failed to truncate journal to %1 bytes").arg(start);
+        }
+        return false;
+    }
+    return true;
+}
+
+QList<ReviewRecord> ReviewJournal::readRecords(const QString &path, QString *errorMessage)
+{
+    QList<ReviewRecord> records;
+    QFile journal(path);
+    if (!journal.exists()) {
+        return records;
+    }
+    if (!journal.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = journal.errorString();
+        }
+        return records;
+    }
+
+    qint64 validEnd = 0;
+    scanJournal(journal, &records, &validEnd, errorMessage);
+    return records;
+}
+
+/**
+ * @brief Восстановить состояние после сбоя
+ *
+ * Записи хранят итоговое состояние карточек, поэтому повторное применение
+ * после сбоя посреди восстановления безопасно.
+ */
+int ReviewJournal::recover(const QString &path, ReviewSink &cards, QString *errorMessage)
+{
+    QString error;
+    const QList<ReviewRecord> records = readRecords(path, &error);
+    if (!error.isEmpty()) {
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        return -1;
+    }
+    if (records.isEmpty()) {
+        return 0;
+    }
+
+    if (!cards.applyReviews(records)) {
+        if (errorMessage) {
+            *errorMessage = cards.lastError();
+        }
+        return -1;
+    }
+
+    QFile journal(path);
+    if (!journal.open(QIODevice::ReadWrite) || !journal.resize(kHeaderSize) || !syncFile(journal)) {
+        if (errorMessage) {
+            *errorMessage = journal.errorString();
+        }
+        return -1;
+    }
+    return static_cast<int>(records.size());
+}
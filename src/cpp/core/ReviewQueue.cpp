@@ -0,0 +1,246 @@
+#include "ReviewQueue.h"
+#include "Deck.h"
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Порядок кучи: на вершине самый ранний срок, при равенстве -
+ *        колода, добавленная раньше
+ */
+template <typename Head>
+bool laterHead(const Head &a, const Head &b)
+{
+    if (a.dueAt != b.dueAt) {
+        return a.dueAt > b.dueAt;
+    }
+    return a.cursor > b.cursor;
+}
+
+} // namespace
+
+void ReviewQueue::addDeck(const Deck *deck)
+{
+    if (deck && !decks.contains(deck)) {
+        decks.append(deck);
+    }
+}
+
+void ReviewQueue::setDecks(const QList<const Deck *> &decks)
+{
+    this->decks.clear();
+    for (const Deck *deck : decks) {
+        addDeck(deck);
+    }
+}
+
+void ReviewQueue::setInterleave(Interleave interleave)
+{
+    this->interleave = interleave;
+}
+
+ReviewQueue::Interleave ReviewQueue::getInterleave() const
+{
+    return interleave;
+}
+
+void ReviewQueue::setDailyLimit(int limit)
+{
+    dailyLimit = limit < 0 ? kUnlimited : limit;
+}
+
+void ReviewQueue::setDeckLimit(int deckId, int limit)
+{
+    deckLimits.insert(deckId, limit < 0 ? kUnlimited : limit);
+}
+
+void ReviewQueue::setReviewedToday(int deckId, int count)
+{
+    reviewedToday.insert(deckId, qMax(0, count));
+}
+
+/**
+ * @brief Начать обход
+ *
+ * Строит курсоры колод и кучу их голов. Готовые карточки не копируются:
+ * голова каждой колоды - первый элемент её индекса повторений.
+ *
+ * Сложность алгоритма: O(k log n)
+ */
+void ReviewQueue::start(qint64 nowMSecs)
+{
+    now = nowMSecs;
+    turn = 0;
+    cursors.clear();
+    heap.clear();
+    cursors.reserve(decks.size());
+
+    for (const Deck *deck : decks) {
+        Cursor cursor;
+        cursor.deck = deck;
+        cursor.budget = deckLimits.value(deck->getId(), dailyLimit);
+        if (cursor.budget != kUnlimited) {
+            cursor.budget = qMax(0, cursor.budget - reviewedToday.value(deck->getId()));
+        }
+        cursors.append(cursor);
+    }
+
+    if (interleave == Interleave::ByDueTime) {
+        heap.reserve(cursors.size());
+        for (int i = 0; i < cursors.size(); i++) {
+            Head head;
+            if (peekCursor(i, head)) {
+                heap.append(head);
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), laterHead<Head>);
+    }
+
+    upcomingCursor = advance();
+}
+
+bool ReviewQueue::hasNext() const
+{
+    return upcomingCursor >= 0;
+}
+
+/**
+ * @brief Выдать очередную карточку
+ *
+ * Следующая карточка ищется сразу, поэтому hasNext() не меняет очередь.
+ * Оценка выданной карточки до следующего вызова next() допустима.
+ */
+ReviewQueue::Item ReviewQueue::next()
+{
+    if (upcomingCursor < 0) {
+        return Item();
+    }
+    const Item item = upcoming;
+    cursors[upcomingCursor].issued++;
+    upcomingCursor = advance();
+    return item;
+}
+
+int ReviewQueue::remaining() const
+{
+    int total = upcomingCursor >= 0 ? 1 : 0;
+    for (int i = 0; i < cursors.size(); i++) {
+        Head head;
+        if (!peekCursor(i, head)) {
+            continue;
+        }
+        // Оставшиеся готовые карточки колоды начинаются с её головы
+        const DueIndex &index = cursors[i].deck->dueIndex;
+        const auto end = index.dueEnd(now);
+        const auto first = std::lower_bound(index.begin(), end, head,
+            [](const DueIndex::Entry &entry, const Head &key) {
+                return entry.dueAt != key.dueAt ? entry.dueAt < key.dueAt : entry.row < key.row;
+            });
+        const int left = int(end - first);
+        total += cursors[i].budget == kUnlimited ? left : qMin(left, cursors[i].budget);
+    }
+    return total;
+}
+
+int ReviewQueue::issued(int deckId) const
+{
+    int count = 0;
+    for (const Cursor &cursor : cursors) {
+        if (cursor.deck->getId() == deckId) {
+            count += cursor.issued;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Найти очередную карточку колоды
+ *
+ * Продолжение ищется бинарным поиском по ключу (срок, позиция) последней
+ * выданной карточки в актуальном индексе колоды, поэтому курсор
+ * не ломается, когда выданные карточки перепланируются.
+ *
+ * Сложность алгоритма: O(log n)
+ */
+bool ReviewQueue::peekCursor(int cursorIndex, Head &head) const
+{
+    const Cursor &cursor = cursors[cursorIndex];
+    if (cursor.budget == 0) {
+        return false;
+    }
+
+    const DueIndex &index = cursor.deck->dueIndex;
+    const auto end = index.dueEnd(now);
+    auto it = index.begin();
+    if (cursor.lastRow >= 0) {
+        it = std::upper_bound(it, end, cursor,
+            [](const Cursor &key, const DueIndex::Entry &entry) {
+                return key.lastDueAt != entry.dueAt ? key.lastDueAt < entry.dueAt
+                                                    : key.lastRow < entry.row;
+            });
+    }
+    if (it == end) {
+        return false;
+    }
+    head = Head{it->dueAt, it->row, cursorIndex};
+    return true;
+}
+
+/**
+ * @brief Найти очередную карточку всей очереди
+ *
+ * ByDueTime извлекает вершину кучи. Голова в куче могла устареть, если
+ * колода изменилась после её вставки; тогда голова вычисляется заново
+ * и возвращается в кучу.
+ *
+ * Сложность алгоритма: O(log k + log n) для ByDueTime; для RoundRobin
+ * и DeckByDeck - O(log n) плюс пропуск исчерпанных колод
+ */
+int ReviewQueue::advance()
+{
+    Head head;
+    if (interleave == Interleave::ByDueTime) {
+        while (!heap.isEmpty()) {
+            std::pop_heap(heap.begin(), heap.end(), laterHead<Head>);
+            const Head top = heap.takeLast();
+            if (!peekCursor(top.cursor, head)) {
+                continue;
+            }
+            if (head.dueAt != top.dueAt || head.row != top.row) {
+                heap.append(head);
+                std::push_heap(heap.begin(), heap.end(), laterHead<Head>);
+                continue;
+            }
+            take(top.cursor, head);
+            Head following;
+            if (peekCursor(top.cursor, following)) {
+                heap.append(following);
+                std::push_heap(heap.begin(), heap.end(), laterHead<Head>);
+            }
+            return top.cursor;
+        }
+        return -1;
+    }
+
+    const int count = int(cursors.size());
+    for (int step = 0; step < count; step++) {
+        const int index = (turn + step) % count;
+        if (peekCursor(index, head)) {
+            take(index, head);
+            turn = interleave == Interleave::RoundRobin ? (index + 1) % count : index;
+            return index;
+        }
+    }
+    return -1;
+}
+
+void ReviewQueue::take(int cursorIndex, const Head &head)
+{
+    Cursor &cursor = cursors[cursorIndex];
+    cursor.lastDueAt = head.dueAt;
+    cursor.lastRow = head.row;
+    if (cursor.budget > 0) {
+        cursor.budget--;
+    }
+    upcoming = Item{cursor.deck, cursor.deck->store.ref(head.row)};
+}
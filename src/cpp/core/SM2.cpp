@@ -0,0 +1,91 @@
+#include "SM2.h"
+#include <QtGlobal>
+#include <cmath>
+
+/**
+ * @brief Применить оценку к состоянию повторения
+ *
+ * 1. **Ограничение оценки**: grade ограничивается диапазоном [0, 5]
+ * 2. **Обработка неудачного ответа (grade < 3)**:
+ *    - repetitions сбрасывается в 0
+ *    - intervalDays устанавливается в 1 день
+ * 3. **Обработка успешного ответа (grade ≥ 3)**:
+ *    - Если repetitions == 0: intervalDays = 1 день
+ *    - Если repetitions == 1: intervalDays = 6 дней
+ *    - Иначе: intervalDays = round(intervalDays × easyFactor)
+ *    - repetitions увеличивается на 1
+ * 4. **Обновление easyFactor**:
+ *    - Формула: EF' = EF + (0.1 - (5 - quality) × (0.08 + (5 - quality) × 0.02))
+ *    - Ограничение: EF ∈ [1.3, 2.5]
+ */
+void SM2::apply(float &easyFactor, int &intervalDays, int &repetitions, int grade)
+{
+    // Шаг 1: Ограничение оценки в допустимом диапазоне
+    grade = qBound(0, grade, 5);
+
+    // Шаг 2-3: Определение нового интервала в зависимости от оценки
+    if (grade < 3) {
+        // Неудачный ответ - сброс прогресса
+        repetitions = 0;
+        intervalDays = 1;
+    } else {
+        // Успешный ответ - увеличение интервала
+        if (repetitions == 0) {
+            intervalDays = 1;           // Первое успешное повторение
+        } else if (repetitions == 1) {
+            intervalDays = 6;           // Второе успешное повторение
+        } else {
+            // Последующие повторения: умножение на easyFactor
+            intervalDays = static_cast<int>(std::round(intervalDays * easyFactor));
+        }
+        repetitions++;  // Увеличение счетчика успешных повторений
+    }
+
+    // Шаг 4: Обновление фактора легкости по формуле SM2
+    float quality = static_cast<float>(grade);
+    float newEF = easyFactor + (0.1f - (5.0f - quality) * (0.08f + (5.0f - quality) * 0.02f));
+
+    // Ограничение easyFactor в диапазоне [1.3, 2.5]
+    if (newEF < kMinEasyFactor) {
+        newEF = kMinEasyFactor;   // Нижняя граница
+    } else if (newEF > kMaxEasyFactor) {
+        newEF = kMaxEasyFactor;   // Верхняя граница
+    }
+    easyFactor = newEF;
+}
+
+/**
+ * @brief Применить оценки к упакованным массивам состояний
+ *
+ * Интервал вычисляется по прежнему фактору легкости, поэтому первый проход
+ * обязан завершиться до второго. Во втором проходе нет ветвлений и вызовов
+ * функций: ограничения над float превращаются в minps/maxps.
+ */
+void SM2::applyBatch(float *easyFactors, int *intervals, int *repetitions,
+                     const int *grades, qsizetype count)
+{
+    // Проход 1: интервалы и счетчики повторений
+    for (qsizetype i = 0; i < count; ++i) {
+        const bool passed = grades[i] >= 3;
+        const int reps = repetitions[i];
+        const int grown = static_cast<int>(std::round(intervals[i] * easyFactors[i]));
+        const int next = reps == 0 ? 1 : (reps == 1 ? 6 : grown);
+
+        intervals[i] = passed ? next : 1;
+        repetitions[i] = passed ? reps + 1 : 0;
+    }
+
+    // Проход 2: фактор легкости; ограничения записаны выборами по значению,
+    // а не qBound/std::clamp по ссылке, чтобы цикл остался без ветвлений
+    for (qsizetype i = 0; i < count; ++i) {
+        int grade = grades[i];
+        grade = grade < 0 ? 0 : grade;
+        grade = grade > 5 ? 5 : grade;
+
+        const float quality = static_cast<float>(grade);
+        float newEF = easyFactors[i] + (0.1f - (5.0f - quality) * (0.08f + (5.0f - quality) * 0.02f));
+        newEF = newEF < kMinEasyFactor ? kMinEasyFactor : newEF;
+        newEF = newEF > kMaxEasyFactor ? kMaxEasyFactor : newEF;
+        easyFactors[i] = newEF;
+    }
+}
@@ -0,0 +1,55 @@
+#include "Scheduler.h"
+#include "CardStore.h"
+#include "SM2.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kMSecsPerDay = 24.0 * 60 * 60 * 1000;
+
+} // namespace
+
+void Scheduler::reviewBatch(SchedulingState *states, const int *grades, const float *elapsedDays,
+                            qsizetype count) const
+{
+    for (qsizetype i = 0; i < count; ++i) {
+        review(states[i], grades[i], elapsedDays[i]);
+    }
+}
+
+const Scheduler &Scheduler::defaultScheduler()
+{
+    static const Sm2Scheduler scheduler;
+    return scheduler;
+}
+
+double Scheduler::elapsedDays(qint64 lastReview, qint64 now)
+{
+    if (lastReview == CardStore::kNoDate || now <= lastReview) {
+        return 0.0;
+    }
+    return double(now - lastReview) / kMSecsPerDay;
+}
+
+QString Sm2Scheduler::name() const
+{
+    return QStringLiteral("SM-2");
+}
+
+void Sm2Scheduler::review(SchedulingState &state, int grade, double elapsedDays) const
+{
+    Q_UNUSED(elapsedDays);
+    SM2::apply(state.easyFactor, state.intervalDays, state.repetitions, grade);
+}
+
+/**
+ * @brief Вероятность вспомнить: 0.9 в степени (прошло / интервал)
+ */
+double Sm2Scheduler::retrievability(const SchedulingState &state, double elapsedDays) const
+{
+    if (state.intervalDays <= 0) {
+        return elapsedDays > 0.0 ? 0.0 : 1.0;
+    }
+    return std::pow(0.9, std::max(0.0, elapsedDays) / state.intervalDays);
+}
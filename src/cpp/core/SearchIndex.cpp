@@ -0,0 +1,666 @@
+#include "SearchIndex.h"
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/// Смещение позиций слов ответа: фраза не переходит из вопроса в ответ
+constexpr qint32 kFieldGap = 1 << 20;
+
+/// Сигнатура файла индекса
+constexpr char kMagic[4] = {'Q', 'C', 'S', 'I'};
+
+/// Не вычищать удаленные документы, пока их меньше
+constexpr int kMinDeletedForCompaction = 1024;
+
+/**
+ * @brief Заголовок файла индекса
+ */
+struct FileHeader {
+    char magic[4];
+    quint32 version;
+    quint32 documents;
+    quint32 terms;
+    qint64 postings;
+};
+
+/**
+ * @brief Условие запроса: слово, префикс или фраза
+ */
+struct Clause {
+    QStringList tokens;     ///< Слова; больше одного - фраза
+    bool prefix = false;    ///< Единственное слово - префикс
+};
+
+/**
+ * @brief Перебрать слова текста
+ *
+ * Слово - последовательность букв, цифр и диакритических знаков.
+ * ASCII обрабатывается отдельной веткой без обращения к таблицам
+ * Unicode. Буфер token переиспользуется между словами, поэтому для
+ * уже известных слов индексация не выделяет память.
+ *
+ * @param text Текст
+ * @param token Буфер слова
+ * @param onToken Вызывается для каждого слова с его номером в тексте
+ */
+template<typename OnToken>
+void forEachToken(const QString &text, QString &token, OnToken &&onToken)
+{
+    const QChar *data = text.constData();
+    const qsizetype size = text.size();
+    qint32 index = 0;
+    bool hasMarks = false;
+    token.resize(0);
+
+    auto finish = [&]() {
+        if (token.isEmpty()) {
+            return;
+        }
+        if (hasMarks) {
+            // Один и тот же символ может быть записан составным или
+            // разложенным; NFC приводит оба варианта к одному слову
+            token = token.normalized(QString::NormalizationForm_C);
+            hasMarks = false;
+        }
+        onToken(token, index++);
+        token.resize(0);
+    };
+
+    for (qsizetype i = 0; i < size; ++i) {
+        char32_t ch = data[i].unicode();
+        if (ch < 0x80) {
+            if ((ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9')) {
+                token += QChar(char16_t(ch));
+            } else if (ch >= 'A' && ch <= 'Z') {
+                token += QChar(char16_t(ch + ('a' - 'A')));
+            } else {
+                finish();
+            }
+            continue;
+        }
+        if (data[i].isHighSurrogate() && i + 1 < size && data[i + 1].isLowSurrogate()) {
+            ch = QChar::surrogateToUcs4(data[i], data[i + 1]);
+            ++i;
+        }
+        const bool mark = QChar::isMark(ch);
+        if (!mark && !QChar::isLetterOrNumber(ch)) {
+            finish();
+            continue;
+        }
+        if (mark) {
+            hasMarks = true;
+        }
+        const char32_t folded = QChar::toCaseFolded(ch);
+        if (QChar::requiresSurrogates(folded)) {
+            token += QChar(QChar::highSurrogate(folded));
+            token += QChar(QChar::lowSurrogate(folded));
+        } else {
+            token += QChar(char16_t(folded));
+        }
+    }
+    finish();
+}
+
+/**
+ * @brief Разобрать запрос на условия
+ */
+QList<Clause> parseQuery(const QString &query)
+{
+    QList<Clause> clauses;
+    const qsizetype size = query.size();
+    qsizetype i = 0;
+    while (i < size) {
+        if (query[i].isSpace()) {
+            ++i;
+            continue;
+        }
+        Clause clause;
+        if (query[i] == QLatin1Char('"')) {
+            qsizetype end = query.indexOf(QLatin1Char('"'), i + 1);
+            if (end < 0) {
+                end = size;
+            }
+            clause.tokens = SearchIndex::tokenize(query.mid(i + 1, end - i - 1));
+            i = end + 1;
+        } else {
+            qsizetype end = i;
+            while (end < size && !query[end].isSpace() && query[end] != QLatin1Char('"')) {
+                ++end;
+            }
+            const QString word = query.mid(i, end - i);
+            clause.tokens = SearchIndex::tokenize(word);
+            // "e-mail*" разбивается на два слова и становится фразой
+            clause.prefix = word.endsWith(QLatin1Char('*')) && clause.tokens.size() == 1;
+            i = end;
+        }
+        if (!clause.tokens.isEmpty()) {
+            clauses.append(clause);
+        }
+    }
+    return clauses;
+}
+
+/**
+ * @brief Оставить в result только документы из other
+ *
+ * Оба списка отсортированы. Поиск в other продвигается скачками
+ * (lower_bound от текущей позиции), поэтому короткий список
+ * пересекается с длинным за O(k log n).
+ */
+void intersect(QList<qint32> &result, const QList<qint32> &other)
+{
+    auto from = other.cbegin();
+    qsizetype kept = 0;
+    for (const qint32 doc : std::as_const(result)) {
+        from = std::lower_bound(from, other.cend(), doc);
+        if (from == other.cend()) {
+            break;
+        }
+        if (*from == doc) {
+            result[kept++] = doc;
+        }
+    }
+    result.resize(kept);
+}
+
+} // namespace
+
+// ==================== CHANGES ====================
+
+void SearchIndex::clear()
+{
+    termIds.clear();
+    sortedTerms.clear();
+    postings.clear();
+    cardByDoc.clear();
+    docByCard.clear();
+    deletedDocs = 0;
+    postingCount = 0;
+}
+
+void SearchIndex::addCard(int cardId, const QString &question, const QString &answer)
+{
+    dropCard(cardId);
+
+    const qint32 doc = static_cast<qint32>(cardByDoc.size());
+    cardByDoc.append(cardId);
+    docByCard.insert(cardId, doc);
+
+    QString token;
+    token.reserve(32);
+    auto add = [this, doc](qint32 fieldOffset) {
+        return [this, doc, fieldOffset](const QString &term, qint32 index) {
+            auto it = termIds.constFind(term);
+            qint32 termId;
+            if (it == termIds.constEnd()) {
+                termId = static_cast<qint32>(postings.size());
+                const QString key = term;
+                termIds.insert(key, termId);
+                sortedTerms.insert(key, termId);
+                postings.append(QList<Posting>());
+            } else {
+                termId = it.value();
+            }
+            postings[termId].append(Posting{doc, fieldOffset + qMin(index, kFieldGap - 1)});
+            ++postingCount;
+        };
+    };
+    forEachToken(question, token, add(0));
+    forEachToken(answer, token, add(kFieldGap));
+
+    compactIfNeeded();
+}
+
+void SearchIndex::addCards(CardSpan cards)
+{
+    cardByDoc.reserve(cardByDoc.size() + cards.size());
+    docByCard.reserve(docByCard.size() + cards.size());
+    for (const CardRef card : cards) {
+        addCard(card.getId(), card.getQuestion(), card.getAnswer());
+    }
+}
+
+bool SearchIndex::updateCard(int cardId, const QString &question, const QString &answer)
+{
+    const bool existed = contains(cardId);
+    addCard(cardId, question, answer);
+    return existed;
+}
+
+bool SearchIndex::removeCard(int cardId)
+{
+    if (!dropCard(cardId)) {
+        return false;
+    }
+    compactIfNeeded();
+    return true;
+}
+
+bool SearchIndex::dropCard(int cardId)
+{
+    auto it = docByCard.find(cardId);
+    if (it == docByCard.end()) {
+        return false;
+    }
+    cardByDoc[it.value()] = -1;
+    docByCard.erase(it);
+    ++deletedDocs;
+    return true;
+}
+
+void SearchIndex::compactIfNeeded()
+{
+    if (deletedDocs >= kMinDeletedForCompaction && deletedDocs > docByCard.size()) {
+        compact();
+    }
+}
+
+/**
+ * @brief Вычистить удаленные документы
+ *
+ * Документы перенумеровываются подряд с сохранением порядка, поэтому
+ * списки вхождений остаются отсортированными. Слова, у которых не
+ * осталось вхождений, удаляются из словаря.
+ */
+void SearchIndex::compact()
+{
+    if (deletedDocs == 0) {
+        return;
+    }
+
+    QList<qint32> newDoc(cardByDoc.size(), -1);
+    QList<int> liveCards;
+    liveCards.reserve(docByCard.size());
+    for (qsizetype doc = 0; doc < cardByDoc.size(); ++doc) {
+        if (cardByDoc[doc] >= 0) {
+            newDoc[doc] = static_cast<qint32>(liveCards.size());
+            liveCards.append(cardByDoc[doc]);
+        }
+    }
+
+    QHash<QString, qint32> liveTermIds;
+    QMap<QString, qint32> liveSortedTerms;
+    QList<QList<Posting>> livePostings;
+    liveTermIds.reserve(termIds.size());
+    postingCount = 0;
+    for (auto it = sortedTerms.cbegin(); it != sortedTerms.cend(); ++it) {
+        QList<Posting> &list = postings[it.value()];
+        qsizetype kept = 0;
+        for (const Posting &posting : std::as_const(list)) {
+            const qint32 doc = newDoc[posting.doc];
+            if (doc >= 0) {
+                list[kept++] = Posting{doc, posting.position};
+            }
+        }
+        if (kept == 0) {
+            continue;
+        }
+        list.resize(kept);
+        list.squeeze();
+        const qint32 termId = static_cast<qint32>(livePostings.size());
+        livePostings.append(std::move(list));
+        liveTermIds.insert(it.key(), termId);
+        liveSortedTerms.insert(liveSortedTerms.cend(), it.key(), termId);
+        postingCount += kept;
+    }
+
+    termIds = std::move(liveTermIds);
+    sortedTerms = std::move(liveSortedTerms);
+    postings = std::move(livePostings);
+    cardByDoc = std::move(liveCards);
+    docByCard.clear();
+    docByCard.reserve(cardByDoc.size());
+    for (qsizetype doc = 0; doc < cardByDoc.size(); ++doc) {
+        docByCard.insert(cardByDoc[doc], static_cast<qint32>(doc));
+    }
+    deletedDocs = 0;
+}
+
+// ==================== SEARCH ====================
+
+/**
+ * @brief Найти карточки по запросу
+ *
+ * Каждое условие дает отсортированный список документов; списки
+ * пересекаются начиная с самого короткого, а удаленные документы
+ * отбрасываются только в итоговом списке.
+ */
+QList<int> SearchIndex::search(const QString &query, int limit) const
+{
+    const QList<Clause> clauses = parseQuery(query);
+    if (clauses.isEmpty() || limit == 0) {
+        return {};
+    }
+
+    QList<QList<qint32>> lists;
+    lists.reserve(clauses.size());
+    for (const Clause &clause : clauses) {
+        QList<qint32> docs;
+        if (clause.tokens.size() > 1) {
+            docs = documentsWithPhrase(clause.tokens);
+        } else if (clause.prefix) {
+            docs = documentsWithPrefix(clause.tokens.first());
+        } else {
+            const qint32 termId = termIds.value(clause.tokens.first(), -1);
+            if (termId >= 0) {
+                docs = documentsWith(termId);
+            }
+        }
+        if (docs.isEmpty()) {
+            return {};
+        }
+        lists.append(std::move(docs));
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const QList<qint32> &a, const QList<qint32> &b) {
+        return a.size() < b.size();
+    });
+    QList<qint32> docs = std::move(lists.first());
+    for (qsizetype i = 1; i < lists.size() && !docs.isEmpty(); ++i) {
+        intersect(docs, lists[i]);
+    }
+
+    QList<int> cards;
+    cards.reserve(limit > 0 ? qMin<qsizetype>(limit, docs.size()) : docs.size());
+    for (const qint32 doc : std::as_const(docs)) {
+        const int cardId = cardByDoc[doc];
+        if (cardId < 0) {
+            continue;
+        }
+        cards.append(cardId);
+        if (limit > 0 && cards.size() >= limit) {
+            break;
+        }
+    }
+    return cards;
+}
+
+QList<qint32> SearchIndex::documentsWith(qint32 termId) const
+{
+    const QList<Posting> &list = postings[termId];
+    QList<qint32> docs;
+    docs.reserve(list.size());
+    for (const Posting &posting : list) {
+        if (docs.isEmpty() || docs.last() != posting.doc) {
+            docs.append(posting.doc);
+        }
+    }
+    return docs;
+}
+
+QList<qint32> SearchIndex::documentsWithPrefix(const QString &prefix) const
+{
+    QList<qint32> docs;
+    int matched = 0;
+    for (auto it = sortedTerms.lowerBound(prefix); it != sortedTerms.cend() && it.key().startsWith(prefix); ++it) {
+        docs.append(documentsWith(it.value()));
+        ++matched;
+    }
+    if (matched > 1) {
+        std::sort(docs.begin(), docs.end());
+        docs.erase(std::unique(docs.begin(), docs.end()), docs.end());
+    }
+    return docs;
+}
+
+/**
+ * @brief Найти документы, где слова идут подряд
+ *
+ * Кандидаты - пересечение документов всех слов; для каждого
+ * кандидата позиции первого слова проверяются двоичным поиском
+ * в позициях остальных слов того же документа.
+ */
+QList<qint32> SearchIndex::documentsWithPhrase(const QStringList &tokens) const
+{
+    QList<qint32> terms;
+    terms.reserve(tokens.size());
+    for (const QString &token : tokens) {
+        const qint32 termId = termIds.value(token, -1);
+        if (termId < 0) {
+            return {};
+        }
+        terms.append(termId);
+    }
+
+    QList<qint32> candidates = documentsWith(terms.first());
+    for (qsizetype i = 1; i < terms.size() && !candidates.isEmpty(); ++i) {
+        intersect(candidates, documentsWith(terms[i]));
+    }
+
+    auto byDoc = [](const Posting &posting, qint32 doc) { return posting.doc < doc; };
+    QList<QList<Posting>::const_iterator> cursors;
+    for (const qint32 termId : std::as_const(terms)) {
+        cursors.append(postings[termId].cbegin());
+    }
+
+    QList<qint32> docs;
+    for (const qint32 doc : std::as_const(candidates)) {
+        // Диапазоны вхождений документа; кандидаты возрастают, поэтому курсоры только движутся вперед
+        QList<std::pair<QList<Posting>::const_iterator, QList<Posting>::const_iterator>> ranges;
+        ranges.reserve(terms.size());
+        for (qsizetype i = 0; i < terms.size(); ++i) {
+            const QList<Posting> &list = postings[terms[i]];
+            auto first = std::lower_bound(cursors[i], list.cend(), doc, byDoc);
+            auto last = first;
+            while (last != list.cend() && last->doc == doc) {
+                ++last;
+            }
+            cursors[i] = last;
+            ranges.append(std::make_pair(first, last));
+        }
+
+        for (auto start = ranges[0].first; start != ranges[0].second; ++start) {
+            bool matched = true;
+            for (qsizetype i = 1; i < ranges.size() && matched; ++i) {
+                const qint32 wanted = start->position + static_cast<qint32>(i);
+                auto found = std::lower_bound(ranges[i].first, ranges[i].second, wanted,
+                    [](const Posting &posting, qint32 position) { return posting.position < position; });
+                matched = found != ranges[i].second && found->position == wanted;
+            }
+            if (matched) {
+                docs.append(doc);
+                break;
+            }
+        }
+    }
+    return docs;
+}
+
+bool SearchIndex::contains(int cardId) const
+{
+    return docByCard.contains(cardId);
+}
+
+int SearchIndex::size() const
+{
+    return static_cast<int>(docByCard.size());
+}
+
+SearchIndex::Stats SearchIndex::stats() const
+{
+    Stats result;
+    result.documents = size();
+    result.deletedDocuments = deletedDocs;
+    result.terms = static_cast<int>(termIds.size());
+    result.postings = postingCount;
+
+    // Узлы QHash и QMap оцениваются приблизительно
+    qsizetype termBytes = 0;
+    for (auto it = termIds.cbegin(); it != termIds.cend(); ++it) {
+        termBytes += it.key().capacity() * qsizetype(sizeof(QChar)) + 96;
+    }
+    result.memoryUsage = termBytes
+                       + postingCount * qsizetype(sizeof(Posting))
+                       + postings.size() * qsizetype(sizeof(QList<Posting>))
+                       + cardByDoc.capacity() * qsizetype(sizeof(int))
+                       + docByCard.size() * 16;
+    return result;
+}
+
+// ==================== FILE ====================
+
+/**
+ * @brief Сохранить индекс
+ *
+ * Перед записью удаленные документы вычищаются. Формат: заголовок
+ * FileHeader, карточки документов, затем слова по алфавиту: длина
+ * в UTF-16, символы, количество вхождений и вхождения.
+ *
+ * @note Формат файла использует порядок байтов платформы
+ */
+bool SearchIndex::save(const QString &path)
+{
+    compact();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(file.errorString());
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.documents = static_cast<quint32>(cardByDoc.size());
+    header.terms = static_cast<quint32>(sortedTerms.size());
+    header.postings = postingCount;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(cardByDoc.constData()), cardByDoc.size() * qint64(sizeof(int)));
+
+    for (auto it = sortedTerms.cbegin(); it != sortedTerms.cend(); ++it) {
+        const quint32 length = static_cast<quint32>(it.key().size());
+        const QList<Posting> &list = postings[it.value()];
+        const quint32 count = static_cast<quint32>(list.size());
+        file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        file.write(reinterpret_cast<const char *>(it.key().constData()), length * qint64(sizeof(QChar)));
+        file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char *>(list.constData()), count * qint64(sizeof(Posting)));
+    }
+
+    if (!file.commit()) {
+        return fail(file.errorString());
+    }
+    return true;
+}
+
+bool SearchIndex::load(const QString &path)
+{
+    clear();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+    const QByteArray bytes = file.readAll();
+    const char *cursor = bytes.constData();
+    const char *end = cursor + bytes.size();
+    auto read = [&cursor, end](void *out, qint64 size) {
+        if (size < 0 || end - cursor < size) {
+            return false;
+        }
+        std::memcpy(out, cursor, size);
+        cursor += size;
+        return true;
+    };
+    auto corrupted = [this]() {
+        clear();
+        return fail(QStringLiteral("Search index file is corrupted"));
+    };
+
+    FileHeader header;
+    if (!read(&header, sizeof(header)) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        return fail(QStringLiteral("Not a search index file"));
+    }
+    if (header.version != kVersion) {
+        return fail(QString("Unsupported search index version %1").arg(header.version));
+    }
+
+    cardByDoc.resize(header.documents);
+    if (!read(cardByDoc.data(), header.documents * qint64(sizeof(int)))) {
+        return corrupted();
+    }
+    docByCard.reserve(header.documents);
+    for (quint32 doc = 0; doc < header.documents; ++doc) {
+        docByCard.insert(cardByDoc[doc], static_cast<qint32>(doc));
+    }
+
+    termIds.reserve(header.terms);
+    postings.reserve(header.terms);
+    for (quint32 termId = 0; termId < header.terms; ++termId) {
+        quint32 length = 0;
+        if (!read(&length, sizeof(length))) {
+            return corrupted();
+        }
+        QString term(static_cast<qsizetype>(qMin<qint64>(length, end - cursor)), Qt::Uninitialized);
+        if (term.size() != qsizetype(length) || !read(term.data(), length * qint64(sizeof(QChar)))) {
+            return corrupted();
+        }
+        quint32 count = 0;
+        if (!read(&count, sizeof(count)) || count == 0 || end - cursor < count * qint64(sizeof(Posting))) {
+            return corrupted();
+        }
+        QList<Posting> list(count);
+        read(list.data(), count * qint64(sizeof(Posting)));
+        for (const Posting &posting : std::as_const(list)) {
+            if (posting.doc < 0 || quint32(posting.doc) >= header.documents) {
+                return corrupted();
+            }
+        }
+        termIds.insert(term, static_cast<qint32>(termId));
+        sortedTerms.insert(sortedTerms.cend(), term, static_cast<qint32>(termId));
+        postings.append(std::move(list));
+        postingCount += count;
+    }
+    if (cursor != end || postingCount != header.postings) {
+        return corrupted();
+    }
+    return true;
+}
+
+QString SearchIndex::lastError() const
+{
+    return errorText;
+}
+
+QString SearchIndex::pathFor(const QString &collectionPath)
+{
+    return collectionPath + QStringLiteral(".search");
+}
+
+bool SearchIndex::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
+
+// ==================== PARSING ====================
+
+QStringList SearchIndex::tokenize(const QString &text)
+{
+    QStringList tokens;
+    QString token;
+    forEachToken(text, token, [&tokens](const QString &term, qint32) { tokens.append(term); });
+    return tokens;
+}
+
+/**
+ * @brief Перевести запрос в выражение FTS5
+ *
+ * Каждое условие становится строкой в кавычках (в FTS5 это фраза,
+ * для одного слова - просто слово), префикс - строкой со звездочкой.
+ * Слова состоят только из букв и цифр, поэтому экранирование не нужно.
+ */
+QString SearchIndex::toFts5Query(const QString &query)
+{
+    QStringList parts;
+    for (const Clause &clause : parseQuery(query)) {
+        QString part = QStringLiteral("\"") + clause.tokens.join(QLatin1Char(' ')) + QStringLiteral("\"");
+        if (clause.prefix) {
+            part += QLatin1Char('*');
+        }
+        parts.append(part);
+    }
+    return parts.join(QLatin1Char(' '));
+}
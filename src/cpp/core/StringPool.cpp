@@ -0,0 +1,113 @@
+#include "StringPool.h"
+#include <QHash>
+#include <QMutexLocker>
+
+namespace {
+
+qint64 textBytes(const QString &text)
+{
+    return qint64(text.size()) * qint64(sizeof(QChar));
+}
+
+} // namespace
+
+StringPool::Shard &StringPool::shardFor(const QString &text)
+{
+    constexpr int kShift = int(sizeof(size_t)) * 8 - 4;
+    static_assert(kShardCount == 16, "kShift assumes 16 shards");
+    return shards[(qHash(text) >> kShift) & (kShardCount - 1)];
+}
+
+const StringPool::Shard &StringPool::shardFor(const QString &text) const
+{
+    return const_cast<StringPool *>(this)->shardFor(text);
+}
+
+QString StringPool::intern(const QString &text)
+{
+    if (text.isEmpty()) {
+        return text;
+    }
+
+    Shard &shard = shardFor(text);
+    QMutexLocker locker(&shard.mutex);
+    ++shard.requests;
+    const auto it = shard.strings.constFind(text);
+    if (it != shard.strings.cend()) {
+        ++shard.hits;
+        if (it->constData() != text.constData()) {
+            shard.savedBytes += textBytes(text);
+        }
+        return *it;
+    }
+    shard.strings.insert(text);
+    shard.pooledBytes += textBytes(text);
+    return text;
+}
+
+bool StringPool::contains(const QString &text) const
+{
+    const Shard &shard = shardFor(text);
+    QMutexLocker locker(&shard.mutex);
+    return shard.strings.contains(text);
+}
+
+qsizetype StringPool::size() const
+{
+    qsizetype total = 0;
+    for (const Shard &shard : shards) {
+        QMutexLocker locker(&shard.mutex);
+        total += shard.strings.size();
+    }
+    return total;
+}
+
+StringPool::Stats StringPool::stats() const
+{
+    Stats total;
+    for (const Shard &shard : shards) {
+        QMutexLocker locker(&shard.mutex);
+        total.strings += shard.strings.size();
+        total.requests += shard.requests;
+        total.hits += shard.hits;
+        total.pooledBytes += shard.pooledBytes;
+        total.savedBytes += shard.savedBytes;
+    }
+    return total;
+}
+
+/**
+ * @brief Удалить неиспользуемые строки
+ *
+ * Строка, буфер которой никто, кроме пула, не разделяет
+ * (QString::isDetached()), удаляется из сегмента.
+ */
+qsizetype StringPool::squeeze()
+{
+    qsizetype removed = 0;
+    for (Shard &shard : shards) {
+        QMutexLocker locker(&shard.mutex);
+        for (auto it = shard.strings.begin(); it != shard.strings.end();) {
+            if (it->isDetached()) {
+                shard.pooledBytes -= textBytes(*it);
+                it = shard.strings.erase(it);
+                ++removed;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return removed;
+}
+
+void StringPool::clear()
+{
+    for (Shard &shard : shards) {
+        QMutexLocker locker(&shard.mutex);
+        shard.strings.clear();
+        shard.requests = 0;
+        shard.hits = 0;
+        shard.pooledBytes = 0;
+        shard.savedBytes = 0;
+    }
+}
@@ -0,0 +1,135 @@
+#include "TaskRunner.h"
+#include <QMutexLocker>
+#include <memory>
+
+// =============== TaskContext ===============
+
+TaskContext::TaskContext(TaskRunner *runner, int id, const QPromise<bool> &promise)
+    : runner(runner)
+    , taskId(id)
+    , promise(promise)
+{}
+
+bool TaskContext::isCanceled() const
+{
+    return promise.isCanceled();
+}
+
+void TaskContext::setProgress(qint64 done, qint64 total)
+{
+    const bool complete = total >= 0 && done >= total;
+    if (sinceProgress.isValid() && !complete && sinceProgress.elapsed() < TaskRunner::kProgressIntervalMSecs) {
+        return;
+    }
+    sinceProgress.start();
+    emit runner->progress(taskId, done, total);
+}
+
+void TaskContext::setError(const QString &message)
+{
+    errorText = message;
+}
+
+QString TaskContext::error() const
+{
+    return errorText;
+}
+
+// =============== TaskRunner ===============
+
+TaskRunner::TaskRunner(int threadCount, QObject *parent)
+    : QObject(parent)
+{
+    if (threadCount > 0) {
+        threadPool.setMaxThreadCount(threadCount);
+    }
+}
+
+TaskRunner::~TaskRunner()
+{
+    cancelAll();
+    threadPool.waitForDone();
+}
+
+/**
+ * @brief Запустить задачу в фоне
+ *
+ * 1. Обещание результата создается в потоке вызова, чтобы future()
+ *    и cancel() работали сразу после run().
+ * 2. Рабочий поток выполняет задачу, если её не отменили в очереди,
+ *    и завершает обещание.
+ * 3. Сигнал finished() и удаление будущего передаются в поток
+ *    TaskRunner очередью событий; при уничтожении TaskRunner
+ *    недоставленные события отбрасываются.
+ */
+int TaskRunner::run(const QString &name, Task task)
+{
+    auto promise = std::make_shared<QPromise<bool>>();
+    promise->start();
+
+    int id = 0;
+    {
+        QMutexLocker locker(&mutex);
+        id = nextId++;
+        futures.insert(id, promise->future());
+    }
+    active.fetch_add(1);
+    emit started(id, name);
+
+    threadPool.start([this, id, promise, task = std::move(task)]() {
+        TaskContext context(this, id, *promise);
+        const bool ok = !promise->isCanceled() && task(context);
+        const bool canceled = promise->isCanceled();
+        promise->addResult(ok && !canceled);
+        promise->finish();
+
+        QString error;
+        if (canceled) {
+            error = QStringLiteral("Task cancelled");
+        } else if (!ok) {
+            error = context.error().isEmpty() ? QStringLiteral("Task failed") : context.error();
+        }
+        QMetaObject::invokeMethod(this, [this, id, ok, canceled, error]() {
+            {
+                QMutexLocker locker(&mutex);
+                futures.remove(id);
+            }
+            emit finished(id, ok && !canceled, error);
+        }, Qt::QueuedConnection);
+        active.fetch_sub(1);
+    });
+    return id;
+}
+
+QFuture<bool> TaskRunner::future(int id) const
+{
+    QMutexLocker locker(&mutex);
+    return futures.value(id);
+}
+
+void TaskRunner::cancel(int id)
+{
+    QMutexLocker locker(&mutex);
+    auto it = futures.find(id);
+    if (it != futures.end()) {
+        it->cancel();
+    }
+}
+
+void TaskRunner::cancelAll()
+{
+    QMutexLocker locker(&mutex);
+    for (QFuture<bool> &future : futures) {
+        future.cancel();
+    }
+}
+
+bool TaskRunner::waitForDone(int msecs)
+{
+    return threadPool.waitForDone(msecs);
+}
+
+int TaskRunner::activeCount() const
+{
+    return active.load();
+}
@@ -0,0 +1,277 @@
+#include "WorkloadSimulator.h"
+#include "Deck.h"
+#include "ReviewForecast.h"
+#include "SM2.h"
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+/**
+ * @brief Рабочие массивы испытания
+ *
+ * Выделяются один раз на поток и переписываются в начале каждого
+ * испытания; очередь дней - односвязные списки через next.
+ */
+struct WorkloadSimulator::TrialBuffers {
+    QList<float> easyFactors;
+    QList<int> intervals;
+    QList<int> repetitions;
+    QList<int> next;            ///< Следующая карточка в списке того же дня; -1 - конец
+    QList<int> heads;           ///< Первая карточка дня; -1 - день пуст
+
+    explicit TrialBuffers(qsizetype cards, int days)
+        : easyFactors(cards), intervals(cards), repetitions(cards), next(cards), heads(days + 1)
+    {}
+};
+
+namespace {
+
+/**
+ * @brief Генератор SplitMix64
+ *
+ * Состояние - одно 64-битное слово: создание и смена зерна не выделяют
+ * память (в отличие от QRandomGenerator, засеваемого через seed_seq),
+ * а качества хватает для выбора оценки.
+ */
+class SplitMix64
+{
+public:
+    explicit SplitMix64(quint64 seed) : state(seed) {}
+
+    quint32 generate()
+    {
+        quint64 z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return quint32((z ^ (z >> 31)) >> 32);
+    }
+
+private:
+    quint64 state;
+};
+
+/**
+ * @brief Перцентиль отсортированного ряда (ближайший ранг)
+ */
+int percentile(const QList<int> &sorted, double fraction)
+{
+    const qsizetype last = sorted.size() - 1;
+    const qsizetype index = std::clamp<qsizetype>(qsizetype(std::lround(fraction * double(last))), 0, last);
+    return sorted[index];
+}
+
+} // namespace
+
+WorkloadSimulator::WorkloadSimulator()
+    : WorkloadSimulator(Options())
+{}
+
+WorkloadSimulator::WorkloadSimulator(const Options &options)
+    : options(options)
+{}
+
+void WorkloadSimulator::setClock(const Clock *clock)
+{
+    this->clock = clock;
+}
+
+/**
+ * @brief Смоделировать нагрузку колоды
+ *
+ * Начальное состояние упаковывается один раз и разделяется всеми
+ * испытаниями только на чтение. Нагрузка испытаний пишется в общую
+ * матрицу (испытание x день) непересекающимися строками, после чего
+ * для каждого дня столбец сортируется и из него берутся перцентили.
+ */
+bool WorkloadSimulator::simulate(const Deck &deck)
+{
+    summary = Result();
+    errorText.clear();
+    QElapsedTimer timer;
+    timer.start();
+
+    if (options.days < 1 || options.trials < 1) {
+        return fail(QStringLiteral("Days and trials must be positive"));
+    }
+    double weightSum = 0.0;
+    for (double weight : options.gradeWeights) {
+        if (weight < 0.0 || !std::isfinite(weight)) {
+            return fail(QStringLiteral("Grade weights must be non-negative"));
+        }
+        weightSum += weight;
+    }
+    if (weightSum <= 0.0) {
+        return fail(QStringLiteral("At least one grade weight must be positive"));
+    }
+
+    // Оценка = количество порогов, не превышающих случайное 32-битное число
+    quint32 thresholds[5];
+    double cumulative = 0.0;
+    for (int grade = 0; grade < 5; grade++) {
+        cumulative += options.gradeWeights[grade] / weightSum;
+        thresholds[grade] = quint32(std::min(4294967295.0, std::floor(cumulative * 4294967296.0)));
+    }
+
+    const Clock &source = clock ? *clock : deck.getClock();
+    const ReviewForecast calendar(source.now(), options.days);
+    const CardSpan cards = deck.getCardsView();
+    Initial initial;
+    initial.easyFactors.reserve(cards.size());
+    initial.intervals.reserve(cards.size());
+    initial.repetitions.reserve(cards.size());
+    initial.dueDays.reserve(cards.size());
+    for (const CardRef card : cards) {
+        initial.easyFactors.append(card.getEasyFactor());
+        initial.intervals.append(card.getIntervalDays());
+        initial.repetitions.append(card.getRepetitions());
+        initial.dueDays.append(calendar.dayOf(card.getNextReviewMSecs()));
+    }
+
+    const int days = options.days;
+    const int trials = options.trials;
+    QList<int> matrix(qsizetype(trials) * days);
+    QList<int> backlogs(trials);
+    int *loads = matrix.data();
+    int *backlog = backlogs.data();
+    std::atomic<int> nextTrial{0};
+
+    auto worker = [&]() {
+        TrialBuffers buffers(cards.size(), days);
+        for (int trial = nextTrial.fetch_add(1); trial < trials; trial = nextTrial.fetch_add(1)) {
+            backlog[trial] = runTrial(initial, thresholds, trial, loads + qsizetype(trial) * days, buffers);
+        }
+    };
+
+    QThreadPool pool;
+    if (options.threadCount > 0) {
+        pool.setMaxThreadCount(options.threadCount);
+    }
+    const int workers = std::min(pool.maxThreadCount(), trials);
+    for (int i = 1; i < workers; i++) {
+        pool.start(worker);
+    }
+    worker();
+    pool.waitForDone();
+
+    // Сводка по дням: столбец матрицы сортируется в переиспользуемом буфере
+    const double tail = (1.0 - std::clamp(options.confidence, 0.0, 1.0)) / 2.0;
+    QList<int> column(trials);
+    QList<int> totals(trials, 0);
+    summary.days.resize(days);
+    for (int day = 0; day < days; day++) {
+        qint64 sum = 0;
+        for (int trial = 0; trial < trials; trial++) {
+            const int load = loads[qsizetype(trial) * days + day];
+            column[trial] = load;
+            totals[trial] += load;
+            sum += load;
+        }
+        std::sort(column.begin(), column.end());
+        DayLoad &result = summary.days[day];
+        result.mean = double(sum) / trials;
+        result.median = percentile(column, 0.5);
+        result.lower = percentile(column, tail);
+        result.upper = percentile(column, 1.0 - tail);
+        summary.reviews += sum;
+    }
+
+    std::sort(totals.begin(), totals.end());
+    summary.meanTotal = double(summary.reviews) / trials;
+    summary.lowerTotal = percentile(totals, tail);
+    summary.upperTotal = percentile(totals, 1.0 - tail);
+    qint64 backlogSum = 0;
+    for (int value : std::as_const(backlogs)) {
+        backlogSum += value;
+    }
+    summary.meanBacklog = double(backlogSum) / trials;
+    summary.elapsedMSecs = timer.elapsed();
+    return true;
+}
+
+const WorkloadSimulator::Result &WorkloadSimulator::result() const
+{
+    return summary;
+}
+
+QString WorkloadSimulator::lastError() const
+{
+    return errorText;
+}
+
+/**
+ * @brief Провести одно испытание
+ *
+ * День d забирает свой список карточек: каждой выставляется случайная
+ * оценка, состояние пересчитывается SM2::apply(), и карточка переходит
+ * в список дня d + интервал. При дневном лимите необработанный остаток
+ * списка переходит на следующий день. Память не выделяется.
+ *
+ * Сложность алгоритма: O(n + d + r), r - количество повторений
+ */
+int WorkloadSimulator::runTrial(const Initial &initial, const quint32 *thresholds, int trial,
+                                int *loads, TrialBuffers &buffers) const
+{
+    const int days = options.days;
+    const int limit = options.dailyLimit;
+    const qsizetype count = initial.dueDays.size();
+
+    float *easyFactors = buffers.easyFactors.data();
+    int *intervals = buffers.intervals.data();
+    int *repetitions = buffers.repetitions.data();
+    int *next = buffers.next.data();
+    int *heads = buffers.heads.data();
+
+    std::copy(initial.easyFactors.cbegin(), initial.easyFactors.cend(), easyFactors);
+    std::copy(initial.intervals.cbegin(), initial.intervals.cend(), intervals);
+    std::copy(initial.repetitions.cbegin(), initial.repetitions.cend(), repetitions);
+    std::fill(heads, heads + days + 1, -1);
+    // Обход с конца сохраняет порядок колоды внутри дня
+    for (qsizetype card = count - 1; card >= 0; card--) {
+        const int day = initial.dueDays[card];
+        next[card] = heads[day];
+        heads[day] = int(card);
+    }
+
+    SplitMix64 random((quint64(options.seed) << 32) ^ quint64(trial));
+    int carried = 0;
+    for (int day = 0; day < days; day++) {
+        int load = 0;
+        int card = heads[day];
+        while (card >= 0 && load != limit) {
+            const int following = next[card];
+            const quint32 sample = random.generate();
+            const int grade = int(sample >= thresholds[0]) + int(sample >= thresholds[1])
+                            + int(sample >= thresholds[2]) + int(sample >= thresholds[3])
+                            + int(sample >= thresholds[4]);
+            SM2::apply(easyFactors[card], intervals[card], repetitions[card], grade);
+
+            // Нулевой интервал вернул бы карточку в уже пройденный список дня
+            const int due = std::min(days, day + std::max(1, intervals[card]));
+            next[card] = heads[due];
+            heads[due] = card;
+            ++load;
+            card = following;
+        }
+        // Не уместившиеся в лимит карточки переносятся на завтра
+        carried = 0;
+        while (card >= 0) {
+            const int following = next[card];
+            next[card] = heads[day + 1];
+            heads[day + 1] = card;
+            card = following;
+            ++carried;
+        }
+        loads[day] = load;
+    }
+
+    // Перенесенные с последнего дня так и не были повторены
+    return carried;
+}
+
+bool WorkloadSimulator::fail(const QString &message)
+{
+    errorText = message;
+    return false;
+}
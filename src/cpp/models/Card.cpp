@@ -1,6 +1,9 @@
 #include "Card.h"
+#include "SM2.h"
+#include "Clock.h"
+#include "Scheduler.h"
+#include "StringPool.h"
 #include <QDateTime>
-#include <cmath>
 #include <algorithm>
 
 /**
@@ -25,14 +28,16 @@ Card::Card()
  *
  * Инициализирует все поля переданными значениями.
  * Использует список инициализации членов для эффективности.
+ * С пулом вопрос и ответ разделяют буфер с одинаковым текстом других карточек.
  */
 Card::Card(int id, const QString &question, const QString &answer,
            ContentType contentType, TestMode testMode,
            float easyFactor, int intervalDays, int repetitions,
-           const QDateTime &nextReview, const QDateTime &lastReview, int deckId) :
+           const QDateTime &nextReview, const QDateTime &lastReview, int deckId,
+           StringPool *pool) :
     id(id),
-    question(question),
-    answer(answer),
+    question(pool ? pool->intern(question) : question),
+    answer(pool ? pool->intern(answer) : answer),
     contentType(contentType),
     testMode(testMode),
     easyFactor(easyFactor),
@@ -174,68 +179,63 @@ Card& Card::operator=(Card&& other) noexcept
 /**
  * @brief Обновить состояние карточки по алгоритму SM2
  *
- * Детальная реализация алгоритма SuperMemo 2:
- *
- * 1. **Ограничение оценки**: grade ограничивается диапазоном [0, 5]
- * 2. **Обновление времени**: lastReview устанавливается в текущее время
- * 3. **Обработка неудачного ответа (grade < 3)**:
- *    - repetitions сбрасывается в 0
- *    - intervalDays устанавливается в 1 день
- * 4. **Обработка успешного ответа (grade ≥ 3)**:
- *    - Если repetitions == 0: intervalDays = 1 день
- *    - Если repetitions == 1: intervalDays = 6 дней
- *    - Иначе: intervalDays = round(intervalDays × easyFactor)
- *    - repetitions увеличивается на 1
- * 5. **Обновление easyFactor**:
- *    - Формула: EF' = EF + (0.1 - (5 - quality) × (0.08 + (5 - quality) × 0.02))
- *    - где quality = grade
- *    - Ограничение: EF ∈ [1.3, 2.5]
- * 6. **Установка nextReview**: lastReview + intervalDays
+ * 1. **Обновление времени**: lastReview устанавливается в текущее время
+ *    (системные часы Clock::system() или переданные clock)
+ * 2. **Шаг SM2**: интервал, счетчик повторений и easyFactor пересчитываются
+ *    функцией SM2::apply() (grade ограничивается диапазоном [0, 5],
+ *    EF - диапазоном [1.3, 2.5])
+ * 3. **Установка nextReview**: lastReview + intervalDays
  *
  * @param grade Оценка ответа пользователя (0-5)
  *
- * @note Использует qBound для ограничения grade
- * @note Использует std::round для корректного округления интервала
- * @note Формула easyFactor соответствует оригинальному алгоритму SM2
+ * @note Та же функция SM2::apply() используется колодой для строк CardStore,
+ *       поэтому оба пути планирования дают одинаковый результат
+ * @see SM2::apply()
  */
 void Card::updateSM2(int grade)
 {
-    // Шаг 1: Ограничение оценки в допустимом диапазоне
-    grade = qBound(0, grade, 5);
-
-    // Шаг 2: Обновление времени последнего повторения
-    lastReview = QDateTime::currentDateTime();
-
-    // Шаг 3-4: Определение нового интервала в зависимости от оценки
-    if (grade < 3) {
-        // Неудачный ответ - сброс прогресса
-        repetitions = 0;
-        intervalDays = 1;
-    } else {
-        // Успешный ответ - увеличение интервала
-        if (repetitions == 0) {
-            intervalDays = 1;           // Первое успешное повторение
-        } else if (repetitions == 1) {
-            intervalDays = 6;           // Второе успешное повторение
-        } else {
-            // Последующие повторения: умножение на easyFactor
-            intervalDays = static_cast<int>(std::round(intervalDays * easyFactor));
-        }
-        repetitions++;  // Увеличение счетчика успешных повторений
-    }
+    updateSM2(grade, Clock::system());
+}
 
-    // Шаг 5: Обновление фактора легкости по формуле SM2
-    float quality = static_cast<float>(grade);
-    float newEF = easyFactor + (0.1f - (5.0f - quality) * (0.08f + (5.0f - quality) * 0.02f));
+/**
+ * @brief Обновить состояние карточки по алгоритму SM2 с заданными часами
+ * @param grade Оценка ответа (0-5)
+ * @param clock Источник момента ответа
+ */
+void Card::updateSM2(int grade, const Clock &clock)
+{
+    // Шаг 1: Обновление времени последнего повторения
+    lastReview = clock.now();
 
-    // Ограничение easyFactor в диапазоне [1.3, 2.5]
-    if (newEF < 1.3f) {
-        newEF = 1.3f;   // Нижняя граница
-    } else if (newEF > 2.5f) {
-        newEF = 2.5f;   // Верхняя граница
-    }
-    easyFactor = newEF;
+    // Шаг 2: Пересчет интервала, повторений и фактора легкости
+    SM2::apply(easyFactor, intervalDays, repetitions, grade);
 
-    // Шаг 6: Установка даты следующего повторения
+    // Шаг 3: Установка даты следующего повторения
+    nextReview = lastReview.addDays(intervalDays);
+}
+
+/**
+ * @brief Оценить ответ и перепланировать карточку выбранным планировщиком
+ * @param grade Оценка ответа (0-5)
+ * @param scheduler Алгоритм планирования
+ * @param clock Источник момента ответа
+ */
+void Card::review(int grade, const Scheduler &scheduler, const Clock &clock)
+{
+    const QDateTime now = clock.now();
+    const double elapsed = lastReview.isValid()
+                               ? Scheduler::elapsedDays(lastReview.toMSecsSinceEpoch(), now.toMSecsSinceEpoch())
+                               : 0.0;
+
+    SchedulingState state;
+    state.easyFactor = easyFactor;
+    state.intervalDays = intervalDays;
+    state.repetitions = repetitions;
+    scheduler.review(state, grade, elapsed);
+
+    easyFactor = state.easyFactor;
+    intervalDays = state.intervalDays;
+    repetitions = state.repetitions;
+    lastReview = now;
     nextReview = lastReview.addDays(intervalDays);
 }
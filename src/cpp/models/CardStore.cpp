@@ -0,0 +1,352 @@
+#include "CardStore.h"
+#include "SM2.h"
+#include "Scheduler.h"
+#include "TextArena.h"
+#include <QHash>
+
+/**
+ * @brief Преобразовать дату в значение столбца
+ *
+ * Сравнение полученных значений эквивалентно сравнению QDateTime:
+ * оба сравнивают моменты времени в UTC, независимо от часового пояса.
+ */
+qint64 CardStore::toEpochMSecs(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : kNoDate;
+}
+
+/**
+ * @brief Преобразовать значение столбца в дату
+ *
+ * Дата восстанавливается в локальном времени, как QDateTime::currentDateTime().
+ * Исходный часовой пояс не сохраняется, но момент времени совпадает,
+ * поэтому QDateTime::operator== считает даты равными.
+ */
+QDateTime CardStore::fromEpochMSecs(qint64 msecs)
+{
+    return msecs == kNoDate ? QDateTime() : QDateTime::fromMSecsSinceEpoch(msecs);
+}
+
+void CardStore::reserve(int rows)
+{
+    ids.reserve(rows);
+    deckIds.reserve(rows);
+    contentTypes.reserve(rows);
+    testModes.reserve(rows);
+    easyFactors.reserve(rows);
+    intervals.reserve(rows);
+    repetitionCounts.reserve(rows);
+    nextReviews.reserve(rows);
+    lastReviews.reserve(rows);
+    if (textStored) {
+        questions.reserve(rows);
+        answers.reserve(rows);
+    }
+}
+
+void CardStore::clear()
+{
+    ids.clear();
+    deckIds.clear();
+    contentTypes.clear();
+    testModes.clear();
+    easyFactors.clear();
+    intervals.clear();
+    repetitionCounts.clear();
+    nextReviews.clear();
+    lastReviews.clear();
+    questions.clear();
+    answers.clear();
+    textArena.reset();
+}
+
+/**
+ * @brief Добавить карточку в конец хранилища
+ *
+ * Раскладывает поля карточки по столбцам. Строки QString разделяют
+ * данные с исходной карточкой (implicit sharing), глубокой копии нет.
+ */
+int CardStore::append(const Card &card)
+{
+    const int row = size();
+    ids.append(card.getId());
+    deckIds.append(card.getDeckId());
+    contentTypes.append(card.getContentType());
+    testModes.append(card.getTestMode());
+    easyFactors.append(card.getEasyFactor());
+    intervals.append(card.getIntervalDays());
+    repetitionCounts.append(card.getRepetitions());
+    nextReviews.append(toEpochMSecs(card.getNextReview()));
+    lastReviews.append(toEpochMSecs(card.getLastReview()));
+    if (textStored) {
+        questions.append(card.getQuestion());
+        answers.append(card.getAnswer());
+    }
+    return row;
+}
+
+/**
+ * @brief Добавить карточку, переместив её строки в столбец текста
+ *
+ * Карточка перемещается во временный объект, который разрушается после
+ * раскладки по столбцам: единственными владельцами текста остаются
+ * столбцы хранилища, счетчики ссылок QString не растут.
+ */
+int CardStore::append(Card &&card)
+{
+    const Card source(std::move(card));
+    return append(source);
+}
+
+/**
+ * @brief Удалить строку, сдвинув последующие
+ *
+ * Сложность O(n): каждый столбец сдвигает свой хвост.
+ */
+void CardStore::removeAt(int row)
+{
+    ids.removeAt(row);
+    deckIds.removeAt(row);
+    contentTypes.removeAt(row);
+    testModes.removeAt(row);
+    easyFactors.removeAt(row);
+    intervals.removeAt(row);
+    repetitionCounts.removeAt(row);
+    nextReviews.removeAt(row);
+    lastReviews.removeAt(row);
+    if (textStored) {
+        questions.removeAt(row);
+        answers.removeAt(row);
+    }
+}
+
+Card CardStore::card(int row) const
+{
+    // Строки буфера не владеют данными: карточка получает свои копии
+    return Card(ids[row], ownedQuestion(row), ownedAnswer(row),
+                contentTypes[row], testModes[row],
+                easyFactors[row], intervals[row], repetitionCounts[row],
+                fromEpochMSecs(nextReviews[row]), fromEpochMSecs(lastReviews[row]),
+                deckIds[row]);
+}
+
+void CardStore::setCard(int row, const Card &card)
+{
+    ids[row] = card.getId();
+    deckIds[row] = card.getDeckId();
+    contentTypes[row] = card.getContentType();
+    testModes[row] = card.getTestMode();
+    easyFactors[row] = card.getEasyFactor();
+    intervals[row] = card.getIntervalDays();
+    repetitionCounts[row] = card.getRepetitions();
+    nextReviews[row] = toEpochMSecs(card.getNextReview());
+    lastReviews[row] = toEpochMSecs(card.getLastReview());
+    if (textStored) {
+        questions[row] = card.getQuestion();
+        answers[row] = card.getAnswer();
+    }
+}
+
+/**
+ * @brief Заменить содержимое хранилища готовыми столбцами
+ *
+ * Конструктор QList от диапазона указателей копирует тривиальные типы
+ * одним memcpy.
+ */
+void CardStore::assign(const Columns &columns, int rows, QList<QString> questions, QList<QString> answers)
+{
+    ids = QList<int>(columns.ids, columns.ids + rows);
+    deckIds = QList<int>(columns.deckIds, columns.deckIds + rows);
+    contentTypes = QList<ContentType>(columns.contentTypes, columns.contentTypes + rows);
+    testModes = QList<TestMode>(columns.testModes, columns.testModes + rows);
+    easyFactors = QList<float>(columns.easyFactors, columns.easyFactors + rows);
+    intervals = QList<int>(columns.intervals, columns.intervals + rows);
+    repetitionCounts = QList<int>(columns.repetitions, columns.repetitions + rows);
+    nextReviews = QList<qint64>(columns.nextReviews, columns.nextReviews + rows);
+    lastReviews = QList<qint64>(columns.lastReviews, columns.lastReviews + rows);
+
+    if (!textStored) {
+        textArena.reset();
+        return;
+    }
+    questions.resize(rows);
+    answers.resize(rows);
+    this->questions = std::move(questions);
+    this->answers = std::move(answers);
+    textArena.reset();
+}
+
+/**
+ * @brief Включить или выключить хранение текста
+ *
+ * При включении столбцы текста заполняются пустыми строками, чтобы
+ * их длина совпала с остальными столбцами.
+ */
+void CardStore::setTextStored(bool stored)
+{
+    if (stored == textStored) {
+        return;
+    }
+    textStored = stored;
+    if (stored) {
+        questions = QList<QString>(size());
+        answers = QList<QString>(size());
+    } else {
+        questions = QList<QString>();
+        answers = QList<QString>();
+        textArena.reset();
+    }
+}
+
+bool CardStore::isTextStored() const
+{
+    return textStored;
+}
+
+bool CardStore::sharesTextWith(const CardStore &other) const
+{
+    return textStored == other.textStored
+        && ids.isSharedWith(other.ids)
+        && questions.isSharedWith(other.questions)
+        && answers.isSharedWith(other.answers);
+}
+
+qsizetype CardStore::memoryUsage() const
+{
+    qsizetype bytes = ids.capacity() * qsizetype(sizeof(int))
+                    + deckIds.capacity() * qsizetype(sizeof(int))
+                    + contentTypes.capacity() * qsizetype(sizeof(ContentType))
+                    + testModes.capacity() * qsizetype(sizeof(TestMode))
+                    + easyFactors.capacity() * qsizetype(sizeof(float))
+                    + intervals.capacity() * qsizetype(sizeof(int))
+                    + repetitionCounts.capacity() * qsizetype(sizeof(int))
+                    + nextReviews.capacity() * qsizetype(sizeof(qint64))
+                    + lastReviews.capacity() * qsizetype(sizeof(qint64))
+                    + questions.capacity() * qsizetype(sizeof(QString))
+                    + answers.capacity() * qsizetype(sizeof(QString));
+
+    for (const QString &text : questions) {
+        bytes += text.capacity() * qsizetype(sizeof(QChar));
+    }
+    for (const QString &text : answers) {
+        bytes += text.capacity() * qsizetype(sizeof(QChar));
+    }
+    if (textArena) {
+        bytes += qsizetype(textArena->bytesReserved());
+    }
+    return bytes;
+}
+
+const QString &CardStore::emptyText()
+{
+    static const QString empty;
+    return empty;
+}
+
+/**
+ * @brief Применить оценку SM2 к строке
+ *
+ * Числовой шаг выполняет SM2::apply() - та же функция, что и в
+ * Card::updateSM2(). Дата следующего повторения вычисляется через
+ * QDateTime::addDays(), чтобы переходы на летнее время учитывались
+ * так же, как в Card.
+ */
+void CardStore::updateSM2(int row, int grade, const QDateTime &now)
+{
+    SM2::apply(easyFactors[row], intervals[row], repetitionCounts[row], grade);
+    lastReviews[row] = now.toMSecsSinceEpoch();
+    nextReviews[row] = now.addDays(intervals[row]).toMSecsSinceEpoch();
+}
+
+/**
+ * @brief Применить оценку к строке выбранным планировщиком
+ */
+void CardStore::review(int row, int grade, const QDateTime &now, const Scheduler &scheduler)
+{
+    const qint64 nowMSecs = now.toMSecsSinceEpoch();
+
+    SchedulingState state;
+    state.easyFactor = easyFactors[row];
+    state.intervalDays = intervals[row];
+    state.repetitions = repetitionCounts[row];
+    scheduler.review(state, grade, Scheduler::elapsedDays(lastReviews[row], nowMSecs));
+
+    easyFactors[row] = state.easyFactor;
+    intervals[row] = state.intervalDays;
+    repetitionCounts[row] = state.repetitions;
+    lastReviews[row] = nowMSecs;
+    nextReviews[row] = now.addDays(state.intervalDays).toMSecsSinceEpoch();
+}
+
+/**
+ * @brief Применить пакет оценок SM2 с общим моментом ответа
+ *
+ * Пакет делится на сегменты, внутри которых каждая строка встречается
+ * не больше одного раза: на повторе строки сегмент закрывается, так что
+ * следующая оценка видит уже обновленное состояние. Для каждого сегмента:
+ * 1. поля планирования собираются по номерам строк в плотные массивы;
+ * 2. SM2::applyBatch() обновляет их одним проходом;
+ * 3. результат раскладывается обратно в столбцы.
+ *
+ * QDateTime::addDays() учитывает часовой пояс и дорог, поэтому момент
+ * следующего повторения кэшируется по значению интервала: в пакете
+ * обычно встречается лишь несколько десятков разных интервалов.
+ */
+void CardStore::applyGrades(const int *rows, const int *grades, qsizetype count, const QDateTime &now)
+{
+    const qint64 nowMSecs = now.toMSecsSinceEpoch();
+    QHash<int, qint64> nextReviewByInterval;
+
+    QList<float> packedEasyFactors(count);
+    QList<int> packedIntervals(count);
+    QList<int> packedRepetitions(count);
+
+    // Номер сегмента, в котором строка встречалась последней. Хранятся
+    // только строки пакета, поэтому память и время - O(count), а не O(size())
+    QHash<int, int> segmentOfRow;
+    segmentOfRow.reserve(count);
+    int segment = 0;
+
+    qsizetype begin = 0;
+    while (begin < count) {
+        ++segment;
+        qsizetype end = begin;
+        while (end < count) {
+            int &lastSegment = segmentOfRow[rows[end]];
+            if (lastSegment == segment) {
+                break;
+            }
+            lastSegment = segment;
+            ++end;
+        }
+
+        const qsizetype length = end - begin;
+        const int *segmentRows = rows + begin;
+        for (qsizetype i = 0; i < length; ++i) {
+            const int row = segmentRows[i];
+            packedEasyFactors[i] = easyFactors[row];
+            packedIntervals[i] = intervals[row];
+            packedRepetitions[i] = repetitionCounts[row];
+        }
+
+        SM2::applyBatch(packedEasyFactors.data(), packedIntervals.data(),
+                        packedRepetitions.data(), grades + begin, length);
+
+        for (qsizetype i = 0; i < length; ++i) {
+            const int row = segmentRows[i];
+            const int interval = packedIntervals[i];
+            easyFactors[row] = packedEasyFactors[i];
+            intervals[row] = interval;
+            repetitionCounts[row] = packedRepetitions[i];
+            lastReviews[row] = nowMSecs;
+
+            auto cached = nextReviewByInterval.constFind(interval);
+            if (cached == nextReviewByInterval.constEnd()) {
+                cached = nextReviewByInterval.insert(interval, now.addDays(interval).toMSecsSinceEpoch());
+            }
+            nextReviews[row] = cached.value();
+        }
+
+        begin = end;
+    }
+}
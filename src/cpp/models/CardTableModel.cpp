@@ -0,0 +1,466 @@
+#include "CardTableModel.h"
+#include "CardContentCache.h"
+#include "Deck.h"
+#include <QSet>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+/**
+ * @brief Отсортировать позиции по ключу; равные ключи - по позиции в колоде
+ *
+ * Ключи выписываются в плотный массив пар один раз, поэтому сравнение
+ * не обращается к столбцам хранилища вразброс.
+ */
+template <typename Key, typename KeyOf>
+void sortByKey(QList<int> &rows, bool descending, KeyOf keyOf)
+{
+    QList<std::pair<Key, int>> keyed(rows.size());
+    for (qsizetype i = 0; i < rows.size(); ++i) {
+        keyed[i] = {keyOf(rows[i]), rows[i]};
+    }
+    if (descending) {
+        std::sort(keyed.begin(), keyed.end(), [](const std::pair<Key, int> &a, const std::pair<Key, int> &b) {
+            return a.first != b.first ? b.first < a.first : a.second < b.second;
+        });
+    } else {
+        std::sort(keyed.begin(), keyed.end());
+    }
+    for (qsizetype i = 0; i < rows.size(); ++i) {
+        rows[i] = keyed[i].second;
+    }
+}
+
+} // namespace
+
+CardTableModel::CardTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{}
+
+// =============== КОЛОДА ===============
+
+void CardTableModel::setDeck(const Deck *deck)
+{
+    source = deck;
+    sortColumn = -1;
+    sortOrder = Qt::AscendingOrder;
+    filterText.clear();
+    filterColumn = -1;
+    dueOnly = false;
+    resetRows();
+}
+
+const Deck *CardTableModel::deck() const
+{
+    return source;
+}
+
+void CardTableModel::reload()
+{
+    resetRows();
+}
+
+int CardTableModel::deckRow(int row) const
+{
+    return identity ? row : rows[row];
+}
+
+// =============== ПОРЦИИ ===============
+
+void CardTableModel::setFetchBatchSize(int rows)
+{
+    fetchBatch = std::max(1, rows);
+}
+
+int CardTableModel::fetchBatchSize() const
+{
+    return fetchBatch;
+}
+
+int CardTableModel::totalRowCount() const
+{
+    if (!source) {
+        return 0;
+    }
+    return identity ? source->store.size() : int(rows.size());
+}
+
+// =============== ФИЛЬТРЫ ===============
+
+void CardTableModel::setFilterText(const QString &text, int column)
+{
+    filterText = text;
+    filterColumn = (column == Question || column == Answer) ? column : -1;
+    resetRows();
+}
+
+void CardTableModel::setDueOnly(bool enabled)
+{
+    dueOnly = enabled;
+    resetRows();
+}
+
+/**
+ * @brief Отфильтровать строки колоды
+ *
+ * Без фильтров модель переходит в режим тождественной перестановки
+ * и освобождает rows. Фильтр готовности сравнивает плотный столбец
+ * дат, текстовый фильтр проверяется только для строк, прошедших его.
+ * Колода без текста читает текст из источника одним проходом и
+ * запоминает только подходящие карточки.
+ *
+ * Сложность алгоритма: O(n)
+ */
+void CardTableModel::applyFilters()
+{
+    rows.clear();
+    identity = true;
+    if (!source || (filterText.isEmpty() && !dueOnly)) {
+        rows.squeeze();
+        return;
+    }
+
+    const CardStore &store = source->store;
+    const qint64 now = source->getClock().nowMSecs();
+    identity = false;
+
+    QSet<int> matched;
+    const bool bulkText = !filterText.isEmpty() && !store.isTextStored()
+        && forEachDeckText([this, &matched](int cardId, const QString &question, const QString &answer) {
+               if (matchesText(question, answer)) {
+                   matched.insert(cardId);
+               }
+           });
+
+    for (int row = 0; row < store.size(); ++row) {
+        if (dueOnly && store.nextReviewMSecs(row) > now) {
+            continue;
+        }
+        if (!filterText.isEmpty() && !(bulkText ? matched.contains(store.id(row)) : matchesFilterText(row))) {
+            continue;
+        }
+        rows.append(row);
+    }
+}
+
+/**
+ * @brief Проверить текстовый фильтр для строки
+ *
+ * Если колода хранит только поля планирования, а источник не читает
+ * колоду целиком, текст строки берется из Deck::getContent().
+ */
+bool CardTableModel::matchesFilterText(int deckRow) const
+{
+    const CardStore &store = source->store;
+    CardContent content;
+    if (!store.isTextStored()) {
+        content = source->getContent(store.id(deckRow));
+    }
+    const QString &question = store.isTextStored() ? store.question(deckRow) : content.question;
+    const QString &answer = store.isTextStored() ? store.answer(deckRow) : content.answer;
+    return matchesText(question, answer);
+}
+
+bool CardTableModel::matchesText(const QString &question, const QString &answer) const
+{
+    return (filterColumn != Answer && question.contains(filterText, Qt::CaseInsensitive))
+        || (filterColumn != Question && answer.contains(filterText, Qt::CaseInsensitive));
+}
+
+bool CardTableModel::forEachDeckText(const CardContentSource::TextVisitor &visit) const
+{
+    return source->contentCache && source->contentCache->forEachText(source->getId(), visit);
+}
+
+/**
+ * @brief Переставить строки по столбцу
+ *
+ * 1. Дата следующего повторения: строки выписываются в порядке индекса
+ *    повторений; при фильтре лишние отсекаются маской. По убыванию
+ *    группы равных дат обходятся с конца, а внутри группы - по позиции.
+ * 2. Текст: устойчивая сортировка без учета регистра; входной порядок
+ *    совпадает с порядком колоды, поэтому равные строки остаются по позиции.
+ *    Колода без текста сначала читает текст столбца из источника одним
+ *    проходом, а если источник так не умеет - через Deck::getContent().
+ * 3. Остальные столбцы: сортировка пар (ключ, позиция).
+ *
+ * Сложность алгоритма: O(n) для даты повторения, O(n log n) для остальных
+ */
+void CardTableModel::applySort()
+{
+    if (!source || sortColumn < 0) {
+        return;
+    }
+
+    const CardStore &store = source->store;
+    if (identity) {
+        rows.resize(store.size());
+        for (int row = 0; row < store.size(); ++row) {
+            rows[row] = row;
+        }
+        identity = false;
+    }
+    const bool descending = sortOrder == Qt::DescendingOrder;
+
+    switch (sortColumn) {
+    case NextReview: {
+        const DueIndex &index = source->dueIndex;
+        QList<char> visible;
+        if (rows.size() != store.size()) {
+            visible.fill(0, store.size());
+            for (int row : std::as_const(rows)) {
+                visible[row] = 1;
+            }
+        }
+        qsizetype next = 0;
+        auto take = [&](DueIndex::const_iterator first, DueIndex::const_iterator last) {
+            for (auto it = first; it != last; ++it) {
+                if (visible.isEmpty() || visible[it->row]) {
+                    rows[next++] = it->row;
+                }
+            }
+        };
+        if (!descending) {
+            take(index.begin(), index.end());
+        } else {
+            auto groupEnd = index.end();
+            while (groupEnd != index.begin()) {
+                auto groupBegin = groupEnd - 1;
+                while (groupBegin != index.begin() && (groupBegin - 1)->dueAt == groupBegin->dueAt) {
+                    --groupBegin;
+                }
+                take(groupBegin, groupEnd);
+                groupEnd = groupBegin;
+            }
+        }
+        break;
+    }
+    case Question:
+    case Answer: {
+        const bool byQuestion = sortColumn == Question;
+        // Колода без текста: текст строки загружается один раз, а не при каждом сравнении
+        QList<QString> fetched;
+        if (!store.isTextStored()) {
+            fetched.resize(store.size());
+            const Deck *deck = source;
+            const bool bulk = forEachDeckText([deck, &fetched, byQuestion](int cardId, const QString &question,
+                                                                           const QString &answer) {
+                const int row = deck->indexOf(cardId);
+                if (row >= 0) {
+                    fetched[row] = byQuestion ? question : answer;
+                }
+            });
+            if (!bulk) {
+                for (int row : std::as_const(rows)) {
+                    const CardContent content = source->getContent(store.id(row));
+                    fetched[row] = byQuestion ? content.question : content.answer;
+                }
+            }
+        }
+        auto textOf = [&store, &fetched, byQuestion](int row) -> const QString & {
+            if (!fetched.isEmpty()) {
+                return fetched[row];
+            }
+            return byQuestion ? store.question(row) : store.answer(row);
+        };
+        std::stable_sort(rows.begin(), rows.end(), [&textOf, descending](int a, int b) {
+            const int order = QString::compare(textOf(a), textOf(b), Qt::CaseInsensitive);
+            return descending ? order > 0 : order < 0;
+        });
+        break;
+    }
+    case Id:
+        sortByKey<int>(rows, descending, [&store](int row) { return store.id(row); });
+        break;
+    case EasyFactor:
+        sortByKey<float>(rows, descending, [&store](int row) { return store.easyFactor(row); });
+        break;
+    case Interval:
+        sortByKey<int>(rows, descending, [&store](int row) { return store.intervalDays(row); });
+        break;
+    case Repetitions:
+        sortByKey<int>(rows, descending, [&store](int row) { return store.repetitions(row); });
+        break;
+    case LastReview:
+        sortByKey<qint64>(rows, descending, [&store](int row) { return store.lastReviewMSecs(row); });
+        break;
+    default:
+        break;
+    }
+}
+
+void CardTableModel::resetRows()
+{
+    beginResetModel();
+    applyFilters();
+    applySort();
+    loaded = std::min(fetchBatch, totalRowCount());
+    endResetModel();
+}
+
+// =============== QAbstractTableModel ===============
+
+int CardTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : loaded;
+}
+
+int CardTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant CardTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!source || !index.isValid() || index.row() >= loaded || index.column() >= ColumnCount) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return displayValue(deckRow(index.row()), index.column());
+    case Qt::TextAlignmentRole:
+        if (index.column() != Question && index.column() != Answer) {
+            return int(Qt::AlignRight | Qt::AlignVCenter);
+        }
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+/**
+ * @brief Значение ячейки
+ *
+ * Если колода хранит только поля планирования, текст видимых строк
+ * подгружается через Deck::getContent() (кэш содержимого).
+ */
+QVariant CardTableModel::displayValue(int deckRow, int column) const
+{
+    const CardStore &store = source->store;
+    switch (column) {
+    case Id:
+        return store.id(deckRow);
+    case Question:
+        return store.isTextStored() ? store.ownedQuestion(deckRow) : source->getContent(store.id(deckRow)).question;
+    case Answer:
+        return store.isTextStored() ? store.ownedAnswer(deckRow) : source->getContent(store.id(deckRow)).answer;
+    case EasyFactor:
+        return store.easyFactor(deckRow);
+    case Interval:
+        return store.intervalDays(deckRow);
+    case Repetitions:
+        return store.repetitions(deckRow);
+    case NextReview:
+    case LastReview: {
+        const qint64 msecs = column == NextReview ? store.nextReviewMSecs(deckRow) : store.lastReviewMSecs(deckRow);
+        if (msecs == CardStore::kNoDate) {
+            return QVariant();
+        }
+        return CardStore::fromEpochMSecs(msecs);
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant CardTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+
+    switch (section) {
+    case Id:
+        return QStringLiteral("ID");
+    case Question:
+        return QStringLiteral("Вопрос");
+    case Answer:
+        return QStringLiteral("Ответ");
+    case EasyFactor:
+        return QStringLiteral("Легкость");
+    case Interval:
+        return QStringLiteral("Интервал");
+    case Repetitions:
+        return QStringLiteral("Повторений");
+    case NextReview:
+        return QStringLiteral("Следующее повторение");
+    case LastReview:
+        return QStringLiteral("Последнее повторение");
+    default:
+        return QVariant();
+    }
+}
+
+bool CardTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && loaded < totalRowCount();
+}
+
+void CardTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    const int count = std::min(fetchBatch, totalRowCount() - loaded);
+    if (count <= 0) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), loaded, loaded + count - 1);
+    loaded += count;
+    endInsertRows();
+}
+
+/**
+ * @brief Отсортировать строки
+ *
+ * Отфильтрованные строки сначала возвращаются в порядок колоды,
+ * затем переставляются по столбцу. Постоянные индексы переносятся
+ * через обратную перестановку, которая строится, только если такие
+ * индексы есть.
+ */
+void CardTableModel::sort(int column, Qt::SortOrder order)
+{
+    if (!source || column >= ColumnCount) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+
+    const QModelIndexList previous = persistentIndexList();
+    QList<int> previousRows(previous.size());
+    for (qsizetype i = 0; i < previous.size(); ++i) {
+        previousRows[i] = deckRow(previous[i].row());
+    }
+
+    sortColumn = column;
+    sortOrder = order;
+    if (!identity) {
+        std::sort(rows.begin(), rows.end());
+        if (column < 0 && filterText.isEmpty() && !dueOnly) {
+            identity = true;
+            rows.clear();
+        }
+    }
+    applySort();
+
+    if (!previous.isEmpty()) {
+        QList<int> modelRow(source->store.size(), -1);
+        for (int row = 0; row < totalRowCount(); ++row) {
+            modelRow[deckRow(row)] = row;
+        }
+        QModelIndexList moved(previous.size());
+        for (qsizetype i = 0; i < previous.size(); ++i) {
+            const int row = modelRow[previousRows[i]];
+            moved[i] = row >= 0 && row < loaded ? index(row, previous[i].column()) : QModelIndex();
+        }
+        changePersistentIndexList(previous, moved);
+    }
+
+    emit layoutChanged();
+}
@@ -0,0 +1,205 @@
+#include "ConcurrentDeck.h"
+#include "SearchIndex.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <utility>
+
+// =============== Snapshot ===============
+
+ConcurrentDeck::Snapshot::Snapshot(std::atomic<quint64> *slot, const Version *version)
+    : slot(slot)
+    , current(version)
+{}
+
+ConcurrentDeck::Snapshot::Snapshot(Snapshot &&other) noexcept
+    : slot(std::exchange(other.slot, nullptr))
+    , current(std::exchange(other.current, nullptr))
+{}
+
+ConcurrentDeck::Snapshot &ConcurrentDeck::Snapshot::operator=(Snapshot &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        slot = std::exchange(other.slot, nullptr);
+        current = std::exchange(other.current, nullptr);
+    }
+    return *this;
+}
+
+ConcurrentDeck::Snapshot::~Snapshot()
+{
+    release();
+}
+
+const Deck &ConcurrentDeck::Snapshot::deck() const
+{
+    return current->deck;
+}
+
+quint64 ConcurrentDeck::Snapshot::version() const
+{
+    return current->number;
+}
+
+void ConcurrentDeck::Snapshot::release()
+{
+    if (slot) {
+        slot->store(kIdle);
+        slot = nullptr;
+        current = nullptr;
+    }
+}
+
+// =============== ConcurrentDeck ===============
+
+ConcurrentDeck::ConcurrentDeck(Deck deck, int readerSlots)
+    : current(nullptr)
+    , slotCount(std::max(1, readerSlots))
+    , searchIndex(deck.searchIndex)
+{
+    detachObservers(deck);
+    current.store(new Version{std::move(deck), 0, 0});
+    readers.reset(new ReaderSlot[slotCount]);
+}
+
+ConcurrentDeck::~ConcurrentDeck()
+{
+    qDeleteAll(retired);
+    delete current.load();
+}
+
+/**
+ * @brief Взять снимок текущей версии
+ *
+ * 1. Читатель захватывает свободную ячейку, записывая в неё текущую
+ *    эпоху (CAS). Поиск начинается с ячейки, занятой этим потоком
+ *    в прошлый раз, поэтому обычно хватает одной попытки, а разные
+ *    потоки пишут в разные строки кэша.
+ * 2. Только после этого читается указатель на версию. Писатель
+ *    освобождает версию, лишь когда все занятые ячейки объявили эпоху
+ *    не раньше её замены, поэтому прочитанная версия не будет удалена.
+ *
+ * Эпоха, прочитанная до захвата, может устареть - это лишь задержит
+ * освобождение старых версий.
+ */
+ConcurrentDeck::Snapshot ConcurrentDeck::read() const
+{
+    static std::atomic<unsigned> threads{0};
+    thread_local unsigned hint = threads.fetch_add(1, std::memory_order_relaxed);
+
+    for (;;) {
+        for (int i = 0; i < slotCount; ++i) {
+            const int index = int((hint + unsigned(i)) % unsigned(slotCount));
+            std::atomic<quint64> &slot = readers[index].epoch;
+            quint64 idle = kIdle;
+            if (slot.load(std::memory_order_relaxed) == kIdle && slot.compare_exchange_strong(idle, epoch.load())) {
+                hint = unsigned(index);
+                return Snapshot(&slot, current.load());
+            }
+        }
+        QThread::yieldCurrentThread();
+    }
+}
+
+quint64 ConcurrentDeck::version() const
+{
+    return current.load()->number;
+}
+
+bool ConcurrentDeck::update(const std::function<bool(Deck &)> &mutation)
+{
+    QMutexLocker locker(&writer);
+    const Version *previous = current.load();
+    auto *next = new Version{previous->deck, previous->number + 1, 0};
+    if (!mutation(next->deck)) {
+        delete next;
+        return false;
+    }
+    detachObservers(next->deck);
+    reindex(previous->deck, next->deck);
+    publish(next);
+    return true;
+}
+
+bool ConcurrentDeck::reviewCard(int cardId, int grade)
+{
+    return update([cardId, grade](Deck &deck) { return deck.reviewCard(cardId, grade); });
+}
+
+int ConcurrentDeck::applyGrades(const QList<CardGrade> &grades)
+{
+    int applied = 0;
+    update([&grades, &applied](Deck &deck) {
+        applied = deck.applyGrades(grades);
+        return applied > 0;
+    });
+    return applied;
+}
+
+int ConcurrentDeck::retainedVersions() const
+{
+    QMutexLocker locker(&writer);
+    return int(retired.size());
+}
+
+void ConcurrentDeck::detachObservers(Deck &deck)
+{
+    deck.searchIndex = nullptr;
+    deck.dueCountCache = nullptr;
+    deck.forecast = nullptr;
+    deck.contentCache = nullptr;
+}
+
+/**
+ * @brief Перенести изменения текста в полнотекстовый индекс
+ *
+ * Оценки меняют только поля планирования, и столбцы текста новой
+ * версии остаются общими с прежней - тогда индекс не трогается.
+ * Иначе карточки прежней версии заменяются в индексе карточками
+ * новой: O(n), но только при изменении текста или состава колоды.
+ */
+void ConcurrentDeck::reindex(const Deck &previous, const Deck &next)
+{
+    if (!searchIndex || next.store.sharesTextWith(previous.store)) {
+        return;
+    }
+    for (int row = 0; row < previous.store.size(); ++row) {
+        searchIndex->removeCard(previous.store.id(row));
+    }
+    if (next.store.isTextStored()) {
+        for (int row = 0; row < next.store.size(); ++row) {
+            searchIndex->addCard(next.store.id(row), next.store.question(row), next.store.answer(row));
+        }
+    }
+}
+
+/**
+ * @brief Опубликовать версию
+ *
+ * Указатель заменяется до перехода к следующей эпохе: читатель,
+ * объявивший новую эпоху, гарантированно прочитает новую версию.
+ */
+void ConcurrentDeck::publish(Version *next)
+{
+    Version *previous = current.exchange(next);
+    previous->retiredAt = epoch.fetch_add(1) + 1;
+    retired.append(previous);
+    reclaim();
+}
+
+void ConcurrentDeck::reclaim()
+{
+    quint64 oldest = kIdle;
+    for (int i = 0; i < slotCount; ++i) {
+        oldest = std::min(oldest, readers[i].epoch.load());
+    }
+    retired.removeIf([oldest](Version *version) {
+        if (version->retiredAt > oldest) {
+            return false;
+        }
+        delete version;
+        return true;
+    });
+}
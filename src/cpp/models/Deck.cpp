@@ -1,14 +1,90 @@
 #include "Deck.h"
+#include "DueFilter.h"
+#include "CardContentCache.h"
+#include "SearchIndex.h"
+#include "DueCountCache.h"
+#include "Scheduler.h"
 #include <QDateTime>
+#include <QSet>
+#include <algorithm>
 
 /**
  * @brief Конструктор по умолчанию
  *
  * Инициализирует колоду с нулевым идентификатором, пустым названием
- * и пустым списком карточек.
+ * и пустым хранилищем карточек. Время берется из системных часов.
  * Использует список инициализации членов для эффективности.
  */
-Deck::Deck() : id(0), name(""), cards() {}
+Deck::Deck() : id(0), name(""), store(), clock(&Clock::system()) {}
+
+/**
+ * @brief Перестроить индекс повторений и таблицу позиций
+ *
+ * Вызывается при полной замене списка карточек. Ключами индекса служит
+ * столбец дат следующего повторения как есть, без преобразований.
+ * При совпадающих идентификаторах в таблице остается первая карточка.
+ */
+void Deck::rebuildIndexes()
+{
+    static_assert(CardStore::kNoDate == DueIndex::kAlwaysDue,
+                  "Отсутствующая дата должна оставаться минимальным ключом индекса");
+
+    rebuildRowIds();
+    dueIndex.rebuild(store.nextReviewColumn());
+}
+
+void Deck::rebuildRowIds()
+{
+    rowById.clear();
+    rowById.reserve(store.size());
+    for (int row = 0; row < store.size(); ++row) {
+        if (!rowById.contains(store.id(row))) {
+            rowById.insert(store.id(row), row);
+        }
+    }
+}
+
+void Deck::assignStore(CardStore cards, DueIndex index)
+{
+    unindexCards();
+    store = std::move(cards);
+    dueIndex = std::move(index);
+    rebuildRowIds();
+    indexCards(0);
+    if (dueCountCache) {
+        dueCountCache->invalidate(this);
+    }
+    rebuildForecast();
+}
+
+/**
+ * @brief Добавить строки хранилища начиная с firstRow в полнотекстовый индекс
+ */
+void Deck::indexCards(int firstRow)
+{
+    if (!searchIndex || !store.isTextStored()) {
+        return;
+    }
+    for (int row = firstRow; row < store.size(); ++row) {
+        searchIndex->addCard(store.id(row), store.question(row), store.answer(row));
+    }
+}
+
+/**
+ * @brief Убрать все карточки колоды из полнотекстового индекса
+ *
+ * Карточки удаляются по идентификатору и тогда, когда колода уже не
+ * хранит текст: в индексе не должно остаться ни одной её карточки.
+ */
+void Deck::unindexCards()
+{
+    if (!searchIndex) {
+        return;
+    }
+    for (int row = 0; row < store.size(); ++row) {
+        searchIndex->removeCard(store.id(row));
+    }
+}
 
 /**
  * @brief Получить идентификатор колоды
@@ -30,11 +106,56 @@ QString Deck::getName() const
 
 /**
  * @brief Получить список всех карточек в колоде
+ *
+ * Тонкая обертка над getCardsView(): собирает Card из каждой строки хранилища.
+ *
  * @return QList<Card> Копия списка карточек
  */
 QList<Card> Deck::getCards() const
 {
-    return cards;
+    QList<Card> result;
+    result.reserve(store.size());
+    for (const CardRef &card : getCardsView()) {
+        result.append(card.toCard());
+    }
+    return result;
+}
+
+/**
+ * @brief Получить представление всех карточек без копирования
+ * @return CardSpan Невладеющий диапазон над внутренним списком
+ */
+CardSpan Deck::getCardsView() const
+{
+    return CardSpan(&store);
+}
+
+/**
+ * @brief Получить количество карточек в колоде
+ * @return Количество карточек
+ */
+int Deck::getCardCount() const
+{
+    return store.size();
+}
+
+/**
+ * @brief Найти позицию карточки в колоде
+ * @param cardId Идентификатор карточки
+ * @return Позиция карточки или -1
+ */
+int Deck::indexOf(int cardId) const
+{
+    return rowById.value(cardId, -1);
+}
+
+/**
+ * @brief Получить часы колоды
+ * @return Часы, заданные setClock(), или системные часы
+ */
+const Clock &Deck::getClock() const
+{
+    return *clock;
 }
 
 /**
@@ -61,46 +182,453 @@ void Deck::setName(QString name)
  */
 void Deck::setCards(QList<Card> cards)
 {
-    this->cards = cards;
+    unindexCards();
+    store.clear();
+    store.reserve(static_cast<int>(cards.size()));
+    // Константный обход не отсоединяет список от копии вызывающей стороны,
+    // а строки карточек попадают в столбцы без глубокого копирования
+    for (const Card &card : std::as_const(cards)) {
+        store.append(card);
+    }
+    rebuildIndexes();
+    indexCards(0);
+    if (dueCountCache) {
+        dueCountCache->invalidate(this);
+    }
+    rebuildForecast();
+}
+
+/**
+ * @brief Установить часы для операций повторения
+ * @param clock Часы; nullptr возвращает системные часы
+ */
+void Deck::setClock(const Clock *clock)
+{
+    this->clock = clock ? clock : &Clock::system();
+}
+
+/**
+ * @brief Получить планировщик повторений колоды
+ */
+const Scheduler &Deck::getScheduler() const
+{
+    return scheduler ? *scheduler : Scheduler::defaultScheduler();
+}
+
+/**
+ * @brief Установить алгоритм планирования
+ * @param scheduler Планировщик; nullptr - SM-2
+ */
+void Deck::setScheduler(const Scheduler *scheduler)
+{
+    this->scheduler = scheduler;
+}
+
+/**
+ * @brief Хранить только поля планирования, без текста карточек
+ *
+ * Вместе с текстом карточки колоды уходят из полнотекстового индекса.
+ */
+void Deck::setMetadataOnly(bool metadataOnly)
+{
+    if (metadataOnly && store.isTextStored()) {
+        unindexCards();
+    }
+    store.setTextStored(!metadataOnly);
+}
+
+bool Deck::isMetadataOnly() const
+{
+    return !store.isTextStored();
+}
+
+void Deck::setContentCache(CardContentCache *cache)
+{
+    contentCache = cache;
+}
+
+/**
+ * @brief Подключить полнотекстовый индекс
+ *
+ * Карточки колоды убираются из прежнего индекса и добавляются в новый.
+ */
+void Deck::setSearchIndex(SearchIndex *index)
+{
+    if (index == searchIndex) {
+        return;
+    }
+    unindexCards();
+    searchIndex = index;
+    indexCards(0);
+}
+
+void Deck::setDueCountCache(DueCountCache *cache)
+{
+    dueCountCache = cache;
+}
+
+void Deck::setForecast(ReviewForecast *forecast)
+{
+    this->forecast = forecast;
+    rebuildForecast();
+}
+
+/**
+ * @brief Пересчитать подключенный прогноз
+ *
+ * Момент построения и горизонт прогноза сохраняются, корзины
+ * заполняются заново по индексу повторений.
+ */
+void Deck::rebuildForecast()
+{
+    if (!forecast || forecast->days() == 0) {
+        return;
+    }
+    ReviewForecast rebuilt(QDateTime::fromMSecsSinceEpoch(forecast->dayStart(0)), forecast->days());
+    rebuilt.addIndex(dueIndex);
+    *forecast = rebuilt;
+}
+
+/**
+ * @brief Получить текст и медиаданные карточки
+ *
+ * Кэш используется, только когда без него не обойтись: для текста
+ * в режиме без текста и для медиаданных, которые колода не хранит никогда.
+ */
+CardContent Deck::getContent(int cardId) const
+{
+    const int row = indexOf(cardId);
+    if (row < 0) {
+        return CardContent();
+    }
+
+    const bool needsMedia = store.contentType(row) != ContentType::Text;
+    if (contentCache && (!store.isTextStored() || needsMedia)) {
+        return contentCache->content(cardId);
+    }
+
+    CardContent content;
+    content.question = store.ownedQuestion(row);
+    content.answer = store.ownedAnswer(row);
+    return content;
+}
+
+/**
+ * @brief Добавить карточку в конец колоды
+ *
+ * Новая карточка получает последнюю позицию, поэтому позиции остальных
+ * карточек в индексе не меняются.
+ */
+void Deck::addCard(const Card &card)
+{
+    const int row = store.append(card);
+    dueIndex.insert(store.nextReviewMSecs(row), row);
+    if (!rowById.contains(card.getId())) {
+        rowById.insert(card.getId(), row);
+    }
+    indexCards(row);
+    if (dueCountCache) {
+        dueCountCache->cardAdded(this, store.nextReviewMSecs(row));
+    }
+    if (forecast) {
+        forecast->cardAdded(store.nextReviewMSecs(row));
+    }
+}
+
+void Deck::addCards(QList<Card> cards)
+{
+    // Без reserve(): точный резерв на каждый пакет отключил бы
+    // геометрический рост столбцов и копировал бы их на каждом пакете
+    const int firstRow = store.size();
+    for (const Card &card : std::as_const(cards)) {
+        const int row = store.append(card);
+        if (!rowById.contains(card.getId())) {
+            rowById.insert(card.getId(), row);
+        }
+    }
+    dueIndex.insertRows(firstRow, store.nextReviewColumn().mid(firstRow));
+    indexCards(firstRow);
+    if (dueCountCache) {
+        dueCountCache->invalidate(this);
+    }
+    rebuildForecast();
+}
+
+/**
+ * @brief Удалить карточку из колоды
+ *
+ * Удаление из середины списка сдвигает позиции последующих карточек,
+ * поэтому индекс корректирует их, а таблица позиций перестраивается.
+ *
+ * Сложность алгоритма: O(n)
+ */
+bool Deck::removeCard(int cardId)
+{
+    auto it = rowById.constFind(cardId);
+    if (it == rowById.constEnd()) {
+        return false;
+    }
+
+    const int row = it.value();
+    const qint64 key = store.nextReviewMSecs(row);
+    dueIndex.remove(key, row);
+    store.removeAt(row);
+    if (dueCountCache) {
+        dueCountCache->cardRemoved(this, key);
+    }
+    if (forecast) {
+        forecast->cardRemoved(key);
+    }
+    if (searchIndex) {
+        searchIndex->removeCard(cardId);
+    }
+    if (contentCache) {
+        contentCache->invalidate(cardId);
+    }
+
+    rowById.clear();
+    for (int i = 0; i < store.size(); ++i) {
+        if (!rowById.contains(store.id(i))) {
+            rowById.insert(store.id(i), i);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Заменить карточку с тем же идентификатором
+ *
+ * Строка хранилища перезаписывается на месте, элемент индекса
+ * повторений переносится на новую дату, а текст переиндексируется.
+ * Запись кэша содержимого удаляется: следующий getContent() прочитает
+ * текст заново.
+ *
+ * Сложность алгоритма: O(log n) плюс сдвиг участка индекса
+ */
+bool Deck::updateCard(const Card &card)
+{
+    auto it = rowById.constFind(card.getId());
+    if (it == rowById.constEnd()) {
+        return false;
+    }
+
+    const int row = it.value();
+    const qint64 oldKey = store.nextReviewMSecs(row);
+    store.setCard(row, card);
+    dueIndex.update(oldKey, store.nextReviewMSecs(row), row);
+    if (dueCountCache) {
+        dueCountCache->cardRescheduled(this, oldKey, store.nextReviewMSecs(row));
+    }
+    if (forecast) {
+        forecast->cardRescheduled(oldKey, store.nextReviewMSecs(row));
+    }
+    if (searchIndex && store.isTextStored()) {
+        searchIndex->updateCard(card.getId(), card.getQuestion(), card.getAnswer());
+    } else if (searchIndex) {
+        searchIndex->removeCard(card.getId());
+    }
+    if (contentCache) {
+        contentCache->invalidate(card.getId());
+    }
+    return true;
+}
+
+/**
+ * @brief Оценить ответ по карточке и перепланировать её
+ *
+ * Запоминает прежний ключ карточки, применяет алгоритм SM2 прямо к строке
+ * хранилища (CardStore::updateSM2) и переносит элемент индекса на новое место.
+ *
+ * Сложность алгоритма: O(log n) на поиск плюс сдвиг участка индекса
+ */
+bool Deck::reviewCard(int cardId, int grade)
+{
+    auto it = rowById.constFind(cardId);
+    if (it == rowById.constEnd()) {
+        return false;
+    }
+
+    const int row = it.value();
+    const qint64 oldKey = store.nextReviewMSecs(row);
+    if (scheduler) {
+        store.review(row, grade, clock->now(), *scheduler);
+    } else {
+        store.updateSM2(row, grade, clock->now());
+    }
+    dueIndex.update(oldKey, store.nextReviewMSecs(row), row);
+    if (dueCountCache) {
+        dueCountCache->cardRescheduled(this, oldKey, store.nextReviewMSecs(row));
+    }
+    if (forecast) {
+        forecast->cardRescheduled(oldKey, store.nextReviewMSecs(row));
+    }
+    return true;
+}
+
+/**
+ * @brief Применить пакет оценок с общим моментом ответа
+ *
+ * Переводит идентификаторы в позиции, запоминает прежние ключи индекса
+ * и передает пакет в CardStore::applyGrades() (с планировщиком,
+ * заданным setScheduler(), - по одной оценке в CardStore::review()).
+ * Затем индекс повторений приводится в соответствие одним из двух
+ * способов:
+ * - пакет затрагивает заметную долю колоды: индекс перестраивается
+ *   целиком за O(n log n), что дешевле множества сдвигов;
+ * - иначе каждая затронутая карточка переносится один раз, от исходного
+ *   ключа сразу к итоговому.
+ *
+ * Сложность алгоритма: O(k) на обновление полей плюс обновление индекса
+ */
+int Deck::applyGrades(const QList<CardGrade> &grades, const QDateTime &now)
+{
+    QList<int> rows;
+    QList<int> rowGrades;
+    QList<qint64> oldKeys;
+    rows.reserve(grades.size());
+    rowGrades.reserve(grades.size());
+    oldKeys.reserve(grades.size());
+
+    for (const CardGrade &entry : grades) {
+        auto it = rowById.constFind(entry.cardId);
+        if (it == rowById.constEnd()) {
+            continue;
+        }
+        rows.append(it.value());
+        rowGrades.append(entry.grade);
+        oldKeys.append(store.nextReviewMSecs(it.value()));
+    }
+
+    if (rows.isEmpty()) {
+        return 0;
+    }
+
+    if (scheduler) {
+        for (qsizetype i = 0; i < rows.size(); ++i) {
+            store.review(rows[i], rowGrades[i], now, *scheduler);
+        }
+    } else {
+        store.applyGrades(rows.constData(), rowGrades.constData(), rows.size(), now);
+    }
+
+    if (qint64(rows.size()) * 16 >= store.size()) {
+        dueIndex.rebuild(store.nextReviewColumn());
+        if (dueCountCache) {
+            dueCountCache->invalidate(this);
+        }
+        rebuildForecast();
+    } else {
+        // Ключ первого вхождения строки - исходный, до всего пакета
+        QSet<int> moved;
+        moved.reserve(rows.size());
+        for (int i = 0; i < rows.size(); ++i) {
+            const int row = rows[i];
+            if (!moved.contains(row)) {
+                moved.insert(row);
+                dueIndex.update(oldKeys[i], store.nextReviewMSecs(row), row);
+                if (dueCountCache) {
+                    dueCountCache->cardRescheduled(this, oldKeys[i], store.nextReviewMSecs(row));
+                }
+                if (forecast) {
+                    forecast->cardRescheduled(oldKeys[i], store.nextReviewMSecs(row));
+                }
+            }
+        }
+    }
+
+    return static_cast<int>(rows.size());
+}
+
+/**
+ * @brief Применить пакет оценок по часам колоды
+ *
+ * Время читается один раз на весь пакет.
+ */
+int Deck::applyGrades(const QList<CardGrade> &grades)
+{
+    return applyGrades(grades, clock->now());
+}
+
+/**
+ * @brief Позиции готовых к повторению карточек в порядке колоды
+ *
+ * Выбирает более дешевый из двух путей по количеству готовых карточек k,
+ * которое индекс дает за O(log n):
+ * - k мало по сравнению с n: позиции берутся из префикса DueIndex
+ *   и сортируются, O(log n + k log k);
+ * - иначе весь столбец дат проходит через векторизованный фильтр
+ *   DueFilter::compactDue(), который сразу выдает позиции по возрастанию
+ *   за один последовательный проход без сортировки.
+ *
+ * @param now Текущий момент (мс от эпохи)
+ * @return QList<int> Позиции карточек в хранилище по возрастанию
+ */
+QList<int> Deck::dueRows(qint64 now) const
+{
+    const int dueCount = dueIndex.countDue(now);
+    QList<int> rows;
+
+    if (qint64(dueCount) * 8 < store.size()) {
+        rows.reserve(dueCount);
+        for (auto it = dueIndex.begin(), end = dueIndex.dueEnd(now); it != end; ++it) {
+            rows.append(it->row);
+        }
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    }
+
+    const QList<qint64> &dates = store.nextReviewColumn();
+    rows.resize(dates.size());
+    const qsizetype written = DueFilter::compactDue(dates.constData(), dates.size(), now, rows.data());
+    rows.resize(written);
+    return rows;
 }
 
 /**
  * @brief Получить карточки для повторения сегодня
  *
- * Алгоритм отбора карточек для повторения:
- * 1. Получает текущее системное время
- * 2. Для каждой карточки в колоде проверяет дату следующего повторения
- * 3. Если дата невалидна или наступила/прошла - добавляет карточку в результат
+ * Тонкая обертка над dueRows(): собирает Card для каждой готовой
+ * строки хранилища в порядке колоды.
  *
- * Сложность алгоритма: O(n), где n - количество карточек в колоде
+ * Сложность алгоритма: O(min(k log k, n / w)), где n - количество карточек,
+ * k - количество готовых карточек, w - ширина SIMD-сравнения
  *
  * @return QList<Card> Список карточек, требующих повторения
  *
- * @note Использует QDateTime::currentDateTime() для получения текущего времени
- * @note Карточки с невалидными датами (QDateTime()) считаются готовыми к повторению
+ * @note Карточки с невалидными датами (QDateTime()) считаются готовыми к повторению:
+ *       их дата хранится как CardStore::kNoDate, минимальное значение qint64
  * @note Время сравнения включает дату и время, а не только дату
  *
- * @see QDateTime::isValid()
- * @see QDateTime::currentDateTime()
+ * @see getDueCardsView()
+ * @see DueFilter
  */
 QList<Card> Deck::getDueCards() const
 {
-    QList<Card> dueCards;
-    QDateTime now = QDateTime::currentDateTime();
-
-    // Проход по всем карточкам в колоде
-    for (const Card& card : cards) {
-        QDateTime nextReview = card.getNextReview();
+    const QList<int> rows = dueRows(clock->nowMSecs());
 
-        // Условие включения карточки в список повторения
-        if (!nextReview.isValid() || nextReview <= now) {
-            dueCards.append(card);
-        }
+    QList<Card> dueCards;
+    dueCards.reserve(rows.size());
+    for (int row : rows) {
+        dueCards.append(store.card(row));
     }
 
     return dueCards;
 }
 
+/**
+ * @brief Получить ленивый диапазон карточек для повторения
+ *
+ * Бинарным поиском находит в индексе границу готовых карточек и
+ * возвращает диапазон над этим префиксом.
+ *
+ * @see Clock::nowMSecs()
+ */
+DueCardRange Deck::getDueCardsView() const
+{
+    const qint64 now = clock->nowMSecs();
+    return DueCardRange(dueIndex.begin(), dueIndex.dueEnd(now), &store);
+}
+
 /**
  * @brief Получить количество карточек для повторения сегодня
  *
@@ -110,7 +638,7 @@ QList<Card> Deck::getDueCards() const
  * Используется, когда нужен только счетчик, а не сами карточки.
  * Полезно для отображения статистики и уведомлений.
  *
- * Сложность алгоритма: O(n), где n - количество карточек в колоде
+ * Сложность алгоритма: O(log n) - бинарный поиск в индексе повторений
  *
  * @return int Количество карточек, готовых к повторению
  *
@@ -119,16 +647,18 @@ QList<Card> Deck::getDueCards() const
  */
 int Deck::getDueCount() const
 {
-    int count = 0;
-    QDateTime now = QDateTime::currentDateTime();
-
-    // Подсчет карточек, готовых к повторению
-    for (const Card& card : cards) {
-        QDateTime nextReview = card.getNextReview();
-        if (!nextReview.isValid() || nextReview <= now) {
-            count++;
-        }
-    }
+    return dueIndex.countDue(clock->nowMSecs());
+}
 
-    return count;
+/**
+ * @brief Прогноз нагрузки на ближайшие дни
+ *
+ * Время читается один раз; корзины заполняются бинарными поисками
+ * границ дней в индексе повторений.
+ */
+ReviewForecast Deck::getForecast(int days) const
+{
+    ReviewForecast forecast(clock->now(), days);
+    forecast.addIndex(dueIndex);
+    return forecast;
 }
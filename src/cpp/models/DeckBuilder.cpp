@@ -0,0 +1,81 @@
+#include "DeckBuilder.h"
+#include "Deck.h"
+
+DeckBuilder::DeckBuilder(int expectedCards, qsizetype blockChars) :
+    text(new TextArena(blockChars)),
+    blockChars(blockChars)
+{
+    store.reserve(expectedCards);
+}
+
+int DeckBuilder::append(const Row &row, const QString &question, const QString &answer)
+{
+    const int index = store.size();
+    store.ids.append(row.id);
+    store.deckIds.append(row.deckId);
+    store.contentTypes.append(row.contentType);
+    store.testModes.append(row.testMode);
+    store.easyFactors.append(row.easyFactor);
+    store.intervals.append(row.intervalDays);
+    store.repetitionCounts.append(row.repetitions);
+    store.nextReviews.append(row.nextReview);
+    store.lastReviews.append(row.lastReview);
+    store.questions.append(question);
+    store.answers.append(answer);
+    return index;
+}
+
+int DeckBuilder::add(const Row &row, QStringView question, QStringView answer)
+{
+    return append(row, text->add(question), text->add(answer));
+}
+
+int DeckBuilder::addUtf8(const Row &row, QByteArrayView question, QByteArrayView answer)
+{
+    return append(row, text->addUtf8(question), text->addUtf8(answer));
+}
+
+int DeckBuilder::add(const Card &card)
+{
+    Row row;
+    row.id = card.getId();
+    row.deckId = card.getDeckId();
+    row.contentType = card.getContentType();
+    row.testMode = card.getTestMode();
+    row.easyFactor = card.getEasyFactor();
+    row.intervalDays = card.getIntervalDays();
+    row.repetitions = card.getRepetitions();
+    row.nextReview = CardStore::toEpochMSecs(card.getNextReview());
+    row.lastReview = CardStore::toEpochMSecs(card.getLastReview());
+    return add(row, card.getQuestion(), card.getAnswer());
+}
+
+int DeckBuilder::size() const
+{
+    return store.size();
+}
+
+const TextArena &DeckBuilder::arena() const
+{
+    return *text;
+}
+
+/**
+ * @brief Передать столбцы и буфер текста колоде
+ *
+ * Хранилище получает общую ссылку на буфер: копии колоды продлевают
+ * его жизнь, а последняя из них освобождает все блоки сразу.
+ */
+void DeckBuilder::build(Deck &deck)
+{
+    static_assert(CardStore::kNoDate == DueIndex::kAlwaysDue,
+                  "Отсутствующая дата должна оставаться минимальным ключом индекса");
+
+    store.textArena = text;
+    DueIndex index;
+    index.rebuild(store.nextReviewColumn());
+    deck.assignStore(std::move(store), std::move(index));
+
+    store = CardStore();
+    text = QSharedPointer<TextArena>(new TextArena(blockChars));
+}
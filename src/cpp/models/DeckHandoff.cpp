@@ -0,0 +1,36 @@
+#include "DeckHandoff.h"
+#include <QMutexLocker>
+#include <utility>
+
+void DeckHandoff::publish(Deck deck)
+{
+    publish(QSharedPointer<const Deck>(new Deck(std::move(deck))));
+}
+
+/**
+ * @brief Заменить опубликованную колоду
+ *
+ * Под мьютексом только обмениваются указатели; прежняя колода
+ * освобождается после снятия блокировки, чтобы current() в потоке
+ * интерфейса не ждал деструктора большой колоды.
+ */
+void DeckHandoff::publish(QSharedPointer<const Deck> next)
+{
+    {
+        QMutexLocker locker(&mutex);
+        deck.swap(next);
+        published.fetch_add(1, std::memory_order_release);
+    }
+    next.reset();
+}
+
+QSharedPointer<const Deck> DeckHandoff::current() const
+{
+    QMutexLocker locker(&mutex);
+    return deck;
+}
+
+quint64 DeckHandoff::version() const
+{
+    return published.load(std::memory_order_acquire);
+}
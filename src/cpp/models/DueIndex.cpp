@@ -0,0 +1,140 @@
+#include "DueIndex.h"
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Порядок элементов индекса: по времени, затем по позиции
+ *
+ * Вторичный ключ делает порядок строгим, поэтому конкретный элемент
+ * находится бинарным поиском даже среди карточек с одинаковой датой.
+ */
+bool entryLess(const DueIndex::Entry &lhs, const DueIndex::Entry &rhs)
+{
+    if (lhs.dueAt != rhs.dueAt) {
+        return lhs.dueAt < rhs.dueAt;
+    }
+    return lhs.row < rhs.row;
+}
+
+} // namespace
+
+void DueIndex::clear()
+{
+    entries.clear();
+}
+
+/**
+ * @brief Перестроить индекс целиком
+ *
+ * Заполняет массив элементов в порядке колоды и сортирует его один раз,
+ * что дешевле n отдельных вставок.
+ */
+void DueIndex::rebuild(const QList<qint64> &keys)
+{
+    entries.clear();
+    entries.reserve(keys.size());
+    for (int row = 0; row < keys.size(); ++row) {
+        entries.append(Entry{keys[row], row});
+    }
+    std::sort(entries.begin(), entries.end(), entryLess);
+}
+
+void DueIndex::assign(const Entry *sorted, int count)
+{
+    entries = QList<Entry>(sorted, sorted + count);
+}
+
+void DueIndex::insert(qint64 dueAt, int row)
+{
+    const Entry entry{dueAt, row};
+    auto pos = std::lower_bound(entries.begin(), entries.end(), entry, entryLess);
+    entries.insert(pos, entry);
+}
+
+void DueIndex::insertRows(int firstRow, const QList<qint64> &keys)
+{
+    const qsizetype oldSize = entries.size();
+    entries.reserve(oldSize + keys.size());
+    for (int i = 0; i < keys.size(); ++i) {
+        entries.append(Entry{keys[i], firstRow + i});
+    }
+    std::sort(entries.begin() + oldSize, entries.end(), entryLess);
+    std::inplace_merge(entries.begin(), entries.begin() + oldSize, entries.end(), entryLess);
+}
+
+/**
+ * @brief Удалить карточку из индекса
+ *
+ * После удаления элемента выполняется проход по индексу для сдвига позиций,
+ * поэтому сложность O(n) - такая же, как у удаления из середины QList.
+ */
+void DueIndex::remove(qint64 dueAt, int row)
+{
+    const Entry entry{dueAt, row};
+    auto pos = std::lower_bound(entries.begin(), entries.end(), entry, entryLess);
+    if (pos != entries.end() && pos->dueAt == dueAt && pos->row == row) {
+        entries.erase(pos);
+    }
+
+    // Сдвиг не меняет относительный порядок элементов с одинаковым dueAt
+    for (Entry &e : entries) {
+        if (e.row > row) {
+            --e.row;
+        }
+    }
+}
+
+/**
+ * @brief Перенести карточку на новый момент повторения
+ *
+ * Вместо пары erase/insert элемент сдвигается на новое место вращением
+ * только затронутого участка массива.
+ */
+void DueIndex::update(qint64 oldDueAt, qint64 newDueAt, int row)
+{
+    const Entry oldEntry{oldDueAt, row};
+    const Entry newEntry{newDueAt, row};
+
+    auto oldPos = std::lower_bound(entries.begin(), entries.end(), oldEntry, entryLess);
+    if (oldPos == entries.end() || oldPos->dueAt != oldDueAt || oldPos->row != row) {
+        insert(newDueAt, row);
+        return;
+    }
+
+    auto newPos = std::lower_bound(entries.begin(), entries.end(), newEntry, entryLess);
+    if (newPos > oldPos) {
+        // Элемент уходит вправо: все между ним и новой позицией сдвигаются влево
+        std::rotate(oldPos, oldPos + 1, newPos);
+        *(newPos - 1) = newEntry;
+    } else {
+        std::rotate(newPos, oldPos, oldPos + 1);
+        *newPos = newEntry;
+    }
+}
+
+int DueIndex::countDue(qint64 now) const
+{
+    return static_cast<int>(dueEnd(now) - entries.begin());
+}
+
+DueIndex::const_iterator DueIndex::begin() const
+{
+    return entries.begin();
+}
+
+DueIndex::const_iterator DueIndex::dueEnd(qint64 now) const
+{
+    return std::upper_bound(entries.begin(), entries.end(), now,
+                            [](qint64 value, const Entry &e) { return value < e.dueAt; });
+}
+
+DueIndex::const_iterator DueIndex::end() const
+{
+    return entries.end();
+}
+
+int DueIndex::size() const
+{
+    return static_cast<int>(entries.size());
+}
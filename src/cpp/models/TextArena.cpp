@@ -0,0 +1,82 @@
+#include "TextArena.h"
+#include <algorithm>
+#include <cstring>
+
+TextArena::TextArena(qsizetype blockChars) :
+    blockChars(std::max<qsizetype>(blockChars, 64)),
+    decoder(QStringConverter::Utf8, QStringConverter::Flag::Stateless)
+{}
+
+char16_t *TextArena::allocate(qsizetype chars)
+{
+    if (chars <= limit - cursor) {
+        char16_t *start = cursor;
+        cursor += chars;
+        usedChars += chars;
+        return start;
+    }
+
+    usedChars += chars;
+    if (chars > blockChars / 4) {
+        // Текущий блок продолжает заполняться
+        reservedChars += chars;
+        blocks.push_back(std::unique_ptr<char16_t[]>(new char16_t[chars]));
+        return blocks.back().get();
+    }
+    reservedChars += blockChars;
+    blocks.push_back(std::unique_ptr<char16_t[]>(new char16_t[blockChars]));
+    cursor = blocks.back().get() + chars;
+    limit = blocks.back().get() + blockChars;
+    return blocks.back().get();
+}
+
+void TextArena::release(char16_t *start, qsizetype reserved, qsizetype used)
+{
+    usedChars -= reserved - used;
+    if (start + reserved == cursor) {
+        cursor = start + used;
+    }
+}
+
+QString TextArena::add(QStringView text)
+{
+    if (text.isEmpty()) {
+        return QString();
+    }
+    char16_t *start = allocate(text.size());
+    std::memcpy(start, text.utf16(), size_t(text.size()) * sizeof(char16_t));
+    return QString::fromRawData(reinterpret_cast<const QChar *>(start), text.size());
+}
+
+/**
+ * @brief Декодировать UTF-8 в буфер
+ *
+ * Символов UTF-16 не больше, чем байт UTF-8, поэтому выделяется
+ * utf8.size() символов, а неиспользованный хвост возвращается буферу.
+ */
+QString TextArena::addUtf8(QByteArrayView utf8)
+{
+    if (utf8.isEmpty()) {
+        return QString();
+    }
+    char16_t *start = allocate(utf8.size());
+    QChar *out = reinterpret_cast<QChar *>(start);
+    const qsizetype size = decoder.appendToBuffer(out, utf8) - out;
+    release(start, utf8.size(), size);
+    return QString::fromRawData(out, size);
+}
+
+int TextArena::blockCount() const
+{
+    return int(blocks.size());
+}
+
+qint64 TextArena::bytesReserved() const
+{
+    return reservedChars * qint64(sizeof(char16_t));
+}
+
+qint64 TextArena::bytesUsed() const
+{
+    return usedChars * qint64(sizeof(char16_t));
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <QtGlobal>
+
+/**
+ * @brief Счетчик выделений памяти для бенчмарков
+ *
+ * По умолчанию считаются только вызовы operator new/new[], что совместимо
+ * с ASan/TSan. Qt выделяет данные QString и QList через malloc, поэтому эти
+ * выделения видны только в сборке с опцией QTCARDS_COUNT_ALLOCATIONS на glibc,
+ * где перехватываются malloc/calloc/realloc.
+ */
+namespace AllocationCounter {
+
+/**
+ * @brief Общее количество выделений памяти с момента запуска тестов
+ */
+quint64 total();
+
+/**
+ * @brief Учитываются ли выделения внутри Qt (сборка с QTCARDS_COUNT_ALLOCATIONS)
+ */
+bool countsQtAllocations();
+
+/**
+ * @brief Подсчет выделений памяти внутри области видимости
+ */
+class Scope
+{
+public:
+    Scope() : start(total()) {}
+
+    /**
+     * @brief Количество выделений с момента создания области
+     */
+    quint64 allocations() const { return total() - start; }
+
+private:
+    quint64 start;
+};
+
+} // namespace AllocationCounter
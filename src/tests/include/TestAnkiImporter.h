@@ -0,0 +1,22 @@
+#pragma once
+#include <QObject>
+
+class TestAnkiImporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Преобразование карточек
+    void testSchedulingMapping();
+    void testFieldsAndContentTypes();
+    void testReviewLogSummary();
+    void testDeckFilterAndSuspended();
+
+    // Получатели и ошибки
+    void testRepositoryImportWithMedia();
+    void testMissingMediaCounted();
+    void testMissingCollectionFails();
+
+    // Производительность
+    void testImportThroughput();
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <QObject>
+
+class TestCardExporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Форматы
+    void testCsvRoundTripThroughImporter();
+    void testJsonLines();
+    void testBinaryRoundTrip();
+    void testDeflateCompression();
+
+    // Фоновый экспорт
+    void testBackgroundExport();
+    void testCancelKeepsPreviousFile();
+
+    // Производительность
+    void testExportThroughput_data();
+    void testExportThroughput();
+};
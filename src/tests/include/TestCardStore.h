@@ -0,0 +1,26 @@
+#pragma once
+#include <QObject>
+
+class TestCardStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Строки и столбцы
+    void testEmptyStore();
+    void testAppendAndReadBack();
+    void testAppendMove();
+    void testInvalidDatesRoundTrip();
+    void testRemoveAt();
+    void testSetCard();
+    void testCardRefGetters();
+
+    // Планирование
+    void testUpdateSM2MatchesCard();
+    void testApplyBatchMatchesApply();
+    void testApplyGradesMatchesUpdateSM2();
+
+    // Производительность
+    void testDueScanPerformance_data();
+    void testDueScanPerformance();
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include <QObject>
+
+class TestCardTableModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Данные
+    void testDataAndHeaders();
+    void testLazyFetch();
+    void testReload();
+
+    // Сортировка и фильтры
+    void testSort_data();
+    void testSort();
+    void testFilters();
+    void testPersistentIndexFollowsSort();
+    void testMetadataOnlyDeck();
+
+    // Производительность
+    void testBrowseSpeed_data();
+    void testBrowseSpeed();
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <QObject>
+
+class TestClock : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Реализации часов
+    void testSystemClockTracksCurrentTime();
+    void testFixedClockAdvance();
+    void testCachedClockTracksSystemTime();
+    void testCachedClockResolution();
+
+    // Часы в Card и Deck
+    void testCardUpdateSM2WithClock();
+    void testDeckUsesClock();
+    void testDeckApplyGradesReadsClockOnce();
+
+    // Производительность
+    void testNowPerformance_data();
+    void testNowPerformance();
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include <QObject>
+
+class TestConcurrentDeck : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Версии
+    void testSnapshotIsolation();
+    void testRejectedUpdate();
+    void testSearchIndexFollowsPublishedVersion();
+    void testContentCacheNotShared();
+    void testReclaimAfterRelease();
+    void testReaderSlotsExhausted();
+
+    // Нагрузка
+    void testReadersAndWriterStress();
+};
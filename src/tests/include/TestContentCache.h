@@ -0,0 +1,24 @@
+#pragma once
+#include <QObject>
+
+class TestContentCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Кэш
+    void testHitAndMiss();
+    void testEvictsLeastRecentlyUsed();
+    void testOversizedContentNotCached();
+    void testInvalidate();
+    void testMissingCard();
+
+    // Колода без текста
+    void testStoreWithoutText();
+    void testMetadataOnlyDeck();
+    void testLoadDeckMetadataFromRepository();
+
+    // Производительность
+    void testLazyStartup_data();
+    void testLazyStartup();
+};
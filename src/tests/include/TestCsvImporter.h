@@ -0,0 +1,32 @@
+#pragma once
+#include <QObject>
+
+class TestCsvImporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Разбор
+    void testHeaderAndAllColumns();
+    void testQuotedFields();
+    void testTsvWithoutHeader();
+    void testMissingRequiredColumns();
+
+    // Ошибки и порядок
+    void testMalformedRowsReported();
+    void testChunkBoundaries_data();
+    void testChunkBoundaries();
+    void testMidFieldQuotes_data();
+    void testMidFieldQuotes();
+    void testProgressReported();
+
+    // Получатели
+    void testDeckSink();
+    void testRepositorySink();
+    void testRepositoryImportKeepsOtherDecks();
+    void testSinkAbortsImport();
+
+    // Производительность
+    void testImportThroughput_data();
+    void testImportThroughput();
+};
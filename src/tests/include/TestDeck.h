@@ -59,7 +59,28 @@ private slots:
     void testGetDueCountConsistency(); // Проверка что getDueCount() == getDueCards().size()
 
     void testGetDueCardsOrder(); // Если нужна сортировка
+
+    // Индекс повторений
+    void testAddCardUpdatesDueIndex();
+    void testRemoveCardUpdatesDueIndex();
+    void testReviewCardReschedules();
+    void testReviewCardUnknownId();
+    void testApplyGradesReschedules();
+    void testApplyGradesMatchesReviewCard();
+
+    // Представления без копирования
+    void testGetCardsViewNoCopy();
+    void testGetDueCardsViewOrder();
+    void testGetDueCardsViewMatchesCopy();
+
+    void testGetDueCardsPerformance_data();
     void testGetDueCardsPerformance(); // Для больших колод
+    void testGetDueCountPerformance_data();
+    void testGetDueCountPerformance();
+    void testDueCardsViewPerformance_data();
+    void testDueCardsViewPerformance();
+    void testApplyGradesPerformance_data();
+    void testApplyGradesPerformance();
 
 private:
     Deck* testDeck = nullptr;
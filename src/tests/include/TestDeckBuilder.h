@@ -0,0 +1,20 @@
+#pragma once
+#include <QObject>
+
+class TestDeckBuilder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Буфер текста
+    void testArena();
+
+    // Сборка колоды
+    void testBuildMatchesSetCards();
+    void testLifetime();
+    void testModifyAfterBuild();
+
+    // Производительность
+    void testConstructionAndTeardown_data();
+    void testConstructionAndTeardown();
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <functional>
+#include "Deck.h"
+
+/**
+ * @brief Общие заготовки колод для модульных тестов
+ *
+ * Сборка колоды одинакова во всех тестах; тест задает только распределение
+ * сроков или, если нужны особые поля, саму карточку.
+ */
+namespace TestDecks {
+
+/**
+ * @brief Фиксированный момент «сейчас» для часов и сроков карточек
+ */
+extern const QDateTime kNow;
+
+/**
+ * @brief Срок следующего повторения i-й карточки (пустой - новая карточка)
+ */
+using DueDate = std::function<QDateTime(int i)>;
+
+/**
+ * @brief Фабрика i-й карточки колоды
+ */
+using CardFactory = std::function<Card(int i)>;
+
+/**
+ * @brief Текстовая карточка «Вопрос i» / «Ответ i»
+ */
+Card textCard(int id, int i, const QDateTime &nextReview, int deckId,
+              int intervalDays = 3, int repetitions = 2);
+
+/**
+ * @brief Колода из текстовых карточек с идентификаторами deckId * 1000000 + i
+ * @param clock Часы колоды (nullptr - системные)
+ */
+Deck makeDeck(int deckId, int count, const DueDate &dueDate, const Clock *clock = nullptr);
+
+/**
+ * @brief Колода из count карточек, созданных makeCard
+ * @param clock Часы колоды (nullptr - системные)
+ */
+Deck buildDeck(int deckId, int count, const CardFactory &makeCard, const Clock *clock = nullptr);
+
+} // namespace TestDecks
@@ -0,0 +1,21 @@
+#pragma once
+#include <QObject>
+
+class TestDueCountCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Счетчики
+    void testMatchesDeckCounts();
+    void testIncrementalUpdates();
+    void testBulkChangesInvalidate();
+    void testRemoveDeck();
+
+    // Время
+    void testTimerNotifies();
+
+    // Производительность
+    void testRepaintRefresh_data();
+    void testRepaintRefresh();
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <QObject>
+
+class TestDueFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Корректность
+    void testEmptyInput();
+    void testInvalidDatesAreDue();
+    void testBoundaryValues();
+    void testKernelsMatchScalar_data();
+    void testKernelsMatchScalar();
+    void testDeckUsesFilterForLargeDueShare();
+
+    // Производительность
+    void testCompactPerformance_data();
+    void testCompactPerformance();
+};
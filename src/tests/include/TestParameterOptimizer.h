@@ -0,0 +1,20 @@
+#pragma once
+#include <QObject>
+
+class TestParameterOptimizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Параметры
+    void testInvalidInput();
+
+    // Обучение
+    void testRecoversGeneratingWeights();
+    void testDeterministic();
+    void testFittedParametersSchedule();
+
+    // Производительность
+    void testFitSpeed_data();
+    void testFitSpeed();
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <QObject>
+#include <QSqlDatabase>
+
+class TestRepository : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    // Схема
+    void testOpenCreatesSchema();
+    void testOpenEnablesWal();
+
+    // Колоды
+    void testSaveAndLoadDeck();
+    void testSaveDeckReplacesCards();
+    void testLoadMissingDeck();
+    void testRemoveDeck();
+    void testSaveScheduling();
+    void testSaveMetadataOnlyDeck();
+
+    // Карточки
+    void testInsertCardsAppends();
+    void testRemoveCard();
+    void testLoadDueCardsMatchesDeck();
+    void testDueQueryUsesIndex();
+    void testFailedBulkInsertRollsBack();
+
+    // Производительность
+    void testSaveLoadThroughput_data();
+    void testSaveLoadThroughput();
+
+private:
+    QString connectionName;
+    QSqlDatabase database;
+};
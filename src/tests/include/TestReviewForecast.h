@@ -0,0 +1,21 @@
+#pragma once
+#include <QObject>
+
+class TestReviewForecast : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Гистограмма
+    void testDeckHistogram();
+    void testCollectionMatchesDecks();
+    void testMergeRequiresSameDays();
+
+    // Обновление
+    void testIncrementalReschedule();
+    void testDeckMaintainsForecast();
+
+    // Производительность
+    void testForecastSpeed_data();
+    void testForecastSpeed();
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include <QObject>
+
+class TestReviewJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Запись и чтение
+    void testAppendFlushAndRead();
+    void testReopenContinuesSequence();
+    void testAppendWhenClosed();
+
+    // Групповая фиксация
+    void testGroupCommitBatchesRecords();
+    void testIntervalCommitsWithoutFlush();
+
+    // Восстановление
+    void testTornTailIsDropped();
+    void testRecoverAppliesToRepository();
+    void testCheckpointTruncatesJournal();
+
+    // Производительность
+    void testReviewSessionLatency();
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <QObject>
+
+class TestReviewQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Порядок
+    void testMergeByDueTime();
+    void testRoundRobin();
+    void testDeckByDeck();
+    void testEmptyQueue();
+
+    // Лимиты и сессия
+    void testDailyLimits();
+    void testReviewDuringSession();
+
+    // Производительность
+    void testMergeVersusSort_data();
+    void testMergeVersusSort();
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <QObject>
+
+class TestScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // SM-2
+    void testSm2MatchesUpdateSM2();
+
+    // FSRS
+    void testFsrsFirstReview();
+    void testFsrsForgettingCurve();
+    void testFsrsRatingsOrderIntervals();
+    void testFsrsLapse();
+    void testFsrsStateFromSm2Fields();
+
+    // Колода
+    void testDeckUsesScheduler();
+
+    // Оценка параметров
+    void testEvaluatePrefersTrueParameters();
+
+    // Производительность
+    void testReplayReviewCounts();
+};
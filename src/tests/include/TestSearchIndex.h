@@ -0,0 +1,30 @@
+#pragma once
+#include <QObject>
+
+class TestSearchIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Разбиение на слова
+    void testTokenizeUnicode();
+    void testToFts5Query();
+
+    // Запросы
+    void testWordAndPrefixQueries();
+    void testPhraseQueries();
+    void testLimit();
+
+    // Изменение
+    void testDeckKeepsIndexInSync();
+    void testCompaction();
+
+    // Файл и база данных
+    void testSaveAndLoad();
+    void testLoadRejectsCorruptFile();
+    void testMatchesFts5();
+
+    // Производительность
+    void testQueryLatency_data();
+    void testQueryLatency();
+};
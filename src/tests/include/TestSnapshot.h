@@ -0,0 +1,27 @@
+#pragma once
+#include <QObject>
+
+class TestSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Запись и чтение
+    void testRoundTrip();
+    void testMetadataOnlyDeck();
+    void testStringsAreInterned();
+    void testEmptyCollection();
+
+    // Проверка целостности
+    void testRejectsMissingFile();
+    void testRejectsForeignFile();
+    void testDetectsCorruptedSection();
+    void testDetectsMalformedDueIndex();
+
+    // Запись через журнал
+    void testJournalWriteBack();
+
+    // Производительность
+    void testColdStart_data();
+    void testColdStart();
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <QObject>
+
+class TestStringPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Пул
+    void testIntern();
+    void testSqueeze();
+    void testConcurrentIntern();
+
+    // Карточки и импорт
+    void testCardConstruction();
+    void testCsvImport();
+
+    // Память
+    void testMemorySaved();
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <QObject>
+
+class TestTaskRunner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Задачи
+    void testRunAndProgress();
+    void testFailure();
+    void testCancelRunning();
+    void testCancelQueued();
+
+    // Передача колоды
+    void testHandoff();
+    void testDeckTasks();
+
+    // Отзывчивость
+    void testEventLoopLatency_data();
+    void testEventLoopLatency();
+};
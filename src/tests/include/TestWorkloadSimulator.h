@@ -0,0 +1,23 @@
+#pragma once
+#include <QObject>
+
+class TestWorkloadSimulator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // Параметры
+    void testInvalidOptions();
+
+    // Модель
+    void testDeterministicLoad();
+    void testDailyLimitCarriesOver();
+    void testClockShiftsDays();
+    void testConfidenceBand();
+    void testThreadCountIndependence();
+
+    // Производительность
+    void testNoPerTrialAllocations();
+    void testSimulationSpeed_data();
+    void testSimulationSpeed();
+};
@@ -0,0 +1,539 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include "TestAnkiImporter.h"
+#include "AnkiImporter.h"
+#include "CardContent.h"
+#include "Database.h"
+#include "DeckRepository.h"
+#include "SM2.h"
+
+namespace {
+
+/// Дата создания тестовой коллекции (секунды от эпохи)
+constexpr qint64 kCreationSecs = 1700006400;
+
+/// Миллисекунд в сутках
+constexpr qint64 kDayMSecs = 86400000;
+
+/**
+ * @brief Карточка Anki для тестовой коллекции
+ */
+struct AnkiCard {
+    qint64 id = 0;
+    qint64 noteId = 0;
+    qint64 deckId = 1;
+    int ord = 0;
+    int type = 0;
+    int queue = 0;
+    qint64 due = 0;
+    int interval = 0;
+    int factor = 0;
+    qint64 originalDue = 0;
+    qint64 originalDeckId = 0;
+};
+
+/**
+ * @brief Минимальная коллекция Anki: только таблицы и столбцы, которые
+ *        читает импорт
+ */
+class AnkiCollection
+{
+public:
+    explicit AnkiCollection(const QString &path)
+        : connection("anki_fixture_" + path)
+    {
+        database = QSqlDatabase::addDatabase("QSQLITE", connection);
+        database.setDatabaseName(path);
+        database.open();
+        exec("CREATE TABLE col (id INTEGER PRIMARY KEY, crt INTEGER NOT NULL)");
+        exec("CREATE TABLE notes (id INTEGER PRIMARY KEY, flds TEXT NOT NULL)");
+        exec("CREATE TABLE cards (id INTEGER PRIMARY KEY, nid INTEGER NOT NULL, did INTEGER NOT NULL,"
+             " ord INTEGER NOT NULL, type INTEGER NOT NULL, queue INTEGER NOT NULL, due INTEGER NOT NULL,"
+             " ivl INTEGER NOT NULL, factor INTEGER NOT NULL, odue INTEGER NOT NULL, odid INTEGER NOT NULL)");
+        exec("CREATE TABLE revlog (id INTEGER PRIMARY KEY, cid INTEGER NOT NULL, ease INTEGER NOT NULL)");
+        exec("INSERT INTO col (id, crt) VALUES (1, " + QString::number(kCreationSecs) + ")");
+    }
+
+    ~AnkiCollection()
+    {
+        database.close();
+        database = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connection);
+    }
+
+    void begin() { database.transaction(); }
+    void commit() { database.commit(); }
+
+    void addNote(qint64 id, const QStringList &fields)
+    {
+        QSqlQuery query(database);
+        query.prepare("INSERT INTO notes (id, flds) VALUES (?, ?)");
+        query.addBindValue(id);
+        query.addBindValue(fields.join(QChar(0x1f)));
+        query.exec();
+    }
+
+    void addCard(const AnkiCard &card)
+    {
+        QSqlQuery query(database);
+        query.prepare("INSERT INTO cards VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        for (const QVariant &value : {QVariant(card.id), QVariant(card.noteId), QVariant(card.deckId),
+                                      QVariant(card.ord), QVariant(card.type), QVariant(card.queue),
+                                      QVariant(card.due), QVariant(card.interval), QVariant(card.factor),
+                                      QVariant(card.originalDue), QVariant(card.originalDeckId)}) {
+            query.addBindValue(value);
+        }
+        query.exec();
+    }
+
+    void addReview(qint64 cardId, qint64 timeMSecs, int ease)
+    {
+        QSqlQuery query(database);
+        query.prepare("INSERT INTO revlog (id, cid, ease) VALUES (?, ?, ?)");
+        query.addBindValue(timeMSecs);
+        query.addBindValue(cardId);
+        query.addBindValue(ease);
+        query.exec();
+    }
+
+    void exec(const QString &sql)
+    {
+        QSqlQuery query(database);
+        query.exec(sql);
+    }
+
+    QSqlDatabase &handle() { return database; }
+
+private:
+
+    QString connection;
+    QSqlDatabase database;
+};
+
+/**
+ * @brief Новая карточка с заметкой из двух полей
+ */
+void newCard(AnkiCollection &collection, qint64 id, const QString &front, const QString &back)
+{
+    collection.addNote(id, {front, back});
+    AnkiCard card;
+    card.id = id;
+    card.noteId = id;
+    collection.addCard(card);
+}
+
+/**
+ * @brief Импортировать коллекцию целиком в список
+ */
+QList<Card> importAll(AnkiImporter &importer, const QString &path, bool *ok = nullptr)
+{
+    QList<Card> cards;
+    const bool imported = importer.importCollection(path,
+        [&cards](QList<Card> &&batch) {
+            cards.append(std::move(batch));
+            return true;
+        },
+        AnkiImporter::MediaSink());
+    if (ok) {
+        *ok = imported;
+    }
+    return cards;
+}
+
+/**
+ * @brief Записать медиафайлы и карту media так, как их хранит .apkg
+ */
+void writeMedia(const QString &directory, const QHash<QString, QByteArray> &files)
+{
+    QJsonObject map;
+    int index = 0;
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it, ++index) {
+        QFile file(directory + "/" + QString::number(index));
+        file.open(QIODevice::WriteOnly);
+        file.write(it.value());
+        map.insert(QString::number(index), it.key());
+    }
+    QFile media(directory + "/media");
+    media.open(QIODevice::WriteOnly);
+    media.write(QJsonDocument(map).toJson(QJsonDocument::Compact));
+}
+
+} // namespace
+
+// ==================== MAPPING ====================
+
+void TestAnkiImporter::testSchedulingMapping()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.anki2");
+    {
+        AnkiCollection collection(path);
+        newCard(collection, 10, "new", "a");
+
+        newCard(collection, 20, "learning", "a");
+        collection.exec("UPDATE cards SET type = 1, queue = 1, due = 1700100000 WHERE id = 20");
+
+        collection.addNote(30, {"review", "a"});
+        AnkiCard review;
+        review.id = 30;
+        review.noteId = 30;
+        review.type = 2;
+        review.queue = 2;
+        review.due = 10;
+        review.interval = 7;
+        review.factor = 2300;
+        collection.addCard(review);
+
+        // Карточка в фильтрованной колоде: срок хранится в odue
+        collection.addNote(40, {"filtered", "a"});
+        AnkiCard filtered = review;
+        filtered.id = 40;
+        filtered.noteId = 40;
+        filtered.factor = 1000;
+        filtered.due = 999;
+        filtered.originalDue = 20;
+        filtered.originalDeckId = 1;
+        collection.addCard(filtered);
+
+        collection.addNote(50, {"relearning", "a"});
+        AnkiCard relearning;
+        relearning.id = 50;
+        relearning.noteId = 50;
+        relearning.type = 3;
+        relearning.queue = 3;
+        relearning.due = 12;
+        relearning.interval = 1;
+        relearning.factor = 3100;
+        collection.addCard(relearning);
+    }
+
+    AnkiImporter::Options options;
+    options.deckId = 4;
+    options.firstCardId = 100;
+    AnkiImporter importer(options);
+    bool ok = false;
+    const QList<Card> cards = importAll(importer, path, &ok);
+    QVERIFY2(ok, qPrintable(importer.lastError()));
+    QCOMPARE(cards.size(), 5);
+    QCOMPARE(importer.result().cards, qint64(5));
+    QCOMPARE(importer.result().imported, qint64(5));
+
+    const qint64 creation = kCreationSecs * 1000;
+    QCOMPARE(cards[0].getId(), 100);
+    QCOMPARE(cards[0].getDeckId(), 4);
+    QVERIFY(!cards[0].getNextReview().isValid());
+    QCOMPARE(cards[0].getIntervalDays(), 0);
+    QCOMPARE(cards[0].getRepetitions(), 0);
+    QCOMPARE(cards[0].getEasyFactor(), 2.5f);
+
+    QCOMPARE(cards[1].getId(), 101);
+    QCOMPARE(cards[1].getNextReview().toMSecsSinceEpoch(), 1700100000000LL);
+
+    QCOMPARE(cards[2].getNextReview().toMSecsSinceEpoch(), creation + 10 * kDayMSecs);
+    QCOMPARE(cards[2].getIntervalDays(), 7);
+    QCOMPARE(cards[2].getRepetitions(), 1);
+    QCOMPARE(cards[2].getEasyFactor(), 2.3f);
+
+    QCOMPARE(cards[3].getNextReview().toMSecsSinceEpoch(), creation + 20 * kDayMSecs);
+    QCOMPARE(cards[3].getEasyFactor(), SM2::kMinEasyFactor);
+
+    QCOMPARE(cards[4].getNextReview().toMSecsSinceEpoch(), creation + 12 * kDayMSecs);
+    QCOMPARE(cards[4].getEasyFactor(), SM2::kMaxEasyFactor);
+}
+
+void TestAnkiImporter::testFieldsAndContentTypes()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.anki21");
+    {
+        AnkiCollection collection(path);
+        collection.addNote(1, {"Hello<br>world &amp; co", "<div>Answer</div><div>two</div>", "extra"});
+        AnkiCard forward;
+        forward.id = 1;
+        forward.noteId = 1;
+        collection.addCard(forward);
+        AnkiCard reverse = forward;
+        reverse.id = 2;
+        reverse.ord = 1;
+        collection.addCard(reverse);
+
+        newCard(collection, 3, "Say [sound:hello.mp3]", "Привет");
+        newCard(collection, 4, "<img src=\"cat.jpg\" />", "Cat");
+        newCard(collection, 5, "&nbsp;", "skipped");
+    }
+
+    AnkiImporter importer;
+    bool ok = false;
+    const QList<Card> cards = importAll(importer, path, &ok);
+    QVERIFY2(ok, qPrintable(importer.lastError()));
+    QCOMPARE(cards.size(), 4);
+    QCOMPARE(importer.result().skipped, qint64(1));
+
+    QCOMPARE(cards[0].getQuestion(), QString("Hello\nworld & co"));
+    QCOMPARE(cards[0].getAnswer(), QString("Answer\ntwo"));
+    QCOMPARE(cards[0].getContentType(), ContentType::Text);
+
+    QCOMPARE(cards[1].getQuestion(), QString("Answer\ntwo"));
+    QCOMPARE(cards[1].getAnswer(), QString("Hello\nworld & co"));
+
+    QCOMPARE(cards[2].getQuestion(), QString("Say"));
+    QCOMPARE(cards[2].getAnswer(), QString("Привет"));
+    QCOMPARE(cards[2].getContentType(), ContentType::Audio);
+
+    QCOMPARE(cards[3].getQuestion(), QString());
+    QCOMPARE(cards[3].getAnswer(), QString("Cat"));
+    QCOMPARE(cards[3].getContentType(), ContentType::Image);
+}
+
+void TestAnkiImporter::testReviewLogSummary()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.anki2");
+    const qint64 base = 1700200000000LL;
+    {
+        AnkiCollection collection(path);
+        newCard(collection, 1, "streak", "a");
+        newCard(collection, 2, "lapsed", "a");
+        newCard(collection, 3, "rescheduled", "a");
+        collection.exec("UPDATE cards SET type = 2, queue = 2, due = 5, ivl = 3 WHERE id = 3");
+
+        // Записи вставлены не по порядку: импорт сортирует их сам
+        collection.addReview(1, base + 4000, 4);
+        collection.addReview(1, base + 1000, 3);
+        collection.addReview(1, base + 3000, 3);
+        collection.addReview(1, base + 2000, 1);
+        collection.addReview(1, base, 3);
+        collection.addReview(2, base + 10, 3);
+        collection.addReview(2, base + 20, 1);
+        collection.addReview(3, base + 30, 0);
+    }
+
+    AnkiImporter importer;
+    bool ok = false;
+    const QList<Card> cards = importAll(importer, path, &ok);
+    QVERIFY2(ok, qPrintable(importer.lastError()));
+    QCOMPARE(cards.size(), 3);
+    QCOMPARE(importer.result().reviewLogs, qint64(8));
+
+    QCOMPARE(cards[0].getRepetitions(), 2);
+    QCOMPARE(cards[0].getLastReview().toMSecsSinceEpoch(), base + 4000);
+
+    QCOMPARE(cards[1].getRepetitions(), 0);
+    QCOMPARE(cards[1].getLastReview().toMSecsSinceEpoch(), base + 20);
+
+    // Перенос без ответа не считается повторением
+    QVERIFY(!cards[2].getLastReview().isValid());
+    QCOMPARE(cards[2].getRepetitions(), 1);
+    QCOMPARE(cards[2].getIntervalDays(), 3);
+}
+
+void TestAnkiImporter::testDeckFilterAndSuspended()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.anki2");
+    {
+        AnkiCollection collection(path);
+        for (int i = 1; i <= 6; ++i) {
+            collection.addNote(i, {QString("Q%1").arg(i), "A"});
+            AnkiCard card;
+            card.id = i;
+            card.noteId = i;
+            card.deckId = i % 2 == 0 ? 2 : 1;
+            card.queue = i == 4 ? -1 : 0;
+            collection.addCard(card);
+            collection.addReview(i, 1700200000000LL + i, 3);
+        }
+    }
+
+    AnkiImporter::Options options;
+    options.sourceDeckId = 2;
+    AnkiImporter all(options);
+    QList<Card> cards = importAll(all, path);
+    QCOMPARE(cards.size(), 3);
+    QCOMPARE(cards[0].getQuestion(), QString("Q2"));
+    QCOMPARE(cards[1].getQuestion(), QString("Q4"));
+    QCOMPARE(all.result().reviewLogs, qint64(3));
+
+    options.includeSuspended = false;
+    AnkiImporter active(options);
+    qint64 lastTotal = 0;
+    active.setProgressCallback([&lastTotal](qint64, qint64 totalCards) { lastTotal = totalCards; });
+    cards = importAll(active, path);
+    QCOMPARE(cards.size(), 2);
+    QCOMPARE(cards[1].getQuestion(), QString("Q6"));
+    QCOMPARE(active.result().skipped, qint64(1));
+    QCOMPARE(lastTotal, qint64(3));
+}
+
+// ==================== SINKS ====================
+
+void TestAnkiImporter::testRepositoryImportWithMedia()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.anki2");
+    const QByteArray image("\x89PNG image bytes", 16);
+    const QByteArray sound("ID3 sound bytes");
+    writeMedia(dir.path(), {{"cat.jpg", image}, {"hello.mp3", sound}});
+    {
+        AnkiCollection collection(path);
+        newCard(collection, 1, "<img src='cat.jpg'>", "Кошка");
+        newCard(collection, 2, "[sound:hello.mp3]", "Привет");
+        newCard(collection, 3, "text", "only");
+    }
+
+    const QString connection = "anki_importer_repository";
+    {
+        QSqlDatabase database = Database::open(":memory:", connection);
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+        Deck deck;
+        deck.setId(3);
+        QVERIFY(repository.saveDeck(deck));
+
+        // Карточки другой колоды занимают первые идентификаторы
+        Deck other;
+        other.setId(2);
+        other.setCards({Card(1, "Один", "1", ContentType::Text, TestMode::DirectAnswer, 2.5f, 0, 0, QDateTime(), QDateTime(), 2),
+                        Card(2, "Два", "2", ContentType::Text, TestMode::DirectAnswer, 2.5f, 0, 0, QDateTime(), QDateTime(), 2)});
+        QVERIFY(repository.saveDeck(other));
+
+        AnkiImporter::Options options;
+        options.deckId = 3;
+        options.batchSize = 2;
+        AnkiImporter importer(options);
+        QVERIFY2(importer.importCollection(path, repository.cards()), qPrintable(importer.lastError()));
+        QCOMPARE(importer.result().mediaFiles, qint64(2));
+        QCOMPARE(importer.result().missingMedia, qint64(0));
+
+        const QList<Card> stored = repository.cards().loadDeckCards(3);
+        QCOMPARE(stored.size(), 3);
+        QCOMPARE(stored[0].getId(), 3);
+        QCOMPARE(stored[0].getContentType(), ContentType::Image);
+        QCOMPARE(repository.cards().loadDeckCards(2).size(), 2);
+        QCOMPARE(repository.cards().loadDeckCards(2)[0].getQuestion(), QString("Один"));
+
+        CardContent content;
+        QVERIFY(repository.cards().fetchContent(stored[0].getId(), content));
+        QCOMPARE(content.media, image);
+        QVERIFY(repository.cards().fetchContent(stored[1].getId(), content));
+        QCOMPARE(content.media, sound);
+        QVERIFY(repository.cards().fetchContent(stored[2].getId(), content));
+        QVERIFY(content.media.isEmpty());
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
+
+void TestAnkiImporter::testMissingMediaCounted()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.anki2");
+    {
+        AnkiCollection collection(path);
+        newCard(collection, 1, "<img src=\"dog.jpg\">", "Собака");
+    }
+
+    QHash<int, QByteArray> received;
+    AnkiImporter importer;
+    QList<Card> cards;
+    QVERIFY(importer.importCollection(path,
+        [&cards](QList<Card> &&batch) {
+            cards.append(std::move(batch));
+            return true;
+        },
+        [&received](const QHash<int, QByteArray> &media) {
+            received.insert(media);
+            return true;
+        }));
+    QCOMPARE(cards.size(), 1);
+    QCOMPARE(importer.result().missingMedia, qint64(1));
+    QVERIFY(received.isEmpty());
+}
+
+void TestAnkiImporter::testMissingCollectionFails()
+{
+    QTemporaryDir dir;
+    AnkiImporter importer;
+    bool ok = true;
+    importAll(importer, dir.filePath("absent.anki2"), &ok);
+    QVERIFY(!ok);
+    QVERIFY(!importer.lastError().isEmpty());
+
+    // Файл есть, но это не коллекция Anki
+    const QString path = dir.filePath("empty.anki2");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+    importAll(importer, path, &ok);
+    QVERIFY(!ok);
+    QVERIFY(!importer.lastError().isEmpty());
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestAnkiImporter::testImportThroughput()
+{
+    // Коллекция 100k карточек с тремя ответами на каждую -> файл базы данных
+    const int cardCount = qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH") ? 1000000 : 100000;
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.anki2");
+    {
+        AnkiCollection collection(path);
+        collection.begin();
+        QSqlQuery notes(collection.handle());
+        notes.prepare("INSERT INTO notes (id, flds) VALUES (?, ?)");
+        QSqlQuery cards(collection.handle());
+        cards.prepare("INSERT INTO cards VALUES (?, ?, 1, 0, 2, 2, ?, ?, 2500, 0, 0)");
+        QSqlQuery reviews(collection.handle());
+        reviews.prepare("INSERT INTO revlog (id, cid, ease) VALUES (?, ?, ?)");
+        for (int i = 1; i <= cardCount; ++i) {
+            notes.addBindValue(i);
+            notes.addBindValue(QString("Question <b>%1</b>\x1f" "Answer %2").arg(i).arg(i % 1000));
+            notes.exec();
+            cards.addBindValue(i);
+            cards.addBindValue(i);
+            cards.addBindValue(i % 365);
+            cards.addBindValue(i % 30);
+            cards.exec();
+            for (int r = 0; r < 3; ++r) {
+                reviews.addBindValue(1700000000000LL + qint64(i) * 3 + r);
+                reviews.addBindValue(i);
+                reviews.addBindValue(1 + (i + r) % 4);
+                reviews.exec();
+            }
+        }
+        collection.commit();
+    }
+
+    const QString connection = "anki_importer_bench";
+    {
+        QSqlDatabase database = Database::open(dir.filePath("cards.db"), connection);
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+        Deck deck;
+        deck.setId(1);
+        QVERIFY(repository.saveDeck(deck));
+
+        AnkiImporter::Options options;
+        options.deckId = 1;
+        AnkiImporter importer(options);
+        QVERIFY2(importer.importCollection(path, repository.cards()), qPrintable(importer.lastError()));
+        QCOMPARE(importer.result().imported, qint64(cardCount));
+        QCOMPARE(importer.result().reviewLogs, qint64(cardCount) * 3);
+
+        const qint64 elapsed = importer.result().elapsedMSecs;
+        qDebug() << "Anki cards:" << cardCount
+                 << "review logs:" << importer.result().reviewLogs
+                 << "time:" << elapsed << "ms,"
+                 << qRound64(cardCount / (qMax<qint64>(1, elapsed) / 1000.0)) << "cards/s";
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
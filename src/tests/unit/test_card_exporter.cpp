@@ -0,0 +1,332 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <algorithm>
+#include "TestCardExporter.h"
+#include "CardExporter.h"
+#include "CsvImporter.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/**
+ * @brief Колода со всеми вариантами полей и символами, требующими экранирования
+ */
+Deck makeDeck(int deckId, int count)
+{
+    return TestDecks::buildDeck(deckId, count, [deckId](int i) {
+        const int id = deckId * 1000000 + i;
+        const QDateTime next = i % 5 == 0 ? QDateTime() : kNow.addSecs(3600LL * (i % 48 - 24));
+        const QDateTime last = i % 7 == 0 ? QDateTime() : kNow.addDays(-(i % 30));
+        const QString question = i % 4 == 0 ? QString("Вопрос %1, \"кавычки\"\nи\tтаб \\").arg(id)
+                                            : QString("Вопрос №%1 ✓").arg(id);
+        return Card(id, question, i % 3 == 0 ? QString() : QString("Ответ %1").arg(i % 10),
+                    static_cast<ContentType>(i % 3), static_cast<TestMode>(i % 3),
+                    1.3f + 0.01f * (i % 150), i % 40, i % 9, next, last, deckId);
+    });
+}
+
+void compareCards(const QList<Card> &actual, const QList<Deck> &decks)
+{
+    int index = 0;
+    for (const Deck &deck : decks) {
+        for (const CardRef &e : deck.getCardsView()) {
+            QVERIFY(index < actual.size());
+            const Card &a = actual[index++];
+            QCOMPARE(a.getId(), e.getId());
+            QCOMPARE(a.getQuestion(), e.getQuestion());
+            QCOMPARE(a.getAnswer(), e.getAnswer());
+            QCOMPARE(a.getContentType(), e.getContentType());
+            QCOMPARE(a.getTestMode(), e.getTestMode());
+            QCOMPARE(a.getEasyFactor(), e.getEasyFactor());
+            QCOMPARE(a.getIntervalDays(), e.getIntervalDays());
+            QCOMPARE(a.getRepetitions(), e.getRepetitions());
+            QCOMPARE(a.getNextReview(), e.getNextReview());
+            QCOMPARE(a.getLastReview(), e.getLastReview());
+        }
+    }
+    QCOMPARE(index, actual.size());
+}
+
+QByteArray exportToBytes(CardExporter &exporter, const QList<Deck> &decks)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    if (!exporter.exportDecks(decks, buffer)) {
+        return QByteArray();
+    }
+    return buffer.data();
+}
+
+/**
+ * @brief Поле /proc/self/status в КиБ (только Linux); -1, если недоступно
+ */
+qint64 processMemoryKiB(const char *field)
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith(field)) {
+            return line.mid(qstrlen(field)).trimmed().split(' ').value(0).toLongLong();
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+// ==================== FORMATS ====================
+
+void TestCardExporter::testCsvRoundTripThroughImporter()
+{
+    const QList<Deck> decks = {makeDeck(1, 300), makeDeck(2, 200)};
+    CardExporter::Options options;
+    options.bufferBytes = 4096;
+    CardExporter exporter(options);
+    const QByteArray csv = exportToBytes(exporter, decks);
+    QVERIFY2(!csv.isEmpty(), qPrintable(exporter.lastError()));
+    QCOMPARE(exporter.result().cards, qint64(500));
+    QCOMPARE(exporter.result().bytesWritten, qint64(csv.size()));
+    QVERIFY(csv.startsWith("id,deck_id,question,answer,content_type,test_mode,"));
+
+    // Экспорт читается импортом CSV без потерь
+    CsvImporter importer;
+    QBuffer input;
+    input.setData(csv);
+    input.open(QIODevice::ReadOnly);
+    QList<Card> cards;
+    QVERIFY(importer.import(input, [&cards](QList<Card> &&batch) {
+        cards.append(std::move(batch));
+        return true;
+    }));
+    QCOMPARE(importer.result().malformed, qint64(0));
+    compareCards(cards, decks);
+}
+
+void TestCardExporter::testJsonLines()
+{
+    const Deck deck = makeDeck(3, 50);
+    CardExporter::Options options;
+    options.format = CardExporter::Format::JsonLines;
+    CardExporter exporter(options);
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(exporter.exportDeck(deck, buffer));
+
+    const QList<QByteArray> lines = buffer.data().split('\n');
+    QCOMPARE(lines.size(), 51);
+    QVERIFY(lines.last().isEmpty());
+
+    const CardSpan cards = deck.getCardsView();
+    for (int i = 0; i < 50; i++) {
+        QJsonParseError error;
+        const QJsonObject object = QJsonDocument::fromJson(lines[i], &error).object();
+        QCOMPARE(error.error, QJsonParseError::NoError);
+        QCOMPARE(object.value("id").toInt(), cards[i].getId());
+        QCOMPARE(object.value("deck_id").toInt(), 3);
+        QCOMPARE(object.value("question").toString(), cards[i].getQuestion());
+        QCOMPARE(object.value("answer").toString(), cards[i].getAnswer());
+        QCOMPARE(float(object.value("easy_factor").toDouble()), cards[i].getEasyFactor());
+        QCOMPARE(object.value("interval_days").toInt(), cards[i].getIntervalDays());
+        if (cards[i].getNextReview().isValid()) {
+            QCOMPARE(qint64(object.value("next_review").toDouble()), cards[i].getNextReviewMSecs());
+        } else {
+            QVERIFY(object.value("next_review").isNull());
+        }
+    }
+    QCOMPARE(QJsonDocument::fromJson(lines[1]).object().value("content_type").toString(), QString("image"));
+    QCOMPARE(QJsonDocument::fromJson(lines[2]).object().value("test_mode").toString(), QString("matching"));
+}
+
+void TestCardExporter::testBinaryRoundTrip()
+{
+    const QList<Deck> decks = {makeDeck(1, 1000), Deck(), makeDeck(2, 10)};
+    CardExporter::Options options;
+    options.format = CardExporter::Format::Binary;
+    options.bufferBytes = 4096;
+    CardExporter exporter(options);
+    const QByteArray bytes = exportToBytes(exporter, decks);
+    QVERIFY(bytes.startsWith("QCEX"));
+
+    QBuffer input;
+    input.setData(bytes);
+    input.open(QIODevice::ReadOnly);
+    QList<Card> cards;
+    QString error;
+    QVERIFY2(CardExporter::readBinary(input, cards, &error), qPrintable(error));
+    compareCards(cards, decks);
+    QCOMPARE(cards.last().getDeckId(), 2);
+
+    // Оборванный файл
+    QBuffer truncated;
+    truncated.setData(bytes.left(bytes.size() - 3));
+    truncated.open(QIODevice::ReadOnly);
+    cards.clear();
+    QVERIFY(!CardExporter::readBinary(truncated, cards, &error));
+    QVERIFY(!error.isEmpty());
+}
+
+void TestCardExporter::testDeflateCompression()
+{
+    const QList<Deck> decks = {makeDeck(1, 5000)};
+    CardExporter::Options options;
+    options.format = CardExporter::Format::JsonLines;
+    options.bufferBytes = 16 * 1024;
+    CardExporter plain(options);
+    const QByteArray expected = exportToBytes(plain, decks);
+
+    options.compression = CardExporter::Compression::Deflate;
+    CardExporter compressed(options);
+    const QByteArray bytes = exportToBytes(compressed, decks);
+    QVERIFY(bytes.startsWith("QCZ1"));
+    QCOMPARE(compressed.result().rawBytes, qint64(expected.size()));
+    QCOMPARE(compressed.result().bytesWritten, qint64(bytes.size()));
+    QVERIFY(bytes.size() < expected.size() / 3);
+
+    QBuffer input;
+    input.setData(bytes);
+    input.open(QIODevice::ReadOnly);
+    QBuffer output;
+    output.open(QIODevice::WriteOnly);
+    QString error;
+    QVERIFY2(CardExporter::decompress(input, output, &error), qPrintable(error));
+    QCOMPARE(output.data(), expected);
+
+    QBuffer foreign;
+    foreign.setData(expected);
+    foreign.open(QIODevice::ReadOnly);
+    QVERIFY(!CardExporter::decompress(foreign, output, &error));
+}
+
+// ==================== BACKGROUND ====================
+
+void TestCardExporter::testBackgroundExport()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("backup.qcex");
+    const QList<Deck> decks = {makeDeck(1, 20000), makeDeck(2, 5000)};
+
+    CardExporter::Options options;
+    options.format = CardExporter::Format::Binary;
+    options.compression = CardExporter::Compression::Deflate;
+    options.bufferBytes = 64 * 1024;
+    CardExporter exporter(options);
+    // Обработчик вызывается в фоновом потоке; проверки - после wait()
+    QList<qint64> progress;
+    qint64 reportedTotal = 0;
+    exporter.setProgressCallback([&progress, &reportedTotal](qint64 cardsWritten, qint64 totalCards) {
+        progress.append(cardsWritten);
+        reportedTotal = totalCards;
+    });
+    QVERIFY(exporter.start(decks, path));
+    QVERIFY(!exporter.start(decks, path));
+    QVERIFY2(exporter.wait(), qPrintable(exporter.lastError()));
+    QVERIFY(!exporter.isRunning());
+
+    QCOMPARE(reportedTotal, qint64(25000));
+    QVERIFY(progress.size() > 1);
+    QVERIFY(std::is_sorted(progress.begin(), progress.end()));
+    QCOMPARE(progress.last(), qint64(25000));
+    QCOMPARE(QFile(path).size(), exporter.result().bytesWritten);
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QBuffer unpacked;
+    unpacked.open(QIODevice::ReadWrite);
+    QVERIFY(CardExporter::decompress(file, unpacked));
+    unpacked.seek(0);
+    QList<Card> cards;
+    QVERIFY(CardExporter::readBinary(unpacked, cards));
+    compareCards(cards, decks);
+}
+
+void TestCardExporter::testCancelKeepsPreviousFile()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("backup.csv");
+    {
+        QFile previous(path);
+        QVERIFY(previous.open(QIODevice::WriteOnly));
+        previous.write("previous backup");
+    }
+
+    const QList<Deck> decks = {makeDeck(1, 100000)};
+    CardExporter::Options options;
+    options.bufferBytes = 4096;
+    CardExporter exporter(options);
+    exporter.setProgressCallback([&exporter](qint64, qint64) { exporter.cancel(); });
+    QVERIFY(exporter.start(decks, path));
+    QVERIFY(!exporter.wait());
+    QVERIFY(exporter.result().canceled);
+    QVERIFY(exporter.result().cards < 100000);
+    QVERIFY(!exporter.lastError().isEmpty());
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArray("previous backup"));
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestCardExporter::testExportThroughput_data()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("200k") << 200000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestCardExporter::testExportThroughput()
+{
+    // Экспорт в файл во всех форматах: скорость и рост памяти процесса
+    QFETCH(int, cardCount);
+    if (cardCount > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    QTemporaryDir dir;
+    const QList<Deck> decks = {makeDeck(1, cardCount)};
+
+    const struct {
+        const char *name;
+        CardExporter::Format format;
+        CardExporter::Compression compression;
+    } variants[] = {
+        {"csv", CardExporter::Format::Csv, CardExporter::Compression::None},
+        {"jsonl", CardExporter::Format::JsonLines, CardExporter::Compression::None},
+        {"binary", CardExporter::Format::Binary, CardExporter::Compression::None},
+        {"csv+deflate", CardExporter::Format::Csv, CardExporter::Compression::Deflate},
+        {"binary+deflate", CardExporter::Format::Binary, CardExporter::Compression::Deflate},
+    };
+
+    for (const auto &variant : variants) {
+        CardExporter::Options options;
+        options.format = variant.format;
+        options.compression = variant.compression;
+        CardExporter exporter(options);
+
+        const qint64 rssBefore = processMemoryKiB("VmRSS:");
+        QVERIFY2(exporter.exportFile(decks, dir.filePath(variant.name)), qPrintable(exporter.lastError()));
+        const qint64 rssAfter = processMemoryKiB("VmRSS:");
+
+        const CardExporter::Result &result = exporter.result();
+        QCOMPARE(result.cards, qint64(cardCount));
+        // Буферы экспорта не растут с размером колоды
+        QVERIFY(result.peakBufferBytes < 4 * options.bufferBytes);
+
+        qDebug() << "Cards:" << cardCount << variant.name
+                 << "time:" << result.elapsedMSecs << "ms,"
+                 << result.megabytesPerSecond() << "MB/s,"
+                 << "file:" << result.bytesWritten / 1024 << "KiB,"
+                 << "buffers:" << result.peakBufferBytes / 1024 << "KiB,"
+                 << "RSS delta:" << (rssBefore >= 0 ? rssAfter - rssBefore : -1) << "KiB,"
+                 << "peak RSS:" << processMemoryKiB("VmHWM:") << "KiB";
+    }
+}
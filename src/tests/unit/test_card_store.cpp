@@ -0,0 +1,287 @@
+#include <QtTest>
+#include "TestCardStore.h"
+#include "CardStore.h"
+#include "SM2.h"
+
+namespace {
+
+Card makeCard(int id, const QDateTime &nextReview, const QDateTime &lastReview)
+{
+    return Card(id, QString("Вопрос %1").arg(id), QString("Ответ %1").arg(id),
+                ContentType::Image, TestMode::Matching,
+                2.1f, 7, 3, nextReview, lastReview, 42);
+}
+
+} // namespace
+
+// ==================== ROWS & COLUMNS ====================
+
+void TestCardStore::testEmptyStore()
+{
+    CardStore store;
+    QVERIFY(store.isEmpty());
+    QCOMPARE(store.size(), 0);
+    QVERIFY(store.nextReviewColumn().isEmpty());
+}
+
+void TestCardStore::testAppendAndReadBack()
+{
+    CardStore store;
+    QDateTime next = QDateTime::currentDateTime().addDays(3);
+    QDateTime last = QDateTime::currentDateTime().addDays(-4);
+
+    const Card original = makeCard(7, next, last);
+    QCOMPARE(store.append(original), 0);
+    QCOMPARE(store.size(), 1);
+
+    Card restored = store.card(0);
+    QCOMPARE(restored.getId(), 7);
+    QCOMPARE(restored.getQuestion(), QString("Вопрос 7"));
+    QCOMPARE(restored.getAnswer(), QString("Ответ 7"));
+    QCOMPARE(restored.getContentType(), ContentType::Image);
+    QCOMPARE(restored.getTestMode(), TestMode::Matching);
+    QCOMPARE(restored.getEasyFactor(), 2.1f);
+    QCOMPARE(restored.getIntervalDays(), 7);
+    QCOMPARE(restored.getRepetitions(), 3);
+    QCOMPARE(restored.getNextReview(), next);
+    QCOMPARE(restored.getLastReview(), last);
+    QCOMPARE(restored.getDeckId(), 42);
+
+    // Столбец дат хранит миллисекунды от эпохи
+    QCOMPARE(store.nextReviewColumn().size(), 1);
+    QCOMPARE(store.nextReviewColumn()[0], next.toMSecsSinceEpoch());
+}
+
+void TestCardStore::testAppendMove()
+{
+    CardStore store;
+    Card card = makeCard(1, QDateTime(), QDateTime());
+
+    QCOMPARE(store.append(std::move(card)), 0);
+    QCOMPARE(store.question(0), QString("Вопрос 1"));
+    QCOMPARE(store.answer(0), QString("Ответ 1"));
+    QCOMPARE(store.id(0), 1);
+}
+
+void TestCardStore::testInvalidDatesRoundTrip()
+{
+    CardStore store;
+    store.append(makeCard(1, QDateTime(), QDateTime()));
+
+    QCOMPARE(store.nextReviewMSecs(0), CardStore::kNoDate);
+    QCOMPARE(store.lastReviewMSecs(0), CardStore::kNoDate);
+    QVERIFY(!store.card(0).getNextReview().isValid());
+    QVERIFY(!store.card(0).getLastReview().isValid());
+
+    QCOMPARE(CardStore::toEpochMSecs(QDateTime()), CardStore::kNoDate);
+    QVERIFY(!CardStore::fromEpochMSecs(CardStore::kNoDate).isValid());
+}
+
+void TestCardStore::testRemoveAt()
+{
+    CardStore store;
+    QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < 5; i++) {
+        store.append(makeCard(i, now.addDays(i), now));
+    }
+
+    store.removeAt(1);
+    QCOMPARE(store.size(), 4);
+    QCOMPARE(store.id(0), 0);
+    QCOMPARE(store.id(1), 2);
+    QCOMPARE(store.question(1), QString("Вопрос 2"));
+    QCOMPARE(store.nextReviewMSecs(1), now.addDays(2).toMSecsSinceEpoch());
+
+    store.clear();
+    QVERIFY(store.isEmpty());
+}
+
+void TestCardStore::testSetCard()
+{
+    CardStore store;
+    QDateTime now = QDateTime::currentDateTime();
+    store.append(makeCard(1, now, now));
+
+    Card replacement(9, "Новый", "Текст", ContentType::Audio, TestMode::DirectAnswer,
+                     1.5f, 2, 0, now.addDays(5), QDateTime(), 3);
+    store.setCard(0, replacement);
+
+    QCOMPARE(store.id(0), 9);
+    QCOMPARE(store.question(0), QString("Новый"));
+    QCOMPARE(store.contentType(0), ContentType::Audio);
+    QCOMPARE(store.easyFactor(0), 1.5f);
+    QCOMPARE(store.nextReviewMSecs(0), now.addDays(5).toMSecsSinceEpoch());
+    QCOMPARE(store.lastReviewMSecs(0), CardStore::kNoDate);
+    QCOMPARE(store.deckId(0), 3);
+}
+
+void TestCardStore::testCardRefGetters()
+{
+    CardStore store;
+    QDateTime next = QDateTime::currentDateTime().addDays(1);
+    QDateTime last = QDateTime::currentDateTime();
+    store.append(makeCard(1, QDateTime(), QDateTime()));
+    store.append(makeCard(2, next, last));
+
+    CardRef ref = store.ref(1);
+    QCOMPARE(ref.row(), 1);
+    QCOMPARE(ref.getId(), 2);
+    QCOMPARE(ref.getQuestion(), QString("Вопрос 2"));
+    QCOMPARE(ref.getAnswer(), QString("Ответ 2"));
+    QCOMPARE(ref.getContentType(), ContentType::Image);
+    QCOMPARE(ref.getTestMode(), TestMode::Matching);
+    QCOMPARE(ref.getEasyFactor(), 2.1f);
+    QCOMPARE(ref.getIntervalDays(), 7);
+    QCOMPARE(ref.getRepetitions(), 3);
+    QCOMPARE(ref.getNextReview(), next);
+    QCOMPARE(ref.getLastReview(), last);
+    QCOMPARE(ref.getNextReviewMSecs(), next.toMSecsSinceEpoch());
+    QCOMPARE(ref.getDeckId(), 42);
+    QCOMPARE(ref.toCard().getId(), 2);
+}
+
+// ==================== SCHEDULING ====================
+
+void TestCardStore::testUpdateSM2MatchesCard()
+{
+    Card card(1, "Q", "A", ContentType::Text, TestMode::DirectAnswer,
+              2.5f, 0, 0, QDateTime(), QDateTime(), 1);
+    CardStore store;
+    store.append(card);
+
+    const QList<int> grades = {4, 5, 3, 1, 4, 5, 5, 0, 2, 4};
+    for (int grade : grades) {
+        card.updateSM2(grade);
+        store.updateSM2(0, grade, card.getLastReview());
+
+        QCOMPARE(store.easyFactor(0), card.getEasyFactor());
+        QCOMPARE(store.intervalDays(0), card.getIntervalDays());
+        QCOMPARE(store.repetitions(0), card.getRepetitions());
+        QCOMPARE(store.lastReviewMSecs(0), card.getLastReview().toMSecsSinceEpoch());
+        QCOMPARE(store.nextReviewMSecs(0), card.getNextReview().toMSecsSinceEpoch());
+    }
+}
+
+void TestCardStore::testApplyBatchMatchesApply()
+{
+    // Все сочетания оценки (включая вне диапазона) и состояния
+    QList<float> easyFactors;
+    QList<int> intervals;
+    QList<int> repetitions;
+    QList<int> grades;
+    for (int grade = -1; grade <= 6; grade++) {
+        for (float ef : {1.3f, 1.45f, 2.0f, 2.36f, 2.5f}) {
+            for (int reps : {0, 1, 2, 7}) {
+                easyFactors.append(ef);
+                intervals.append(reps * 3 + 1);
+                repetitions.append(reps);
+                grades.append(grade);
+            }
+        }
+    }
+
+    QList<float> expectedEasyFactors = easyFactors;
+    QList<int> expectedIntervals = intervals;
+    QList<int> expectedRepetitions = repetitions;
+    for (int i = 0; i < grades.size(); i++) {
+        SM2::apply(expectedEasyFactors[i], expectedIntervals[i], expectedRepetitions[i], grades[i]);
+    }
+
+    SM2::applyBatch(easyFactors.data(), intervals.data(), repetitions.data(),
+                    grades.constData(), grades.size());
+
+    QCOMPARE(easyFactors, expectedEasyFactors);
+    QCOMPARE(intervals, expectedIntervals);
+    QCOMPARE(repetitions, expectedRepetitions);
+}
+
+void TestCardStore::testApplyGradesMatchesUpdateSM2()
+{
+    CardStore batched;
+    for (int i = 0; i < 20; i++) {
+        batched.append(Card(i, "Q", "A", ContentType::Text, TestMode::DirectAnswer,
+                            1.3f + 0.06f * i, i % 4 + 1, i % 3, QDateTime(), QDateTime(), 1));
+    }
+    CardStore sequential = batched;
+
+    // Повторы строк 3 и 7 проверяют деление пакета на сегменты
+    const QList<int> rows =   {3, 0, 7, 3, 19, 7, 7, 5, 3, 12, 0};
+    const QList<int> grades = {5, 2, 4, 4, 7,  0, 5, 3, -1, 4, 5};
+    const QDateTime now = QDateTime::currentDateTime();
+
+    batched.applyGrades(rows.constData(), grades.constData(), rows.size(), now);
+    for (int i = 0; i < rows.size(); i++) {
+        sequential.updateSM2(rows[i], grades[i], now);
+    }
+
+    for (int row = 0; row < batched.size(); row++) {
+        QCOMPARE(batched.easyFactor(row), sequential.easyFactor(row));
+        QCOMPARE(batched.intervalDays(row), sequential.intervalDays(row));
+        QCOMPARE(batched.repetitions(row), sequential.repetitions(row));
+        QCOMPARE(batched.lastReviewMSecs(row), sequential.lastReviewMSecs(row));
+        QCOMPARE(batched.nextReviewMSecs(row), sequential.nextReviewMSecs(row));
+    }
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestCardStore::testDueScanPerformance_data()
+{
+    QTest::addColumn<int>("cardCount");
+    QTest::addColumn<bool>("columnar");
+
+    QTest::newRow("QList<Card> 100k") << 100000 << false;
+    QTest::newRow("CardStore 100k") << 100000 << true;
+    QTest::newRow("QList<Card> 1M") << 1000000 << false;
+    QTest::newRow("CardStore 1M") << 1000000 << true;
+}
+
+void TestCardStore::testDueScanPerformance()
+{
+    // Полный проход по датам повторения: по объектам Card и по столбцу хранилища
+    QFETCH(int, cardCount);
+    QFETCH(bool, columnar);
+    if (cardCount > 100000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    QList<Card> cards;
+    cards.reserve(cardCount);
+    CardStore store;
+    store.reserve(cardCount);
+    for (int i = 0; i < cardCount; i++) {
+        Card card(i, QString("Scan Q%1").arg(i), QString("Scan A%1").arg(i),
+                  ContentType::Text, TestMode::DirectAnswer, 2.0f, 1, 0,
+                  (i % 5 == 0) ? now.addDays(-1) : now.addDays(1), now, 1);
+        if (columnar) {
+            store.append(std::move(card));
+        } else {
+            cards.append(std::move(card));
+        }
+    }
+
+    int due = 0;
+    if (columnar) {
+        const qint64 nowMSecs = now.toMSecsSinceEpoch();
+        const QList<qint64> &column = store.nextReviewColumn();
+        QBENCHMARK {
+            due = 0;
+            for (qint64 nextReview : column) {
+                due += nextReview <= nowMSecs ? 1 : 0;
+            }
+        }
+    } else {
+        QBENCHMARK {
+            due = 0;
+            for (const Card &card : cards) {
+                QDateTime nextReview = card.getNextReview();
+                if (!nextReview.isValid() || nextReview <= now) {
+                    due++;
+                }
+            }
+        }
+    }
+
+    QCOMPARE(due, (cardCount + 4) / 5);
+}
@@ -0,0 +1,466 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <algorithm>
+#include <limits>
+#include "TestCardTableModel.h"
+#include "CardContentCache.h"
+#include "CardTableModel.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/**
+ * @brief Колода с повторяющимися значениями во всех столбцах
+ *
+ * Вопросы различаются регистром, чтобы проверить сравнение без учета
+ * регистра; у каждой девятой карточки нет даты следующего повторения.
+ */
+Deck makeDeck(int count, const Clock *clock)
+{
+    return TestDecks::buildDeck(1, count, [count](int i) {
+        const qint64 minutes = (qint64(i) * 7919) % (60 * 24 * 60) - 7 * 24 * 60;
+        const QDateTime next = i % 9 == 0 ? QDateTime() : kNow.addSecs(minutes * 60);
+        const QDateTime last = i % 4 == 0 ? QDateTime() : kNow.addDays(-(i % 30));
+        const QString question = (i % 2 ? QString("вопрос %1") : QString("ВОПРОС %1")).arg(i % 500);
+        return Card((i * 7) % count + 1, question, QString("Ответ %1").arg(i),
+                    ContentType::Text, TestMode::DirectAnswer,
+                    1.3f + float(i % 13) * 0.1f, i % 37, i % 5, next, last, 1);
+    }, clock);
+}
+
+/**
+ * @brief Источник текста из полной копии колоды
+ *
+ * Чтение колоды целиком (forEachText) включается полем bulk.
+ */
+class DeckSource : public CardContentSource
+{
+public:
+    explicit DeckSource(const Deck &deck) : deck(deck) {}
+
+    bool fetchContent(int cardId, CardContent &content) override
+    {
+        ++fetches;
+        const int row = deck.indexOf(cardId);
+        if (row < 0) {
+            return false;
+        }
+        content = deck.getContent(cardId);
+        return true;
+    }
+
+    bool forEachText(int deckId, const TextVisitor &visit) override
+    {
+        if (!bulk || deckId != deck.getId()) {
+            return false;
+        }
+        ++bulkReads;
+        for (const CardRef card : deck.getCardsView()) {
+            visit(card.getId(), card.getQuestion(), card.getAnswer());
+        }
+        return true;
+    }
+
+    bool bulk = false;
+    int fetches = 0;
+    int bulkReads = 0;
+
+private:
+    const Deck &deck;
+};
+
+void fetchAll(CardTableModel &model)
+{
+    while (model.canFetchMore(QModelIndex())) {
+        model.fetchMore(QModelIndex());
+    }
+}
+
+QList<int> modelRows(const CardTableModel &model)
+{
+    QList<int> rows;
+    for (int row = 0; row < model.rowCount(); row++) {
+        rows.append(model.deckRow(row));
+    }
+    return rows;
+}
+
+/**
+ * @brief Ожидаемый порядок строк колоды перебором по CardRef
+ */
+QList<int> expectedOrder(const Deck &deck, int column, Qt::SortOrder order)
+{
+    const CardSpan cards = deck.getCardsView();
+    QList<int> rows;
+    for (int row = 0; row < cards.size(); row++) {
+        rows.append(row);
+    }
+    auto compare = [&cards, column](int a, int b) -> int {
+        const CardRef &left = cards[a];
+        const CardRef &right = cards[b];
+        auto sign = [](auto x, auto y) { return x < y ? -1 : (y < x ? 1 : 0); };
+        switch (column) {
+        case CardTableModel::Id:
+            return sign(left.getId(), right.getId());
+        case CardTableModel::Question:
+            return QString::compare(left.getQuestion(), right.getQuestion(), Qt::CaseInsensitive);
+        case CardTableModel::Answer:
+            return QString::compare(left.getAnswer(), right.getAnswer(), Qt::CaseInsensitive);
+        case CardTableModel::EasyFactor:
+            return sign(left.getEasyFactor(), right.getEasyFactor());
+        case CardTableModel::Interval:
+            return sign(left.getIntervalDays(), right.getIntervalDays());
+        case CardTableModel::Repetitions:
+            return sign(left.getRepetitions(), right.getRepetitions());
+        case CardTableModel::NextReview:
+            return sign(left.getNextReviewMSecs(), right.getNextReviewMSecs());
+        default:
+            return sign(left.getLastReviewMSecs(), right.getLastReviewMSecs());
+        }
+    };
+    std::stable_sort(rows.begin(), rows.end(), [&compare, order](int a, int b) {
+        const int result = compare(a, b);
+        return order == Qt::AscendingOrder ? result < 0 : result > 0;
+    });
+    return rows;
+}
+
+} // namespace
+
+// ==================== DATA ====================
+
+void TestCardTableModel::testDataAndHeaders()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeDeck(2500, &clock);
+    CardTableModel model;
+    QCOMPARE(model.rowCount(), 0);
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+
+    model.setDeck(&deck);
+    QCOMPARE(model.deck(), &deck);
+    QCOMPARE(model.columnCount(), int(CardTableModel::ColumnCount));
+    QCOMPARE(model.rowCount(), CardTableModel::kDefaultFetchBatch);
+    QCOMPARE(model.totalRowCount(), 2500);
+
+    const CardRef card = deck.getCardsView()[10];
+    QCOMPARE(model.index(10, CardTableModel::Id).data().toInt(), card.getId());
+    QCOMPARE(model.index(10, CardTableModel::Question).data().toString(), card.getQuestion());
+    QCOMPARE(model.index(10, CardTableModel::Answer).data().toString(), card.getAnswer());
+    QCOMPARE(model.index(10, CardTableModel::EasyFactor).data().toFloat(), card.getEasyFactor());
+    QCOMPARE(model.index(10, CardTableModel::Interval).data().toInt(), card.getIntervalDays());
+    QCOMPARE(model.index(10, CardTableModel::Repetitions).data().toInt(), card.getRepetitions());
+    QCOMPARE(model.index(10, CardTableModel::NextReview).data().toDateTime(), card.getNextReview());
+    QCOMPARE(model.index(10, CardTableModel::LastReview).data().toDateTime(), card.getLastReview());
+
+    // Пустая дата - пустая ячейка; за загруженной частью данных нет
+    QVERIFY(!model.index(0, CardTableModel::NextReview).data().isValid());
+    QVERIFY(!model.index(1500, CardTableModel::Id).isValid());
+    QVERIFY(!model.index(10, CardTableModel::Id).data(Qt::DecorationRole).isValid());
+
+    QCOMPARE(model.headerData(CardTableModel::Question, Qt::Horizontal).toString(), QString("Вопрос"));
+    QCOMPARE(model.headerData(4, Qt::Vertical).toInt(), 5);
+    QVERIFY(!model.headerData(CardTableModel::ColumnCount, Qt::Horizontal).isValid());
+}
+
+void TestCardTableModel::testLazyFetch()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeDeck(2500, &clock);
+    CardTableModel model;
+    model.setFetchBatchSize(0);
+    QCOMPARE(model.fetchBatchSize(), 1);
+    model.setFetchBatchSize(1000);
+    model.setDeck(&deck);
+
+    QSignalSpy inserted(&model, &CardTableModel::rowsInserted);
+    QVERIFY(model.canFetchMore(QModelIndex()));
+    model.fetchMore(QModelIndex());
+    QCOMPARE(model.rowCount(), 2000);
+    model.fetchMore(QModelIndex());
+    QCOMPARE(model.rowCount(), 2500);
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+    model.fetchMore(QModelIndex());
+
+    QCOMPARE(inserted.count(), 2);
+    QCOMPARE(inserted.at(1).at(1).toInt(), 2000);
+    QCOMPARE(inserted.at(1).at(2).toInt(), 2499);
+
+    // Строки верхнего уровня не имеют дочерних
+    const QModelIndex parent = model.index(0, 0);
+    QCOMPARE(model.rowCount(parent), 0);
+    QVERIFY(!model.canFetchMore(parent));
+}
+
+void TestCardTableModel::testReload()
+{
+    FixedClock clock(kNow);
+    Deck deck = makeDeck(100, &clock);
+    CardTableModel model;
+    model.setDeck(&deck);
+    model.sort(CardTableModel::Interval, Qt::DescendingOrder);
+
+    deck.addCard(Card(1000, "Новый вопрос", "Новый ответ", ContentType::Text, TestMode::DirectAnswer,
+                      2.5f, 99, 1, kNow, kNow, 1));
+    QSignalSpy reset(&model, &CardTableModel::modelReset);
+    model.reload();
+    QCOMPARE(reset.count(), 1);
+    QCOMPARE(model.totalRowCount(), 101);
+
+    // Сортировка сохраняется: новая карточка с наибольшим интервалом - первая
+    QCOMPARE(model.index(0, CardTableModel::Id).data().toInt(), 1000);
+
+    model.setDeck(nullptr);
+    QCOMPARE(model.rowCount(), 0);
+    QVERIFY(!model.index(0, 0).data().isValid());
+}
+
+// ==================== SORT AND FILTER ====================
+
+void TestCardTableModel::testSort_data()
+{
+    QTest::addColumn<int>("column");
+    QTest::addColumn<int>("order");
+
+    const char *names[] = {"id", "question", "answer", "ease", "interval", "repetitions", "next", "last"};
+    for (int column = 0; column < CardTableModel::ColumnCount; column++) {
+        QTest::newRow((QByteArray(names[column]) + " asc").constData()) << column << int(Qt::AscendingOrder);
+        QTest::newRow((QByteArray(names[column]) + " desc").constData()) << column << int(Qt::DescendingOrder);
+    }
+}
+
+void TestCardTableModel::testSort()
+{
+    QFETCH(int, column);
+    QFETCH(int, order);
+
+    FixedClock clock(kNow);
+    const Deck deck = makeDeck(3000, &clock);
+    CardTableModel model;
+    model.setDeck(&deck);
+
+    QSignalSpy layout(&model, &CardTableModel::layoutChanged);
+    model.sort(column, Qt::SortOrder(order));
+    QCOMPARE(layout.count(), 1);
+    QCOMPARE(model.rowCount(), CardTableModel::kDefaultFetchBatch);
+
+    fetchAll(model);
+    QCOMPARE(modelRows(model), expectedOrder(deck, column, Qt::SortOrder(order)));
+
+    // -1 возвращает порядок колоды
+    model.sort(-1);
+    QCOMPARE(model.deckRow(0), 0);
+    QCOMPARE(model.deckRow(2999), 2999);
+}
+
+void TestCardTableModel::testFilters()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeDeck(3000, &clock);
+    const CardSpan cards = deck.getCardsView();
+    CardTableModel model;
+    model.setFetchBatchSize(100000);
+    model.setDeck(&deck);
+
+    // Подстрока в вопросе или ответе, без учета регистра
+    model.setFilterText("ВОПРОС 42");
+    QList<int> expected;
+    for (int row = 0; row < cards.size(); row++) {
+        if (cards[row].getQuestion().contains("вопрос 42", Qt::CaseInsensitive)) {
+            expected.append(row);
+        }
+    }
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(modelRows(model), expected);
+
+    model.setFilterText("Ответ 12", CardTableModel::Answer);
+    expected.clear();
+    for (int row = 0; row < cards.size(); row++) {
+        if (cards[row].getAnswer().contains("Ответ 12")) {
+            expected.append(row);
+        }
+    }
+    QCOMPARE(modelRows(model), expected);
+
+    model.setFilterText("Ответ 12", CardTableModel::Question);
+    QCOMPARE(model.totalRowCount(), 0);
+
+    // Готовые к повторению, отсортированные по сроку
+    model.setFilterText(QString());
+    model.setDueOnly(true);
+    QCOMPARE(model.totalRowCount(), deck.getDueCount());
+    model.sort(CardTableModel::NextReview, Qt::DescendingOrder);
+    expected.clear();
+    for (int row : expectedOrder(deck, CardTableModel::NextReview, Qt::DescendingOrder)) {
+        if (cards[row].getNextReviewMSecs() <= kNow.toMSecsSinceEpoch()) {
+            expected.append(row);
+        }
+    }
+    QCOMPARE(modelRows(model), expected);
+
+    // Снятие фильтров сохраняет сортировку
+    model.setDueOnly(false);
+    QCOMPARE(modelRows(model), expectedOrder(deck, CardTableModel::NextReview, Qt::DescendingOrder));
+}
+
+void TestCardTableModel::testPersistentIndexFollowsSort()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeDeck(3000, &clock);
+    CardTableModel model;
+    model.setFetchBatchSize(3000);
+    model.setDeck(&deck);
+
+    const QPersistentModelIndex current(model.index(123, CardTableModel::Question));
+    const int cardId = model.index(123, CardTableModel::Id).data().toInt();
+
+    model.sort(CardTableModel::Interval, Qt::DescendingOrder);
+    QVERIFY(current.isValid());
+    QVERIFY(current.row() != 123);
+    QCOMPARE(current.column(), int(CardTableModel::Question));
+    QCOMPARE(model.index(current.row(), CardTableModel::Id).data().toInt(), cardId);
+
+    model.sort(-1);
+    QCOMPARE(current.row(), 123);
+}
+
+void TestCardTableModel::testMetadataOnlyDeck()
+{
+    FixedClock clock(kNow);
+    const Deck full = makeDeck(1500, &clock);
+    DeckSource source(full);
+    CardContentCache cache(&source);
+    Deck lazy = full;
+    lazy.setMetadataOnly(true);
+    lazy.setContentCache(&cache);
+
+    CardTableModel fullModel;
+    CardTableModel lazyModel;
+    fullModel.setFetchBatchSize(100000);
+    lazyModel.setFetchBatchSize(100000);
+    fullModel.setDeck(&full);
+    lazyModel.setDeck(&lazy);
+    QCOMPARE(lazyModel.index(7, CardTableModel::Question).data().toString(),
+             fullModel.index(7, CardTableModel::Question).data().toString());
+
+    // Фильтр и сортировка по тексту берут его из источника, а не из пустых
+    // столбцов: по карточке, а если источник умеет - одним проходом по колоде
+    for (bool bulk : {false, true}) {
+        source.bulk = bulk;
+        cache.clear();
+        const int fetches = source.fetches;
+        fullModel.sort(-1);
+        lazyModel.sort(-1);
+
+        for (int column : {-1, int(CardTableModel::Question), int(CardTableModel::Answer)}) {
+            fullModel.setFilterText("вопрос 4", column);
+            lazyModel.setFilterText("вопрос 4", column);
+            QCOMPARE(modelRows(lazyModel), modelRows(fullModel));
+        }
+        QVERIFY(lazyModel.totalRowCount() > 0);
+
+        fullModel.setFilterText(QString());
+        lazyModel.setFilterText(QString());
+        for (int column : {int(CardTableModel::Question), int(CardTableModel::Answer)}) {
+            for (Qt::SortOrder order : {Qt::AscendingOrder, Qt::DescendingOrder}) {
+                fullModel.sort(column, order);
+                lazyModel.sort(column, order);
+                QCOMPARE(modelRows(lazyModel), modelRows(fullModel));
+            }
+        }
+
+        if (bulk) {
+            QCOMPARE(source.fetches, fetches);
+            QCOMPARE(source.bulkReads, 7);
+            QCOMPARE(cache.totalCost(), qsizetype(0));
+        } else {
+            QVERIFY(source.fetches > fetches);
+        }
+    }
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestCardTableModel::testBrowseSpeed_data()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("200k") << 200000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestCardTableModel::testBrowseSpeed()
+{
+    // Кадр прокрутки: 40 видимых строк по 8 столбцов при 60 кадрах в секунду
+    constexpr int kVisibleRows = 40;
+    constexpr int kFrames = 2000;
+    constexpr qint64 kFrameNSecs = 16 * 1000000LL;
+
+    QFETCH(int, cardCount);
+    if (cardCount > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    FixedClock clock(kNow);
+    const Deck deck = makeDeck(cardCount, &clock);
+    CardTableModel model;
+    QElapsedTimer timer;
+
+    timer.start();
+    model.setDeck(&deck);
+    const qint64 resetNSecs = timer.nsecsElapsed();
+
+    timer.start();
+    model.sort(CardTableModel::NextReview);
+    const qint64 dueSortNSecs = timer.nsecsElapsed();
+
+    timer.start();
+    model.sort(CardTableModel::Interval, Qt::DescendingOrder);
+    const qint64 intervalSortNSecs = timer.nsecsElapsed();
+
+    timer.start();
+    model.sort(CardTableModel::Question);
+    const qint64 textSortNSecs = timer.nsecsElapsed();
+
+    // Прокрутка к концу порциями, как это делает представление
+    timer.start();
+    fetchAll(model);
+    const qint64 fetchNSecs = timer.nsecsElapsed();
+    QCOMPARE(model.rowCount(), cardCount);
+
+    // Окна прокрутки в случайных местах таблицы
+    qint64 worstFrame = 0;
+    qint64 totalFrames = 0;
+    qint64 checksum = 0;
+    for (int frame = 0; frame < kFrames; frame++) {
+        const int first = int((qint64(frame) * 104729) % (cardCount - kVisibleRows));
+        timer.start();
+        for (int row = first; row < first + kVisibleRows; row++) {
+            for (int column = 0; column < CardTableModel::ColumnCount; column++) {
+                const QVariant value = model.data(model.index(row, column));
+                checksum += value.isValid() ? 1 : 0;
+            }
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+        worstFrame = std::max(worstFrame, elapsed);
+        totalFrames += elapsed;
+    }
+    QVERIFY(checksum > 0);
+
+    qDebug() << "Cards:" << cardCount
+             << "reset:" << resetNSecs / 1000000.0 << "ms,"
+             << "sort by due:" << dueSortNSecs / 1000000.0 << "ms,"
+             << "by interval:" << intervalSortNSecs / 1000000.0 << "ms,"
+             << "by question:" << textSortNSecs / 1000000.0 << "ms,"
+             << "fetch all:" << fetchNSecs / 1000000.0 << "ms,"
+             << "frame avg:" << totalFrames / kFrames / 1000.0 << "us,"
+             << "worst:" << worstFrame / 1000.0 << "us";
+
+    QVERIFY(resetNSecs < kFrameNSecs);
+    QVERIFY(worstFrame < kFrameNSecs);
+    QVERIFY(dueSortNSecs < 1000 * 1000000LL);
+    QVERIFY(intervalSortNSecs < 1000 * 1000000LL);
+}
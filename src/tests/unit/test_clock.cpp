@@ -0,0 +1,219 @@
+#include <QtTest>
+#include "TestClock.h"
+#include "Clock.h"
+#include "Card.h"
+#include "Deck.h"
+
+namespace {
+
+/**
+ * @brief Часы, подсчитывающие обращения к себе
+ */
+class CountingClock : public FixedClock
+{
+public:
+    using FixedClock::FixedClock;
+
+    QDateTime now() const override { ++calls; return FixedClock::now(); }
+    qint64 nowMSecs() const override { ++calls; return FixedClock::nowMSecs(); }
+
+    mutable int calls = 0;
+};
+
+Card makeCard(int id, const QDateTime &nextReview)
+{
+    return Card(id, QString("Q%1").arg(id), QString("A%1").arg(id),
+                ContentType::Text, TestMode::DirectAnswer,
+                2.5f, 1, 0, nextReview, QDateTime(), 1);
+}
+
+} // namespace
+
+// ==================== CLOCKS ====================
+
+void TestClock::testSystemClockTracksCurrentTime()
+{
+    const qint64 before = QDateTime::currentMSecsSinceEpoch();
+    const qint64 now = Clock::system().nowMSecs();
+    const qint64 after = QDateTime::currentMSecsSinceEpoch();
+
+    QVERIFY(before <= now && now <= after);
+    QVERIFY(Clock::system().now().isValid());
+    QCOMPARE(&Clock::system(), &Clock::system());
+}
+
+void TestClock::testFixedClockAdvance()
+{
+    const QDateTime start(QDate(2024, 3, 1), QTime(9, 0));
+    FixedClock clock(start);
+
+    QCOMPARE(clock.now(), start);
+    QCOMPARE(clock.nowMSecs(), start.toMSecsSinceEpoch());
+    QCOMPARE(clock.now(), clock.now());
+
+    clock.advance(1500);
+    QCOMPARE(clock.nowMSecs(), start.toMSecsSinceEpoch() + 1500);
+
+    clock.setNow(start);
+    clock.advanceDays(3);
+    QCOMPARE(clock.now(), start.addDays(3));
+}
+
+void TestClock::testCachedClockTracksSystemTime()
+{
+    CachedClock clock(0);
+
+    const qint64 before = QDateTime::currentMSecsSinceEpoch();
+    const qint64 now = clock.nowMSecs();
+    const qint64 after = QDateTime::currentMSecsSinceEpoch();
+
+    // Монотонный таймер и системное время могут расходиться на миллисекунды
+    QVERIFY(qAbs(now - before) <= 50);
+    QVERIFY(qAbs(now - after) <= 50);
+
+    QTest::qWait(20);
+    QVERIFY(clock.nowMSecs() >= now + 20);
+    QVERIFY(qAbs(clock.now().toMSecsSinceEpoch() - clock.nowMSecs()) <= 50);
+}
+
+void TestClock::testCachedClockResolution()
+{
+    CachedClock clock(60 * 1000);
+
+    // В пределах точности now() отдает один и тот же кэшированный момент
+    const QDateTime first = clock.now();
+    QTest::qWait(5);
+    QCOMPARE(clock.now(), first);
+    QVERIFY(clock.nowMSecs() > first.toMSecsSinceEpoch());
+
+    clock.resync();
+    QVERIFY(clock.now() >= first);
+}
+
+// ==================== CARD & DECK ====================
+
+void TestClock::testCardUpdateSM2WithClock()
+{
+    const QDateTime start(QDate(2024, 3, 1), QTime(9, 0));
+    FixedClock clock(start);
+    Card card = makeCard(1, QDateTime());
+
+    card.updateSM2(5, clock);
+    QCOMPARE(card.getLastReview(), start);
+    QCOMPARE(card.getNextReview(), start.addDays(1));
+
+    clock.advanceDays(1);
+    card.updateSM2(5, clock);
+    QCOMPARE(card.getLastReview(), start.addDays(1));
+    QCOMPARE(card.getNextReview(), start.addDays(7));
+}
+
+void TestClock::testDeckUsesClock()
+{
+    const QDateTime start(QDate(2024, 3, 1), QTime(9, 0));
+    FixedClock clock(start);
+
+    Deck deck;
+    QCOMPARE(&deck.getClock(), &Clock::system());
+
+    deck.setClock(&clock);
+    QCOMPARE(&deck.getClock(), static_cast<const Clock *>(&clock));
+
+    QList<Card> cards;
+    for (int i = 0; i < 10; i++) {
+        cards.append(makeCard(i, start.addDays(i)));
+    }
+    deck.setCards(cards);
+
+    // Время сдвигается только вместе с часами
+    QCOMPARE(deck.getDueCount(), 1);
+    clock.advanceDays(4);
+    QCOMPARE(deck.getDueCount(), 5);
+    QCOMPARE(deck.getDueCards().size(), 5);
+    QCOMPARE(deck.getDueCardsView().size(), 5);
+
+    QVERIFY(deck.reviewCard(0, 5));
+    QCOMPARE(deck.getDueCount(), 4);
+    QCOMPARE(deck.getCards()[0].getLastReview(), start.addDays(4));
+
+    deck.setClock(nullptr);
+    QCOMPARE(&deck.getClock(), &Clock::system());
+    QCOMPARE(deck.getDueCount(), 10);
+}
+
+void TestClock::testDeckApplyGradesReadsClockOnce()
+{
+    const QDateTime start(QDate(2024, 3, 1), QTime(9, 0));
+    CountingClock clock(start);
+
+    Deck deck;
+    deck.setClock(&clock);
+    QList<Card> cards;
+    QList<CardGrade> grades;
+    for (int i = 0; i < 100; i++) {
+        cards.append(makeCard(i, QDateTime()));
+        grades.append(CardGrade{i, 4});
+    }
+    deck.setCards(cards);
+
+    clock.calls = 0;
+    QCOMPARE(deck.applyGrades(grades), 100);
+    QCOMPARE(clock.calls, 1);
+
+    for (const CardRef &card : deck.getCardsView()) {
+        QCOMPARE(card.getLastReview(), start);
+    }
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestClock::testNowPerformance_data()
+{
+    QTest::addColumn<QString>("source");
+
+    QTest::newRow("QDateTime::currentDateTime") << "current";
+    QTest::newRow("SystemClock::now") << "system";
+    QTest::newRow("SystemClock::nowMSecs") << "systemMSecs";
+    QTest::newRow("FixedClock::now") << "fixed";
+    QTest::newRow("CachedClock::now") << "cached";
+    QTest::newRow("CachedClock::nowMSecs") << "cachedMSecs";
+}
+
+void TestClock::testNowPerformance()
+{
+    // Стоимость одного чтения времени; 1000 вызовов на итерацию
+    QFETCH(QString, source);
+
+    const SystemClock systemClock;
+    const FixedClock fixedClock(QDateTime::currentDateTime());
+    const CachedClock cachedClock;
+    const int calls = 1000;
+    qint64 checksum = 0;
+
+    if (source == "current") {
+        QBENCHMARK {
+            for (int i = 0; i < calls; i++) {
+                checksum += QDateTime::currentDateTime().time().msec();
+            }
+        }
+    } else if (source == "system" || source == "fixed" || source == "cached") {
+        const Clock &clock = source == "system" ? static_cast<const Clock &>(systemClock)
+                           : source == "fixed"  ? static_cast<const Clock &>(fixedClock)
+                                                : static_cast<const Clock &>(cachedClock);
+        QBENCHMARK {
+            for (int i = 0; i < calls; i++) {
+                checksum += clock.now().time().msec();
+            }
+        }
+    } else {
+        const Clock &clock = source == "systemMSecs" ? static_cast<const Clock &>(systemClock)
+                                                     : static_cast<const Clock &>(cachedClock);
+        QBENCHMARK {
+            for (int i = 0; i < calls; i++) {
+                checksum += clock.nowMSecs() & 1;
+            }
+        }
+    }
+
+    QVERIFY(checksum >= 0);
+}
@@ -0,0 +1,309 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include "TestConcurrentDeck.h"
+#include "CardContentCache.h"
+#include "ConcurrentDeck.h"
+#include "SearchIndex.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/**
+ * @brief Колода с идентификаторами карточек 1..count
+ */
+Deck makeDeck(int count, const Clock *clock)
+{
+    return TestDecks::buildDeck(1, count, [](int i) {
+        const QDateTime next = i % 3 == 0 ? QDateTime() : kNow.addSecs(qint64(i % 1000) * 3600 - 24 * 3600);
+        return TestDecks::textCard(i + 1, i, next, 1, i % 20, 0);
+    }, clock);
+}
+
+/**
+ * @brief Источник содержимого, запоминающий потоки обращений
+ */
+class ThreadRecordingSource : public CardContentSource
+{
+public:
+    bool fetchContent(int cardId, CardContent &content) override
+    {
+        threads.append(QThread::currentThread());
+        content.question = QString("Вопрос %1").arg(cardId);
+        return true;
+    }
+
+    QList<QThread *> threads;
+};
+
+int repetitionsOf(const Deck &deck, int cardId)
+{
+    return deck.getCardsView()[deck.indexOf(cardId)].getRepetitions();
+}
+
+} // namespace
+
+// ==================== VERSIONS ====================
+
+void TestConcurrentDeck::testSnapshotIsolation()
+{
+    FixedClock clock(kNow);
+    ConcurrentDeck deck(makeDeck(1000, &clock));
+    QCOMPARE(deck.version(), quint64(0));
+
+    const ConcurrentDeck::Snapshot before = deck.read();
+    QVERIFY(deck.reviewCard(10, 5));
+    QCOMPARE(deck.version(), quint64(1));
+
+    // Старый снимок не видит оценку, новый видит
+    QCOMPARE(before.version(), quint64(0));
+    QCOMPARE(repetitionsOf(before.deck(), 10), 0);
+    const ConcurrentDeck::Snapshot after = deck.read();
+    QCOMPARE(after.version(), quint64(1));
+    QCOMPARE(repetitionsOf(after.deck(), 10), 1);
+    QCOMPARE(after->getCardCount(), 1000);
+
+    // Пакет оценок - одна публикация
+    QCOMPARE(deck.applyGrades({{1, 4}, {2, 4}, {3, 1}, {99999, 5}}), 3);
+    QCOMPARE(deck.version(), quint64(2));
+    QCOMPARE(repetitionsOf(deck.read().deck(), 2), 1);
+    QCOMPARE(repetitionsOf(after.deck(), 2), 0);
+}
+
+void TestConcurrentDeck::testRejectedUpdate()
+{
+    FixedClock clock(kNow);
+    ConcurrentDeck deck(makeDeck(100, &clock));
+
+    QVERIFY(!deck.reviewCard(12345, 5));
+    QCOMPARE(deck.applyGrades({{12345, 5}}), 0);
+    QVERIFY(!deck.update([](Deck &copy) {
+        copy.setName("Не сохранится");
+        return false;
+    }));
+    QCOMPARE(deck.version(), quint64(0));
+    QCOMPARE(deck.read()->getName(), QString());
+
+    QVERIFY(deck.update([](Deck &copy) {
+        copy.setName("Новое название");
+        return true;
+    }));
+    QCOMPARE(deck.read()->getName(), QString("Новое название"));
+}
+
+void TestConcurrentDeck::testSearchIndexFollowsPublishedVersion()
+{
+    FixedClock clock(kNow);
+    SearchIndex index;
+    Deck initial = makeDeck(100, &clock);
+    initial.setSearchIndex(&index);
+    ConcurrentDeck deck(std::move(initial));
+    QCOMPARE(index.size(), 100);
+
+    const Card added(500, "Новая карточка", "Ответ", ContentType::Text, TestMode::DirectAnswer,
+                     2.5f, 0, 0, QDateTime(), QDateTime(), 1);
+
+    // Отмененное изменение не попадает в индекс
+    QVERIFY(!deck.update([&added](Deck &copy) {
+        copy.addCard(added);
+        return false;
+    }));
+    QVERIFY(!index.contains(500));
+
+    // Копия снимка не связана с индексом
+    Deck detached = deck.read().deck();
+    detached.addCard(added);
+    QVERIFY(detached.removeCard(1));
+    QVERIFY(!index.contains(500));
+    QVERIFY(index.contains(1));
+
+    // Оценки текст не меняют, опубликованные изменения текста - меняют
+    QVERIFY(deck.reviewCard(5, 4));
+    QCOMPARE(index.size(), 100);
+    QVERIFY(deck.update([&added](Deck &copy) {
+        copy.addCard(added);
+        return copy.removeCard(1);
+    }));
+    QVERIFY(index.contains(500));
+    QVERIFY(!index.contains(1));
+    QCOMPARE(index.size(), 100);
+    QCOMPARE(index.search("новая"), QList<int>({500}));
+}
+
+void TestConcurrentDeck::testContentCacheNotShared()
+{
+    // Источник содержимого не вызывается из потоков читателей
+    FixedClock clock(kNow);
+    ThreadRecordingSource source;
+    CardContentCache cache(&source);
+    Deck initial = makeDeck(10, &clock);
+    initial.setMetadataOnly(true);
+    initial.setContentCache(&cache);
+    QCOMPARE(initial.getContent(3).question, QString("Вопрос 3"));
+    ConcurrentDeck deck(std::move(initial));
+
+    QThread *reader = QThread::create([&deck]() {
+        const ConcurrentDeck::Snapshot snapshot = deck.read();
+        snapshot->getContent(4);
+        Deck copy = snapshot.deck();
+        copy.getContent(5);
+    });
+    reader->start();
+    QVERIFY(reader->wait(5000));
+    delete reader;
+
+    QCOMPARE(source.threads, QList<QThread *>({QThread::currentThread()}));
+}
+
+void TestConcurrentDeck::testReclaimAfterRelease()
+{
+    FixedClock clock(kNow);
+    ConcurrentDeck deck(makeDeck(100, &clock));
+
+    {
+        ConcurrentDeck::Snapshot held = deck.read();
+        for (int i = 0; i < 5; i++) {
+            QVERIFY(deck.reviewCard(1, 4));
+        }
+        // Удерживаемая версия 0 и версии после неё ждут освобождения снимка
+        QVERIFY(deck.retainedVersions() >= 1);
+        QCOMPARE(held.version(), quint64(0));
+
+        // Перемещенный снимок продолжает удерживать версию
+        ConcurrentDeck::Snapshot moved = std::move(held);
+        QCOMPARE(moved.version(), quint64(0));
+        QVERIFY(deck.reviewCard(1, 4));
+        QVERIFY(deck.retainedVersions() >= 1);
+    }
+
+    QVERIFY(deck.reviewCard(1, 4));
+    QCOMPARE(deck.retainedVersions(), 0);
+    QCOMPARE(repetitionsOf(deck.read().deck(), 1), 7);
+}
+
+void TestConcurrentDeck::testReaderSlotsExhausted()
+{
+    FixedClock clock(kNow);
+    ConcurrentDeck deck(makeDeck(10, &clock), 2);
+
+    auto first = std::make_unique<ConcurrentDeck::Snapshot>(deck.read());
+    const ConcurrentDeck::Snapshot second = deck.read();
+
+    // Третий читатель ждет, пока освободится ячейка
+    std::atomic<bool> done{false};
+    QThread *reader = QThread::create([&deck, &done]() {
+        const ConcurrentDeck::Snapshot third = deck.read();
+        done = third->getCardCount() == 10;
+    });
+    reader->start();
+    QThread::msleep(50);
+    QVERIFY(!done);
+
+    first.reset();
+    QVERIFY(reader->wait(10000));
+    QVERIFY(done);
+    delete reader;
+}
+
+// ==================== STRESS ====================
+
+/**
+ * @brief 1, 2, 4 и 8 читателей против одного писателя
+ *
+ * Писатель каждой публикацией ставит оценку двум карточкам, поэтому
+ * в согласованном снимке их счетчики повторений равны и совпадают
+ * с номером версии. Читатели проверяют это, считают готовые карточки
+ * и проходят окно столбца интервалов.
+ */
+void TestConcurrentDeck::testReadersAndWriterStress()
+{
+    constexpr int kCards = 20000;
+    constexpr int kWindow = 2048;
+    constexpr int kRunMSecs = 300;
+
+    FixedClock clock(kNow);
+    QList<double> readsPerSecond;
+
+    for (int readerCount : {1, 2, 4, 8}) {
+        ConcurrentDeck deck(makeDeck(kCards, &clock));
+        std::atomic<bool> stop{false};
+        std::atomic<qint64> reads{0};
+        std::atomic<int> violations{0};
+        qint64 writes = 0;
+
+        QList<QThread *> readers;
+        for (int r = 0; r < readerCount; r++) {
+            readers.append(QThread::create([&, r]() {
+                quint64 lastVersion = 0;
+                qint64 local = 0;
+                qint64 checksum = 0;
+                int offset = r * 997;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const ConcurrentDeck::Snapshot snapshot = deck.read();
+                    const Deck &view = snapshot.deck();
+                    const int first = repetitionsOf(view, 1);
+                    const int second = repetitionsOf(view, 2);
+                    if (first != second || quint64(first) != snapshot.version()
+                        || snapshot.version() < lastVersion) {
+                        violations++;
+                    }
+                    lastVersion = snapshot.version();
+
+                    checksum += view.getDueCount();
+                    const CardSpan cards = view.getCardsView();
+                    offset = (offset + kWindow) % (kCards - kWindow);
+                    for (int i = offset; i < offset + kWindow; i++) {
+                        checksum += cards[i].getIntervalDays();
+                    }
+                    local++;
+                }
+                reads += local;
+                if (checksum < 0) {
+                    violations++;
+                }
+            }));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (QThread *reader : std::as_const(readers)) {
+            reader->start();
+        }
+        while (timer.elapsed() < kRunMSecs) {
+            if (deck.applyGrades({{1, 5}, {2, 5}, {3 + int(writes % (kCards - 3)), 3}}) != 3) {
+                violations++;
+            }
+            writes++;
+        }
+        stop = true;
+        for (QThread *reader : std::as_const(readers)) {
+            QVERIFY(reader->wait(10000));
+            delete reader;
+        }
+        const double seconds = timer.elapsed() / 1000.0;
+
+        QCOMPARE(violations.load(), 0);
+        QVERIFY(reads.load() > 0);
+        QCOMPARE(deck.version(), quint64(writes));
+
+        // Без читателей следующая публикация освобождает все старые версии
+        QVERIFY(deck.update([](Deck &) { return true; }));
+        QCOMPARE(deck.retainedVersions(), 0);
+
+        readsPerSecond.append(reads.load() / seconds);
+        qDebug() << "Readers:" << readerCount
+                 << "reads/s:" << qint64(reads.load() / seconds)
+                 << "writes/s:" << qint64(writes / seconds)
+                 << "scaling:" << readsPerSecond.last() / readsPerSecond.first();
+    }
+
+    // Читатели не мешают друг другу: при достаточном числе ядер
+    // пропускная способность растет с их числом
+    if (QThread::idealThreadCount() >= 10) {
+        QVERIFY(readsPerSecond.last() > 2.0 * readsPerSecond.first());
+    }
+}
@@ -0,0 +1,360 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <functional>
+#include "TestContentCache.h"
+#include "CardContentCache.h"
+#include "Database.h"
+#include "DeckRepository.h"
+
+namespace {
+
+/**
+ * @brief Источник содержимого в памяти, считающий обращения
+ */
+class MemorySource : public CardContentSource
+{
+public:
+    bool fetchContent(int cardId, CardContent &content) override
+    {
+        ++fetches;
+        if (onFetch) {
+            onFetch();
+        }
+        auto it = contents.constFind(cardId);
+        if (it == contents.constEnd()) {
+            return false;
+        }
+        content = it.value();
+        return true;
+    }
+
+    void add(int cardId, qsizetype textLength)
+    {
+        CardContent content;
+        content.question = QString(textLength, QChar('q'));
+        content.answer = QString("A%1").arg(cardId);
+        contents.insert(cardId, content);
+    }
+
+    QHash<int, CardContent> contents;
+    int fetches = 0;
+    std::function<void()> onFetch;  ///< Вызывается при каждом чтении
+};
+
+Card makeCard(int id, ContentType type = ContentType::Text)
+{
+    return Card(id, QString("Вопрос %1 ").arg(id).repeated(8), QString("Ответ %1 ").arg(id).repeated(8),
+                type, TestMode::DirectAnswer,
+                2.5f, 1, 0, QDateTime::currentDateTime().addDays(-1), QDateTime(), 1);
+}
+
+} // namespace
+
+// ==================== CACHE ====================
+
+void TestContentCache::testHitAndMiss()
+{
+    MemorySource source;
+    source.add(1, 10);
+    source.add(2, 10);
+    CardContentCache cache(&source);
+
+    QCOMPARE(cache.content(1).answer, QString("A1"));
+    QCOMPARE(cache.content(1).answer, QString("A1"));
+    QCOMPARE(cache.content(2).answer, QString("A2"));
+    QCOMPARE(cache.content(1).answer, QString("A1"));
+
+    QCOMPARE(source.fetches, 2);
+    const CardContentCache::Stats stats = cache.stats();
+    QCOMPARE(stats.hits, qint64(2));
+    QCOMPARE(stats.misses, qint64(2));
+    QCOMPARE(stats.hitRate(), 0.5);
+
+    cache.resetStats();
+    QCOMPARE(cache.stats().hits, qint64(0));
+    QCOMPARE(cache.stats().hitRate(), 0.0);
+}
+
+void TestContentCache::testEvictsLeastRecentlyUsed()
+{
+    MemorySource source;
+    for (int id = 1; id <= 4; id++) {
+        source.add(id, 500);
+    }
+
+    // Помещаются ровно три карточки
+    CardContent probe;
+    source.fetchContent(1, probe);
+    source.fetches = 0;
+    CardContentCache cache(&source, probe.memoryCost() * 3);
+
+    cache.content(1);
+    cache.content(2);
+    cache.content(3);
+    cache.content(1);       // 1 становится самой свежей
+    cache.content(4);       // вытесняет 2
+
+    QVERIFY(cache.contains(1));
+    QVERIFY(!cache.contains(2));
+    QVERIFY(cache.contains(3));
+    QVERIFY(cache.contains(4));
+    QVERIFY(cache.totalCost() <= cache.capacity());
+
+    cache.setCapacity(probe.memoryCost());
+    QVERIFY(cache.totalCost() <= probe.memoryCost());
+}
+
+void TestContentCache::testOversizedContentNotCached()
+{
+    MemorySource source;
+    source.add(1, 10000);
+    CardContentCache cache(&source, 1024);
+
+    QCOMPARE(cache.content(1).question.size(), 10000);
+    QVERIFY(!cache.contains(1));
+    QCOMPARE(cache.totalCost(), qsizetype(0));
+}
+
+void TestContentCache::testInvalidate()
+{
+    MemorySource source;
+    source.add(1, 10);
+    CardContentCache cache(&source);
+
+    cache.content(1);
+    source.contents[1].answer = "Изменен";
+    QCOMPARE(cache.content(1).answer, QString("A1"));
+
+    cache.invalidate(1);
+    QCOMPARE(cache.content(1).answer, QString("Изменен"));
+
+    cache.clear();
+    QVERIFY(!cache.contains(1));
+
+    // Источник читается без мьютекса кэша; содержимое, забытое во время
+    // чтения, не кэшируется
+    source.onFetch = [&cache]() { cache.invalidate(1); };
+    QCOMPARE(cache.content(1).answer, QString("Изменен"));
+    QVERIFY(!cache.contains(1));
+    source.onFetch = nullptr;
+    cache.content(1);
+    QVERIFY(cache.contains(1));
+}
+
+void TestContentCache::testMissingCard()
+{
+    MemorySource source;
+    CardContentCache cache(&source);
+
+    bool found = true;
+    const CardContent content = cache.content(42, &found);
+    QVERIFY(!found);
+    QVERIFY(content.question.isEmpty());
+    QCOMPARE(cache.stats().failures, qint64(1));
+    QVERIFY(!cache.contains(42));
+}
+
+// ==================== METADATA-ONLY DECK ====================
+
+void TestContentCache::testStoreWithoutText()
+{
+    CardStore full;
+    CardStore lean;
+    lean.setTextStored(false);
+    for (int i = 0; i < 100; i++) {
+        full.append(makeCard(i));
+        lean.append(makeCard(i));
+    }
+
+    QVERIFY(!lean.isTextStored());
+    QCOMPARE(lean.size(), 100);
+    QVERIFY(lean.question(5).isEmpty());
+    QCOMPARE(lean.card(5).getEasyFactor(), full.card(5).getEasyFactor());
+    QVERIFY(lean.memoryUsage() < full.memoryUsage() / 4);
+
+    lean.removeAt(0);
+    QCOMPARE(lean.id(0), 1);
+
+    // Возврат к хранению текста выравнивает столбцы
+    lean.setTextStored(true);
+    QVERIFY(lean.question(10).isEmpty());
+    lean.append(makeCard(500));
+    QCOMPARE(lean.question(lean.size() - 1), makeCard(500).getQuestion());
+}
+
+void TestContentCache::testMetadataOnlyDeck()
+{
+    MemorySource source;
+    QList<Card> cards;
+    for (int i = 1; i <= 20; i++) {
+        source.add(i, 40);
+        cards.append(makeCard(i));
+    }
+    CardContentCache cache(&source);
+
+    Deck deck;
+    deck.setMetadataOnly(true);
+    deck.setCards(cards);
+    QVERIFY(deck.isMetadataOnly());
+
+    // Планирование работает без текста
+    QCOMPARE(deck.getDueCount(), 20);
+    QVERIFY(deck.reviewCard(3, 5));
+    QCOMPARE(deck.getDueCount(), 19);
+    QVERIFY(deck.getCards()[0].getQuestion().isEmpty());
+
+    // Без кэша содержимого нет, с кэшем - загружается по требованию
+    QVERIFY(deck.getContent(3).answer.isEmpty());
+    deck.setContentCache(&cache);
+    QCOMPARE(deck.getContent(3).answer, QString("A3"));
+    QCOMPARE(deck.getContent(3).answer, QString("A3"));
+    QCOMPARE(source.fetches, 1);
+    QVERIFY(deck.getContent(999).answer.isEmpty());
+
+    // Удаленная и добавленная заново карточка читает содержимое заново
+    source.contents[3].answer = "A3 (правка)";
+    QVERIFY(deck.removeCard(3));
+    deck.addCard(makeCard(3));
+    QCOMPARE(deck.getContent(3).answer, QString("A3 (правка)"));
+    QCOMPARE(source.fetches, 2);
+
+    // Измененная карточка тоже
+    source.contents[3].answer = "A3 (вторая правка)";
+    QVERIFY(deck.updateCard(makeCard(3)));
+    QCOMPARE(deck.getContent(3).answer, QString("A3 (вторая правка)"));
+    QCOMPARE(source.fetches, 3);
+
+    // Колода с текстом отвечает из памяти и не трогает кэш
+    Deck fullDeck;
+    fullDeck.setCards(cards);
+    fullDeck.setContentCache(&cache);
+    QCOMPARE(fullDeck.getContent(7).question, cards[6].getQuestion());
+    QCOMPARE(source.fetches, 3);
+}
+
+void TestContentCache::testLoadDeckMetadataFromRepository()
+{
+    const QString connection = "content_cache_metadata";
+    {
+        QSqlDatabase database = Database::open(":memory:", connection);
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+
+        Deck original;
+        original.setId(1);
+        original.setName("Медиа");
+        original.setCards({makeCard(1), makeCard(2, ContentType::Image), makeCard(3, ContentType::Audio)});
+        QVERIFY(repository.saveDeck(original));
+        QVERIFY(repository.cards().saveMedia(2, QByteArray("\x89PNG", 4)));
+        QVERIFY(repository.cards().saveMedia(3, QByteArray(1000, 'a')));
+
+        Deck lazy;
+        QVERIFY2(repository.loadDeckMetadata(1, lazy), qPrintable(repository.lastError()));
+        QVERIFY(lazy.isMetadataOnly());
+        QCOMPARE(lazy.getName(), QString("Медиа"));
+        QCOMPARE(lazy.getCardCount(), 3);
+        QVERIFY(lazy.getCards()[0].getQuestion().isEmpty());
+        QCOMPARE(lazy.getCards()[1].getContentType(), ContentType::Image);
+        QCOMPARE(lazy.getDueCount(), original.getDueCount());
+
+        CardContentCache cache(&repository.cards());
+        lazy.setContentCache(&cache);
+        QCOMPARE(lazy.getContent(1).question, original.getCards()[0].getQuestion());
+        QVERIFY(lazy.getContent(1).media.isEmpty());
+        QCOMPARE(lazy.getContent(2).media, QByteArray("\x89PNG", 4));
+        QCOMPARE(lazy.getContent(3).media.size(), 1000);
+
+        // Медиаданные удаляются вместе с колодой
+        QVERIFY(repository.removeDeck(1));
+        CardContent content;
+        QVERIFY(!repository.cards().fetchContent(2, content));
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestContentCache::testLazyStartup_data()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestContentCache::testLazyStartup()
+{
+    // Запуск с полной загрузкой и только с полями планирования,
+    // затем сессия с неравномерным доступом к содержимому
+    QFETCH(int, cardCount);
+    if (cardCount > 100000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    QTemporaryDir dir;
+    const QString connection = "content_cache_bench";
+    {
+        QSqlDatabase database = Database::open(dir.filePath("lazy.db"), connection);
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+        {
+            QList<Card> cards;
+            cards.reserve(cardCount);
+            for (int i = 0; i < cardCount; i++) {
+                cards.append(makeCard(i + 1));
+            }
+            Deck deck;
+            deck.setId(1);
+            deck.setCards(std::move(cards));
+            QVERIFY(repository.saveDeck(deck));
+        }
+
+        QElapsedTimer timer;
+        Deck full;
+        timer.start();
+        QVERIFY(repository.loadDeck(1, full));
+        const qint64 fullMSecs = timer.elapsed();
+
+        Deck lazy;
+        timer.restart();
+        QVERIFY(repository.loadDeckMetadata(1, lazy));
+        const qint64 lazyMSecs = timer.elapsed();
+
+        CardStore fullStore;
+        CardStore lazyStore;
+        lazyStore.setTextStored(false);
+        for (const CardRef &card : full.getCardsView()) {
+            fullStore.append(card.toCard());
+            lazyStore.append(card.toCard());
+        }
+
+        qDebug() << "Cards:" << cardCount
+                 << "full load:" << fullMSecs << "ms," << fullStore.memoryUsage() / 1024 << "KiB"
+                 << "metadata load:" << lazyMSecs << "ms," << lazyStore.memoryUsage() / 1024 << "KiB";
+
+        // Сессия: 80% обращений к 5% карточек
+        CardContentCache cache(&repository.cards(), 8 * 1024 * 1024);
+        lazy.setContentCache(&cache);
+        QRandomGenerator rng(7u);
+        const int hotCards = cardCount / 20;
+        for (int i = 0; i < 20000; i++) {
+            const int cardId = rng.bounded(100) < 80 ? rng.bounded(hotCards) + 1
+                                                     : rng.bounded(cardCount) + 1;
+            QVERIFY(!lazy.getContent(cardId).question.isEmpty());
+        }
+
+        const CardContentCache::Stats stats = cache.stats();
+        qDebug() << "Content requests:" << stats.hits + stats.misses
+                 << "hit rate:" << stats.hitRate()
+                 << "cached:" << cache.totalCost() / 1024 << "KiB";
+
+        QVERIFY(lazyStore.memoryUsage() < fullStore.memoryUsage());
+        QVERIFY(stats.hitRate() > 0.5);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
@@ -0,0 +1,481 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <algorithm>
+#include "TestCsvImporter.h"
+#include "CsvImporter.h"
+#include "Database.h"
+#include "DeckRepository.h"
+
+namespace {
+
+/**
+ * @brief Импортировать текст целиком и собрать все карточки
+ */
+QList<Card> importText(CsvImporter &importer, const QByteArray &text, bool *ok = nullptr)
+{
+    QBuffer buffer;
+    buffer.setData(text);
+    buffer.open(QIODevice::ReadOnly);
+
+    QList<Card> cards;
+    const bool imported = importer.import(buffer, [&cards](QList<Card> &&batch) {
+        cards.append(std::move(batch));
+        return true;
+    });
+    if (ok) {
+        *ok = imported;
+    }
+    return cards;
+}
+
+/**
+ * @brief CSV с заголовком и count записями, включая многострочные поля
+ */
+QByteArray makeCsv(int count)
+{
+    QByteArray csv = "question,answer,easy_factor,interval_days,repetitions,next_review\n";
+    csv.reserve(count * 64);
+    for (int i = 0; i < count; i++) {
+        csv += "Question ";
+        csv += QByteArray::number(i);
+        if (i % 10 == 0) {
+            csv += ",\"Multi\nline, \"\"quoted\"\" answer\",";
+        } else {
+            csv += ",Answer ";
+            csv += QByteArray::number(i % 1000);
+            csv += ',';
+        }
+        csv += QByteArray::number(1.3 + (i % 12) * 0.1);
+        csv += ',';
+        csv += QByteArray::number(i % 30);
+        csv += ',';
+        csv += QByteArray::number(i % 5);
+        csv += ',';
+        csv += QByteArray::number(1700000000000LL + qint64(i) * 60000);
+        csv += '\n';
+    }
+    return csv;
+}
+
+} // namespace
+
+// ==================== PARSING ====================
+
+void TestCsvImporter::testHeaderAndAllColumns()
+{
+    const QByteArray csv =
+        "ID,Question,Answer,Content_Type,Test_Mode,Easy_Factor,Interval_Days,Repetitions,Next_Review,Last_Review,Extra\n"
+        "42,Столица Франции?,Париж,text,direct,2.36,6,2,2024-03-01T10:00:00.000Z,1700000000000,x\n"
+        "43,Изображение,pic.png,1,matching,1.3,0,0,,,\n";
+
+    CsvImporter::Options options;
+    options.deckId = 9;
+    CsvImporter importer(options);
+    bool ok = false;
+    const QList<Card> cards = importText(importer, csv, &ok);
+    QVERIFY2(ok, qPrintable(importer.lastError()));
+    QCOMPARE(cards.size(), 2);
+
+    const Card &first = cards[0];
+    QCOMPARE(first.getId(), 42);
+    QCOMPARE(first.getQuestion(), QString("Столица Франции?"));
+    QCOMPARE(first.getAnswer(), QString("Париж"));
+    QCOMPARE(first.getContentType(), ContentType::Text);
+    QCOMPARE(first.getTestMode(), TestMode::DirectAnswer);
+    QCOMPARE(first.getEasyFactor(), 2.36f);
+    QCOMPARE(first.getIntervalDays(), 6);
+    QCOMPARE(first.getRepetitions(), 2);
+    QCOMPARE(first.getNextReview(), QDateTime::fromString("2024-03-01T10:00:00.000Z", Qt::ISODateWithMs));
+    QCOMPARE(first.getLastReview().toMSecsSinceEpoch(), 1700000000000LL);
+    QCOMPARE(first.getDeckId(), 9);
+
+    const Card &second = cards[1];
+    QCOMPARE(second.getContentType(), ContentType::Image);
+    QCOMPARE(second.getTestMode(), TestMode::Matching);
+    QVERIFY(!second.getNextReview().isValid());
+    QVERIFY(!second.getLastReview().isValid());
+
+    QCOMPARE(importer.result().rows, qint64(2));
+    QCOMPARE(importer.result().imported, qint64(2));
+    QCOMPARE(importer.result().malformed, qint64(0));
+    QCOMPARE(importer.result().bytesRead, qint64(csv.size()));
+}
+
+void TestCsvImporter::testQuotedFields()
+{
+    const QByteArray csv =
+        "\xEF\xBB\xBF" "question,answer\r\n"
+        "\"a, b\",\"line 1\r\nline 2\"\r\n"
+        "\"He said \"\"hi\"\"\",\"\"\r\n"
+        "plain,\"\"\"\"\r\n";
+
+    CsvImporter importer;
+    const QList<Card> cards = importText(importer, csv);
+    QCOMPARE(cards.size(), 3);
+    QCOMPARE(cards[0].getQuestion(), QString("a, b"));
+    QCOMPARE(cards[0].getAnswer(), QString("line 1\r\nline 2"));
+    QCOMPARE(cards[1].getQuestion(), QString("He said \"hi\""));
+    QVERIFY(cards[1].getAnswer().isEmpty());
+    QCOMPARE(cards[2].getAnswer(), QString("\""));
+
+    // Без столбца id идентификаторы назначаются по порядку файла
+    QCOMPARE(cards[0].getId(), 1);
+    QCOMPARE(cards[2].getId(), 3);
+    QCOMPARE(cards[0].getEasyFactor(), 2.5f);
+}
+
+void TestCsvImporter::testTsvWithoutHeader()
+{
+    const QByteArray tsv = "вопрос 1\tответ 1\n\nвопрос 2\tответ, с запятой\n";
+
+    CsvImporter::Options options;
+    options.delimiter = '\t';
+    options.hasHeader = false;
+    options.firstCardId = 100;
+    CsvImporter importer(options);
+    const QList<Card> cards = importText(importer, tsv);
+
+    QCOMPARE(cards.size(), 2);
+    QCOMPARE(cards[0].getId(), 100);
+    QCOMPARE(cards[1].getQuestion(), QString("вопрос 2"));
+    QCOMPARE(cards[1].getAnswer(), QString("ответ, с запятой"));
+    QCOMPARE(importer.result().rows, qint64(2));
+}
+
+void TestCsvImporter::testMissingRequiredColumns()
+{
+    CsvImporter importer;
+    bool ok = true;
+    const QList<Card> cards = importText(importer, "question,comment\nq,c\n", &ok);
+    QVERIFY(!ok);
+    QVERIFY(cards.isEmpty());
+    QVERIFY(importer.lastError().contains("answer"));
+
+    QVERIFY(!importer.importFile("/nonexistent/cards.csv", [](QList<Card> &&) { return true; }));
+    QVERIFY(!importer.lastError().isEmpty());
+}
+
+// ==================== ERRORS & ORDER ====================
+
+void TestCsvImporter::testMalformedRowsReported()
+{
+    const QByteArray csv =
+        "question,answer,interval_days,next_review\n"   // 1
+        "ok 1,a,1,\n"                                    // 2
+        "too few fields\n"                               // 3
+        "bad interval,a,soon,\n"                         // 4
+        "\"multi\nline\",a,2,\n"                         // 5-6
+        "bad date,a,3,yesterday\n"                       // 7
+        ",no question,1,\n"                              // 8
+        "\"bad\"quote,a,1,\n"                            // 9
+        "ok 2,a,4,\n"                                    // 10
+        "\"unterminated,a,1,\n";                         // 11
+
+    CsvImporter importer;
+    bool ok = false;
+    const QList<Card> cards = importText(importer, csv, &ok);
+    QVERIFY(ok);
+
+    QCOMPARE(cards.size(), 3);
+    QCOMPARE(cards[0].getQuestion(), QString("ok 1"));
+    QCOMPARE(cards[1].getQuestion(), QString("multi\nline"));
+    QCOMPARE(cards[2].getQuestion(), QString("ok 2"));
+
+    const CsvImporter::Result &result = importer.result();
+    QCOMPARE(result.rows, qint64(9));
+    QCOMPARE(result.malformed, qint64(6));
+    QCOMPARE(result.errors.size(), 6);
+    const QList<qint64> lines{3, 4, 7, 8, 9, 11};
+    for (int i = 0; i < lines.size(); i++) {
+        QCOMPARE(result.errors[i].line, lines[i]);
+        QVERIFY(!result.errors[i].message.isEmpty());
+    }
+    QVERIFY(result.errors[1].message.contains("interval_days"));
+    QVERIFY(result.errors[5].message.contains("unterminated"));
+}
+
+void TestCsvImporter::testChunkBoundaries_data()
+{
+    QTest::addColumn<int>("chunkBytes");
+    QTest::addColumn<int>("threadCount");
+    QTest::addColumn<int>("batchSize");
+
+    QTest::newRow("1 byte, 1 thread") << 1 << 1 << 7;
+    QTest::newRow("13 bytes, 4 threads") << 13 << 4 << 100;
+    QTest::newRow("4 KiB, 8 threads") << 4096 << 8 << 1000;
+    QTest::newRow("default") << (4 << 20) << 0 << 50000;
+}
+
+void TestCsvImporter::testChunkBoundaries()
+{
+    // Результат не зависит от размера блоков и количества потоков
+    QFETCH(int, chunkBytes);
+    QFETCH(int, threadCount);
+    QFETCH(int, batchSize);
+
+    const QByteArray csv = makeCsv(3000) + "broken,\"\n";
+
+    CsvImporter::Options options;
+    options.chunkBytes = chunkBytes;
+    options.threadCount = threadCount;
+    options.batchSize = batchSize;
+    CsvImporter importer(options);
+    const QList<Card> cards = importText(importer, csv);
+
+    QCOMPARE(cards.size(), 3000);
+    for (int i = 0; i < cards.size(); i++) {
+        QCOMPARE(cards[i].getId(), i + 1);
+        QCOMPARE(cards[i].getQuestion(), QString("Question %1").arg(i));
+        QCOMPARE(cards[i].getIntervalDays(), i % 30);
+    }
+    QCOMPARE(cards[10].getAnswer(), QString("Multi\nline, \"quoted\" answer"));
+    QCOMPARE(importer.result().malformed, qint64(1));
+    QCOMPARE(importer.result().errors.first().line, qint64(3000 + 300 + 2));
+}
+
+void TestCsvImporter::testMidFieldQuotes_data()
+{
+    QTest::addColumn<int>("chunkBytes");
+
+    QTest::newRow("1 byte") << 1;
+    QTest::newRow("7 bytes") << 7;
+    QTest::newRow("64 bytes") << 64;
+}
+
+void TestCsvImporter::testMidFieldQuotes()
+{
+    // Кавычка в середине поля без кавычек не открывает поле в кавычках,
+    // поэтому блоки режутся только по настоящим концам записей
+    QFETCH(int, chunkBytes);
+
+    QByteArray csv = "question,answer,note\n";
+    for (int i = 0; i < 200; i++) {
+        csv += "Height " + QByteArray::number(i) + ",5'11\"";
+        if (i % 3 == 0) {
+            csv += " \"tall\"\n";
+        } else if (i % 3 == 1) {
+            csv += "\n";
+        } else {
+            csv += ",\"x\ny\"\"\"\n";
+        }
+    }
+
+    CsvImporter::Options options;
+    options.chunkBytes = chunkBytes;
+    options.threadCount = 2;
+    CsvImporter importer(options);
+    bool ok = false;
+    const QList<Card> cards = importText(importer, csv, &ok);
+    QVERIFY2(ok, qPrintable(importer.lastError()));
+
+    QCOMPARE(cards.size(), 200);
+    QCOMPARE(importer.result().malformed, qint64(0));
+    for (int i = 0; i < cards.size(); i++) {
+        QCOMPARE(cards[i].getQuestion(), QString("Height %1").arg(i));
+    }
+    QCOMPARE(cards[0].getAnswer(), QString("5'11\" \"tall\""));
+    QCOMPARE(cards[1].getAnswer(), QString("5'11\""));
+    QCOMPARE(cards[2].getAnswer(), QString("5'11\""));
+}
+
+void TestCsvImporter::testProgressReported()
+{
+    const QByteArray csv = makeCsv(5000);
+
+    CsvImporter::Options options;
+    options.chunkBytes = 4096;
+    CsvImporter importer(options);
+    QList<qint64> progress;
+    qint64 lastRows = 0;
+    importer.setProgressCallback([&](qint64 bytesProcessed, qint64 totalBytes, qint64 rowsImported) {
+        QCOMPARE(totalBytes, qint64(csv.size()));
+        QVERIFY(rowsImported >= lastRows);
+        lastRows = rowsImported;
+        progress.append(bytesProcessed);
+    });
+    importText(importer, csv);
+
+    QVERIFY(progress.size() > 10);
+    QVERIFY(std::is_sorted(progress.begin(), progress.end()));
+    QCOMPARE(progress.last(), qint64(csv.size()));
+    QCOMPARE(lastRows, qint64(5000));
+}
+
+// ==================== SINKS ====================
+
+void TestCsvImporter::testDeckSink()
+{
+    const QByteArray csv = makeCsv(2000);
+
+    CsvImporter::Options options;
+    options.batchSize = 300;
+    options.chunkBytes = 8192;
+    CsvImporter importer(options);
+    Deck deck;
+    FixedClock clock(QDateTime::fromMSecsSinceEpoch(1700000000000LL + 1000LL * 60000));
+    deck.setClock(&clock);
+
+    QBuffer buffer;
+    buffer.setData(csv);
+    buffer.open(QIODevice::ReadOnly);
+    QVERIFY(importer.import(buffer, CsvImporter::deckSink(deck)));
+
+    QCOMPARE(deck.getCardCount(), 2000);
+    QCOMPARE(deck.indexOf(1500), 1499);
+
+    // Индекс, собранный слиянием пакетов, совпадает с перестроенным
+    Deck rebuilt;
+    rebuilt.setClock(&clock);
+    rebuilt.setCards(deck.getCards());
+    QCOMPARE(deck.getDueCount(), 1001);
+    QCOMPARE(deck.getDueCount(), rebuilt.getDueCount());
+    DueCardRange due = deck.getDueCardsView();
+    auto it = due.begin();
+    for (const CardRef &card : rebuilt.getDueCardsView()) {
+        QCOMPARE((*it).getId(), card.getId());
+        ++it;
+    }
+}
+
+void TestCsvImporter::testRepositorySink()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("cards.csv");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(makeCsv(1500));
+    file.close();
+
+    const QString connection = "csv_importer_repository";
+    {
+        QSqlDatabase database = Database::open(":memory:", connection);
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+        Deck deck;
+        deck.setId(5);
+        QVERIFY(repository.saveDeck(deck));
+
+        CsvImporter::Options options;
+        options.deckId = 5;
+        options.batchSize = 400;
+        CsvImporter importer(options);
+        QVERIFY2(importer.importFile(path, CsvImporter::repositorySink(repository.cards(), 5)),
+                 qPrintable(importer.lastError()));
+
+        const QList<Card> stored = repository.cards().loadDeckCards(5);
+        QCOMPARE(stored.size(), 1500);
+        QCOMPARE(stored[1499].getQuestion(), QString("Question 1499"));
+        QCOMPARE(stored[10].getAnswer(), QString("Multi\nline, \"quoted\" answer"));
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
+
+void TestCsvImporter::testRepositoryImportKeepsOtherDecks()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("cards.csv");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(makeCsv(300));
+    file.close();
+
+    const QString connection = "csv_importer_two_decks";
+    {
+        QSqlDatabase database = Database::open(":memory:", connection);
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+
+        // Оба файла нумеруются импортером, но идентификаторы общие для базы
+        for (int deckId : {1, 2}) {
+            CsvImporter::Options options;
+            options.deckId = deckId;
+            options.batchSize = 128;
+            CsvImporter importer(options);
+            QVERIFY2(importer.importFile(path, repository.cards()), qPrintable(importer.lastError()));
+            QCOMPARE(importer.result().imported, qint64(300));
+        }
+
+        const QList<Card> first = repository.cards().loadDeckCards(1);
+        const QList<Card> second = repository.cards().loadDeckCards(2);
+        QCOMPARE(first.size(), 300);
+        QCOMPARE(second.size(), 300);
+        QCOMPARE(first.first().getId(), 1);
+        QCOMPARE(second.first().getId(), 301);
+        QCOMPARE(second.last().getQuestion(), QString("Question 299"));
+        QCOMPARE(repository.cards().nextCardId(), 601);
+
+        // Прямой получатель с занятыми идентификаторами не перезаписывает колоду 1
+        CsvImporter::Options options;
+        options.deckId = 3;
+        CsvImporter importer(options);
+        QVERIFY(!importer.importFile(path, CsvImporter::repositorySink(repository.cards(), 3)));
+        QCOMPARE(repository.cards().loadDeckCards(1).size(), 300);
+        QCOMPARE(repository.cards().loadDeckCards(3).size(), 0);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+}
+
+void TestCsvImporter::testSinkAbortsImport()
+{
+    CsvImporter::Options options;
+    options.batchSize = 100;
+    options.chunkBytes = 1024;
+    CsvImporter importer(options);
+
+    QBuffer buffer;
+    buffer.setData(makeCsv(5000));
+    buffer.open(QIODevice::ReadOnly);
+    int batches = 0;
+    QVERIFY(!importer.import(buffer, [&batches](QList<Card> &&) { return ++batches < 3; }));
+    QCOMPARE(batches, 3);
+    QVERIFY(!importer.lastError().isEmpty());
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestCsvImporter::testImportThroughput_data()
+{
+    QTest::addColumn<int>("rowCount");
+
+    QTest::newRow("200k") << 200000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestCsvImporter::testImportThroughput()
+{
+    // Импорт файла в колоду: один поток разбора против всех ядер
+    QFETCH(int, rowCount);
+    if (rowCount > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-row benchmarks");
+    }
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("bench.csv");
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(makeCsv(rowCount));
+    }
+    const double megabytes = QFile(path).size() / (1024.0 * 1024.0);
+
+    for (int threads : {1, 0}) {
+        CsvImporter::Options options;
+        options.threadCount = threads;
+        CsvImporter importer(options);
+        Deck deck;
+        QVERIFY(importer.importFile(path, CsvImporter::deckSink(deck)));
+        QCOMPARE(deck.getCardCount(), rowCount);
+
+        const CsvImporter::Result &result = importer.result();
+        const double seconds = qMax<qint64>(1, result.elapsedMSecs) / 1000.0;
+        qDebug() << "Rows:" << rowCount
+                 << "threads:" << (threads > 0 ? QString::number(threads) : QString("auto"))
+                 << "time:" << result.elapsedMSecs << "ms,"
+                 << qRound64(rowCount / seconds) << "rows/s,"
+                 << megabytes / seconds << "MB/s";
+    }
+}
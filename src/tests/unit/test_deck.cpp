@@ -1,6 +1,7 @@
 #include <QtTest/QtTest>
 #include "TestDeck.h"
 #include "Deck.h"
+#include "AllocationCounter.h"
 
 TestDeck::TestDeck() {}
 
@@ -668,39 +669,455 @@ void TestDeck::testGetDueCardsOrder()
     QCOMPARE(dueCards[2].getId(), 3);
 }
 
-void TestDeck::testGetDueCardsPerformance()
+// ==================== DUE INDEX TESTS ====================
+
+void TestDeck::testAddCardUpdatesDueIndex()
+{
+    Deck deck;
+    QDateTime now = QDateTime::currentDateTime();
+
+    deck.addCard(Card(1, "Q1", "A1", ContentType::Text, TestMode::DirectAnswer,
+                      2.5f, 1, 0, now.addDays(1), now, 1));
+    QCOMPARE(deck.getCardCount(), 1);
+    QCOMPARE(deck.getDueCount(), 0);
+
+    deck.addCard(Card(2, "Q2", "A2", ContentType::Text, TestMode::DirectAnswer,
+                      2.5f, 1, 0, now.addDays(-1), now.addDays(-2), 1));
+    deck.addCard(Card(3, "Q3", "A3", ContentType::Text, TestMode::DirectAnswer,
+                      2.5f, 1, 0, QDateTime(), QDateTime(), 1));
+    QCOMPARE(deck.getCardCount(), 3);
+    QCOMPARE(deck.getDueCount(), 2);
+
+    QList<Card> dueCards = deck.getDueCards();
+    QCOMPARE(dueCards.size(), 2);
+    QCOMPARE(dueCards[0].getId(), 2);
+    QCOMPARE(dueCards[1].getId(), 3);
+}
+
+void TestDeck::testRemoveCardUpdatesDueIndex()
+{
+    Deck deck;
+    QDateTime now = QDateTime::currentDateTime();
+
+    for (int i = 0; i < 6; i++) {
+        // Четные карточки просрочены, нечетные - в будущем
+        deck.addCard(Card(i + 1, QString("Q%1").arg(i), QString("A%1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 1, 0, (i % 2 == 0) ? now.addDays(-1) : now.addDays(1),
+                          now, 1));
+    }
+    QCOMPARE(deck.getDueCount(), 3);
+
+    QVERIFY(deck.removeCard(1));
+    QCOMPARE(deck.getCardCount(), 5);
+    QCOMPARE(deck.getDueCount(), 2);
+
+    QVERIFY(deck.removeCard(4));
+    QCOMPARE(deck.getDueCount(), 2);
+
+    // Позиции после удалений сдвинулись - проверяем, что индекс указывает на верные карточки
+    QList<Card> dueCards = deck.getDueCards();
+    QCOMPARE(dueCards.size(), 2);
+    QCOMPARE(dueCards[0].getId(), 3);
+    QCOMPARE(dueCards[1].getId(), 5);
+
+    QVERIFY(!deck.removeCard(42));
+    QCOMPARE(deck.getCardCount(), 4);
+}
+
+void TestDeck::testReviewCardReschedules()
 {
-    // Тест производительности для большой колоды
     Deck deck;
     QList<Card> cards;
     QDateTime now = QDateTime::currentDateTime();
 
-    const int LARGE_COUNT = 10000;
+    for (int i = 0; i < 4; i++) {
+        cards.append(Card(i + 1, QString("Q%1").arg(i), QString("A%1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 1, 0, now.addDays(-1), now.addDays(-2), 1));
+    }
+    deck.setCards(cards);
+    QCOMPARE(deck.getDueCount(), 4);
+
+    // Успешный ответ переносит карточку на завтра
+    QVERIFY(deck.reviewCard(2, 5));
+    QCOMPARE(deck.getDueCount(), 3);
+
+    QList<Card> dueCards = deck.getDueCards();
+    for (const Card& card : dueCards) {
+        QVERIFY(card.getId() != 2);
+    }
+
+    // Состояние SM2 сохранено внутри колоды
+    const Card reviewed = deck.getCards()[1];
+    QCOMPARE(reviewed.getId(), 2);
+    QCOMPARE(reviewed.getRepetitions(), 1);
+    QCOMPARE(reviewed.getIntervalDays(), 1);
+    QVERIFY(reviewed.getNextReview() > now);
+}
+
+void TestDeck::testReviewCardUnknownId()
+{
+    Deck deck;
+    deck.setCards(*testCards);
+    const int dueBefore = deck.getDueCount();
+
+    QVERIFY(!deck.reviewCard(12345, 5));
+    QCOMPARE(deck.getDueCount(), dueBefore);
+}
+
+void TestDeck::testApplyGradesReschedules()
+{
+    Deck deck;
+    QList<Card> cards;
+    QDateTime now = QDateTime::currentDateTime();
+
+    for (int i = 0; i < 6; i++) {
+        cards.append(Card(i + 1, QString("Q%1").arg(i), QString("A%1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 1, 0, now.addDays(-1), now.addDays(-2), 1));
+    }
+    deck.setCards(cards);
+    QCOMPARE(deck.getDueCount(), 6);
+
+    // Неизвестный идентификатор пропускается, провал оставляет карточку на завтра
+    const QList<CardGrade> grades = {{2, 5}, {999, 5}, {4, 4}, {5, 1}};
+    QCOMPARE(deck.applyGrades(grades, now), 3);
+    QCOMPARE(deck.getDueCount(), 3);
+    QCOMPARE(deck.getDueCards().size(), 3);
+
+    const QList<Card> after = deck.getCards();
+    QCOMPARE(after[1].getRepetitions(), 1);
+    QCOMPARE(after[1].getLastReview(), now);
+    QCOMPARE(after[1].getNextReview(), now.addDays(1));
+    QCOMPARE(after[4].getRepetitions(), 0);
+    QCOMPARE(after[0].getRepetitions(), 0);
+
+    QCOMPARE(deck.applyGrades({}, now), 0);
+    QCOMPARE(deck.applyGrades({{999, 5}}, now), 0);
+}
+
+void TestDeck::testApplyGradesMatchesReviewCard()
+{
+    // Малый пакет (точечное обновление индекса) и большой (перестроение)
+    for (int batchSize : {3, 200}) {
+        QList<Card> cards;
+        QDateTime now = QDateTime::currentDateTime();
+        for (int i = 0; i < 400; i++) {
+            cards.append(Card(i, QString("Q%1").arg(i), QString("A%1").arg(i),
+                              ContentType::Text, TestMode::DirectAnswer,
+                              2.0f, 2, i % 3, now.addSecs(-i), now.addDays(-3), 1));
+        }
+
+        Deck batched;
+        batched.setCards(cards);
+        Deck sequential;
+        sequential.setCards(cards);
+
+        QList<CardGrade> grades;
+        for (int i = 0; i < batchSize; i++) {
+            // Повторные оценки одной карточки идут подряд по порядку списка
+            grades.append(CardGrade{(i * 7) % 50, i % 6});
+        }
+
+        QCOMPARE(batched.applyGrades(grades, now), batchSize);
+        for (const CardGrade &entry : grades) {
+            sequential.reviewCard(entry.cardId, entry.grade);
+        }
+
+        const QList<Card> batchedCards = batched.getCards();
+        const QList<Card> sequentialCards = sequential.getCards();
+        for (int i = 0; i < batchedCards.size(); i++) {
+            QCOMPARE(batchedCards[i].getEasyFactor(), sequentialCards[i].getEasyFactor());
+            QCOMPARE(batchedCards[i].getIntervalDays(), sequentialCards[i].getIntervalDays());
+            QCOMPARE(batchedCards[i].getRepetitions(), sequentialCards[i].getRepetitions());
+        }
+
+        // Индекс согласован с пересчитанными датами
+        int expectedDue = 0;
+        const qint64 nowMSecs = QDateTime::currentMSecsSinceEpoch();
+        for (const CardRef &card : batched.getCardsView()) {
+            if (!card.getNextReview().isValid() || card.getNextReview().toMSecsSinceEpoch() <= nowMSecs) {
+                expectedDue++;
+            }
+        }
+        QCOMPARE(batched.getDueCount(), expectedDue);
+        QCOMPARE(batched.getDueCards().size(), expectedDue);
+    }
+}
+
+// ==================== VIEW TESTS ====================
+
+void TestDeck::testGetCardsViewNoCopy()
+{
+    testDeck->setCards(*testCards);
+
+    CardSpan view = testDeck->getCardsView();
+    QCOMPARE(view.size(), 3);
+    QVERIFY(!view.isEmpty());
+    QCOMPARE(view[0].getId(), 1);
+    QCOMPARE(view[2].getQuestion(), QString("2 + 2?"));
+
+    // Элементы представления - дескрипторы строк хранилища колоды
+    QCOMPARE(view[1].row(), 1);
+    QCOMPARE(view[1].getNextReview(), testCards->at(1).getNextReview());
+    QCOMPARE(view[1].toCard().getAnswer(), QString("Париж"));
+
+    Deck empty;
+    QVERIFY(empty.getCardsView().isEmpty());
+    QVERIFY(empty.getDueCardsView().isEmpty());
+}
+
+void TestDeck::testGetDueCardsViewOrder()
+{
+    Deck deck;
+    QDateTime now = QDateTime::currentDateTime();
+
+    deck.addCard(Card(1, "Q1", "A1", ContentType::Text, TestMode::DirectAnswer,
+                      2.0f, 1, 0, now.addSecs(-60), now.addDays(-1), 1));
+    deck.addCard(Card(2, "Q2", "A2", ContentType::Text, TestMode::DirectAnswer,
+                      2.0f, 1, 0, now.addDays(1), now, 1));
+    deck.addCard(Card(3, "Q3", "A3", ContentType::Text, TestMode::DirectAnswer,
+                      2.0f, 1, 0, now.addDays(-10), now.addDays(-11), 1));
+    deck.addCard(Card(4, "Q4", "A4", ContentType::Text, TestMode::DirectAnswer,
+                      2.0f, 1, 0, QDateTime(), QDateTime(), 1));
+
+    DueCardRange due = deck.getDueCardsView();
+    QCOMPARE(due.size(), 3);
+
+    // Сначала карточка без даты, затем по степени просроченности
+    QList<int> ids;
+    for (const CardRef &card : due) {
+        ids.append(card.getId());
+    }
+    QCOMPARE(ids, QList<int>({4, 3, 1}));
+    QCOMPARE(due.front().getId(), 4);
+
+    // Элементы представления указывают на строки колоды, а не на копии
+    CardSpan all = deck.getCardsView();
+    for (auto it = due.begin(); it != due.end(); ++it) {
+        QCOMPARE((*it).row(), it.row());
+        QCOMPARE((*it).getId(), all[it.row()].getId());
+    }
+}
+
+void TestDeck::testGetDueCardsViewMatchesCopy()
+{
+    Deck deck;
+    QList<Card> cards;
+    QDateTime now = QDateTime::currentDateTime();
+
+    for (int i = 0; i < 50; i++) {
+        cards.append(Card(i, QString("Q%1").arg(i), QString("A%1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.0f, 1, 0, now.addSecs((i % 7 - 3) * 3600), now, 1));
+    }
+    deck.setCards(cards);
 
-    for (int i = 0; i < LARGE_COUNT; i++) {
+    QList<int> viewIds;
+    for (const CardRef &card : deck.getDueCardsView()) {
+        viewIds.append(card.getId());
+    }
+    std::sort(viewIds.begin(), viewIds.end());
+
+    QList<int> copyIds;
+    for (const Card &card : deck.getDueCards()) {
+        copyIds.append(card.getId());
+    }
+
+    QCOMPARE(viewIds, copyIds);
+    QCOMPARE(static_cast<int>(viewIds.size()), deck.getDueCount());
+}
+
+// ==================== PERFORMANCE TESTS ====================
+
+namespace {
+
+/**
+ * @brief Колоды из миллиона карточек строятся только по запросу
+ *
+ * Установите переменную окружения QTCARDS_LARGE_BENCH, чтобы включить
+ * самые тяжелые строки бенчмарков.
+ */
+bool largeBenchmarksEnabled()
+{
+    return qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH");
+}
+
+void addPerformanceRows()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+Deck makePerformanceDeck(int count)
+{
+    QList<Card> cards;
+    cards.reserve(count);
+    QDateTime now = QDateTime::currentDateTime();
+
+    for (int i = 0; i < count; i++) {
         // Каждая 5-я карточка просрочена
         bool isDue = (i % 5 == 0);
-        Card card(i,
-                  QString("Perf Q%1").arg(i),
-                  QString("Perf A%1").arg(i),
-                  ContentType::Text,
-                  TestMode::DirectAnswer,
-                  2.0f,
-                  1,
-                  0,
-                  isDue ? now.addDays(-1) : now.addDays(1),
-                  now,
-                  1);
-        cards.append(card);
+        cards.append(Card(i,
+                          QString("Perf Q%1").arg(i),
+                          QString("Perf A%1").arg(i),
+                          ContentType::Text,
+                          TestMode::DirectAnswer,
+                          2.0f,
+                          1,
+                          0,
+                          isDue ? now.addDays(-1) : now.addDays(1),
+                          now,
+                          1));
     }
 
-    deck.setCards(cards);
+    Deck deck;
+    deck.setCards(std::move(cards));
+    return deck;
+}
+
+} // namespace
+
+void TestDeck::testGetDueCardsPerformance_data()
+{
+    addPerformanceRows();
+}
+
+void TestDeck::testGetDueCardsPerformance()
+{
+    // Тест производительности для большой колоды
+    QFETCH(int, cardCount);
+    if (cardCount > 100000 && !largeBenchmarksEnabled()) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    Deck deck = makePerformanceDeck(cardCount);
 
     QBENCHMARK {
         QList<Card> dueCards = deck.getDueCards();
     }
 
     // Проверяем правильность
-    int expectedDue = LARGE_COUNT / 5; // 2000
+    int expectedDue = (cardCount + 4) / 5;
     QCOMPARE(deck.getDueCount(), expectedDue);
+    QCOMPARE(deck.getDueCards().size(), expectedDue);
+}
+
+void TestDeck::testGetDueCountPerformance_data()
+{
+    addPerformanceRows();
+}
+
+void TestDeck::testGetDueCountPerformance()
+{
+    QFETCH(int, cardCount);
+    if (cardCount > 100000 && !largeBenchmarksEnabled()) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    Deck deck = makePerformanceDeck(cardCount);
+    int dueCount = 0;
+
+    QBENCHMARK {
+        dueCount = deck.getDueCount();
+    }
+
+    QCOMPARE(dueCount, (cardCount + 4) / 5);
+}
+
+void TestDeck::testDueCardsViewPerformance_data()
+{
+    addPerformanceRows();
+}
+
+void TestDeck::testDueCardsViewPerformance()
+{
+    QFETCH(int, cardCount);
+    if (cardCount > 100000 && !largeBenchmarksEnabled()) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    Deck deck = makePerformanceDeck(cardCount);
+    const int expectedDue = (cardCount + 4) / 5;
+
+    // До: копирующий getDueCards()
+    quint64 copyAllocations = 0;
+    {
+        AllocationCounter::Scope scope;
+        QList<Card> dueCards = deck.getDueCards();
+        copyAllocations = scope.allocations();
+        QCOMPARE(static_cast<int>(dueCards.size()), expectedDue);
+    }
+
+    // После: обход ленивого диапазона
+    quint64 viewAllocations = 0;
+    qint64 checksum = 0;
+    {
+        AllocationCounter::Scope scope;
+        for (const CardRef &card : deck.getDueCardsView()) {
+            checksum += card.getId();
+        }
+        viewAllocations = scope.allocations();
+    }
+
+    qDebug() << "Due cards:" << expectedDue
+             << "allocations getDueCards():" << copyAllocations
+             << "getDueCardsView():" << viewAllocations;
+
+    QCOMPARE(viewAllocations, quint64(0));
+    QVERIFY(checksum > 0);
+
+    QBENCHMARK {
+        int walked = 0;
+        for (const CardRef &card : deck.getDueCardsView()) {
+            walked += card.getRepetitions() + 1;
+        }
+        QVERIFY(walked > 0);
+    }
+}
+
+void TestDeck::testApplyGradesPerformance_data()
+{
+    QTest::addColumn<int>("cardCount");
+    QTest::addColumn<bool>("batched");
+
+    QTest::newRow("reviewCard 100k") << 100000 << false;
+    QTest::newRow("applyGrades 100k") << 100000 << true;
+    QTest::newRow("reviewCard 1M") << 1000000 << false;
+    QTest::newRow("applyGrades 1M") << 1000000 << true;
+}
+
+void TestDeck::testApplyGradesPerformance()
+{
+    // Пересчет расписания: по одной оценке на каждую карточку колоды
+    QFETCH(int, cardCount);
+    QFETCH(bool, batched);
+    if (cardCount > 100000 && !largeBenchmarksEnabled()) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    Deck deck = makePerformanceDeck(cardCount);
+    QList<CardGrade> grades;
+    grades.reserve(cardCount);
+    for (int i = 0; i < cardCount; i++) {
+        grades.append(CardGrade{i, i % 6});
+    }
+    const QDateTime now = QDateTime::currentDateTime();
+
+    QBENCHMARK_ONCE {
+        if (batched) {
+            QCOMPARE(deck.applyGrades(grades, now), cardCount);
+        } else {
+            for (const CardGrade &entry : grades) {
+                deck.reviewCard(entry.cardId, entry.grade);
+            }
+        }
+    }
+
+    // Провал (оценка 0-2) переносит карточку на завтра, поэтому готовых нет
+    QCOMPARE(deck.getDueCount(), 0);
 }
@@ -0,0 +1,310 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <memory>
+#include "TestDeckBuilder.h"
+#include "AllocationCounter.h"
+#include "DeckBuilder.h"
+#include "Deck.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+Card makeCard(int i)
+{
+    const QDateTime next = i % 4 == 0 ? QDateTime() : kNow.addSecs(qint64(i % 200) * 3600 - 48 * 3600);
+    const QDateTime last = i % 3 == 0 ? QDateTime() : kNow.addDays(-(i % 10));
+    return Card(i + 1, QString("Вопрос %1").arg(i), i % 7 == 0 ? QString() : QString("Ответ %1").arg(i),
+                i % 5 == 0 ? ContentType::Image : ContentType::Text,
+                i % 2 == 0 ? TestMode::DirectAnswer : TestMode::MultipleChoice,
+                1.3f + float(i % 13) * 0.1f, i % 30, i % 6, next, last, 1 + i % 2);
+}
+
+void compareRows(const Deck &actual, const Deck &expected)
+{
+    QCOMPARE(actual.getCardCount(), expected.getCardCount());
+    const CardSpan a = actual.getCardsView();
+    const CardSpan e = expected.getCardsView();
+    for (int row = 0; row < e.size(); row++) {
+        QCOMPARE(a[row].getId(), e[row].getId());
+        QCOMPARE(a[row].getQuestion(), e[row].getQuestion());
+        QCOMPARE(a[row].getAnswer(), e[row].getAnswer());
+        QCOMPARE(a[row].getContentType(), e[row].getContentType());
+        QCOMPARE(a[row].getTestMode(), e[row].getTestMode());
+        QCOMPARE(a[row].getEasyFactor(), e[row].getEasyFactor());
+        QCOMPARE(a[row].getIntervalDays(), e[row].getIntervalDays());
+        QCOMPARE(a[row].getRepetitions(), e[row].getRepetitions());
+        QCOMPARE(a[row].getNextReviewMSecs(), e[row].getNextReviewMSecs());
+        QCOMPARE(a[row].getLastReviewMSecs(), e[row].getLastReviewMSecs());
+        QCOMPARE(a[row].getDeckId(), e[row].getDeckId());
+    }
+}
+
+/**
+ * @brief Текст карточки в UTF-8, как его отдает разбор файла
+ */
+int formatText(char *buffer, size_t size, const char *prefix, int i)
+{
+    return std::snprintf(buffer, size, "%s %d", prefix, i);
+}
+
+} // namespace
+
+// ==================== ARENA ====================
+
+void TestDeckBuilder::testArena()
+{
+    TextArena arena(256);
+    QCOMPARE(arena.blockCount(), 0);
+    QVERIFY(arena.add(QStringView()).isEmpty());
+    QVERIFY(arena.addUtf8(QByteArrayView()).isEmpty());
+    QCOMPARE(arena.blockCount(), 0);
+
+    const QString question = arena.add(QString("Вопрос"));
+    QCOMPARE(question, QString("Вопрос"));
+    QCOMPARE(arena.blockCount(), 1);
+    QCOMPARE(arena.bytesReserved(), qint64(256 * 2));
+    QCOMPARE(arena.bytesUsed(), qint64(6 * 2));
+
+    // UTF-8 занимает больше байт, чем символов: хвост возвращается буферу
+    const QByteArray utf8 = QString("Ответ ответ").toUtf8();
+    const QString answer = arena.addUtf8(utf8);
+    QCOMPARE(answer, QString("Ответ ответ"));
+    QCOMPARE(arena.bytesUsed(), qint64((6 + 11) * 2));
+
+    // Строки лежат подряд в одном блоке
+    QCOMPARE(answer.constData(), question.constData() + question.size());
+
+    // Длинная строка получает свой блок, текущий продолжает заполняться
+    const QString longText(100, QChar('x'));
+    QCOMPARE(arena.add(longText), longText);
+    QCOMPARE(arena.blockCount(), 2);
+    const QString next = arena.add(QString("Дальше"));
+    QCOMPARE(next.constData(), answer.constData() + answer.size());
+    QCOMPARE(arena.blockCount(), 2);
+    QCOMPARE(arena.bytesReserved(), qint64((256 + 100) * 2));
+
+    // Заполненный блок сменяется новым, прежние строки не меняются
+    for (int i = 0; i < 100; i++) {
+        QCOMPARE(arena.add(QString("Строка %1").arg(i)), QString("Строка %1").arg(i));
+    }
+    QVERIFY(arena.blockCount() > 2);
+    QCOMPARE(question, QString("Вопрос"));
+    QCOMPARE(answer, QString("Ответ ответ"));
+}
+
+// ==================== BUILD ====================
+
+void TestDeckBuilder::testBuildMatchesSetCards()
+{
+    constexpr int kCards = 3000;
+    FixedClock clock(kNow);
+
+    QList<Card> cards;
+    for (int i = 0; i < kCards; i++) {
+        cards.append(makeCard(i));
+    }
+    Deck expected;
+    expected.setClock(&clock);
+    expected.setCards(cards);
+
+    // Три способа добавления дают одинаковые строки
+    DeckBuilder builder(kCards, 1024);
+    for (int i = 0; i < kCards; i++) {
+        const Card &card = cards[i];
+        if (i % 3 == 0) {
+            QCOMPARE(builder.add(card), i);
+            continue;
+        }
+        DeckBuilder::Row row;
+        row.id = card.getId();
+        row.deckId = card.getDeckId();
+        row.contentType = card.getContentType();
+        row.testMode = card.getTestMode();
+        row.easyFactor = card.getEasyFactor();
+        row.intervalDays = card.getIntervalDays();
+        row.repetitions = card.getRepetitions();
+        row.nextReview = CardStore::toEpochMSecs(card.getNextReview());
+        row.lastReview = CardStore::toEpochMSecs(card.getLastReview());
+        if (i % 3 == 1) {
+            QCOMPARE(builder.add(row, card.getQuestion(), card.getAnswer()), i);
+        } else {
+            QCOMPARE(builder.addUtf8(row, card.getQuestion().toUtf8(), card.getAnswer().toUtf8()), i);
+        }
+    }
+    QCOMPARE(builder.size(), kCards);
+    QVERIFY(builder.arena().blockCount() > 1);
+
+    Deck built;
+    built.setClock(&clock);
+    built.addCard(makeCard(99999));
+    builder.build(built);
+    compareRows(built, expected);
+    QCOMPARE(built.getDueCount(), expected.getDueCount());
+    QCOMPARE(built.indexOf(1234), expected.indexOf(1234));
+    QCOMPARE(built.indexOf(100000), -1);
+
+    // Построитель пуст и собирает следующую колоду заново
+    QCOMPARE(builder.size(), 0);
+    QCOMPARE(builder.arena().blockCount(), 0);
+    builder.add(makeCard(1));
+    Deck second;
+    builder.build(second);
+    QCOMPARE(second.getCardCount(), 1);
+    QCOMPARE(built.getCardCount(), kCards);
+}
+
+void TestDeckBuilder::testLifetime()
+{
+    DeckBuilder builder;
+    for (int i = 0; i < 100; i++) {
+        builder.add(makeCard(i));
+    }
+    auto deck = std::make_unique<Deck>();
+    builder.build(*deck);
+
+    // Карточка и строки геттеров держат свои копии текста, копия колоды - буфер
+    const Card card = deck->getCardsView()[42].toCard();
+    const QList<Card> cards = deck->getCards();
+    const QString question = deck->getCardsView()[5].getQuestion();
+    const CardContent content = deck->getContent(9);
+    QCOMPARE(deck->getCardsView()[5].questionView(), QStringView(u"Вопрос 5"));
+    Deck copy = *deck;
+    deck.reset();
+
+    QCOMPARE(card.getQuestion(), QString("Вопрос 42"));
+    QVERIFY(cards[7].getAnswer().isEmpty());
+    QCOMPARE(cards[8].getAnswer(), QString("Ответ 8"));
+    QCOMPARE(copy.getCardsView()[99].getQuestion(), QString("Вопрос 99"));
+
+    copy = Deck();
+    QCOMPARE(card.getAnswer(), QString("Ответ 42"));
+    QCOMPARE(cards[99].getQuestion(), QString("Вопрос 99"));
+    QCOMPARE(question, QString("Вопрос 5"));
+    QCOMPARE(content.question, QString("Вопрос 8"));
+    QCOMPARE(content.answer, QString("Ответ 8"));
+}
+
+void TestDeckBuilder::testModifyAfterBuild()
+{
+    FixedClock clock(kNow);
+    DeckBuilder builder;
+    for (int i = 0; i < 500; i++) {
+        builder.add(makeCard(i));
+    }
+    Deck deck;
+    deck.setClock(&clock);
+    builder.build(deck);
+    const int due = deck.getDueCount();
+
+    QVERIFY(deck.reviewCard(1, 5));
+    QCOMPARE(deck.getDueCount(), due - 1);
+
+    Card changed = deck.getCardsView()[deck.indexOf(10)].toCard();
+    changed.setQuestion("Новый вопрос");
+    QVERIFY(deck.updateCard(changed));
+    QCOMPARE(deck.getCardsView()[deck.indexOf(10)].getQuestion(), QString("Новый вопрос"));
+
+    deck.addCard(makeCard(1000));
+    QVERIFY(deck.removeCard(20));
+    QCOMPARE(deck.getCardCount(), 500);
+    QCOMPARE(deck.getCardsView()[deck.indexOf(11)].getQuestion(), QString("Вопрос 10"));
+    QCOMPARE(deck.getCardsView()[deck.indexOf(1001)].getQuestion(), QString("Вопрос 1000"));
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestDeckBuilder::testConstructionAndTeardown_data()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("200k") << 200000;
+    QTest::newRow("1M") << 1000000;
+}
+
+/**
+ * @brief Сборка и уничтожение: QList<Card> против DeckBuilder
+ *
+ * Оба пути получают текст в UTF-8, как после разбора файла. QList<Card>
+ * выделяет по буферу на каждый вопрос и ответ; DeckBuilder пишет текст
+ * в блоки TextArena и дополнительно строит индексы колоды.
+ */
+void TestDeckBuilder::testConstructionAndTeardown()
+{
+    QFETCH(int, cardCount);
+    if (cardCount > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    const qint64 now = kNow.toMSecsSinceEpoch();
+    char question[64];
+    char answer[64];
+    QElapsedTimer timer;
+
+    // QList<Card>: отдельные QString и QDateTime у каждой карточки
+    QList<Card> cards;
+    quint64 listAllocations = 0;
+    timer.start();
+    {
+        AllocationCounter::Scope scope;
+        cards.reserve(cardCount);
+        for (int i = 0; i < cardCount; i++) {
+            const int q = formatText(question, sizeof(question), "Вопрос", i);
+            const int a = formatText(answer, sizeof(answer), "Ответ", i);
+            cards.append(Card(i + 1, QString::fromUtf8(question, q), QString::fromUtf8(answer, a),
+                              ContentType::Text, TestMode::DirectAnswer, 2.5f, i % 30, i % 5,
+                              CardStore::fromEpochMSecs(now + qint64(i % 1000) * 60000), QDateTime(), 1));
+        }
+        listAllocations = scope.allocations();
+    }
+    const qint64 listBuild = timer.nsecsElapsed();
+    {
+        QList<Card> doomed = std::move(cards);
+        timer.start();
+    }
+    const qint64 listTeardown = timer.nsecsElapsed();
+
+    // DeckBuilder: столбцы и буфер текста
+    auto deck = std::make_unique<Deck>();
+    quint64 arenaAllocations = 0;
+    timer.start();
+    {
+        AllocationCounter::Scope scope;
+        DeckBuilder builder(cardCount);
+        DeckBuilder::Row row;
+        row.deckId = 1;
+        for (int i = 0; i < cardCount; i++) {
+            const int q = formatText(question, sizeof(question), "Вопрос", i);
+            const int a = formatText(answer, sizeof(answer), "Ответ", i);
+            row.id = i + 1;
+            row.intervalDays = i % 30;
+            row.repetitions = i % 5;
+            row.nextReview = now + qint64(i % 1000) * 60000;
+            builder.addUtf8(row, QByteArrayView(question, q), QByteArrayView(answer, a));
+        }
+        builder.build(*deck);
+        arenaAllocations = scope.allocations();
+    }
+    const qint64 arenaBuild = timer.nsecsElapsed();
+    QCOMPARE(deck->getCardCount(), cardCount);
+    QCOMPARE(deck->getCardsView()[cardCount - 1].getAnswer(), QString("Ответ %1").arg(cardCount - 1));
+    {
+        std::unique_ptr<Deck> doomed = std::move(deck);
+        timer.start();
+    }
+    const qint64 arenaTeardown = timer.nsecsElapsed();
+
+    qDebug() << "Cards:" << cardCount
+             << "build QList<Card>:" << listBuild / 1000000 << "ms" << listAllocations << "allocations,"
+             << "DeckBuilder:" << arenaBuild / 1000000 << "ms" << arenaAllocations << "allocations;"
+             << "teardown QList<Card>:" << listTeardown / 1000 << "us,"
+             << "Deck:" << arenaTeardown / 1000 << "us";
+
+    // Без QTCARDS_COUNT_ALLOCATIONS выделения QString и QList не видны счетчику
+    if (AllocationCounter::countsQtAllocations()) {
+        QVERIFY(arenaAllocations * 20 < listAllocations);
+    }
+    QVERIFY(arenaTeardown < listTeardown);
+}
@@ -0,0 +1,32 @@
+#include "TestDecks.h"
+
+const QDateTime TestDecks::kNow = QDateTime(QDate(2024, 3, 15), QTime(14, 30));
+
+Card TestDecks::textCard(int id, int i, const QDateTime &nextReview, int deckId,
+                         int intervalDays, int repetitions)
+{
+    return Card(id, QString("Вопрос %1").arg(i), QString("Ответ %1").arg(i),
+                ContentType::Text, TestMode::DirectAnswer,
+                2.5f, intervalDays, repetitions, nextReview, QDateTime(), deckId);
+}
+
+Deck TestDecks::makeDeck(int deckId, int count, const DueDate &dueDate, const Clock *clock)
+{
+    return buildDeck(deckId, count, [deckId, &dueDate](int i) {
+        return textCard(deckId * 1000000 + i, i, dueDate(i), deckId);
+    }, clock);
+}
+
+Deck TestDecks::buildDeck(int deckId, int count, const CardFactory &makeCard, const Clock *clock)
+{
+    QList<Card> cards;
+    cards.reserve(count);
+    for (int i = 0; i < count; i++) {
+        cards.append(makeCard(i));
+    }
+    Deck deck;
+    deck.setId(deckId);
+    deck.setClock(clock);
+    deck.setCards(std::move(cards));
+    return deck;
+}
@@ -0,0 +1,265 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include "TestDueCountCache.h"
+#include "DueCountCache.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/**
+ * @brief Колода со сроками от двух суток назад до двух суток вперед
+ */
+Deck makeDeck(int deckId, int count, const Clock *clock)
+{
+    return TestDecks::makeDeck(deckId, count, [deckId](int i) {
+        const qint64 offsetSecs = ((qint64(i) * 7919 + deckId * 104729) % 345600) - 172800;
+        return i % 10 == 0 ? QDateTime() : kNow.addSecs(offsetSecs);
+    }, clock);
+}
+
+void compareCounts(DueCountCache &cache, const QList<Deck> &decks)
+{
+    const QList<int> counts = cache.dueCounts();
+    QCOMPARE(counts.size(), decks.size());
+    int total = 0;
+    for (int i = 0; i < decks.size(); i++) {
+        QCOMPARE(counts[i], decks[i].getDueCount());
+        total += counts[i];
+    }
+    QCOMPARE(cache.totalDueCount(), total);
+}
+
+} // namespace
+
+// ==================== COUNTS ====================
+
+void TestDueCountCache::testMatchesDeckCounts()
+{
+    FixedClock clock(kNow);
+    QList<Deck> decks = {makeDeck(1, 2000, &clock), makeDeck(2, 500, &clock), makeDeck(3, 0, &clock)};
+    DueCountCache cache(&clock);
+    for (Deck &deck : decks) {
+        cache.addDeck(&deck);
+    }
+    cache.addDeck(&decks[0]);
+    QCOMPARE(cache.deckCount(), 3);
+
+    compareCounts(cache, decks);
+    QCOMPARE(cache.stats().misses, qint64(3));
+
+    // Время идет: счетчики растут по шкале, без пересчета колод
+    cache.resetStats();
+    for (int step = 0; step < 50; step++) {
+        clock.advance(17 * 60 * 1000);
+        compareCounts(cache, decks);
+    }
+    QCOMPARE(cache.stats().misses, qint64(0));
+    QVERIFY(cache.stats().crossings > 0);
+    QVERIFY(cache.nextChangeAt() > cache.now());
+
+    // Выход за горизонт и шаг назад перестраивают шкалу
+    clock.advanceDays(2);
+    compareCounts(cache, decks);
+    clock.setNow(kNow);
+    compareCounts(cache, decks);
+    QCOMPARE(cache.stats().rebuilds, qint64(2));
+
+    Deck detached = makeDeck(4, 100, &clock);
+    QCOMPARE(cache.dueCount(&detached), detached.getDueCount());
+}
+
+void TestDueCountCache::testIncrementalUpdates()
+{
+    FixedClock clock(kNow);
+    QList<Deck> decks = {makeDeck(1, 3000, &clock), makeDeck(2, 3000, &clock)};
+    DueCountCache cache(&clock);
+    cache.addDeck(&decks[0]);
+    cache.addDeck(&decks[1]);
+    compareCounts(cache, decks);
+    cache.resetStats();
+
+    // Ответы на готовые карточки
+    for (int i = 0; i < 100; i++) {
+        const int cardId = decks[0].getDueCardsView().front().getId();
+        QVERIFY(decks[0].reviewCard(cardId, i % 6));
+        QCOMPARE(cache.dueCount(&decks[0]), decks[0].getDueCount());
+    }
+
+    // Небольшой пакет оценок переносит карточки по одной
+    QList<CardGrade> grades;
+    for (int i = 0; i < 50; i++) {
+        grades.append(CardGrade{2000000 + i * 37, 4});
+    }
+    QCOMPARE(decks[1].applyGrades(grades), 50);
+
+    // Правка срока: карточка из будущего становится готовой и наоборот
+    Card card = decks[1].getCards()[1];
+    card.setNextReview(kNow.addSecs(-10));
+    QVERIFY(decks[1].updateCard(card));
+    card = decks[1].getCards()[3];
+    card.setNextReview(kNow.addSecs(3600));
+    QVERIFY(decks[1].updateCard(card));
+
+    decks[1].addCard(Card(2999999, "новая", "карточка", ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 0, 0, QDateTime(), QDateTime(), 2));
+    decks[1].addCard(Card(2999998, "будущая", "карточка", ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 1, 1, kNow.addSecs(600), QDateTime(), 2));
+    QVERIFY(decks[1].removeCard(2000005));
+    QVERIFY(decks[1].removeCard(2000006));
+
+    compareCounts(cache, decks);
+    QCOMPARE(cache.stats().misses, qint64(0));
+    QVERIFY(cache.stats().updates >= 100 + 50 + 2 + 2 + 2);
+
+    // Изменения продолжают учитываться при движении времени
+    clock.advance(3600 * 1000 + 1);
+    compareCounts(cache, decks);
+    QCOMPARE(cache.stats().misses, qint64(0));
+}
+
+void TestDueCountCache::testBulkChangesInvalidate()
+{
+    FixedClock clock(kNow);
+    QList<Deck> decks = {makeDeck(1, 1000, &clock), makeDeck(2, 1000, &clock)};
+    DueCountCache cache(&clock);
+    cache.addDeck(&decks[0]);
+    cache.addDeck(&decks[1]);
+    compareCounts(cache, decks);
+    cache.resetStats();
+
+    // Замена карточек сбрасывает только запись своей колоды
+    decks[0].setCards(makeDeck(1, 300, &clock).getCards());
+    compareCounts(cache, decks);
+    QCOMPARE(cache.stats().misses, qint64(1));
+    QCOMPARE(cache.stats().hits, qint64(3));
+
+    decks[1].addCards(makeDeck(5, 200, &clock).getCards());
+    QList<CardGrade> grades;
+    for (const CardRef &card : decks[0].getCardsView()) {
+        grades.append(CardGrade{card.getId(), 5});
+    }
+    QCOMPARE(decks[0].applyGrades(grades), 300);
+    compareCounts(cache, decks);
+    QCOMPARE(decks[0].getDueCount(), 0);
+    QCOMPARE(cache.stats().misses, qint64(3));
+}
+
+void TestDueCountCache::testRemoveDeck()
+{
+    FixedClock clock(kNow);
+    QList<Deck> decks = {makeDeck(1, 500, &clock), makeDeck(2, 500, &clock), makeDeck(3, 500, &clock)};
+    {
+        DueCountCache cache(&clock);
+        for (Deck &deck : decks) {
+            cache.addDeck(&deck);
+        }
+        compareCounts(cache, decks);
+
+        cache.removeDeck(&decks[0]);
+        QCOMPARE(cache.deckCount(), 2);
+        // Отключенная колода больше не уведомляет кэш
+        QVERIFY(decks[0].removeCard(1000001));
+
+        const QList<Deck> rest = {decks[1], decks[2]};
+        for (int step = 0; step < 10; step++) {
+            clock.advance(2 * 3600 * 1000);
+            const QList<int> counts = cache.dueCounts();
+            QCOMPARE(counts, QList<int>({rest[0].getDueCount(), rest[1].getDueCount()}));
+        }
+    }
+    // Уничтоженный кэш отключился от колод
+    QVERIFY(decks[1].removeCard(2000001));
+}
+
+// ==================== TIME ====================
+
+void TestDueCountCache::testTimerNotifies()
+{
+    FixedClock clock(kNow);
+    Deck deck;
+    deck.setId(1);
+    deck.setClock(&clock);
+    deck.setCards({Card(1, "скоро", "", ContentType::Text, TestMode::DirectAnswer,
+                        2.5f, 1, 1, kNow.addMSecs(100), QDateTime(), 1)});
+
+    DueCountCache cache(&clock);
+    cache.addDeck(&deck);
+    int notifications = 0;
+    cache.setChangedCallback([&notifications]() { ++notifications; });
+    cache.setAutoAdvance(true, 10);
+    QCOMPARE(cache.nextChangeAt(), kNow.toMSecsSinceEpoch() + 100);
+    QCOMPARE(cache.dueCount(&deck), 0);
+
+    clock.advance(150);
+    QTRY_COMPARE_WITH_TIMEOUT(notifications, 1, 5000);
+    QCOMPARE(cache.dueCount(&deck), 1);
+
+    cache.setAutoAdvance(false);
+    cache.removeDeck(&deck);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestDueCountCache::testRepaintRefresh_data()
+{
+    QTest::addColumn<int>("deckCount");
+    QTest::addColumn<int>("cardsPerDeck");
+
+    QTest::newRow("500x400") << 500 << 400;
+    QTest::newRow("500x2000") << 500 << 2000;
+}
+
+void TestDueCountCache::testRepaintRefresh()
+{
+    // Перерисовка счетчиков всех колод раз в секунду условного времени
+    QFETCH(int, deckCount);
+    QFETCH(int, cardsPerDeck);
+    if (qint64(deckCount) * cardsPerDeck > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    FixedClock clock(kNow);
+    QList<Deck> decks;
+    decks.reserve(deckCount);
+    for (int i = 0; i < deckCount; i++) {
+        decks.append(makeDeck(i + 1, cardsPerDeck, &clock));
+    }
+    DueCountCache cache(&clock);
+    for (Deck &deck : decks) {
+        cache.addDeck(&deck);
+    }
+
+    constexpr int kRepaints = 1000;
+    QElapsedTimer timer;
+    timer.start();
+    qint64 direct = 0;
+    for (int repaint = 0; repaint < kRepaints; repaint++) {
+        clock.advance(1000);
+        for (const Deck &deck : decks) {
+            direct += deck.getDueCount();
+        }
+    }
+    const qint64 directNSecs = timer.nsecsElapsed();
+
+    clock.setNow(kNow);
+    cache.resetStats();
+    qint64 cached = 0;
+    timer.restart();
+    for (int repaint = 0; repaint < kRepaints; repaint++) {
+        clock.advance(1000);
+        cached += cache.totalDueCount();
+    }
+    const qint64 cachedNSecs = timer.nsecsElapsed();
+
+    QCOMPARE(cached, direct);
+    const DueCountCache::Stats stats = cache.stats();
+    QVERIFY(stats.hitRate() > 0.99);
+
+    qDebug() << "Decks:" << deckCount << "cards:" << qint64(deckCount) * cardsPerDeck
+             << "getDueCount:" << directNSecs / 1000.0 / kRepaints << "us/repaint,"
+             << "cache:" << cachedNSecs / 1000.0 / kRepaints << "us/repaint,"
+             << "hits:" << stats.hits << "misses:" << stats.misses
+             << "crossings:" << stats.crossings;
+}
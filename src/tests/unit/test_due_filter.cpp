@@ -0,0 +1,197 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <limits>
+#include "TestDueFilter.h"
+#include "DueFilter.h"
+#include "CardStore.h"
+#include "Deck.h"
+
+namespace {
+
+const QList<DueFilter::Kernel> allKernels = {
+    DueFilter::Kernel::Scalar,
+    DueFilter::Kernel::Sse2,
+    DueFilter::Kernel::Avx2
+};
+
+QList<int> referenceRows(const QList<qint64> &dates, qint64 now)
+{
+    QList<int> rows;
+    for (int i = 0; i < dates.size(); i++) {
+        if (dates[i] <= now) {
+            rows.append(i);
+        }
+    }
+    return rows;
+}
+
+QList<int> compactRows(const QList<qint64> &dates, qint64 now, DueFilter::Kernel kernel)
+{
+    QList<int> rows(dates.size());
+    rows.resize(DueFilter::compactDue(dates.constData(), dates.size(), now, rows.data(), kernel));
+    return rows;
+}
+
+} // namespace
+
+// ==================== CORRECTNESS ====================
+
+void TestDueFilter::testEmptyInput()
+{
+    for (DueFilter::Kernel kernel : allKernels) {
+        QCOMPARE(DueFilter::countDue(nullptr, 0, 0, kernel), qsizetype(0));
+        QCOMPARE(DueFilter::compactDue(nullptr, 0, 0, nullptr, kernel), qsizetype(0));
+    }
+    QVERIFY(DueFilter::isSupported(DueFilter::Kernel::Scalar));
+    QVERIFY(DueFilter::isSupported(DueFilter::bestKernel()));
+}
+
+void TestDueFilter::testInvalidDatesAreDue()
+{
+    // Отсутствующая дата хранится как kNoDate и должна считаться наступившей
+    QList<qint64> dates(100, CardStore::kNoDate);
+    const qint64 now = std::numeric_limits<qint64>::min() + 1;
+
+    for (DueFilter::Kernel kernel : allKernels) {
+        QCOMPARE(DueFilter::countDue(dates.constData(), dates.size(), now, kernel), qsizetype(100));
+    }
+}
+
+void TestDueFilter::testBoundaryValues()
+{
+    const qint64 now = 0x0000000180000000LL;    // старшее и младшее слова заданы явно
+    const QList<qint64> dates = {
+        CardStore::kNoDate,
+        now,                                    // ровно сейчас - наступила
+        now - 1,
+        now + 1,
+        now ^ 0x80000000LL,                     // отличается только знаковый бит младшего слова
+        now + 0x100000000LL,                    // больше только старшее слово
+        now - 0x100000000LL,
+        std::numeric_limits<qint64>::max(),
+        -1,
+        0
+    };
+
+    const QList<int> expected = referenceRows(dates, now);
+    QCOMPARE(expected, QList<int>({0, 1, 2, 4, 6, 8, 9}));
+
+    for (DueFilter::Kernel kernel : allKernels) {
+        QCOMPARE(compactRows(dates, now, kernel), expected);
+    }
+}
+
+void TestDueFilter::testKernelsMatchScalar_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("63") << 63;
+    QTest::newRow("64") << 64;
+    QTest::newRow("65") << 65;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("100003") << 100003;
+}
+
+void TestDueFilter::testKernelsMatchScalar()
+{
+    QFETCH(int, count);
+
+    QRandomGenerator rng(static_cast<quint32>(count));
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<qint64> dates;
+    dates.reserve(count);
+    for (int i = 0; i < count; i++) {
+        switch (rng.bounded(6)) {
+        case 0:
+            dates.append(CardStore::kNoDate);
+            break;
+        case 1:
+            dates.append(now);
+            break;
+        case 2:
+            // Совпадает старшее слово - проверяет сравнение младших половин
+            dates.append((now & ~0xFFFFFFFFLL) | qint64(rng.generate()));
+            break;
+        default:
+            dates.append(now + rng.bounded(-1000000, 1000000));
+            break;
+        }
+    }
+
+    const QList<int> scalarRows = compactRows(dates, now, DueFilter::Kernel::Scalar);
+    QCOMPARE(scalarRows, referenceRows(dates, now));
+
+    QList<quint64> scalarBits((count + 63) / 64);
+    DueFilter::dueBitmap(dates.constData(), count, now, scalarBits.data(), DueFilter::Kernel::Scalar);
+
+    for (DueFilter::Kernel kernel : allKernels) {
+        QCOMPARE(compactRows(dates, now, kernel), scalarRows);
+        QCOMPARE(DueFilter::countDue(dates.constData(), count, now, kernel), scalarRows.size());
+
+        QList<quint64> bits((count + 63) / 64);
+        DueFilter::dueBitmap(dates.constData(), count, now, bits.data(), kernel);
+        QCOMPARE(bits, scalarBits);
+    }
+}
+
+void TestDueFilter::testDeckUsesFilterForLargeDueShare()
+{
+    // Почти все карточки готовы - getDueCards() идет через фильтр и сохраняет порядок колоды
+    Deck deck;
+    QList<Card> cards;
+    QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < 500; i++) {
+        QDateTime nextReview = (i % 10 == 0) ? now.addDays(1)
+                             : (i % 3 == 0) ? QDateTime()
+                                            : now.addSecs(-i * 60);
+        cards.append(Card(i, QString("Q%1").arg(i), QString("A%1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.0f, 1, 0, nextReview, now, 1));
+    }
+    deck.setCards(cards);
+
+    QList<Card> dueCards = deck.getDueCards();
+    QCOMPARE(dueCards.size(), 450);
+    QCOMPARE(deck.getDueCount(), 450);
+    for (int i = 1; i < dueCards.size(); i++) {
+        QVERIFY(dueCards[i - 1].getId() < dueCards[i].getId());
+    }
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestDueFilter::testCompactPerformance_data()
+{
+    QTest::addColumn<int>("kernel");
+
+    QTest::newRow("scalar") << static_cast<int>(DueFilter::Kernel::Scalar);
+    QTest::newRow("sse2") << static_cast<int>(DueFilter::Kernel::Sse2);
+    QTest::newRow("avx2") << static_cast<int>(DueFilter::Kernel::Avx2);
+}
+
+void TestDueFilter::testCompactPerformance()
+{
+    QFETCH(int, kernel);
+    const auto selected = static_cast<DueFilter::Kernel>(kernel);
+    if (!DueFilter::isSupported(selected)) {
+        QSKIP("Kernel is not supported on this CPU");
+    }
+
+    // Столбец из миллиона дат, 20% наступили
+    const int count = 1000000;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<qint64> dates;
+    dates.reserve(count);
+    for (int i = 0; i < count; i++) {
+        dates.append(i % 5 == 0 ? now - 1000 : now + 1000);
+    }
+
+    QList<int> rows(count);
+    qsizetype written = 0;
+    QBENCHMARK {
+        written = DueFilter::compactDue(dates.constData(), count, now, rows.data(), selected);
+    }
+
+    QCOMPARE(written, qsizetype(count / 5));
+}
@@ -1,13 +1,45 @@
 #include <QtTest>
 #include "TestDeck.h"
 #include "TestCard.h"
+#include "TestCardStore.h"
+#include "TestDueFilter.h"
+#include "TestClock.h"
+#include "TestRepository.h"
+#include "TestReviewJournal.h"
+#include "TestContentCache.h"
+#include "TestSnapshot.h"
+#include "TestCsvImporter.h"
+#include "TestAnkiImporter.h"
+#include "TestCardExporter.h"
+#include "TestSearchIndex.h"
+#include "TestReviewQueue.h"
+#include "TestDueCountCache.h"
+#include "TestReviewForecast.h"
+#include "TestWorkloadSimulator.h"
+#include "TestScheduler.h"
+#include "TestParameterOptimizer.h"
+#include "TestCardTableModel.h"
+#include "TestTaskRunner.h"
+#include "TestConcurrentDeck.h"
+#include "TestStringPool.h"
+#include "TestDeckBuilder.h"
 
 // Объявляем все тестовые классы
 class TestCard;
 class TestDeck;
+class TestCardStore;
+class TestDueFilter;
+class TestClock;
+class TestRepository;
+class TestReviewJournal;
+class TestContentCache;
+class TestSnapshot;
+class TestCsvImporter;
 
 // Регистрируем все тесты
 int main(int argc, char *argv[]) {
+    // Цикл событий нужен тестам фоновых задач (QSignalSpy::wait, QTimer)
+    QCoreApplication app(argc, argv);
     int status = 0;
 
     {
@@ -20,5 +52,115 @@ int main(int argc, char *argv[]) {
         status |= QTest::qExec(&td, argc, argv);
     }
 
+    {
+        TestCardStore tcs;
+        status |= QTest::qExec(&tcs, argc, argv);
+    }
+
+    {
+        TestDueFilter tdf;
+        status |= QTest::qExec(&tdf, argc, argv);
+    }
+
+    {
+        TestClock tcl;
+        status |= QTest::qExec(&tcl, argc, argv);
+    }
+
+    {
+        TestRepository trp;
+        status |= QTest::qExec(&trp, argc, argv);
+    }
+
+    {
+        TestReviewJournal trj;
+        status |= QTest::qExec(&trj, argc, argv);
+    }
+
+    {
+        TestContentCache tcc;
+        status |= QTest::qExec(&tcc, argc, argv);
+    }
+
+    {
+        TestSnapshot tsn;
+        status |= QTest::qExec(&tsn, argc, argv);
+    }
+
+    {
+        TestCsvImporter tci;
+        status |= QTest::qExec(&tci, argc, argv);
+    }
+
+    {
+        TestAnkiImporter tai;
+        status |= QTest::qExec(&tai, argc, argv);
+    }
+
+    {
+        TestCardExporter tce;
+        status |= QTest::qExec(&tce, argc, argv);
+    }
+
+    {
+        TestSearchIndex tsi;
+        status |= QTest::qExec(&tsi, argc, argv);
+    }
+
+    {
+        TestReviewQueue trq;
+        status |= QTest::qExec(&trq, argc, argv);
+    }
+
+    {
+        TestDueCountCache tdc;
+        status |= QTest::qExec(&tdc, argc, argv);
+    }
+
+    {
+        TestReviewForecast trf;
+        status |= QTest::qExec(&trf, argc, argv);
+    }
+
+    {
+        TestWorkloadSimulator tws;
+        status |= QTest::qExec(&tws, argc, argv);
+    }
+
+    {
+        TestScheduler tsc;
+        status |= QTest::qExec(&tsc, argc, argv);
+    }
+
+    {
+        TestParameterOptimizer tpo;
+        status |= QTest::qExec(&tpo, argc, argv);
+    }
+
+    {
+        TestCardTableModel tct;
+        status |= QTest::qExec(&tct, argc, argv);
+    }
+
+    {
+        TestTaskRunner ttr;
+        status |= QTest::qExec(&ttr, argc, argv);
+    }
+
+    {
+        TestConcurrentDeck tcd;
+        status |= QTest::qExec(&tcd, argc, argv);
+    }
+
+    {
+        TestStringPool tsp;
+        status |= QTest::qExec(&tsp, argc, argv);
+    }
+
+    {
+        TestDeckBuilder tdb;
+        status |= QTest::qExec(&tdb, argc, argv);
+    }
+
     return status;
 }
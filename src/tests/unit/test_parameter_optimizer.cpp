@@ -0,0 +1,241 @@
+#include <QtTest>
+#include <QRandomGenerator>
+#include <cmath>
+#include "TestParameterOptimizer.h"
+#include "ParameterOptimizer.h"
+#include "FsrsModel.h"
+
+namespace {
+
+constexpr qint64 kStartMSecs = 1709280000000LL;   // 2024-03-01
+constexpr qint64 kMSecsPerDay = 24LL * 60 * 60 * 1000;
+
+/**
+ * @brief Веса "настоящего" пользователя: память растет медленнее,
+ *        чем по весам по умолчанию, а хорошо выученное забывается легче
+ */
+FsrsScheduler::Weights userWeights()
+{
+    FsrsScheduler::Weights weights = FsrsScheduler::defaultWeights();
+    weights[2] = 6.0f;
+    weights[8] = 1.0f;
+    weights[11] = 1.5f;
+    return weights;
+}
+
+/**
+ * @brief Сгенерировать историю по модели FSRS с заданными весами
+ *
+ * Ответ - испытание Бернулли с вероятностью вспомнить по модели;
+ * следующее повторение назначается на случайную долю (0.5-1.5)
+ * стабильности, чтобы в истории были и ранние, и поздние ответы.
+ *
+ * @param sink Получатель: sink(cardId, grade, reviewedAt)
+ */
+template <typename Sink>
+void generateHistory(const FsrsScheduler::Weights &weights, int cards, int reviewsPerCard, Sink sink)
+{
+    for (int card = 0; card < cards; ++card) {
+        QRandomGenerator random(quint32(card) * 7919u + 1u);
+        double stability = 0.0;
+        double difficulty = 0.0;
+        double day = 0.0;
+        double elapsed = 0.0;
+        for (int k = 0; k < reviewsPerCard; ++k) {
+            int rating;
+            if (k == 0) {
+                rating = random.generateDouble() < 0.2 ? 1 : random.generateDouble() < 0.8 ? 3 : 4;
+                stability = FsrsModel::initialStability<double>(weights, rating);
+                difficulty = FsrsModel::initialDifficulty<double>(weights, rating);
+            } else {
+                const double r = FsrsModel::retrievability(stability, elapsed);
+                const bool recalled = random.generateDouble() < r;
+                rating = !recalled ? 1 : random.generateDouble() < 0.7 ? 3 : random.generateDouble() < 0.5 ? 2 : 4;
+                const double next = FsrsModel::nextStability(weights, stability, difficulty, r, rating);
+                difficulty = FsrsModel::nextDifficulty(weights, difficulty, rating);
+                stability = next;
+            }
+            // Рейтинг 1-4 обратно в оценку 0-5
+            sink(card + 1, rating + 1, kStartMSecs + qint64(day * kMSecsPerDay));
+            elapsed = std::max(1.0, std::round(stability * (0.5 + random.generateDouble())));
+            day += elapsed;
+        }
+    }
+}
+
+QList<ReviewRecord> makeHistory(const FsrsScheduler::Weights &weights, int cards, int reviewsPerCard)
+{
+    QList<ReviewRecord> records;
+    records.reserve(qsizetype(cards) * reviewsPerCard);
+    generateHistory(weights, cards, reviewsPerCard, [&records](int cardId, int grade, qint64 reviewedAt) {
+        ReviewRecord record;
+        record.cardId = cardId;
+        record.grade = grade;
+        record.reviewedAt = reviewedAt;
+        records.append(record);
+    });
+    return records;
+}
+
+} // namespace
+
+// ==================== OPTIONS ====================
+
+void TestParameterOptimizer::testInvalidInput()
+{
+    ParameterOptimizer empty;
+    QVERIFY(!empty.fit());
+    QVERIFY(!empty.lastError().isEmpty());
+
+    ParameterOptimizer::Options options;
+    options.epochs = 0;
+    ParameterOptimizer noEpochs(options);
+    noEpochs.addReview(1, 4, kStartMSecs);
+    QVERIFY(!noEpochs.fit());
+
+    options = ParameterOptimizer::Options();
+    options.learningRate = 0.0;
+    ParameterOptimizer noRate(options);
+    noRate.addReview(1, 4, kStartMSecs);
+    QVERIFY(!noRate.fit());
+
+    // Одна карточка с одним ответом: предсказывать нечего, веса не меняются
+    ParameterOptimizer single;
+    single.addReview(1, 4, kStartMSecs);
+    QVERIFY(single.fit());
+    QCOMPARE(single.result().predictions, qint64(0));
+    QCOMPARE(single.result().steps, 0);
+    QVERIFY(single.result().weights == FsrsScheduler::defaultWeights());
+
+    single.clear();
+    QCOMPARE(single.reviewCount(), qsizetype(0));
+}
+
+// ==================== FITTING ====================
+
+void TestParameterOptimizer::testRecoversGeneratingWeights()
+{
+    const FsrsScheduler::Weights truth = userWeights();
+    const QList<ReviewRecord> history = makeHistory(truth, 20000, 20);
+
+    ParameterOptimizer::Options options;
+    options.batchReviews = 1 << 14;
+    ParameterOptimizer optimizer(options);
+    optimizer.addReviews(history);
+    QCOMPARE(optimizer.reviewCount(), history.size());
+    QVERIFY(optimizer.fit());
+
+    const ParameterOptimizer::Result &result = optimizer.result();
+    QCOMPARE(result.reviews, qint64(history.size()));
+    QCOMPARE(result.cards, 20000);
+    QCOMPARE(result.predictions, qint64(20000) * 19);
+    QCOMPARE(result.epochLogLoss.size(), options.epochs);
+    QVERIFY(result.steps >= options.epochs * 20);
+
+    FsrsScheduler::Parameters trueParameters;
+    trueParameters.weights = truth;
+    const double trueLoss = FsrsScheduler::evaluate(history, {trueParameters})[0].logLoss;
+
+    qDebug() << "Log-loss: default" << result.initialLogLoss << "fitted" << result.finalLogLoss
+             << "generating" << trueLoss << "in" << result.elapsedMSecs << "ms";
+
+    // Подобранные веса объясняют историю почти так же, как исходные
+    QVERIFY(result.finalLogLoss < result.initialLogLoss);
+    QVERIFY(result.finalLogLoss - trueLoss < 0.25 * (result.initialLogLoss - trueLoss));
+    QVERIFY(std::abs(result.weights[8] - truth[8]) < std::abs(FsrsScheduler::defaultWeights()[8] - truth[8]));
+
+    // Та же оценка через планировщик
+    const double fittedLoss = FsrsScheduler::evaluate(history, {optimizer.fittedParameters()})[0].logLoss;
+    QVERIFY(std::abs(fittedLoss - result.finalLogLoss) < 1e-3);
+}
+
+void TestParameterOptimizer::testDeterministic()
+{
+    const QList<ReviewRecord> history = makeHistory(userWeights(), 5000, 12);
+
+    ParameterOptimizer::Options options;
+    options.epochs = 2;
+    options.batchReviews = 1 << 15;
+    options.threadCount = 1;
+    ParameterOptimizer sequential(options);
+    sequential.addReviews(history);
+    QVERIFY(sequential.fit());
+
+    // Другой порядок ответов и другое число потоков
+    options.threadCount = 4;
+    ParameterOptimizer parallel(options);
+    for (qsizetype i = history.size() - 1; i >= 0; --i) {
+        parallel.addReview(history[i].cardId, history[i].grade, history[i].reviewedAt);
+    }
+    QVERIFY(parallel.fit());
+
+    QVERIFY(parallel.result().weights == sequential.result().weights);
+    QCOMPARE(parallel.result().finalLogLoss, sequential.result().finalLogLoss);
+    QCOMPARE(parallel.result().epochLogLoss, sequential.result().epochLogLoss);
+}
+
+void TestParameterOptimizer::testFittedParametersSchedule()
+{
+    ParameterOptimizer::Options options;
+    options.epochs = 3;
+    ParameterOptimizer optimizer(options);
+    generateHistory(userWeights(), 3000, 15, [&optimizer](int cardId, int grade, qint64 reviewedAt) {
+        optimizer.addReview(cardId, grade, reviewedAt);
+    });
+    QVERIFY(optimizer.fit());
+
+    const FsrsScheduler::Parameters parameters = optimizer.fittedParameters(0.85);
+    QCOMPARE(parameters.desiredRetention, 0.85);
+    QVERIFY(parameters.weights == optimizer.result().weights);
+
+    // Веса в допустимых диапазонах, планировщик дает разумные интервалы
+    const FsrsScheduler fsrs(parameters);
+    SchedulingState state;
+    fsrs.review(state, 4, 0.0);
+    QVERIFY(state.intervalDays >= 1);
+    const int first = state.intervalDays;
+    fsrs.review(state, 4, first);
+    QVERIFY(state.intervalDays > first);
+    for (float weight : parameters.weights) {
+        QVERIFY(std::isfinite(weight));
+        QVERIFY(weight >= 0.0f);
+    }
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestParameterOptimizer::testFitSpeed_data()
+{
+    QTest::addColumn<int>("cards");
+    QTest::addColumn<int>("reviewsPerCard");
+
+    QTest::newRow("1M") << 50000 << 20;
+    QTest::newRow("10M") << 250000 << 40;
+}
+
+void TestParameterOptimizer::testFitSpeed()
+{
+    // Пять эпох по истории; 10M ответов должны уложиться в минуту
+    QFETCH(int, cards);
+    QFETCH(int, reviewsPerCard);
+    const qint64 total = qint64(cards) * reviewsPerCard;
+    if (total > 1000000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to fit 10M reviews");
+    }
+
+    ParameterOptimizer optimizer;
+    optimizer.reserve(total);
+    generateHistory(userWeights(), cards, reviewsPerCard, [&optimizer](int cardId, int grade, qint64 reviewedAt) {
+        optimizer.addReview(cardId, grade, reviewedAt);
+    });
+    QVERIFY(optimizer.fit());
+
+    const ParameterOptimizer::Result &result = optimizer.result();
+    qDebug() << "Reviews:" << result.reviews << "steps:" << result.steps
+             << "fit:" << result.elapsedMSecs << "ms,"
+             << "reviews/s per epoch:" << qint64(double(result.reviews) * 5 * 1000 / std::max<qint64>(1, result.elapsedMSecs))
+             << "log-loss:" << result.initialLogLoss << "->" << result.finalLogLoss;
+    QCOMPARE(result.reviews, total);
+    QVERIFY(result.finalLogLoss < result.initialLogLoss);
+    QVERIFY(result.elapsedMSecs < 60 * 1000);
+}
@@ -0,0 +1,404 @@
+#include <QtTest>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <limits>
+#include "TestRepository.h"
+#include "Database.h"
+#include "CardRepository.h"
+#include "DeckRepository.h"
+
+namespace {
+
+Card makeCard(int id, const QDateTime &nextReview, int deckId = 1)
+{
+    return Card(id, QString("Вопрос %1").arg(id), QString("Ответ %1").arg(id),
+                ContentType::Audio, TestMode::MultipleChoice,
+                2.2f, 3, 2, nextReview, nextReview.isValid() ? nextReview.addDays(-3) : QDateTime(), deckId);
+}
+
+Deck makeDeck(int deckId, int count, const QDateTime &now)
+{
+    QList<Card> cards;
+    cards.reserve(count);
+    for (int i = 0; i < count; i++) {
+        // Каждая 4-я карточка без даты, каждая 3-я просрочена
+        QDateTime nextReview = (i % 4 == 0) ? QDateTime()
+                             : (i % 3 == 0) ? now.addSecs(-60 * i)
+                                            : now.addDays(1 + i % 7);
+        cards.append(makeCard(deckId * 1000000 + i, nextReview, deckId));
+    }
+
+    Deck deck;
+    deck.setId(deckId);
+    deck.setName(QString("Колода %1").arg(deckId));
+    deck.setCards(std::move(cards));
+    return deck;
+}
+
+void compareCards(const Card &actual, const Card &expected)
+{
+    QCOMPARE(actual.getId(), expected.getId());
+    QCOMPARE(actual.getQuestion(), expected.getQuestion());
+    QCOMPARE(actual.getAnswer(), expected.getAnswer());
+    QCOMPARE(actual.getContentType(), expected.getContentType());
+    QCOMPARE(actual.getTestMode(), expected.getTestMode());
+    QCOMPARE(actual.getEasyFactor(), expected.getEasyFactor());
+    QCOMPARE(actual.getIntervalDays(), expected.getIntervalDays());
+    QCOMPARE(actual.getRepetitions(), expected.getRepetitions());
+    QCOMPARE(actual.getNextReview(), expected.getNextReview());
+    QCOMPARE(actual.getLastReview(), expected.getLastReview());
+}
+
+int connectionCounter = 0;
+
+} // namespace
+
+void TestRepository::init()
+{
+    connectionName = QString("test_repository_%1").arg(++connectionCounter);
+    QString error;
+    database = Database::open(":memory:", connectionName, &error);
+    QVERIFY2(database.isOpen(), qPrintable(error));
+}
+
+void TestRepository::cleanup()
+{
+    database.close();
+    database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+// ==================== SCHEMA ====================
+
+void TestRepository::testOpenCreatesSchema()
+{
+    QSqlQuery query(database);
+    QVERIFY(query.exec("SELECT name FROM sqlite_master WHERE type IN ('table', 'index') ORDER BY name"));
+    QStringList names;
+    while (query.next()) {
+        names.append(query.value(0).toString());
+    }
+
+    QVERIFY(names.contains("decks"));
+    QVERIFY(names.contains("cards"));
+    QVERIFY(names.contains("idx_cards_deck_due"));
+    QVERIFY(names.contains("idx_cards_deck_position"));
+    QVERIFY(!names.contains("cards_fts"));
+    QVERIFY(!Database::hasFullTextSearch(database));
+
+    // Повторная разметка существующей базы ничего не ломает
+    QVERIFY(Database::createSchema(database));
+}
+
+void TestRepository::testOpenEnablesWal()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QString name = connectionName + "_file";
+    {
+        QSqlDatabase fileDatabase = Database::open(dir.filePath("cards.db"), name);
+        QVERIFY(fileDatabase.isOpen());
+
+        QSqlQuery query(fileDatabase);
+        QVERIFY(query.exec("PRAGMA journal_mode"));
+        QVERIFY(query.next());
+        QCOMPARE(query.value(0).toString().toLower(), QString("wal"));
+        fileDatabase.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+// ==================== DECKS ====================
+
+void TestRepository::testSaveAndLoadDeck()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const Deck original = makeDeck(7, 50, now);
+
+    DeckRepository repository(database);
+    QVERIFY2(repository.saveDeck(original), qPrintable(repository.lastError()));
+
+    Deck loaded;
+    QVERIFY2(repository.loadDeck(7, loaded), qPrintable(repository.lastError()));
+    QCOMPARE(loaded.getId(), 7);
+    QCOMPARE(loaded.getName(), original.getName());
+
+    const QList<Card> expected = original.getCards();
+    const QList<Card> actual = loaded.getCards();
+    QCOMPARE(actual.size(), expected.size());
+    for (int i = 0; i < expected.size(); i++) {
+        compareCards(actual[i], expected[i]);
+        QCOMPARE(actual[i].getDeckId(), 7);
+    }
+
+    QCOMPARE(repository.deckIds(), QList<int>({7}));
+}
+
+void TestRepository::testSaveDeckReplacesCards()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    Deck deck = makeDeck(1, 20, now);
+
+    DeckRepository repository(database);
+    QVERIFY(repository.saveDeck(deck));
+    QVERIFY(repository.cards().saveMedia({{1000005, QByteArray("ogg5")}, {1000006, QByteArray("ogg6")}}));
+
+    QVERIFY(deck.removeCard(1000005));
+    deck.setName("Переименована");
+    QVERIFY(repository.saveDeck(deck));
+
+    Deck loaded;
+    QVERIFY(repository.loadDeck(1, loaded));
+    QCOMPARE(loaded.getName(), QString("Переименована"));
+    QCOMPARE(loaded.getCardCount(), 19);
+    QCOMPARE(loaded.getCards()[5].getId(), 1000006);
+
+    // Медиаданные удаленной карточки удаляются, оставшейся - сохраняются
+    QSqlQuery media(database);
+    QVERIFY(media.exec("SELECT card_id FROM card_media ORDER BY card_id"));
+    QList<int> mediaIds;
+    while (media.next()) {
+        mediaIds.append(media.value(0).toInt());
+    }
+    QCOMPARE(mediaIds, QList<int>({1000006}));
+}
+
+void TestRepository::testLoadMissingDeck()
+{
+    DeckRepository repository(database);
+    Deck deck;
+    QVERIFY(!repository.loadDeck(42, deck));
+    QVERIFY(!repository.lastError().isEmpty());
+}
+
+void TestRepository::testRemoveDeck()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    DeckRepository repository(database);
+    QVERIFY(repository.saveDeck(makeDeck(1, 10, now)));
+    QVERIFY(repository.saveDeck(makeDeck(2, 10, now)));
+
+    QVERIFY(repository.removeDeck(1));
+    QVERIFY(!repository.removeDeck(1));
+    QCOMPARE(repository.deckIds(), QList<int>({2}));
+    QCOMPARE(repository.cards().loadDeckCards(1).size(), 0);
+    QCOMPARE(repository.cards().loadDeckCards(2).size(), 10);
+}
+
+void TestRepository::testSaveScheduling()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    Deck deck = makeDeck(3, 30, now);
+
+    DeckRepository repository(database);
+    QVERIFY(repository.saveDeck(deck));
+
+    QList<CardGrade> grades;
+    for (int i = 0; i < 30; i += 2) {
+        grades.append(CardGrade{3000000 + i, i % 6});
+    }
+    QCOMPARE(deck.applyGrades(grades, now), 15);
+    QVERIFY2(repository.saveScheduling(deck), qPrintable(repository.lastError()));
+
+    Deck loaded;
+    QVERIFY(repository.loadDeck(3, loaded));
+    const QList<Card> expected = deck.getCards();
+    const QList<Card> actual = loaded.getCards();
+    for (int i = 0; i < expected.size(); i++) {
+        compareCards(actual[i], expected[i]);
+    }
+}
+
+void TestRepository::testSaveMetadataOnlyDeck()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const Deck original = makeDeck(6, 40, now);
+
+    DeckRepository repository(database);
+    QVERIFY(repository.saveDeck(original));
+
+    Deck lazy;
+    QVERIFY(repository.loadDeckMetadata(6, lazy));
+    QVERIFY(lazy.isMetadataOnly());
+    QVERIFY(lazy.reviewCard(6000001, 5));
+    QVERIFY(lazy.removeCard(6000002));
+    lazy.setName("Без текста");
+    QVERIFY2(repository.saveDeck(lazy), qPrintable(repository.lastError()));
+
+    // Текст сохраненных карточек пережил сохранение колоды без текста
+    Deck loaded;
+    QVERIFY(repository.loadDeck(6, loaded));
+    QCOMPARE(loaded.getName(), QString("Без текста"));
+    QCOMPARE(loaded.getCardCount(), 39);
+    const QList<Card> expected = lazy.getCards();
+    const QList<Card> actual = loaded.getCards();
+    for (int i = 0; i < expected.size(); i++) {
+        QCOMPARE(actual[i].getId(), expected[i].getId());
+        QCOMPARE(actual[i].getQuestion(), QString("Вопрос %1").arg(expected[i].getId()));
+        QCOMPARE(actual[i].getAnswer(), QString("Ответ %1").arg(expected[i].getId()));
+        QCOMPARE(actual[i].getRepetitions(), expected[i].getRepetitions());
+        QCOMPARE(actual[i].getNextReview(), expected[i].getNextReview());
+    }
+    QCOMPARE(loaded.indexOf(6000002), -1);
+    QCOMPARE(actual[1].getRepetitions(), original.getCards()[1].getRepetitions() + 1);
+
+    // Карточка чужой колоды с тем же идентификатором не переносится
+    const Deck other = makeDeck(7, 3, now);
+    QVERIFY(repository.saveDeck(other));
+    lazy.addCard(makeCard(7000001, now, 6));
+    QVERIFY(!repository.saveDeck(lazy));
+    QVERIFY(repository.lastError().contains("7000001"));
+
+    Deck otherLoaded;
+    QVERIFY(repository.loadDeck(7, otherLoaded));
+    QCOMPARE(otherLoaded.getCardCount(), 3);
+    QCOMPARE(otherLoaded.getCards()[1].getQuestion(), QString("Вопрос 7000001"));
+    QVERIFY(repository.loadDeck(6, loaded));
+    QCOMPARE(loaded.getCardCount(), 39);
+}
+
+// ==================== CARDS ====================
+
+void TestRepository::testInsertCardsAppends()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    CardRepository repository(database);
+
+    QVERIFY(repository.insertCards(5, {makeCard(1, now), makeCard(2, now)}));
+    QVERIFY(repository.insertCards(5, {makeCard(3, now, 99)}));
+
+    const QList<Card> cards = repository.loadDeckCards(5);
+    QCOMPARE(cards.size(), 3);
+    QCOMPARE(cards[0].getId(), 1);
+    QCOMPARE(cards[2].getId(), 3);
+    QCOMPARE(cards[2].getDeckId(), 5);
+}
+
+void TestRepository::testRemoveCard()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    CardRepository repository(database);
+    QVERIFY(repository.insertCards(1, {makeCard(1, now), makeCard(2, now)}));
+
+    QVERIFY(repository.removeCard(1));
+    QVERIFY(!repository.removeCard(1));
+    QCOMPARE(repository.loadDeckCards(1).size(), 1);
+}
+
+void TestRepository::testLoadDueCardsMatchesDeck()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const Deck deck = makeDeck(4, 200, now);
+    DeckRepository repository(database);
+    QVERIFY(repository.saveDeck(deck));
+    QVERIFY(repository.saveDeck(makeDeck(5, 200, now)));
+
+    const qint64 nowMSecs = now.toMSecsSinceEpoch();
+    const QList<Card> dueCards = repository.cards().loadDueCards(4, nowMSecs);
+    QCOMPARE(dueCards.size(), deck.getDueCount());
+    QCOMPARE(repository.cards().countDueCards(4, nowMSecs), deck.getDueCount());
+
+    // Сначала карточки без даты, затем по возрастанию даты
+    QVERIFY(!dueCards.first().getNextReview().isValid());
+    for (int i = 1; i < dueCards.size(); i++) {
+        QCOMPARE(dueCards[i].getDeckId(), 4);
+        QVERIFY(CardStore::toEpochMSecs(dueCards[i - 1].getNextReview())
+                <= CardStore::toEpochMSecs(dueCards[i].getNextReview()));
+    }
+
+    QCOMPARE(repository.cards().loadDueCards(4, nowMSecs, 10).size(), 10);
+}
+
+void TestRepository::testDueQueryUsesIndex()
+{
+    QSqlQuery query(database);
+    QVERIFY(query.exec("EXPLAIN QUERY PLAN SELECT id FROM cards"
+                       " WHERE deck_id = 1 AND next_review <= 0 ORDER BY next_review"));
+    QString plan;
+    while (query.next()) {
+        plan += query.value(3).toString() + "\n";
+    }
+
+    QVERIFY2(plan.contains("idx_cards_deck_due"), qPrintable(plan));
+    QVERIFY2(!plan.contains("TEMP B-TREE"), qPrintable(plan));
+}
+
+void TestRepository::testFailedBulkInsertRollsBack()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    CardRepository repository(database);
+
+    // SQLite хранит NaN как NULL, что нарушает NOT NULL посреди пакета
+    Card broken = makeCard(3, now);
+    broken.setEasyFactor(std::numeric_limits<float>::quiet_NaN());
+
+    QVERIFY(!repository.insertCards(1, {makeCard(1, now), makeCard(2, now), broken}));
+    QVERIFY(!repository.lastError().isEmpty());
+    QCOMPARE(repository.loadDeckCards(1).size(), 0);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestRepository::testSaveLoadThroughput_data()
+{
+    QTest::addColumn<int>("cardCount");
+    QTest::addColumn<bool>("fullTextSearch");
+
+    QTest::newRow("100k") << 100000 << false;
+    QTest::newRow("100k fts") << 100000 << true;
+    QTest::newRow("1M") << 1000000 << false;
+    QTest::newRow("1M fts") << 1000000 << true;
+}
+
+void TestRepository::testSaveLoadThroughput()
+{
+    QFETCH(int, cardCount);
+    QFETCH(bool, fullTextSearch);
+    if (cardCount > 100000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString name = connectionName + "_bench";
+    {
+        QSqlDatabase fileDatabase = Database::open(dir.filePath("bench.db"), name);
+        QVERIFY(fileDatabase.isOpen());
+        // Триггеры cards_fts удваивают стоимость записи текста
+        QVERIFY(!fullTextSearch || Database::enableFullTextSearch(fileDatabase));
+
+        const QDateTime now = QDateTime::currentDateTime();
+        const Deck deck = makeDeck(1, cardCount, now);
+        DeckRepository repository(fileDatabase);
+        QElapsedTimer timer;
+
+        timer.start();
+        QVERIFY2(repository.saveDeck(deck), qPrintable(repository.lastError()));
+        const qint64 saveMSecs = qMax<qint64>(1, timer.elapsed());
+
+        timer.restart();
+        QVERIFY(repository.saveScheduling(deck));
+        const qint64 updateMSecs = qMax<qint64>(1, timer.elapsed());
+
+        Deck loaded;
+        timer.restart();
+        QVERIFY(repository.loadDeck(1, loaded));
+        const qint64 loadMSecs = qMax<qint64>(1, timer.elapsed());
+
+        timer.restart();
+        const QList<Card> dueCards = repository.cards().loadDueCards(1, now.toMSecsSinceEpoch());
+        const qint64 dueMSecs = timer.elapsed();
+
+        qDebug() << "Cards:" << cardCount << "FTS:" << fullTextSearch
+                 << "save:" << cardCount * 1000 / saveMSecs << "rows/s"
+                 << "update:" << cardCount * 1000 / updateMSecs << "rows/s"
+                 << "load:" << cardCount * 1000 / loadMSecs << "rows/s"
+                 << "due query:" << dueCards.size() << "rows in" << dueMSecs << "ms";
+
+        QCOMPARE(loaded.getCardCount(), cardCount);
+        QCOMPARE(static_cast<int>(dueCards.size()), deck.getDueCount());
+        fileDatabase.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+}
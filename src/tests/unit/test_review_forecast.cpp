@@ -0,0 +1,240 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <limits>
+#include "TestReviewForecast.h"
+#include "ReviewForecast.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/**
+ * @brief Колода со сроками от недели назад до полугода вперед
+ */
+Deck makeDeck(int deckId, int count, const Clock *clock)
+{
+    return TestDecks::makeDeck(deckId, count, [deckId](int i) {
+        const qint64 minutes = (qint64(i) * 7919 + qint64(deckId) * 104729) % (190 * 24 * 60) - 7 * 24 * 60;
+        return i % 9 == 0 ? QDateTime() : kNow.addSecs(minutes * 60);
+    }, clock);
+}
+
+/**
+ * @brief Гистограмма перебором по календарным датам карточек
+ */
+QList<int> bruteForce(const Deck &deck, int days, int *later)
+{
+    QList<int> counts(days, 0);
+    *later = 0;
+    for (const CardRef &card : deck.getCardsView()) {
+        const QDateTime next = card.getNextReview();
+        const qint64 day = next.isValid() ? std::max<qint64>(0, kNow.date().daysTo(next.date())) : 0;
+        if (day < days) {
+            counts[day]++;
+        } else {
+            ++*later;
+        }
+    }
+    return counts;
+}
+
+} // namespace
+
+// ==================== HISTOGRAM ====================
+
+void TestReviewForecast::testDeckHistogram()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeDeck(1, 5000, &clock);
+
+    for (int days : {1, 7, 30, 365}) {
+        const ReviewForecast forecast = deck.getForecast(days);
+        int later = 0;
+        QCOMPARE(forecast.days(), days);
+        QCOMPARE(forecast.counts(), bruteForce(deck, days, &later));
+        QCOMPARE(forecast.later(), later);
+        QCOMPARE(forecast.total(), qint64(deck.getCardCount()));
+    }
+
+    // Сегодня - все готовые карточки и те, что станут готовыми до полуночи
+    const ReviewForecast forecast = deck.getForecast(30);
+    QVERIFY(forecast.count(0) >= deck.getDueCount());
+    QCOMPARE(forecast.count(-1), 0);
+    QCOMPARE(forecast.count(30), 0);
+    QCOMPARE(forecast.dayStart(0), kNow.toMSecsSinceEpoch());
+    QCOMPARE(forecast.dayStart(1), QDateTime(QDate(2024, 3, 16), QTime(0, 0)).toMSecsSinceEpoch());
+    QCOMPARE(forecast.dayOf(forecast.dayStart(1) - 1), 0);
+    QCOMPARE(forecast.dayOf(forecast.dayStart(1)), 1);
+    QCOMPARE(forecast.dayOf(CardStore::kNoDate), 0);
+
+    const ReviewForecast empty = Deck().getForecast(0);
+    QCOMPARE(empty.days(), 1);
+    QCOMPARE(empty.total(), qint64(0));
+}
+
+void TestReviewForecast::testCollectionMatchesDecks()
+{
+    FixedClock clock(kNow);
+    QList<Deck> decks;
+    for (int i = 0; i < 37; i++) {
+        decks.append(makeDeck(i + 1, 50 + i * 40, &clock));
+    }
+    QList<const Deck *> pointers;
+    ReviewForecast expected(kNow, 60);
+    for (const Deck &deck : decks) {
+        pointers.append(&deck);
+        QVERIFY(expected.merge(deck.getForecast(60)));
+    }
+    pointers.append(nullptr);
+
+    for (int threads : {1, 2, 4, 0}) {
+        const ReviewForecast forecast = ReviewForecast::forDecks(pointers, kNow, 60, threads);
+        QCOMPARE(forecast.counts(), expected.counts());
+        QCOMPARE(forecast.later(), expected.later());
+    }
+    QCOMPARE(ReviewForecast::forDecks({}, kNow, 10).total(), qint64(0));
+}
+
+void TestReviewForecast::testMergeRequiresSameDays()
+{
+    ReviewForecast week(kNow, 7);
+    QVERIFY(!week.merge(ReviewForecast(kNow, 8)));
+    QVERIFY(!week.merge(ReviewForecast(kNow.addDays(1), 7)));
+    // Другой момент того же дня дает те же границы
+    QVERIFY(week.merge(ReviewForecast(kNow.addSecs(3600), 7)));
+}
+
+// ==================== UPDATES ====================
+
+void TestReviewForecast::testIncrementalReschedule()
+{
+    FixedClock clock(kNow);
+    Deck deck = makeDeck(1, 3000, &clock);
+    ReviewForecast forecast = deck.getForecast(90);
+
+    for (int i = 0; i < 500; i++) {
+        const int cardId = 1000000 + (i * 13) % 3000;
+        const int row = deck.indexOf(cardId);
+        const qint64 oldDueAt = deck.getCardsView()[row].getNextReviewMSecs();
+        QVERIFY(deck.reviewCard(cardId, i % 6));
+        forecast.cardRescheduled(oldDueAt, deck.getCardsView()[row].getNextReviewMSecs());
+    }
+
+    const Card added(5000000, "новая", "", ContentType::Text, TestMode::DirectAnswer,
+                     2.5f, 0, 0, kNow.addDays(3), QDateTime(), 1);
+    deck.addCard(added);
+    forecast.cardAdded(added.getNextReview().toMSecsSinceEpoch());
+    const qint64 removedDueAt = deck.getCardsView()[10].getNextReviewMSecs();
+    QVERIFY(deck.removeCard(deck.getCardsView()[10].getId()));
+    forecast.cardRemoved(removedDueAt);
+
+    const ReviewForecast fresh = deck.getForecast(90);
+    QCOMPARE(forecast.counts(), fresh.counts());
+    QCOMPARE(forecast.later(), fresh.later());
+}
+
+void TestReviewForecast::testDeckMaintainsForecast()
+{
+    FixedClock clock(kNow);
+    Deck deck = makeDeck(1, 3000, &clock);
+    ReviewForecast forecast(kNow, 90);
+    deck.setForecast(&forecast);
+
+    auto matchesDeck = [&deck, &forecast]() {
+        const ReviewForecast fresh = deck.getForecast(90);
+        return forecast.counts() == fresh.counts() && forecast.later() == fresh.later();
+    };
+    QVERIFY(matchesDeck());
+    QCOMPARE(forecast.total(), qint64(3000));
+
+    // Одиночные изменения переносят карточки между корзинами
+    for (int i = 0; i < 200; i++) {
+        QVERIFY(deck.reviewCard(1000000 + (i * 13) % 3000, i % 6));
+    }
+    QVERIFY(matchesDeck());
+    QCOMPARE(deck.applyGrades({{1000001, 5}, {1000002, 0}, {1000001, 3}}, kNow), 3);
+    QVERIFY(matchesDeck());
+
+    deck.addCard(Card(5000000, "новая", "", ContentType::Text, TestMode::DirectAnswer,
+                      2.5f, 0, 0, kNow.addDays(3), QDateTime(), 1));
+    QVERIFY(deck.removeCard(1000010));
+    Card moved = deck.getCardsView()[deck.indexOf(1000020)].toCard();
+    moved.setNextReview(kNow.addDays(200));
+    QVERIFY(deck.updateCard(moved));
+    QVERIFY(matchesDeck());
+
+    // Массовые изменения пересчитывают прогноз
+    QList<CardGrade> grades;
+    for (int i = 0; i < 1000; i++) {
+        grades.append({1000000 + i, 4});
+    }
+    QCOMPARE(deck.applyGrades(grades, kNow), 1000);
+    QVERIFY(matchesDeck());
+    deck.setCards(makeDeck(2, 500, &clock).getCards());
+    QVERIFY(matchesDeck());
+    QCOMPARE(forecast.total(), qint64(500));
+
+    deck.setForecast(nullptr);
+    deck.addCard(Card(6000000, "без", "прогноза", ContentType::Text, TestMode::DirectAnswer,
+                      2.5f, 0, 0, kNow, QDateTime(), 1));
+    QCOMPARE(forecast.total(), qint64(500));
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestReviewForecast::testForecastSpeed_data()
+{
+    QTest::addColumn<int>("deckCount");
+    QTest::addColumn<int>("cardsPerDeck");
+
+    QTest::newRow("1x200k") << 1 << 200000;
+    QTest::newRow("1000x200") << 1000 << 200;
+    QTest::newRow("1x1M") << 1 << 1000000;
+    QTest::newRow("1000x1000") << 1000 << 1000;
+}
+
+void TestReviewForecast::testForecastSpeed()
+{
+    // Прогноз на год вперед: одна большая колода и тысяча колод
+    QFETCH(int, deckCount);
+    QFETCH(int, cardsPerDeck);
+    if (qint64(deckCount) * cardsPerDeck > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    FixedClock clock(kNow);
+    QList<Deck> decks;
+    decks.reserve(deckCount);
+    QList<const Deck *> pointers;
+    for (int i = 0; i < deckCount; i++) {
+        decks.append(makeDeck(i + 1, cardsPerDeck, &clock));
+        pointers.append(&decks.last());
+    }
+
+    constexpr int kRuns = 20;
+    qint64 best = std::numeric_limits<qint64>::max();
+    ReviewForecast forecast;
+    QElapsedTimer timer;
+    for (int run = 0; run < kRuns; run++) {
+        timer.start();
+        forecast = ReviewForecast::forDecks(pointers, kNow, 365);
+        best = std::min(best, timer.nsecsElapsed());
+    }
+    QCOMPARE(forecast.total(), qint64(deckCount) * cardsPerDeck);
+
+    timer.start();
+    qint64 sequential = 0;
+    for (const Deck *deck : pointers) {
+        sequential += deck->getForecast(365).count(1);
+    }
+    const qint64 sequentialNSecs = timer.nsecsElapsed();
+    QCOMPARE(sequential, qint64(forecast.count(1)));
+
+    qDebug() << "Decks:" << deckCount << "cards:" << qint64(deckCount) * cardsPerDeck
+             << "parallel:" << best / 1000000.0 << "ms,"
+             << "sequential:" << sequentialNSecs / 1000000.0 << "ms,"
+             << "today:" << forecast.count(0) << "tomorrow:" << forecast.count(1);
+    QVERIFY(best < 10 * 1000000LL);
+}
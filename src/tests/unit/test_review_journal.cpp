@@ -0,0 +1,350 @@
+#include <QtTest>
+#include <QFile>
+#include <QMutex>
+#include <QTemporaryDir>
+#include <algorithm>
+#include "TestReviewJournal.h"
+#include "ReviewJournal.h"
+#include "Database.h"
+#include "DeckRepository.h"
+
+namespace {
+
+ReviewRecord makeRecord(int cardId, int grade)
+{
+    ReviewRecord record;
+    record.cardId = cardId;
+    record.grade = grade;
+    record.reviewedAt = 1700000000000LL + cardId;
+    record.easyFactor = 2.5f - 0.1f * grade;
+    record.intervalDays = grade + 1;
+    record.repetitions = grade;
+    record.nextReview = record.reviewedAt + 86400000LL * record.intervalDays;
+    return record;
+}
+
+Deck makeDeck(int count, const QDateTime &now)
+{
+    QList<Card> cards;
+    cards.reserve(count);
+    for (int i = 0; i < count; i++) {
+        cards.append(Card(i + 1, QString("Q%1").arg(i), QString("A%1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 1, 0, now.addDays(-1), now.addDays(-2), 1));
+    }
+    Deck deck;
+    deck.setId(1);
+    deck.setName("Journal");
+    deck.setCards(std::move(cards));
+    return deck;
+}
+
+/**
+ * @brief Перцентиль выборки (выборка сортируется на месте)
+ */
+qint64 percentile(QList<qint64> &samples, double fraction)
+{
+    if (samples.isEmpty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const qsizetype index = qMin(samples.size() - 1, static_cast<qsizetype>(samples.size() * fraction));
+    return samples[index];
+}
+
+} // namespace
+
+// ==================== WRITE & READ ====================
+
+void TestReviewJournal::testAppendFlushAndRead()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("reviews.journal");
+    ReviewJournal journal(path);
+    QVERIFY2(journal.open(), qPrintable(journal.lastError()));
+
+    for (int i = 1; i <= 10; i++) {
+        QCOMPARE(journal.append(makeRecord(i, i % 6)), qint64(i));
+    }
+    QVERIFY(journal.flush());
+    QCOMPARE(journal.committedSequence(), qint64(10));
+    QCOMPARE(journal.stats().committed, qint64(10));
+
+    const QList<ReviewRecord> records = ReviewJournal::readRecords(path);
+    QCOMPARE(records.size(), 10);
+    for (int i = 0; i < records.size(); i++) {
+        const ReviewRecord expected = makeRecord(i + 1, (i + 1) % 6);
+        QCOMPARE(records[i].sequence, qint64(i + 1));
+        QCOMPARE(records[i].cardId, expected.cardId);
+        QCOMPARE(records[i].grade, expected.grade);
+        QCOMPARE(records[i].reviewedAt, expected.reviewedAt);
+        QCOMPARE(records[i].easyFactor, expected.easyFactor);
+        QCOMPARE(records[i].intervalDays, expected.intervalDays);
+        QCOMPARE(records[i].repetitions, expected.repetitions);
+        QCOMPARE(records[i].nextReview, expected.nextReview);
+    }
+}
+
+void TestReviewJournal::testReopenContinuesSequence()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("reviews.journal");
+    {
+        ReviewJournal journal(path);
+        QVERIFY(journal.open());
+        journal.append(makeRecord(1, 4));
+        journal.append(makeRecord(2, 4));
+        // Деструктор фиксирует очередь
+    }
+
+    ReviewJournal journal(path);
+    QVERIFY(journal.open());
+    QCOMPARE(journal.committedSequence(), qint64(2));
+    QCOMPARE(journal.append(makeRecord(3, 4)), qint64(3));
+    journal.close();
+
+    QCOMPARE(ReviewJournal::readRecords(path).size(), 3);
+}
+
+void TestReviewJournal::testAppendWhenClosed()
+{
+    QTemporaryDir dir;
+    ReviewJournal journal(dir.filePath("reviews.journal"));
+    QVERIFY(!journal.isOpen());
+    QCOMPARE(journal.append(makeRecord(1, 5)), qint64(0));
+}
+
+// ==================== GROUP COMMIT ====================
+
+void TestReviewJournal::testGroupCommitBatchesRecords()
+{
+    QTemporaryDir dir;
+    ReviewJournal::Options options;
+    options.flushIntervalMSecs = 60 * 1000;
+    options.maxBatchRecords = 100;
+    ReviewJournal journal(dir.filePath("reviews.journal"), options);
+    QVERIFY(journal.open());
+
+    for (int i = 0; i < 1000; i++) {
+        journal.append(makeRecord(i + 1, 3));
+    }
+    QVERIFY(journal.flush());
+
+    // Фиксация идет группами, а не по одной записи
+    const ReviewJournal::Stats stats = journal.stats();
+    QCOMPARE(stats.appended, qint64(1000));
+    QCOMPARE(stats.committed, qint64(1000));
+    QVERIFY(stats.groupCommits >= 1);
+    QVERIFY2(stats.groupCommits <= 20, qPrintable(QString::number(stats.groupCommits)));
+}
+
+void TestReviewJournal::testIntervalCommitsWithoutFlush()
+{
+    QTemporaryDir dir;
+    ReviewJournal::Options options;
+    options.flushIntervalMSecs = 10;
+    options.maxBatchRecords = 1000;
+    ReviewJournal journal(dir.filePath("reviews.journal"), options);
+
+    QMutex mutex;
+    qint64 lastCommitted = 0;
+    journal.setCommitCallback([&](qint64 sequence) {
+        QMutexLocker locker(&mutex);
+        lastCommitted = sequence;
+    });
+    QVERIFY(journal.open());
+
+    journal.append(makeRecord(1, 5));
+    QTRY_COMPARE(journal.committedSequence(), qint64(1));
+
+    QMutexLocker locker(&mutex);
+    QCOMPARE(lastCommitted, qint64(1));
+}
+
+// ==================== RECOVERY ====================
+
+void TestReviewJournal::testTornTailIsDropped()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("reviews.journal");
+    {
+        ReviewJournal journal(path);
+        QVERIFY(journal.open());
+        for (int i = 1; i <= 5; i++) {
+            journal.append(makeRecord(i, 4));
+        }
+    }
+
+    // Сбой посреди записи: половина шестой записи
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::Append));
+    file.write(QByteArray(20, '\x7f'));
+    file.close();
+
+    QCOMPARE(ReviewJournal::readRecords(path).size(), 5);
+
+    // Открытие отрезает хвост, новая запись ложится сразу за целыми
+    ReviewJournal journal(path);
+    QVERIFY(journal.open());
+    QCOMPARE(journal.append(makeRecord(6, 4)), qint64(6));
+    journal.close();
+    QCOMPARE(ReviewJournal::readRecords(path).size(), 6);
+}
+
+void TestReviewJournal::testRecoverAppliesToRepository()
+{
+    QTemporaryDir dir;
+    const QString journalPath = dir.filePath("reviews.journal");
+    const QDateTime now = QDateTime::currentDateTime();
+    {
+        QSqlDatabase database = Database::open(dir.filePath("cards.db"), "journal_recover");
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+        Deck deck = makeDeck(20, now);
+        QVERIFY(repository.saveDeck(deck));
+
+        // Сессия: ответы попадают только в журнал, база не обновляется («сбой»)
+        ReviewJournal journal(journalPath);
+        QVERIFY(journal.open());
+        for (int cardId : {3, 7, 3, 11}) {
+            QVERIFY(deck.reviewCard(cardId, 5));
+            journal.append(ReviewRecord::fromCard(deck.getCardsView()[deck.indexOf(cardId)], 5));
+        }
+        QVERIFY(journal.flush());
+        journal.close();
+
+        // Запуск после сбоя
+        QString error;
+        QCOMPARE(ReviewJournal::recover(journalPath, repository.cards(), &error), 4);
+        QVERIFY(error.isEmpty());
+        QCOMPARE(ReviewJournal::readRecords(journalPath).size(), 0);
+
+        Deck restored;
+        QVERIFY(repository.loadDeck(1, restored));
+        const QList<Card> expected = deck.getCards();
+        const QList<Card> actual = restored.getCards();
+        for (int i = 0; i < expected.size(); i++) {
+            QCOMPARE(actual[i].getRepetitions(), expected[i].getRepetitions());
+            QCOMPARE(actual[i].getIntervalDays(), expected[i].getIntervalDays());
+            QCOMPARE(actual[i].getEasyFactor(), expected[i].getEasyFactor());
+            QCOMPARE(actual[i].getNextReview(), expected[i].getNextReview());
+            QCOMPARE(actual[i].getLastReview(), expected[i].getLastReview());
+        }
+        QCOMPARE(restored.getCards()[2].getRepetitions(), 2);
+
+        // Повторное восстановление пустого журнала ничего не делает
+        QCOMPARE(ReviewJournal::recover(journalPath, repository.cards()), 0);
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("journal_recover");
+}
+
+void TestReviewJournal::testCheckpointTruncatesJournal()
+{
+    QTemporaryDir dir;
+    const QString journalPath = dir.filePath("reviews.journal");
+    const QDateTime now = QDateTime::currentDateTime();
+    {
+        QSqlDatabase database = Database::open(":memory:", "journal_checkpoint");
+        DeckRepository repository(database);
+        Deck deck = makeDeck(10, now);
+        QVERIFY(repository.saveDeck(deck));
+
+        ReviewJournal journal(journalPath);
+        QVERIFY(journal.open());
+        QVERIFY(deck.reviewCard(4, 4));
+        journal.append(ReviewRecord::fromCard(deck.getCardsView()[deck.indexOf(4)], 4));
+
+        QVERIFY(journal.checkpoint(repository.cards()));
+        QCOMPARE(ReviewJournal::readRecords(journalPath).size(), 0);
+        QCOMPARE(repository.cards().countDueCards(1, now.toMSecsSinceEpoch()), 9);
+
+        // После очистки журнал продолжает принимать записи
+        QVERIFY(deck.reviewCard(5, 4));
+        journal.append(ReviewRecord::fromCard(deck.getCardsView()[deck.indexOf(5)], 4));
+        QVERIFY(journal.flush());
+        QCOMPARE(ReviewJournal::readRecords(journalPath).size(), 1);
+        journal.close();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("journal_checkpoint");
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestReviewJournal::testReviewSessionLatency()
+{
+    // Синтетическая сессия: 10k ответов (100k с QTCARDS_LARGE_BENCH), каждый
+    // перепланирует карточку и уходит в журнал. Задержка append() - то, что
+    // видит поток интерфейса; задержка фиксации - время до попадания на диск.
+    const int answers = qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH") ? 100000 : 10000;
+    const int cardCount = 10000;
+
+    QTemporaryDir dir;
+    const QDateTime now = QDateTime::currentDateTime();
+    FixedClock clock(now);
+    Deck deck = makeDeck(cardCount, now);
+    deck.setClock(&clock);
+
+    ReviewJournal journal(dir.filePath("session.journal"));
+    QElapsedTimer session;
+
+    // Момент постановки каждой записи; индекс - порядковый номер записи
+    QList<qint64> enqueuedAt(answers + 1, 0);
+    QList<qint64> commitLatency(answers + 1, 0);
+    QMutex commitMutex;
+    qint64 measuredUpTo = 0;
+    journal.setCommitCallback([&](qint64 lastSequence) {
+        const qint64 committedAt = session.nsecsElapsed();
+        QMutexLocker locker(&commitMutex);
+        for (qint64 sequence = measuredUpTo + 1; sequence <= lastSequence; ++sequence) {
+            commitLatency[sequence] = committedAt - enqueuedAt[sequence];
+        }
+        measuredUpTo = lastSequence;
+    });
+    QVERIFY(journal.open());
+
+    QList<QList<qint64>> appendByGrade(6);
+    QList<int> gradeOf(answers + 1, 0);
+    session.start();
+
+    for (int i = 0; i < answers; i++) {
+        const int cardId = (i * 7919) % cardCount + 1;
+        const int grade = i % 6;
+
+        const qint64 started = session.nsecsElapsed();
+        deck.reviewCard(cardId, grade);
+        ReviewRecord record = ReviewRecord::fromCard(deck.getCardsView()[deck.indexOf(cardId)], grade);
+        {
+            QMutexLocker locker(&commitMutex);
+            enqueuedAt[i + 1] = started;
+        }
+        const qint64 sequence = journal.append(record);
+        appendByGrade[grade].append(session.nsecsElapsed() - started);
+        gradeOf[sequence] = grade;
+    }
+
+    QVERIFY(journal.flush());
+    const qint64 totalMSecs = qMax<qint64>(1, session.elapsed());
+    journal.close();
+
+    QList<QList<qint64>> commitByGrade(6);
+    for (int sequence = 1; sequence <= answers; sequence++) {
+        commitByGrade[gradeOf[sequence]].append(commitLatency[sequence]);
+    }
+
+    for (int grade = 0; grade < 6; grade++) {
+        qDebug().nospace() << "grade " << grade
+                           << ": answer p50 " << percentile(appendByGrade[grade], 0.50) / 1000.0 << " us"
+                           << ", p99 " << percentile(appendByGrade[grade], 0.99) / 1000.0 << " us"
+                           << "; durable p50 " << percentile(commitByGrade[grade], 0.50) / 1000000.0 << " ms"
+                           << ", p99 " << percentile(commitByGrade[grade], 0.99) / 1000000.0 << " ms";
+    }
+
+    const ReviewJournal::Stats stats = journal.stats();
+    qDebug() << "Answers:" << answers << "throughput:" << answers * 1000 / totalMSecs << "answers/s"
+             << "group commits:" << stats.groupCommits;
+
+    QCOMPARE(stats.committed, qint64(answers));
+    QCOMPARE(ReviewJournal::readRecords(dir.filePath("session.journal")).size(), answers);
+}
@@ -0,0 +1,278 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <tuple>
+#include "TestReviewQueue.h"
+#include "ReviewQueue.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/**
+ * @brief Колода, где каждая 5-я карточка новая, половина остальных просрочена
+ */
+Deck makeDeck(int deckId, int count, const Clock *clock, int seed = 0)
+{
+    return TestDecks::buildDeck(deckId, count, [deckId, seed](int i) {
+        const int mix = (i * 7919 + seed * 104729) % 10007;
+        const QDateTime next = i % 5 == 0 ? QDateTime()
+                             : i % 2 == 0 ? kNow.addSecs(-60LL * (mix + 1))
+                                          : kNow.addSecs(60LL * (mix + 1));
+        return TestDecks::textCard(deckId * 1000000 + i, i, next, deckId, 1, 1);
+    }, clock);
+}
+
+QList<int> drain(ReviewQueue &queue, int limit = -1)
+{
+    QList<int> ids;
+    while (queue.hasNext() && (limit < 0 || ids.size() < limit)) {
+        ids.append(queue.next().card.getId());
+    }
+    return ids;
+}
+
+/**
+ * @brief Наивный порядок: все готовые карточки всех колод одним списком,
+ *        отсортированным по сроку (при равенстве - колода, позиция)
+ */
+QList<int> concatenateAndSort(const QList<Deck> &decks)
+{
+    struct Due {
+        qint64 dueAt;
+        int deck;
+        int row;
+        int id;
+    };
+    QList<Due> all;
+    for (int d = 0; d < decks.size(); d++) {
+        const QList<Card> cards = decks[d].getDueCards();
+        for (int row = 0; row < cards.size(); row++) {
+            const QDateTime next = cards[row].getNextReview();
+            all.append(Due{next.isValid() ? next.toMSecsSinceEpoch() : CardStore::kNoDate,
+                           d, decks[d].indexOf(cards[row].getId()), cards[row].getId()});
+        }
+    }
+    std::sort(all.begin(), all.end(), [](const Due &a, const Due &b) {
+        return std::tie(a.dueAt, a.deck, a.row) < std::tie(b.dueAt, b.deck, b.row);
+    });
+    QList<int> ids;
+    ids.reserve(all.size());
+    for (const Due &due : all) {
+        ids.append(due.id);
+    }
+    return ids;
+}
+
+} // namespace
+
+// ==================== ORDER ====================
+
+void TestReviewQueue::testMergeByDueTime()
+{
+    FixedClock clock(kNow);
+    const QList<Deck> decks = {makeDeck(1, 300, &clock, 1), makeDeck(2, 50, &clock, 2),
+                               makeDeck(3, 0, &clock), makeDeck(4, 700, &clock, 4)};
+    ReviewQueue queue;
+    for (const Deck &deck : decks) {
+        queue.addDeck(&deck);
+    }
+    queue.addDeck(&decks[0]);
+    queue.addDeck(nullptr);
+    queue.start(kNow.toMSecsSinceEpoch());
+
+    const int expectedTotal = decks[0].getDueCount() + decks[1].getDueCount() + decks[3].getDueCount();
+    QCOMPARE(queue.remaining(), expectedTotal);
+
+    const ReviewQueue::Item first = queue.next();
+    QCOMPARE(first.deck, &decks[0]);
+    QVERIFY(!first.card.getNextReview().isValid());
+    QCOMPARE(queue.remaining(), expectedTotal - 1);
+
+    QList<int> ids = {first.card.getId()};
+    ids.append(drain(queue));
+    QCOMPARE(ids, concatenateAndSort(decks));
+    QCOMPARE(queue.issued(1), decks[0].getDueCount());
+    QCOMPARE(queue.issued(4), decks[3].getDueCount());
+    QCOMPARE(queue.remaining(), 0);
+}
+
+void TestReviewQueue::testRoundRobin()
+{
+    FixedClock clock(kNow);
+    const QList<Deck> decks = {makeDeck(1, 20, &clock), makeDeck(2, 100, &clock), makeDeck(3, 10, &clock)};
+    ReviewQueue queue;
+    queue.setDecks({&decks[0], &decks[1], &decks[2]});
+    queue.setInterleave(ReviewQueue::Interleave::RoundRobin);
+    QCOMPARE(queue.getInterleave(), ReviewQueue::Interleave::RoundRobin);
+    queue.start(kNow.toMSecsSinceEpoch());
+
+    // Пока в колодах есть карточки, они чередуются 1, 2, 3, 1, 2, 3...
+    const int rounds = std::min({decks[0].getDueCount(), decks[1].getDueCount(), decks[2].getDueCount()});
+    for (int round = 0; round < rounds; round++) {
+        for (int deckId = 1; deckId <= 3; deckId++) {
+            QCOMPARE(queue.next().deck->getId(), deckId);
+        }
+    }
+    // Внутри колоды - по сроку, как в getDueCardsView()
+    drain(queue);
+    QCOMPARE(queue.issued(2), decks[1].getDueCount());
+
+    queue.start(kNow.toMSecsSinceEpoch());
+    QList<int> deckTwo;
+    while (queue.hasNext()) {
+        const ReviewQueue::Item item = queue.next();
+        if (item.deck == &decks[1]) {
+            deckTwo.append(item.card.getId());
+        }
+    }
+    QList<int> expected;
+    for (const CardRef &card : decks[1].getDueCardsView()) {
+        expected.append(card.getId());
+    }
+    QCOMPARE(deckTwo, expected);
+}
+
+void TestReviewQueue::testDeckByDeck()
+{
+    FixedClock clock(kNow);
+    const QList<Deck> decks = {makeDeck(1, 30, &clock), makeDeck(2, 30, &clock)};
+    ReviewQueue queue;
+    queue.setDecks({&decks[1], &decks[0]});
+    queue.setInterleave(ReviewQueue::Interleave::DeckByDeck);
+    queue.start(kNow.toMSecsSinceEpoch());
+
+    QList<int> order;
+    while (queue.hasNext()) {
+        order.append(queue.next().deck->getId());
+    }
+    QCOMPARE(order.size(), decks[0].getDueCount() + decks[1].getDueCount());
+    QVERIFY(std::is_sorted(order.begin(), order.end(), std::greater<int>()));
+}
+
+void TestReviewQueue::testEmptyQueue()
+{
+    ReviewQueue queue;
+    queue.start(kNow.toMSecsSinceEpoch());
+    QVERIFY(!queue.hasNext());
+    QCOMPARE(queue.next().deck, nullptr);
+    QCOMPARE(queue.remaining(), 0);
+
+    FixedClock clock(kNow.addYears(-1));
+    const Deck deck = makeDeck(1, 100, &clock);
+    queue.addDeck(&deck);
+    queue.start(kNow.addYears(-1).toMSecsSinceEpoch());
+    // Готовы только новые карточки
+    QCOMPARE(queue.remaining(), 20);
+}
+
+// ==================== LIMITS AND SESSION ====================
+
+void TestReviewQueue::testDailyLimits()
+{
+    FixedClock clock(kNow);
+    const QList<Deck> decks = {makeDeck(1, 200, &clock), makeDeck(2, 200, &clock), makeDeck(3, 200, &clock)};
+    ReviewQueue queue;
+    queue.setDecks({&decks[0], &decks[1], &decks[2]});
+    queue.setDailyLimit(25);
+    queue.setDeckLimit(2, 5);
+    queue.setDeckLimit(3, ReviewQueue::kUnlimited);
+    queue.setReviewedToday(1, 20);
+    queue.start(kNow.toMSecsSinceEpoch());
+
+    QCOMPARE(queue.remaining(), 5 + 5 + decks[2].getDueCount());
+    drain(queue);
+    QCOMPARE(queue.issued(1), 5);
+    QCOMPARE(queue.issued(2), 5);
+    QCOMPARE(queue.issued(3), decks[2].getDueCount());
+
+    // Лимит, выбранный заранее
+    queue.setReviewedToday(2, 100);
+    queue.setDeckLimit(3, 0);
+    queue.start(kNow.toMSecsSinceEpoch());
+    QCOMPARE(queue.remaining(), 5);
+    QCOMPARE(drain(queue).size(), 5);
+}
+
+void TestReviewQueue::testReviewDuringSession()
+{
+    FixedClock clock(kNow);
+    QList<Deck> decks = {makeDeck(1, 500, &clock), makeDeck(2, 500, &clock)};
+    ReviewQueue queue;
+    queue.setDecks({&decks[0], &decks[1]});
+    queue.start(kNow.toMSecsSinceEpoch());
+
+    const QList<int> expected = concatenateAndSort(decks);
+    QList<int> reviewed;
+    int grade = 0;
+    while (queue.hasNext()) {
+        const ReviewQueue::Item item = queue.next();
+        const int cardId = item.card.getId();
+        reviewed.append(cardId);
+        // Оценка перепланирует карточку и сдвигает её в индексе колоды
+        Deck &deck = decks[item.deck == &decks[0] ? 0 : 1];
+        QVERIFY(deck.reviewCard(cardId, grade++ % 6));
+    }
+    QCOMPARE(reviewed, expected);
+    QCOMPARE(decks[0].getDueCount(), 0);
+    QCOMPARE(decks[1].getDueCount(), 0);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestReviewQueue::testMergeVersusSort_data()
+{
+    QTest::addColumn<int>("cardsPerDeck");
+
+    QTest::newRow("1000x200") << 200;
+    QTest::newRow("1000x1000") << 1000;
+}
+
+void TestReviewQueue::testMergeVersusSort()
+{
+    // 1000 колод: первая порция сессии и полный обход очереди против
+    // склейки getDueCards() всех колод с сортировкой
+    QFETCH(int, cardsPerDeck);
+    if (cardsPerDeck > 200 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    constexpr int kDecks = 1000;
+    constexpr int kSession = 200;
+    FixedClock clock(kNow);
+    QList<Deck> decks;
+    decks.reserve(kDecks);
+    for (int i = 0; i < kDecks; i++) {
+        decks.append(makeDeck(i + 1, cardsPerDeck, &clock, i));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QList<int> naive = concatenateAndSort(decks);
+    const qint64 naiveNSecs = timer.nsecsElapsed();
+
+    ReviewQueue queue;
+    for (const Deck &deck : decks) {
+        queue.addDeck(&deck);
+    }
+    timer.restart();
+    queue.start(kNow.toMSecsSinceEpoch());
+    const QList<int> session = drain(queue, kSession);
+    const qint64 sessionNSecs = timer.nsecsElapsed();
+
+    timer.restart();
+    queue.start(kNow.toMSecsSinceEpoch());
+    const QList<int> merged = drain(queue);
+    const qint64 mergeNSecs = timer.nsecsElapsed();
+
+    QCOMPARE(merged, naive);
+    QCOMPARE(session, naive.mid(0, kSession));
+    // Первая порция не зависит от общего числа готовых карточек
+    QVERIFY(sessionNSecs * 10 < naiveNSecs);
+
+    qDebug() << "Decks:" << kDecks << "cards:" << kDecks * cardsPerDeck << "due:" << naive.size()
+             << "concatenate+sort:" << naiveNSecs / 1000000.0 << "ms,"
+             << "queue first" << kSession << ":" << sessionNSecs / 1000000.0 << "ms,"
+             << "queue drain:" << mergeNSecs / 1000000.0 << "ms";
+}
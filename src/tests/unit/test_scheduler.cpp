@@ -0,0 +1,393 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <cmath>
+#include "TestScheduler.h"
+#include "FsrsScheduler.h"
+#include "Scheduler.h"
+#include "Deck.h"
+
+namespace {
+
+const QDateTime kStart = QDateTime(QDate(2024, 3, 1), QTime(9, 0));
+constexpr qint64 kMSecsPerDay = 24LL * 60 * 60 * 1000;
+
+Card makeCard(int id)
+{
+    return Card(id, QString("Вопрос %1").arg(id), QString("Ответ %1").arg(id),
+                ContentType::Text, TestMode::DirectAnswer,
+                2.5f, 0, 0, QDateTime(), QDateTime(), 1);
+}
+
+SchedulingState reviewed(const Scheduler &scheduler, const QList<int> &grades, const QList<double> &elapsed)
+{
+    SchedulingState state;
+    for (qsizetype i = 0; i < grades.size(); ++i) {
+        scheduler.review(state, grades[i], elapsed[i]);
+    }
+    return state;
+}
+
+/**
+ * @brief Итог воспроизведения истории одним планировщиком
+ */
+struct Replay {
+    qint64 reviews = 0;         ///< Все повторения, включая первые
+    qint64 recalls = 0;         ///< Вспомненных среди повторных
+    qint64 checks = 0;          ///< Повторных (не первых) повторений
+    QList<ReviewRecord> history;
+
+    double recallRate() const { return checks > 0 ? double(recalls) / double(checks) : 0.0; }
+};
+
+/**
+ * @brief Провести учащегося по расписанию планировщика
+ *
+ * Учащийся моделируется кривой забывания FSRS со скрытой от
+ * планировщика трудностью каждой карточки: вероятность вспомнить
+ * убывает со временем, успешное повторение увеличивает истинную
+ * стабильность, ошибка уменьшает её. Генератор карточки засевается
+ * её номером, поэтому все планировщики видят одного и того же
+ * учащегося. Оценка зависит только от истинной трудности.
+ */
+Replay replay(const Scheduler &scheduler, int cardCount, int days, bool keepHistory)
+{
+    const FsrsScheduler::Weights w = FsrsScheduler::defaultWeights();
+    Replay result;
+    for (int card = 0; card < cardCount; ++card) {
+        QRandomGenerator random(quint32(card + 1));
+        const double hardness = 1.0 + 9.0 * random.generateDouble();
+        double trueStability = std::max(0.1, w[2] * (11.0 - hardness) / 6.0);
+
+        SchedulingState state;
+        int day = 0;
+        int last = -1;
+        while (day < days) {
+            const double elapsed = last < 0 ? 0.0 : double(day - last);
+            bool recalled = true;
+            if (last >= 0) {
+                const double p = std::pow(1.0 + 19.0 / 81.0 * elapsed / trueStability, -0.5);
+                recalled = random.generateDouble() < p;
+                if (recalled) {
+                    trueStability *= 1.0 + std::exp(w[8]) * (11.0 - hardness) * std::pow(trueStability, -w[9])
+                                           * (std::exp(w[10] * (1.0 - p)) - 1.0);
+                } else {
+                    trueStability = std::min(trueStability, w[11] * std::pow(hardness, -w[12])
+                                                                * (std::pow(trueStability + 1.0, w[13]) - 1.0)
+                                                                * std::exp(w[14] * (1.0 - p)));
+                }
+                ++result.checks;
+                result.recalls += recalled ? 1 : 0;
+            }
+            const int grade = !recalled ? 1 : hardness < 4.0 ? 5 : hardness < 7.0 ? 4 : 3;
+            scheduler.review(state, grade, elapsed);
+            ++result.reviews;
+            if (keepHistory) {
+                ReviewRecord record;
+                record.cardId = card + 1;
+                record.grade = grade;
+                record.reviewedAt = kStart.toMSecsSinceEpoch() + qint64(day) * kMSecsPerDay;
+                result.history.append(record);
+            }
+            last = day;
+            day += state.intervalDays;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+// ==================== SM-2 ====================
+
+void TestScheduler::testSm2MatchesUpdateSM2()
+{
+    FixedClock clock(kStart);
+    Card legacy = makeCard(1);
+    Card pluggable = makeCard(1);
+
+    for (int grade : {5, 4, 3, 5, 1, 4, 5, 0, 2, 5}) {
+        legacy.updateSM2(grade, clock);
+        pluggable.review(grade, Scheduler::defaultScheduler(), clock);
+        QCOMPARE(pluggable.getEasyFactor(), legacy.getEasyFactor());
+        QCOMPARE(pluggable.getIntervalDays(), legacy.getIntervalDays());
+        QCOMPARE(pluggable.getRepetitions(), legacy.getRepetitions());
+        QCOMPARE(pluggable.getLastReview(), legacy.getLastReview());
+        QCOMPARE(pluggable.getNextReview(), legacy.getNextReview());
+        clock.advanceDays(legacy.getIntervalDays());
+    }
+    QCOMPARE(Scheduler::defaultScheduler().name(), QString("SM-2"));
+
+    // Модели памяти у SM-2 нет: к концу интервала вероятность 90%
+    SchedulingState state;
+    state.intervalDays = 10;
+    QVERIFY(qFuzzyCompare(Scheduler::defaultScheduler().retrievability(state, 10.0), 0.9));
+    QCOMPARE(Scheduler::elapsedDays(CardStore::kNoDate, 1000), 0.0);
+    QCOMPARE(Scheduler::elapsedDays(0, 36 * 60 * 60 * 1000), 1.5);
+}
+
+// ==================== FSRS ====================
+
+void TestScheduler::testFsrsFirstReview()
+{
+    const FsrsScheduler fsrs;
+    const FsrsScheduler::Weights w = FsrsScheduler::defaultWeights();
+
+    // Начальная стабильность - вес рейтинга, интервал при 90% равен стабильности
+    const SchedulingState again = reviewed(fsrs, {0}, {0.0});
+    const SchedulingState hard = reviewed(fsrs, {3}, {0.0});
+    const SchedulingState good = reviewed(fsrs, {4}, {0.0});
+    const SchedulingState easy = reviewed(fsrs, {5}, {0.0});
+    QCOMPARE(again.stability, w[0]);
+    QCOMPARE(hard.stability, w[1]);
+    QCOMPARE(good.stability, w[2]);
+    QCOMPARE(easy.stability, w[3]);
+    QCOMPARE(again.intervalDays, 1);
+    QCOMPARE(hard.intervalDays, 1);
+    QCOMPARE(good.intervalDays, 4);
+    QCOMPARE(easy.intervalDays, 14);
+    QCOMPARE(good.repetitions, 1);
+
+    // Трудность: Good - w4, каждая ступень рейтинга сдвигает её на w5
+    QCOMPARE(good.difficulty, w[4]);
+    QVERIFY(qFuzzyCompare(hard.difficulty, w[4] + w[5]));
+    QVERIFY(again.difficulty > hard.difficulty);
+    QVERIFY(easy.difficulty < good.difficulty);
+
+    // Трудность кодируется в факторе легкости: легче - больше
+    QVERIFY(easy.easyFactor > good.easyFactor);
+    QVERIFY(good.easyFactor > again.easyFactor);
+    QVERIFY(again.easyFactor >= 1.3f && easy.easyFactor <= 2.5f);
+
+    QCOMPARE(FsrsScheduler::rating(0), 1);
+    QCOMPARE(FsrsScheduler::rating(2), 1);
+    QCOMPARE(FsrsScheduler::rating(3), 2);
+    QCOMPARE(FsrsScheduler::rating(4), 3);
+    QCOMPARE(FsrsScheduler::rating(9), 4);
+}
+
+void TestScheduler::testFsrsForgettingCurve()
+{
+    const FsrsScheduler fsrs;
+    SchedulingState state;
+    state.stability = 10.0f;
+    state.difficulty = 5.0f;
+
+    QCOMPARE(fsrs.retrievability(state, 0.0), 1.0);
+    QVERIFY(qFuzzyCompare(fsrs.retrievability(state, 10.0), 0.9));
+    QVERIFY(fsrs.retrievability(state, 30.0) < fsrs.retrievability(state, 20.0));
+    QCOMPARE(fsrs.nextInterval(10.0f), 10);
+
+    // Меньшая желаемая вероятность - длиннее интервал
+    FsrsScheduler::Parameters relaxed;
+    relaxed.desiredRetention = 0.8;
+    const FsrsScheduler relaxedFsrs(relaxed);
+    QCOMPARE(relaxedFsrs.nextInterval(10.0f), 24);
+
+    FsrsScheduler::Parameters capped;
+    capped.maximumInterval = 30;
+    QCOMPARE(FsrsScheduler(capped).nextInterval(1000.0f), 30);
+    QCOMPARE(fsrs.nextInterval(0.01f), 1);
+}
+
+void TestScheduler::testFsrsRatingsOrderIntervals()
+{
+    const FsrsScheduler fsrs;
+    const SchedulingState start = reviewed(fsrs, {4, 4}, {0.0, 4.0});
+
+    QList<int> intervals;
+    for (int grade : {3, 4, 5}) {
+        SchedulingState state = start;
+        fsrs.review(state, grade, start.intervalDays);
+        intervals.append(state.intervalDays);
+        QVERIFY(state.stability > start.stability);
+    }
+    QVERIFY(intervals[0] < intervals[1]);
+    QVERIFY(intervals[1] < intervals[2]);
+
+    // Повторение позже срока дает больший прирост стабильности
+    SchedulingState onTime = start;
+    SchedulingState overdue = start;
+    fsrs.review(onTime, 4, start.intervalDays);
+    fsrs.review(overdue, 4, start.intervalDays * 3);
+    QVERIFY(overdue.stability > onTime.stability);
+
+    // Интервалы Good растут, пока карточка вспоминается
+    SchedulingState state;
+    int previous = 0;
+    for (int i = 0; i < 6; ++i) {
+        fsrs.review(state, 4, previous);
+        QVERIFY(state.intervalDays > previous);
+        previous = state.intervalDays;
+    }
+}
+
+void TestScheduler::testFsrsLapse()
+{
+    const FsrsScheduler fsrs;
+    SchedulingState state = reviewed(fsrs, {4, 4, 4}, {0.0, 4.0, 15.0});
+    const SchedulingState before = state;
+
+    fsrs.review(state, 1, before.intervalDays);
+    QVERIFY(state.stability < before.stability);
+    QVERIFY(state.difficulty > before.difficulty);
+    QVERIFY(state.intervalDays < before.intervalDays);
+    // Счетчик не сбрасывается: карточка остается изученной
+    QCOMPARE(state.repetitions, before.repetitions + 1);
+}
+
+void TestScheduler::testFsrsStateFromSm2Fields()
+{
+    // Карточка, которая планировалась по SM-2: стабильность выводится из интервала
+    const FsrsScheduler fsrs;
+    SchedulingState sm2;
+    sm2.easyFactor = 2.5f;
+    sm2.intervalDays = 20;
+    sm2.repetitions = 4;
+
+    SchedulingState state = sm2;
+    fsrs.review(state, 4, 20.0);
+    QVERIFY(state.stability > 20.0f);
+    QVERIFY(state.difficulty < 2.0f);
+
+    // То же состояние с явной моделью памяти дает тот же результат
+    SchedulingState explicitState = sm2;
+    explicitState.stability = 20.0f;
+    explicitState.difficulty = 1.0f;
+    fsrs.review(explicitState, 4, 20.0);
+    QCOMPARE(explicitState.intervalDays, state.intervalDays);
+    QVERIFY(qFuzzyCompare(explicitState.stability, state.stability));
+}
+
+// ==================== DECK ====================
+
+void TestScheduler::testDeckUsesScheduler()
+{
+    FixedClock clock(kStart);
+    const FsrsScheduler fsrs;
+
+    QList<Card> cards;
+    for (int i = 1; i <= 100; ++i) {
+        cards.append(makeCard(i));
+    }
+    Deck deck;
+    deck.setClock(&clock);
+    deck.setCards(cards);
+    Deck batch = deck;
+
+    QCOMPARE(&deck.getScheduler(), &Scheduler::defaultScheduler());
+    deck.setScheduler(&fsrs);
+    batch.setScheduler(&fsrs);
+    QCOMPARE(&deck.getScheduler(), static_cast<const Scheduler *>(&fsrs));
+
+    // Одиночные оценки, пакет и Card::review() дают одно и то же
+    QList<CardGrade> grades;
+    for (int i = 1; i <= 100; ++i) {
+        const int grade = i % 6;
+        QVERIFY(deck.reviewCard(i, grade));
+        grades.append({i, grade});
+        cards[i - 1].review(grade, fsrs, clock);
+    }
+    QCOMPARE(batch.applyGrades(grades), 100);
+
+    for (int i = 0; i < 100; ++i) {
+        const CardRef single = deck.getCardsView()[i];
+        const CardRef packed = batch.getCardsView()[i];
+        QCOMPARE(single.getIntervalDays(), cards[i].getIntervalDays());
+        QCOMPARE(single.getEasyFactor(), cards[i].getEasyFactor());
+        QCOMPARE(single.getNextReview(), cards[i].getNextReview());
+        QCOMPARE(packed.getIntervalDays(), single.getIntervalDays());
+        QCOMPARE(packed.getNextReviewMSecs(), single.getNextReviewMSecs());
+    }
+
+    // Индекс повторений следует за новыми сроками: Easy ждет 14 дней
+    QCOMPARE(deck.getDueCount(), 0);
+    clock.advanceDays(4);
+    const int dueGood = deck.getDueCount();
+    QVERIFY(dueGood > 0);
+    QCOMPARE(batch.getDueCount(), dueGood);
+    clock.advanceDays(10);
+    QCOMPARE(deck.getDueCount(), 100);
+
+    // Сброс планировщика возвращает SM-2
+    deck.setScheduler(nullptr);
+    QCOMPARE(&deck.getScheduler(), &Scheduler::defaultScheduler());
+}
+
+// ==================== EVALUATION ====================
+
+void TestScheduler::testEvaluatePrefersTrueParameters()
+{
+    const Replay run = replay(FsrsScheduler(), 5000, 365, true);
+    QVERIFY(!run.history.isEmpty());
+
+    // История в обратном порядке: evaluate() сам упорядочивает ответы
+    QList<ReviewRecord> shuffled(run.history.crbegin(), run.history.crend());
+
+    QList<FsrsScheduler::Parameters> candidates;
+    candidates.append(FsrsScheduler::Parameters());
+    FsrsScheduler::Parameters slow;
+    slow.weights[8] -= 1.0f;
+    candidates.append(slow);
+    FsrsScheduler::Parameters flat;
+    flat.weights = {1, 1, 1, 1, 5, 1, 1, 0, 1, 0, 1, 1, 0, 0, 1, 1, 1};
+    candidates.append(flat);
+
+    QElapsedTimer timer;
+    timer.start();
+    const QList<FsrsScheduler::Evaluation> parallel = FsrsScheduler::evaluate(shuffled, candidates, 4);
+    const qint64 parallelMSecs = timer.elapsed();
+    const QList<FsrsScheduler::Evaluation> sequential = FsrsScheduler::evaluate(run.history, candidates, 1);
+
+    QCOMPARE(parallel.size(), 3);
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(parallel[i].logLoss, sequential[i].logLoss);
+        QCOMPARE(parallel[i].predictions, run.checks);
+        QVERIFY(std::isfinite(parallel[i].logLoss));
+    }
+    QCOMPARE(parallel[0].actualRecall, run.recallRate());
+
+    qDebug() << "Reviews:" << run.history.size() << "candidates:" << candidates.size()
+             << "evaluated in" << parallelMSecs << "ms, log-loss:"
+             << parallel[0].logLoss << parallel[1].logLoss << parallel[2].logLoss;
+
+    // Веса, по которым обновлялась истинная стабильность, предсказывают лучше
+    QVERIFY(parallel[0].logLoss < parallel[1].logLoss);
+    QVERIFY(parallel[0].logLoss < parallel[2].logLoss);
+    QVERIFY(FsrsScheduler::evaluate({}, candidates)[0].predictions == 0);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestScheduler::testReplayReviewCounts()
+{
+    // Год занятий 20k карточек: сколько повторений назначает каждый
+    // планировщик и какая доля карточек вспоминается
+    constexpr int kCards = 20000;
+    constexpr int kDays = 365;
+
+    QElapsedTimer timer;
+    timer.start();
+    const Replay sm2 = replay(Scheduler::defaultScheduler(), kCards, kDays, false);
+    const qint64 sm2MSecs = timer.restart();
+    qDebug() << "SM-2: reviews" << sm2.reviews << "recall" << sm2.recallRate() << "in" << sm2MSecs << "ms";
+
+    QList<Replay> fsrsRuns;
+    for (double retention : {0.95, 0.9, 0.85, 0.8}) {
+        FsrsScheduler::Parameters parameters;
+        parameters.desiredRetention = retention;
+        timer.restart();
+        fsrsRuns.append(replay(FsrsScheduler(parameters), kCards, kDays, false));
+        const Replay &run = fsrsRuns.last();
+        qDebug() << "FSRS" << retention << ": reviews" << run.reviews
+                 << "(" << 100.0 * double(run.reviews) / double(sm2.reviews) << "% of SM-2)"
+                 << "recall" << run.recallRate() << "in" << timer.elapsed() << "ms";
+    }
+
+    // Желаемая вероятность - ручка "нагрузка против запоминания"
+    for (qsizetype i = 1; i < fsrsRuns.size(); ++i) {
+        QVERIFY(fsrsRuns[i].reviews < fsrsRuns[i - 1].reviews);
+        QVERIFY(fsrsRuns[i].recallRate() < fsrsRuns[i - 1].recallRate());
+    }
+    QVERIFY(sm2.reviews >= kCards);
+}
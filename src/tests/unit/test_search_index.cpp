@@ -0,0 +1,422 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <algorithm>
+#include "TestSearchIndex.h"
+#include "SearchIndex.h"
+#include "CardRepository.h"
+#include "Database.h"
+#include "Deck.h"
+
+namespace {
+
+const char *const kWords[] = {
+    "кошка", "собака", "дом", "река", "солнце", "ёлка", "зима", "лето",
+    "apple", "house", "river", "sun", "tree", "winter", "summer", "book",
+    "читать", "писать", "бежать", "думать", "время", "город", "слово", "день"
+};
+constexpr int kWordCount = int(sizeof(kWords) / sizeof(kWords[0]));
+
+Card makeCard(int id, const QString &question, const QString &answer)
+{
+    return Card(id, question, answer, ContentType::Text, TestMode::DirectAnswer,
+                2.5f, 0, 0, QDateTime(), QDateTime(), 1);
+}
+
+/**
+ * @brief Колода со словарными карточками: слова выбираются по номеру
+ */
+QList<Card> makeCards(int count, int firstId = 1)
+{
+    QList<Card> cards;
+    cards.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const int id = firstId + i;
+        const QString question = QString("%1 %2 %3 №%4").arg(kWords[i % kWordCount],
+                                                              kWords[(i / kWordCount) % kWordCount],
+                                                              kWords[(i * 7 + 3) % kWordCount])
+                                                          .arg(id);
+        const QString answer = QString("%1 %2").arg(kWords[(i * 13 + 5) % kWordCount],
+                                                     kWords[(i / 97) % kWordCount]);
+        cards.append(makeCard(id, question, answer));
+    }
+    return cards;
+}
+
+QList<int> sorted(QList<int> ids)
+{
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+ * @brief Поиск перебором: все слова запроса (без префиксов и фраз)
+ */
+QList<int> bruteForce(const QList<Card> &cards, const QString &query)
+{
+    const QStringList words = SearchIndex::tokenize(query);
+    QList<int> ids;
+    for (const Card &card : cards) {
+        const QStringList tokens = SearchIndex::tokenize(card.getQuestion() + ' ' + card.getAnswer());
+        if (std::all_of(words.begin(), words.end(),
+                        [&tokens](const QString &word) { return tokens.contains(word); })) {
+            ids.append(card.getId());
+        }
+    }
+    return ids;
+}
+
+int connectionCounter = 0;
+
+} // namespace
+
+// ==================== TOKENIZER ====================
+
+void TestSearchIndex::testTokenizeUnicode()
+{
+    QCOMPARE(SearchIndex::tokenize("Привет, МИР! Hello-World 42"),
+             QStringList({"привет", "мир", "hello", "world", "42"}));
+    QCOMPARE(SearchIndex::tokenize("ЁЛКА Ёлка ёлка"), QStringList({"ёлка", "ёлка", "ёлка"}));
+
+    // Разложенная "й" (и + кратка) приводится к составной
+    const QString decomposed = QString("мо") + QChar(0x0438) + QChar(0x0306);
+    QCOMPARE(SearchIndex::tokenize(decomposed), QStringList({"мой"}));
+
+    // Знаки препинания и смешанные письменности
+    QCOMPARE(SearchIndex::tokenize("  ...  "), QStringList());
+    QCOMPARE(SearchIndex::tokenize("Straße—улица"), QStringList({"straße", "улица"}));
+
+    // Суррогатная пара - часть слова
+    const QString gothic = QString::fromUtf8("a\U00010330b");
+    QCOMPARE(SearchIndex::tokenize(gothic).size(), 1);
+}
+
+void TestSearchIndex::testToFts5Query()
+{
+    QCOMPARE(SearchIndex::toFts5Query("Кошка дом*"), QString("\"кошка\" \"дом\"*"));
+    QCOMPARE(SearchIndex::toFts5Query("\"Красный  дом\" река"), QString("\"красный дом\" \"река\""));
+    QCOMPARE(SearchIndex::toFts5Query("e-mail"), QString("\"e mail\""));
+    QCOMPARE(SearchIndex::toFts5Query("\"OR\" AND"), QString("\"or\" \"and\""));
+    QVERIFY(SearchIndex::toFts5Query(" - * \"\" ").isEmpty());
+}
+
+// ==================== QUERIES ====================
+
+void TestSearchIndex::testWordAndPrefixQueries()
+{
+    SearchIndex index;
+    index.addCard(1, "Кошка сидит на крыше", "The cat");
+    index.addCard(2, "Собака бежит", "The dog runs");
+    index.addCard(3, "кошка и собака", "cats and dogs");
+    index.addCard(4, "Кошачий корм", "");
+
+    QCOMPARE(index.search("кошка"), QList<int>({1, 3}));
+    QCOMPARE(index.search("КОШКА собака"), QList<int>({3}));
+    QCOMPARE(index.search("the"), QList<int>({1, 2}));
+    QCOMPARE(index.search("кош*"), QList<int>({1, 3, 4}));
+    QCOMPARE(index.search("dog*"), QList<int>({2, 3}));
+    QCOMPARE(index.search("кот"), QList<int>());
+    QCOMPARE(index.search("кошка кот"), QList<int>());
+    QCOMPARE(index.search("   "), QList<int>());
+    QVERIFY(index.contains(4));
+    QCOMPARE(index.size(), 4);
+
+    // Совпадение с перебором на большой выборке
+    const QList<Card> cards = makeCards(3000);
+    SearchIndex large;
+    for (const Card &card : cards) {
+        large.addCard(card.getId(), card.getQuestion(), card.getAnswer());
+    }
+    for (const QString &query : {QString("кошка"), QString("дом река"), QString("apple зима лето"),
+                                 QString("ёлка №17"), QString("солнце tree")}) {
+        QCOMPARE(large.search(query), bruteForce(cards, query));
+    }
+}
+
+void TestSearchIndex::testPhraseQueries()
+{
+    SearchIndex index;
+    index.addCard(1, "красный дом у реки", "");
+    index.addCard(2, "дом красный", "");
+    index.addCard(3, "красный", "дом");
+    index.addCard(4, "очень красный дом", "красный дом");
+
+    QCOMPARE(index.search("\"красный дом\""), QList<int>({1, 4}));
+    QCOMPARE(index.search("\"дом красный\""), QList<int>({2}));
+    // Фраза не переходит из вопроса в ответ
+    QCOMPARE(index.search("красный дом"), QList<int>({1, 2, 3, 4}));
+    QCOMPARE(index.search("\"красный дом\" реки"), QList<int>({1}));
+    // Слово через дефис ищется как фраза
+    index.addCard(5, "электронная почта: e-mail", "");
+    index.addCard(6, "e и mail отдельно", "");
+    QCOMPARE(index.search("e-mail"), QList<int>({5}));
+}
+
+void TestSearchIndex::testLimit()
+{
+    SearchIndex index;
+    for (int i = 1; i <= 100; i++) {
+        index.addCard(i, "общее слово", QString::number(i));
+    }
+    QCOMPARE(index.search("общее", 10).size(), 10);
+    QCOMPARE(index.search("общее", 10).first(), 1);
+    QCOMPARE(index.search("общее", 0), QList<int>());
+    QCOMPARE(index.search("общее").size(), 100);
+}
+
+// ==================== UPDATES ====================
+
+void TestSearchIndex::testDeckKeepsIndexInSync()
+{
+    SearchIndex index;
+    Deck deck;
+    deck.setCards(makeCards(100));
+    deck.setSearchIndex(&index);
+    QCOMPARE(index.size(), 100);
+
+    deck.addCard(makeCard(1000, "Новая карточка", "уникальное слово"));
+    QCOMPARE(index.search("уникальное"), QList<int>({1000}));
+
+    deck.addCards({makeCard(1001, "пакет", "первый"), makeCard(1002, "пакет", "второй")});
+    QCOMPARE(index.search("пакет"), QList<int>({1001, 1002}));
+
+    QVERIFY(deck.removeCard(1001));
+    QCOMPARE(index.search("пакет"), QList<int>({1002}));
+
+    // Правка текста через updateCard() переиндексирует карточку
+    Card edited = deck.getCards().last();
+    edited.setQuestion("исправленный вопрос");
+    QVERIFY(deck.updateCard(edited));
+    QCOMPARE(index.search("пакет"), QList<int>());
+    QCOMPARE(index.search("исправленный"), QList<int>({1002}));
+    QVERIFY(!deck.updateCard(makeCard(5000, "нет", "такой")));
+    QVERIFY(index.search("такой").isEmpty());
+
+    // Замена всех карточек перестраивает индекс
+    deck.setCards({makeCard(7, "только", "одна")});
+    QCOMPARE(index.size(), 1);
+    QCOMPARE(index.search("только"), QList<int>({7}));
+    QVERIFY(index.search("кошка").isEmpty());
+
+    // Замененный индекс больше не содержит карточек колоды
+    SearchIndex other;
+    deck.setSearchIndex(&other);
+    QCOMPARE(index.size(), 0);
+    QVERIFY(other.contains(7));
+
+    // Колода, сбросившая текст, уходит из индекса и удаляет из него по идентификатору
+    deck.setSearchIndex(&index);
+    QVERIFY(!other.contains(7));
+    deck.addCard(makeCard(9, "девятая", "карточка"));
+    deck.setMetadataOnly(true);
+    QCOMPARE(index.size(), 0);
+    QVERIFY(deck.removeCard(9));
+    QVERIFY(deck.updateCard(makeCard(7, "только", "одна")));
+    QCOMPARE(index.size(), 0);
+    deck.setMetadataOnly(false);
+
+    deck.setSearchIndex(nullptr);
+    QVERIFY(!index.contains(7));
+    deck.addCard(makeCard(8, "без", "индекса"));
+    QVERIFY(!index.contains(8));
+}
+
+void TestSearchIndex::testCompaction()
+{
+    SearchIndex index;
+    const QList<Card> cards = makeCards(5000);
+    for (const Card &card : cards) {
+        index.addCard(card.getId(), card.getQuestion(), card.getAnswer());
+    }
+    const qint64 postings = index.stats().postings;
+
+    // Повторное обновление оставляет удаленные документы до уплотнения
+    for (int i = 0; i < 500; i++) {
+        QVERIFY(index.updateCard(cards[i].getId(), cards[i].getQuestion(), cards[i].getAnswer()));
+    }
+    QCOMPARE(index.stats().deletedDocuments, 500);
+    QCOMPARE(index.size(), 5000);
+    QCOMPARE(sorted(index.search("кошка")), bruteForce(cards, "кошка"));
+
+    index.compact();
+    QCOMPARE(index.stats().deletedDocuments, 0);
+    QCOMPARE(index.stats().postings, postings);
+    QCOMPARE(sorted(index.search("кошка")), bruteForce(cards, "кошка"));
+
+    // Уплотнение запускается само, когда удаленных больше живых
+    for (int i = 0; i < 4000; i++) {
+        QVERIFY(index.removeCard(cards[i].getId()));
+    }
+    QVERIFY(!index.removeCard(cards[0].getId()));
+    QVERIFY(index.stats().deletedDocuments < index.size());
+    QCOMPARE(index.search("кошка"), bruteForce(cards.mid(4000), "кошка"));
+}
+
+// ==================== FILE AND DATABASE ====================
+
+void TestSearchIndex::testSaveAndLoad()
+{
+    QTemporaryDir dir;
+    const QString path = SearchIndex::pathFor(dir.filePath("cards.db"));
+    QCOMPARE(path, dir.filePath("cards.db.search"));
+
+    const QList<Card> cards = makeCards(2000);
+    SearchIndex index;
+    for (const Card &card : cards) {
+        index.addCard(card.getId(), card.getQuestion(), card.getAnswer());
+    }
+    index.removeCard(5);
+    index.addCard(5000, "Ёжик в тумане", "\"цитата\"");
+    QVERIFY2(index.save(path), qPrintable(index.lastError()));
+
+    SearchIndex loaded;
+    QVERIFY2(loaded.load(path), qPrintable(loaded.lastError()));
+    QCOMPARE(loaded.size(), index.size());
+    QCOMPARE(loaded.stats().terms, index.stats().terms);
+    QCOMPARE(loaded.stats().postings, index.stats().postings);
+    for (const QString &query : {QString("кошка"), QString("дом*"), QString("\"ёжик в\""),
+                                 QString("apple река"), QString("цитата")}) {
+        QCOMPARE(loaded.search(query), index.search(query));
+    }
+    QVERIFY(!loaded.contains(5));
+}
+
+void TestSearchIndex::testLoadRejectsCorruptFile()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("index.search");
+    SearchIndex index;
+    for (const Card &card : makeCards(200)) {
+        index.addCard(card.getId(), card.getQuestion(), card.getAnswer());
+    }
+    QVERIFY(index.save(path));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray bytes = file.readAll();
+    file.close();
+
+    const QByteArray variants[] = {
+        QByteArray(),
+        QByteArray("QCSX") + bytes.mid(4),
+        bytes.left(bytes.size() / 2),
+        bytes + QByteArray(3, '\0'),
+    };
+    for (const QByteArray &variant : variants) {
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(variant);
+        file.close();
+
+        SearchIndex loaded;
+        loaded.addCard(1, "старое", "");
+        QVERIFY(!loaded.load(path));
+        QVERIFY(!loaded.lastError().isEmpty());
+        QCOMPARE(loaded.size(), 0);
+    }
+    QVERIFY(!index.load(dir.filePath("missing.search")));
+}
+
+void TestSearchIndex::testMatchesFts5()
+{
+    const QString connectionName = QString("test_search_index_%1").arg(++connectionCounter);
+    {
+        QString error;
+        QSqlDatabase database = Database::open(":memory:", connectionName, &error);
+        QVERIFY2(database.isOpen(), qPrintable(error));
+
+        QList<Card> cards = makeCards(2000);
+        cards.append(makeCard(3000, "Красный дом у реки", "ЁЛКА"));
+        cards.append(makeCard(3001, "дом красный", "e-mail"));
+        CardRepository repository(database);
+        QVERIFY2(repository.insertCards(1, cards), qPrintable(repository.lastError()));
+
+        // Индекс FTS5 создается только по запросу и заполняется уже сохраненными карточками
+        QVERIFY(!Database::hasFullTextSearch(database));
+        QCOMPARE(repository.search("кошка"), QList<int>());
+        QVERIFY(!repository.lastError().isEmpty());
+        QVERIFY2(Database::enableFullTextSearch(database, &error), qPrintable(error));
+        QVERIFY(Database::enableFullTextSearch(database));
+        QVERIFY(Database::hasFullTextSearch(database));
+
+        SearchIndex index;
+        for (const Card &card : cards) {
+            index.addCard(card.getId(), card.getQuestion(), card.getAnswer());
+        }
+
+        const QString queries[] = {
+            "кошка", "Дом река", "дом*", "\"красный дом\"", "ёлка", "e-mail",
+            "apple зима", "сол* tree", "№17", "несуществующее"
+        };
+        for (const QString &query : queries) {
+            const QList<int> expected = sorted(index.search(query));
+            QCOMPARE(repository.search(query), expected);
+        }
+        QCOMPARE(repository.search("кошка", 3), sorted(index.search("кошка")).mid(0, 3));
+
+        // Занятый идентификатор не перезаписывает карточку
+        QVERIFY(!repository.insertCards(1, {makeCard(3000, "синий дом", "")}));
+        QCOMPARE(repository.search("синий"), QList<int>());
+
+        // Удаление и вставка карточки обновляют FTS5 триггерами
+        QVERIFY(repository.removeCard(3000));
+        QVERIFY(repository.insertCards(1, {makeCard(3000, "синий дом", "")}));
+        QCOMPARE(repository.search("\"красный дом\""), QList<int>());
+        QCOMPARE(repository.search("синий"), QList<int>({3000}));
+        QVERIFY(repository.removeCard(3000));
+        QCOMPARE(repository.search("синий"), QList<int>());
+
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestSearchIndex::testQueryLatency_data()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("200k") << 200000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestSearchIndex::testQueryLatency()
+{
+    // Время построения, размер индекса и время запросов разных видов
+    QFETCH(int, cardCount);
+    if (cardCount > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    Deck deck;
+    deck.setCards(makeCards(cardCount));
+
+    SearchIndex index;
+    QElapsedTimer timer;
+    timer.start();
+    deck.setSearchIndex(&index);
+    const qint64 buildMSecs = timer.elapsed();
+    QCOMPARE(index.size(), cardCount);
+
+    const QString queries[] = {
+        "№123456", "кошка река", "apple зима лето", "\"кошка собака\"", "книг*", "дом*", "время"
+    };
+    constexpr int kRepeats = 20;
+    for (const QString &query : queries) {
+        int found = 0;
+        timer.restart();
+        for (int i = 0; i < kRepeats; i++) {
+            found = index.search(query, 50).size();
+        }
+        const double averageMSecs = double(timer.nsecsElapsed()) / 1e6 / kRepeats;
+        qDebug() << "Cards:" << cardCount << "query:" << query
+                 << "found:" << found << "avg:" << averageMSecs << "ms";
+        QVERIFY2(averageMSecs < 5.0, qPrintable(query));
+    }
+
+    const SearchIndex::Stats stats = index.stats();
+    qDebug() << "Cards:" << cardCount << "build:" << buildMSecs << "ms,"
+             << "terms:" << stats.terms << "postings:" << stats.postings
+             << "index:" << stats.memoryUsage / 1024 << "KiB";
+}
@@ -0,0 +1,422 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include "TestSnapshot.h"
+#include "CollectionSnapshot.h"
+#include "CardContentCache.h"
+#include "Database.h"
+#include "DeckRepository.h"
+#include "ReviewJournal.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/**
+ * @brief Колода со всеми вариантами полей карточки
+ */
+Deck makeDeck(int deckId, int count)
+{
+    Deck deck = TestDecks::buildDeck(deckId, count, [deckId](int i) {
+        const int id = deckId * 100000 + i;
+        const QDateTime next = i % 5 == 0 ? QDateTime() : kNow.addSecs(3600LL * (i % 48 - 24));
+        const QDateTime last = i % 7 == 0 ? QDateTime() : kNow.addDays(-(i % 30));
+        return Card(id, QString("Вопрос №%1 ✓").arg(id), i % 3 == 0 ? QString() : QString("Ответ %1").arg(i % 10),
+                    static_cast<ContentType>(i % 3), static_cast<TestMode>(i % 3),
+                    1.3f + 0.01f * (i % 150), i % 40, i % 9, next, last, deckId);
+    });
+    deck.setName(QString("Колода %1").arg(deckId));
+    return deck;
+}
+
+void compareDecks(const Deck &actual, const Deck &expected)
+{
+    QCOMPARE(actual.getId(), expected.getId());
+    QCOMPARE(actual.getName(), expected.getName());
+    QCOMPARE(actual.getCardCount(), expected.getCardCount());
+
+    const CardSpan actualCards = actual.getCardsView();
+    const CardSpan expectedCards = expected.getCardsView();
+    for (int row = 0; row < expected.getCardCount(); row++) {
+        const CardRef a = actualCards[row];
+        const CardRef e = expectedCards[row];
+        QCOMPARE(a.getId(), e.getId());
+        QCOMPARE(a.getDeckId(), e.getDeckId());
+        QCOMPARE(a.getContentType(), e.getContentType());
+        QCOMPARE(a.getTestMode(), e.getTestMode());
+        QCOMPARE(a.getEasyFactor(), e.getEasyFactor());
+        QCOMPARE(a.getIntervalDays(), e.getIntervalDays());
+        QCOMPARE(a.getRepetitions(), e.getRepetitions());
+        QCOMPARE(a.getNextReviewMSecs(), e.getNextReviewMSecs());
+        QCOMPARE(a.getLastReviewMSecs(), e.getLastReviewMSecs());
+        QCOMPARE(actual.indexOf(a.getId()), row);
+    }
+
+    // Индекс повторений открывается готовым и совпадает с перестроенным
+    DueCardRange actualDue = actual.getDueCardsView();
+    DueCardRange expectedDue = expected.getDueCardsView();
+    QCOMPARE(actualDue.size(), expectedDue.size());
+    auto it = actualDue.begin();
+    for (const CardRef &card : expectedDue) {
+        QCOMPARE((*it).getId(), card.getId());
+        ++it;
+    }
+}
+
+} // namespace
+
+// ==================== WRITE & READ ====================
+
+void TestSnapshot::testRoundTrip()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.snapshot");
+    FixedClock clock(kNow);
+    QList<Deck> decks{makeDeck(1, 500), makeDeck(2, 37)};
+    for (Deck &deck : decks) {
+        deck.setClock(&clock);
+    }
+
+    QString error;
+    QVERIFY2(CollectionSnapshot::write(path, decks, &error), qPrintable(error));
+
+    CollectionSnapshot snapshot(path);
+    QVERIFY2(snapshot.open(), qPrintable(snapshot.lastError()));
+    QCOMPARE(snapshot.deckIds(), QList<int>({1, 2}));
+    QCOMPARE(snapshot.cardCount(), 537);
+
+    for (const Deck &expected : decks) {
+        Deck loaded;
+        loaded.setClock(&clock);
+        QVERIFY2(snapshot.loadDeck(expected.getId(), loaded), qPrintable(snapshot.lastError()));
+        QVERIFY(!loaded.isMetadataOnly());
+        compareDecks(loaded, expected);
+
+        const QList<Card> loadedCards = loaded.getCards();
+        const QList<Card> expectedCards = expected.getCards();
+        for (int i = 0; i < expectedCards.size(); i++) {
+            QCOMPARE(loadedCards[i].getQuestion(), expectedCards[i].getQuestion());
+            QCOMPARE(loadedCards[i].getAnswer(), expectedCards[i].getAnswer());
+            QCOMPARE(loadedCards[i].getNextReview(), expectedCards[i].getNextReview());
+            QCOMPARE(loadedCards[i].getLastReview(), expectedCards[i].getLastReview());
+        }
+        QCOMPARE(loaded.getDueCount(), expected.getDueCount());
+
+        // Открытая колода остается изменяемой
+        const int cardId = loadedCards[1].getId();
+        QVERIFY(loaded.reviewCard(cardId, 5));
+        QVERIFY(loaded.removeCard(loadedCards[0].getId()));
+        QCOMPARE(loaded.indexOf(cardId), 0);
+    }
+
+    Deck missing;
+    QVERIFY(!snapshot.loadDeck(3, missing));
+    QVERIFY(!snapshot.lastError().isEmpty());
+}
+
+void TestSnapshot::testMetadataOnlyDeck()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.snapshot");
+    const Deck expected = makeDeck(1, 200);
+    QVERIFY(CollectionSnapshot::write(path, {expected}));
+
+    CollectionSnapshot snapshot(path);
+    QVERIFY(snapshot.open());
+    Deck lazy;
+    QVERIFY(snapshot.loadDeckMetadata(1, lazy));
+    QVERIFY(lazy.isMetadataOnly());
+    compareDecks(lazy, expected);
+    QVERIFY(lazy.getCards()[4].getQuestion().isEmpty());
+
+    // Текст загружается по требованию прямо из снимка
+    CardContentCache cache(&snapshot);
+    lazy.setContentCache(&cache);
+    const Card original = expected.getCards()[4];
+    QCOMPARE(lazy.getContent(original.getId()).question, original.getQuestion());
+    QCOMPARE(lazy.getContent(original.getId()).answer, original.getAnswer());
+
+    CardContent content;
+    QVERIFY(!snapshot.fetchContent(-1, content));
+
+    // Колода без текста не переписывается в снимок с пустыми строками
+    QString error;
+    QVERIFY(!CollectionSnapshot::write(dir.filePath("lazy.snapshot"), {lazy}, &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!QFile::exists(dir.filePath("lazy.snapshot")));
+}
+
+void TestSnapshot::testStringsAreInterned()
+{
+    QTemporaryDir dir;
+    QList<Card> repeated;
+    QList<Card> unique;
+    const QString text = QString("Повторяющийся текст ").repeated(10);
+    for (int i = 0; i < 1000; i++) {
+        repeated.append(Card(i, text, text, ContentType::Text, TestMode::DirectAnswer,
+                             2.5f, 0, 0, QDateTime(), QDateTime(), 1));
+        unique.append(Card(i, text + QString::number(i), text + QString::number(i), ContentType::Text,
+                           TestMode::DirectAnswer, 2.5f, 0, 0, QDateTime(), QDateTime(), 1));
+    }
+    Deck repeatedDeck;
+    repeatedDeck.setCards(repeated);
+    Deck uniqueDeck;
+    uniqueDeck.setCards(unique);
+
+    const QString repeatedPath = dir.filePath("repeated.snapshot");
+    const QString uniquePath = dir.filePath("unique.snapshot");
+    QVERIFY(CollectionSnapshot::write(repeatedPath, {repeatedDeck}));
+    QVERIFY(CollectionSnapshot::write(uniquePath, {uniqueDeck}));
+
+    // Одна копия текста вместо тысячи
+    QVERIFY(QFile(repeatedPath).size() * 10 < QFile(uniquePath).size());
+
+    CollectionSnapshot snapshot(repeatedPath);
+    QVERIFY(snapshot.open());
+    Deck loaded;
+    QVERIFY(snapshot.loadDeck(0, loaded));
+    QCOMPARE(loaded.getCards()[999].getQuestion(), text);
+}
+
+void TestSnapshot::testEmptyCollection()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("empty.snapshot");
+    Deck empty;
+    empty.setId(7);
+    QVERIFY(CollectionSnapshot::write(path, {empty}));
+
+    CollectionSnapshot snapshot(path);
+    QVERIFY2(snapshot.open(), qPrintable(snapshot.lastError()));
+    QCOMPARE(snapshot.cardCount(), 0);
+    Deck loaded;
+    QVERIFY(snapshot.loadDeck(7, loaded));
+    QCOMPARE(loaded.getCardCount(), 0);
+    QCOMPARE(loaded.getDueCount(), 0);
+}
+
+// ==================== INTEGRITY ====================
+
+void TestSnapshot::testRejectsMissingFile()
+{
+    QTemporaryDir dir;
+    CollectionSnapshot snapshot(dir.filePath("missing.snapshot"));
+    QVERIFY(!snapshot.open());
+    QVERIFY(!snapshot.isOpen());
+    QVERIFY(!snapshot.lastError().isEmpty());
+
+    Deck deck;
+    QVERIFY(!snapshot.loadDeck(1, deck));
+}
+
+void TestSnapshot::testRejectsForeignFile()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("foreign.snapshot");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(4096, 'x'));
+    file.close();
+
+    CollectionSnapshot snapshot(path);
+    QVERIFY(!snapshot.open());
+
+    // Обрезанный снимок
+    const QString truncatedPath = dir.filePath("truncated.snapshot");
+    QVERIFY(CollectionSnapshot::write(truncatedPath, {makeDeck(1, 100)}));
+    QFile truncated(truncatedPath);
+    QVERIFY(truncated.open(QIODevice::ReadWrite));
+    QVERIFY(truncated.resize(truncated.size() / 2));
+    truncated.close();
+
+    CollectionSnapshot truncatedSnapshot(truncatedPath);
+    QVERIFY(!truncatedSnapshot.open(false));
+}
+
+void TestSnapshot::testDetectsCorruptedSection()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("corrupted.snapshot");
+    QVERIFY(CollectionSnapshot::write(path, {makeDeck(1, 100)}));
+
+    // Портим последний байт - раздел строк
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(file.size() - 1));
+    const char last = file.read(1).at(0);
+    QVERIFY(file.seek(file.size() - 1));
+    file.write(QByteArray(1, char(last ^ 0x5A)));
+    file.close();
+
+    CollectionSnapshot snapshot(path);
+    QVERIFY(!snapshot.open());
+    QVERIFY(snapshot.lastError().contains("checksum"));
+
+    // Без проверки разделов снимок открывается, столбцы планирования целы
+    QVERIFY(snapshot.open(false));
+    Deck deck;
+    QVERIFY(snapshot.loadDeckMetadata(1, deck));
+    QCOMPARE(deck.getCardCount(), 100);
+}
+
+void TestSnapshot::testDetectsMalformedDueIndex()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("due.snapshot");
+    const qint64 dueAt = kNow.addDays(3).toMSecsSinceEpoch();
+    Deck deck;
+    deck.setId(1);
+    deck.setCards({Card(1, "Вопрос", "Ответ", ContentType::Text, TestMode::DirectAnswer,
+                        2.5f, 3, 1, QDateTime::fromMSecsSinceEpoch(dueAt), QDateTime(), 1)});
+    QVERIFY(CollectionSnapshot::write(path, {deck}));
+
+    // Раздел индекса идет после столбца дат, поэтому последнее вхождение
+    // даты - ключ записи индекса, за которым лежит её строка
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const QByteArray bytes = file.readAll();
+    const qsizetype key = bytes.lastIndexOf(QByteArray(reinterpret_cast<const char *>(&dueAt), sizeof(dueAt)));
+    QVERIFY(key > 0);
+    const qint32 badRow = 1000;
+    QVERIFY(file.seek(key + qsizetype(sizeof(dueAt))));
+    file.write(reinterpret_cast<const char *>(&badRow), sizeof(badRow));
+    file.close();
+
+    // Контрольная сумма раздела не проверяется, но строка индекса - да
+    CollectionSnapshot snapshot(path);
+    QVERIFY(!snapshot.open(false));
+    QVERIFY(!snapshot.isOpen());
+    QVERIFY(snapshot.lastError().contains("due index"));
+}
+
+// ==================== JOURNAL WRITE-BACK ====================
+
+void TestSnapshot::testJournalWriteBack()
+{
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.snapshot");
+    const QString journalPath = dir.filePath("reviews.journal");
+    FixedClock clock(kNow);
+    QVERIFY(CollectionSnapshot::write(path, {makeDeck(1, 300), makeDeck(2, 300)}));
+
+    CollectionSnapshot snapshot(path);
+    QVERIFY(snapshot.open());
+    Deck deck;
+    deck.setClock(&clock);
+    QVERIFY(snapshot.loadDeck(2, deck));
+
+    ReviewJournal::Options options;
+    options.syncToDisk = false;
+    ReviewJournal journal(journalPath, options);
+    QVERIFY(journal.open());
+
+    const QList<Card> cards = deck.getCards();
+    for (int i = 0; i < 50; i++) {
+        const int cardId = cards[i * 3].getId();
+        QVERIFY(deck.reviewCard(cardId, i % 6));
+        journal.append(ReviewRecord::fromCard(deck.getCardsView()[deck.indexOf(cardId)], i % 6));
+    }
+    QVERIFY2(journal.checkpoint(snapshot), qPrintable(journal.lastError()));
+    QVERIFY(ReviewJournal::readRecords(journalPath).isEmpty());
+    QVERIFY(snapshot.isOpen());
+
+    // Новое открытие видит перенесенные ответы и упорядоченный индекс
+    CollectionSnapshot reopened(path);
+    QVERIFY2(reopened.open(), qPrintable(reopened.lastError()));
+    Deck restored;
+    restored.setClock(&clock);
+    QVERIFY(reopened.loadDeck(2, restored));
+    compareDecks(restored, deck);
+    QCOMPARE(restored.getDueCount(), deck.getDueCount());
+
+    // Нетронутая колода не изменилась
+    Deck untouched;
+    QVERIFY(reopened.loadDeck(1, untouched));
+    compareDecks(untouched, makeDeck(1, 300));
+
+    // Восстановление после сбоя: ответы из журнала применяются к снимку
+    QVERIFY(deck.reviewCard(cards[1].getId(), 5));
+    journal.append(ReviewRecord::fromCard(deck.getCardsView()[deck.indexOf(cards[1].getId())], 5));
+    journal.close();
+    reopened.close();
+    QCOMPARE(ReviewJournal::recover(journalPath, snapshot), 1);
+    QVERIFY(reopened.open());
+    QVERIFY(reopened.loadDeck(2, restored));
+    compareDecks(restored, deck);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestSnapshot::testColdStart_data()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestSnapshot::testColdStart()
+{
+    // Открытие колоды из снимка против загрузки из SQLite
+    // и сборки колоды из QList<Card>
+    QFETCH(int, cardCount);
+    if (cardCount > 100000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("cold.snapshot");
+    const Deck source = makeDeck(1, cardCount);
+    const QList<Card> cards = source.getCards();
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(CollectionSnapshot::write(path, {source}));
+    const qint64 writeMSecs = timer.elapsed();
+
+    const QString connection = "snapshot_cold_start";
+    qint64 sqliteMSecs = 0;
+    {
+        QSqlDatabase database = Database::open(dir.filePath("cold.db"), connection);
+        QVERIFY(database.isOpen());
+        DeckRepository repository(database);
+        QVERIFY(repository.saveDeck(source));
+        Deck fromDatabase;
+        timer.restart();
+        QVERIFY(repository.loadDeck(1, fromDatabase));
+        sqliteMSecs = timer.elapsed();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connection);
+
+    Deck fromCards;
+    timer.restart();
+    fromCards.setCards(cards);
+    const qint64 setCardsMSecs = timer.elapsed();
+
+    CollectionSnapshot snapshot(path);
+    Deck full;
+    timer.restart();
+    QVERIFY(snapshot.open());
+    QVERIFY(snapshot.loadDeck(1, full));
+    const qint64 fullMSecs = timer.elapsed();
+
+    Deck lazy;
+    timer.restart();
+    QVERIFY(snapshot.open(false));
+    QVERIFY(snapshot.loadDeckMetadata(1, lazy));
+    const qint64 lazyMSecs = timer.elapsed();
+
+    qDebug() << "Cards:" << cardCount
+             << "snapshot size:" << QFile(path).size() / 1024 << "KiB, write:" << writeMSecs << "ms";
+    qDebug() << "SQLite loadDeck:" << sqliteMSecs << "ms,"
+             << "Deck::setCards(QList<Card>):" << setCardsMSecs << "ms";
+    qDebug() << "Snapshot open + loadDeck:" << fullMSecs << "ms,"
+             << "open without section checks + loadDeckMetadata:" << lazyMSecs << "ms";
+
+    QCOMPARE(full.getDueCount(), source.getDueCount());
+    QCOMPARE(lazy.getCardCount(), cardCount);
+    QVERIFY(lazyMSecs <= sqliteMSecs);
+}
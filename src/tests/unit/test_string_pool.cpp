@@ -0,0 +1,309 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QSet>
+#include <QThread>
+#include "TestStringPool.h"
+#include "StringPool.h"
+#include "CsvImporter.h"
+#include "Deck.h"
+
+namespace {
+
+/**
+ * @brief Строка с отдельным буфером, как после разбора файла
+ */
+QString fresh(const char *text)
+{
+    return QString::fromUtf8(QByteArray(text));
+}
+
+Card makeCard(int id, const QString &question, const QString &answer, StringPool *pool)
+{
+    return Card(id, question, answer, ContentType::Text, TestMode::DirectAnswer,
+                2.5f, 0, 0, QDateTime(), QDateTime(), 1, pool);
+}
+
+/**
+ * @brief Оценка кучи под текст карточек колоды
+ *
+ * Каждый различный буфер считается один раз: заголовок QArrayData,
+ * емкость в UTF-16 с завершающим нулем, округление блока malloc до 16 байт.
+ */
+qint64 textHeapBytes(const Deck &deck, qint64 *buffers = nullptr)
+{
+    QSet<const QChar *> seen;
+    qint64 bytes = 0;
+    auto account = [&](const QString &text) {
+        if (text.isEmpty() || seen.contains(text.constData())) {
+            return;
+        }
+        seen.insert(text.constData());
+        const qint64 block = 16 + (qint64(text.capacity()) + 1) * qint64(sizeof(QChar));
+        bytes += (block + 15) & ~qint64(15);
+    };
+    const CardSpan cards = deck.getCardsView();
+    for (int i = 0; i < cards.size(); i++) {
+        account(cards[i].getQuestion());
+        account(cards[i].getAnswer());
+    }
+    if (buffers) {
+        *buffers = seen.size();
+    }
+    return bytes;
+}
+
+/**
+ * @brief Сгенерированная колода: таблицы спряжений и словарь с общими переводами
+ *
+ * Половина записей - спряжения: 1500 глаголов, 6 времен, 6 лиц; одни
+ * и те же вопросы повторяются в колодах разных учебников, а формы
+ * разных лиц часто совпадают. Другая половина - словарь: слова
+ * повторяются по уровням и направлениям, переводы общие у синонимов.
+ */
+QByteArray generatedCsv(int rows)
+{
+    static const char *const kTenses[] = {"настоящее", "прошедшее", "будущее",
+                                          "имперфект", "условное", "сослагательное"};
+    static const char *const kPersons[] = {"я", "ты", "он/она", "мы", "вы", "они"};
+    static const char *const kEndings[] = {"e", "es", "ons", "ez"};
+
+    QByteArray csv("question,answer\n");
+    csv.reserve(qsizetype(rows) * 56);
+    for (int i = 0; i < rows; i++) {
+        const int j = i / 2;
+        QString question;
+        QString answer;
+        if (i % 2 == 0) {
+            const int verb = j % 1500;
+            const int tense = (j / 1500) % 6;
+            const int person = (j / 9000) % 6;
+            question = QString("Спрягите «verbe%1» (%2; %3)")
+                           .arg(verb).arg(kTenses[tense]).arg(kPersons[person]);
+            answer = QString("verbe%1-%2%3").arg(verb).arg(tense).arg(kEndings[person % 4]);
+        } else {
+            question = QString("Переведите слово «mot%1»").arg(j % 60000);
+            answer = QString("перевод номер %1").arg(j % 4000);
+        }
+        csv += question.toUtf8();
+        csv += ',';
+        csv += answer.toUtf8();
+        csv += '\n';
+    }
+    return csv;
+}
+
+bool importInto(Deck &deck, const QByteArray &csv, StringPool *pool, qint64 *elapsedMSecs = nullptr)
+{
+    CsvImporter::Options options;
+    options.deckId = 1;
+    options.stringPool = pool;
+    CsvImporter importer(options);
+    QBuffer buffer;
+    buffer.setData(csv);
+    buffer.open(QIODevice::ReadOnly);
+    const bool ok = importer.import(buffer, CsvImporter::deckSink(deck));
+    if (elapsedMSecs) {
+        *elapsedMSecs = importer.result().elapsedMSecs;
+    }
+    return ok && importer.result().malformed == 0;
+}
+
+} // namespace
+
+// ==================== POOL ====================
+
+void TestStringPool::testIntern()
+{
+    StringPool pool;
+    const QString first = fresh("Столица Франции?");
+    const QString second = fresh("Столица Франции?");
+    QVERIFY(first.constData() != second.constData());
+
+    const QString a = pool.intern(first);
+    const QString b = pool.intern(second);
+    QCOMPARE(a, second);
+    QCOMPARE(a.constData(), first.constData());
+    QCOMPARE(b.constData(), first.constData());
+    QVERIFY(pool.contains(fresh("Столица Франции?")));
+    QVERIFY(!pool.contains(fresh("Париж")));
+
+    // Пустые строки не хранятся
+    QVERIFY(pool.intern(QString()).isEmpty());
+    QVERIFY(pool.intern(fresh("")).isEmpty());
+    QCOMPARE(pool.size(), qsizetype(1));
+
+    // Повторный вызов с уже интернированной строкой не считается экономией
+    pool.intern(a);
+    const StringPool::Stats stats = pool.stats();
+    QCOMPARE(stats.strings, qsizetype(1));
+    QCOMPARE(stats.requests, qint64(3));
+    QCOMPARE(stats.hits, qint64(2));
+    QCOMPARE(stats.pooledBytes, qint64(first.size() * 2));
+    QCOMPARE(stats.savedBytes, qint64(second.size() * 2));
+
+    pool.clear();
+    QCOMPARE(pool.size(), qsizetype(0));
+    QCOMPARE(pool.stats().requests, qint64(0));
+    QCOMPARE(a, first);
+}
+
+void TestStringPool::testSqueeze()
+{
+    StringPool pool;
+    QString kept = pool.intern(fresh("Остается"));
+    pool.intern(fresh("Не используется"));
+    {
+        const QString temporary = pool.intern(fresh("Временная"));
+        QCOMPARE(pool.squeeze(), qsizetype(1));
+    }
+    QCOMPARE(pool.size(), qsizetype(2));
+
+    QCOMPARE(pool.squeeze(), qsizetype(1));
+    QVERIFY(pool.contains(kept));
+    QVERIFY(!pool.contains(fresh("Временная")));
+    QCOMPARE(pool.stats().pooledBytes, qint64(kept.size() * 2));
+
+    kept = QString();
+    QCOMPARE(pool.squeeze(), qsizetype(1));
+    QCOMPARE(pool.size(), qsizetype(0));
+}
+
+void TestStringPool::testConcurrentIntern()
+{
+    constexpr int kThreads = 8;
+    constexpr int kDistinct = 5000;
+    constexpr int kPerThread = 50000;
+
+    StringPool pool;
+    QList<QList<QString>> results(kThreads);
+    QList<QThread *> threads;
+    for (int t = 0; t < kThreads; t++) {
+        QList<QString> *out = &results[t];
+        out->resize(kDistinct);
+        threads.append(QThread::create([&pool, out, t]() {
+            for (int i = 0; i < kPerThread; i++) {
+                const int key = (i * 7919 + t * 104729) % kDistinct;
+                const QString text = pool.intern(QString("Текст %1").arg(key));
+                QString &seen = (*out)[key];
+                if (seen.isNull()) {
+                    seen = text;
+                } else if (seen.constData() != text.constData()) {
+                    seen = QString("несовпадение");
+                }
+            }
+        }));
+    }
+    for (QThread *thread : std::as_const(threads)) {
+        thread->start();
+    }
+    for (QThread *thread : std::as_const(threads)) {
+        QVERIFY(thread->wait(30000));
+        delete thread;
+    }
+
+    // Все потоки получили один и тот же буфер для каждого текста
+    QCOMPARE(pool.size(), qsizetype(kDistinct));
+    for (int key = 0; key < kDistinct; key++) {
+        const QChar *shared = nullptr;
+        for (int t = 0; t < kThreads; t++) {
+            const QString &text = results[t][key];
+            if (text.isNull()) {
+                continue;
+            }
+            QCOMPARE(text, QString("Текст %1").arg(key));
+            if (!shared) {
+                shared = text.constData();
+            }
+            QCOMPARE(text.constData(), shared);
+        }
+    }
+    const StringPool::Stats stats = pool.stats();
+    QCOMPARE(stats.requests, qint64(kThreads) * kPerThread);
+    QCOMPARE(stats.hits, stats.requests - kDistinct);
+}
+
+// ==================== CARDS ====================
+
+void TestStringPool::testCardConstruction()
+{
+    StringPool pool;
+    const Card first = makeCard(1, fresh("aller - je"), fresh("vais"), &pool);
+    const Card second = makeCard(2, fresh("aller - tu"), fresh("vas"), &pool);
+    const Card third = makeCard(3, fresh("aller - je"), fresh("vais"), &pool);
+    QCOMPARE(third.getQuestion(), QString("aller - je"));
+    QCOMPARE(third.getQuestion().constData(), first.getQuestion().constData());
+    QCOMPARE(third.getAnswer().constData(), first.getAnswer().constData());
+    QVERIFY(second.getAnswer().constData() != first.getAnswer().constData());
+    QCOMPARE(pool.size(), qsizetype(4));
+
+    // Без пула каждая карточка хранит свой буфер
+    const Card plain = makeCard(4, fresh("aller - je"), fresh("vais"), nullptr);
+    QVERIFY(plain.getQuestion().constData() != first.getQuestion().constData());
+    QCOMPARE(pool.size(), qsizetype(4));
+}
+
+void TestStringPool::testCsvImport()
+{
+    StringPool pool;
+    Deck deck;
+    QVERIFY(importInto(deck, generatedCsv(20000), &pool));
+    QCOMPARE(deck.getCardCount(), 20000);
+
+    // Одинаковый текст из разных блоков и потоков разбора - один буфер
+    const CardSpan cards = deck.getCardsView();
+    QCOMPARE(cards[1].getAnswer(), cards[1 + 2 * 4000].getAnswer());
+    QCOMPARE(cards[1].getAnswer().constData(), cards[1 + 2 * 4000].getAnswer().constData());
+    QCOMPARE(cards[1].getAnswer().constData(), cards[1 + 4 * 4000].getAnswer().constData());
+
+    qint64 buffers = 0;
+    textHeapBytes(deck, &buffers);
+    QCOMPARE(buffers, qint64(pool.size()));
+}
+
+// ==================== MEMORY ====================
+
+/**
+ * @brief Экономия памяти на тексте сгенерированной колоды из 500 тысяч карточек
+ *
+ * Колода импортируется без пула и с пулом; сравнивается оценка кучи,
+ * которую удерживает текст карточек после импорта. Временные строки
+ * разбора освобождаются сразу и в оценку не входят.
+ */
+void TestStringPool::testMemorySaved()
+{
+    // На меньшей колоде текст почти не повторяется, поэтому размер не уменьшается
+    if (!qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 500k-card benchmarks");
+    }
+
+    constexpr int kCards = 500000;
+    const QByteArray csv = generatedCsv(kCards);
+
+    qint64 plainMSecs = 0;
+    Deck plain;
+    QVERIFY(importInto(plain, csv, nullptr, &plainMSecs));
+    qint64 plainBuffers = 0;
+    const qint64 plainBytes = textHeapBytes(plain, &plainBuffers);
+    plain = Deck();
+
+    qint64 pooledMSecs = 0;
+    StringPool pool;
+    Deck pooled;
+    QVERIFY(importInto(pooled, csv, &pool, &pooledMSecs));
+    QCOMPARE(pooled.getCardCount(), kCards);
+    qint64 pooledBuffers = 0;
+    const qint64 pooledBytes = textHeapBytes(pooled, &pooledBuffers);
+
+    const StringPool::Stats stats = pool.stats();
+    QCOMPARE(qint64(stats.strings), pooledBuffers);
+    QCOMPARE(plainBuffers, qint64(kCards) * 2);
+
+    const double saved = 1.0 - double(pooledBytes) / double(plainBytes);
+    qDebug() << "Cards:" << kCards
+             << "text buffers:" << plainBuffers << "->" << pooledBuffers
+             << "text heap:" << plainBytes / 1024 << "KiB ->" << pooledBytes / 1024 << "KiB"
+             << "saved:" << qRound(saved * 100) << "%"
+             << "pool hits:" << stats.hits << "/" << stats.requests
+             << "import:" << plainMSecs << "ms ->" << pooledMSecs << "ms";
+    QVERIFY(saved > 0.5);
+}
@@ -0,0 +1,344 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QPair>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include "TestTaskRunner.h"
+#include "TaskRunner.h"
+#include "DeckTasks.h"
+#include "DeckHandoff.h"
+#include "CardTableModel.h"
+#include "CollectionSnapshot.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+Deck makeDeck(int deckId, int count)
+{
+    return TestDecks::buildDeck(deckId, count, [deckId](int i) {
+        const QDateTime next = i % 9 == 0 ? QDateTime() : kNow.addSecs(qint64(i % 5000) * 600);
+        return TestDecks::textCard(deckId * 10000000 + i, i, next, deckId, i % 30, i % 4);
+    });
+}
+
+/**
+ * @brief Дождаться сигнала finished() задачи id
+ * @return Аргументы сигнала; при тайм-ауте - неуспех с текстом ошибки
+ */
+QList<QVariant> waitFinished(QSignalSpy &spy, int id)
+{
+    for (;;) {
+        for (const QList<QVariant> &arguments : std::as_const(spy)) {
+            if (arguments.at(0).toInt() == id) {
+                return arguments;
+            }
+        }
+        if (!spy.wait(10000)) {
+            return {id, false, QString("Тайм-аут")};
+        }
+    }
+}
+
+} // namespace
+
+// ==================== TASKS ====================
+
+void TestTaskRunner::testRunAndProgress()
+{
+    TaskRunner runner(2);
+    QSignalSpy started(&runner, &TaskRunner::started);
+    QSignalSpy finished(&runner, &TaskRunner::finished);
+
+    // progress() выдается в рабочем потоке: получатель в этом потоке
+    // принимает его очередью событий
+    QList<QPair<qint64, qint64>> progress;
+    connect(&runner, &TaskRunner::progress, this, [&progress](int, qint64 done, qint64 total) {
+        progress.append({done, total});
+    });
+
+    constexpr qint64 kSteps = 2000000;
+    const int id = runner.run("Счет", [](TaskContext &context) {
+        for (qint64 step = 1; step <= kSteps; step++) {
+            context.setProgress(step, kSteps);
+        }
+        return true;
+    });
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(started.at(0).at(1).toString(), QString("Счет"));
+
+    const QList<QVariant> result = waitFinished(finished, id);
+    QCOMPARE(result.size(), 3);
+    QVERIFY(result.at(1).toBool());
+    QVERIFY(result.at(2).toString().isEmpty());
+    QCOMPARE(runner.activeCount(), 0);
+
+    // Прогресс прорежен, но последний сигнал - завершение
+    QVERIFY(progress.size() >= 1);
+    QVERIFY(progress.size() < 1000);
+    QCOMPARE(progress.last().first, kSteps);
+    QCOMPARE(progress.last().second, kSteps);
+
+    // Будущее доступно только до доставки finished()
+    QVERIFY(!runner.future(id).isValid());
+}
+
+void TestTaskRunner::testFailure()
+{
+    TaskRunner runner;
+    QSignalSpy finished(&runner, &TaskRunner::finished);
+
+    const int failing = runner.run("Ошибка", [](TaskContext &context) {
+        context.setError("File not found");
+        return false;
+    });
+    const int silent = runner.run("Без текста", [](TaskContext &) { return false; });
+
+    QList<QVariant> result = waitFinished(finished, failing);
+    QVERIFY(!result.at(1).toBool());
+    QCOMPARE(result.at(2).toString(), QString("File not found"));
+
+    result = waitFinished(finished, silent);
+    QVERIFY(!result.at(1).toBool());
+    QCOMPARE(result.at(2).toString(), QString("Task failed"));
+}
+
+void TestTaskRunner::testCancelRunning()
+{
+    TaskRunner runner(1);
+    QSignalSpy finished(&runner, &TaskRunner::finished);
+    std::atomic<bool> running{false};
+
+    const int id = runner.run("Бесконечная", [&running](TaskContext &context) {
+        running = true;
+        while (!context.isCanceled()) {
+            QThread::msleep(1);
+        }
+        return false;
+    });
+    const QFuture<bool> future = runner.future(id);
+    QTRY_VERIFY(running.load());
+    runner.cancel(id);
+
+    const QList<QVariant> result = waitFinished(finished, id);
+    QVERIFY(!result.at(1).toBool());
+    QCOMPARE(result.at(2).toString(), QString("Task cancelled"));
+    QVERIFY(future.isCanceled());
+    QVERIFY(future.isFinished());
+    QVERIFY(!runner.future(id).isValid());
+}
+
+void TestTaskRunner::testCancelQueued()
+{
+    TaskRunner runner(1);
+    QSignalSpy finished(&runner, &TaskRunner::finished);
+    std::atomic<bool> release{false};
+    std::atomic<bool> queuedRan{false};
+
+    const int blocking = runner.run("Первая", [&release](TaskContext &) {
+        while (!release) {
+            QThread::msleep(1);
+        }
+        return true;
+    });
+    const int queued = runner.run("Вторая", [&queuedRan](TaskContext &) {
+        queuedRan = true;
+        return true;
+    });
+    QCOMPARE(runner.activeCount(), 2);
+
+    runner.cancel(queued);
+    release = true;
+    QVERIFY(runner.waitForDone(10000));
+
+    QVERIFY(waitFinished(finished, blocking).at(1).toBool());
+    QVERIFY(!waitFinished(finished, queued).at(1).toBool());
+    QVERIFY(!queuedRan);
+
+    // Деструктор отменяет незавершенные задачи
+    {
+        TaskRunner scoped(1);
+        scoped.run("Бесконечная", [](TaskContext &context) {
+            while (!context.isCanceled()) {
+                QThread::msleep(1);
+            }
+            return false;
+        });
+    }
+}
+
+// ==================== HANDOFF ====================
+
+void TestTaskRunner::testHandoff()
+{
+    DeckHandoff handoff;
+    QVERIFY(!handoff.current());
+    QCOMPARE(handoff.version(), quint64(0));
+
+    TaskRunner runner(4);
+    for (int i = 1; i <= 8; i++) {
+        runner.run("Сборка", [&handoff, i](TaskContext &) {
+            handoff.publish(makeDeck(i, 100 * i));
+            return true;
+        });
+    }
+    QVERIFY(runner.waitForDone(10000));
+    QCOMPARE(handoff.version(), quint64(8));
+
+    // Интерфейс держит свою ссылку, пока её не отпустит
+    QSharedPointer<const Deck> held = handoff.current();
+    QVERIFY(held);
+    QCOMPARE(held->getCardCount(), held->getId() * 100);
+    handoff.publish(makeDeck(42, 10));
+    QCOMPARE(handoff.current()->getId(), 42);
+    QCOMPARE(held->getCardCount(), held->getId() * 100);
+
+    runner.releaseLater(std::move(held));
+    QVERIFY(!held);
+    QVERIFY(runner.waitForDone(10000));
+}
+
+void TestTaskRunner::testDeckTasks()
+{
+    QTemporaryDir dir;
+    const QString snapshotPath = dir.filePath("collection.snapshot");
+    QString error;
+    QVERIFY2(CollectionSnapshot::write(snapshotPath, {makeDeck(1, 3000), makeDeck(2, 10)}, &error),
+             qPrintable(error));
+
+    TaskRunner runner;
+    QSignalSpy finished(&runner, &TaskRunner::finished);
+    DeckHandoff handoff;
+
+    // Статистика без опубликованной колоды
+    ReviewForecast forecast;
+    int id = runner.run("Прогноз", DeckTasks::forecast(handoff, 30, forecast));
+    QList<QVariant> result = waitFinished(finished, id);
+    QVERIFY(!result.at(1).toBool());
+    QCOMPARE(result.at(2).toString(), QString("Deck is not loaded"));
+
+    id = runner.run("Загрузка", DeckTasks::loadSnapshot(snapshotPath, 1, handoff));
+    QVERIFY(waitFinished(finished, id).at(1).toBool());
+    QCOMPARE(handoff.current()->getCardCount(), 3000);
+    QCOMPARE(handoff.current()->getCardsView()[7].getQuestion(), QString("Вопрос 7"));
+
+    // Несуществующая колода: ошибка, прежняя колода остается
+    id = runner.run("Загрузка", DeckTasks::loadSnapshot(snapshotPath, 99, handoff));
+    result = waitFinished(finished, id);
+    QVERIFY(!result.at(1).toBool());
+    QVERIFY(!result.at(2).toString().isEmpty());
+    QCOMPARE(handoff.current()->getId(), 1);
+
+    // Статистика по опубликованной колоде
+    id = runner.run("Прогноз", DeckTasks::forecast(handoff, 30, forecast));
+    QVERIFY(waitFinished(finished, id).at(1).toBool());
+    QCOMPARE(forecast.total(), qint64(3000));
+
+    // Импорт CSV в новую колоду
+    const QString csvPath = dir.filePath("cards.csv");
+    QFile file(csvPath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("question,answer\n");
+    for (int i = 0; i < 500; i++) {
+        file.write(QString("Q%1,A%1\n").arg(i).toUtf8());
+    }
+    file.close();
+
+    int progress = 0;
+    connect(&runner, &TaskRunner::progress, this, [&progress]() { progress++; });
+    id = runner.run("Импорт", DeckTasks::importCsv(csvPath, 7, handoff));
+    QVERIFY(waitFinished(finished, id).at(1).toBool());
+    QCOMPARE(handoff.current()->getId(), 7);
+    QCOMPARE(handoff.current()->getCardCount(), 500);
+    QCOMPARE(handoff.current()->getCardsView()[499].getDeckId(), 7);
+    QVERIFY(progress >= 1);
+
+    id = runner.run("Импорт", DeckTasks::importCsv(dir.filePath("missing.csv"), 8, handoff));
+    QVERIFY(!waitFinished(finished, id).at(1).toBool());
+    QCOMPARE(handoff.current()->getId(), 7);
+}
+
+// ==================== LATENCY ====================
+
+void TestTaskRunner::testEventLoopLatency_data()
+{
+    QTest::addColumn<int>("cardCount");
+
+    QTest::newRow("200k") << 200000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void TestTaskRunner::testEventLoopLatency()
+{
+    // Кадр интерфейса при 60 кадрах в секунду
+    constexpr qint64 kFrameMSecs = 16;
+
+    QFETCH(int, cardCount);
+    if (cardCount > 200000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 1M-card benchmarks");
+    }
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("collection.snapshot");
+    QVERIFY(CollectionSnapshot::write(path, {makeDeck(1, cardCount)}));
+
+    TaskRunner runner;
+    DeckHandoff handoff;
+    CardTableModel model;
+    QSharedPointer<const Deck> shown;
+    QEventLoop loop;
+
+    // Таймер с шагом 1 мс измеряет паузы цикла событий
+    QElapsedTimer sinceTick;
+    qint64 worstGap = 0;
+    int ticks = 0;
+    QTimer ticker;
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(1);
+    QObject::connect(&ticker, &QTimer::timeout, [&]() {
+        worstGap = std::max(worstGap, sinceTick.restart());
+        ticks++;
+    });
+
+    // Переход на новую колоду выполняется в потоке интерфейса
+    bool ok = false;
+    QObject::connect(&runner, &TaskRunner::finished, [&](int, bool success) {
+        ok = success;
+        if (success) {
+            QSharedPointer<const Deck> previous = std::move(shown);
+            shown = handoff.current();
+            model.setDeck(shown.data());
+            runner.releaseLater(std::move(previous));
+        }
+        loop.quit();
+    });
+
+    QElapsedTimer total;
+    total.start();
+    sinceTick.start();
+    ticker.start();
+    for (int round = 0; round < 3; round++) {
+        runner.run("Загрузка", DeckTasks::loadSnapshot(path, 1, handoff));
+        loop.exec();
+        QVERIFY(ok);
+    }
+    ticker.stop();
+    const qint64 totalMSecs = total.elapsed();
+
+    QCOMPARE(model.totalRowCount(), cardCount);
+    model.setDeck(nullptr);
+    runner.releaseLater(std::move(shown));
+    QVERIFY(runner.waitForDone(60000));
+
+    qDebug() << "Cards:" << cardCount << "three loads:" << totalMSecs << "ms,"
+             << "timer ticks:" << ticks << "worst event loop gap:" << worstGap << "ms";
+    QVERIFY(ticks > 0);
+    QVERIFY(worstGap <= kFrameMSecs);
+}
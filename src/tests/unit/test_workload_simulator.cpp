@@ -0,0 +1,324 @@
+#include <QtTest>
+#include "TestWorkloadSimulator.h"
+#include "WorkloadSimulator.h"
+#include "AllocationCounter.h"
+#include "Deck.h"
+#include "TestDecks.h"
+
+namespace {
+
+using TestDecks::kNow;
+
+/// Все ответы на 5: расписание становится детерминированным
+const std::array<double, 6> kPerfect = {0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+
+/**
+ * @brief Колода новых карточек (еще не повторялись)
+ */
+Deck makeNewDeck(int count, const Clock *clock)
+{
+    QList<Card> cards;
+    cards.reserve(count);
+    for (int i = 0; i < count; i++) {
+        cards.append(Card(i + 1, QString("Вопрос %1").arg(i), QString("Ответ %1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 0, 0, QDateTime(), QDateTime(), 1));
+    }
+    Deck deck;
+    deck.setId(1);
+    deck.setClock(clock);
+    deck.setCards(std::move(cards));
+    return deck;
+}
+
+/**
+ * @brief Колода изученных карточек со сроками в ближайшие два месяца
+ */
+Deck makeMatureDeck(int count, const Clock *clock)
+{
+    QList<Card> cards;
+    cards.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const int interval = 1 + (i * 37) % 60;
+        const int repetitions = i % 10 == 0 ? 0 : 1 + i % 6;
+        const float easyFactor = 1.3f + float(i % 13) * 0.1f;
+        const QDateTime next = kNow.addSecs(qint64(i * 7919 % (60 * 24 * 60)) * 60 - 2 * 24 * 3600);
+        cards.append(Card(i + 1, QString("Вопрос %1").arg(i), QString("Ответ %1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          easyFactor, interval, repetitions, next, kNow.addDays(-interval), 1));
+    }
+    Deck deck;
+    deck.setId(1);
+    deck.setClock(clock);
+    deck.setCards(std::move(cards));
+    return deck;
+}
+
+} // namespace
+
+// ==================== OPTIONS ====================
+
+void TestWorkloadSimulator::testInvalidOptions()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeNewDeck(10, &clock);
+
+    WorkloadSimulator::Options options;
+    options.days = 0;
+    WorkloadSimulator noDays(options);
+    QVERIFY(!noDays.simulate(deck));
+    QVERIFY(!noDays.lastError().isEmpty());
+    QVERIFY(noDays.result().days.isEmpty());
+
+    options = WorkloadSimulator::Options();
+    options.gradeWeights = {0.1, 0.1, -0.1, 0.3, 0.3, 0.3};
+    QVERIFY(!WorkloadSimulator(options).simulate(deck));
+
+    options.gradeWeights = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    QVERIFY(!WorkloadSimulator(options).simulate(deck));
+
+    // Пустая колода - допустимый вход с нулевой нагрузкой
+    WorkloadSimulator empty;
+    QVERIFY(empty.simulate(Deck()));
+    QVERIFY(empty.lastError().isEmpty());
+    QCOMPARE(empty.result().days.size(), 365);
+    QCOMPARE(empty.result().reviews, qint64(0));
+}
+
+// ==================== MODEL ====================
+
+void TestWorkloadSimulator::testDeterministicLoad()
+{
+    // Новая карточка с ответами на 5 повторяется в дни 0, 1, 7, 22, 60
+    FixedClock clock(kNow);
+    const Deck deck = makeNewDeck(100, &clock);
+
+    WorkloadSimulator::Options options;
+    options.days = 90;
+    options.trials = 8;
+    options.gradeWeights = kPerfect;
+    WorkloadSimulator simulator(options);
+    QVERIFY(simulator.simulate(deck));
+
+    const WorkloadSimulator::Result &result = simulator.result();
+    QCOMPARE(result.days.size(), 90);
+    const QList<int> reviewDays = {0, 1, 7, 22, 60};
+    for (int day = 0; day < 90; day++) {
+        const WorkloadSimulator::DayLoad &load = result.days[day];
+        const int expected = reviewDays.contains(day) ? 100 : 0;
+        QCOMPARE(load.median, expected);
+        QCOMPARE(load.lower, expected);
+        QCOMPARE(load.upper, expected);
+        QCOMPARE(load.mean, double(expected));
+    }
+    QCOMPARE(result.meanTotal, 500.0);
+    QCOMPARE(result.lowerTotal, 500);
+    QCOMPARE(result.upperTotal, 500);
+    QCOMPARE(result.reviews, qint64(500 * 8));
+    QCOMPARE(result.meanBacklog, 0.0);
+
+    // Колода не изменилась
+    QCOMPARE(deck.getDueCount(), 100);
+}
+
+void TestWorkloadSimulator::testDailyLimitCarriesOver()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeNewDeck(100, &clock);
+
+    WorkloadSimulator::Options options;
+    options.days = 3;
+    options.trials = 4;
+    options.dailyLimit = 30;
+    options.gradeWeights = kPerfect;
+    WorkloadSimulator simulator(options);
+    QVERIFY(simulator.simulate(deck));
+
+    // День 0: 30 из 100; день 1: 70 перенесенных + 30 повторенных вчера,
+    // выполнено 30; день 2: 70 в очереди, выполнено 30, 40 остаются
+    const WorkloadSimulator::Result &result = simulator.result();
+    for (const WorkloadSimulator::DayLoad &load : result.days) {
+        QCOMPARE(load.median, 30);
+        QCOMPARE(load.upper, 30);
+    }
+    QCOMPARE(result.meanTotal, 90.0);
+    QCOMPARE(result.meanBacklog, 40.0);
+}
+
+void TestWorkloadSimulator::testClockShiftsDays()
+{
+    // Карточки со сроком через 10 дней
+    FixedClock clock(kNow);
+    QList<Card> cards;
+    for (int i = 0; i < 50; i++) {
+        cards.append(Card(i + 1, QString("Q%1").arg(i), QString("A%1").arg(i),
+                          ContentType::Text, TestMode::DirectAnswer,
+                          2.5f, 10, 3, kNow.addDays(10), kNow, 1));
+    }
+    Deck deck;
+    deck.setClock(&clock);
+    deck.setCards(std::move(cards));
+
+    WorkloadSimulator::Options options;
+    options.days = 20;
+    options.trials = 2;
+    options.gradeWeights = kPerfect;
+    WorkloadSimulator simulator(options);
+    QVERIFY(simulator.simulate(deck));
+    QCOMPARE(simulator.result().days[10].median, 50);
+
+    // Собственные часы симулятора: через 4 дня срок наступит на 6-й день
+    FixedClock later(kNow.addDays(4));
+    simulator.setClock(&later);
+    QVERIFY(simulator.simulate(deck));
+    QCOMPARE(simulator.result().days[6].median, 50);
+    QCOMPARE(simulator.result().days[10].median, 0);
+}
+
+void TestWorkloadSimulator::testConfidenceBand()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeMatureDeck(2000, &clock);
+
+    WorkloadSimulator::Options options;
+    options.days = 120;
+    options.trials = 50;
+    WorkloadSimulator simulator(options);
+    QVERIFY(simulator.simulate(deck));
+
+    const WorkloadSimulator::Result &result = simulator.result();
+    bool spread = false;
+    for (const WorkloadSimulator::DayLoad &load : result.days) {
+        QVERIFY(load.lower <= load.median);
+        QVERIFY(load.median <= load.upper);
+        spread = spread || load.lower < load.upper;
+    }
+    // Случайные оценки дают разброс нагрузки между испытаниями
+    QVERIFY(spread);
+    QVERIFY(result.lowerTotal <= result.upperTotal);
+    QVERIFY(result.meanTotal >= deck.getDueCount());
+
+    // Первые повторения сегодня не зависят от оценок
+    QCOMPARE(result.days[0].lower, deck.getForecast(1).count(0));
+    QCOMPARE(result.days[0].upper, deck.getForecast(1).count(0));
+
+    // Полная полоса - минимум и максимум по испытаниям
+    options.confidence = 1.0;
+    WorkloadSimulator wide(options);
+    QVERIFY(wide.simulate(deck));
+    for (int day = 0; day < options.days; day++) {
+        QVERIFY(wide.result().days[day].lower <= result.days[day].lower);
+        QVERIFY(wide.result().days[day].upper >= result.days[day].upper);
+    }
+}
+
+void TestWorkloadSimulator::testThreadCountIndependence()
+{
+    FixedClock clock(kNow);
+    const Deck deck = makeMatureDeck(3000, &clock);
+
+    WorkloadSimulator::Options options;
+    options.days = 180;
+    options.trials = 24;
+    options.dailyLimit = 200;
+    options.seed = 42;
+
+    options.threadCount = 1;
+    WorkloadSimulator sequential(options);
+    QVERIFY(sequential.simulate(deck));
+
+    options.threadCount = 4;
+    WorkloadSimulator parallel(options);
+    QVERIFY(parallel.simulate(deck));
+
+    const WorkloadSimulator::Result &a = sequential.result();
+    const WorkloadSimulator::Result &b = parallel.result();
+    QCOMPARE(a.reviews, b.reviews);
+    QCOMPARE(a.meanBacklog, b.meanBacklog);
+    QCOMPARE(a.lowerTotal, b.lowerTotal);
+    QCOMPARE(a.upperTotal, b.upperTotal);
+    for (int day = 0; day < options.days; day++) {
+        QCOMPARE(a.days[day].mean, b.days[day].mean);
+        QCOMPARE(a.days[day].median, b.days[day].median);
+        QCOMPARE(a.days[day].lower, b.days[day].lower);
+        QCOMPARE(a.days[day].upper, b.days[day].upper);
+    }
+
+    // Другое зерно - другая траектория
+    options.seed = 43;
+    WorkloadSimulator reseeded(options);
+    QVERIFY(reseeded.simulate(deck));
+    QVERIFY(reseeded.result().reviews != a.reviews);
+}
+
+// ==================== PERFORMANCE ====================
+
+void TestWorkloadSimulator::testNoPerTrialAllocations()
+{
+    // Внутренний цикл не выделяет память: число выделений не растет с испытаниями
+    FixedClock clock(kNow);
+    const Deck deck = makeMatureDeck(1000, &clock);
+
+    WorkloadSimulator::Options options;
+    options.days = 90;
+    options.threadCount = 1;
+
+    options.trials = 4;
+    WorkloadSimulator few(options);
+    quint64 fewAllocations = 0;
+    {
+        AllocationCounter::Scope scope;
+        QVERIFY(few.simulate(deck));
+        fewAllocations = scope.allocations();
+    }
+
+    options.trials = 40;
+    WorkloadSimulator many(options);
+    quint64 manyAllocations = 0;
+    {
+        AllocationCounter::Scope scope;
+        QVERIFY(many.simulate(deck));
+        manyAllocations = scope.allocations();
+    }
+
+    qDebug() << "Allocations, 4 trials:" << fewAllocations << "40 trials:" << manyAllocations;
+    QCOMPARE(manyAllocations, fewAllocations);
+}
+
+void TestWorkloadSimulator::testSimulationSpeed_data()
+{
+    QTest::addColumn<int>("cardCount");
+    QTest::addColumn<int>("trials");
+
+    QTest::newRow("20k x 20") << 20000 << 20;
+    QTest::newRow("100k x 100") << 100000 << 100;
+}
+
+void TestWorkloadSimulator::testSimulationSpeed()
+{
+    // Год вперед с вероятностями оценок по умолчанию
+    QFETCH(int, cardCount);
+    QFETCH(int, trials);
+    if (qint64(cardCount) * trials > 1000000 && !qEnvironmentVariableIsSet("QTCARDS_LARGE_BENCH")) {
+        QSKIP("Set QTCARDS_LARGE_BENCH to run 100k-card simulations");
+    }
+
+    FixedClock clock(kNow);
+    const Deck deck = makeMatureDeck(cardCount, &clock);
+
+    WorkloadSimulator::Options options;
+    options.days = 365;
+    options.trials = trials;
+    WorkloadSimulator simulator(options);
+    QVERIFY(simulator.simulate(deck));
+
+    const WorkloadSimulator::Result &result = simulator.result();
+    const double seconds = std::max<qint64>(1, result.elapsedMSecs) / 1000.0;
+    qDebug() << "Cards:" << cardCount << "trials:" << trials
+             << "elapsed:" << result.elapsedMSecs << "ms,"
+             << "reviews/s:" << qint64(result.reviews / seconds)
+             << "mean per trial:" << result.meanTotal
+             << "day 30:" << result.days[30].lower << "-" << result.days[30].upper;
+    QVERIFY(result.reviews > qint64(cardCount) * trials);
+    QVERIFY(result.elapsedMSecs < 60 * 1000);
+}